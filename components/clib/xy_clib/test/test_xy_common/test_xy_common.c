@@ -10,6 +10,7 @@ extern int test_xy_dec2bcd(void);
 extern int test_xy_bcd2dec(void);
 extern int test_xy_bits(void);
 extern int test_xy_list(void);
+extern int test_xy_rb(void);
 
 void setUp(void)
 {
@@ -29,5 +30,6 @@ int test_xy_common(void)
     test_xy_dec2bcd();
     test_xy_bits();
     test_xy_list();
+    test_xy_rb();
     return 0;
 }
\ No newline at end of file
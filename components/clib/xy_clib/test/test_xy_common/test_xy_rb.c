@@ -0,0 +1,75 @@
+#include "unity.h"
+#include "xy_rb.h"
+
+
+void test_xy_rb_drop_wrap(void)
+{
+    xy_rb_t rb;
+    uint8_t pool[8];
+    uint8_t data[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    uint8_t out[8];
+
+    xy_rb_init(&rb, pool, sizeof(pool));
+
+    // 读指针移到 6，写指针回绕到 4
+    TEST_ASSERT_EQUAL(6, xy_rb_put(&rb, data, 6));
+    TEST_ASSERT_EQUAL(6, xy_rb_drop(&rb, 6));
+    TEST_ASSERT_EQUAL(6, xy_rb_put(&rb, data, 6));
+    TEST_ASSERT_EQUAL(6, xy_rb_data_len(&rb));
+
+    // 跨越回绕点丢弃 3 字节
+    TEST_ASSERT_EQUAL(3, xy_rb_drop(&rb, 3));
+    TEST_ASSERT_EQUAL(1, rb.read_index);
+    TEST_ASSERT_EQUAL(3, xy_rb_data_len(&rb));
+    TEST_ASSERT_EQUAL(5, xy_rb_space_len(&rb));
+
+    // 剩余数据不受影响
+    TEST_ASSERT_EQUAL(3, xy_rb_get(&rb, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&data[3], out, 3);
+    TEST_ASSERT_EQUAL(0, xy_rb_data_len(&rb));
+}
+
+void test_xy_rb_drop_to_end(void)
+{
+    xy_rb_t rb;
+    uint8_t pool[8];
+    uint8_t data[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    uint8_t out[2];
+
+    xy_rb_init(&rb, pool, sizeof(pool));
+
+    // 正好丢弃到缓冲区末尾，读指针回到 0
+    TEST_ASSERT_EQUAL(8, xy_rb_put(&rb, data, 8));
+    TEST_ASSERT_EQUAL(8, xy_rb_drop(&rb, 8));
+    TEST_ASSERT_EQUAL(0, rb.read_index);
+    TEST_ASSERT_EQUAL(0, xy_rb_data_len(&rb));
+
+    TEST_ASSERT_EQUAL(2, xy_rb_put(&rb, data, 2));
+    TEST_ASSERT_EQUAL(2, xy_rb_get(&rb, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, out, 2);
+}
+
+void test_xy_rb_drop_more_than_data(void)
+{
+    xy_rb_t rb;
+    uint8_t pool[8];
+    uint8_t data[8] = { 0 };
+
+    xy_rb_init(&rb, pool, sizeof(pool));
+
+    // 只丢弃已有的数据
+    TEST_ASSERT_EQUAL(0, xy_rb_drop(&rb, 4));
+    TEST_ASSERT_EQUAL(5, xy_rb_put(&rb, data, 5));
+    TEST_ASSERT_EQUAL(5, xy_rb_drop(&rb, 100));
+    TEST_ASSERT_EQUAL(0, xy_rb_data_len(&rb));
+    TEST_ASSERT_EQUAL(8, xy_rb_space_len(&rb));
+    TEST_ASSERT_EQUAL(0, xy_rb_drop(NULL, 4));
+}
+
+int test_xy_rb(void)
+{
+    RUN_TEST(test_xy_rb_drop_wrap);
+    RUN_TEST(test_xy_rb_drop_to_end);
+    RUN_TEST(test_xy_rb_drop_more_than_data);
+    return 0;
+}
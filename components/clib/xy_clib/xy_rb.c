@@ -260,6 +260,35 @@ size_t xy_rb_get(xy_rb_t *rb, uint8_t *ptr, uint32_t length)
     }
 }
 
+/**
+ * @brief Discard data from the ring buffer without copying it
+ *
+ * Pairs with xy_rb_peek() for zero-copy consumers.
+ */
+size_t xy_rb_drop(xy_rb_t *rb, uint32_t length)
+{
+    if (!rb || length == 0)
+        return 0;
+
+    uint32_t size;
+
+    /* available data in ring buffer */
+    size = xy_rb_data_len(rb);
+
+    if (size < length)
+        length = size;
+
+    if ((uint32_t)(rb->buffer_size - rb->read_index) > length) {
+        rb->read_index += length;
+    } else {
+        /* we are going into the other mirror */
+        rb->read_mirror = ~rb->read_mirror;
+        rb->read_index  = length - (uint32_t)(rb->buffer_size - rb->read_index);
+    }
+
+    return length;
+}
+
 /**
  * @brief Peek data from the ring buffer without changing read index
  */
@@ -2,6 +2,7 @@
 #define _XY_RB_H_
 
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,6 +25,7 @@ size_t xy_rb_space_len(xy_rb_t *rb);
 size_t xy_rb_put(xy_rb_t *rb, const uint8_t *ptr, uint32_t length);
 size_t xy_rb_put_force(xy_rb_t *rb, const uint8_t *ptr, uint32_t length);
 size_t xy_rb_get(xy_rb_t *rb, uint8_t *ptr, uint32_t length);
+size_t xy_rb_drop(xy_rb_t *rb, uint32_t length);
 size_t xy_rb_peek(xy_rb_t *rb, uint8_t **ptr);
 size_t xy_rb_putchar(xy_rb_t *rb, const uint8_t ch);
 size_t xy_rb_putchar_force(xy_rb_t *rb, const uint8_t ch);
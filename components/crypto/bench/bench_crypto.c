@@ -0,0 +1,480 @@
+/**
+ * @file bench_crypto.c
+ * @brief Known-answer tests and throughput for all xy_* crypto primitives
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * Every primitive is checked against a published vector first; a primitive
+ * that fails its KAT is not timed and the program exits non-zero.
+ *
+ * Usage: bench_crypto [csv|json]
+ */
+
+#include <stdio.h>
+
+#include "xy_bench.h"
+#include "xy_tiny_crypto.h"
+#include "xy_crc.h"
+#include "xy_blake2.h"
+#include "xy_chacha20_poly1305.h"
+#include "xy_25519.h"
+#include "xy_rng.h"
+#include <string.h>
+
+/* ==================== Configuration ==================== */
+
+/**
+ * @brief Include Ed25519
+ *
+ * xy_25519.c expects the port to provide xy_sha512_hash(); enable this only
+ * when one is linked in (make ED25519=1 SHA512_SRC=...).
+ */
+#ifndef XY_BENCH_ED25519
+#define XY_BENCH_ED25519 0
+#endif
+
+#define BENCH_MAX_MSG 8192
+
+static const size_t s_sizes[] = { 16, 64, 256, 1024, BENCH_MAX_MSG };
+
+#define BENCH_NUM_SIZES (sizeof(s_sizes) / sizeof(s_sizes[0]))
+
+static uint8_t s_msg[BENCH_MAX_MSG];
+static uint8_t s_out[BENCH_MAX_MSG];
+
+/* ==================== Known-Answer Vectors ==================== */
+
+static const uint8_t s_abc[3] = { 'a', 'b', 'c' };
+
+/* RFC 1321 A.5 */
+static const uint8_t s_md5_abc[16] = {
+    0x90, 0x01, 0x50, 0x98, 0x3c, 0xd2, 0x4f, 0xb0,
+    0xd6, 0x96, 0x3f, 0x7d, 0x28, 0xe1, 0x7f, 0x72
+};
+
+/* FIPS 180-4 example */
+static const uint8_t s_sha256_abc[32] = {
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+    0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+    0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+    0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+
+/* RFC 7693 Appendix B */
+static const uint8_t s_blake2s_abc[32] = {
+    0x50, 0x8c, 0x5e, 0x8c, 0x32, 0x7c, 0x14, 0xe2,
+    0xe1, 0xa7, 0x2b, 0xa3, 0x4e, 0xeb, 0x45, 0x2f,
+    0x37, 0x45, 0x8b, 0x20, 0x9e, 0xd6, 0x3a, 0x29,
+    0x4d, 0x99, 0x9b, 0x4c, 0x86, 0x67, 0x59, 0x82
+};
+
+/* FIPS 197 Appendix C.1 */
+static const uint8_t s_aes_key[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+static const uint8_t s_aes_pt[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+static const uint8_t s_aes_ct[16] = {
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+    0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+/* RFC 8439 2.8.2 */
+static const uint8_t s_aead_nonce[12] = {
+    0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43,
+    0x44, 0x45, 0x46, 0x47
+};
+static const uint8_t s_aead_aad[12] = {
+    0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7
+};
+static const char s_aead_pt[] =
+    "Ladies and Gentlemen of the class of '99: If I could offer you only "
+    "one tip for the future, sunscreen would be it.";
+static const uint8_t s_aead_ct[114] = {
+    0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb, 0x7b, 0x86, 0xaf, 0xbc,
+    0x53, 0xef, 0x7e, 0xc2, 0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe,
+    0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6, 0x3d, 0xbe, 0xa4, 0x5e,
+    0x8c, 0xa9, 0x67, 0x12, 0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+    0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29, 0x05, 0xd6, 0xa5, 0xb6,
+    0x7e, 0xcd, 0x3b, 0x36, 0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c,
+    0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58, 0xfa, 0xb3, 0x24, 0xe4,
+    0xfa, 0xd6, 0x75, 0x94, 0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+    0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d, 0xe5, 0x76, 0xd2, 0x65,
+    0x86, 0xce, 0xc6, 0x4b, 0x61, 0x16
+};
+static const uint8_t s_aead_tag[16] = {
+    0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a,
+    0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91
+};
+
+/* RFC 7748 6.1 */
+static const uint8_t s_x25519_alice_priv[32] = {
+    0x77, 0x07, 0x6d, 0x0a, 0x73, 0x18, 0xa5, 0x7d,
+    0x3c, 0x16, 0xc1, 0x72, 0x51, 0xb2, 0x66, 0x45,
+    0xdf, 0x4c, 0x2f, 0x87, 0xeb, 0xc0, 0x99, 0x2a,
+    0xb1, 0x77, 0xfb, 0xa5, 0x1d, 0xb9, 0x2c, 0x2a
+};
+static const uint8_t s_x25519_alice_pub[32] = {
+    0x85, 0x20, 0xf0, 0x09, 0x89, 0x30, 0xa7, 0x54,
+    0x74, 0x8b, 0x7d, 0xdc, 0xb4, 0x3e, 0xf7, 0x5a,
+    0x0d, 0xbf, 0x3a, 0x0d, 0x26, 0x38, 0x1a, 0xf4,
+    0xeb, 0xa4, 0xa9, 0x8e, 0xaa, 0x9b, 0x4e, 0x6a
+};
+static const uint8_t s_x25519_bob_pub[32] = {
+    0xde, 0x9e, 0xdb, 0x7d, 0x7b, 0x7d, 0xc1, 0xb4,
+    0xd3, 0x5b, 0x61, 0xc2, 0xec, 0xe4, 0x35, 0x37,
+    0x3f, 0x83, 0x43, 0xc8, 0x5b, 0x78, 0x67, 0x4d,
+    0xad, 0xfc, 0x7e, 0x14, 0x6f, 0x88, 0x2b, 0x4f
+};
+static const uint8_t s_x25519_shared[32] = {
+    0x4a, 0x5d, 0x9d, 0x5b, 0xa4, 0xce, 0x2d, 0xe1,
+    0x72, 0x8e, 0x3b, 0xf4, 0x80, 0x35, 0x0f, 0x25,
+    0xe0, 0x7e, 0x21, 0xc9, 0x47, 0xd1, 0x9e, 0x33,
+    0x76, 0xf0, 0x9b, 0x3c, 0x1e, 0x16, 0x17, 0x42
+};
+
+#if XY_BENCH_ED25519
+/* RFC 8032 7.1 TEST 1 */
+static const uint8_t s_ed25519_sk[32] = {
+    0x9d, 0x61, 0xb1, 0x9d, 0xef, 0xfd, 0x5a, 0x60,
+    0xba, 0x84, 0x4a, 0xf4, 0x92, 0xec, 0x2c, 0xc4,
+    0x44, 0x49, 0xc5, 0x69, 0x7b, 0x32, 0x69, 0x19,
+    0x70, 0x3b, 0xac, 0x03, 0x1c, 0xae, 0x7f, 0x60
+};
+static const uint8_t s_ed25519_pk[32] = {
+    0xd7, 0x5a, 0x98, 0x01, 0x82, 0xb1, 0x0a, 0xb7,
+    0xd5, 0x4b, 0xfe, 0xd3, 0xc9, 0x64, 0x07, 0x3a,
+    0x0e, 0xe1, 0x72, 0xe0, 0x2d, 0xaa, 0x62, 0x32,
+    0x5a, 0xf0, 0x21, 0x1a, 0x68, 0xf7, 0x07, 0x51
+};
+static const uint8_t s_ed25519_sig[64] = {
+    0xe5, 0x56, 0x43, 0x00, 0xc3, 0x60, 0xac, 0x72,
+    0x90, 0x86, 0xe2, 0xcc, 0x80, 0x6e, 0x82, 0x8a,
+    0x84, 0x87, 0x7f, 0x1e, 0xb8, 0xe5, 0xd9, 0x74,
+    0xd8, 0x73, 0xe0, 0x65, 0x22, 0x49, 0x01, 0x55,
+    0x5f, 0xb8, 0x82, 0x15, 0x90, 0xa3, 0x3b, 0xac,
+    0xc6, 0x1e, 0x39, 0x70, 0x1c, 0xf9, 0xb4, 0x6b,
+    0xd2, 0x5b, 0xf5, 0xf0, 0x59, 0x5b, 0xbe, 0x24,
+    0x65, 0x51, 0x41, 0x43, 0x8e, 0x7a, 0x10, 0x0b
+};
+#endif
+
+/* RFC 8439 2.3.2 style: zero key / nonce / counter ChaCha20 block */
+static const uint8_t s_chacha_zero_block[64] = {
+    0x76, 0xb8, 0xe0, 0xad, 0xa0, 0xf1, 0x3d, 0x90,
+    0x40, 0x5d, 0x6a, 0xe5, 0x53, 0x86, 0xbd, 0x28,
+    0xbd, 0xd2, 0x19, 0xb8, 0xa0, 0x8d, 0xed, 0x1a,
+    0xa8, 0x36, 0xef, 0xcc, 0x8b, 0x77, 0x0d, 0xc7,
+    0xda, 0x41, 0x59, 0x7c, 0x51, 0x57, 0x48, 0x8d,
+    0x77, 0x24, 0xe0, 0x3f, 0xb8, 0xd8, 0x4a, 0x37,
+    0x6a, 0x43, 0xb8, 0xf4, 0x15, 0x18, 0xa1, 0x1c,
+    0xc3, 0x87, 0xb6, 0x69, 0xb2, 0xee, 0x65, 0x86
+};
+
+/* ==================== Known-Answer Tests ==================== */
+
+static int prv_kat_crc32(void)
+{
+    uint8_t check[9] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+    return xy_crc32_normal(check, sizeof(check)) == 0xCBF43926u;
+}
+
+static int prv_kat_md5(void)
+{
+    uint8_t digest[16];
+
+    return xy_md5_hash(s_abc, sizeof(s_abc), digest) == 0
+           && memcmp(digest, s_md5_abc, sizeof(digest)) == 0;
+}
+
+static int prv_kat_sha256(void)
+{
+    uint8_t digest[32];
+
+    return xy_sha256_hash(s_abc, sizeof(s_abc), digest) == 0
+           && memcmp(digest, s_sha256_abc, sizeof(digest)) == 0;
+}
+
+static int prv_kat_blake2s(void)
+{
+    uint8_t digest[32];
+
+    return xy_blake2s(digest, sizeof(digest), s_abc, sizeof(s_abc), NULL, 0)
+               == 0
+           && memcmp(digest, s_blake2s_abc, sizeof(digest)) == 0;
+}
+
+static int prv_kat_aes(void)
+{
+    xy_aes_ctx_t ctx;
+    uint8_t ct[16];
+
+    return xy_aes_init(&ctx, s_aes_key, XY_AES_KEY_SIZE_128) == 0
+           && xy_aes_encrypt_block(&ctx, s_aes_pt, ct) == 0
+           && memcmp(ct, s_aes_ct, sizeof(ct)) == 0;
+}
+
+static int prv_kat_aead(void)
+{
+    uint8_t key[32];
+    uint8_t ct[sizeof(s_aead_ct)];
+    uint8_t tag[16];
+    int i;
+
+    for (i = 0; i < 32; i++) {
+        key[i] = (uint8_t)(0x80 + i);
+    }
+    if (xy_chacha20_poly1305_encrypt(key, s_aead_nonce, s_aead_aad,
+                                     sizeof(s_aead_aad),
+                                     (const uint8_t *)s_aead_pt, sizeof(ct),
+                                     ct, tag)
+        != XY_CHACHA20_POLY1305_SUCCESS) {
+        return 0;
+    }
+    return memcmp(ct, s_aead_ct, sizeof(ct)) == 0
+           && memcmp(tag, s_aead_tag, sizeof(tag)) == 0;
+}
+
+static int prv_kat_x25519(void)
+{
+    uint8_t pub[32];
+    uint8_t shared[32];
+
+    return xy_x25519_public_key(s_x25519_alice_priv, pub) == XY_X25519_SUCCESS
+           && memcmp(pub, s_x25519_alice_pub, sizeof(pub)) == 0
+           && xy_x25519_shared_secret(shared, s_x25519_alice_priv,
+                                      s_x25519_bob_pub)
+                  == XY_X25519_SUCCESS
+           && memcmp(shared, s_x25519_shared, sizeof(shared)) == 0;
+}
+
+#if XY_BENCH_ED25519
+static int prv_kat_ed25519(void)
+{
+    uint8_t pk[32];
+    uint8_t sig[64];
+
+    return xy_ed25519_public_key(s_ed25519_sk, pk) == XY_ED25519_SUCCESS
+           && memcmp(pk, s_ed25519_pk, sizeof(pk)) == 0
+           && xy_ed25519_sign(sig, NULL, 0, pk, s_ed25519_sk)
+                  == XY_ED25519_SUCCESS
+           && memcmp(sig, s_ed25519_sig, sizeof(sig)) == 0
+           && xy_ed25519_verify(sig, NULL, 0, pk) == XY_ED25519_SUCCESS;
+}
+#endif
+
+static int prv_kat_csprng(void)
+{
+    uint8_t seed[32];
+    uint8_t out[64];
+
+    /* A zero seed keys ChaCha20 with zero key, nonce and counter */
+    memset(seed, 0, sizeof(seed));
+    return xy_csprng_init(seed, sizeof(seed)) == 0
+           && xy_csprng_generate(out, sizeof(out)) == 0
+           && memcmp(out, s_chacha_zero_block, sizeof(out)) == 0;
+}
+
+/* ==================== Timed Operations ==================== */
+
+static xy_aes_ctx_t s_aes_ctx;
+static uint8_t s_key[32];
+static uint8_t s_nonce[12];
+static uint8_t s_iv[16];
+#if XY_BENCH_ED25519
+static uint8_t s_sig[64];
+static uint8_t s_pk[32];
+#endif
+static uint8_t s_tag[16];
+static volatile uint32_t s_sink;
+
+static void prv_op_crc32(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    s_sink = xy_crc32_normal(buf, (uint16_t)len);
+}
+
+static void prv_op_md5(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    xy_md5_hash(buf, len, s_out);
+}
+
+static void prv_op_sha256(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    xy_sha256_hash(buf, len, s_out);
+}
+
+static void prv_op_blake2s(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    xy_blake2s(s_out, 32, buf, len, NULL, 0);
+}
+
+static void prv_op_aes_cbc(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    xy_aes_cbc_encrypt(&s_aes_ctx, s_iv, buf, len, s_out);
+}
+
+static void prv_op_aead(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    xy_chacha20_poly1305_encrypt(s_key, s_nonce, NULL, 0, buf, len, s_out,
+                                 s_tag);
+}
+
+static void prv_op_csprng(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    xy_csprng_generate(buf, len);
+}
+
+static void prv_op_x25519_pub(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    (void)buf;
+    (void)len;
+    xy_x25519_public_key(s_key, s_out);
+}
+
+static void prv_op_x25519_shared(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    (void)buf;
+    (void)len;
+    xy_x25519_shared_secret(s_out, s_key, s_x25519_bob_pub);
+}
+
+#if XY_BENCH_ED25519
+static void prv_op_ed25519_sign(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    (void)len;
+    xy_ed25519_sign(s_sig, buf, 64, s_pk, s_key);
+}
+
+static void prv_op_ed25519_verify(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    (void)len;
+    s_sink = (uint32_t)xy_ed25519_verify(s_sig, buf, 64, s_pk);
+}
+#endif
+
+/* ==================== Port Hooks ==================== */
+
+void xy_log_char(char ch)
+{
+    fputc(ch, stderr);
+}
+
+/* ==================== Driver ==================== */
+
+typedef struct {
+    const char *primitive;
+    const char *op;
+    int (*kat)(void);
+    xy_bench_fn_t fn;
+    int sized; /**< 0: fixed-size op, timed once */
+} bench_entry_t;
+
+static const bench_entry_t s_entries[] = {
+    { "crc32", "checksum", prv_kat_crc32, prv_op_crc32, 1 },
+    { "md5", "hash", prv_kat_md5, prv_op_md5, 1 },
+    { "sha256", "hash", prv_kat_sha256, prv_op_sha256, 1 },
+    { "blake2s", "hash", prv_kat_blake2s, prv_op_blake2s, 1 },
+    { "aes128-cbc", "encrypt", prv_kat_aes, prv_op_aes_cbc, 1 },
+    { "chacha20-poly1305", "seal", prv_kat_aead, prv_op_aead, 1 },
+    { "csprng", "generate", prv_kat_csprng, prv_op_csprng, 1 },
+    { "x25519", "public_key", prv_kat_x25519, prv_op_x25519_pub, 0 },
+    { "x25519", "shared_secret", prv_kat_x25519, prv_op_x25519_shared, 0 },
+#if XY_BENCH_ED25519
+    { "ed25519", "sign", prv_kat_ed25519, prv_op_ed25519_sign, 0 },
+    { "ed25519", "verify", prv_kat_ed25519, prv_op_ed25519_verify, 0 },
+#endif
+};
+
+#define BENCH_NUM_ENTRIES (sizeof(s_entries) / sizeof(s_entries[0]))
+
+static void prv_setup(void)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(s_msg); i++) {
+        s_msg[i] = (uint8_t)(i * 131u + 7u);
+    }
+    for (i = 0; i < sizeof(s_key); i++) {
+        s_key[i] = (uint8_t)(0x80 + i);
+    }
+    memcpy(s_nonce, s_aead_nonce, sizeof(s_nonce));
+    memcpy(s_iv, s_aes_pt, sizeof(s_iv));
+    xy_aes_init(&s_aes_ctx, s_aes_key, XY_AES_KEY_SIZE_128);
+    xy_csprng_init(s_key, sizeof(s_key));
+#if XY_BENCH_ED25519
+    xy_ed25519_public_key(s_key, s_pk);
+    xy_ed25519_sign(s_sig, s_msg, 64, s_pk, s_key);
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    xy_bench_fmt_t fmt = XY_BENCH_FMT_CSV;
+    int pass[BENCH_NUM_ENTRIES];
+    int failed = 0;
+    xy_bench_result_t res;
+    size_t i, j;
+
+    if (argc > 1 && strcmp(argv[1], "json") == 0) {
+        fmt = XY_BENCH_FMT_JSON;
+    } else if (argc > 1 && strcmp(argv[1], "csv") != 0) {
+        fprintf(stderr, "usage: %s [csv|json]\n", argv[0]);
+        return 2;
+    }
+
+    if (xy_bench_set_counter(NULL) != 0) {
+        fprintf(stderr, "cycle counter init failed\n");
+        return 1;
+    }
+
+    xy_bench_report_begin(fmt);
+
+    /* Shared KATs (x25519, ed25519) are reported once */
+    for (i = 0; i < BENCH_NUM_ENTRIES; i++) {
+        if (i > 0 && s_entries[i].kat == s_entries[i - 1].kat) {
+            pass[i] = pass[i - 1];
+            continue;
+        }
+        pass[i] = s_entries[i].kat();
+        failed |= !pass[i];
+        xy_bench_report_kat(s_entries[i].primitive, pass[i]);
+    }
+
+    prv_setup();
+
+    for (i = 0; i < BENCH_NUM_ENTRIES; i++) {
+        if (!pass[i]) {
+            continue;
+        }
+        res.primitive = s_entries[i].primitive;
+        res.op = s_entries[i].op;
+        if (!s_entries[i].sized) {
+            xy_bench_measure(&res, s_entries[i].fn, NULL, s_msg, 0);
+            xy_bench_report_result(&res);
+            continue;
+        }
+        for (j = 0; j < BENCH_NUM_SIZES; j++) {
+            xy_bench_measure(&res, s_entries[i].fn, NULL, s_msg, s_sizes[j]);
+            xy_bench_report_result(&res);
+        }
+    }
+
+    xy_bench_report_end();
+    return failed ? 1 : 0;
+}
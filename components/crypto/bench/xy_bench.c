@@ -0,0 +1,285 @@
+/**
+ * @file xy_bench.c
+ * @brief Cycle-counter backends and CSV / JSON reporting
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "xy_bench.h"
+#include <stdio.h>
+
+#if XY_BENCH_COUNTER == XY_BENCH_COUNTER_RDTSC \
+    || XY_BENCH_COUNTER == XY_BENCH_COUNTER_CLOCK
+#include <time.h>
+#endif
+
+/* ==================== Built-in Backends ==================== */
+
+#if XY_BENCH_COUNTER == XY_BENCH_COUNTER_DWT
+
+#define DEMCR      (*(volatile uint32_t *)0xE000EDFCu)
+#define DWT_CTRL   (*(volatile uint32_t *)0xE0001000u)
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004u)
+#define DWT_LAR    (*(volatile uint32_t *)0xE0001FB0u)
+
+static uint32_t s_dwt_last;
+static uint64_t s_dwt_high;
+
+static int prv_counter_init(void)
+{
+    DEMCR |= (1u << 24); /* TRCENA */
+    DWT_LAR = 0xC5ACCE55u; /* Unlock on M7, ignored elsewhere */
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1u; /* CYCCNTENA */
+    s_dwt_last = 0;
+    s_dwt_high = 0;
+    return (DWT_CTRL & 1u) ? 0 : -1;
+}
+
+static uint64_t prv_counter_read(void)
+{
+    uint32_t now = DWT_CYCCNT;
+
+    /* Extend to 64 bits; read at least once per wrap (~89 s @ 48 MHz) */
+    if (now < s_dwt_last) {
+        s_dwt_high += 1ull << 32;
+    }
+    s_dwt_last = now;
+    return s_dwt_high | now;
+}
+
+static xy_bench_counter_t s_default_counter = {
+    "dwt", prv_counter_init, prv_counter_read, XY_BENCH_CPU_HZ,
+    XY_BENCH_CPU_HZ
+};
+
+#elif XY_BENCH_COUNTER == XY_BENCH_COUNTER_RDTSC
+
+static uint64_t prv_clock_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t prv_counter_read(void)
+{
+    uint32_t lo, hi;
+
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static int prv_counter_init(void);
+
+static xy_bench_counter_t s_default_counter = {
+    "rdtsc", prv_counter_init, prv_counter_read, 0, 0
+};
+
+static int prv_counter_init(void)
+{
+    uint64_t t0, c0, t1, c1;
+
+    /* Calibrate the TSC against the monotonic clock over ~50 ms */
+    t0 = prv_clock_ns();
+    c0 = prv_counter_read();
+    do {
+        t1 = prv_clock_ns();
+    } while (t1 - t0 < 50000000ull);
+    c1 = prv_counter_read();
+
+    s_default_counter.tick_hz = (c1 - c0) * 1000000000ull / (t1 - t0);
+    /* The TSC runs at the nominal core clock */
+    s_default_counter.cpu_hz = s_default_counter.tick_hz;
+    return 0;
+}
+
+#else /* XY_BENCH_COUNTER_CLOCK */
+
+static int prv_counter_init(void)
+{
+    return 0;
+}
+
+static uint64_t prv_counter_read(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static xy_bench_counter_t s_default_counter = {
+    "clock_gettime", prv_counter_init, prv_counter_read, 1000000000ull,
+    XY_BENCH_CPU_HZ
+};
+
+#endif
+
+static xy_bench_counter_t *s_counter;
+
+int xy_bench_set_counter(xy_bench_counter_t *counter)
+{
+    if (counter == NULL) {
+        counter = &s_default_counter;
+    }
+    if (counter->init != NULL && counter->init() != 0) {
+        return -1;
+    }
+    if (counter->read == NULL || counter->tick_hz == 0) {
+        return -1;
+    }
+    if (counter->cpu_hz == 0) {
+        counter->cpu_hz = counter->tick_hz;
+    }
+    s_counter = counter;
+    return 0;
+}
+
+const xy_bench_counter_t *xy_bench_counter(void)
+{
+    if (s_counter == NULL) {
+        xy_bench_set_counter(NULL);
+    }
+    return s_counter;
+}
+
+/* ==================== Measurement ==================== */
+
+static uint64_t prv_run(xy_bench_fn_t fn, void *ctx, uint8_t *buf, size_t len,
+                        uint32_t iterations)
+{
+    uint64_t t0;
+    uint32_t i;
+
+    t0 = s_counter->read();
+    for (i = 0; i < iterations; i++) {
+        fn(ctx, buf, len);
+    }
+    return s_counter->read() - t0;
+}
+
+void xy_bench_measure(xy_bench_result_t *res, xy_bench_fn_t fn, void *ctx,
+                      uint8_t *buf, size_t len)
+{
+    const xy_bench_counter_t *counter = xy_bench_counter();
+    uint64_t min_ticks = counter->tick_hz / 1000u * XY_BENCH_MIN_MS;
+    uint64_t best;
+    uint64_t ticks;
+    uint32_t n = 1;
+    int i;
+
+    /* Warm caches and find an iteration count that fills the window */
+    fn(ctx, buf, len);
+    ticks = prv_run(fn, ctx, buf, len, n);
+    while (ticks < min_ticks && n < 0x40000000u) {
+        n *= 2;
+        ticks = prv_run(fn, ctx, buf, len, n);
+    }
+
+    best = ticks;
+    for (i = 0; i < 2; i++) {
+        ticks = prv_run(fn, ctx, buf, len, n);
+        if (ticks < best) {
+            best = ticks;
+        }
+    }
+    if (best == 0) {
+        best = 1;
+    }
+
+    res->bytes = len;
+    res->iterations = n;
+    res->cycles_per_op = (double)best * (double)counter->cpu_hz
+                         / (double)counter->tick_hz / (double)n;
+    res->ops_per_sec = (double)n * (double)counter->tick_hz / (double)best;
+    res->cycles_per_byte = len ? res->cycles_per_op / (double)len : 0.0;
+    res->mb_per_sec = len ? res->ops_per_sec * (double)len / 1e6 : 0.0;
+}
+
+/* ==================== Reporting ==================== */
+
+static xy_bench_fmt_t s_fmt;
+static int s_section; /* 0: header, 1: in kat list, 2: in results list */
+static int s_first;
+
+void xy_bench_report_begin(xy_bench_fmt_t fmt)
+{
+    const xy_bench_counter_t *counter = xy_bench_counter();
+
+    s_fmt = fmt;
+    s_section = 0;
+    s_first = 1;
+
+    if (fmt == XY_BENCH_FMT_JSON) {
+        printf("{\n  \"counter\": \"%s\",\n  \"tick_hz\": %llu,\n"
+               "  \"cpu_hz\": %llu",
+               counter->name, (unsigned long long)counter->tick_hz,
+               (unsigned long long)counter->cpu_hz);
+    } else {
+        printf("# counter=%s tick_hz=%llu cpu_hz=%llu\n", counter->name,
+               (unsigned long long)counter->tick_hz,
+               (unsigned long long)counter->cpu_hz);
+    }
+}
+
+static void prv_json_section(int section, const char *name)
+{
+    if (s_section != section) {
+        if (s_section != 0) {
+            printf("\n  ]");
+        }
+        printf(",\n  \"%s\": [", name);
+        s_section = section;
+        s_first = 1;
+    }
+    printf("%s\n    ", s_first ? "" : ",");
+    s_first = 0;
+}
+
+void xy_bench_report_kat(const char *name, int pass)
+{
+    if (s_fmt == XY_BENCH_FMT_JSON) {
+        prv_json_section(1, "kat");
+        printf("{\"name\": \"%s\", \"pass\": %s}", name,
+               pass ? "true" : "false");
+    } else {
+        printf("# kat %s %s\n", name, pass ? "PASS" : "FAIL");
+    }
+}
+
+void xy_bench_report_result(const xy_bench_result_t *res)
+{
+    if (s_fmt == XY_BENCH_FMT_JSON) {
+        prv_json_section(2, "results");
+        printf("{\"primitive\": \"%s\", \"op\": \"%s\", \"bytes\": %u, "
+               "\"iterations\": %u, \"cycles_per_op\": %.1f, "
+               "\"cycles_per_byte\": %.2f, \"ops_per_sec\": %.1f, "
+               "\"mb_per_sec\": %.3f}",
+               res->primitive, res->op, (unsigned)res->bytes,
+               (unsigned)res->iterations, res->cycles_per_op,
+               res->cycles_per_byte, res->ops_per_sec, res->mb_per_sec);
+        return;
+    }
+
+    if (s_section != 2) {
+        printf("primitive,op,bytes,iterations,cycles_per_op,cycles_per_byte,"
+               "ops_per_sec,mb_per_sec\n");
+        s_section = 2;
+    }
+    printf("%s,%s,%u,%u,%.1f,%.2f,%.1f,%.3f\n", res->primitive, res->op,
+           (unsigned)res->bytes, (unsigned)res->iterations, res->cycles_per_op,
+           res->cycles_per_byte, res->ops_per_sec, res->mb_per_sec);
+}
+
+void xy_bench_report_end(void)
+{
+    if (s_fmt == XY_BENCH_FMT_JSON) {
+        printf("%s\n}\n", s_section != 0 ? "\n  ]" : "");
+    }
+}
@@ -0,0 +1,147 @@
+/**
+ * @file xy_bench.h
+ * @brief Cycle-counter backends and result reporting for crypto benchmarks
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * A counter backend returns a monotonically increasing tick value. Ticks are
+ * converted to CPU cycles with cpu_hz / tick_hz, so a backend that counts
+ * nanoseconds still yields cycles/byte once the CPU clock is known.
+ *
+ * Backend selection (XY_BENCH_COUNTER):
+ * - XY_BENCH_COUNTER_DWT:   Cortex-M3/M4/M7/M33 DWT->CYCCNT
+ * - XY_BENCH_COUNTER_RDTSC: x86 time-stamp counter, calibrated at init
+ * - XY_BENCH_COUNTER_CLOCK: POSIX clock_gettime(CLOCK_MONOTONIC)
+ * Any other counter can be installed with xy_bench_set_counter().
+ */
+
+#ifndef XY_BENCH_H
+#define XY_BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Configuration ==================== */
+
+#define XY_BENCH_COUNTER_DWT   1
+#define XY_BENCH_COUNTER_RDTSC 2
+#define XY_BENCH_COUNTER_CLOCK 3
+
+#ifndef XY_BENCH_COUNTER
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) \
+    || defined(__ARM_ARCH_8M_MAIN__)
+#define XY_BENCH_COUNTER XY_BENCH_COUNTER_DWT
+#elif defined(__x86_64__) || defined(__i386__)
+#define XY_BENCH_COUNTER XY_BENCH_COUNTER_RDTSC
+#else
+#define XY_BENCH_COUNTER XY_BENCH_COUNTER_CLOCK
+#endif
+#endif
+
+/**
+ * @brief CPU core clock in Hz
+ *
+ * Required for DWT (SystemCoreClock). For the clock_gettime backend it
+ * converts nanoseconds to cycles; left at 1 GHz, "cycles" read as ns.
+ */
+#ifndef XY_BENCH_CPU_HZ
+#define XY_BENCH_CPU_HZ 1000000000ull
+#endif
+
+/**
+ * @brief Minimum measured time per data point, in milliseconds
+ */
+#ifndef XY_BENCH_MIN_MS
+#define XY_BENCH_MIN_MS 100
+#endif
+
+/* ==================== Counter Backend ==================== */
+
+/**
+ * @brief Cycle counter backend
+ */
+typedef struct {
+    const char *name;       /**< Reported in the output header */
+    int (*init)(void);      /**< Enable / calibrate, 0 on success */
+    uint64_t (*read)(void); /**< Current tick value */
+    uint64_t tick_hz;       /**< Ticks per second (set by init if 0) */
+    uint64_t cpu_hz;        /**< CPU cycles per second */
+} xy_bench_counter_t;
+
+/**
+ * @brief Install a counter backend (NULL selects the built-in default)
+ * @return 0 on success, negative if the backend failed to initialize
+ */
+int xy_bench_set_counter(xy_bench_counter_t *counter);
+
+/**
+ * @brief Get the active counter backend
+ */
+const xy_bench_counter_t *xy_bench_counter(void);
+
+/* ==================== Measurement ==================== */
+
+/**
+ * @brief Operation under test; called repeatedly with the same arguments
+ */
+typedef void (*xy_bench_fn_t)(void *ctx, uint8_t *buf, size_t len);
+
+/**
+ * @brief One data point
+ */
+typedef struct {
+    const char *primitive; /**< e.g. "sha256" */
+    const char *op;        /**< e.g. "hash", "encrypt", "sign" */
+    size_t bytes;          /**< Message size, 0 for fixed-size ops */
+    uint32_t iterations;   /**< Calls in the best run */
+    double cycles_per_op;
+    double cycles_per_byte; /**< 0 when bytes == 0 */
+    double ops_per_sec;
+    double mb_per_sec; /**< 0 when bytes == 0 */
+} xy_bench_result_t;
+
+/**
+ * @brief Time @p fn, growing the iteration count until one run lasts at
+ *        least XY_BENCH_MIN_MS, and keep the best of three runs
+ */
+void xy_bench_measure(xy_bench_result_t *res, xy_bench_fn_t fn, void *ctx,
+                      uint8_t *buf, size_t len);
+
+/* ==================== Reporting ==================== */
+
+typedef enum {
+    XY_BENCH_FMT_CSV = 0,
+    XY_BENCH_FMT_JSON,
+} xy_bench_fmt_t;
+
+/**
+ * @brief Start a report (prints the header)
+ */
+void xy_bench_report_begin(xy_bench_fmt_t fmt);
+
+/**
+ * @brief Record a known-answer test outcome
+ *
+ * All KAT lines must be emitted before the first result.
+ */
+void xy_bench_report_kat(const char *name, int pass);
+
+/**
+ * @brief Record a timing result
+ */
+void xy_bench_report_result(const xy_bench_result_t *res);
+
+/**
+ * @brief Close the report
+ */
+void xy_bench_report_end(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XY_BENCH_H */
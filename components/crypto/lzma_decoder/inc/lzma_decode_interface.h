@@ -0,0 +1,85 @@
+/**
+ * @file lzma_decode_interface.h
+ * @brief FOTA wrapper: decompress an LZMA image straight into flash
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * Glues the streaming decoder to a flash partition. Each decoded page is
+ * programmed in place; sectors are erased lazily just ahead of the write
+ * cursor, so the download, decompression and flash programming overlap and
+ * no full-image staging buffer is needed.
+ */
+
+#ifndef XY_LZMA_DECODE_INTERFACE_H
+#define XY_LZMA_DECODE_INTERFACE_H
+
+#include "lzma_decoder.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Flash operations used by the FOTA wrapper
+ */
+typedef struct {
+    /** Erase one sector at @p addr (sector aligned) */
+    int (*erase)(void *ctx, uint32_t addr);
+    /** Program @p len bytes at @p addr (page aligned except the last page) */
+    int (*program)(void *ctx, uint32_t addr, const uint8_t *data,
+                   uint32_t len);
+    void *ctx;            /**< Passed to erase / program */
+    uint32_t sector_size; /**< Erase granularity */
+    uint32_t page_size;   /**< Program granularity */
+} xy_lzma_flash_ops_t;
+
+/**
+ * @brief FOTA decompression session
+ */
+typedef struct {
+    xy_lzma_dec_t dec;
+    xy_lzma_flash_ops_t ops;
+    uint32_t base_addr;  /**< Start of the destination partition */
+    uint32_t part_size;  /**< Partition size in bytes */
+    uint32_t erased_end; /**< Partition offset erased so far */
+} xy_lzma_fota_t;
+
+/**
+ * @brief Start decompressing an image into a flash partition
+ *
+ * @param fota Session context
+ * @param format Compressed stream format
+ * @param ops Flash operations
+ * @param base_addr Partition start address (sector aligned)
+ * @param part_size Partition size
+ * @param dict_buf Sliding window buffer
+ * @param dict_size Window size, multiple of ops->page_size
+ * @return XY_LZMA_OK on success, error code otherwise
+ */
+int xy_lzma_fota_begin(xy_lzma_fota_t *fota, xy_lzma_format_t format,
+                       const xy_lzma_flash_ops_t *ops, uint32_t base_addr,
+                       uint32_t part_size, uint8_t *dict_buf,
+                       uint32_t dict_size);
+
+/**
+ * @brief Feed a received fragment of the compressed image
+ *
+ * @return XY_LZMA_OK, XY_LZMA_STREAM_END or a negative error code
+ */
+int xy_lzma_fota_write(xy_lzma_fota_t *fota, const uint8_t *data,
+                       size_t len);
+
+/**
+ * @brief Finish the session after the last fragment
+ *
+ * @param fota Session context
+ * @param image_size Receives the decompressed image size (may be NULL)
+ * @return XY_LZMA_STREAM_END on success, negative error code otherwise
+ */
+int xy_lzma_fota_end(xy_lzma_fota_t *fota, uint32_t *image_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XY_LZMA_DECODE_INTERFACE_H */
@@ -0,0 +1,223 @@
+/**
+ * @file lzma_decoder.h
+ * @brief Streaming LZMA / LZMA2 decoder with a bounded sliding window
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * Push-mode decoder intended for FOTA images: compressed data is fed in
+ * arbitrary fragments as it arrives from the radio, and decompressed data
+ * is handed to a sink one page at a time directly out of the dictionary
+ * window, so no separate output buffer is needed.
+ *
+ * The dictionary (sliding window) is supplied by the caller and must be a
+ * multiple of the sink page size. Streams whose encoder dictionary is larger
+ * than the window are only accepted if the whole image fits in the window;
+ * compress images with a matching dictionary (e.g. `xz --format=lzma
+ * --lzma1=dict=16KiB,lc=3,lp=0,pb=2`).
+ */
+
+#ifndef XY_LZMA_DECODER_H
+#define XY_LZMA_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Configuration ==================== */
+
+/**
+ * @brief Largest lc + lp accepted by the decoder
+ *
+ * The literal coder needs 0x300 << (lc + lp) probabilities of 2 bytes each,
+ * so this bounds the context size: 3 -> 12 KB (xz default lc=3,lp=0),
+ * 4 -> 24 KB (LZMA2 maximum).
+ */
+#ifndef XY_LZMA_LCLP_MAX
+#define XY_LZMA_LCLP_MAX 3
+#endif
+
+/* ==================== Error Codes ==================== */
+
+#define XY_LZMA_OK                 0  /**< More input needed */
+#define XY_LZMA_STREAM_END         1  /**< Stream decoded completely */
+#define XY_LZMA_ERROR_INVALID_PARAM -1 /**< NULL pointer or bad config */
+#define XY_LZMA_ERROR_DATA         -2 /**< Corrupt compressed data */
+#define XY_LZMA_ERROR_UNSUPPORTED  -3 /**< Properties exceed build limits */
+#define XY_LZMA_ERROR_DICT         -4 /**< Stream needs a larger window */
+#define XY_LZMA_ERROR_SINK         -5 /**< Sink callback failed */
+#define XY_LZMA_ERROR_TRUNCATED    -6 /**< Input ended before stream end */
+
+/* ==================== Types ==================== */
+
+/**
+ * @brief Container format of the compressed stream
+ */
+typedef enum {
+    XY_LZMA_FORMAT_ALONE = 0, /**< .lzma: 13-byte header + LZMA1 data */
+    XY_LZMA_FORMAT_LZMA2,     /**< Raw LZMA2 chunks (as inside .xz) */
+} xy_lzma_format_t;
+
+/**
+ * @brief Page sink callback
+ *
+ * Called with each completed page of decompressed data, in order. @p data
+ * points into the dictionary window and stays valid only for the call.
+ * The last page of the stream may be shorter than the page size.
+ *
+ * @param ctx User context from the config
+ * @param offset Byte offset of @p data in the decompressed image
+ * @param data Page data
+ * @param len Page length in bytes
+ * @return 0 on success, negative to abort decoding
+ */
+typedef int (*xy_lzma_sink_t)(void *ctx, uint32_t offset, const uint8_t *data,
+                              uint32_t len);
+
+/**
+ * @brief Decoder configuration
+ */
+typedef struct {
+    xy_lzma_format_t format; /**< Stream container format */
+    uint8_t *dict_buf;       /**< Sliding window buffer */
+    uint32_t dict_size;      /**< Window size, multiple of page_size */
+    uint32_t page_size;      /**< Sink granularity (e.g. flash page) */
+    xy_lzma_sink_t sink;     /**< Page sink */
+    void *sink_ctx;          /**< Passed to sink */
+} xy_lzma_cfg_t;
+
+/**
+ * @brief Range decoder state
+ */
+typedef struct {
+    uint32_t range;
+    uint32_t code;
+    uint32_t init_bytes_left; /**< Bytes still needed to prime @c code */
+    const uint8_t *in;
+    size_t in_pos;
+    size_t in_limit; /**< Last position where a full symbol may start */
+} xy_lzma_rc_t;
+
+/**
+ * @brief Length decoder probabilities
+ */
+typedef struct {
+    uint16_t choice;
+    uint16_t choice2;
+    uint16_t low[16][8];
+    uint16_t mid[16][8];
+    uint16_t high[256];
+} xy_lzma_len_dec_t;
+
+/**
+ * @brief Decoder context
+ *
+ * Size is about 3.7 KB + (1.5 KB << (XY_LZMA_LCLP_MAX)), independent of the
+ * window size. Allocate statically; no heap is used.
+ */
+typedef struct {
+    xy_lzma_cfg_t cfg;
+
+    /* Sliding window */
+    uint32_t dict_pos;   /**< Write position in the window */
+    uint32_t dict_full;  /**< Valid history bytes (<= dict_size) */
+    uint32_t dict_start; /**< Start of the page not yet handed to the sink */
+    uint32_t dict_limit; /**< End of the current page */
+    uint32_t total_out;  /**< Bytes produced since stream start */
+    uint32_t dict_base;  /**< total_out at the last dictionary reset */
+    uint32_t out_left;   /**< Bytes left in chunk / stream */
+
+    /* Stream state */
+    uint8_t seq;
+    uint8_t header_pos;
+    uint8_t size_known;
+    uint8_t need_dict_reset;
+    uint8_t need_props;
+    uint8_t header[13];
+    uint32_t chunk_in_left; /**< Compressed bytes left in the chunk */
+    uint32_t next_chunk_in; /**< Compressed size parsed from LZMA2 header */
+    uint8_t chunk_ctrl;
+
+    /* Properties */
+    uint8_t lc;
+    uint8_t literal_pos_mask;
+    uint8_t pos_mask;
+
+    /* LZMA state */
+    uint8_t state;
+    uint32_t rep0, rep1, rep2, rep3;
+    uint32_t len; /**< Pending match bytes not yet copied */
+
+    xy_lzma_rc_t rc;
+
+    /* Input carried over between push calls */
+    uint8_t temp[2 * 21];
+    uint32_t temp_size;
+
+    /* Probabilities */
+    uint16_t is_match[12][16];
+    uint16_t is_rep[12];
+    uint16_t is_rep0[12];
+    uint16_t is_rep1[12];
+    uint16_t is_rep2[12];
+    uint16_t is_rep0_long[12][16];
+    uint16_t dist_slot[4][64];
+    uint16_t dist_special[114];
+    uint16_t dist_align[16];
+    xy_lzma_len_dec_t match_len;
+    xy_lzma_len_dec_t rep_len;
+    uint16_t literal[1u << XY_LZMA_LCLP_MAX][0x300];
+} xy_lzma_dec_t;
+
+/* ==================== API ==================== */
+
+/**
+ * @brief Initialize a decoder
+ *
+ * For XY_LZMA_FORMAT_LZMA2 the window size is taken from @p cfg; the LZMA2
+ * dictionary property byte is not part of the raw chunk stream.
+ *
+ * @param dec Decoder context
+ * @param cfg Configuration, copied into the context
+ * @return XY_LZMA_OK on success, error code otherwise
+ */
+int xy_lzma_dec_init(xy_lzma_dec_t *dec, const xy_lzma_cfg_t *cfg);
+
+/**
+ * @brief Feed a fragment of compressed input
+ *
+ * The whole fragment is always consumed; bytes that cannot be decoded yet
+ * are carried over internally. Completed pages are passed to the sink from
+ * inside this call. Bytes after the end of the stream are ignored.
+ *
+ * @param dec Decoder context
+ * @param in Input fragment
+ * @param len Fragment length
+ * @return XY_LZMA_OK if more input is expected, XY_LZMA_STREAM_END when the
+ *         stream is complete, or a negative error code
+ */
+int xy_lzma_dec_push(xy_lzma_dec_t *dec, const uint8_t *in, size_t len);
+
+/**
+ * @brief Signal end of input and flush the last partial page
+ *
+ * Needed for .lzma streams that end exactly at the end of input without
+ * an end marker, and to deliver the final partial page to the sink.
+ *
+ * @param dec Decoder context
+ * @return XY_LZMA_STREAM_END on success, negative error code otherwise
+ */
+int xy_lzma_dec_finish(xy_lzma_dec_t *dec);
+
+/**
+ * @brief Get the number of decompressed bytes produced so far
+ */
+uint32_t xy_lzma_dec_total_out(const xy_lzma_dec_t *dec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XY_LZMA_DECODER_H */
@@ -0,0 +1,87 @@
+/**
+ * @file lzma_decode_interface.c
+ * @brief FOTA wrapper implementation
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "lzma_decode_interface.h"
+#include <stddef.h>
+
+/**
+ * @brief Decoder sink: erase ahead as needed, then program the page
+ */
+static int prv_fota_sink(void *ctx, uint32_t offset, const uint8_t *data,
+                         uint32_t len)
+{
+    xy_lzma_fota_t *fota = (xy_lzma_fota_t *)ctx;
+    uint32_t end = offset + len;
+
+    if (end > fota->part_size || end < offset) {
+        return -1;
+    }
+
+    while (fota->erased_end < end) {
+        if (fota->ops.erase(fota->ops.ctx,
+                            fota->base_addr + fota->erased_end)
+            != 0) {
+            return -1;
+        }
+        fota->erased_end += fota->ops.sector_size;
+    }
+
+    return fota->ops.program(fota->ops.ctx, fota->base_addr + offset, data,
+                             len);
+}
+
+int xy_lzma_fota_begin(xy_lzma_fota_t *fota, xy_lzma_format_t format,
+                       const xy_lzma_flash_ops_t *ops, uint32_t base_addr,
+                       uint32_t part_size, uint8_t *dict_buf,
+                       uint32_t dict_size)
+{
+    xy_lzma_cfg_t cfg;
+
+    if (fota == NULL || ops == NULL || ops->erase == NULL
+        || ops->program == NULL || ops->sector_size == 0
+        || ops->page_size == 0 || (base_addr % ops->sector_size) != 0) {
+        return XY_LZMA_ERROR_INVALID_PARAM;
+    }
+
+    fota->ops = *ops;
+    fota->base_addr = base_addr;
+    fota->part_size = part_size;
+    fota->erased_end = 0;
+
+    cfg.format = format;
+    cfg.dict_buf = dict_buf;
+    cfg.dict_size = dict_size;
+    cfg.page_size = ops->page_size;
+    cfg.sink = prv_fota_sink;
+    cfg.sink_ctx = fota;
+
+    return xy_lzma_dec_init(&fota->dec, &cfg);
+}
+
+int xy_lzma_fota_write(xy_lzma_fota_t *fota, const uint8_t *data,
+                       size_t len)
+{
+    if (fota == NULL) {
+        return XY_LZMA_ERROR_INVALID_PARAM;
+    }
+    return xy_lzma_dec_push(&fota->dec, data, len);
+}
+
+int xy_lzma_fota_end(xy_lzma_fota_t *fota, uint32_t *image_size)
+{
+    int ret;
+
+    if (fota == NULL) {
+        return XY_LZMA_ERROR_INVALID_PARAM;
+    }
+
+    ret = xy_lzma_dec_finish(&fota->dec);
+    if (ret == XY_LZMA_STREAM_END && image_size != NULL) {
+        *image_size = xy_lzma_dec_total_out(&fota->dec);
+    }
+    return ret;
+}
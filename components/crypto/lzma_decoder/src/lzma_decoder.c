@@ -0,0 +1,889 @@
+/**
+ * @file lzma_decoder.c
+ * @brief Streaming LZMA / LZMA2 decoder implementation
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * The range coder and symbol decoding follow the reference LZMA SDK and
+ * xz-embedded (both public domain). Input handling borrows the xz-embedded
+ * trick of only starting a symbol when XY_LZMA_IN_REQUIRED bytes are
+ * available, carrying shorter tails over in a small temp buffer, so the
+ * symbol decoder itself never has to suspend mid-symbol.
+ */
+
+#include "lzma_decoder.h"
+#include <stddef.h>
+#include <string.h>
+
+/* ==================== Constants ==================== */
+
+/** Worst-case input bytes consumed by one symbol */
+#define XY_LZMA_IN_REQUIRED 21
+
+#define RC_TOP_VALUE      (1u << 24)
+#define RC_BIT_MODEL_BITS 11
+#define RC_BIT_MODEL_TOTAL (1u << RC_BIT_MODEL_BITS)
+#define RC_MOVE_BITS      5
+#define RC_INIT_BYTES     5
+
+#define LZMA_STATES         12
+#define LZMA_LIT_STATES     7
+#define MATCH_LEN_MIN       2
+#define DIST_STATES         4
+#define DIST_SLOTS          64
+#define DIST_MODEL_START    4
+#define DIST_MODEL_END      14
+#define ALIGN_BITS          4
+#define LEN_LOW_SYMBOLS     8
+#define LEN_MID_SYMBOLS     8
+#define LEN_HIGH_SYMBOLS    256
+
+#define LZMA_PROPS_MAX      (9 * 5 * 5)
+#define LZMA_ALONE_HDR_SIZE 13
+
+enum {
+    SEQ_ALONE_HEADER = 0,
+    SEQ_CONTROL,
+    SEQ_UNCOMPRESSED_1,
+    SEQ_UNCOMPRESSED_2,
+    SEQ_COMPRESSED_1,
+    SEQ_COMPRESSED_2,
+    SEQ_PROPERTIES,
+    SEQ_RC_INIT,
+    SEQ_LZMA_RUN,
+    SEQ_COPY,
+    SEQ_END,
+    SEQ_ERROR,
+};
+
+/* lzma_main() results besides negative error codes */
+#define PRV_NEED_INPUT 0
+#define PRV_CHUNK_DONE 1
+
+/* ==================== Sliding Window ==================== */
+
+/**
+ * @brief Hand the current page to the sink and advance to the next one
+ */
+static int prv_dict_flush(xy_lzma_dec_t *dec)
+{
+    uint32_t len = dec->dict_pos - dec->dict_start;
+
+    if (len > 0) {
+        if (dec->cfg.sink(dec->cfg.sink_ctx, dec->total_out - len,
+                          dec->cfg.dict_buf + dec->dict_start, len)
+            != 0) {
+            return XY_LZMA_ERROR_SINK;
+        }
+    }
+
+    if (dec->dict_pos == dec->cfg.dict_size) {
+        dec->dict_pos = 0;
+    }
+    dec->dict_start = dec->dict_pos;
+    dec->dict_limit = dec->dict_start + dec->cfg.page_size;
+    return 0;
+}
+
+static void prv_dict_reset(xy_lzma_dec_t *dec)
+{
+    dec->dict_full = 0;
+    dec->dict_base = dec->total_out;
+}
+
+static inline uint32_t prv_dict_get(const xy_lzma_dec_t *dec, uint32_t dist)
+{
+    uint32_t i = dec->dict_pos - dist - 1;
+
+    if (dist >= dec->dict_pos) {
+        i += dec->cfg.dict_size;
+    }
+    return dec->cfg.dict_buf[i];
+}
+
+static inline void prv_dict_put(xy_lzma_dec_t *dec, uint8_t byte)
+{
+    dec->cfg.dict_buf[dec->dict_pos++] = byte;
+    dec->total_out++;
+    dec->out_left--;
+    if (dec->dict_full < dec->cfg.dict_size) {
+        dec->dict_full++;
+    }
+}
+
+/**
+ * @brief Copy pending match bytes up to the end of the current page
+ */
+static void prv_dict_repeat(xy_lzma_dec_t *dec)
+{
+    uint8_t *buf = dec->cfg.dict_buf;
+    uint32_t left = dec->dict_limit - dec->dict_pos;
+    uint32_t back;
+
+    if (left > dec->len) {
+        left = dec->len;
+    }
+
+    back = dec->dict_pos - dec->rep0 - 1;
+    if (dec->rep0 >= dec->dict_pos) {
+        back += dec->cfg.dict_size;
+    }
+
+    dec->len -= left;
+    dec->total_out += left;
+    dec->out_left -= left;
+    dec->dict_full += left;
+    if (dec->dict_full > dec->cfg.dict_size) {
+        dec->dict_full = dec->cfg.dict_size;
+    }
+
+    do {
+        buf[dec->dict_pos++] = buf[back++];
+        if (back == dec->cfg.dict_size) {
+            back = 0;
+        }
+    } while (--left > 0);
+}
+
+/* ==================== Range Decoder ==================== */
+
+static void prv_rc_reset(xy_lzma_rc_t *rc)
+{
+    rc->range = 0xFFFFFFFFu;
+    rc->code = 0;
+    rc->init_bytes_left = RC_INIT_BYTES;
+}
+
+static inline void prv_rc_normalize(xy_lzma_rc_t *rc)
+{
+    if (rc->range < RC_TOP_VALUE) {
+        rc->range <<= 8;
+        rc->code = (rc->code << 8) | rc->in[rc->in_pos++];
+    }
+}
+
+static inline uint32_t prv_rc_bit(xy_lzma_rc_t *rc, uint16_t *prob)
+{
+    uint32_t bound;
+
+    prv_rc_normalize(rc);
+    bound = (rc->range >> RC_BIT_MODEL_BITS) * *prob;
+    if (rc->code < bound) {
+        rc->range = bound;
+        *prob += (RC_BIT_MODEL_TOTAL - *prob) >> RC_MOVE_BITS;
+        return 0;
+    }
+    rc->range -= bound;
+    rc->code -= bound;
+    *prob -= *prob >> RC_MOVE_BITS;
+    return 1;
+}
+
+static inline uint32_t prv_rc_bittree(xy_lzma_rc_t *rc, uint16_t *probs,
+                                      uint32_t limit)
+{
+    uint32_t symbol = 1;
+
+    do {
+        symbol = (symbol << 1) | prv_rc_bit(rc, &probs[symbol]);
+    } while (symbol < limit);
+
+    return symbol;
+}
+
+static inline void prv_rc_bittree_reverse(xy_lzma_rc_t *rc, uint16_t *probs,
+                                          uint32_t *dest, uint32_t limit)
+{
+    uint32_t symbol = 1;
+    uint32_t i = 0;
+
+    do {
+        if (prv_rc_bit(rc, &probs[symbol])) {
+            symbol = (symbol << 1) + 1;
+            *dest += 1u << i;
+        } else {
+            symbol <<= 1;
+        }
+    } while (++i < limit);
+}
+
+static inline void prv_rc_direct(xy_lzma_rc_t *rc, uint32_t *dest,
+                                 uint32_t limit)
+{
+    uint32_t mask;
+
+    do {
+        prv_rc_normalize(rc);
+        rc->range >>= 1;
+        rc->code -= rc->range;
+        mask = 0u - (rc->code >> 31);
+        rc->code += rc->range & mask;
+        *dest = (*dest << 1) + (mask + 1);
+    } while (--limit > 0);
+}
+
+/* ==================== LZMA Symbol Decoding ==================== */
+
+static void prv_lzma_reset(xy_lzma_dec_t *dec)
+{
+    uint16_t *probs = &dec->is_match[0][0];
+    size_t count;
+    size_t i;
+
+    /* Only the literal coders selected by lc/lp need initialising */
+    count = (offsetof(xy_lzma_dec_t, literal) - offsetof(xy_lzma_dec_t, is_match))
+                / sizeof(uint16_t)
+            + ((size_t)0x300 << dec->lc) * ((size_t)dec->literal_pos_mask + 1);
+
+    for (i = 0; i < count; i++) {
+        probs[i] = RC_BIT_MODEL_TOTAL / 2;
+    }
+
+    dec->state = 0;
+    dec->rep0 = 0;
+    dec->rep1 = 0;
+    dec->rep2 = 0;
+    dec->rep3 = 0;
+    dec->len = 0;
+    prv_rc_reset(&dec->rc);
+}
+
+static int prv_lzma_props(xy_lzma_dec_t *dec, uint8_t props)
+{
+    uint32_t lc, lp, pb;
+
+    if (props >= LZMA_PROPS_MAX) {
+        return XY_LZMA_ERROR_DATA;
+    }
+
+    lc = props % 9;
+    props /= 9;
+    lp = props % 5;
+    pb = props / 5;
+
+    if (lc + lp > XY_LZMA_LCLP_MAX) {
+        return XY_LZMA_ERROR_UNSUPPORTED;
+    }
+
+    dec->lc = (uint8_t)lc;
+    dec->literal_pos_mask = (uint8_t)((1u << lp) - 1);
+    dec->pos_mask = (uint8_t)((1u << pb) - 1);
+    return XY_LZMA_OK;
+}
+
+static void prv_lzma_literal(xy_lzma_dec_t *dec, uint32_t pos)
+{
+    xy_lzma_rc_t *rc = &dec->rc;
+    uint16_t *probs;
+    uint32_t prev = dec->dict_full ? prv_dict_get(dec, 0) : 0;
+    uint32_t symbol;
+    uint32_t match_byte;
+    uint32_t match_bit;
+    uint32_t offset;
+
+    probs = dec->literal[((pos & dec->literal_pos_mask) << dec->lc)
+                         + (prev >> (8 - dec->lc))];
+
+    if (dec->state < LZMA_LIT_STATES) {
+        symbol = prv_rc_bittree(rc, probs, 0x100);
+    } else {
+        symbol = 1;
+        match_byte = prv_dict_get(dec, dec->rep0) << 1;
+        offset = 0x100;
+        do {
+            match_bit = match_byte & offset;
+            match_byte <<= 1;
+            if (prv_rc_bit(rc, &probs[offset + match_bit + symbol])) {
+                symbol = (symbol << 1) + 1;
+                offset &= match_bit;
+            } else {
+                symbol <<= 1;
+                offset &= ~match_bit;
+            }
+        } while (symbol < 0x100);
+    }
+
+    prv_dict_put(dec, (uint8_t)symbol);
+
+    if (dec->state < 4) {
+        dec->state = 0;
+    } else if (dec->state < 10) {
+        dec->state -= 3;
+    } else {
+        dec->state -= 6;
+    }
+}
+
+static uint32_t prv_lzma_len(xy_lzma_dec_t *dec, xy_lzma_len_dec_t *l,
+                             uint32_t pos_state)
+{
+    xy_lzma_rc_t *rc = &dec->rc;
+
+    if (!prv_rc_bit(rc, &l->choice)) {
+        return MATCH_LEN_MIN
+               + prv_rc_bittree(rc, l->low[pos_state], LEN_LOW_SYMBOLS)
+               - LEN_LOW_SYMBOLS;
+    }
+    if (!prv_rc_bit(rc, &l->choice2)) {
+        return MATCH_LEN_MIN + LEN_LOW_SYMBOLS
+               + prv_rc_bittree(rc, l->mid[pos_state], LEN_MID_SYMBOLS)
+               - LEN_MID_SYMBOLS;
+    }
+    return MATCH_LEN_MIN + LEN_LOW_SYMBOLS + LEN_MID_SYMBOLS
+           + prv_rc_bittree(rc, l->high, LEN_HIGH_SYMBOLS) - LEN_HIGH_SYMBOLS;
+}
+
+static void prv_lzma_match(xy_lzma_dec_t *dec, uint32_t pos_state)
+{
+    xy_lzma_rc_t *rc = &dec->rc;
+    uint32_t dist_state;
+    uint32_t dist_slot;
+    uint32_t limit;
+
+    dec->state = dec->state < LZMA_LIT_STATES ? 7 : 10;
+    dec->rep3 = dec->rep2;
+    dec->rep2 = dec->rep1;
+    dec->rep1 = dec->rep0;
+
+    dec->len = prv_lzma_len(dec, &dec->match_len, pos_state);
+
+    dist_state = dec->len < MATCH_LEN_MIN + DIST_STATES
+                     ? dec->len - MATCH_LEN_MIN
+                     : DIST_STATES - 1;
+    dist_slot =
+        prv_rc_bittree(rc, dec->dist_slot[dist_state], DIST_SLOTS) - DIST_SLOTS;
+
+    if (dist_slot < DIST_MODEL_START) {
+        dec->rep0 = dist_slot;
+        return;
+    }
+
+    limit = (dist_slot >> 1) - 1;
+    dec->rep0 = 2 + (dist_slot & 1);
+
+    if (dist_slot < DIST_MODEL_END) {
+        dec->rep0 <<= limit;
+        prv_rc_bittree_reverse(rc, dec->dist_special + dec->rep0 - dist_slot - 1,
+                               &dec->rep0, limit);
+    } else {
+        prv_rc_direct(rc, &dec->rep0, limit - ALIGN_BITS);
+        dec->rep0 <<= ALIGN_BITS;
+        prv_rc_bittree_reverse(rc, dec->dist_align, &dec->rep0, ALIGN_BITS);
+    }
+}
+
+static void prv_lzma_rep_match(xy_lzma_dec_t *dec, uint32_t pos_state)
+{
+    xy_lzma_rc_t *rc = &dec->rc;
+    uint32_t tmp;
+
+    if (!prv_rc_bit(rc, &dec->is_rep0[dec->state])) {
+        if (!prv_rc_bit(rc, &dec->is_rep0_long[dec->state][pos_state])) {
+            dec->state = dec->state < LZMA_LIT_STATES ? 9 : 11;
+            dec->len = 1;
+            return;
+        }
+    } else {
+        if (!prv_rc_bit(rc, &dec->is_rep1[dec->state])) {
+            tmp = dec->rep1;
+        } else {
+            if (!prv_rc_bit(rc, &dec->is_rep2[dec->state])) {
+                tmp = dec->rep2;
+            } else {
+                tmp = dec->rep3;
+                dec->rep3 = dec->rep2;
+            }
+            dec->rep2 = dec->rep1;
+        }
+        dec->rep1 = dec->rep0;
+        dec->rep0 = tmp;
+    }
+
+    dec->state = dec->state < LZMA_LIT_STATES ? 8 : 11;
+    dec->len = prv_lzma_len(dec, &dec->rep_len, pos_state);
+}
+
+/**
+ * @brief Decode one literal, match or rep-match
+ */
+static int prv_lzma_symbol(xy_lzma_dec_t *dec)
+{
+    xy_lzma_rc_t *rc = &dec->rc;
+    uint32_t pos = dec->total_out - dec->dict_base;
+    uint32_t pos_state = pos & dec->pos_mask;
+
+    if (!prv_rc_bit(rc, &dec->is_match[dec->state][pos_state])) {
+        prv_lzma_literal(dec, pos);
+        return 0;
+    }
+
+    if (prv_rc_bit(rc, &dec->is_rep[dec->state])) {
+        if (dec->dict_full == 0) {
+            return XY_LZMA_ERROR_DATA;
+        }
+        prv_lzma_rep_match(dec, pos_state);
+    } else {
+        prv_lzma_match(dec, pos_state);
+        if (dec->rep0 == 0xFFFFFFFFu) {
+            /* End-of-payload marker: .lzma only, and only where allowed */
+            if (dec->cfg.format != XY_LZMA_FORMAT_ALONE
+                || (dec->size_known && dec->out_left != 0)) {
+                return XY_LZMA_ERROR_DATA;
+            }
+            dec->len = 0;
+            dec->out_left = 0;
+            return 0;
+        }
+        if (dec->rep0 >= dec->dict_full) {
+            return dec->rep0 >= dec->cfg.dict_size ? XY_LZMA_ERROR_DICT
+                                                   : XY_LZMA_ERROR_DATA;
+        }
+    }
+
+    if (dec->len > dec->out_left) {
+        return XY_LZMA_ERROR_DATA;
+    }
+    return 0;
+}
+
+/**
+ * @brief Decode symbols until input limit, chunk end or error
+ *
+ * @return PRV_NEED_INPUT, PRV_CHUNK_DONE or a negative error code
+ */
+static int prv_lzma_main(xy_lzma_dec_t *dec)
+{
+    int ret;
+
+    for (;;) {
+        if (dec->dict_pos == dec->dict_limit) {
+            ret = prv_dict_flush(dec);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+
+        if (dec->len > 0) {
+            prv_dict_repeat(dec);
+            continue;
+        }
+
+        if (dec->out_left == 0) {
+            /* Pull in the byte the encoder's flush left pending */
+            prv_rc_normalize(&dec->rc);
+            return PRV_CHUNK_DONE;
+        }
+
+        if (dec->rc.in_pos > dec->rc.in_limit) {
+            prv_rc_normalize(&dec->rc);
+            return PRV_NEED_INPUT;
+        }
+
+        ret = prv_lzma_symbol(dec);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+}
+
+/**
+ * @brief Run the LZMA decoder over as much of @p in as is safe
+ *
+ * Consumes compressed bytes of the current chunk, never more than
+ * chunk_in_left. Tails shorter than XY_LZMA_IN_REQUIRED are kept in
+ * dec->temp until more input arrives or the chunk end is known.
+ */
+static int prv_lzma_run(xy_lzma_dec_t *dec, const uint8_t *in, size_t in_size,
+                        size_t *in_pos)
+{
+    xy_lzma_rc_t *rc = &dec->rc;
+    size_t in_avail = in_size - *in_pos;
+    size_t used;
+    uint32_t tmp;
+    int ret;
+
+    if (dec->temp_size > 0 || dec->chunk_in_left == 0) {
+        tmp = 2 * XY_LZMA_IN_REQUIRED - dec->temp_size;
+        if (tmp > dec->chunk_in_left - dec->temp_size) {
+            tmp = dec->chunk_in_left - dec->temp_size;
+        }
+        if (tmp > in_avail) {
+            tmp = (uint32_t)in_avail;
+        }
+        memcpy(dec->temp + dec->temp_size, in + *in_pos, tmp);
+
+        if (dec->temp_size + tmp == dec->chunk_in_left) {
+            /* Chunk end is known: zero-pad so over-reads are detected */
+            memset(dec->temp + dec->temp_size + tmp, 0,
+                   sizeof(dec->temp) - dec->temp_size - tmp);
+            rc->in_limit = dec->temp_size + tmp;
+        } else if (dec->temp_size + tmp < XY_LZMA_IN_REQUIRED) {
+            dec->temp_size += tmp;
+            *in_pos += tmp;
+            return PRV_NEED_INPUT;
+        } else {
+            rc->in_limit = dec->temp_size + tmp - XY_LZMA_IN_REQUIRED;
+        }
+
+        rc->in = dec->temp;
+        rc->in_pos = 0;
+        ret = prv_lzma_main(dec);
+        if (ret < 0) {
+            return ret;
+        }
+        if (rc->in_pos > dec->temp_size + tmp) {
+            return XY_LZMA_ERROR_DATA;
+        }
+        dec->chunk_in_left -= (uint32_t)rc->in_pos;
+
+        if (rc->in_pos < dec->temp_size) {
+            dec->temp_size -= (uint32_t)rc->in_pos;
+            memmove(dec->temp, dec->temp + rc->in_pos, dec->temp_size);
+            if (ret == PRV_CHUNK_DONE) {
+                dec->temp_size = 0;
+            }
+            return ret;
+        }
+
+        *in_pos += rc->in_pos - dec->temp_size;
+        dec->temp_size = 0;
+        if (ret == PRV_CHUNK_DONE) {
+            return ret;
+        }
+    }
+
+    in_avail = in_size - *in_pos;
+    if (in_avail >= XY_LZMA_IN_REQUIRED) {
+        rc->in = in;
+        rc->in_pos = *in_pos;
+        if (in_avail - XY_LZMA_IN_REQUIRED >= dec->chunk_in_left) {
+            rc->in_limit = *in_pos + dec->chunk_in_left;
+        } else {
+            rc->in_limit = in_size - XY_LZMA_IN_REQUIRED;
+        }
+
+        ret = prv_lzma_main(dec);
+        if (ret < 0) {
+            return ret;
+        }
+        used = rc->in_pos - *in_pos;
+        if (used > dec->chunk_in_left) {
+            return XY_LZMA_ERROR_DATA;
+        }
+        dec->chunk_in_left -= (uint32_t)used;
+        *in_pos = rc->in_pos;
+        if (ret == PRV_CHUNK_DONE) {
+            return ret;
+        }
+    }
+
+    in_avail = in_size - *in_pos;
+    if (in_avail < XY_LZMA_IN_REQUIRED) {
+        if (in_avail > dec->chunk_in_left) {
+            in_avail = dec->chunk_in_left;
+        }
+        memcpy(dec->temp, in + *in_pos, in_avail);
+        dec->temp_size = (uint32_t)in_avail;
+        *in_pos += in_avail;
+    }
+
+    return PRV_NEED_INPUT;
+}
+
+/* ==================== Container Parsing ==================== */
+
+static uint32_t prv_load32_le(const uint8_t *src)
+{
+    return ((uint32_t)src[0]) | ((uint32_t)src[1] << 8)
+           | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+static int prv_alone_header(xy_lzma_dec_t *dec)
+{
+    uint32_t dict_size = prv_load32_le(dec->header + 1);
+    uint32_t size_lo = prv_load32_le(dec->header + 5);
+    uint32_t size_hi = prv_load32_le(dec->header + 9);
+    int ret;
+
+    ret = prv_lzma_props(dec, dec->header[0]);
+    if (ret != XY_LZMA_OK) {
+        return ret;
+    }
+
+    if (size_lo == 0xFFFFFFFFu && size_hi == 0xFFFFFFFFu) {
+        dec->size_known = 0;
+        dec->out_left = 0xFFFFFFFFu;
+    } else if (size_hi != 0) {
+        return XY_LZMA_ERROR_UNSUPPORTED;
+    } else {
+        dec->size_known = 1;
+        dec->out_left = size_lo;
+    }
+
+    if (dict_size > dec->cfg.dict_size
+        && !(dec->size_known && dec->out_left <= dec->cfg.dict_size)) {
+        return XY_LZMA_ERROR_DICT;
+    }
+
+    prv_lzma_reset(dec);
+    prv_dict_reset(dec);
+    dec->chunk_in_left = 0xFFFFFFFFu;
+    return XY_LZMA_OK;
+}
+
+/**
+ * @brief Parse an LZMA2 control byte
+ */
+static int prv_lzma2_control(xy_lzma_dec_t *dec, uint8_t ctrl)
+{
+    if (ctrl == 0x00) {
+        return XY_LZMA_STREAM_END;
+    }
+
+    if (ctrl >= 0xE0 || ctrl == 0x01) {
+        dec->need_props = 1;
+        dec->need_dict_reset = 0;
+        prv_dict_reset(dec);
+    } else if (dec->need_dict_reset) {
+        return XY_LZMA_ERROR_DATA;
+    }
+
+    dec->chunk_ctrl = ctrl;
+    if (ctrl >= 0x80) {
+        dec->out_left = (uint32_t)(ctrl & 0x1F) << 16;
+        dec->seq = SEQ_UNCOMPRESSED_1;
+        if (ctrl >= 0xC0) {
+            dec->need_props = 0;
+        } else if (dec->need_props) {
+            return XY_LZMA_ERROR_DATA;
+        } else if (ctrl >= 0xA0) {
+            prv_lzma_reset(dec);
+        }
+    } else {
+        if (ctrl > 0x02) {
+            return XY_LZMA_ERROR_DATA;
+        }
+        dec->seq = SEQ_COMPRESSED_1;
+    }
+    return XY_LZMA_OK;
+}
+
+static int prv_end(xy_lzma_dec_t *dec)
+{
+    int ret = prv_dict_flush(dec);
+
+    if (ret != 0) {
+        dec->seq = SEQ_ERROR;
+        return ret;
+    }
+    dec->seq = SEQ_END;
+    return XY_LZMA_STREAM_END;
+}
+
+/**
+ * @brief Handle completion of an LZMA chunk or .lzma payload
+ */
+static int prv_chunk_done(xy_lzma_dec_t *dec)
+{
+    if (dec->cfg.format == XY_LZMA_FORMAT_ALONE) {
+        return prv_end(dec);
+    }
+
+    if (dec->chunk_in_left != 0 || dec->rc.code != 0) {
+        return XY_LZMA_ERROR_DATA;
+    }
+    prv_rc_reset(&dec->rc);
+    dec->seq = SEQ_CONTROL;
+    return XY_LZMA_OK;
+}
+
+/* ==================== API ==================== */
+
+int xy_lzma_dec_init(xy_lzma_dec_t *dec, const xy_lzma_cfg_t *cfg)
+{
+    if (dec == NULL || cfg == NULL || cfg->dict_buf == NULL
+        || cfg->sink == NULL || cfg->page_size == 0
+        || cfg->dict_size < cfg->page_size
+        || (cfg->dict_size % cfg->page_size) != 0) {
+        return XY_LZMA_ERROR_INVALID_PARAM;
+    }
+    if (cfg->format != XY_LZMA_FORMAT_ALONE
+        && cfg->format != XY_LZMA_FORMAT_LZMA2) {
+        return XY_LZMA_ERROR_INVALID_PARAM;
+    }
+
+    memset(dec, 0, offsetof(xy_lzma_dec_t, is_match));
+    dec->cfg = *cfg;
+    dec->dict_limit = cfg->page_size;
+    prv_rc_reset(&dec->rc);
+
+    if (cfg->format == XY_LZMA_FORMAT_ALONE) {
+        dec->seq = SEQ_ALONE_HEADER;
+    } else {
+        dec->seq = SEQ_CONTROL;
+        dec->need_dict_reset = 1;
+        dec->need_props = 1;
+    }
+    return XY_LZMA_OK;
+}
+
+int xy_lzma_dec_push(xy_lzma_dec_t *dec, const uint8_t *in, size_t len)
+{
+    size_t pos = 0;
+    uint32_t n;
+    int ret = XY_LZMA_OK;
+
+    if (dec == NULL || (in == NULL && len > 0)) {
+        return XY_LZMA_ERROR_INVALID_PARAM;
+    }
+
+    while (pos < len && ret == XY_LZMA_OK) {
+        switch (dec->seq) {
+        case SEQ_ALONE_HEADER:
+            dec->header[dec->header_pos++] = in[pos++];
+            if (dec->header_pos == LZMA_ALONE_HDR_SIZE) {
+                ret = prv_alone_header(dec);
+                dec->seq = SEQ_RC_INIT;
+            }
+            break;
+
+        case SEQ_CONTROL:
+            ret = prv_lzma2_control(dec, in[pos++]);
+            if (ret == XY_LZMA_STREAM_END) {
+                ret = prv_end(dec);
+            }
+            break;
+
+        case SEQ_UNCOMPRESSED_1:
+            dec->out_left += (uint32_t)in[pos++] << 8;
+            dec->seq = SEQ_UNCOMPRESSED_2;
+            break;
+
+        case SEQ_UNCOMPRESSED_2:
+            dec->out_left += (uint32_t)in[pos++] + 1;
+            dec->seq = SEQ_COMPRESSED_1;
+            break;
+
+        case SEQ_COMPRESSED_1:
+            dec->next_chunk_in = (uint32_t)in[pos++] << 8;
+            dec->seq = SEQ_COMPRESSED_2;
+            break;
+
+        case SEQ_COMPRESSED_2:
+            dec->next_chunk_in += (uint32_t)in[pos++] + 1;
+            if (dec->chunk_ctrl < 0x80) {
+                /* Uncompressed chunk: the size field is the data size */
+                dec->out_left = dec->next_chunk_in;
+                dec->seq = SEQ_COPY;
+            } else if (dec->next_chunk_in < RC_INIT_BYTES) {
+                ret = XY_LZMA_ERROR_DATA;
+            } else {
+                dec->chunk_in_left = dec->next_chunk_in - RC_INIT_BYTES;
+                dec->seq = dec->chunk_ctrl >= 0xC0 ? SEQ_PROPERTIES
+                                                   : SEQ_RC_INIT;
+            }
+            break;
+
+        case SEQ_PROPERTIES:
+            ret = prv_lzma_props(dec, in[pos++]);
+            if (ret == XY_LZMA_OK) {
+                prv_lzma_reset(dec);
+                dec->seq = SEQ_RC_INIT;
+            }
+            break;
+
+        case SEQ_RC_INIT:
+            if (dec->rc.init_bytes_left == RC_INIT_BYTES && in[pos] != 0x00) {
+                ret = XY_LZMA_ERROR_DATA;
+                break;
+            }
+            dec->rc.code = (dec->rc.code << 8) | in[pos++];
+            if (--dec->rc.init_bytes_left == 0) {
+                dec->seq = SEQ_LZMA_RUN;
+            }
+            break;
+
+        case SEQ_LZMA_RUN:
+            ret = prv_lzma_run(dec, in, len, &pos);
+            if (ret == PRV_CHUNK_DONE) {
+                ret = prv_chunk_done(dec);
+            }
+            break;
+
+        case SEQ_COPY:
+            while (pos < len && dec->out_left > 0) {
+                if (dec->dict_pos == dec->dict_limit) {
+                    ret = prv_dict_flush(dec);
+                    if (ret != 0) {
+                        break;
+                    }
+                }
+                n = dec->dict_limit - dec->dict_pos;
+                if (n > dec->out_left) {
+                    n = dec->out_left;
+                }
+                if (n > len - pos) {
+                    n = (uint32_t)(len - pos);
+                }
+                memcpy(dec->cfg.dict_buf + dec->dict_pos, in + pos, n);
+                pos += n;
+                dec->dict_pos += n;
+                dec->total_out += n;
+                dec->out_left -= n;
+                dec->dict_full += n;
+                if (dec->dict_full > dec->cfg.dict_size) {
+                    dec->dict_full = dec->cfg.dict_size;
+                }
+            }
+            if (ret == XY_LZMA_OK && dec->out_left == 0) {
+                dec->seq = SEQ_CONTROL;
+            }
+            break;
+
+        case SEQ_END:
+            return XY_LZMA_STREAM_END;
+
+        default:
+            return XY_LZMA_ERROR_DATA;
+        }
+    }
+
+    if (ret < 0) {
+        dec->seq = SEQ_ERROR;
+    }
+    return ret;
+}
+
+int xy_lzma_dec_finish(xy_lzma_dec_t *dec)
+{
+    size_t pos = 0;
+    int ret;
+
+    if (dec == NULL) {
+        return XY_LZMA_ERROR_INVALID_PARAM;
+    }
+
+    if (dec->seq == SEQ_END) {
+        return XY_LZMA_STREAM_END;
+    }
+
+    if (dec->cfg.format != XY_LZMA_FORMAT_ALONE || dec->seq != SEQ_LZMA_RUN) {
+        dec->seq = SEQ_ERROR;
+        return XY_LZMA_ERROR_TRUNCATED;
+    }
+
+    /* The compressed payload ends with whatever is carried over */
+    dec->chunk_in_left = dec->temp_size;
+    ret = prv_lzma_run(dec, dec->temp, 0, &pos);
+    if (ret == PRV_CHUNK_DONE) {
+        return prv_end(dec);
+    }
+
+    dec->seq = SEQ_ERROR;
+    return ret < 0 && ret != XY_LZMA_ERROR_DATA ? ret : XY_LZMA_ERROR_TRUNCATED;
+}
+
+uint32_t xy_lzma_dec_total_out(const xy_lzma_dec_t *dec)
+{
+    return dec != NULL ? dec->total_out : 0;
+}
@@ -0,0 +1,339 @@
+/**
+ * @file lzma_bench.c
+ * @brief Known-answer test and benchmark for the streaming LZMA decoder
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * Usage:
+ *   lzma_bench                          built-in vector (8 KB image, 4 KB window)
+ *   lzma_bench <file> [lzma|lzma2] [dict] [page] [frag]
+ *
+ * Reports decode throughput, the fixed RAM footprint (decoder context +
+ * window) and the number of flash erases / programs per image.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "lzma_decode_interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAX_WINDOW (1u << 20)
+
+/* ==================== Built-in Vector ==================== */
+
+/*
+ * 256 lines of "fota blk %03u flags %02x page %05u\n" (8448 bytes),
+ * compressed with lc=3 lp=0 pb=2 and a 4 KB dictionary (.lzma, end marker).
+ */
+static const uint8_t kat_lzma[] = {
+    0x5d, 0x00, 0x10, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x00, 0x33, 0x1b, 0xca, 0xee, 0x94, 0x07, 0x67, 0xa4, 0x0a, 0x62,
+    0xd6, 0x38, 0x4f, 0x74, 0x19, 0x0b, 0xde, 0xd8, 0x80, 0x84, 0xe6, 0x18,
+    0xb3, 0xff, 0x53, 0x3a, 0x91, 0x77, 0x65, 0x76, 0x6a, 0x96, 0xfa, 0x83,
+    0x8d, 0x95, 0x94, 0xb9, 0xb0, 0x49, 0xfa, 0xf7, 0xb2, 0x50, 0x50, 0xdb,
+    0x41, 0x09, 0xfa, 0x25, 0xc5, 0x0d, 0xef, 0x38, 0xd6, 0xf6, 0x64, 0x05,
+    0xdc, 0x6a, 0x81, 0xbc, 0x55, 0x04, 0xa1, 0xf8, 0x3e, 0x50, 0xd6, 0x24,
+    0xb7, 0x32, 0x39, 0x54, 0x78, 0xe7, 0x69, 0xea, 0x66, 0x2a, 0x4f, 0xc5,
+    0x0c, 0x7d, 0x94, 0x77, 0x75, 0x55, 0x63, 0xc8, 0x89, 0x1c, 0x86, 0x03,
+    0xf2, 0xf1, 0xaa, 0xd1, 0xc9, 0x7a, 0x06, 0x0d, 0x58, 0xe0, 0x52, 0x11,
+    0x58, 0x12, 0xbe, 0x60, 0x63, 0x9e, 0x7f, 0xef, 0x09, 0x3a, 0xc8, 0x5f,
+    0x10, 0xbf, 0x46, 0x08, 0xa0, 0xa6, 0x43, 0xe0, 0xd6, 0x95, 0x1a, 0x1f,
+    0x14, 0x2f, 0xcb, 0x95, 0xa3, 0x45, 0x53, 0x2a, 0xc6, 0x8f, 0x27, 0x72,
+    0xc9, 0x8b, 0xbd, 0x26, 0xb6, 0x04, 0x02, 0x7a, 0xf6, 0x33, 0x99, 0x4c,
+    0x79, 0x9f, 0x3b, 0x66, 0x41, 0xb9, 0xda, 0x4b, 0x48, 0x00, 0xa5, 0x1b,
+    0x33, 0xcc, 0x15, 0xb1, 0xc4, 0xee, 0x14, 0x64, 0xe3, 0x28, 0xa2, 0x35,
+    0xfa, 0x51, 0x0b, 0x32, 0xc1, 0x1f, 0xae, 0xbc, 0x97, 0x54, 0x73, 0x81,
+    0xbd, 0xb9, 0x5f, 0x85, 0x15, 0x2b, 0x47, 0xa1, 0x46, 0xb5, 0x6d, 0xd3,
+    0x63, 0x0c, 0x32, 0xbd, 0x6b, 0xa9, 0x2e, 0x91, 0x84, 0x33, 0x05, 0x9b,
+    0xeb, 0x6b, 0x1e, 0x15, 0x92, 0x6a, 0xb2, 0xc4, 0x50, 0xc7, 0x92, 0x21,
+    0x94, 0x5e, 0xb6, 0x7d, 0xf2, 0x49, 0x37, 0x63, 0xc4, 0x48, 0x2d, 0x1e,
+    0xe7, 0x46, 0x38, 0xb8, 0xf0, 0xec, 0x7a, 0x82, 0xe4, 0x8b, 0x18, 0x43,
+    0xec, 0xf8, 0xa2, 0xa1, 0x44, 0xf6, 0xdc, 0x4b, 0xa5, 0xae, 0x68, 0x02,
+    0x9e, 0x90, 0xcf, 0x1b, 0x57, 0x29, 0x32, 0x35, 0x82, 0x65, 0x5b, 0x75,
+    0x2e, 0x70, 0xa3, 0x18, 0x82, 0x76, 0x3e, 0x0a, 0xb7, 0x43, 0x88, 0xdb,
+    0x7b, 0xb5, 0x27, 0x19, 0x20, 0xe5, 0x5e, 0x1c, 0xf0, 0xa5, 0x36, 0x1a,
+    0x0d, 0x24, 0x8c, 0x8a, 0x21, 0x27, 0x3b, 0xc6, 0xd2, 0xd6, 0xcb, 0x5b,
+    0x51, 0x69, 0xf2, 0xf8, 0xe6, 0xbe, 0xa0, 0xa1, 0xcc, 0xd8, 0xdf, 0x97,
+    0xfc, 0xad, 0x10, 0x85, 0xbe, 0x4d, 0x07, 0xbf, 0xb6, 0xeb, 0xe2, 0x3a,
+    0x08, 0xe9, 0x03, 0x73, 0xba, 0xbe, 0x5e, 0x1c, 0xe4, 0x74, 0x72, 0x3c,
+    0x9f, 0xbf, 0xc1, 0x1b, 0xd2, 0xda, 0xff, 0x56, 0x3b, 0xc6, 0x57, 0x13,
+    0xd4, 0x29, 0x75, 0x12, 0x5a, 0xbf, 0xe9, 0xb9, 0x63, 0x5b, 0x7b, 0x0f,
+    0xdc, 0x25, 0x32, 0x79, 0x7a, 0xd0, 0x87, 0x9e, 0xa8, 0xbf, 0xd7, 0x1b,
+    0xe7, 0x69, 0xf0, 0x74, 0x7c, 0x78, 0x65, 0xf8, 0xff, 0x26, 0x21, 0x53,
+    0xb6, 0xfa, 0x90, 0x2f, 0x6f, 0x1f, 0x5d, 0xbc, 0x0e, 0x9e, 0x52, 0x4e,
+    0x47, 0x80, 0x17, 0x0b, 0x40, 0x28, 0x69, 0x30, 0x56, 0xfa, 0x12, 0xf9,
+    0x01, 0x66, 0x3b, 0x33, 0xb7, 0xe1, 0xdb, 0xe6, 0x5b, 0x3b, 0x15, 0x15,
+    0xd5, 0x50, 0x9d, 0x26, 0xef, 0x57, 0xbb, 0x15, 0xa8, 0x49, 0x4b, 0x85,
+    0xf2, 0xa4, 0xce, 0x8a, 0x65, 0x94, 0xb6, 0x7c, 0x6c, 0x43, 0x8f, 0x51,
+    0xf8, 0x73, 0xae, 0x7d, 0xa1, 0x5e, 0xea, 0x0b, 0x11, 0xb1, 0x17, 0xc3,
+    0x01, 0x26, 0x47, 0x62, 0xc0, 0x57, 0x32, 0x37, 0x42, 0x4e, 0xc1, 0x23,
+    0xdd, 0x49, 0x01, 0xf4, 0x46, 0xcc, 0xe0, 0x4f, 0x8f, 0xa4, 0x33, 0xb8,
+    0xf0, 0x44, 0xe0, 0x1d, 0x2a, 0x36, 0xf5, 0x0a, 0x4e, 0x3a, 0x06, 0x63,
+    0x82, 0x2f, 0x49, 0xe9, 0x00, 0x2b, 0x37, 0xa1, 0x26, 0xcb, 0x89, 0xac,
+    0x57, 0xce, 0xe0, 0xa5, 0x86, 0xb2, 0x7a, 0xeb, 0x2b, 0x7c, 0xce, 0x43,
+    0xed, 0x03, 0x1e, 0xff, 0xb8, 0x2d, 0xa5, 0x4d, 0x76, 0x37, 0x35, 0x64,
+    0x3f, 0xd3, 0xc0, 0x6a, 0x88, 0xca, 0x87, 0x13, 0xd3, 0xe7, 0x06, 0x29,
+    0x4a, 0xe5, 0x87, 0x4d, 0x6f, 0x92, 0x92, 0x26, 0x51, 0x90, 0x9c, 0xaf,
+    0xe2, 0x13, 0xe1, 0xe0, 0x7e, 0x54, 0x76, 0x79, 0xba, 0xae, 0x9b, 0x12,
+    0x43, 0xf9, 0xf9, 0xce, 0x4f, 0xc2, 0x8f, 0x96, 0xd9, 0xf4, 0xa6, 0x96,
+    0x35, 0xd8, 0xa0, 0x68, 0x09, 0x09, 0xf2, 0x1d, 0xa1, 0x77, 0xcc, 0x97,
+    0x8d, 0x62, 0x4e, 0x28, 0x76, 0x02, 0x6c, 0x7f, 0x16, 0x77, 0xb8, 0x47,
+    0x2f, 0x4f, 0xe2, 0x02, 0xe5, 0x0d, 0x31, 0xa5, 0x2f, 0xae, 0xe0, 0x8d,
+    0x2e, 0x03, 0xb8, 0x58, 0xa2, 0xb3, 0x0e, 0x64, 0x6c, 0xda, 0x35, 0xd8,
+    0x5c, 0x03, 0x0e, 0xda, 0x7c, 0xda, 0xa2, 0xb5, 0x59, 0xc6, 0xf0, 0x1f,
+    0x62, 0x78, 0xeb, 0x01, 0x6b, 0x3a, 0xd8, 0x51, 0x5b, 0x10, 0x19, 0xca,
+    0xbb, 0xb6, 0x09, 0xf5, 0x03, 0x1e, 0x1a, 0x45, 0xab, 0x6c, 0xf7, 0x9a,
+    0x8e, 0xb6, 0x9c, 0x0e, 0x9d, 0xe1, 0xa4, 0x33, 0x53, 0xca, 0x09, 0x8f,
+    0xec, 0x70, 0x62, 0xab, 0x2b, 0x50, 0xc9, 0x43, 0x0d, 0x4c, 0x1b, 0x6c,
+    0xf8, 0xf8, 0xca, 0xa2, 0x43, 0xef, 0x78, 0xfc, 0x48, 0xb3, 0x14, 0xc2,
+    0x02, 0xa6, 0x5e, 0xaf, 0x7a, 0x09, 0x3b, 0xdf, 0xb3, 0xbc, 0x70, 0x9c,
+    0x59, 0x93, 0xba, 0x4b, 0xaf, 0x06, 0xe2, 0x49, 0xa2, 0x22, 0xb9, 0x66,
+    0x6c, 0x73, 0xbe, 0x69, 0x55, 0x85, 0xf7, 0xd5, 0x1a, 0xf1, 0x5e, 0x12,
+    0x55, 0x9f, 0x73, 0xe1, 0xea, 0x5b, 0x58, 0xfc, 0xc1, 0x94, 0x25, 0x9c,
+    0xdf, 0xf2, 0x7d, 0x73, 0x09, 0x56, 0x75, 0xb4, 0x12, 0x97, 0xc3, 0x01,
+    0xe3, 0xfe, 0xd1, 0x12, 0xe2, 0x58, 0xb1, 0xa2, 0x42, 0x8d, 0x4f, 0x3a,
+    0x56, 0x2d, 0xb5, 0x6c, 0xc9, 0x85, 0x94, 0x7e, 0x2a, 0xc7, 0x12, 0xc5,
+    0x97, 0x22, 0x5a, 0x04, 0x1c, 0xbb, 0x1a, 0x8b, 0x00, 0xc2, 0x62, 0xe6,
+    0x56, 0x48, 0x7f, 0x58, 0x63, 0xca, 0xc4, 0xdd, 0xd0, 0xef, 0x1d, 0x92,
+    0x0c, 0x46, 0xcd, 0x8e, 0x03, 0x59, 0x25, 0xa1, 0x13, 0xa2, 0x65, 0xd5,
+    0x59, 0xe4, 0x8b, 0x45, 0xbe, 0xc8, 0x74, 0x2f, 0xb1, 0x75, 0x19, 0xf0,
+    0x7f, 0x14, 0x83, 0xf8, 0x2c, 0x37, 0x8b, 0x0b, 0xb9, 0xc4, 0x37, 0x1e,
+    0x86, 0xe9, 0x86, 0xc0, 0x37, 0xf3, 0xc7, 0xb7, 0x3e, 0x8c, 0x0e, 0x8c,
+    0x15, 0xeb, 0xf4, 0xc9, 0xea, 0xb4, 0x5c, 0xd7, 0x0f, 0xd4, 0x73, 0x4d,
+    0x0f, 0x4a, 0x65, 0xff, 0xc9, 0x4b, 0x91, 0x8c, 0x11, 0x14, 0x0a, 0x65,
+    0x5a, 0xec, 0xfb, 0xf5, 0xa2, 0x79, 0x95, 0x85, 0x01, 0x63, 0x79, 0xea,
+    0x2e, 0x1c, 0x98, 0x05, 0xe4, 0x8e, 0x10, 0x12, 0xe0, 0xb0, 0x00, 0x6e,
+    0x93, 0xbb, 0xa3, 0x2e, 0xa4, 0x7e, 0x88, 0x2b, 0x51, 0x38, 0x67, 0xfc,
+    0xef, 0x4c, 0x3b, 0x12, 0x0c, 0xc0, 0x15, 0x39, 0xe1, 0x93, 0x5a, 0xd6,
+    0xdc, 0x2e, 0x83, 0x08, 0xca, 0xf9, 0xd5, 0x3f, 0x98, 0x18, 0xcd, 0xfd,
+    0xa9, 0xc8, 0xd1, 0xe3, 0xd2, 0xe2, 0xff, 0xe9, 0x73, 0x71, 0x86, 0x7e,
+    0x1f, 0x50, 0xda, 0xd9, 0xcd, 0xa4, 0xaa, 0x49, 0x8e, 0x8e, 0x70, 0x48,
+    0x3e, 0xea, 0x0a, 0x48, 0x65, 0x02, 0x37, 0xbf, 0xe2, 0x3b, 0x83, 0xb5,
+    0x3f, 0xb1, 0x74, 0x19, 0x62, 0x4c, 0xb0, 0x57, 0xc7, 0x2a, 0xbb, 0xa1,
+    0xd9, 0x3f, 0x46, 0xed, 0x1f, 0x97, 0x1f, 0x7d, 0x4a, 0xff, 0xee, 0x67,
+    0x65, 0x92, 0x69, 0x6a, 0xa3, 0xb3, 0x6a, 0xcb, 0x41, 0xbb, 0x5f, 0xe2,
+    0x67, 0x3e, 0xbf, 0x64, 0xae, 0xe1, 0x5c, 0x38, 0xe9, 0x7b, 0x2d, 0xfd,
+    0x24, 0xac, 0xed, 0x17, 0xb0, 0xa2, 0x56, 0xe6, 0x81, 0x9d, 0x6f, 0x42,
+    0x64, 0x9a, 0xb6, 0x5a, 0xcc, 0xd5, 0xab, 0x2d, 0x26, 0x42, 0x63, 0xbf,
+    0x57, 0xc2, 0xea, 0xe9, 0xe9, 0x25, 0x92, 0x61, 0x40, 0x4f, 0x95, 0x3c,
+    0xb5, 0x47, 0xea, 0xc5, 0xcd, 0x10, 0xaa, 0xb7, 0x01, 0xc2, 0x4e, 0x4d,
+    0x0f, 0x45, 0x6a, 0x50, 0xd6, 0x1b, 0x9c, 0x7b, 0x2e, 0xfa, 0x8d, 0xa2,
+    0x1f, 0x0b, 0x8d, 0x5d, 0x08, 0xbf, 0xd9, 0xf7, 0xa3, 0xa8, 0xbc, 0xca,
+    0x89, 0xdb, 0x0c, 0xe1, 0x21, 0x46, 0xc7, 0x25, 0xa5, 0xa7, 0x02, 0x3a,
+    0x39, 0xf1, 0x56, 0x08, 0xcd, 0x2e, 0xf1, 0x10, 0x4a, 0x0e, 0x0b, 0x95,
+    0xb6, 0xec, 0x7d, 0xf8, 0x11, 0x87, 0xab, 0xbc, 0xfb, 0xf4, 0xe5, 0x9d,
+    0x6e, 0x5f, 0x09, 0xb7, 0xd0, 0xbb, 0x42, 0xd4, 0xcd, 0x00, 0xac, 0x77,
+    0x43, 0x16, 0x53, 0xff, 0xff, 0xf0, 0xfd, 0x59, 0xe0,
+};
+
+static uint32_t kat_expected(uint8_t *out)
+{
+    uint32_t n = 0;
+    unsigned i;
+
+    for (i = 0; i < 256; i++) {
+        n += (uint32_t)sprintf((char *)out + n, "fota blk %03u flags %02x page %05u\n",
+                               i, (i * 37u) & 0xffu, (i * i) % 65536u);
+    }
+    return n;
+}
+
+/* ==================== Flash Model ==================== */
+
+typedef struct {
+    uint8_t *mem;
+    uint32_t size;
+    uint32_t erases;
+    uint32_t programs;
+} bench_flash_t;
+
+static int bench_erase(void *ctx, uint32_t addr)
+{
+    bench_flash_t *f = (bench_flash_t *)ctx;
+
+    if (addr + 4096u > f->size) {
+        return -1;
+    }
+    memset(f->mem + addr, 0xFF, 4096u);
+    f->erases++;
+    return 0;
+}
+
+static int bench_program(void *ctx, uint32_t addr, const uint8_t *data,
+                         uint32_t len)
+{
+    bench_flash_t *f = (bench_flash_t *)ctx;
+
+    if (addr + len > f->size) {
+        return -1;
+    }
+    memcpy(f->mem + addr, data, len);
+    f->programs++;
+    return 0;
+}
+
+/* ==================== Helpers ==================== */
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static xy_lzma_fota_t fota;
+static uint8_t window[BENCH_MAX_WINDOW];
+
+static int decode_once(const uint8_t *in, size_t in_len,
+                       xy_lzma_format_t format, uint32_t dict_size,
+                       uint32_t page_size, size_t frag, bench_flash_t *flash,
+                       uint32_t *out_len)
+{
+    xy_lzma_flash_ops_t ops;
+    size_t pos = 0;
+    size_t n;
+    int ret;
+
+    ops.erase = bench_erase;
+    ops.program = bench_program;
+    ops.ctx = flash;
+    ops.sector_size = 4096;
+    ops.page_size = page_size;
+
+    ret = xy_lzma_fota_begin(&fota, format, &ops, 0, flash->size, window,
+                             dict_size);
+    while (ret == XY_LZMA_OK && pos < in_len) {
+        n = in_len - pos < frag ? in_len - pos : frag;
+        ret = xy_lzma_fota_write(&fota, in + pos, n);
+        pos += n;
+    }
+    if (ret >= 0) {
+        ret = xy_lzma_fota_end(&fota, out_len);
+    }
+    return ret;
+}
+
+static int run(const char *name, const uint8_t *in, size_t in_len,
+               xy_lzma_format_t format, uint32_t dict_size,
+               uint32_t page_size, size_t frag, const uint8_t *expected,
+               uint32_t expected_len)
+{
+    bench_flash_t flash;
+    uint32_t out_len = 0;
+    uint32_t iters;
+    uint32_t i;
+    double t0, dt;
+    int ret;
+
+    flash.size = 64u << 20;
+    flash.mem = (uint8_t *)malloc(flash.size);
+    flash.erases = 0;
+    flash.programs = 0;
+    if (flash.mem == NULL) {
+        return -1;
+    }
+
+    ret = decode_once(in, in_len, format, dict_size, page_size, frag, &flash,
+                      &out_len);
+    if (ret != XY_LZMA_STREAM_END) {
+        printf("%s: decode failed (%d)\n", name, ret);
+        free(flash.mem);
+        return -1;
+    }
+    if (expected != NULL
+        && (out_len != expected_len
+            || memcmp(flash.mem, expected, expected_len) != 0)) {
+        printf("%s: output mismatch\n", name);
+        free(flash.mem);
+        return -1;
+    }
+
+    iters = (uint32_t)(64u * 1024 * 1024 / (out_len + 1)) + 1;
+    t0 = now_sec();
+    for (i = 0; i < iters; i++) {
+        decode_once(in, in_len, format, dict_size, page_size, frag, &flash,
+                    &out_len);
+    }
+    dt = now_sec() - t0;
+
+    printf("%s: %u -> %u bytes, window %u, page %u, frag %u\n", name,
+           (unsigned)in_len, (unsigned)out_len, (unsigned)dict_size,
+           (unsigned)page_size, (unsigned)frag);
+    printf("  decode      %8.2f MB/s out, %8.2f MB/s in\n",
+           (double)out_len * iters / dt / 1e6,
+           (double)in_len * iters / dt / 1e6);
+    printf("  ram         %8u B context + %u B window\n",
+           (unsigned)sizeof(xy_lzma_dec_t), (unsigned)dict_size);
+    printf("  flash       %8u erases, %u programs per image\n",
+           (unsigned)(flash.erases / (iters + 1)),
+           (unsigned)(flash.programs / (iters + 1)));
+
+    free(flash.mem);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t expected[16384];
+    xy_lzma_format_t format = XY_LZMA_FORMAT_ALONE;
+    uint32_t dict_size = 16384;
+    uint32_t page_size = 256;
+    size_t frag = 512;
+    uint8_t *in;
+    long in_len;
+    FILE *fp;
+    uint32_t n;
+    int ret;
+
+    if (argc < 2) {
+        n = kat_expected(expected);
+        ret = run("kat", kat_lzma, sizeof(kat_lzma), XY_LZMA_FORMAT_ALONE,
+                  4096, 256, 1, expected, n);
+        ret |= run("kat", kat_lzma, sizeof(kat_lzma), XY_LZMA_FORMAT_ALONE,
+                   4096, 4096, 1500, expected, n);
+        printf("%s\n", ret == 0 ? "PASS" : "FAIL");
+        return ret == 0 ? 0 : 1;
+    }
+
+    if (argc > 2 && strcmp(argv[2], "lzma2") == 0) {
+        format = XY_LZMA_FORMAT_LZMA2;
+    }
+    if (argc > 3) {
+        dict_size = (uint32_t)strtoul(argv[3], NULL, 0);
+    }
+    if (argc > 4) {
+        page_size = (uint32_t)strtoul(argv[4], NULL, 0);
+    }
+    if (argc > 5) {
+        frag = (size_t)strtoul(argv[5], NULL, 0);
+    }
+    if (dict_size > BENCH_MAX_WINDOW || frag == 0) {
+        printf("bad window or fragment size\n");
+        return 1;
+    }
+
+    fp = fopen(argv[1], "rb");
+    if (fp == NULL) {
+        printf("cannot open %s\n", argv[1]);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    in_len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    in = (uint8_t *)malloc((size_t)in_len);
+    if (in == NULL || fread(in, 1, (size_t)in_len, fp) != (size_t)in_len) {
+        fclose(fp);
+        free(in);
+        return 1;
+    }
+    fclose(fp);
+
+    ret = run(argv[1], in, (size_t)in_len, format, dict_size, page_size, frag,
+              NULL, 0);
+    free(in);
+    return ret == 0 ? 0 : 1;
+}
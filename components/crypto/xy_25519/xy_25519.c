@@ -19,9 +19,9 @@ extern int xy_sha512_hash(const uint8_t *data, size_t len, uint8_t digest[64]);
 /* ==================== Shared Field Arithmetic (mod 2^255-19) ==================== */
 
 /**
- * @brief Field element type (10 limbs, 25.5 bits each)
+ * @brief Field element type (10 signed limbs of 26 and 25 bits alternately)
  */
-typedef uint32_t fe25519[10];
+typedef int32_t fe25519[10];
 
 /**
  * @brief Prime field modulus: 2^255 - 19
@@ -84,83 +84,115 @@ static const fe25519 ed25519_sqrtm1 = {
 
 /* ==================== Field Arithmetic Primitives ==================== */
 
-static uint32_t load32_le(const uint8_t *src)
+static int64_t load_3(const uint8_t *src)
 {
-    return ((uint32_t)src[0])
-           | ((uint32_t)src[1] << 8)
-           | ((uint32_t)src[2] << 16)
-           | ((uint32_t)src[3] << 24);
+    return (int64_t)src[0]
+           | ((int64_t)src[1] << 8)
+           | ((int64_t)src[2] << 16);
 }
 
-static void store32_le(uint8_t *dst, uint32_t value)
+static int64_t load_4(const uint8_t *src)
 {
-    dst[0] = (uint8_t)(value & 0xff);
-    dst[1] = (uint8_t)((value >> 8) & 0xff);
-    dst[2] = (uint8_t)((value >> 16) & 0xff);
-    dst[3] = (uint8_t)((value >> 24) & 0xff);
+    return load_3(src) | ((int64_t)src[3] << 24);
 }
 
+/* Bit 255 is ignored, as RFC 7748 requires for u-coordinates */
 static void fe_frombytes(fe25519 h, const uint8_t *s)
 {
-    uint64_t h0 = load32_le(s);
-    uint64_t h1 = load32_le(s + 4);
-    uint64_t h2 = load32_le(s + 8);
-    uint64_t h3 = load32_le(s + 12);
-    uint64_t h4 = load32_le(s + 16);
-    uint64_t h5 = load32_le(s + 20);
-    uint64_t h6 = load32_le(s + 24);
-    uint64_t h7 = load32_le(s + 28);
-
-    h[0] = (uint32_t)(h0 & 0x3ffffff);
-    h[1] = (uint32_t)((h0 >> 26) | ((h1 & 0x1fff) << 6));
-    h[2] = (uint32_t)((h1 >> 13) | ((h2 & 0xff) << 19));
-    h[3] = (uint32_t)((h2 >> 8) | ((h3 & 0x1f) << 24));
-    h[4] = (uint32_t)((h3 >> 5) & 0x3ffffff);
-    h[5] = (uint32_t)((h3 >> 31) | ((h4 & 0x3ffff) << 1));
-    h[6] = (uint32_t)((h4 >> 18) | ((h5 & 0x1fff) << 14));
-    h[7] = (uint32_t)((h5 >> 13) | ((h6 & 0xff) << 19));
-    h[8] = (uint32_t)((h6 >> 8) | ((h7 & 0x1f) << 24));
-    h[9] = (uint32_t)((h7 >> 5) & 0x1ffffff);
-}
-
+    int64_t h0 = load_4(s);
+    int64_t h1 = load_3(s + 4) << 6;
+    int64_t h2 = load_3(s + 7) << 5;
+    int64_t h3 = load_3(s + 10) << 3;
+    int64_t h4 = load_3(s + 13) << 2;
+    int64_t h5 = load_4(s + 16);
+    int64_t h6 = load_3(s + 20) << 7;
+    int64_t h7 = load_3(s + 23) << 5;
+    int64_t h8 = load_3(s + 26) << 4;
+    int64_t h9 = (load_3(s + 29) & 0x7fffff) << 2;
+    int64_t c;
+
+    c = (h9 + (1 << 24)) >> 25; h0 += c * 19; h9 -= c * (1 << 25);
+    c = (h1 + (1 << 24)) >> 25; h2 += c; h1 -= c * (1 << 25);
+    c = (h3 + (1 << 24)) >> 25; h4 += c; h3 -= c * (1 << 25);
+    c = (h5 + (1 << 24)) >> 25; h6 += c; h5 -= c * (1 << 25);
+    c = (h7 + (1 << 24)) >> 25; h8 += c; h7 -= c * (1 << 25);
+    c = (h0 + (1 << 25)) >> 26; h1 += c; h0 -= c * (1 << 26);
+    c = (h2 + (1 << 25)) >> 26; h3 += c; h2 -= c * (1 << 26);
+    c = (h4 + (1 << 25)) >> 26; h5 += c; h4 -= c * (1 << 26);
+    c = (h6 + (1 << 25)) >> 26; h7 += c; h6 -= c * (1 << 26);
+    c = (h8 + (1 << 25)) >> 26; h9 += c; h8 -= c * (1 << 26);
+
+    h[0] = (int32_t)h0; h[1] = (int32_t)h1; h[2] = (int32_t)h2;
+    h[3] = (int32_t)h3; h[4] = (int32_t)h4; h[5] = (int32_t)h5;
+    h[6] = (int32_t)h6; h[7] = (int32_t)h7; h[8] = (int32_t)h8;
+    h[9] = (int32_t)h9;
+}
+
+/* Fully reduced modulo 2^255-19, little-endian */
 static void fe_tobytes(uint8_t *s, const fe25519 h)
 {
-    uint32_t t[10];
-    uint32_t carry;
-    int i;
-
-    for (i = 0; i < 10; i++) {
-        t[i] = h[i];
-    }
-
-    carry = (t[9] >> 25);
-    t[9] &= 0x1ffffff;
-    carry *= 19;
-    t[0] += carry;
-
-    for (i = 0; i < 9; i++) {
-        carry = t[i] >> 26;
-        t[i] &= 0x3ffffff;
-        t[i + 1] += carry;
-    }
-
-    carry = t[9] >> 25;
-    t[9] &= 0x1ffffff;
-    carry *= 19;
-    t[0] += carry;
-
-    carry = t[0] >> 26;
-    t[0] &= 0x3ffffff;
-    t[1] += carry;
-
-    store32_le(s, t[0] | (t[1] << 26));
-    store32_le(s + 4, (t[1] >> 6) | (t[2] << 19));
-    store32_le(s + 8, (t[2] >> 13) | (t[3] << 13));
-    store32_le(s + 12, (t[3] >> 19) | (t[4] << 6));
-    store32_le(s + 16, t[5] | (t[6] << 25));
-    store32_le(s + 20, (t[6] >> 7) | (t[7] << 19));
-    store32_le(s + 24, (t[7] >> 13) | (t[8] << 12));
-    store32_le(s + 28, (t[8] >> 20) | (t[9] << 6));
+    int32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+    int32_t h5 = h[5], h6 = h[6], h7 = h[7], h8 = h[8], h9 = h[9];
+    int32_t q, c;
+
+    /* q = 1 if h >= p, else 0 */
+    q = (19 * h9 + (1 << 24)) >> 25;
+    q = (h0 + q) >> 26;
+    q = (h1 + q) >> 25;
+    q = (h2 + q) >> 26;
+    q = (h3 + q) >> 25;
+    q = (h4 + q) >> 26;
+    q = (h5 + q) >> 25;
+    q = (h6 + q) >> 26;
+    q = (h7 + q) >> 25;
+    q = (h8 + q) >> 26;
+    q = (h9 + q) >> 25;
+
+    /* h - q * p, computed as h + 19 * q - q * 2^255 */
+    h0 += 19 * q;
+    c = h0 >> 26; h1 += c; h0 -= c * (1 << 26);
+    c = h1 >> 25; h2 += c; h1 -= c * (1 << 25);
+    c = h2 >> 26; h3 += c; h2 -= c * (1 << 26);
+    c = h3 >> 25; h4 += c; h3 -= c * (1 << 25);
+    c = h4 >> 26; h5 += c; h4 -= c * (1 << 26);
+    c = h5 >> 25; h6 += c; h5 -= c * (1 << 25);
+    c = h6 >> 26; h7 += c; h6 -= c * (1 << 26);
+    c = h7 >> 25; h8 += c; h7 -= c * (1 << 25);
+    c = h8 >> 26; h9 += c; h8 -= c * (1 << 26);
+    c = h9 >> 25;              h9 -= c * (1 << 25);
+
+    s[0] = (uint8_t)h0;
+    s[1] = (uint8_t)(h0 >> 8);
+    s[2] = (uint8_t)(h0 >> 16);
+    s[3] = (uint8_t)((h0 >> 24) | (h1 * (1 << 2)));
+    s[4] = (uint8_t)(h1 >> 6);
+    s[5] = (uint8_t)(h1 >> 14);
+    s[6] = (uint8_t)((h1 >> 22) | (h2 * (1 << 3)));
+    s[7] = (uint8_t)(h2 >> 5);
+    s[8] = (uint8_t)(h2 >> 13);
+    s[9] = (uint8_t)((h2 >> 21) | (h3 * (1 << 5)));
+    s[10] = (uint8_t)(h3 >> 3);
+    s[11] = (uint8_t)(h3 >> 11);
+    s[12] = (uint8_t)((h3 >> 19) | (h4 * (1 << 6)));
+    s[13] = (uint8_t)(h4 >> 2);
+    s[14] = (uint8_t)(h4 >> 10);
+    s[15] = (uint8_t)(h4 >> 18);
+    s[16] = (uint8_t)h5;
+    s[17] = (uint8_t)(h5 >> 8);
+    s[18] = (uint8_t)(h5 >> 16);
+    s[19] = (uint8_t)((h5 >> 24) | (h6 * (1 << 1)));
+    s[20] = (uint8_t)(h6 >> 7);
+    s[21] = (uint8_t)(h6 >> 15);
+    s[22] = (uint8_t)((h6 >> 23) | (h7 * (1 << 3)));
+    s[23] = (uint8_t)(h7 >> 5);
+    s[24] = (uint8_t)(h7 >> 13);
+    s[25] = (uint8_t)((h7 >> 21) | (h8 * (1 << 4)));
+    s[26] = (uint8_t)(h8 >> 4);
+    s[27] = (uint8_t)(h8 >> 12);
+    s[28] = (uint8_t)((h8 >> 20) | (h9 * (1 << 6)));
+    s[29] = (uint8_t)(h9 >> 2);
+    s[30] = (uint8_t)(h9 >> 10);
+    s[31] = (uint8_t)(h9 >> 18);
 }
 
 static void fe_copy(fe25519 h, const fe25519 f)
@@ -192,16 +224,10 @@ static void fe_add(fe25519 h, const fe25519 f, const fe25519 g)
 
 static void fe_sub(fe25519 h, const fe25519 f, const fe25519 g)
 {
-    h[0] = f[0] + 0x7ffffda - g[0];
-    h[1] = f[1] + 0x3fffffe - g[1];
-    h[2] = f[2] + 0x7fffffe - g[2];
-    h[3] = f[3] + 0x3fffffe - g[3];
-    h[4] = f[4] + 0x7fffffe - g[4];
-    h[5] = f[5] + 0x3fffffe - g[5];
-    h[6] = f[6] + 0x7fffffe - g[6];
-    h[7] = f[7] + 0x3fffffe - g[7];
-    h[8] = f[8] + 0x7fffffe - g[8];
-    h[9] = f[9] + 0x1fffffe - g[9];
+    int i;
+    for (i = 0; i < 10; i++) {
+        h[i] = f[i] - g[i];
+    }
 }
 
 static void fe_mul(fe25519 h, const fe25519 f, const fe25519 g)
@@ -239,23 +265,23 @@ static void fe_mul(fe25519 h, const fe25519 f, const fe25519 g)
     h9 = f0*g9 + f1*g8 + f2*g7 + f3*g6 + f4*g5 + f5*g4
        + f6*g3 + f7*g2 + f8*g1 + f9*g0;
 
-    c0 = (h0 + (1<<25)) >> 26; h1 += c0; h0 -= c0 << 26;
-    c4 = (h4 + (1<<25)) >> 26; h5 += c4; h4 -= c4 << 26;
-    c1 = (h1 + (1<<24)) >> 25; h2 += c1; h1 -= c1 << 25;
-    c5 = (h5 + (1<<24)) >> 25; h6 += c5; h5 -= c5 << 25;
-    c2 = (h2 + (1<<25)) >> 26; h3 += c2; h2 -= c2 << 26;
-    c6 = (h6 + (1<<25)) >> 26; h7 += c6; h6 -= c6 << 26;
-    c3 = (h3 + (1<<24)) >> 25; h4 += c3; h3 -= c3 << 25;
-    c7 = (h7 + (1<<24)) >> 25; h8 += c7; h7 -= c7 << 25;
-    c4 = (h4 + (1<<25)) >> 26; h5 += c4; h4 -= c4 << 26;
-    c8 = (h8 + (1<<25)) >> 26; h9 += c8; h8 -= c8 << 26;
-    c9 = (h9 + (1<<24)) >> 25; h0 += c9 * 19; h9 -= c9 << 25;
-    c0 = (h0 + (1<<25)) >> 26; h1 += c0; h0 -= c0 << 26;
-
-    h[0] = (uint32_t)h0; h[1] = (uint32_t)h1; h[2] = (uint32_t)h2;
-    h[3] = (uint32_t)h3; h[4] = (uint32_t)h4; h[5] = (uint32_t)h5;
-    h[6] = (uint32_t)h6; h[7] = (uint32_t)h7; h[8] = (uint32_t)h8;
-    h[9] = (uint32_t)h9;
+    c0 = (h0 + (1<<25)) >> 26; h1 += c0; h0 -= c0 * (1 << 26);
+    c4 = (h4 + (1<<25)) >> 26; h5 += c4; h4 -= c4 * (1 << 26);
+    c1 = (h1 + (1<<24)) >> 25; h2 += c1; h1 -= c1 * (1 << 25);
+    c5 = (h5 + (1<<24)) >> 25; h6 += c5; h5 -= c5 * (1 << 25);
+    c2 = (h2 + (1<<25)) >> 26; h3 += c2; h2 -= c2 * (1 << 26);
+    c6 = (h6 + (1<<25)) >> 26; h7 += c6; h6 -= c6 * (1 << 26);
+    c3 = (h3 + (1<<24)) >> 25; h4 += c3; h3 -= c3 * (1 << 25);
+    c7 = (h7 + (1<<24)) >> 25; h8 += c7; h7 -= c7 * (1 << 25);
+    c4 = (h4 + (1<<25)) >> 26; h5 += c4; h4 -= c4 * (1 << 26);
+    c8 = (h8 + (1<<25)) >> 26; h9 += c8; h8 -= c8 * (1 << 26);
+    c9 = (h9 + (1<<24)) >> 25; h0 += c9 * 19; h9 -= c9 * (1 << 25);
+    c0 = (h0 + (1<<25)) >> 26; h1 += c0; h0 -= c0 * (1 << 26);
+
+    h[0] = (int32_t)h0; h[1] = (int32_t)h1; h[2] = (int32_t)h2;
+    h[3] = (int32_t)h3; h[4] = (int32_t)h4; h[5] = (int32_t)h5;
+    h[6] = (int32_t)h6; h[7] = (int32_t)h7; h[8] = (int32_t)h8;
+    h[9] = (int32_t)h9;
 }
 
 static void fe_sq(fe25519 h, const fe25519 f)
@@ -302,8 +328,8 @@ static void fe_invert(fe25519 out, const fe25519 z)
 
 static void fe_cswap(fe25519 a, fe25519 b, uint32_t swap)
 {
-    uint32_t mask = (uint32_t)(-(int32_t)swap);
-    uint32_t temp;
+    int32_t mask = -(int32_t)swap;
+    int32_t temp;
     int i;
     for (i = 0; i < 10; i++) {
         temp = mask & (a[i] ^ b[i]);
@@ -314,8 +340,8 @@ static void fe_cswap(fe25519 a, fe25519 b, uint32_t swap)
 
 static void fe_cmov(fe25519 f, const fe25519 g, uint32_t b)
 {
-    uint32_t mask = (uint32_t)(-(int32_t)b);
-    uint32_t x;
+    int32_t mask = -(int32_t)b;
+    int32_t x;
     int i;
     for (i = 0; i < 10; i++) {
         x = f[i] ^ g[i];
@@ -190,106 +190,79 @@ int xy_chacha20_crypt(xy_chacha20_ctx_t *ctx,
 /* ==================== Poly1305 Implementation ==================== */
 
 /**
- * @brief Poly1305 modular multiplication
+ * @brief Process one 16-byte Poly1305 block
  *
- * Multiplies accumulator h by r, modulo 2^130-5.
+ * Adds the block to accumulator h and multiplies h by r, modulo 2^130-5.
  *
  * @param ctx Poly1305 context
+ * @param block 16-byte input block
+ * @param hibit 1 << 24 for a full block (2^128), 0 for the padded final one
  */
-static void prv_poly1305_multiply(xy_poly1305_ctx_t *ctx)
+static void prv_poly1305_block(xy_poly1305_ctx_t *ctx, const uint8_t block[16],
+                               uint32_t hibit)
 {
-    uint64_t d0, d1, d2, d3, d4;
+    uint32_t r0, r1, r2, r3, r4;
+    uint32_t s1, s2, s3, s4;
     uint32_t h0, h1, h2, h3, h4;
-    uint64_t c;
-
-    h0 = ctx->h[0];
-    h1 = ctx->h[1];
-    h2 = ctx->h[2];
-    h3 = ctx->h[3];
-    h4 = ctx->h[4];
+    uint64_t d0, d1, d2, d3, d4;
+    uint32_t c;
+
+    r0 = ctx->r[0];
+    r1 = ctx->r[1];
+    r2 = ctx->r[2];
+    r3 = ctx->r[3];
+    r4 = ctx->r[4];
+
+    /* 2^130 = 5 modulo p: limbs that overflow wrap around times 5 */
+    s1 = r1 * 5;
+    s2 = r2 * 5;
+    s3 = r3 * 5;
+    s4 = r4 * 5;
+
+    /* Add block in little-endian to accumulator */
+    h0 = ctx->h[0] + (prv_load32_le(&block[0]) & 0x3ffffff);
+    h1 = ctx->h[1] + ((prv_load32_le(&block[3]) >> 2) & 0x3ffffff);
+    h2 = ctx->h[2] + ((prv_load32_le(&block[6]) >> 4) & 0x3ffffff);
+    h3 = ctx->h[3] + ((prv_load32_le(&block[9]) >> 6) & 0x3ffffff);
+    h4 = ctx->h[4] + ((prv_load32_le(&block[12]) >> 8) | hibit);
 
     /* h * r */
-    d0 = ((uint64_t)h0 * ctx->r[0])
-        + ((uint64_t)h1 * ctx->r[4])
-        + ((uint64_t)h2 * ctx->r[3])
-        + ((uint64_t)h3 * ctx->r[2])
-        + ((uint64_t)h4 * ctx->r[1]);
-
-    d1 = ((uint64_t)h0 * ctx->r[1])
-        + ((uint64_t)h1 * ctx->r[0])
-        + ((uint64_t)h2 * ctx->r[4])
-        + ((uint64_t)h3 * ctx->r[3])
-        + ((uint64_t)h4 * ctx->r[2]);
-
-    d2 = ((uint64_t)h0 * ctx->r[2])
-        + ((uint64_t)h1 * ctx->r[1])
-        + ((uint64_t)h2 * ctx->r[0])
-        + ((uint64_t)h3 * ctx->r[4])
-        + ((uint64_t)h4 * ctx->r[3]);
-
-    d3 = ((uint64_t)h0 * ctx->r[3])
-        + ((uint64_t)h1 * ctx->r[2])
-        + ((uint64_t)h2 * ctx->r[1])
-        + ((uint64_t)h3 * ctx->r[0])
-        + ((uint64_t)h4 * ctx->r[4]);
-
-    d4 = ((uint64_t)h0 * ctx->r[4])
-        + ((uint64_t)h1 * ctx->r[3])
-        + ((uint64_t)h2 * ctx->r[2])
-        + ((uint64_t)h3 * ctx->r[1])
-        + ((uint64_t)h4 * ctx->r[0]);
+    d0 = ((uint64_t)h0 * r0) + ((uint64_t)h1 * s4) + ((uint64_t)h2 * s3)
+         + ((uint64_t)h3 * s2) + ((uint64_t)h4 * s1);
+    d1 = ((uint64_t)h0 * r1) + ((uint64_t)h1 * r0) + ((uint64_t)h2 * s4)
+         + ((uint64_t)h3 * s3) + ((uint64_t)h4 * s2);
+    d2 = ((uint64_t)h0 * r2) + ((uint64_t)h1 * r1) + ((uint64_t)h2 * r0)
+         + ((uint64_t)h3 * s4) + ((uint64_t)h4 * s3);
+    d3 = ((uint64_t)h0 * r3) + ((uint64_t)h1 * r2) + ((uint64_t)h2 * r1)
+         + ((uint64_t)h3 * r0) + ((uint64_t)h4 * s4);
+    d4 = ((uint64_t)h0 * r4) + ((uint64_t)h1 * r3) + ((uint64_t)h2 * r2)
+         + ((uint64_t)h3 * r1) + ((uint64_t)h4 * r0);
 
     /* Partial reduction modulo 2^130-5 */
-    c = (d0 >> 26);
-    ctx->h[0] = (uint32_t)d0 & 0x3ffffff;
+    c = (uint32_t)(d0 >> 26);
+    h0 = (uint32_t)d0 & 0x3ffffff;
     d1 += c;
-
-    c = (d1 >> 26);
-    ctx->h[1] = (uint32_t)d1 & 0x3ffffff;
+    c = (uint32_t)(d1 >> 26);
+    h1 = (uint32_t)d1 & 0x3ffffff;
     d2 += c;
-
-    c = (d2 >> 26);
-    ctx->h[2] = (uint32_t)d2 & 0x3ffffff;
+    c = (uint32_t)(d2 >> 26);
+    h2 = (uint32_t)d2 & 0x3ffffff;
     d3 += c;
-
-    c = (d3 >> 26);
-    ctx->h[3] = (uint32_t)d3 & 0x3ffffff;
+    c = (uint32_t)(d3 >> 26);
+    h3 = (uint32_t)d3 & 0x3ffffff;
     d4 += c;
-
-    c = (d4 >> 26);
-    ctx->h[4] = (uint32_t)d4 & 0x3ffffff;
-    ctx->h[0] += (uint32_t)(c * 5);
-
-    c = (ctx->h[0] >> 26);
-    ctx->h[0] &= 0x3ffffff;
-    ctx->h[1] += (uint32_t)c;
-}
-
-/**
- * @brief Process one 16-byte Poly1305 block
- *
- * @param ctx Poly1305 context
- * @param block 16-byte input block
- */
-static void prv_poly1305_block(xy_poly1305_ctx_t *ctx, const uint8_t block[16])
-{
-    uint32_t t0, t1, t2, t3;
-
-    /* Load block in little-endian */
-    t0 = prv_load32_le(&block[0]);
-    t1 = prv_load32_le(&block[4]);
-    t2 = prv_load32_le(&block[8]);
-    t3 = prv_load32_le(&block[12]);
-
-    /* Add to accumulator */
-    ctx->h[0] += t0 & 0x3ffffff;
-    ctx->h[1] += ((t0 >> 26) | (t1 << 6)) & 0x3ffffff;
-    ctx->h[2] += ((t1 >> 20) | (t2 << 12)) & 0x3ffffff;
-    ctx->h[3] += ((t2 >> 14) | (t3 << 18)) & 0x3ffffff;
-    ctx->h[4] += (t3 >> 8) | (1 << 24); /* Add 2^128 */
-
-    /* Multiply by r */
-    prv_poly1305_multiply(ctx);
+    c = (uint32_t)(d4 >> 26);
+    h4 = (uint32_t)d4 & 0x3ffffff;
+    h0 += c * 5;
+    c = h0 >> 26;
+    h0 &= 0x3ffffff;
+    h1 += c;
+
+    ctx->h[0] = h0;
+    ctx->h[1] = h1;
+    ctx->h[2] = h2;
+    ctx->h[3] = h3;
+    ctx->h[4] = h4;
 }
 
 int xy_poly1305_init(xy_poly1305_ctx_t *ctx,
@@ -314,12 +287,6 @@ int xy_poly1305_init(xy_poly1305_ctx_t *ctx,
     ctx->r[3] = (prv_load32_le(&key[9]) >> 6) & 0x3f03fff;
     ctx->r[4] = (prv_load32_le(&key[12]) >> 8) & 0x00fffff;
 
-    /* Precompute 5*r for modular reduction */
-    ctx->r[1] *= 5;
-    ctx->r[2] *= 5;
-    ctx->r[3] *= 5;
-    ctx->r[4] *= 5;
-
     /* Load s */
     ctx->s[0] = prv_load32_le(&key[16]);
     ctx->s[1] = prv_load32_le(&key[20]);
@@ -356,14 +323,14 @@ int xy_poly1305_update(xy_poly1305_ctx_t *ctx,
         i += to_copy;
 
         if (ctx->buffer_len == 16) {
-            prv_poly1305_block(ctx, ctx->buffer);
+            prv_poly1305_block(ctx, ctx->buffer, 1u << 24);
             ctx->buffer_len = 0;
         }
     }
 
     /* Process complete blocks */
     while (i + 16 <= length) {
-        prv_poly1305_block(ctx, &data[i]);
+        prv_poly1305_block(ctx, &data[i], 1u << 24);
         i += 16;
     }
 
@@ -379,76 +346,94 @@ int xy_poly1305_update(xy_poly1305_ctx_t *ctx,
 int xy_poly1305_finish(xy_poly1305_ctx_t *ctx,
                         uint8_t tag[XY_POLY1305_TAG_SIZE])
 {
-    uint64_t f0, f1, f2, f3;
+    uint32_t h0, h1, h2, h3, h4;
     uint32_t g0, g1, g2, g3, g4;
-    uint32_t mask;
+    uint32_t c, mask;
+    uint64_t f;
 
     /* Validate parameters */
     if (!ctx || !tag) {
         return XY_CHACHA20_POLY1305_ERROR_INVALID_PARAM;
     }
 
-    /* Process final partial block if any */
+    /* Process final partial block if any, padded with 1 then zeros */
     if (ctx->buffer_len > 0) {
         size_t i;
-        /* Pad with zeros */
-        for (i = ctx->buffer_len; i < 16; i++) {
-            ctx->buffer[i] = 0;
-        }
 
-        /* Process with padding bit at position buffer_len */
-        {
-            uint32_t t0, t1, t2, t3;
-            t0 = prv_load32_le(&ctx->buffer[0]);
-            t1 = prv_load32_le(&ctx->buffer[4]);
-            t2 = prv_load32_le(&ctx->buffer[8]);
-            t3 = prv_load32_le(&ctx->buffer[12]);
-
-            ctx->h[0] += t0 & 0x3ffffff;
-            ctx->h[1] += ((t0 >> 26) | (t1 << 6)) & 0x3ffffff;
-            ctx->h[2] += ((t1 >> 20) | (t2 << 12)) & 0x3ffffff;
-            ctx->h[3] += ((t2 >> 14) | (t3 << 18)) & 0x3ffffff;
-            ctx->h[4] += (t3 >> 8) | (1 << (ctx->buffer_len * 8 - 104));
-
-            prv_poly1305_multiply(ctx);
+        ctx->buffer[ctx->buffer_len] = 1;
+        for (i = ctx->buffer_len + 1; i < 16; i++) {
+            ctx->buffer[i] = 0;
         }
+        prv_poly1305_block(ctx, ctx->buffer, 0);
     }
 
-    /* Final reduction modulo 2^130-5 */
-    g0 = ctx->h[0] + 5;
-    g1 = ctx->h[1] + (g0 >> 26);
+    /* Fully carry h */
+    h0 = ctx->h[0];
+    h1 = ctx->h[1];
+    h2 = ctx->h[2];
+    h3 = ctx->h[3];
+    h4 = ctx->h[4];
+
+    c = h1 >> 26;
+    h1 &= 0x3ffffff;
+    h2 += c;
+    c = h2 >> 26;
+    h2 &= 0x3ffffff;
+    h3 += c;
+    c = h3 >> 26;
+    h3 &= 0x3ffffff;
+    h4 += c;
+    c = h4 >> 26;
+    h4 &= 0x3ffffff;
+    h0 += c * 5;
+    c = h0 >> 26;
+    h0 &= 0x3ffffff;
+    h1 += c;
+
+    /* g = h + 5 - 2^130, i.e. h - p */
+    g0 = h0 + 5;
+    c = g0 >> 26;
     g0 &= 0x3ffffff;
-    g2 = ctx->h[2] + (g1 >> 26);
+    g1 = h1 + c;
+    c = g1 >> 26;
     g1 &= 0x3ffffff;
-    g3 = ctx->h[3] + (g2 >> 26);
+    g2 = h2 + c;
+    c = g2 >> 26;
     g2 &= 0x3ffffff;
-    g4 = ctx->h[4] + (g3 >> 26) - (1 << 26);
+    g3 = h3 + c;
+    c = g3 >> 26;
     g3 &= 0x3ffffff;
-
-    /* Select h if h < p, else select g = h - p */
-    mask = (g4 >> 31) - 1; /* All 1s if g4 negative, all 0s otherwise */
-    ctx->h[0] = (ctx->h[0] & ~mask) | (g0 & mask);
-    ctx->h[1] = (ctx->h[1] & ~mask) | (g1 & mask);
-    ctx->h[2] = (ctx->h[2] & ~mask) | (g2 & mask);
-    ctx->h[3] = (ctx->h[3] & ~mask) | (g3 & mask);
-    ctx->h[4] = (ctx->h[4] & ~mask) | (g4 & mask);
-
-    /* Combine into 128-bit value */
-    f0 = ((ctx->h[0]) | ((uint64_t)ctx->h[1] << 26)) + ctx->s[0];
-    f1 = ((ctx->h[1] >> 6) | ((uint64_t)ctx->h[2] << 20)) + ctx->s[1];
-    f2 = ((ctx->h[2] >> 12) | ((uint64_t)ctx->h[3] << 14)) + ctx->s[2];
-    f3 = ((ctx->h[3] >> 18) | ((uint64_t)ctx->h[4] << 8)) + ctx->s[3];
-
-    /* Handle carries */
-    f1 += (f0 >> 32);
-    f2 += (f1 >> 32);
-    f3 += (f2 >> 32);
+    g4 = h4 + c - (1u << 26);
+
+    /* Select g if h >= p (g4 did not borrow), else h */
+    mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    /* h = h % 2^128, as four 32-bit words */
+    h0 = (h0 | (h1 << 26)) & 0xffffffff;
+    h1 = ((h1 >> 6) | (h2 << 20)) & 0xffffffff;
+    h2 = ((h2 >> 12) | (h3 << 14)) & 0xffffffff;
+    h3 = ((h3 >> 18) | (h4 << 8)) & 0xffffffff;
+
+    /* tag = (h + s) % 2^128 */
+    f = (uint64_t)h0 + ctx->s[0];
+    h0 = (uint32_t)f;
+    f = (uint64_t)h1 + ctx->s[1] + (f >> 32);
+    h1 = (uint32_t)f;
+    f = (uint64_t)h2 + ctx->s[2] + (f >> 32);
+    h2 = (uint32_t)f;
+    f = (uint64_t)h3 + ctx->s[3] + (f >> 32);
+    h3 = (uint32_t)f;
 
     /* Output tag */
-    prv_store32_le(&tag[0], (uint32_t)f0);
-    prv_store32_le(&tag[4], (uint32_t)f1);
-    prv_store32_le(&tag[8], (uint32_t)f2);
-    prv_store32_le(&tag[12], (uint32_t)f3);
+    prv_store32_le(&tag[0], h0);
+    prv_store32_le(&tag[4], h1);
+    prv_store32_le(&tag[8], h2);
+    prv_store32_le(&tag[12], h3);
 
     return XY_CHACHA20_POLY1305_SUCCESS;
 }
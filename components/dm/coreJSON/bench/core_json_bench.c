@@ -0,0 +1,528 @@
+/**
+ * @file core_json_bench.c
+ * @brief Indexed queries vs. repeated JSON_Search, and the streaming writer
+ *
+ * 1. Writer: a cloud config document (device, network, 8 sensors, feature
+ *    flags, schedule) is produced with JSONWriter_*; ns per document.
+ * 2. Queries: 40 paths read from the document, compact and pretty-printed,
+ *    by JSON_Validate + JSON_SearchConst per path against JSONIndex_Build +
+ *    JSONIndex_Search per path. Every result is compared.
+ * 3. Iterate: all members of every sensor object with JSON_Iterate and
+ *    JSONIndex_Iterate.
+ * 4. Agreement: JSONIndex_Build must accept what JSON_Validate accepts
+ *    over hand-written cases and random corruptions of the document, and
+ *    find the same values whenever both accept. The one expected difference
+ *    is a missing comma before a nested collection, which only
+ *    JSON_Validate lets through.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "core_json.h"
+#include "core_json_index.h"
+#include "core_json_writer.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define ROUNDS     20000
+#define SENSORS    8
+#define FEATURES   16
+#define MUTATIONS  20000
+
+static char s_doc[4096];
+static char s_pretty[8192];
+static JSONIndexEntry_t s_tape[JSON_INDEX_TAPE_LENGTH(sizeof(s_pretty))];
+static uint32_t s_rand = 1;
+static volatile size_t s_sink;
+
+static const char *s_queries[] = {
+    "version", "device.id", "device.model", "device.fw", "device.hw",
+    "network.wifi.ssid", "network.wifi.rssi_min", "network.wifi.roam",
+    "network.mqtt.host", "network.mqtt.port", "network.mqtt.keepalive",
+    "network.mqtt.topics[0]", "network.mqtt.topics[2]", "network.mqtt.tls",
+    "sampling.period", "sampling.batch", "sampling.upload",
+    "sensors[0].type", "sensors[0].limits.lo", "sensors[1].period",
+    "sensors[2].limits.hi", "sensors[3].enabled", "sensors[4].type",
+    "sensors[5].calib[1]", "sensors[6].limits.hi", "sensors[7].type",
+    "sensors[7].calib[2]", "sensors[7].enabled",
+    "features.f00", "features.f05", "features.f09", "features.f15",
+    "ota.url", "ota.size", "ota.sha256",
+    "schedule[0].at", "schedule[3].action", "schedule[5].at",
+    "timezone", "note",
+};
+
+#define QUERY_COUNT (sizeof(s_queries) / sizeof(s_queries[0]))
+
+static uint32_t rnd(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* ==================== Writer ==================== */
+
+#define KEY(w, k) JSONWriter_Key(w, k, sizeof(k) - 1)
+#define STR(w, s) JSONWriter_String(w, s, sizeof(s) - 1)
+
+static void write_sensor(JSONWriter_t *w, int i)
+{
+    static const char *types[] = { "temp", "humidity", "pressure", "co2" };
+    const char *type = types[i % 4];
+
+    JSONWriter_OpenObject(w);
+    KEY(w, "id");
+    JSONWriter_Int(w, 100 + i);
+    KEY(w, "type");
+    JSONWriter_String(w, type, strlen(type));
+    KEY(w, "period");
+    JSONWriter_Int(w, 5 * (i + 1));
+    KEY(w, "limits");
+    JSONWriter_OpenObject(w);
+    KEY(w, "lo");
+    JSONWriter_Int(w, -20 - i);
+    KEY(w, "hi");
+    JSONWriter_Int(w, 85 + i);
+    JSONWriter_CloseObject(w);
+    KEY(w, "calib");
+    JSONWriter_OpenArray(w);
+    JSONWriter_Number(w, "1.0", 3);
+    JSONWriter_Number(w, "-0.25", 5);
+    JSONWriter_Number(w, "3e-4", 4);
+    JSONWriter_CloseArray(w);
+    KEY(w, "enabled");
+    JSONWriter_Bool(w, (i & 1) == 0);
+    JSONWriter_CloseObject(w);
+}
+
+static size_t write_doc(char *buf, size_t size)
+{
+    JSONWriter_t w;
+    char key[4] = "f00";
+    size_t len = 0;
+
+    JSONWriter_Init(&w, buf, size);
+    JSONWriter_OpenObject(&w);
+    KEY(&w, "version");
+    JSONWriter_Int(&w, 3);
+    KEY(&w, "device");
+    JSONWriter_OpenObject(&w);
+    KEY(&w, "id");
+    STR(&w, "XY-00A1-7F3C-9921");
+    KEY(&w, "model");
+    STR(&w, "gw-200");
+    KEY(&w, "fw");
+    STR(&w, "1.4.2");
+    KEY(&w, "hw");
+    JSONWriter_Int(&w, 5);
+    JSONWriter_CloseObject(&w);
+
+    KEY(&w, "network");
+    JSONWriter_OpenObject(&w);
+    KEY(&w, "wifi");
+    JSONWriter_OpenObject(&w);
+    KEY(&w, "ssid");
+    STR(&w, "plant \"B\" floor 2");
+    KEY(&w, "rssi_min");
+    JSONWriter_Int(&w, -80);
+    KEY(&w, "roam");
+    JSONWriter_Bool(&w, true);
+    JSONWriter_CloseObject(&w);
+    KEY(&w, "mqtt");
+    JSONWriter_OpenObject(&w);
+    KEY(&w, "host");
+    STR(&w, "mqtt.example.com");
+    KEY(&w, "port");
+    JSONWriter_Int(&w, 8883);
+    KEY(&w, "keepalive");
+    JSONWriter_Int(&w, 60);
+    KEY(&w, "topics");
+    JSONWriter_OpenArray(&w);
+    STR(&w, "dev/XY-00A1/up");
+    STR(&w, "dev/XY-00A1/down");
+    STR(&w, "dev/XY-00A1/ota");
+    JSONWriter_CloseArray(&w);
+    KEY(&w, "tls");
+    JSONWriter_Bool(&w, true);
+    JSONWriter_CloseObject(&w);
+    JSONWriter_CloseObject(&w);
+
+    KEY(&w, "sampling");
+    JSONWriter_OpenObject(&w);
+    KEY(&w, "period");
+    JSONWriter_Int(&w, 10);
+    KEY(&w, "batch");
+    JSONWriter_Int(&w, 32);
+    KEY(&w, "upload");
+    JSONWriter_Int(&w, 300);
+    JSONWriter_CloseObject(&w);
+
+    KEY(&w, "sensors");
+    JSONWriter_OpenArray(&w);
+    for (int i = 0; i < SENSORS; i++)
+        write_sensor(&w, i);
+    JSONWriter_CloseArray(&w);
+
+    KEY(&w, "features");
+    JSONWriter_OpenObject(&w);
+    for (int i = 0; i < FEATURES; i++) {
+        key[1] = (char)('0' + i / 10);
+        key[2] = (char)('0' + i % 10);
+        JSONWriter_Key(&w, key, 3);
+        JSONWriter_Bool(&w, i % 3 != 0);
+    }
+    JSONWriter_CloseObject(&w);
+
+    KEY(&w, "ota");
+    JSONWriter_OpenObject(&w);
+    KEY(&w, "url");
+    STR(&w, "https://ota.example.com/gw-200/1.4.3.bin");
+    KEY(&w, "size");
+    JSONWriter_Int(&w, 734208);
+    KEY(&w, "sha256");
+    STR(&w, "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08");
+    JSONWriter_CloseObject(&w);
+
+    KEY(&w, "schedule");
+    JSONWriter_OpenArray(&w);
+    for (int i = 0; i < 6; i++) {
+        JSONWriter_OpenObject(&w);
+        KEY(&w, "at");
+        JSONWriter_Int(&w, 1700000000LL + i * 3600);
+        KEY(&w, "action");
+        STR(&w, "report");
+        JSONWriter_CloseObject(&w);
+    }
+    JSONWriter_CloseArray(&w);
+
+    KEY(&w, "timezone");
+    STR(&w, "Asia/Shanghai");
+    KEY(&w, "note");
+    STR(&w, "line 1\nline 2\ttab \\ \x01");
+    JSONWriter_CloseObject(&w);
+
+    return JSONWriter_Finish(&w, &len) == JSONSuccess ? len : 0;
+}
+
+/* Two-space indentation, as config files are often stored */
+static size_t pretty(const char *in, size_t n, char *out)
+{
+    size_t o = 0;
+    int depth = 0, str = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        char c = in[i];
+
+        if (str) {
+            out[o++] = c;
+            if (c == '\\')
+                out[o++] = in[++i];
+            else if (c == '"')
+                str = 0;
+            continue;
+        }
+        if (c == '}' || c == ']') {
+            depth--;
+            out[o++] = '\n';
+            for (int d = 0; d < depth * 2; d++)
+                out[o++] = ' ';
+        }
+        out[o++] = c;
+        if (c == '"')
+            str = 1;
+        if (c == ':')
+            out[o++] = ' ';
+        if (c == '{' || c == '[' || c == ',') {
+            if (c != ',')
+                depth++;
+            out[o++] = '\n';
+            for (int d = 0; d < depth * 2; d++)
+                out[o++] = ' ';
+        }
+    }
+    return o;
+}
+
+/* ==================== Queries ==================== */
+
+static int same_results(const char *doc, size_t len, const JSONIndex_t *index)
+{
+    for (size_t q = 0; q < QUERY_COUNT; q++) {
+        const char *v1 = NULL, *v2 = NULL;
+        size_t l1 = 0, l2 = 0;
+        JSONTypes_t t1 = JSONInvalid, t2 = JSONInvalid;
+        JSONStatus_t r1, r2;
+
+        r1 = JSON_SearchConst(doc, len, s_queries[q], strlen(s_queries[q]), &v1, &l1, &t1);
+        r2 = JSONIndex_Search(index, s_queries[q], strlen(s_queries[q]), &v2, &l2, &t2);
+        if (r1 != r2 || (r1 == JSONSuccess && (v1 != v2 || l1 != l2 || t1 != t2))) {
+            printf("  mismatch on %s: %d/%d\n", s_queries[q], (int)r1, (int)r2);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int bench_queries(const char *name, const char *doc, size_t len)
+{
+    JSONIndex_t index;
+    double t0, t_search, t_index;
+    const char *v;
+    size_t l;
+
+    if (JSONIndex_Build(doc, len, s_tape, JSON_INDEX_TAPE_LENGTH(len), &index) != JSONSuccess
+        || !same_results(doc, len, &index))
+        return 0;
+
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        if (JSON_Validate(doc, len) != JSONSuccess)
+            return 0;
+        for (size_t q = 0; q < QUERY_COUNT; q++) {
+            if (JSON_SearchConst(doc, len, s_queries[q], strlen(s_queries[q]), &v, &l, NULL)
+                != JSONSuccess)
+                return 0;
+            s_sink += l;
+        }
+    }
+    t_search = (now_ns() - t0) / ROUNDS;
+
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        if (JSONIndex_Build(doc, len, s_tape, JSON_INDEX_TAPE_LENGTH(len), &index)
+            != JSONSuccess)
+            return 0;
+        for (size_t q = 0; q < QUERY_COUNT; q++) {
+            if (JSONIndex_Search(&index, s_queries[q], strlen(s_queries[q]), &v, &l, NULL)
+                != JSONSuccess)
+                return 0;
+            s_sink += l;
+        }
+    }
+    t_index = (now_ns() - t0) / ROUNDS;
+
+    printf("  %-8s %5zu B  validate + %zu searches %8.0f ns   build + %zu lookups %7.0f ns"
+           "  (%.1fx, %zu tape entries)\n",
+           name, len, QUERY_COUNT, t_search, QUERY_COUNT, t_index, t_search / t_index,
+           index.count);
+    return 1;
+}
+
+static int bench_iterate(const char *doc, size_t len)
+{
+    JSONIndex_t index;
+    double t0, t_plain, t_index;
+    size_t pairs = 0;
+
+    if (JSONIndex_Build(doc, len, s_tape, JSON_INDEX_TAPE_LENGTH(len), &index) != JSONSuccess)
+        return 0;
+
+    /* Same pairs both ways */
+    for (int s = 0; s < SENSORS; s++) {
+        char q[24];
+        const char *obj;
+        size_t obj_len, entry, start = 0, next = 0, istart, inext = 0;
+        JSONPair_t p1, p2;
+
+        snprintf(q, sizeof(q), "sensors[%d]", s);
+        if (JSON_SearchConst(doc, len, q, strlen(q), &obj, &obj_len, NULL) != JSONSuccess
+            || JSONIndex_Find(&index, 0, q, strlen(q), &entry) != JSONSuccess)
+            return 0;
+        istart = entry;
+        for (;;) {
+            JSONStatus_t r1 = JSON_Iterate(obj, obj_len, &start, &next, &p1);
+            JSONStatus_t r2 = JSONIndex_Iterate(&index, &istart, &inext, &p2);
+
+            if (r1 != r2)
+                return 0;
+            if (r1 != JSONSuccess)
+                break;
+            if (p1.key != p2.key || p1.keyLength != p2.keyLength || p1.value != p2.value
+                || p1.valueLength != p2.valueLength || p1.jsonType != p2.jsonType)
+                return 0;
+            pairs++;
+        }
+    }
+
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int s = 0; s < SENSORS; s++) {
+            char q[] = "sensors[0]";
+            const char *obj;
+            size_t obj_len, start = 0, next = 0;
+            JSONPair_t p;
+
+            q[8] = (char)('0' + s);
+            JSON_SearchConst(doc, len, q, sizeof(q) - 1, &obj, &obj_len, NULL);
+            while (JSON_Iterate(obj, obj_len, &start, &next, &p) == JSONSuccess)
+                s_sink += p.valueLength;
+        }
+    }
+    t_plain = (now_ns() - t0) / ROUNDS;
+
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int s = 0; s < SENSORS; s++) {
+            char q[] = "sensors[0]";
+            size_t start = 0, next = 0;
+            JSONPair_t p;
+
+            q[8] = (char)('0' + s);
+            JSONIndex_Find(&index, 0, q, sizeof(q) - 1, &start);
+            while (JSONIndex_Iterate(&index, &start, &next, &p) == JSONSuccess)
+                s_sink += p.valueLength;
+        }
+    }
+    t_index = (now_ns() - t0) / ROUNDS;
+
+    printf("  %zu pairs in %d sensors: JSON_Iterate %6.0f ns   JSONIndex_Iterate %5.0f ns\n",
+           pairs, SENSORS, t_plain, t_index);
+    return 1;
+}
+
+/* ==================== Agreement ==================== */
+
+static const char *s_cases[] = {
+    "{}", "[]", " 1 ", "-0.5e+3", "\"a\\u00e9\\ud83d\\ude00\"", "true", "null",
+    "{\"a\":[1,2,{\"b\":null}],\"c\":\"x\"}", "[[[[]]]]", "\"\xc3\xa9\xe2\x82\xac\"",
+    "{\"a\":1,}", "[1,]", "[01]", "[1.]", "[.5]", "[1e]", "{\"a\" 1}", "{1:2}",
+    "[\"\\u0000\"]", "[\"\\udc00\"]", "[\"\\ud800x\"]", "[\"\x01\"]", "[\"\xc0\x80\"]",
+    "[\"\xed\xa0\x80\"]", "[\"\xf4\x90\x80\x80\"]", "[tru]", "[truex]", "{\"a\":1}}",
+    "[1] [2]", "{\"a\":{\"b\":[1,2,3]", "[\"abc", "", "   ", "[\"\\x\"]", "[-]", "[--1]",
+    "{\"a\":1 \"b\":2}", "[1 2]", "[]]", "{]", "[}", "[1 {}]", "[[][]]",
+};
+
+/*
+ * JSON_Validate() lets a collection through without the comma before it
+ * inside an array ("[1 {}]", "[[][]]"); JSONIndex_Build() does not.
+ */
+static int comma_missing(const char *doc, size_t len)
+{
+    char prev = 0;
+    int str = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = doc[i];
+
+        if (str) {
+            if (c == '\\')
+                i++;
+            else if (c == '"')
+                str = 0, prev = c;
+            continue;
+        }
+        if ((c == '{' || c == '[') && prev != 0 && prev != '[' && prev != ',' && prev != ':')
+            return 1;
+        if (c == '"')
+            str = 1;
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+            prev = c;
+    }
+    return 0;
+}
+
+static int agree(const char *doc, size_t len, uint32_t *lenient)
+{
+    JSONIndex_t index;
+    JSONStatus_t r1, r2;
+
+    r1 = len ? JSON_Validate(doc, len) : JSONBadParameter;
+    r2 = JSONIndex_Build(doc, len, s_tape, JSON_INDEX_TAPE_LENGTH(len), &index);
+    if (r1 == JSONSuccess && r2 != JSONSuccess && comma_missing(doc, len)) {
+        (*lenient)++;
+        return 1;
+    }
+    if ((r1 == JSONSuccess) != (r2 == JSONSuccess)) {
+        printf("  disagree on \"%.*s\": validate %d, index %d\n", (int)len, doc, (int)r1,
+               (int)r2);
+        return 0;
+    }
+    return r1 != JSONSuccess || same_results(doc, len, &index);
+}
+
+static int check_agreement(const char *doc, size_t len)
+{
+    static char buf[sizeof(s_doc)];
+    static const char pool[] = "{}[]\",:\\ 0-.eE1tfnu\x01\xc3\xa9\xff";
+    size_t n = sizeof(s_cases) / sizeof(s_cases[0]);
+    uint32_t rejected = 0, lenient = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (!agree(s_cases[i], strlen(s_cases[i]), &lenient))
+            return 0;
+    }
+    for (int m = 0; m < MUTATIONS; m++) {
+        size_t blen = len;
+
+        memcpy(buf, doc, len);
+        for (uint32_t k = rnd() % 3 + 1; k > 0; k--) {
+            switch (rnd() % 3) {
+            case 0:
+                buf[rnd() % blen] = pool[rnd() % (sizeof(pool) - 1)];
+                break;
+            case 1:
+                blen = rnd() % blen + 1;
+                break;
+            default: {
+                size_t at = rnd() % blen;
+                memmove(&buf[at], &buf[at + 1], blen - at - 1);
+                blen = blen > 1 ? blen - 1 : 1;
+                break;
+            }
+            }
+        }
+        if (!agree(buf, blen, &lenient))
+            return 0;
+        rejected += JSON_Validate(buf, blen) != JSONSuccess;
+    }
+    printf("  %zu cases and %d corruptions (%u rejected): same verdicts and values\n", n,
+           MUTATIONS, (unsigned)rejected);
+    printf("  %u accepted by JSON_Validate only, all missing a comma before a collection\n",
+           (unsigned)lenient);
+    return 1;
+}
+
+int main(void)
+{
+    size_t len, plen;
+    double t0;
+
+    len = write_doc(s_doc, sizeof(s_doc));
+    if (len == 0 || JSON_Validate(s_doc, len) != JSONSuccess)
+        goto fail;
+    t0 = now_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        s_sink += write_doc(s_doc, sizeof(s_doc));
+    printf("writer\n  %zu B config document  %.0f ns\n", len, (now_ns() - t0) / ROUNDS);
+    if (write_doc(s_doc, len) != len || write_doc(s_doc, len - 1) != 0)
+        goto fail; /* Exactly fits without the NUL; one byte less is full */
+    len = write_doc(s_doc, sizeof(s_doc));
+    plen = pretty(s_doc, len, s_pretty);
+    if (JSON_Validate(s_pretty, plen) != JSONSuccess)
+        goto fail;
+
+    printf("\n%zu queries per document\n", QUERY_COUNT);
+    if (!bench_queries("compact", s_doc, len) || !bench_queries("pretty", s_pretty, plen))
+        goto fail;
+
+    printf("\niterate\n");
+    if (!bench_iterate(s_doc, len))
+        goto fail;
+
+    printf("\nagreement with JSON_Validate / JSON_SearchConst\n");
+    if (!check_agreement(s_doc, len))
+        goto fail;
+    return 0;
+
+fail:
+    printf("check failed\n");
+    return 1;
+}
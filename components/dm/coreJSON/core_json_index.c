@@ -0,0 +1,1090 @@
+/*
+ * coreJSON v3.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_index.c
+ * @brief One-pass JSON tokenizer building a tape of value positions, and
+ * queries over that tape.
+ */
+
+#include <string.h>
+
+#include "core_json_index.h"
+
+/** @cond DO_NOT_DOCUMENT */
+
+/* Same limits and query syntax as core_json.c */
+#ifndef JSON_MAX_DEPTH
+    #define JSON_MAX_DEPTH    32
+#endif
+
+#ifndef JSON_QUERY_KEY_SEPARATOR
+    #define JSON_QUERY_KEY_SEPARATOR    '.'
+#endif
+
+#define isSeparator_( x )    ( ( x ) == JSON_QUERY_KEY_SEPARATOR )
+#define isdigit_( x )        ( ( ( x ) >= '0' ) && ( ( x ) <= '9' ) )
+#define isspace_( x )                          \
+    ( ( ( x ) == ' ' ) || ( ( x ) == '\t' ) || \
+      ( ( x ) == '\n' ) || ( ( x ) == '\r' ) )
+#define isOpenBracket_( x )     ( ( ( x ) == '{' ) || ( ( x ) == '[' ) )
+#define isCollection_( t )      ( ( ( t ) == JSONObject ) || ( ( t ) == JSONArray ) )
+
+/* Largest tape position that fits JSONIndexEntry_t.next */
+#define TAPE_MAX    ( ( ( size_t ) 1U << 28U ) - 1U )
+
+#define MAX_FACTOR    ( MAX_INDEX_VALUE / 10 )
+
+/*
+ * SWAR: test eight bytes at once in a uint64_t.  swarLess_() sets the high
+ * bit of every byte below n (n <= 0x80); bits above the first such byte may
+ * be false positives, which only ever send the scan to the bytewise path.
+ */
+#define SWAR_ONES             ( 0x0101010101010101ULL )
+#define SWAR_HIGHS            ( 0x8080808080808080ULL )
+#define SWAR_SPACES           ( SWAR_ONES * ( uint64_t ) ' ' )
+#define swarLess_( x, n )     ( ( ( x ) - ( SWAR_ONES * ( uint64_t ) ( n ) ) ) & ~( x ) & SWAR_HIGHS )
+#define swarEq_( x, c )       swarLess_( ( x ) ^ ( SWAR_ONES * ( uint64_t ) ( uint8_t ) ( c ) ), 1U )
+
+typedef union
+{
+    char c;
+    uint8_t u;
+} char_;
+
+typedef enum
+{
+    stateValue = 0, /* a value */
+    stateKey,       /* a key, then ':' */
+    stateFirst,     /* first member, or the close of an empty collection */
+    stateMore,      /* ',' or the close of the current collection */
+    stateDone
+} state_t;
+
+typedef struct
+{
+    const char * buf;
+    size_t max;
+    size_t i;
+    JSONIndexEntry_t * tape;
+    size_t tapeLength;
+    size_t count;
+} parser_t;
+
+static uint64_t load64( const char * p )
+{
+    uint64_t w;
+
+    ( void ) memcpy( &w, p, sizeof( w ) );
+
+    return w;
+}
+
+/**
+ * @brief Bytes that end the fast path through a string: quote, backslash,
+ * control characters and the start of UTF-8 sequences.
+ */
+static uint64_t stringSpecials( uint64_t w )
+{
+    return swarEq_( w, '"' ) | swarEq_( w, '\\' ) | swarLess_( w, 0x20U ) | ( w & SWAR_HIGHS );
+}
+
+static void skipSpace( parser_t * p )
+{
+    size_t i = p->i;
+
+    /* Indentation runs of pretty-printed documents */
+    while( ( ( p->max - i ) >= 8U ) && ( load64( &p->buf[ i ] ) == SWAR_SPACES ) )
+    {
+        i += 8U;
+    }
+
+    while( ( i < p->max ) && isspace_( p->buf[ i ] ) )
+    {
+        i++;
+    }
+
+    p->i = i;
+}
+
+static JSONStatus_t addEntry( parser_t * p,
+                              size_t offset,
+                              size_t length,
+                              JSONTypes_t type,
+                              size_t * outPos )
+{
+    JSONStatus_t ret = JSONBadParameter;
+
+    if( p->count < p->tapeLength )
+    {
+        JSONIndexEntry_t * e = &p->tape[ p->count ];
+
+        e->offset = ( uint32_t ) offset;
+        e->length = ( uint32_t ) length;
+        e->next = ( uint32_t ) p->count + 1U;
+        e->type = ( uint32_t ) type;
+        *outPos = p->count;
+        p->count++;
+        ret = JSONSuccess;
+    }
+
+    return ret;
+}
+
+/* ==================== Scalars ==================== */
+
+static uint8_t hexValue( char c )
+{
+    uint8_t n = 0x10U;
+
+    if( isdigit_( c ) )
+    {
+        n = ( uint8_t ) ( c - '0' );
+    }
+    else if( ( c >= 'a' ) && ( c <= 'f' ) )
+    {
+        n = ( uint8_t ) ( c - 'a' + 10 );
+    }
+    else if( ( c >= 'A' ) && ( c <= 'F' ) )
+    {
+        n = ( uint8_t ) ( c - 'A' + 10 );
+    }
+    else
+    {
+        /* not a hex digit */
+    }
+
+    return n;
+}
+
+/**
+ * @brief One \uXXXX escape at buf[ *start ]; \u0000 is disallowed as in core_json.c.
+ */
+static JSONStatus_t scanHex( const char * buf,
+                             size_t * start,
+                             size_t max,
+                             uint16_t * outValue )
+{
+    JSONStatus_t ret = JSONSuccess;
+    size_t i = *start;
+    uint16_t value = 0U;
+
+    if( ( max - i ) < 6U )
+    {
+        ret = JSONPartial;
+    }
+    else if( ( buf[ i ] != '\\' ) || ( buf[ i + 1U ] != 'u' ) )
+    {
+        ret = JSONIllegalDocument;
+    }
+    else
+    {
+        for( i += 2U; i < ( *start + 6U ); i++ )
+        {
+            uint8_t n = hexValue( buf[ i ] );
+
+            if( n > 0x0FU )
+            {
+                ret = JSONIllegalDocument;
+                break;
+            }
+
+            value = ( uint16_t ) ( ( value << 4U ) | n );
+        }
+    }
+
+    if( ( ret == JSONSuccess ) && ( value == 0U ) )
+    {
+        ret = JSONIllegalDocument;
+    }
+
+    if( ret == JSONSuccess )
+    {
+        *start = i;
+        *outValue = value;
+    }
+
+    return ret;
+}
+
+#define isHighSurrogate( x )    ( ( ( x ) >= 0xD800U ) && ( ( x ) <= 0xDBFFU ) )
+#define isLowSurrogate( x )     ( ( ( x ) >= 0xDC00U ) && ( ( x ) <= 0xDFFFU ) )
+
+static JSONStatus_t scanEscape( const char * buf,
+                                size_t * start,
+                                size_t max )
+{
+    JSONStatus_t ret = JSONIllegalDocument;
+    size_t i = *start;
+    uint16_t value = 0U;
+    char_ c;
+
+    if( ( max - i ) < 2U )
+    {
+        ret = JSONPartial;
+    }
+    else
+    {
+        c.c = buf[ i + 1U ];
+
+        switch( c.c )
+        {
+            case 'u':
+                ret = scanHex( buf, &i, max, &value );
+
+                if( ( ret == JSONSuccess ) && isHighSurrogate( value ) )
+                {
+                    ret = scanHex( buf, &i, max, &value );
+
+                    if( ( ret == JSONSuccess ) && !isLowSurrogate( value ) )
+                    {
+                        ret = JSONIllegalDocument;
+                    }
+                }
+                else if( ( ret == JSONSuccess ) && isLowSurrogate( value ) )
+                {
+                    ret = JSONIllegalDocument;
+                }
+                else
+                {
+                    /* MISRA 15.7 */
+                }
+
+                break;
+
+            case '"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                i += 2U;
+                ret = JSONSuccess;
+                break;
+
+            default:
+
+                /* core_json.c also takes an escaped control character, except NUL */
+                if( ( c.u > 0U ) && ( c.u < 0x20U ) )
+                {
+                    i += 2U;
+                    ret = JSONSuccess;
+                }
+
+                break;
+        }
+    }
+
+    if( ret == JSONSuccess )
+    {
+        *start = i;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief A UTF-8 multibyte sequence: shortest form, no surrogates, at most U+10FFFF.
+ */
+static JSONStatus_t scanUTF8( const char * buf,
+                              size_t * start,
+                              size_t max )
+{
+    JSONStatus_t ret = JSONIllegalDocument;
+    size_t i = *start, n = 0U, j;
+    uint32_t value = 0U, min = 0U;
+    char_ c;
+
+    c.c = buf[ i ];
+
+    if( ( c.u >= 0xC2U ) && ( c.u <= 0xDFU ) )
+    {
+        n = 2U;
+        value = c.u & 0x1FU;
+        min = 0x80U;
+    }
+    else if( ( c.u >= 0xE0U ) && ( c.u <= 0xEFU ) )
+    {
+        n = 3U;
+        value = c.u & 0x0FU;
+        min = 0x800U;
+    }
+    else if( ( c.u >= 0xF0U ) && ( c.u <= 0xF4U ) )
+    {
+        n = 4U;
+        value = c.u & 0x07U;
+        min = 0x10000U;
+    }
+    else
+    {
+        /* continuation byte or illegal lead byte */
+    }
+
+    if( n > 0U )
+    {
+        if( ( max - i ) < n )
+        {
+            ret = JSONPartial;
+        }
+        else
+        {
+            for( j = 1U; j < n; j++ )
+            {
+                c.c = buf[ i + j ];
+
+                if( ( c.u & 0xC0U ) != 0x80U )
+                {
+                    break;
+                }
+
+                value = ( value << 6U ) | ( c.u & 0x3FU );
+            }
+
+            if( ( j == n ) && ( value >= min ) && ( value <= 0x10FFFFU ) &&
+                ( ( value < 0xD800U ) || ( value > 0xDFFFU ) ) )
+            {
+                *start = i + n;
+                ret = JSONSuccess;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief A string at p->i, added to the tape without its quotes.
+ */
+static JSONStatus_t scanString( parser_t * p,
+                                size_t * outPos )
+{
+    JSONStatus_t ret = JSONSuccess;
+    const char * buf = p->buf;
+    size_t max = p->max, i = p->i + 1U;
+    bool closed = false;
+    char_ c;
+
+    while( ( ret == JSONSuccess ) && ( closed == false ) )
+    {
+        /* Plain ASCII eight bytes at a time */
+        while( ( ( max - i ) >= 8U ) && ( stringSpecials( load64( &buf[ i ] ) ) == 0U ) )
+        {
+            i += 8U;
+        }
+
+        if( i >= max )
+        {
+            ret = JSONPartial;
+            break;
+        }
+
+        c.c = buf[ i ];
+
+        if( c.c == '"' )
+        {
+            ret = addEntry( p, p->i + 1U, i - p->i - 1U, JSONString, outPos );
+            closed = true;
+            i++;
+        }
+        else if( c.c == '\\' )
+        {
+            ret = scanEscape( buf, &i, max );
+        }
+        else if( c.u < 0x20U )
+        {
+            ret = JSONIllegalDocument;
+        }
+        else if( c.u >= 0x80U )
+        {
+            ret = scanUTF8( buf, &i, max );
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    if( ret == JSONSuccess )
+    {
+        p->i = i;
+    }
+
+    return ret;
+}
+
+static size_t skipDigits( const char * buf,
+                          size_t i,
+                          size_t max )
+{
+    size_t j = i;
+
+    while( ( j < max ) && isdigit_( buf[ j ] ) )
+    {
+        j++;
+    }
+
+    return j;
+}
+
+/**
+ * @brief A number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+ */
+static JSONStatus_t scanNumber( parser_t * p,
+                                size_t * outPos )
+{
+    JSONStatus_t ret = JSONSuccess;
+    const char * buf = p->buf;
+    size_t max = p->max, i = p->i;
+
+    if( buf[ i ] == '-' )
+    {
+        i++;
+    }
+
+    if( i >= max )
+    {
+        ret = JSONPartial;
+    }
+    else if( buf[ i ] == '0' )
+    {
+        i++;
+    }
+    else if( isdigit_( buf[ i ] ) )
+    {
+        i = skipDigits( buf, i, max );
+    }
+    else
+    {
+        ret = JSONIllegalDocument;
+    }
+
+    if( ( ret == JSONSuccess ) && ( i < max ) && ( buf[ i ] == '.' ) )
+    {
+        i++;
+
+        if( i >= max )
+        {
+            ret = JSONPartial;
+        }
+        else if( !isdigit_( buf[ i ] ) )
+        {
+            ret = JSONIllegalDocument;
+        }
+        else
+        {
+            i = skipDigits( buf, i, max );
+        }
+    }
+
+    if( ( ret == JSONSuccess ) && ( i < max ) && ( ( buf[ i ] == 'e' ) || ( buf[ i ] == 'E' ) ) )
+    {
+        i++;
+
+        if( ( i < max ) && ( ( buf[ i ] == '-' ) || ( buf[ i ] == '+' ) ) )
+        {
+            i++;
+        }
+
+        if( i >= max )
+        {
+            ret = JSONPartial;
+        }
+        else if( !isdigit_( buf[ i ] ) )
+        {
+            ret = JSONIllegalDocument;
+        }
+        else
+        {
+            i = skipDigits( buf, i, max );
+        }
+    }
+
+    if( ret == JSONSuccess )
+    {
+        ret = addEntry( p, p->i, i - p->i, JSONNumber, outPos );
+    }
+
+    if( ret == JSONSuccess )
+    {
+        p->i = i;
+    }
+
+    return ret;
+}
+
+static JSONStatus_t scanLiteral( parser_t * p,
+                                 const char * literal,
+                                 size_t length,
+                                 JSONTypes_t type,
+                                 size_t * outPos )
+{
+    JSONStatus_t ret = JSONIllegalDocument;
+    size_t avail = p->max - p->i;
+
+    if( avail < length )
+    {
+        if( memcmp( &p->buf[ p->i ], literal, avail ) == 0 )
+        {
+            ret = JSONPartial;
+        }
+    }
+    else if( memcmp( &p->buf[ p->i ], literal, length ) == 0 )
+    {
+        ret = addEntry( p, p->i, length, type, outPos );
+
+        if( ret == JSONSuccess )
+        {
+            p->i += length;
+        }
+    }
+    else
+    {
+        /* MISRA 15.7 */
+    }
+
+    return ret;
+}
+
+static JSONStatus_t scanScalar( parser_t * p )
+{
+    JSONStatus_t ret;
+    size_t pos = 0U;
+
+    switch( p->buf[ p->i ] )
+    {
+        case '"':
+            ret = scanString( p, &pos );
+            break;
+
+        case 't':
+            ret = scanLiteral( p, "true", 4U, JSONTrue, &pos );
+            break;
+
+        case 'f':
+            ret = scanLiteral( p, "false", 5U, JSONFalse, &pos );
+            break;
+
+        case 'n':
+            ret = scanLiteral( p, "null", 4U, JSONNull, &pos );
+            break;
+
+        default:
+            ret = scanNumber( p, &pos );
+            break;
+    }
+
+    return ret;
+}
+
+/* ==================== Tape ==================== */
+
+/**
+ * @brief Tokenize the whole document onto the tape.
+ *
+ * An open collection is pushed as an entry whose length and next are
+ * filled in at its close, so the tape comes out in document order with
+ * every entry knowing where its subtree ends.
+ */
+static JSONStatus_t buildTape( parser_t * p )
+{
+    JSONStatus_t ret = JSONSuccess;
+    size_t stack[ JSON_MAX_DEPTH ];
+    size_t depth = 0U, pos = 0U;
+    state_t state = stateValue;
+    bool inObject = false;
+    char c;
+
+    skipSpace( p );
+
+    #ifdef JSON_VALIDATE_COLLECTIONS_ONLY
+        if( ( p->i < p->max ) && !isOpenBracket_( p->buf[ p->i ] ) )
+        {
+            ret = JSONIllegalDocument;
+        }
+    #endif
+
+    while( ( ret == JSONSuccess ) && ( state != stateDone ) )
+    {
+        if( ( state == stateMore ) && ( depth == 0U ) )
+        {
+            state = stateDone;
+            break;
+        }
+
+        if( p->i >= p->max )
+        {
+            ret = JSONPartial;
+            break;
+        }
+
+        c = p->buf[ p->i ];
+
+        switch( state )
+        {
+            case stateValue:
+
+                if( isOpenBracket_( c ) )
+                {
+                    if( depth >= JSON_MAX_DEPTH )
+                    {
+                        ret = JSONMaxDepthExceeded;
+                        break;
+                    }
+
+                    ret = addEntry( p, p->i, 0U, ( c == '{' ) ? JSONObject : JSONArray, &pos );
+                    stack[ depth ] = pos;
+                    depth++;
+                    inObject = ( c == '{' );
+                    p->i++;
+                    state = stateFirst;
+                }
+                else
+                {
+                    ret = scanScalar( p );
+                    state = stateMore;
+                }
+
+                break;
+
+            case stateKey:
+
+                if( c != '"' )
+                {
+                    ret = JSONIllegalDocument;
+                    break;
+                }
+
+                ret = scanString( p, &pos );
+
+                if( ret == JSONSuccess )
+                {
+                    skipSpace( p );
+
+                    if( p->i >= p->max )
+                    {
+                        ret = JSONPartial;
+                    }
+                    else if( p->buf[ p->i ] != ':' )
+                    {
+                        ret = JSONIllegalDocument;
+                    }
+                    else
+                    {
+                        p->i++;
+                        state = stateValue;
+                    }
+                }
+
+                break;
+
+            case stateFirst:
+            case stateMore:
+
+                if( ( state == stateMore ) && ( c == ',' ) )
+                {
+                    p->i++;
+                    state = inObject ? stateKey : stateValue;
+                }
+                else if( ( c == ( inObject ? '}' : ']' ) ) )
+                {
+                    JSONIndexEntry_t * e;
+
+                    depth--;
+                    e = &p->tape[ stack[ depth ] ];
+                    e->length = ( uint32_t ) ( p->i + 1U - e->offset );
+                    e->next = ( uint32_t ) p->count;
+                    inObject = ( depth > 0U ) && ( p->tape[ stack[ depth - 1U ] ].type == JSONObject );
+                    p->i++;
+                    state = stateMore;
+                }
+                else if( state == stateFirst )
+                {
+                    /* nothing consumed; the member starts here */
+                    state = inObject ? stateKey : stateValue;
+                }
+                else
+                {
+                    ret = JSONIllegalDocument;
+                }
+
+                break;
+
+            default:
+                ret = JSONIllegalDocument;
+                break;
+        }
+
+        skipSpace( p );
+    }
+
+    if( ( ret == JSONSuccess ) && ( p->i != p->max ) )
+    {
+        ret = JSONIllegalDocument;
+    }
+
+    return ret;
+}
+
+/* ==================== Queries ==================== */
+
+static bool objectMember( const JSONIndex_t * index,
+                          size_t * pos,
+                          const char * key,
+                          size_t keyLength )
+{
+    bool ret = false;
+    const JSONIndexEntry_t * tape = index->tape;
+    size_t k = *pos + 1U, end = tape[ *pos ].next;
+
+    if( tape[ *pos ].type == ( uint32_t ) JSONObject )
+    {
+        while( k < end )
+        {
+            if( ( tape[ k ].length == keyLength ) &&
+                ( memcmp( &index->buf[ tape[ k ].offset ], key, keyLength ) == 0 ) )
+            {
+                *pos = k + 1U;
+                ret = true;
+                break;
+            }
+
+            k = tape[ k + 1U ].next;
+        }
+    }
+
+    return ret;
+}
+
+static bool arrayMember( const JSONIndex_t * index,
+                         size_t * pos,
+                         uint32_t n )
+{
+    bool ret = false;
+    const JSONIndexEntry_t * tape = index->tape;
+    size_t v = *pos + 1U, end = tape[ *pos ].next;
+    uint32_t i;
+
+    if( tape[ *pos ].type == ( uint32_t ) JSONArray )
+    {
+        for( i = 0U; ( i < n ) && ( v < end ); i++ )
+        {
+            v = tape[ v ].next;
+        }
+
+        if( v < end )
+        {
+            *pos = v;
+            ret = true;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Walk the parts of a query, as multiSearch() in core_json.c does over the text.
+ */
+static JSONStatus_t findEntry( const JSONIndex_t * index,
+                               size_t start,
+                               const char * query,
+                               size_t queryLength,
+                               size_t * outEntry )
+{
+    JSONStatus_t ret = JSONSuccess;
+    size_t i = 0U, pos = start;
+
+    while( ( ret == JSONSuccess ) && ( i < queryLength ) )
+    {
+        bool found = false;
+
+        if( query[ i ] == '[' )
+        {
+            int32_t n = 0;
+            size_t digits;
+
+            i++;
+            digits = i;
+
+            while( ( i < queryLength ) && isdigit_( query[ i ] ) )
+            {
+                n = ( n <= MAX_FACTOR ) ? ( ( n * 10 ) + ( query[ i ] - '0' ) ) : -1;
+                i++;
+            }
+
+            if( ( i == digits ) || ( n < 0 ) || ( i >= queryLength ) || ( query[ i ] != ']' ) )
+            {
+                ret = JSONBadParameter;
+                break;
+            }
+
+            i++;
+            found = arrayMember( index, &pos, ( uint32_t ) n );
+        }
+        else
+        {
+            size_t key = i;
+
+            while( ( i < queryLength ) && !isSeparator_( query[ i ] ) && ( query[ i ] != '[' ) )
+            {
+                i++;
+            }
+
+            /* catch an empty key part or a trailing separator */
+            if( ( i == key ) || ( i == ( queryLength - 1U ) ) )
+            {
+                ret = JSONBadParameter;
+                break;
+            }
+
+            found = objectMember( index, &pos, &query[ key ], i - key );
+        }
+
+        if( found == false )
+        {
+            ret = JSONNotFound;
+            break;
+        }
+
+        if( ( i < queryLength ) && isSeparator_( query[ i ] ) )
+        {
+            i++;
+        }
+    }
+
+    if( ret == JSONSuccess )
+    {
+        *outEntry = pos;
+    }
+
+    return ret;
+}
+
+/** @endcond */
+
+/**
+ * See core_json_index.h for docs.
+ */
+JSONStatus_t JSONIndex_Build( const char * buf,
+                              size_t max,
+                              JSONIndexEntry_t * tape,
+                              size_t tapeLength,
+                              JSONIndex_t * outIndex )
+{
+    JSONStatus_t ret;
+    parser_t p;
+
+    if( ( buf == NULL ) || ( tape == NULL ) || ( outIndex == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( max == 0U ) || ( max > UINT32_MAX ) || ( tapeLength == 0U ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        p.buf = buf;
+        p.max = max;
+        p.i = 0U;
+        p.tape = tape;
+        p.tapeLength = ( tapeLength > TAPE_MAX ) ? TAPE_MAX : tapeLength;
+        p.count = 0U;
+
+        ret = buildTape( &p );
+
+        outIndex->buf = buf;
+        outIndex->max = max;
+        outIndex->tape = tape;
+        outIndex->tapeLength = tapeLength;
+        outIndex->count = ( ret == JSONSuccess ) ? p.count : 0U;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_index.h for docs.
+ */
+JSONStatus_t JSONIndex_Find( const JSONIndex_t * index,
+                             size_t start,
+                             const char * query,
+                             size_t queryLength,
+                             size_t * outEntry )
+{
+    JSONStatus_t ret;
+
+    if( ( index == NULL ) || ( query == NULL ) || ( outEntry == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( queryLength == 0U ) || ( start >= index->count ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        ret = findEntry( index, start, query, queryLength, outEntry );
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_index.h for docs.
+ */
+JSONStatus_t JSONIndex_Value( const JSONIndex_t * index,
+                              size_t entry,
+                              const char ** outValue,
+                              size_t * outValueLength,
+                              JSONTypes_t * outType )
+{
+    JSONStatus_t ret = JSONSuccess;
+
+    if( ( index == NULL ) || ( outValue == NULL ) || ( outValueLength == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( entry >= index->count )
+    {
+        ret = JSONBadParameter;
+    }
+    else
+    {
+        const JSONIndexEntry_t * e = &index->tape[ entry ];
+
+        *outValue = &index->buf[ e->offset ];
+        *outValueLength = e->length;
+
+        if( outType != NULL )
+        {
+            *outType = ( JSONTypes_t ) e->type;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_index.h for docs.
+ */
+JSONStatus_t JSONIndex_Search( const JSONIndex_t * index,
+                               const char * query,
+                               size_t queryLength,
+                               const char ** outValue,
+                               size_t * outValueLength,
+                               JSONTypes_t * outType )
+{
+    JSONStatus_t ret;
+    size_t entry = 0U;
+
+    if( ( outValue == NULL ) || ( outValueLength == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else
+    {
+        ret = JSONIndex_Find( index, 0U, query, queryLength, &entry );
+    }
+
+    if( ret == JSONSuccess )
+    {
+        ret = JSONIndex_Value( index, entry, outValue, outValueLength, outType );
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_index.h for docs.
+ */
+JSONStatus_t JSONIndex_Iterate( const JSONIndex_t * index,
+                                size_t * start,
+                                size_t * next,
+                                JSONPair_t * outPair )
+{
+    JSONStatus_t ret = JSONSuccess;
+    const JSONIndexEntry_t * tape = NULL;
+    size_t key = 0U, value = 0U;
+
+    if( ( index == NULL ) || ( start == NULL ) || ( next == NULL ) || ( outPair == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( ( *start >= index->count ) || ( *next > index->count ) )
+    {
+        ret = JSONBadParameter;
+    }
+    else if( !isCollection_( ( JSONTypes_t ) index->tape[ *start ].type ) )
+    {
+        ret = JSONIllegalDocument;
+    }
+    else
+    {
+        tape = index->tape;
+
+        if( *next <= *start )
+        {
+            *next = *start + 1U;
+        }
+
+        if( *next >= tape[ *start ].next )
+        {
+            ret = JSONNotFound;
+        }
+        else if( tape[ *start ].type == ( uint32_t ) JSONObject )
+        {
+            key = *next;
+            value = key + 1U;
+        }
+        else
+        {
+            value = *next;
+        }
+    }
+
+    if( ret == JSONSuccess )
+    {
+        const JSONIndexEntry_t * v = &tape[ value ];
+
+        if( key != 0U )
+        {
+            outPair->key = &index->buf[ tape[ key ].offset ];
+            outPair->keyLength = tape[ key ].length;
+        }
+        else
+        {
+            outPair->key = NULL;
+            outPair->keyLength = 0U;
+        }
+
+        outPair->value = &index->buf[ v->offset ];
+        outPair->valueLength = v->length;
+        outPair->jsonType = ( JSONTypes_t ) v->type;
+        *next = v->next;
+    }
+
+    return ret;
+}
@@ -0,0 +1,239 @@
+/*
+ * coreJSON v3.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_index.h
+ * @brief One-pass index of a JSON document for repeated queries.
+ *
+ * JSON_Search() parses the document from the start on every call.  When
+ * many keys are read from the same document, build an index once with
+ * JSONIndex_Build() and query it instead: the document is validated and
+ * tokenized in a single pass into a tape of value positions, and each
+ * lookup then walks the tape, skipping whole objects and arrays in one
+ * step.  The index holds offsets into the caller's buffer, which must stay
+ * unchanged while the index is in use.
+ */
+
+#ifndef CORE_JSON_INDEX_H_
+#define CORE_JSON_INDEX_H_
+
+#include <stdint.h>
+
+#include "core_json.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup json_struct_types
+ * @brief One tape entry: a value, or the key of an object member.
+ *
+ * The members of an object are stored as key, value, key, value, ...
+ * directly after the object's own entry; the values of an array likewise.
+ */
+typedef struct
+{
+    uint32_t offset;    /**< @brief Position of the value in the buffer; for strings, after the opening quote. */
+    uint32_t length;    /**< @brief Length of the value; for strings, without the quotes. */
+    uint32_t next : 28; /**< @brief Tape position just past this value and everything inside it. */
+    uint32_t type : 4;  /**< @brief #JSONTypes_t of the value; keys are #JSONString. */
+} JSONIndexEntry_t;
+
+/**
+ * @ingroup json_struct_types
+ * @brief An indexed document.
+ */
+typedef struct
+{
+    const char * buf;         /**< @brief The indexed buffer. */
+    size_t max;               /**< @brief Size of the buffer. */
+    JSONIndexEntry_t * tape;  /**< @brief Tape storage, provided by the caller. */
+    size_t tapeLength;        /**< @brief Number of entries in tape. */
+    size_t count;             /**< @brief Entries used; entry 0 is the root value. */
+} JSONIndex_t;
+
+/**
+ * @brief Tape entries always sufficient for a document of @p max bytes.
+ *
+ * Every value takes at least one byte plus a separator, so the tape never
+ * needs more than one entry per two bytes.
+ */
+#define JSON_INDEX_TAPE_LENGTH( max )    ( ( ( max ) / 2U ) + 1U )
+
+/**
+ * @brief Validate a JSON document and index it in one pass.
+ *
+ * Accepts the same documents as JSON_Validate(), including the
+ * JSON_MAX_DEPTH and JSON_VALIDATE_COLLECTIONS_ONLY settings, except that
+ * a nested object or array must be preceded by a comma inside an array
+ * ("[1 {}]" passes JSON_Validate() but is rejected here).
+ *
+ * @param[in] buf  The buffer to index.
+ * @param[in] max  The size of the buffer (at most 2^32 - 1).
+ * @param[out] tape  Storage for the tape entries.
+ * @param[in] tapeLength  Number of entries in tape; JSON_INDEX_TAPE_LENGTH( max ) always suffices.
+ * @param[out] outIndex  The index, used by the other JSONIndex_ functions.
+ *
+ * @return #JSONSuccess if the document is valid and indexed;
+ * #JSONNullParameter if any pointer parameter is NULL;
+ * #JSONBadParameter if max is 0 or too large, or the tape is too short;
+ * #JSONIllegalDocument if the buffer contents are NOT valid JSON;
+ * #JSONMaxDepthExceeded if object and array nesting exceeds JSON_MAX_DEPTH;
+ * #JSONPartial if the buffer contents are potentially valid but incomplete.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     char buffer[] = "{\"foo\":\"abc\",\"bar\":{\"foo\":\"xyz\"}}";
+ *     size_t bufferLength = sizeof( buffer ) - 1;
+ *     JSONIndexEntry_t tape[ 8 ];
+ *     JSONIndex_t index;
+ *     const char * value;
+ *     size_t valueLength;
+ *     JSONStatus_t result;
+ *
+ *     result = JSONIndex_Build( buffer, bufferLength, tape, 8, &index );
+ *
+ *     if( result == JSONSuccess )
+ *     {
+ *         result = JSONIndex_Search( &index, "bar.foo", 7, &value, &valueLength, NULL );
+ *     }
+ *
+ *     if( result == JSONSuccess )
+ *     {
+ *         // "Found: bar.foo -> xyz" will be printed.
+ *         printf( "Found: bar.foo -> %.*s\n", ( int ) valueLength, value );
+ *     }
+ * @endcode
+ */
+/* @[declare_jsonindex_build] */
+JSONStatus_t JSONIndex_Build( const char * buf,
+                              size_t max,
+                              JSONIndexEntry_t * tape,
+                              size_t tapeLength,
+                              JSONIndex_t * outIndex );
+/* @[declare_jsonindex_build] */
+
+/**
+ * @brief Find a query below a tape entry and output the entry of its value.
+ *
+ * The query syntax is that of JSON_Search(), relative to the value at
+ * @p start; use 0 for the root.
+ *
+ * @param[in] index  An index from JSONIndex_Build().
+ * @param[in] start  Tape position of the value to search in.
+ * @param[in] query  The object keys and array indexes to search for.
+ * @param[in] queryLength  Length of the query.
+ * @param[out] outEntry  A pointer to receive the tape position of the value found.
+ *
+ * @return #JSONSuccess if the query is matched and the entry output;
+ * #JSONNullParameter if any pointer parameter is NULL;
+ * #JSONBadParameter if the query is empty, or any part is empty, or an index
+ * is too large, or start is not in the index;
+ * #JSONNotFound if the query has no match.
+ */
+/* @[declare_jsonindex_find] */
+JSONStatus_t JSONIndex_Find( const JSONIndex_t * index,
+                             size_t start,
+                             const char * query,
+                             size_t queryLength,
+                             size_t * outEntry );
+/* @[declare_jsonindex_find] */
+
+/**
+ * @brief Output the value of a tape entry, as JSON_SearchConst() would.
+ *
+ * @param[in] index  An index from JSONIndex_Build().
+ * @param[in] entry  Tape position, e.g., from JSONIndex_Find().
+ * @param[out] outValue  A pointer to receive the address of the value.
+ * @param[out] outValueLength  A pointer to receive the length of the value.
+ * @param[out] outType  The JSON-specific type of the value; may be NULL.
+ *
+ * @return #JSONSuccess if the value is output;
+ * #JSONNullParameter if any pointer parameter other than outType is NULL;
+ * #JSONBadParameter if entry is not in the index.
+ */
+/* @[declare_jsonindex_value] */
+JSONStatus_t JSONIndex_Value( const JSONIndex_t * index,
+                              size_t entry,
+                              const char ** outValue,
+                              size_t * outValueLength,
+                              JSONTypes_t * outType );
+/* @[declare_jsonindex_value] */
+
+/**
+ * @brief Same as JSON_SearchConst() on the indexed buffer, without re-parsing it.
+ *
+ * @param[in] index  An index from JSONIndex_Build().
+ * @param[in] query  The object keys and array indexes to search for.
+ * @param[in] queryLength  Length of the query.
+ * @param[out] outValue  A pointer to receive the address of the value found.
+ * @param[out] outValueLength  A pointer to receive the length of the value found.
+ * @param[out] outType  The JSON-specific type of the value; may be NULL.
+ *
+ * @return as JSONIndex_Find().
+ */
+/* @[declare_jsonindex_search] */
+JSONStatus_t JSONIndex_Search( const JSONIndex_t * index,
+                               const char * query,
+                               size_t queryLength,
+                               const char ** outValue,
+                               size_t * outValueLength,
+                               JSONTypes_t * outType );
+/* @[declare_jsonindex_search] */
+
+/**
+ * @brief Same as JSON_Iterate() over an indexed collection.
+ *
+ * @p start is the tape position of the collection (0 for the root, or an
+ * entry from JSONIndex_Find()) and @p next is set to 0 before the first
+ * call; both are updated by the function.
+ *
+ * @param[in] index  An index from JSONIndex_Build().
+ * @param[in,out] start  Tape position of the collection.
+ * @param[in,out] next  Tape position of the next member.
+ * @param[out] outPair  A pointer to receive the next key-value pair.
+ *
+ * @return #JSONSuccess if a value is output;
+ * #JSONNullParameter if any pointer parameter is NULL;
+ * #JSONBadParameter if start or next is not in the index;
+ * #JSONIllegalDocument if start is not a collection;
+ * #JSONNotFound if there are no further values in the collection.
+ */
+/* @[declare_jsonindex_iterate] */
+JSONStatus_t JSONIndex_Iterate( const JSONIndex_t * index,
+                                size_t * start,
+                                size_t * next,
+                                JSONPair_t * outPair );
+/* @[declare_jsonindex_iterate] */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef CORE_JSON_INDEX_H_ */
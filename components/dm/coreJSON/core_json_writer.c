@@ -0,0 +1,473 @@
+/*
+ * coreJSON v3.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_writer.c
+ * @brief Streaming JSON writer.
+ */
+
+#include <string.h>
+
+#include "core_json_writer.h"
+
+/** @cond DO_NOT_DOCUMENT */
+
+#define levelBit_( n )    ( ( uint32_t ) 1U << ( n ) )
+
+static void put( JSONWriter_t * w,
+                 const char * s,
+                 size_t n )
+{
+    if( w->status == JSONSuccess )
+    {
+        if( n <= ( w->size - w->length ) )
+        {
+            ( void ) memcpy( &w->buf[ w->length ], s, n );
+            w->length += n;
+        }
+        else
+        {
+            w->status = JSONBadParameter;
+        }
+    }
+}
+
+static void putChar( JSONWriter_t * w,
+                     char c )
+{
+    put( w, &c, 1U );
+}
+
+/**
+ * @brief Check that a value may go here and write the comma before an array element.
+ */
+static void beginValue( JSONWriter_t * w )
+{
+    if( w->status == JSONSuccess )
+    {
+        if( w->depth == 0U )
+        {
+            if( w->rootDone == true )
+            {
+                w->status = JSONIllegalDocument;
+            }
+        }
+        else if( ( w->object & levelBit_( w->depth - 1U ) ) != 0U )
+        {
+            /* in an object the comma went before the key */
+            if( w->keyDone == false )
+            {
+                w->status = JSONIllegalDocument;
+            }
+        }
+        else if( ( w->members & levelBit_( w->depth - 1U ) ) != 0U )
+        {
+            putChar( w, ',' );
+        }
+        else
+        {
+            /* first element */
+        }
+    }
+}
+
+static void endValue( JSONWriter_t * w )
+{
+    if( w->status == JSONSuccess )
+    {
+        if( w->depth == 0U )
+        {
+            w->rootDone = true;
+        }
+        else
+        {
+            w->members |= levelBit_( w->depth - 1U );
+            w->keyDone = false;
+        }
+    }
+}
+
+static void putEscaped( JSONWriter_t * w,
+                        const char * s,
+                        size_t n )
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t i, run = 0U;
+
+    putChar( w, '"' );
+
+    for( i = 0U; ( i < n ) && ( w->status == JSONSuccess ); i++ )
+    {
+        uint8_t c = ( uint8_t ) s[ i ];
+
+        /* plain bytes are copied in runs */
+        if( ( c != ( uint8_t ) '"' ) && ( c != ( uint8_t ) '\\' ) && ( c >= 0x20U ) )
+        {
+            continue;
+        }
+
+        char esc[ 6 ] = { '\\', 'u', '0', '0', '0', '0' };
+        size_t escLength = 2U;
+
+        put( w, &s[ run ], i - run );
+        run = i + 1U;
+
+        switch( c )
+        {
+            case '"':
+            case '\\':
+                esc[ 1 ] = ( char ) c;
+                break;
+
+            case '\b':
+                esc[ 1 ] = 'b';
+                break;
+
+            case '\f':
+                esc[ 1 ] = 'f';
+                break;
+
+            case '\n':
+                esc[ 1 ] = 'n';
+                break;
+
+            case '\r':
+                esc[ 1 ] = 'r';
+                break;
+
+            case '\t':
+                esc[ 1 ] = 't';
+                break;
+
+            default:
+                esc[ 4 ] = hex[ c >> 4U ];
+                esc[ 5 ] = hex[ c & 0x0FU ];
+                escLength = 6U;
+                break;
+        }
+
+        put( w, esc, escLength );
+    }
+
+    if( w->status == JSONSuccess )
+    {
+        put( w, &s[ run ], n - run );
+    }
+
+    putChar( w, '"' );
+}
+
+static JSONStatus_t openCollection( JSONWriter_t * w,
+                                    bool object )
+{
+    beginValue( w );
+
+    if( w->status == JSONSuccess )
+    {
+        if( w->depth >= JSON_WRITER_MAX_DEPTH )
+        {
+            w->status = JSONMaxDepthExceeded;
+        }
+        else
+        {
+            putChar( w, object ? '{' : '[' );
+        }
+    }
+
+    if( w->status == JSONSuccess )
+    {
+        if( object )
+        {
+            w->object |= levelBit_( w->depth );
+        }
+        else
+        {
+            w->object &= ~levelBit_( w->depth );
+        }
+
+        w->members &= ~levelBit_( w->depth );
+        w->depth++;
+        /* the pending key, if any, now belongs to this collection */
+        w->keyDone = false;
+    }
+
+    return w->status;
+}
+
+static JSONStatus_t closeCollection( JSONWriter_t * w,
+                                     bool object )
+{
+    if( w->status == JSONSuccess )
+    {
+        if( ( w->depth == 0U ) || ( w->keyDone == true ) ||
+            ( ( ( w->object & levelBit_( w->depth - 1U ) ) != 0U ) != object ) )
+        {
+            w->status = JSONIllegalDocument;
+        }
+        else
+        {
+            putChar( w, object ? '}' : ']' );
+        }
+    }
+
+    if( w->status == JSONSuccess )
+    {
+        w->depth--;
+        endValue( w );
+    }
+
+    return w->status;
+}
+
+static JSONStatus_t putValue( JSONWriter_t * w,
+                              const char * s,
+                              size_t n,
+                              bool escape )
+{
+    if( ( s == NULL ) && ( w->status == JSONSuccess ) )
+    {
+        w->status = JSONNullParameter;
+    }
+
+    beginValue( w );
+
+    if( escape == true )
+    {
+        putEscaped( w, s, n );
+    }
+    else
+    {
+        put( w, s, n );
+    }
+
+    endValue( w );
+
+    return w->status;
+}
+
+/** @endcond */
+
+/**
+ * See core_json_writer.h for docs.
+ */
+void JSONWriter_Init( JSONWriter_t * writer,
+                      char * buf,
+                      size_t size )
+{
+    if( writer != NULL )
+    {
+        ( void ) memset( writer, 0, sizeof( *writer ) );
+        writer->buf = buf;
+        writer->size = ( buf != NULL ) ? size : 0U;
+        writer->status = JSONSuccess;
+    }
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_OpenObject( JSONWriter_t * writer )
+{
+    return ( writer == NULL ) ? JSONNullParameter : openCollection( writer, true );
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_OpenArray( JSONWriter_t * writer )
+{
+    return ( writer == NULL ) ? JSONNullParameter : openCollection( writer, false );
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_CloseObject( JSONWriter_t * writer )
+{
+    return ( writer == NULL ) ? JSONNullParameter : closeCollection( writer, true );
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_CloseArray( JSONWriter_t * writer )
+{
+    return ( writer == NULL ) ? JSONNullParameter : closeCollection( writer, false );
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_Key( JSONWriter_t * writer,
+                             const char * key,
+                             size_t keyLength )
+{
+    JSONStatus_t ret = JSONNullParameter;
+
+    if( writer != NULL )
+    {
+        if( ( key == NULL ) && ( writer->status == JSONSuccess ) )
+        {
+            writer->status = JSONNullParameter;
+        }
+
+        if( writer->status == JSONSuccess )
+        {
+            if( ( writer->depth == 0U ) || ( writer->keyDone == true ) ||
+                ( ( writer->object & levelBit_( writer->depth - 1U ) ) == 0U ) )
+            {
+                writer->status = JSONIllegalDocument;
+            }
+            else if( ( writer->members & levelBit_( writer->depth - 1U ) ) != 0U )
+            {
+                putChar( writer, ',' );
+            }
+            else
+            {
+                /* first member */
+            }
+        }
+
+        putEscaped( writer, key, keyLength );
+        putChar( writer, ':' );
+
+        if( writer->status == JSONSuccess )
+        {
+            writer->keyDone = true;
+        }
+
+        ret = writer->status;
+    }
+
+    return ret;
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_String( JSONWriter_t * writer,
+                                const char * str,
+                                size_t strLength )
+{
+    return ( writer == NULL ) ? JSONNullParameter : putValue( writer, str, strLength, true );
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_Int( JSONWriter_t * writer,
+                             int64_t value )
+{
+    char digits[ 20 ];
+    size_t i = sizeof( digits );
+    uint64_t magnitude = ( value < 0 ) ? ( 0U - ( uint64_t ) value ) : ( uint64_t ) value;
+
+    do
+    {
+        i--;
+        digits[ i ] = ( char ) ( '0' + ( char ) ( magnitude % 10U ) );
+        magnitude /= 10U;
+    } while( magnitude > 0U );
+
+    if( value < 0 )
+    {
+        i--;
+        digits[ i ] = '-';
+    }
+
+    return ( writer == NULL ) ? JSONNullParameter :
+           putValue( writer, &digits[ i ], sizeof( digits ) - i, false );
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_Number( JSONWriter_t * writer,
+                                const char * number,
+                                size_t numberLength )
+{
+    return ( writer == NULL ) ? JSONNullParameter : putValue( writer, number, numberLength, false );
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_Bool( JSONWriter_t * writer,
+                              bool value )
+{
+    return ( writer == NULL ) ? JSONNullParameter :
+           putValue( writer, value ? "true" : "false", value ? 4U : 5U, false );
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_Null( JSONWriter_t * writer )
+{
+    return ( writer == NULL ) ? JSONNullParameter : putValue( writer, "null", 4U, false );
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_Raw( JSONWriter_t * writer,
+                             const char * json,
+                             size_t jsonLength )
+{
+    return ( writer == NULL ) ? JSONNullParameter : putValue( writer, json, jsonLength, false );
+}
+
+/**
+ * See core_json_writer.h for docs.
+ */
+JSONStatus_t JSONWriter_Finish( JSONWriter_t * writer,
+                                size_t * outLength )
+{
+    JSONStatus_t ret;
+
+    if( ( writer == NULL ) || ( outLength == NULL ) )
+    {
+        ret = JSONNullParameter;
+    }
+    else if( writer->status != JSONSuccess )
+    {
+        ret = writer->status;
+    }
+    else if( ( writer->depth > 0U ) || ( writer->rootDone == false ) )
+    {
+        ret = JSONPartial;
+    }
+    else
+    {
+        if( writer->length < writer->size )
+        {
+            writer->buf[ writer->length ] = '\0';
+        }
+
+        *outLength = writer->length;
+        ret = JSONSuccess;
+    }
+
+    return ret;
+}
@@ -0,0 +1,190 @@
+/*
+ * coreJSON v3.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_json_writer.h
+ * @brief Streaming JSON writer into a caller-provided buffer.
+ *
+ * Values are appended in document order; commas, colons and string escapes
+ * are inserted by the writer, so the output is valid JSON whenever
+ * JSONWriter_Finish() returns #JSONSuccess.  No heap is used.
+ *
+ * Errors are sticky: after the first failure (buffer full, a value where a
+ * key is due, too deep, ...) every call returns the same status and
+ * nothing more is written, so a sequence of calls may be checked once at
+ * the end.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *     char buf[ 64 ];
+ *     JSONWriter_t w;
+ *     size_t length;
+ *
+ *     JSONWriter_Init( &w, buf, sizeof( buf ) );
+ *     ( void ) JSONWriter_OpenObject( &w );
+ *     ( void ) JSONWriter_Key( &w, "id", 2 );
+ *     ( void ) JSONWriter_Int( &w, 42 );
+ *     ( void ) JSONWriter_Key( &w, "tags", 4 );
+ *     ( void ) JSONWriter_OpenArray( &w );
+ *     ( void ) JSONWriter_String( &w, "a\"b", 3 );
+ *     ( void ) JSONWriter_Null( &w );
+ *     ( void ) JSONWriter_CloseArray( &w );
+ *     ( void ) JSONWriter_CloseObject( &w );
+ *
+ *     if( JSONWriter_Finish( &w, &length ) == JSONSuccess )
+ *     {
+ *         // buf holds {"id":42,"tags":["a\"b",null]}
+ *     }
+ * @endcode
+ */
+
+#ifndef CORE_JSON_WRITER_H_
+#define CORE_JSON_WRITER_H_
+
+#include <stdint.h>
+
+#include "core_json.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @brief Deepest nesting the writer tracks (one bit per level).
+ */
+#define JSON_WRITER_MAX_DEPTH    32U
+
+/**
+ * @ingroup json_struct_types
+ * @brief Writer state; initialize with JSONWriter_Init().
+ */
+typedef struct
+{
+    char * buf;          /**< @brief Output buffer. */
+    size_t size;         /**< @brief Size of the output buffer. */
+    size_t length;       /**< @brief Bytes written so far. */
+    uint32_t object;     /**< @brief Bit n set: level n is an object. */
+    uint32_t members;    /**< @brief Bit n set: level n has a member, so the next needs a comma. */
+    uint8_t depth;       /**< @brief Open collections. */
+    bool keyDone;        /**< @brief A key was written; its value is next. */
+    bool rootDone;       /**< @brief The root value is complete. */
+    JSONStatus_t status; /**< @brief #JSONSuccess or the first error. */
+} JSONWriter_t;
+
+/**
+ * @brief Start writing into @p buf.
+ *
+ * @param[out] writer  The writer.
+ * @param[in] buf  The output buffer.
+ * @param[in] size  Size of the output buffer.
+ */
+void JSONWriter_Init( JSONWriter_t * writer,
+                      char * buf,
+                      size_t size );
+
+/**
+ * @brief Open an object or array; a value in its own right.
+ *
+ * @return #JSONSuccess;
+ * #JSONBadParameter if the buffer is full;
+ * #JSONIllegalDocument if a key is due or the root is already complete;
+ * #JSONMaxDepthExceeded beyond JSON_WRITER_MAX_DEPTH.
+ */
+JSONStatus_t JSONWriter_OpenObject( JSONWriter_t * writer );
+JSONStatus_t JSONWriter_OpenArray( JSONWriter_t * writer );
+
+/**
+ * @brief Close the innermost object or array.
+ *
+ * @return #JSONSuccess;
+ * #JSONBadParameter if the buffer is full;
+ * #JSONIllegalDocument if the innermost collection is of the other kind,
+ * none is open, or a key has no value.
+ */
+JSONStatus_t JSONWriter_CloseObject( JSONWriter_t * writer );
+JSONStatus_t JSONWriter_CloseArray( JSONWriter_t * writer );
+
+/**
+ * @brief Write an object key, escaped as needed.
+ *
+ * @return #JSONSuccess;
+ * #JSONBadParameter if the buffer is full;
+ * #JSONIllegalDocument if not directly inside an object or a key is pending.
+ */
+JSONStatus_t JSONWriter_Key( JSONWriter_t * writer,
+                             const char * key,
+                             size_t keyLength );
+
+/**
+ * @brief Write a value.
+ *
+ * JSONWriter_String() escapes quotes, backslashes and control characters;
+ * other bytes, including UTF-8 sequences, are copied.  JSONWriter_Number()
+ * copies @p number, which must be a valid JSON number; JSONWriter_Raw()
+ * copies @p json, which must be one valid JSON value.
+ *
+ * @return #JSONSuccess;
+ * #JSONBadParameter if the buffer is full;
+ * #JSONIllegalDocument if a key is due or the root is already complete.
+ */
+JSONStatus_t JSONWriter_String( JSONWriter_t * writer,
+                                const char * str,
+                                size_t strLength );
+JSONStatus_t JSONWriter_Int( JSONWriter_t * writer,
+                             int64_t value );
+JSONStatus_t JSONWriter_Number( JSONWriter_t * writer,
+                                const char * number,
+                                size_t numberLength );
+JSONStatus_t JSONWriter_Bool( JSONWriter_t * writer,
+                              bool value );
+JSONStatus_t JSONWriter_Null( JSONWriter_t * writer );
+JSONStatus_t JSONWriter_Raw( JSONWriter_t * writer,
+                             const char * json,
+                             size_t jsonLength );
+
+/**
+ * @brief Complete the document and output its length.
+ *
+ * A NUL is placed after the document when it fits; it is not counted.
+ *
+ * @param[in] writer  The writer.
+ * @param[out] outLength  A pointer to receive the document length.
+ *
+ * @return #JSONSuccess if one complete value was written;
+ * #JSONNullParameter if any pointer parameter is NULL;
+ * #JSONPartial if collections are still open or nothing was written;
+ * the first error otherwise.
+ */
+JSONStatus_t JSONWriter_Finish( JSONWriter_t * writer,
+                                size_t * outLength );
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef CORE_JSON_WRITER_H_ */
@@ -0,0 +1,299 @@
+/**
+ * @file norflash_bench.c
+ * @brief Single-granularity range erase vs. the SFDP erase planner
+ *
+ * The port below simulates a 4 MB SPI NOR in virtual time. Its SFDP basic
+ * parameter table advertises 4K/32K/64K erases with typical times taken
+ * from a W25Q datasheet (45/120/150 ms). An erase keeps WIP set for its
+ * typical time; erasing while WIP is set, without WEL or at a misaligned
+ * address is counted as a violation. The model erases for exactly the
+ * time its SFDP table reports, so the planner's estimate can be checked.
+ *
+ * The OTA slot being wiped does not start on a 64K boundary, so the planner
+ * has to step up through 4K and 32K erases before it can use 64K ones.
+ * A second chip whose 32K erase is slower than eight 4K erases checks that
+ * the planner skips erase types that do not pay off.
+ */
+
+#include "norflash.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_CAP    (4u * 1024 * 1024)
+#define SLOT_ADDR  0x011000u /* 68K: not 32K/64K aligned */
+#define SLOT_LEN   0x1E0000u /* 1920K */
+#define CMD_NS     2000.0    /* one short SPI command incl. driver work */
+#define TICK_MS    1         /* timer period for norflash_erase_poll() */
+
+typedef struct {
+    uint16_t t4k, t32k, t64k; /* typical erase times in SFDP DWORD10 */
+} sim_chip_t;
+
+static uint8_t s_mem[SIM_CAP];
+static uint8_t s_sfdp[0x80];
+static double s_now;        /* virtual time, ns */
+static double s_cpu;        /* CPU busy time, ns */
+static double s_busy_until; /* WIP clears at this time */
+static bool s_wel;
+static uint32_t s_violations;
+static uint32_t s_erases;
+static const sim_chip_t *s_chip;
+
+/* ==================== Device Model ==================== */
+
+/* DWORD10 typical time field: 5-bit count + 2-bit unit (1/16/128/1000 ms) */
+static uint32_t sfdp_time(uint32_t ms)
+{
+    /* Rounded to the unit, like a datasheet value squeezed into SFDP */
+    if (ms <= 32)
+        return ms - 1;
+    if (ms <= 32 * 16)
+        return (1u << 5) | ((ms + 8) / 16 - 1);
+    return (2u << 5) | ((ms + 64) / 128 - 1);
+}
+
+static uint32_t sfdp_time_ms(uint32_t code)
+{
+    static const uint32_t unit_ms[4] = { 1, 16, 128, 1000 };
+
+    return ((code & 0x1F) + 1) * unit_ms[code >> 5];
+}
+
+static void sfdp_put32(uint32_t off, uint32_t v)
+{
+    s_sfdp[off]     = (uint8_t)v;
+    s_sfdp[off + 1] = (uint8_t)(v >> 8);
+    s_sfdp[off + 2] = (uint8_t)(v >> 16);
+    s_sfdp[off + 3] = (uint8_t)(v >> 24);
+}
+
+static void sim_build_sfdp(const sim_chip_t *chip)
+{
+    const uint32_t tbl = 0x30;
+
+    memset(s_sfdp, 0xFF, sizeof(s_sfdp));
+    memcpy(s_sfdp, "SFDP", 4);
+    s_sfdp[4] = 6;    /* JESD216B */
+    s_sfdp[5] = 1;
+    s_sfdp[6] = 0;    /* one parameter header */
+    s_sfdp[8] = 0x00; /* basic flash parameter table */
+    s_sfdp[9] = 6;
+    s_sfdp[10] = 1;
+    s_sfdp[11] = 16;  /* DWORDs */
+    s_sfdp[12] = (uint8_t)tbl;
+    s_sfdp[13] = 0;
+    s_sfdp[14] = 0;
+
+    sfdp_put32(tbl + 0, 0xFFF120E5);                  /* 4K erase, 0x20 */
+    sfdp_put32(tbl + 4, SIM_CAP * 8 - 1);             /* density, bits */
+    sfdp_put32(tbl + 28, 0x520F200C);                 /* 4K 0x20, 32K 0x52 */
+    sfdp_put32(tbl + 32, 0x0000D810);                 /* 64K 0xD8 */
+    sfdp_put32(tbl + 36, 0x2 | sfdp_time(chip->t4k) << 4
+                         | sfdp_time(chip->t32k) << 11
+                         | sfdp_time(chip->t64k) << 18);
+    sfdp_put32(tbl + 40, 0x00000081);                 /* 256 B page */
+}
+
+static int sim_send_cmd(void *user_ctx, uint8_t cmd, uint32_t addr,
+                        const uint8_t *tx, uint8_t *rx, uint32_t len)
+{
+    uint32_t size = 0, ms = 0;
+
+    (void)user_ctx;
+    (void)tx;
+    s_now += CMD_NS;
+    s_cpu += CMD_NS;
+    switch (cmd) {
+    case 0x9F:
+        rx[0] = 0xEF;
+        rx[1] = 0x40;
+        rx[2] = 0x16;
+        return 0;
+    case 0x5A:
+        memcpy(rx, &s_sfdp[addr], len);
+        return 0;
+    case 0x05:
+        rx[0] = (uint8_t)((s_now < s_busy_until ? 0x01 : 0) | (s_wel ? 0x02 : 0));
+        return 0;
+    case 0x03:
+        memcpy(rx, &s_mem[addr], len);
+        return 0;
+    case 0x20:
+        size = 4096;
+        ms   = sfdp_time_ms(sfdp_time(s_chip->t4k));
+        break;
+    case 0x52:
+        size = 32 * 1024;
+        ms   = sfdp_time_ms(sfdp_time(s_chip->t32k));
+        break;
+    case 0xD8:
+        size = 64 * 1024;
+        ms   = sfdp_time_ms(sfdp_time(s_chip->t64k));
+        break;
+    default:
+        return 0;
+    }
+
+    if (!s_wel || s_now < s_busy_until || addr % size != 0 || addr + size > SIM_CAP) {
+        s_violations++;
+        return -1;
+    }
+    memset(&s_mem[addr], 0xFF, size);
+    s_wel        = false;
+    s_busy_until = s_now + ms * 1e6;
+    s_erases++;
+    return 0;
+}
+
+static void sim_write_enable(void *user_ctx)
+{
+    (void)user_ctx;
+    s_now += CMD_NS;
+    s_cpu += CMD_NS;
+    s_wel = true;
+}
+
+/* Blocking wait: the CPU spins on the status register until WIP clears */
+static void sim_wait_ready(void *user_ctx)
+{
+    (void)user_ctx;
+    if (s_now < s_busy_until) {
+        s_cpu += s_busy_until - s_now;
+        s_now = s_busy_until;
+    }
+}
+
+/* ==================== Helpers ==================== */
+
+static void sim_reset(norflash_t *flash, const sim_chip_t *chip)
+{
+    memset(s_mem, 0x00, sizeof(s_mem));
+    sim_build_sfdp(chip);
+    s_chip       = chip;
+    s_busy_until = 0;
+    s_wel        = false;
+    memset(flash, 0, sizeof(*flash));
+    flash->write_enable = sim_write_enable;
+    flash->wait_ready   = sim_wait_ready;
+    flash->send_cmd     = sim_send_cmd;
+}
+
+static int check_slot(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < SIM_CAP; i++) {
+        bool in = i >= SLOT_ADDR && i < SLOT_ADDR + SLOT_LEN;
+        if (s_mem[i] != (in ? 0xFF : 0x00))
+            return -1;
+    }
+    return s_violations == 0 ? 0 : -1;
+}
+
+static void report(const char *name, double t0, double c0)
+{
+    double t = s_now - t0;
+
+    printf("  %-30s %4u erases %9.1f ms  CPU %5.1f%%\n", name,
+           (unsigned)s_erases, t / 1e6, 100.0 * (s_cpu - c0) / t);
+    s_erases = 0;
+}
+
+/* What norflash_erase() did before the planner: one granularity, 4K first */
+static void erase_4k_only(norflash_t *flash, uint32_t addr, uint32_t len)
+{
+    for (; len > 0; addr += 4096, len -= 4096) {
+        flash->write_enable(flash->user_ctx);
+        flash->send_cmd(flash->user_ctx, flash->info.cmd_erase_4k, addr, NULL,
+                        NULL, 0);
+        flash->wait_ready(flash->user_ctx);
+    }
+}
+
+/* ==================== Benchmark ==================== */
+
+static int bench_chip(const char *name, const sim_chip_t *chip)
+{
+    norflash_t flash;
+    norflash_erase_plan_t plan;
+    double t0, c0, tick;
+    int ret;
+
+    printf("\n%s (SFDP): 4K %u ms, 32K %u ms, 64K %u ms; wipe %u K at 0x%06X\n",
+           name, (unsigned)sfdp_time_ms(sfdp_time(chip->t4k)),
+           (unsigned)sfdp_time_ms(sfdp_time(chip->t32k)),
+           (unsigned)sfdp_time_ms(sfdp_time(chip->t64k)),
+           (unsigned)(SLOT_LEN / 1024), (unsigned)SLOT_ADDR);
+
+    sim_reset(&flash, chip);
+    if (norflash_init(&flash) != 0 || !flash.info.support_sfdp
+        || flash.info.capacity != SIM_CAP || flash.info.erase_type_num != 3) {
+        printf("init failed\n");
+        return -1;
+    }
+
+    t0 = s_now;
+    c0 = s_cpu;
+    erase_4k_only(&flash, SLOT_ADDR, SLOT_LEN);
+    report("4K only (old norflash_erase)", t0, c0);
+    if (check_slot() != 0)
+        return -1;
+
+    sim_reset(&flash, chip);
+    norflash_init(&flash);
+    if (norflash_erase_plan(&flash, SLOT_ADDR, SLOT_LEN, &plan) != 0)
+        return -1;
+    printf("  plan: %u erases, expected %u ms\n", (unsigned)plan.ops,
+           (unsigned)plan.time_ms);
+    t0 = s_now;
+    c0 = s_cpu;
+    if (norflash_erase(&flash, SLOT_ADDR, SLOT_LEN) != 0)
+        return -1;
+    report("planned, blocking", t0, c0);
+    if (check_slot() != 0)
+        return -1;
+
+    /* Same plan driven from a 1 ms timer; the CPU is free between ticks */
+    sim_reset(&flash, chip);
+    norflash_init(&flash);
+    norflash_erase_plan(&flash, SLOT_ADDR, SLOT_LEN, &plan);
+    t0   = s_now;
+    c0   = s_cpu;
+    tick = s_now;
+    while ((ret = norflash_erase_poll(&flash, &plan)) == 1) {
+        tick += TICK_MS * 1e6;
+        if (s_now < tick)
+            s_now = tick;
+    }
+    if (ret != 0)
+        return -1;
+    report("planned, norflash_erase_poll", t0, c0);
+    return check_slot();
+}
+
+int main(void)
+{
+    static const sim_chip_t w25q = { 45, 120, 150 };
+    /* 32K erase slower than eight 4K erases: the planner must skip it */
+    static const sim_chip_t slow32k = { 10, 400, 150 };
+    norflash_t flash;
+    norflash_erase_plan_t plan;
+
+    if (bench_chip("W25Q-like", &w25q) != 0 || bench_chip("slow 32K", &slow32k) != 0) {
+        printf("\nverify failed (violations %u)\n", (unsigned)s_violations);
+        return 1;
+    }
+
+    /* Unaligned ranges are refused, nothing is erased */
+    sim_reset(&flash, &w25q);
+    norflash_init(&flash);
+    if (norflash_erase_plan(&flash, SLOT_ADDR + 512, 4096, &plan) == 0
+        || norflash_erase(&flash, SLOT_ADDR, 4096 + 512) == 0
+        || norflash_erase_plan(&flash, SIM_CAP - 4096, 8192, &plan) == 0
+        || s_erases != 0) {
+        printf("\nunaligned range accepted\n");
+        return 1;
+    }
+    printf("\nerased ranges verified, unaligned ranges refused\n");
+    return 0;
+}
@@ -14,15 +14,18 @@ typedef struct {
     uint8_t cmd_erase_64k;
     uint8_t cmd_chip_erase;
     bool support_qspi;
+    uint16_t time_4k_ms; // 典型擦除时间（数据手册）
+    uint16_t time_32k_ms;
+    uint16_t time_64k_ms;
 } norflash_param_t;
 
 static const norflash_param_t norflash_param_table[] = {
     // id,      capacity,      erase, page, read, write, 4k, 32k, 64k, chip,
-    // qspi
+    // qspi, t4k, t32k, t64k
     { 0xEF4017, 8 * 1024 * 1024, 64 * 1024, 256, 0x03, 0x02, 0x20, 0x52, 0xD8,
-      0xC7, true }, // W25Q64
+      0xC7, true, 45, 120, 150 }, // W25Q64
     { 0xC84016, 4 * 1024 * 1024, 64 * 1024, 256, 0x03, 0x02, 0x20, 0x52, 0xD8,
-      0x60, false }, // GD25Q32
+      0x60, false, 50, 150, 250 }, // GD25Q32
     // ...可扩展更多型号
 };
 #define PARAM_TABLE_SIZE \
@@ -36,41 +39,128 @@ static uint32_t norflash_read_id(norflash_t *flash)
     return (id_buf[0] << 16) | (id_buf[1] << 8) | id_buf[2];
 }
 
-// SFDP读取与解析（这里只演示基础部分）
+// 加入一种擦除类型，保持按粒度从大到小排列
+static void norflash_erase_type_add(norflash_info_t *info, uint32_t size,
+                                    uint8_t cmd, uint32_t time_ms)
+{
+    uint8_t i, n = info->erase_type_num;
+
+    if (size == 0 || cmd == 0 || n >= NORFLASH_ERASE_TYPE_MAX)
+        return;
+    for (i = 0; i < n; i++) {
+        if (info->erase_type[i].size == size)
+            return; // 同粒度只保留第一种
+    }
+    for (i = n; i > 0 && info->erase_type[i - 1].size < size; i--)
+        info->erase_type[i] = info->erase_type[i - 1];
+    info->erase_type[i].size    = size;
+    info->erase_type[i].cmd     = cmd;
+    info->erase_type[i].time_ms = time_ms;
+    info->erase_type_num        = n + 1;
+}
+
+// 由擦除类型表回填 4K/32K/64K 指令与最小擦除粒度
+static void norflash_erase_type_sync(norflash_info_t *info)
+{
+    info->cmd_erase_4k  = 0;
+    info->cmd_erase_32k = 0;
+    info->cmd_erase_64k = 0;
+    for (uint8_t i = 0; i < info->erase_type_num; i++) {
+        if (info->erase_type[i].size == 4096)
+            info->cmd_erase_4k = info->erase_type[i].cmd;
+        else if (info->erase_type[i].size == 32 * 1024)
+            info->cmd_erase_32k = info->erase_type[i].cmd;
+        else if (info->erase_type[i].size == 64 * 1024)
+            info->cmd_erase_64k = info->erase_type[i].cmd;
+    }
+    info->support_4k_erase  = (info->cmd_erase_4k != 0);
+    info->support_32k_erase = (info->cmd_erase_32k != 0);
+    info->support_64k_erase = (info->cmd_erase_64k != 0);
+    if (info->erase_type_num > 0)
+        info->erase_size = info->erase_type[info->erase_type_num - 1].size;
+}
+
+// SFDP 没给擦除时间时按粒度估算（4K 约 50ms，64K 约 150ms 量级）
+static uint32_t norflash_erase_time_guess(uint32_t size)
+{
+    if (size <= 4096)
+        return 50;
+    if (size <= 32 * 1024)
+        return 120;
+    return 150 * (size / (64 * 1024));
+}
+
+static uint32_t sfdp_dword(const uint8_t *tbl, uint32_t n)
+{
+    const uint8_t *p = tbl + (n - 1) * 4; // DWORD 编号从 1 开始
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// SFDP读取与解析（JESD216 基础参数表：容量、擦除类型及典型时间、页大小）
 static int norflash_sfdp_read(norflash_t *flash, norflash_info_t *info)
 {
-    uint8_t sfdp_header[8] = { 0 };
-    flash->send_cmd(flash->user_ctx, 0x5A, 0x000000, NULL, sfdp_header, 8);
+    // SFDP 头（8字节）+ 第一个参数头，即基础参数表头（8字节）
+    uint8_t sfdp_header[16] = { 0 };
+    flash->send_cmd(flash->user_ctx, 0x5A, 0x000000, NULL, sfdp_header, 16);
     if (memcmp(sfdp_header, "SFDP", 4) != 0)
         return -1; // 无SFDP
-    info->sfdp_major_rev = sfdp_header[6];
-    info->sfdp_minor_rev = sfdp_header[5];
-    // 基础参数表
-    uint32_t param_tbl_addr =
-        (sfdp_header[7] << 16) | (sfdp_header[4] << 8) | sfdp_header[3];
+    info->sfdp_minor_rev = sfdp_header[4];
+    info->sfdp_major_rev = sfdp_header[5];
+    // 基础参数表：长度（DWORD数）与地址
+    uint32_t param_tbl_len  = sfdp_header[11];
+    uint32_t param_tbl_addr = sfdp_header[12] | (sfdp_header[13] << 8)
+                              | (sfdp_header[14] << 16);
+    if (param_tbl_len < 9)
+        return -1; // 至少要到擦除类型（DWORD8~9）
+    if (param_tbl_len > 16)
+        param_tbl_len = 16;
     uint8_t param_tbl[64] = { 0 };
-    flash->send_cmd(flash->user_ctx, 0x5A, param_tbl_addr, NULL, param_tbl, 64);
+    flash->send_cmd(flash->user_ctx, 0x5A, param_tbl_addr, NULL, param_tbl,
+                    param_tbl_len * 4);
 
-    // 容量（JESD216 BFP Table: DWORD2 [bit 0~31]，bit单位）
-    uint32_t density = param_tbl[7] | (param_tbl[8] << 8) | (param_tbl[9] << 16)
-                       | (param_tbl[10] << 24);
+    // 容量（DWORD2，bit单位）
+    uint32_t density = sfdp_dword(param_tbl, 2);
     if (density & 0x80000000)
-        info->capacity = 1 << ((density & 0x7FFFFFFF) - 3);
+        info->capacity = 1u << ((density & 0x7FFFFFFF) - 3);
     else
-        info->capacity = (density + 1) / 8;
-    info->cmd_read          = 0x03;
-    info->cmd_write         = 0x02;
-    info->cmd_erase_4k      = param_tbl[28];
-    info->cmd_erase_32k     = param_tbl[29];
-    info->cmd_erase_64k     = param_tbl[30];
-    info->cmd_chip_erase    = param_tbl[31];
-    info->erase_size        = 4096;
-    info->page_size         = 256;
-    info->support_4k_erase  = (info->cmd_erase_4k != 0);
-    info->support_32k_erase = (info->cmd_erase_32k != 0);
-    info->support_64k_erase = (info->cmd_erase_64k != 0);
-    info->support_qspi      = false; // 如需进一步解析可扩展
-    info->support_sfdp      = true;
+        info->capacity = (density >> 3) + 1;
+
+    // 擦除类型（DWORD8~9：每种 1 字节 2^N 粒度 + 1 字节指令）
+    // 典型擦除时间（DWORD10，JESD216A 起：每种 7 位，低 5 位计数 + 高 2 位单位）
+    static const uint16_t unit_ms[4] = { 1, 16, 128, 1000 };
+    uint32_t dw10      = (param_tbl_len >= 10) ? sfdp_dword(param_tbl, 10) : 0;
+    info->erase_type_num = 0;
+    for (uint32_t i = 0; i < NORFLASH_ERASE_TYPE_MAX; i++) {
+        uint8_t exp = param_tbl[28 + i * 2];
+        uint8_t cmd = param_tbl[29 + i * 2];
+        if (exp == 0 || exp >= 32)
+            continue;
+        uint32_t size    = 1u << exp;
+        uint32_t time_ms = norflash_erase_time_guess(size);
+        if (dw10 != 0) {
+            uint32_t t = (dw10 >> (4 + i * 7)) & 0x7F;
+            time_ms    = ((t & 0x1F) + 1) * unit_ms[t >> 5];
+        }
+        norflash_erase_type_add(info, size, cmd, time_ms);
+    }
+    // 老器件可能只在 DWORD1 里声明 4K 擦除
+    uint32_t dw1 = sfdp_dword(param_tbl, 1);
+    if ((dw1 & 0x3) == 0x1)
+        norflash_erase_type_add(info, 4096, (dw1 >> 8) & 0xFF,
+                                norflash_erase_time_guess(4096));
+    if (info->erase_type_num == 0)
+        return -1;
+
+    info->cmd_read       = 0x03;
+    info->cmd_write      = 0x02;
+    info->cmd_chip_erase = 0xC7;
+    // 页大小（DWORD11 bit[7:4]，2^N）
+    info->page_size = 256;
+    if (param_tbl_len >= 11)
+        info->page_size = 1u << ((sfdp_dword(param_tbl, 11) >> 4) & 0xF);
+    norflash_erase_type_sync(info);
+    info->support_qspi = false; // 如需进一步解析可扩展
+    info->support_sfdp = true;
     return 0;
 }
 
@@ -88,10 +178,15 @@ static int norflash_lookup_table(uint32_t id, norflash_info_t *info)
             info->cmd_erase_32k     = norflash_param_table[i].cmd_erase_32k;
             info->cmd_erase_64k     = norflash_param_table[i].cmd_erase_64k;
             info->cmd_chip_erase    = norflash_param_table[i].cmd_chip_erase;
-            info->support_4k_erase  = (info->cmd_erase_4k != 0);
-            info->support_32k_erase = (info->cmd_erase_32k != 0);
-            info->support_64k_erase = (info->cmd_erase_64k != 0);
             info->support_qspi      = norflash_param_table[i].support_qspi;
+            info->erase_type_num    = 0;
+            norflash_erase_type_add(info, 64 * 1024, info->cmd_erase_64k,
+                                    norflash_param_table[i].time_64k_ms);
+            norflash_erase_type_add(info, 32 * 1024, info->cmd_erase_32k,
+                                    norflash_param_table[i].time_32k_ms);
+            norflash_erase_type_add(info, 4096, info->cmd_erase_4k,
+                                    norflash_param_table[i].time_4k_ms);
+            norflash_erase_type_sync(info);
             info->support_sfdp      = false;
             return 0;
         }
@@ -123,6 +218,104 @@ int norflash_init(norflash_t *flash)
     return -1;
 }
 
+// ===================== 擦除计划 =====================
+// 参与计划的擦除类型：从最小粒度往上，算出每种粒度一块的最短耗时；
+// 某种大块擦除若比拼出同样大小的小块擦除还慢，就不用它
+static uint8_t norflash_erase_mask(const norflash_info_t *info)
+{
+    uint8_t n    = info->erase_type_num;
+    uint8_t mask = 1u << (n - 1); // 最小粒度总要用
+    uint64_t best = info->erase_type[n - 1].time_ms;
+
+    for (int i = n - 2; i >= 0; i--) {
+        const norflash_erase_type_t *t = &info->erase_type[i];
+        uint64_t sub = best * (t->size / info->erase_type[i + 1].size);
+        if (t->time_ms <= sub) {
+            mask |= 1u << i;
+            best = t->time_ms;
+        } else {
+            best = sub;
+        }
+    }
+    return mask;
+}
+
+// 当前地址可用的最大擦除：地址对齐且不越过区间末尾
+static const norflash_erase_type_t *
+norflash_erase_pick(const norflash_info_t *info,
+                    const norflash_erase_plan_t *plan)
+{
+    for (uint8_t i = 0; i < info->erase_type_num; i++) {
+        const norflash_erase_type_t *t = &info->erase_type[i];
+        if ((plan->type_mask & (1u << i)) && plan->addr % t->size == 0
+            && plan->end - plan->addr >= t->size)
+            return t;
+    }
+    return NULL;
+}
+
+// 发出计划中的下一条擦除，不等待完成
+static void norflash_erase_issue(norflash_t *flash, norflash_erase_plan_t *plan)
+{
+    const norflash_erase_type_t *t = norflash_erase_pick(&flash->info, plan);
+
+    flash->write_enable(flash->user_ctx);
+    flash->send_cmd(flash->user_ctx, t->cmd, plan->addr, NULL, NULL, 0);
+    plan->addr += t->size;
+    plan->ops--;
+    plan->time_ms -= t->time_ms;
+}
+
+int norflash_erase_plan(norflash_t *flash, uint32_t addr, uint32_t len,
+                        norflash_erase_plan_t *plan)
+{
+    if (!flash || !flash->inited || !plan || flash->info.erase_type_num == 0)
+        return -1;
+    if (addr > flash->info.capacity || len > flash->info.capacity - addr)
+        return -1;
+    if (addr % flash->info.erase_size != 0 || len % flash->info.erase_size != 0)
+        return -1;
+
+    plan->addr      = addr;
+    plan->end       = addr + len;
+    plan->ops       = 0;
+    plan->time_ms   = 0;
+    plan->type_mask = norflash_erase_mask(&flash->info);
+
+    // 走一遍计划统计指令数和耗时
+    norflash_erase_plan_t walk = *plan;
+    while (walk.addr < walk.end) {
+        const norflash_erase_type_t *t = norflash_erase_pick(&flash->info, &walk);
+        walk.addr += t->size;
+        plan->ops++;
+        plan->time_ms += t->time_ms;
+    }
+    return 0;
+}
+
+int norflash_erase_poll(norflash_t *flash, norflash_erase_plan_t *plan)
+{
+    if (!flash || !flash->inited || !plan)
+        return -1;
+    if (norflash_is_busy(flash))
+        return 1;
+    if (plan->addr >= plan->end)
+        return 0;
+    norflash_erase_issue(flash, plan);
+    return 1;
+}
+
+int norflash_is_busy(norflash_t *flash)
+{
+    uint8_t sr = 0;
+
+    if (!flash || !flash->inited)
+        return -1;
+    // Read Status Register-1 指令（0x05），bit0 为 WIP
+    flash->send_cmd(flash->user_ctx, 0x05, 0, NULL, &sr, 1);
+    return sr & 0x01;
+}
+
 // ===================== 基础操作实现 =====================
 int norflash_read(norflash_t *flash, uint32_t addr, uint8_t *buf, uint32_t len)
 {
@@ -163,31 +356,13 @@ int norflash_write(norflash_t *flash, uint32_t addr, const uint8_t *buf,
 
 int norflash_erase(norflash_t *flash, uint32_t addr, uint32_t len)
 {
-    if (!flash || !flash->inited)
-        return -1;
-    uint32_t remain     = len;
-    uint32_t erase_size = 0;
-    uint8_t erase_cmd   = 0;
-
-    if (flash->info.support_4k_erase) {
-        erase_size = 4096;
-        erase_cmd  = flash->info.cmd_erase_4k;
-    } else if (flash->info.support_64k_erase) {
-        erase_size = 64 * 1024;
-        erase_cmd  = flash->info.cmd_erase_64k;
-    } else if (flash->info.support_32k_erase) {
-        erase_size = 32 * 1024;
-        erase_cmd  = flash->info.cmd_erase_32k;
-    } else {
-        return -1;
-    }
+    norflash_erase_plan_t plan;
 
-    while (remain > 0) {
-        flash->write_enable(flash->user_ctx);
-        flash->send_cmd(flash->user_ctx, erase_cmd, addr, NULL, NULL, 0);
+    if (norflash_erase_plan(flash, addr, len, &plan) != 0)
+        return -1;
+    while (plan.addr < plan.end) {
+        norflash_erase_issue(flash, &plan);
         flash->wait_ready(flash->user_ctx);
-        addr += erase_size;
-        remain -= erase_size;
     }
     return 0;
 }
@@ -4,6 +4,15 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#define NORFLASH_ERASE_TYPE_MAX 4 // SFDP 最多描述 4 种擦除类型
+
+// 一种擦除类型（扇区/块擦除）
+typedef struct {
+    uint32_t size;    // 擦除粒度（字节，2 的幂），0 表示无此类型
+    uint32_t time_ms; // 典型擦除时间
+    uint8_t cmd;      // 擦除指令
+} norflash_erase_type_t;
+
 // 芯片参数与特性结构体
 typedef struct {
     uint32_t id;
@@ -23,6 +32,9 @@ typedef struct {
     bool support_64k_erase;
     uint8_t sfdp_major_rev;
     uint8_t sfdp_minor_rev;
+    // 所有擦除类型，按粒度从大到小排列，erase_size 为最小粒度
+    norflash_erase_type_t erase_type[NORFLASH_ERASE_TYPE_MAX];
+    uint8_t erase_type_num;
 } norflash_info_t;
 
 // norflash 驱动对象，包含参数和底层操作
@@ -53,4 +65,23 @@ int norflash_chip_erase(norflash_t *flash);
 int norflash_sleep(norflash_t *flash);
 int norflash_wakeup(norflash_t *flash);
 
+// 区间擦除计划：按地址对齐和剩余长度混用 64K/32K/4K（或厂商自定义）擦除，
+// 指令数最少；若某种大块擦除比等量小块更慢则不用它，总耗时最短
+typedef struct {
+    uint32_t addr;     // 下一条擦除的地址
+    uint32_t end;      // 区间结束地址（不含）
+    uint32_t ops;      // 剩余擦除指令数
+    uint32_t time_ms;  // 剩余典型耗时
+    uint8_t type_mask; // 参与计划的擦除类型（erase_type 下标位图）
+} norflash_erase_plan_t;
+
+// 生成擦除计划，addr/len 须按最小擦除粒度对齐；plan->ops/time_ms 即预计指令数和耗时
+int norflash_erase_plan(norflash_t *flash, uint32_t addr, uint32_t len,
+                        norflash_erase_plan_t *plan);
+// 非阻塞推进：芯片忙返回 1；空闲则发出下一条擦除并返回 1；全部完成返回 0；出错返回 -1
+// 可在定时器或任务中周期调用，两次调用之间 CPU 可做其他事
+int norflash_erase_poll(norflash_t *flash, norflash_erase_plan_t *plan);
+// 读状态寄存器 WIP 位：忙返回 1，空闲返回 0
+int norflash_is_busy(norflash_t *flash);
+
 #endif // _NORFLASH_H_
\ No newline at end of file
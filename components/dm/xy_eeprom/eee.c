@@ -0,0 +1,625 @@
+#include "eee.h"
+#include <string.h>
+
+/**
+ * @file eee.c
+ * @brief Wear-levelled EEPROM emulation on page-erase flash
+ * @version 1.0
+ * @date 2025-10-22
+ *
+ * Page layout:
+ *   | header: magic(2) seq(2) erase_count(4), padded to max(unit, 8) |
+ *   | record slot 0 | record slot 1 | ...                            |
+ *
+ * Pages in use are ordered by seq; on mount they are replayed oldest first
+ * so the last record of an element wins. A page whose header is torn or
+ * missing but which is not blank is erased. Records that fail their CRC
+ * (torn programs) are skipped.
+ *
+ * A drained page needs no "obsolete" marker: every element whose latest
+ * record was in it has been rewritten to a newer page first, so if power
+ * is lost before the erase, its records are simply superseded on mount
+ * and the drain is resumed.
+ */
+
+#define EEE_PAGE_MAGIC    0x5AEE
+#define EEE_PAGE_ERASED   0
+#define EEE_PAGE_USED     1
+#define EEE_NONE          0xFF
+#define EEE_COUNT_UNKNOWN 0xFFFFFFFFu
+#define EEE_UNIT_MAX      16
+#define EEE_SCAN_CHUNK    64
+
+/* ==================== Internal Helper Functions ==================== */
+
+static uint32_t page_addr(const eee_handle_t *handle, uint8_t page)
+{
+    return handle->config.base + (uint32_t)page * handle->config.page_size;
+}
+
+static uint32_t slot_addr(const eee_handle_t *handle, uint8_t page,
+                          uint16_t slot)
+{
+    return page_addr(handle, page) + handle->header
+           + (uint32_t)slot * handle->config.write_unit;
+}
+
+static bool is_blank(const uint8_t *buf, size_t size)
+{
+    while (size--) {
+        if (*buf++ != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint8_t crc8_update(uint8_t crc, uint8_t byte)
+{
+    uint8_t i;
+
+    crc ^= byte;
+    for (i = 0; i < 8; i++) {
+        crc = (uint8_t)((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+    return crc;
+}
+
+/**
+ * @brief CRC-8 (poly 0x07) over element and data; the 0xFF init keeps an
+ *        all-zero slot from passing
+ */
+static uint8_t record_check(uint8_t element, const uint8_t *data,
+                            uint8_t size)
+{
+    uint8_t crc = crc8_update(0xFF, element);
+
+    while (size--) {
+        crc = crc8_update(crc, *data++);
+    }
+    return crc;
+}
+
+/**
+ * @brief Decode a record slot
+ * @return bool true if the record is intact and in range
+ */
+static bool record_parse(const eee_handle_t *handle, const uint8_t *rec,
+                         uint16_t *element)
+{
+    uint8_t esz = EEE_ELEMENT_SIZE(handle->config.write_unit);
+
+    *element = rec[0];
+    if (*element >= handle->config.element_count) {
+        return false;
+    }
+    return rec[1] == record_check(rec[0], rec + 2, esz);
+}
+
+static bool page_is_blank(const eee_handle_t *handle, uint8_t page)
+{
+    uint8_t buf[EEE_SCAN_CHUNK];
+    uint32_t addr = page_addr(handle, page);
+    uint32_t end = addr + handle->config.page_size;
+    uint32_t n;
+
+    while (addr < end) {
+        n = end - addr < sizeof(buf) ? end - addr : sizeof(buf);
+        if (handle->port.read(handle->port.ctx, addr, buf, n) != 0
+            || !is_blank(buf, n)) {
+            return false;
+        }
+        addr += n;
+    }
+    return true;
+}
+
+static eee_result_t page_erase(eee_handle_t *handle, uint8_t page)
+{
+    if (handle->port.erase(handle->port.ctx, page_addr(handle, page)) != 0) {
+        return EEE_ERROR_FLASH;
+    }
+    handle->erase_count[page]++;
+    handle->state[page] = EEE_PAGE_ERASED;
+    return EEE_OK;
+}
+
+static uint8_t erased_pages(const eee_handle_t *handle)
+{
+    uint8_t n = 0;
+    uint8_t i;
+
+    for (i = 0; i < handle->config.page_count; i++) {
+        n += handle->state[i] == EEE_PAGE_ERASED;
+    }
+    return n;
+}
+
+/**
+ * @brief Oldest page in use other than the active one
+ */
+static uint8_t oldest_page(const eee_handle_t *handle)
+{
+    uint16_t cur = handle->seq[handle->active];
+    uint16_t age, best_age = 0;
+    uint8_t best = EEE_NONE;
+    uint8_t i;
+
+    for (i = 0; i < handle->config.page_count; i++) {
+        if (i == handle->active || handle->state[i] != EEE_PAGE_USED) {
+            continue;
+        }
+        age = (uint16_t)(cur - handle->seq[i]);
+        if (best == EEE_NONE || age > best_age) {
+            best = i;
+            best_age = age;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Open the erased page with the lowest erase count as active page;
+ *        start draining the oldest page if that used the last erased one
+ */
+static eee_result_t page_open(eee_handle_t *handle)
+{
+    uint8_t hdr[EEE_UNIT_MAX > 8 ? EEE_UNIT_MAX : 8];
+    uint32_t count;
+    uint8_t page = EEE_NONE;
+    uint8_t i;
+
+    for (i = 0; i < handle->config.page_count; i++) {
+        if (handle->state[i] == EEE_PAGE_ERASED
+            && (page == EEE_NONE
+                || handle->erase_count[i] < handle->erase_count[page])) {
+            page = i;
+        }
+    }
+    if (page == EEE_NONE) {
+        return EEE_ERROR_NO_SPACE;
+    }
+
+    count = handle->erase_count[page];
+    memset(hdr, 0xFF, sizeof(hdr));
+    hdr[0] = (uint8_t)EEE_PAGE_MAGIC;
+    hdr[1] = (uint8_t)(EEE_PAGE_MAGIC >> 8);
+    hdr[2] = (uint8_t)handle->next_seq;
+    hdr[3] = (uint8_t)(handle->next_seq >> 8);
+    hdr[4] = (uint8_t)count;
+    hdr[5] = (uint8_t)(count >> 8);
+    hdr[6] = (uint8_t)(count >> 16);
+    hdr[7] = (uint8_t)(count >> 24);
+    if (handle->port.write(handle->port.ctx, page_addr(handle, page), hdr,
+                           handle->header)
+        != 0) {
+        return EEE_ERROR_FLASH;
+    }
+
+    handle->state[page] = EEE_PAGE_USED;
+    handle->seq[page] = handle->next_seq++;
+    handle->active = page;
+    handle->cursor = 0;
+
+    if (handle->drain == EEE_NONE && erased_pages(handle) == 0) {
+        handle->drain = oldest_page(handle);
+        handle->drain_slot = 0;
+    }
+    return EEE_OK;
+}
+
+/**
+ * @brief Program one record at the cursor, read it back, retry on the
+ *        next slot if the slot was damaged
+ */
+static eee_result_t record_append(eee_handle_t *handle, uint16_t element,
+                                  const uint8_t *data)
+{
+    uint8_t unit = handle->config.write_unit;
+    uint8_t rec[EEE_UNIT_MAX];
+    uint8_t back[EEE_UNIT_MAX];
+    uint8_t retry = 0;
+    uint32_t addr;
+    eee_result_t ret;
+
+    rec[0] = (uint8_t)element;
+    rec[1] = record_check(rec[0], data, unit - 2);
+    memcpy(rec + 2, data, unit - 2);
+
+    while (retry < EEE_WRITE_RETRIES) {
+        if (handle->cursor >= handle->slots) {
+            /* Cannot open a page while one is still being drained */
+            if (handle->drain != EEE_NONE) {
+                return EEE_ERROR_NO_SPACE;
+            }
+            ret = page_open(handle);
+            if (ret != EEE_OK) {
+                return ret;
+            }
+        }
+
+        addr = slot_addr(handle, handle->active, handle->cursor);
+        if (handle->port.write(handle->port.ctx, addr, rec, unit) == 0
+            && handle->port.read(handle->port.ctx, addr, back, unit) == 0
+            && memcmp(rec, back, unit) == 0) {
+            handle->cursor++;
+            handle->page_of[element] = handle->active;
+            return EEE_OK;
+        }
+
+        /* A blank slot can be retried in place; skip a damaged one */
+        if (handle->port.read(handle->port.ctx, addr, back, unit) != 0
+            || !is_blank(back, unit)) {
+            handle->cursor++;
+        }
+        retry++;
+    }
+    return EEE_ERROR_VERIFY;
+}
+
+/**
+ * @brief Move up to @p quota live records out of the page being drained,
+ *        erasing it once the scan reaches its end
+ */
+static eee_result_t drain_step(eee_handle_t *handle, uint16_t quota)
+{
+    uint8_t esz = EEE_ELEMENT_SIZE(handle->config.write_unit);
+    uint8_t rec[EEE_UNIT_MAX];
+    uint16_t element;
+    eee_result_t ret;
+
+    while (handle->drain != EEE_NONE) {
+        if (handle->drain_slot >= handle->slots) {
+            ret = page_erase(handle, handle->drain);
+            if (ret != EEE_OK) {
+                return ret;
+            }
+            handle->drain = EEE_NONE;
+            break;
+        }
+        if (quota == 0) {
+            break;
+        }
+
+        if (handle->port.read(handle->port.ctx,
+                              slot_addr(handle, handle->drain,
+                                        handle->drain_slot),
+                              rec, handle->config.write_unit)
+            != 0) {
+            return EEE_ERROR_FLASH;
+        }
+        if (is_blank(rec, handle->config.write_unit)) {
+            handle->drain_slot = handle->slots;
+            continue;
+        }
+        /* Rewrite from the shadow: later records in this page may be newer */
+        if (record_parse(handle, rec, &element)
+            && handle->page_of[element] == handle->drain) {
+            ret = record_append(handle, element,
+                                handle->shadow + (size_t)element * esz);
+            if (ret != EEE_OK) {
+                return ret;
+            }
+            handle->moves++;
+            quota--;
+        }
+        handle->drain_slot++;
+    }
+    return EEE_OK;
+}
+
+/**
+ * @brief Replay the records of one page into the shadow
+ * @return uint16_t First blank slot
+ */
+static uint16_t page_replay(eee_handle_t *handle, uint8_t page)
+{
+    uint8_t esz = EEE_ELEMENT_SIZE(handle->config.write_unit);
+    uint8_t rec[EEE_UNIT_MAX];
+    uint16_t element;
+    uint16_t slot;
+
+    for (slot = 0; slot < handle->slots; slot++) {
+        if (handle->port.read(handle->port.ctx, slot_addr(handle, page, slot),
+                              rec, handle->config.write_unit)
+                != 0
+            || is_blank(rec, handle->config.write_unit)) {
+            break;
+        }
+        if (record_parse(handle, rec, &element)) {
+            memcpy(handle->shadow + (size_t)element * esz, rec + 2, esz);
+            handle->page_of[element] = page;
+        }
+    }
+    return slot;
+}
+
+static void shadow_reset(eee_handle_t *handle)
+{
+    uint16_t count = handle->config.element_count;
+
+    memset(handle->shadow, 0xFF,
+           (size_t)count * EEE_ELEMENT_SIZE(handle->config.write_unit));
+    memset(handle->page_of, EEE_NONE, count);
+}
+
+/* ==================== Public API ==================== */
+
+/**
+ * @brief Mount the emulated EEPROM, formatting blank flash
+ */
+eee_result_t eee_init(eee_handle_t *handle, const eee_config_t *config,
+                      const eee_port_t *port, void *workspace,
+                      size_t workspace_size)
+{
+    uint8_t order[EEE_MAX_PAGES];
+    uint8_t hdr[8];
+    uint8_t used = 0;
+    uint32_t known_max = 0;
+    uint8_t unit, i, j;
+    eee_result_t ret;
+
+    if (handle == NULL || config == NULL || port == NULL || workspace == NULL
+        || port->read == NULL || port->write == NULL || port->erase == NULL) {
+        return EEE_ERROR_INVALID_PARAM;
+    }
+
+    unit = config->write_unit;
+    if ((unit != 4 && unit != 8 && unit != 16) || config->page_count < 2
+        || config->page_count > EEE_MAX_PAGES || config->element_count == 0
+        || config->element_count > EEE_MAX_ELEMENTS
+        || config->page_size % unit != 0 || config->base % unit != 0
+        || workspace_size
+               < EEE_WORKSPACE_SIZE(config->element_count, unit)) {
+        return EEE_ERROR_INVALID_PARAM;
+    }
+
+    memset(handle, 0, sizeof(*handle));
+    handle->config = *config;
+    handle->port = *port;
+    handle->header = unit > 8 ? unit : 8;
+    if (config->page_size <= handle->header) {
+        return EEE_ERROR_INVALID_PARAM;
+    }
+    handle->slots = (uint16_t)((config->page_size - handle->header) / unit);
+    /* A drain moves at most element_count records while each write moves
+     * EEE_WRITE_MOVES, so half a page always covers it */
+    if (config->element_count > handle->slots / 2) {
+        return EEE_ERROR_INVALID_PARAM;
+    }
+    handle->shadow = (uint8_t *)workspace;
+    handle->page_of = handle->shadow
+                      + (size_t)config->element_count * EEE_ELEMENT_SIZE(unit);
+    handle->drain = EEE_NONE;
+    shadow_reset(handle);
+
+    /* Classify pages; order used ones by seq */
+    for (i = 0; i < config->page_count; i++) {
+        if (port->read(port->ctx, page_addr(handle, i), hdr, sizeof(hdr))
+            != 0) {
+            return EEE_ERROR_FLASH;
+        }
+        handle->erase_count[i] = (uint32_t)hdr[4] | ((uint32_t)hdr[5] << 8)
+                                 | ((uint32_t)hdr[6] << 16)
+                                 | ((uint32_t)hdr[7] << 24);
+        if ((hdr[0] | (hdr[1] << 8)) == EEE_PAGE_MAGIC
+            && handle->erase_count[i] != EEE_COUNT_UNKNOWN) {
+            handle->state[i] = EEE_PAGE_USED;
+            handle->seq[i] = (uint16_t)(hdr[2] | (hdr[3] << 8));
+            if (handle->erase_count[i] > known_max) {
+                known_max = handle->erase_count[i];
+            }
+            for (j = used; j > 0
+                           && (int16_t)(handle->seq[order[j - 1]]
+                                        - handle->seq[i])
+                                  > 0;
+                 j--) {
+                order[j] = order[j - 1];
+            }
+            order[j] = i;
+            used++;
+        } else {
+            handle->erase_count[i] = EEE_COUNT_UNKNOWN;
+            handle->state[i] = EEE_PAGE_ERASED;
+        }
+    }
+
+    /* Counts of unformatted pages are unknown: assume the worst seen */
+    for (i = 0; i < config->page_count; i++) {
+        if (handle->erase_count[i] != EEE_COUNT_UNKNOWN) {
+            continue;
+        }
+        handle->erase_count[i] = known_max;
+        if (!page_is_blank(handle, i)) {
+            ret = page_erase(handle, i);
+            if (ret != EEE_OK) {
+                return ret;
+            }
+        }
+    }
+
+    handle->initialized = true;
+    if (used == 0) {
+        return page_open(handle);
+    }
+
+    for (i = 0; i < used; i++) {
+        handle->cursor = page_replay(handle, order[i]);
+    }
+    handle->active = order[used - 1];
+    handle->next_seq = (uint16_t)(handle->seq[handle->active] + 1);
+    if (erased_pages(handle) == 0) {
+        handle->drain = order[0];
+        handle->drain_slot = 0;
+    }
+    return EEE_OK;
+}
+
+/**
+ * @brief Erase all pages and start empty
+ */
+eee_result_t eee_format(eee_handle_t *handle)
+{
+    eee_result_t ret;
+    uint8_t i;
+
+    if (handle == NULL) {
+        return EEE_ERROR_INVALID_PARAM;
+    }
+    if (!handle->initialized) {
+        return EEE_ERROR_NOT_INIT;
+    }
+
+    for (i = 0; i < handle->config.page_count; i++) {
+        ret = page_erase(handle, i);
+        if (ret != EEE_OK) {
+            return ret;
+        }
+    }
+    shadow_reset(handle);
+    handle->drain = EEE_NONE;
+    return page_open(handle);
+}
+
+/**
+ * @brief Read from the RAM shadow
+ */
+eee_result_t eee_read(eee_handle_t *handle, uint32_t offset, void *data,
+                      size_t size)
+{
+    if (handle == NULL || data == NULL) {
+        return EEE_ERROR_INVALID_PARAM;
+    }
+    if (!handle->initialized) {
+        return EEE_ERROR_NOT_INIT;
+    }
+    if (offset > eee_size(handle) || size > eee_size(handle) - offset) {
+        return EEE_ERROR_OUT_OF_RANGE;
+    }
+
+    memcpy(data, handle->shadow + offset, size);
+    return EEE_OK;
+}
+
+/**
+ * @brief Write bytes; only elements whose content changes are programmed
+ */
+eee_result_t eee_write(eee_handle_t *handle, uint32_t offset,
+                       const void *data, size_t size)
+{
+    const uint8_t *src = (const uint8_t *)data;
+    uint8_t elem[EEE_UNIT_MAX];
+    uint8_t esz;
+    uint16_t element;
+    uint32_t pos, n;
+    eee_result_t ret;
+
+    if (handle == NULL || (data == NULL && size > 0)) {
+        return EEE_ERROR_INVALID_PARAM;
+    }
+    if (!handle->initialized) {
+        return EEE_ERROR_NOT_INIT;
+    }
+    if (offset > eee_size(handle) || size > eee_size(handle) - offset) {
+        return EEE_ERROR_OUT_OF_RANGE;
+    }
+
+    esz = EEE_ELEMENT_SIZE(handle->config.write_unit);
+    while (size > 0) {
+        element = (uint16_t)(offset / esz);
+        pos = offset % esz;
+        n = esz - pos < size ? esz - pos : (uint32_t)size;
+
+        memcpy(elem, handle->shadow + (size_t)element * esz, esz);
+        memcpy(elem + pos, src, n);
+        if (memcmp(elem, handle->shadow + (size_t)element * esz, esz) != 0) {
+            /* Keep the drain ahead of the active page filling up */
+            if (handle->drain != EEE_NONE) {
+                ret = drain_step(handle, EEE_WRITE_MOVES);
+                if (ret != EEE_OK) {
+                    return ret;
+                }
+            }
+            ret = record_append(handle, element, elem);
+            if (ret != EEE_OK) {
+                return ret;
+            }
+            memcpy(handle->shadow + (size_t)element * esz, elem, esz);
+            handle->records++;
+        }
+
+        offset += n;
+        src += n;
+        size -= n;
+    }
+    return EEE_OK;
+}
+
+/**
+ * @brief Background page transfer
+ */
+bool eee_service(eee_handle_t *handle)
+{
+    if (handle == NULL || !handle->initialized
+        || handle->drain == EEE_NONE) {
+        return false;
+    }
+    drain_step(handle, EEE_SERVICE_MOVES);
+    return handle->drain != EEE_NONE;
+}
+
+/**
+ * @brief Emulated EEPROM size in bytes
+ */
+uint32_t eee_size(const eee_handle_t *handle)
+{
+    if (handle == NULL || !handle->initialized) {
+        return 0;
+    }
+    return (uint32_t)handle->config.element_count
+           * EEE_ELEMENT_SIZE(handle->config.write_unit);
+}
+
+/**
+ * @brief Get statistics and wear-levelling state
+ */
+eee_result_t eee_get_stats(const eee_handle_t *handle, eee_stats_t *stats)
+{
+    uint8_t i;
+
+    if (handle == NULL || stats == NULL) {
+        return EEE_ERROR_INVALID_PARAM;
+    }
+    if (!handle->initialized) {
+        return EEE_ERROR_NOT_INIT;
+    }
+
+    stats->erase_min = handle->erase_count[0];
+    stats->erase_max = handle->erase_count[0];
+    for (i = 1; i < handle->config.page_count; i++) {
+        if (handle->erase_count[i] < stats->erase_min) {
+            stats->erase_min = handle->erase_count[i];
+        }
+        if (handle->erase_count[i] > stats->erase_max) {
+            stats->erase_max = handle->erase_count[i];
+        }
+    }
+    stats->records = handle->records;
+    stats->moves = handle->moves;
+    stats->free_slots = handle->slots - handle->cursor;
+    stats->erased_pages = erased_pages(handle);
+    stats->transfer_pending = handle->drain != EEE_NONE;
+    return EEE_OK;
+}
+
+/**
+ * @brief Get the erase count of a page
+ */
+uint32_t eee_get_erase_count(const eee_handle_t *handle, uint8_t page)
+{
+    if (handle == NULL || !handle->initialized
+        || page >= handle->config.page_count) {
+        return 0;
+    }
+    return handle->erase_count[page];
+}
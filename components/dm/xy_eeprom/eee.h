@@ -0,0 +1,191 @@
+#ifndef EEE_H
+#define EEE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file eee.h
+ * @brief Wear-levelled EEPROM emulation on page-erase flash
+ * @version 1.0
+ * @date 2025-10-22
+ *
+ * The emulated EEPROM is a byte array split into elements. Every update of
+ * an element appends one record of exactly one flash program unit:
+ *
+ *   | element (1 byte) | CRC-8 of element and data (1 byte) | data (unit - 2) |
+ *
+ * so a 32-bit unit carries 2 data bytes, a 64-bit unit 6 and a 128-bit
+ * unit 14. A torn program passes the CRC about once in 256 times. Reads
+ * are served from a RAM shadow. When the active page fills, the next page
+ * is the erased page with the lowest erase count; the oldest page is then
+ * drained a few records at a time by eee_service() (and by eee_write() if
+ * the drain falls behind), so no call copies a whole page.
+ */
+
+/* Configuration constants */
+#define EEE_MAX_PAGES        16   /**< Maximum number of pages */
+#define EEE_MAX_ELEMENTS     255  /**< Element index is 8 bits, 0xFF is blank */
+#ifndef EEE_SERVICE_MOVES
+#define EEE_SERVICE_MOVES    8    /**< Records moved per eee_service() call */
+#endif
+#ifndef EEE_WRITE_MOVES
+#define EEE_WRITE_MOVES      2    /**< Records moved per write while draining */
+#endif
+#ifndef EEE_WRITE_RETRIES
+#define EEE_WRITE_RETRIES    3    /**< Slots tried when read-back fails */
+#endif
+
+/** Bytes of data per element for a program unit */
+#define EEE_ELEMENT_SIZE(unit) ((unit) - 2)
+
+/** Workspace for eee_init(): data shadow plus one page byte per element */
+#define EEE_WORKSPACE_SIZE(count, unit) \
+    ((size_t)(count) * (EEE_ELEMENT_SIZE(unit) + 1))
+
+/* Error codes */
+typedef enum {
+    EEE_OK = 0,              /**< Operation successful */
+    EEE_ERROR_INVALID_PARAM, /**< Invalid parameter or configuration */
+    EEE_ERROR_OUT_OF_RANGE,  /**< Offset outside the emulated EEPROM */
+    EEE_ERROR_NOT_INIT,      /**< Not initialized */
+    EEE_ERROR_FLASH,         /**< Flash port reported a failure */
+    EEE_ERROR_VERIFY,        /**< Read-back mismatch on every retry */
+    EEE_ERROR_NO_SPACE,      /**< No slot left (drain could not keep up) */
+} eee_result_t;
+
+/* Flash port, addresses relative to the flash device */
+typedef struct {
+    int (*read)(void *ctx, uint32_t addr, void *data, size_t size);
+    int (*write)(void *ctx, uint32_t addr, const void *data, size_t size);
+    int (*erase)(void *ctx, uint32_t addr); /**< Erase page at @p addr */
+    void *ctx;
+} eee_port_t;                               /**< All return 0 on success */
+
+/* Configuration */
+typedef struct {
+    uint32_t base;          /**< Address of the first page */
+    uint32_t page_size;     /**< Erase page size in bytes */
+    uint8_t page_count;     /**< Pages used, 2..EEE_MAX_PAGES */
+    uint8_t write_unit;     /**< Program unit in bytes: 4, 8 or 16 */
+    uint16_t element_count; /**< Elements, at most half the slots of a page */
+} eee_config_t;
+
+/* Statistics */
+typedef struct {
+    uint32_t erase_min;      /**< Lowest page erase count */
+    uint32_t erase_max;      /**< Highest page erase count */
+    uint32_t records;        /**< Records written by eee_write() */
+    uint32_t moves;          /**< Records written by page transfer */
+    uint16_t free_slots;     /**< Free slots in the active page */
+    uint8_t erased_pages;    /**< Pages ready to be opened */
+    bool transfer_pending;   /**< A page is being drained */
+} eee_stats_t;
+
+/* Handle */
+typedef struct {
+    eee_config_t config;
+    eee_port_t port;
+    uint8_t *shadow;                        /**< Element data */
+    uint8_t *page_of;                       /**< Page of the latest record */
+    uint32_t erase_count[EEE_MAX_PAGES];
+    uint16_t seq[EEE_MAX_PAGES];
+    uint8_t state[EEE_MAX_PAGES];
+    uint16_t slots;                         /**< Record slots per page */
+    uint16_t cursor;                        /**< Next slot in active page */
+    uint16_t drain_slot;                    /**< Next slot to scan in drain */
+    uint16_t next_seq;
+    uint8_t header;                         /**< Page header bytes */
+    uint8_t active;
+    uint8_t drain;                          /**< Page being drained or 0xFF */
+    uint32_t records;
+    uint32_t moves;
+    bool initialized;
+} eee_handle_t;
+
+/**
+ * @brief Mount the emulated EEPROM, formatting blank flash
+ *
+ * Pages that are not blank and lack the eee header, such as pages in an
+ * older EEPROM emulation format, are erased: their data is not migrated.
+ * @param handle Pointer to handle
+ * @param config Pointer to configuration
+ * @param port Pointer to flash port
+ * @param workspace EEE_WORKSPACE_SIZE() bytes, owned by the handle
+ * @param workspace_size Size of @p workspace
+ * @return eee_result_t Operation result
+ */
+eee_result_t eee_init(eee_handle_t *handle, const eee_config_t *config,
+                      const eee_port_t *port, void *workspace,
+                      size_t workspace_size);
+
+/**
+ * @brief Erase all pages and start empty (every byte reads 0xFF)
+ * @param handle Pointer to handle
+ * @return eee_result_t Operation result
+ */
+eee_result_t eee_format(eee_handle_t *handle);
+
+/**
+ * @brief Read from the RAM shadow
+ * @param handle Pointer to handle
+ * @param offset Byte offset in the emulated EEPROM
+ * @param data Pointer to buffer for read data
+ * @param size Number of bytes to read
+ * @return eee_result_t Operation result
+ */
+eee_result_t eee_read(eee_handle_t *handle, uint32_t offset, void *data,
+                      size_t size);
+
+/**
+ * @brief Write bytes; only elements whose content changes are programmed
+ * @param handle Pointer to handle
+ * @param offset Byte offset in the emulated EEPROM
+ * @param data Pointer to data to write
+ * @param size Number of bytes to write
+ * @return eee_result_t Operation result
+ */
+eee_result_t eee_write(eee_handle_t *handle, uint32_t offset,
+                       const void *data, size_t size);
+
+/**
+ * @brief Background work: move up to EEE_SERVICE_MOVES records out of the
+ *        page being drained, and erase it once it is empty
+ * @param handle Pointer to handle
+ * @return bool true if a transfer is still pending
+ */
+bool eee_service(eee_handle_t *handle);
+
+/**
+ * @brief Emulated EEPROM size in bytes
+ * @param handle Pointer to handle
+ * @return uint32_t Size, 0 if not initialized
+ */
+uint32_t eee_size(const eee_handle_t *handle);
+
+/**
+ * @brief Get statistics and wear-levelling state
+ * @param handle Pointer to handle
+ * @param stats Pointer to buffer for statistics
+ * @return eee_result_t Operation result
+ */
+eee_result_t eee_get_stats(const eee_handle_t *handle, eee_stats_t *stats);
+
+/**
+ * @brief Get the erase count of a page
+ * @param handle Pointer to handle
+ * @param page Page index
+ * @return uint32_t Erase count, 0 if out of range
+ */
+uint32_t eee_get_erase_count(const eee_handle_t *handle, uint8_t page);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EEE_H */
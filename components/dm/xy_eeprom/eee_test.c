@@ -0,0 +1,480 @@
+#include <stdio.h>
+#include <string.h>
+#include "eflash.h"
+#include "eee.h"
+
+/**
+ * @file eee_test.c
+ * @brief Test program for the EEPROM emulation engine, on the eflash mock
+ * @version 1.0
+ * @date 2025-10-22
+ */
+
+/* Test configuration */
+#define TEST_PAGE_SIZE  512
+#define TEST_PAGE_COUNT 4
+#define TEST_ELEMENTS   40
+#define TEST_WS_SIZE    EEE_WORKSPACE_SIZE(TEST_ELEMENTS, 16)
+#define TORN_TRIALS     4000
+
+/* Color output for terminal */
+#define COLOR_GREEN  "\033[0;32m"
+#define COLOR_RED    "\033[0;31m"
+#define COLOR_YELLOW "\033[0;33m"
+#define COLOR_RESET  "\033[0m"
+
+static eflash_handle_t s_flash;
+static uint8_t s_ws[TEST_WS_SIZE];
+static uint8_t s_ref[TEST_ELEMENTS * 14];
+
+/* Power cut: programs counted from arming, 0 = off */
+static uint32_t s_programs;
+static uint32_t s_cut_at;
+static bool s_tear_random;
+static uint32_t s_rand = 1;
+
+static uint8_t rnd8(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return (uint8_t)(s_rand >> 16);
+}
+
+static void print_test_result(const char *test_name, bool passed)
+{
+    if (passed) {
+        printf(COLOR_GREEN "[PASS]" COLOR_RESET " %s\n", test_name);
+    } else {
+        printf(COLOR_RED "[FAIL]" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_separator(void)
+{
+    printf("========================================\n");
+}
+
+/* ==================== Flash Port ==================== */
+
+static int port_read(void *ctx, uint32_t addr, void *data, size_t size)
+{
+    if (s_cut_at != 0 && s_programs >= s_cut_at) {
+        return -1;
+    }
+    return eflash_read((eflash_handle_t *)ctx, addr, (uint8_t *)data, size)
+                   == EFLASH_OK
+               ? 0
+               : -1;
+}
+
+static int port_write(void *ctx, uint32_t addr, const void *data, size_t size)
+{
+    eflash_handle_t *flash = (eflash_handle_t *)ctx;
+    const uint8_t *src     = (const uint8_t *)data;
+
+    if (s_cut_at != 0) {
+        if (s_programs >= s_cut_at) {
+            return -1;
+        }
+        if (++s_programs == s_cut_at) {
+            /* Torn program: only the first half of the bytes land, or
+             * with s_tear_random the rest get a random half of their bits */
+            for (size_t i = 0; i < size; i++) {
+                if (i < size / 2) {
+                    flash->memory[addr + i] &= src[i];
+                } else if (s_tear_random) {
+                    flash->memory[addr + i] &= src[i] | rnd8();
+                }
+            }
+            return -1;
+        }
+    }
+    return eflash_write(flash, addr, src, size) == EFLASH_OK ? 0 : -1;
+}
+
+static int port_erase(void *ctx, uint32_t addr)
+{
+    if (s_cut_at != 0 && s_programs >= s_cut_at) {
+        return -1;
+    }
+    return eflash_erase_sector((eflash_handle_t *)ctx, addr) == EFLASH_OK ? 0
+                                                                          : -1;
+}
+
+static const eee_port_t s_port = { port_read, port_write, port_erase,
+                                   &s_flash };
+
+static bool flash_setup(eflash_write_unit_t unit)
+{
+    eflash_config_t config = { .page_size  = TEST_PAGE_SIZE,
+                               .page_count = TEST_PAGE_COUNT,
+                               .write_unit = unit,
+                               .auto_erase = false };
+
+    if (s_flash.initialized) {
+        eflash_deinit(&s_flash);
+    }
+    s_cut_at   = 0;
+    s_programs = 0;
+    return eflash_init(&s_flash, &config) == EFLASH_OK;
+}
+
+static bool eee_mount(eee_handle_t *eee, uint8_t unit, uint16_t elements)
+{
+    eee_config_t config = { .base          = 0,
+                            .page_size     = TEST_PAGE_SIZE,
+                            .page_count    = TEST_PAGE_COUNT,
+                            .write_unit    = unit,
+                            .element_count = elements };
+
+    return eee_init(eee, &config, &s_port, s_ws, sizeof(s_ws)) == EEE_OK;
+}
+
+static bool matches_ref(eee_handle_t *eee)
+{
+    uint8_t buf[sizeof(s_ref)];
+    uint32_t size = eee_size(eee);
+
+    return eee_read(eee, 0, buf, size) == EEE_OK
+           && memcmp(buf, s_ref, size) == 0;
+}
+
+/* ==================== Tests ==================== */
+
+/* Test 1: Blank flash formats and reads as erased */
+static bool test_init(void)
+{
+    eee_handle_t eee;
+    eee_stats_t stats;
+    uint8_t buf[8];
+
+    if (!flash_setup(EFLASH_WRITE_UNIT_32BIT)
+        || !eee_mount(&eee, 4, TEST_ELEMENTS)) {
+        return false;
+    }
+    if (eee_size(&eee) != TEST_ELEMENTS * 2
+        || eee_read(&eee, 0, buf, sizeof(buf)) != EEE_OK) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        if (buf[i] != 0xFF) {
+            return false;
+        }
+    }
+    return eee_get_stats(&eee, &stats) == EEE_OK
+           && stats.erased_pages == TEST_PAGE_COUNT - 1
+           && !stats.transfer_pending;
+}
+
+/* Write unaligned byte ranges, remount, compare */
+static bool check_unit(eflash_write_unit_t unit, uint16_t elements)
+{
+    eee_handle_t eee;
+    uint32_t size;
+
+    if (!flash_setup(unit) || !eee_mount(&eee, (uint8_t)unit, elements)) {
+        return false;
+    }
+    size = eee_size(&eee);
+    memset(s_ref, 0xFF, sizeof(s_ref));
+    for (uint32_t i = 0; i < 300; i++) {
+        uint32_t off = (i * 37) % size;
+        uint32_t len = 1 + i % 5;
+        uint8_t data[5];
+
+        if (off + len > size) {
+            len = size - off;
+        }
+        for (uint32_t j = 0; j < len; j++) {
+            data[j] = (uint8_t)(i + j);
+        }
+        memcpy(&s_ref[off], data, len);
+        if (eee_write(&eee, off, data, len) != EEE_OK || !matches_ref(&eee)) {
+            return false;
+        }
+    }
+    return eee_mount(&eee, (uint8_t)unit, elements) && matches_ref(&eee);
+}
+
+/* Test 2-4: Packing per write unit (at most half a page of slots) */
+static bool test_unit_32bit(void)
+{
+    return check_unit(EFLASH_WRITE_UNIT_32BIT, TEST_ELEMENTS);
+}
+
+static bool test_unit_64bit(void)
+{
+    return check_unit(EFLASH_WRITE_UNIT_64BIT, 24);
+}
+
+static bool test_unit_128bit(void)
+{
+    return check_unit(EFLASH_WRITE_UNIT_128BIT, 12);
+}
+
+/* Test 5: Rewriting the same content programs nothing */
+static bool test_unchanged(void)
+{
+    eee_handle_t eee;
+    eee_stats_t before, after;
+    uint8_t data[6] = { 1, 2, 3, 4, 5, 6 };
+
+    if (!flash_setup(EFLASH_WRITE_UNIT_64BIT)
+        || !eee_mount(&eee, 8, 24)
+        || eee_write(&eee, 3, data, sizeof(data)) != EEE_OK) {
+        return false;
+    }
+    eee_get_stats(&eee, &before);
+    if (eee_write(&eee, 3, data, sizeof(data)) != EEE_OK) {
+        return false;
+    }
+    eee_get_stats(&eee, &after);
+    return before.records == 2 && after.records == before.records;
+}
+
+/* Test 6: Page transfer is incremental and wear is levelled */
+static bool test_incremental_transfer(void)
+{
+    eee_handle_t eee;
+    eee_stats_t stats;
+    uint32_t moves;
+    uint32_t size;
+
+    if (!flash_setup(EFLASH_WRITE_UNIT_32BIT)
+        || !eee_mount(&eee, 4, TEST_ELEMENTS)) {
+        return false;
+    }
+    size = eee_size(&eee);
+    memset(s_ref, 0xFF, sizeof(s_ref));
+    for (uint32_t i = 0; i < 20000; i++) {
+        uint16_t value = (uint16_t)(i * 7);
+        uint32_t off   = (i % 3 == 0) ? 0 : 2 * (i % TEST_ELEMENTS);
+
+        memcpy(&s_ref[off], &value, 2);
+        eee_get_stats(&eee, &stats);
+        moves = stats.moves;
+        if (eee_write(&eee, off, &value, 2) != EEE_OK) {
+            return false;
+        }
+        eee_get_stats(&eee, &stats);
+        if (stats.moves - moves > EEE_WRITE_MOVES) {
+            return false;
+        }
+        if (i % 4 == 0) {
+            moves = stats.moves;
+            eee_service(&eee);
+            eee_get_stats(&eee, &stats);
+            if (stats.moves - moves > EEE_SERVICE_MOVES) {
+                return false;
+            }
+        }
+    }
+    if (!matches_ref(&eee)) {
+        return false;
+    }
+    eee_get_stats(&eee, &stats);
+    return stats.erase_min > 0 && stats.erase_max - stats.erase_min <= 1
+           && eee_mount(&eee, 4, TEST_ELEMENTS) && matches_ref(&eee)
+           && size == eee_size(&eee);
+}
+
+/* Test 7: Power cut at every program of a write sequence */
+static bool test_power_cut(void)
+{
+    eee_handle_t eee;
+    uint8_t before[sizeof(s_ref)];
+    uint8_t buf[sizeof(s_ref)];
+    uint32_t cut, size;
+    uint16_t value;
+    uint16_t element;
+
+    if (!flash_setup(EFLASH_WRITE_UNIT_32BIT)
+        || !eee_mount(&eee, 4, TEST_ELEMENTS)) {
+        return false;
+    }
+    size = eee_size(&eee);
+
+    /* Cuts land on records, page headers and transfer moves */
+    for (cut = 1; cut < 3000; cut++) {
+        element = (uint16_t)(cut % TEST_ELEMENTS);
+        value   = (uint16_t)cut;
+        if (eee_read(&eee, 0, before, size) != EEE_OK) {
+            return false;
+        }
+
+        s_programs = 0;
+        s_cut_at   = 1 + cut % 3;
+        eee_write(&eee, element * 2, &value, 2);
+        s_cut_at = 0;
+
+        if (!eee_mount(&eee, 4, TEST_ELEMENTS)
+            || eee_read(&eee, 0, buf, size) != EEE_OK) {
+            return false;
+        }
+        /* Only the element being written may change, to the new value */
+        memcpy(&before[element * 2], &buf[element * 2], 2);
+        if (memcmp(before, buf, size) != 0) {
+            return false;
+        }
+        if (memcmp(&buf[element * 2], &value, 2) != 0
+            && eee_write(&eee, element * 2, &value, 2) != EEE_OK) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Test 8: Torn records are rejected by their CRC */
+static bool test_torn_records(void)
+{
+    eee_handle_t eee;
+    uint8_t before[sizeof(s_ref)];
+    uint8_t buf[sizeof(s_ref)];
+    uint32_t trial, size, garbled = 0;
+    uint16_t value, element, e;
+
+    if (!flash_setup(EFLASH_WRITE_UNIT_32BIT)
+        || !eee_mount(&eee, 4, TEST_ELEMENTS)) {
+        return false;
+    }
+    size = eee_size(&eee);
+
+    /* The first program of each write is torn, record or transfer move */
+    for (trial = 0; trial < TORN_TRIALS; trial++) {
+        element = (uint16_t)(trial % TEST_ELEMENTS);
+        value   = (uint16_t)(trial * 40503u + 1);
+        if (eee_read(&eee, 0, before, size) != EEE_OK) {
+            return false;
+        }
+
+        s_programs    = 0;
+        s_cut_at      = 1;
+        s_tear_random = true;
+        eee_write(&eee, element * 2, &value, 2);
+        s_tear_random = false;
+        s_cut_at      = 0;
+
+        if (!eee_mount(&eee, 4, TEST_ELEMENTS)
+            || eee_read(&eee, 0, buf, size) != EEE_OK) {
+            return false;
+        }
+        /* Anything but the old content or the value written came from a
+         * torn record that passed its check */
+        for (e = 0; e < TEST_ELEMENTS; e++) {
+            if (memcmp(&buf[e * 2], &before[e * 2], 2) != 0
+                && (e != element || memcmp(&buf[e * 2], &value, 2) != 0)) {
+                garbled++;
+            }
+        }
+        if (eee_write(&eee, element * 2, &value, 2) != EEE_OK) {
+            return false;
+        }
+    }
+    /* CRC-8 lets about 1 in 256 through; a 4-bit check would be 1 in 16 */
+    return garbled * 64 <= TORN_TRIALS;
+}
+
+/* Test 9: Configuration checks */
+static bool test_invalid_config(void)
+{
+    eee_handle_t eee;
+    eee_config_t config = { .base          = 0,
+                            .page_size     = TEST_PAGE_SIZE,
+                            .page_count    = TEST_PAGE_COUNT,
+                            .write_unit    = 4,
+                            .element_count = 200 };
+
+    if (!flash_setup(EFLASH_WRITE_UNIT_32BIT)) {
+        return false;
+    }
+    /* More elements than half a page of slots */
+    if (eee_init(&eee, &config, &s_port, s_ws, sizeof(s_ws))
+        != EEE_ERROR_INVALID_PARAM) {
+        return false;
+    }
+    config.element_count = TEST_ELEMENTS;
+    config.write_unit    = 2;
+    if (eee_init(&eee, &config, &s_port, s_ws, sizeof(s_ws))
+        != EEE_ERROR_INVALID_PARAM) {
+        return false;
+    }
+    config.write_unit = 4;
+    config.page_count = 1;
+    if (eee_init(&eee, &config, &s_port, s_ws, sizeof(s_ws))
+        != EEE_ERROR_INVALID_PARAM) {
+        return false;
+    }
+    config.page_count = TEST_PAGE_COUNT;
+    return eee_init(&eee, &config, &s_port, s_ws, 8)
+           == EEE_ERROR_INVALID_PARAM;
+}
+
+/* Test 10: Out of range access */
+static bool test_out_of_range(void)
+{
+    eee_handle_t eee;
+    uint8_t data[4] = { 0 };
+
+    if (!flash_setup(EFLASH_WRITE_UNIT_32BIT)
+        || !eee_mount(&eee, 4, TEST_ELEMENTS)) {
+        return false;
+    }
+    return eee_write(&eee, eee_size(&eee) - 2, data, 4)
+               == EEE_ERROR_OUT_OF_RANGE
+           && eee_read(&eee, eee_size(&eee), data, 1)
+                  == EEE_ERROR_OUT_OF_RANGE;
+}
+
+/* Main test function */
+int main(void)
+{
+    printf(COLOR_YELLOW "\n");
+    printf("===========================================\n");
+    printf("   EEE Component Test Suite\n");
+    printf("===========================================\n");
+    printf(COLOR_RESET "\n");
+
+    int total_tests  = 0;
+    int passed_tests = 0;
+
+    /* Run all tests */
+    struct {
+        const char *name;
+        bool (*func)(void);
+    } tests[] = {
+        { "Test 1: Format Blank Flash", test_init },
+        { "Test 2: Packing (32-bit unit)", test_unit_32bit },
+        { "Test 3: Packing (64-bit unit)", test_unit_64bit },
+        { "Test 4: Packing (128-bit unit)", test_unit_128bit },
+        { "Test 5: Unchanged Write", test_unchanged },
+        { "Test 6: Incremental Transfer", test_incremental_transfer },
+        { "Test 7: Power Cut", test_power_cut },
+        { "Test 8: Torn Records", test_torn_records },
+        { "Test 9: Invalid Config", test_invalid_config },
+        { "Test 10: Out of Range", test_out_of_range },
+    };
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        total_tests++;
+        bool result = tests[i].func();
+        print_test_result(tests[i].name, result);
+        if (result) {
+            passed_tests++;
+        }
+    }
+
+    if (s_flash.initialized) {
+        eflash_deinit(&s_flash);
+    }
+
+    print_separator();
+    printf("\n");
+    printf("Test Summary: %d/%d tests passed\n", passed_tests, total_tests);
+
+    if (passed_tests == total_tests) {
+        printf(COLOR_GREEN "All tests PASSED!" COLOR_RESET "\n\n");
+        return 0;
+    } else {
+        printf(COLOR_RED "Some tests FAILED!" COLOR_RESET "\n\n");
+        return 1;
+    }
+}
@@ -4,268 +4,154 @@
 #include "eep_def.h"
 #include "eep_port.h"
 #include "eep.h"
+#include "eee.h"
 
-#define EEP_MAX_CYCLE    0x00FFFFFF
-#define EEP_CYCLE_MASK   0x00FFFFFF
-#define EEP_CYCLE_SHIFT  (0)
-#define EEP_ADDR_SIZE    (2)
 #define EEP_RW_ONE_WORLD (1)
 
-typedef struct {
-    uint16_t addr;
-    uint16_t value;
-} eep_data_t;
-
-typedef union {
-    struct {
-        uint8_t active_page;
-        uint8_t next_page;
-    } bits;
-    uint8_t data;
-} eep_page_t;
+/**
+ * eep 接口保留, 存储由 xy_eeprom/eee 引擎完成:
+ * 每个 uint16_t 数据是一个元素, 写入追加一条 32bit 记录, 读取走 RAM 影子,
+ * 页切换由 eee_service()/写入增量完成, 不再整页同步拷贝.
+ */
 
 typedef struct {
-    eep_page_t page;
-    uint16_t write_index;
-    uint16_t len;
-    uint16_t remain_len;
-    uint32_t _cycle;
+    eee_handle_t eee;
     uint16_t *data;
+    uint16_t len;
 } eep_cntlr_t;
 
+static eep_cntlr_t _eep_cntlr = { 0 };
+static uint8_t _eep_ws[EEE_WORKSPACE_SIZE(EEP_DATA_NUM, EEP_FLASH_WRITE_SIZE)];
 
-eep_error_t eep_search_valid_page(void);
-eep_error_t eep_search_valid_data(void);
-eep_error_t eep_page_shift(void);
+/* flash 接口按字访问, 中间经对齐的缓存 */
+static int eep_port_read(void *ctx, uint32_t addr, void *data, size_t size)
+{
+    uint32_t word;
+    size_t i;
 
-eep_cntlr_t _eep_cntlr   = { 0 };
-eep_header_t _eep_header = { 0 };
+    (void)ctx;
+    for (i = 0; i < size; i += 4) {
+        eep_flash_read_words(addr + i, &word, EEP_RW_ONE_WORLD);
+        memcpy((uint8_t *)data + i, &word, 4);
+    }
+    return 0;
+}
+
+static int eep_port_write(void *ctx, uint32_t addr, const void *data,
+                          size_t size)
+{
+    uint32_t word;
+    size_t i;
+
+    (void)ctx;
+    for (i = 0; i < size; i += 4) {
+        memcpy(&word, (const uint8_t *)data + i, 4);
+        if (eep_flash_write_words(addr + i, &word, EEP_RW_ONE_WORLD)
+            != EEP_RW_ONE_WORLD) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int eep_port_erase(void *ctx, uint32_t addr)
+{
+    (void)ctx;
+    return eep_flash_erase(addr, EEP_PAGE_SIZE) == 0 ? 0 : -1;
+}
 
 /**
- * @brief
- * -----------------------------------------------------------------------------
- *                \   Page1 valid    |    Page 1 transfer   |   Page 1 Erased  |
- * ----------------------------------------------------------------------------|
- *                |   Erase Page0
- * Page0 valid    |   Page0 valid
- *                |   Erase Page1
- *  ----------------------------------------------------------------------------
- *                |
- * Page0 transfer |
- *                |
- * -----------------------------------------------------------------------------
- *                |
- * Page0  Erased  |
- *                |
- * -----------------------------------------------------------------------------
+ * @brief 挂载并把保存的数据读到 data
  *
- * @param data
- * @param len
- * @return eep_status_t
+ * @param data 数据镜像, len 个 uint16_t
+ * @param len 数据个数, 不超过 EEP_DATA_NUM
+ * @return eep_error_t
  */
 eep_error_t eep_init(uint16_t *data, uint16_t len)
 {
-    _eep_cntlr.data = data;
-    _eep_cntlr.len  = len;
-
-    // 0. TODO
-    eep_flash_init();
+    static const eee_port_t port = { eep_port_read, eep_port_write,
+                                     eep_port_erase, NULL };
+    eee_config_t config;
 
-    // 1. find valid page
-    if (eep_search_valid_page() != eep_error_ok) {
-        return eep_error_no_valid_page;
-    }
-    // 2. get valid data
-    if (eep_search_valid_data() != eep_error_ok) {
-        return eep_error_no_valid_data;
+    if (data == NULL || len == 0 || len > EEP_DATA_NUM) {
+        return eep_error_over_data;
     }
 
-    // 3.
-    return eep_error_ok;
-}
-
-
-eep_error_t eep_search_valid_page(void)
-{
-    int8_t i;
-    int32_t ret;
-    uint32_t max_cycle = 0;
-    for (i = 0; i < EEP_PAGE_NUM; i++) {
-        ret = eep_flash_read_words(EEP_FLASH_BASE + i * EEP_PAGE_SIZE,
-                                   &_eep_header.data, EEP_RW_ONE_WORLD);
-        if (ret == EEP_RW_ONE_WORLD) {
-            // get valid header
-            if ((_eep_header.bits.status == eep_page_status_valid)
-                && (_eep_header.bits.cycle != EEP_CYCLE_MASK)) {
-                if (_eep_header.bits.cycle > max_cycle) {
-                    max_cycle                        = _eep_header.bits.cycle;
-                    _eep_header.bits.cycle           = max_cycle;
-                    _eep_cntlr.page.bits.active_page = i;
-                }
-            }
-        }
-    }
+    eep_flash_init();
 
-    /** there is no valid data */
-    if (_eep_header.bits.cycle == 0) {
+    config.base          = EEP_FLASH_BASE;
+    config.page_size     = EEP_PAGE_SIZE;
+    config.page_count    = EEP_PAGE_NUM;
+    config.write_unit    = EEP_FLASH_WRITE_SIZE;
+    config.element_count = len;
+    if (eee_init(&_eep_cntlr.eee, &config, &port, _eep_ws, sizeof(_eep_ws))
+        != EEE_OK) {
         return eep_error_no_valid_page;
-    } else {
-        return eep_error_ok;
     }
-}
 
-eep_error_t eep_search_valid_data(void)
-{
-    eep_data_t data;
-    uint16_t i;
-    for (i = 1; i < EEP_DATA_ADDR_MAX; i++) {
-        if (eep_flash_read_words(
-                EEP_FLASH_BASE
-                    + _eep_cntlr.page.bits.active_page * EEP_PAGE_SIZE
-                    + i * EEP_FLASH_WRITE_SIZE,
-                (uint32_t *)&data, EEP_RW_ONE_WORLD)) {
-            if (data.addr < _eep_cntlr.len) {
-                _eep_cntlr.data[data.addr] = data.value;
-            }
-        }
-    }
+    _eep_cntlr.data = data;
+    _eep_cntlr.len  = len;
+    eee_read(&_eep_cntlr.eee, 0, data, len * sizeof(uint16_t));
     return eep_error_ok;
 }
 
-
 int32_t eep_read_data(uint16_t addr, uint16_t *data, uint16_t len)
 {
-    int32_t ret = len;
-    if (addr >= _eep_cntlr.len) {
+    if (addr >= _eep_cntlr.len || len > _eep_cntlr.len - addr) {
         return eep_error_outoff_range;
     }
-
-    memcpy(data, &_eep_cntlr.data[addr], len * sizeof(uint16_t));
-
-    return ret;
-}
-
-int32_t eep_verify_write(uint32_t addr, const uint32_t *data, uint16_t len)
-{
-    int32_t ret   = len;
-    uint8_t retry = 0;
-    uint32_t verify_buf[EEP_FLASH_WORD_NUM];
-
-    while (retry < EEP_WRITE_RETRIES) {
-        if (eep_flash_write_words(addr, data, len) != ret) {
-            retry++;
-            continue;
-        }
-
-        if (eep_flash_read_words(addr, verify_buf, len) != ret) {
-            retry++;
-            continue;
-        }
-
-        if (memcmp(data, verify_buf, len * sizeof(uint32_t)) == 0) {
-            return ret;
-        }
-
-        retry++;
+    if (eee_read(&_eep_cntlr.eee, addr * sizeof(uint16_t), data,
+                 len * sizeof(uint16_t))
+        != EEE_OK) {
+        return eep_error_read_timeout;
     }
-
-    return eep_error_write_timeout;
+    return len;
 }
 
 int32_t eep_write_data(uint16_t addr, uint16_t *data, uint16_t len)
 {
-    uint32_t write_addr;
-    uint16_t i;
-    int32_t ret;
-    if (addr >= _eep_cntlr.len) {
+    if (addr >= _eep_cntlr.len || len > _eep_cntlr.len - addr) {
         return eep_error_outoff_range;
     }
-
-    // get current write index;
-    write_addr = EEP_FLASH_BASE
-                 + (_eep_cntlr.page.bits.active_page * EEP_PAGE_SIZE)
-                 + _eep_cntlr.write_index * EEP_FLASH_WRITE_SIZE;
-
-    for (i = 0; i < len; i++) {
-        if (_eep_cntlr.write_index == EEP_DATA_ADDR_MAX) {
-            eep_page_shift();
-            write_addr = EEP_FLASH_BASE
-                         + (_eep_cntlr.page.bits.active_page * EEP_PAGE_SIZE)
-                         + _eep_cntlr.write_index * EEP_FLASH_WRITE_SIZE;
-        }
-        eep_verify_write(write_addr, &_eep_header.data, EEP_RW_ONE_WORLD);
-        write_addr += 4;
-        _eep_cntlr.write_index += 1;
+    if (eee_write(&_eep_cntlr.eee, addr * sizeof(uint16_t), data,
+                  len * sizeof(uint16_t))
+        != EEE_OK) {
+        return eep_error_write_timeout;
     }
-
-
+    memcpy(&_eep_cntlr.data[addr], data, len * sizeof(uint16_t));
     return eep_error_ok;
 }
 
-eep_error_t eep_page_shift(void)
+/**
+ * @brief 空闲时调用, 增量完成页切换
+ *
+ * @return 1--仍有页在搬运
+ */
+int32_t eep_service(void)
 {
-    uint32_t write_addr;
-    uint32_t flash_data;
-    uint16_t i;
-
-    // get next page header data
-    write_addr =
-        EEP_FLASH_BASE + (_eep_cntlr.page.bits.next_page * EEP_PAGE_SIZE);
-
-    eep_flash_read_words(write_addr, &_eep_header.data, EEP_RW_ONE_WORLD);
-
-    // get header data check if need to erase
-    if (_eep_header.bits.status != eep_page_status_erase
-        || _eep_header.bits.cycle != EEP_CYCLE_MASK) {
-        // erase page
-        eep_flash_erase(write_addr, EEP_PAGE_SIZE);
-    }
-
-    _eep_header.bits.status = eep_page_status_transfer;
-
-    eep_flash_write_words(write_addr, &_eep_header.data, EEP_RW_ONE_WORLD);
-
-
-    write_addr += EEP_FLASH_WRITE_SIZE;
-
-    // move data to new page
-    for (i = 0; i < EEP_DATA_NUM; i++) {
-        flash_data = (i << 16) | _eep_cntlr.data[i];
-        eep_flash_write_words(
-            write_addr + i * 4, &flash_data, EEP_RW_ONE_WORLD);
-    }
-
-    // set header.status = valid
-    _eep_header.bits.status = eep_page_status_valid;
-    _eep_cntlr._cycle += 1;
-    _eep_header.bits.cycle = _eep_cntlr._cycle;
-    eep_flash_write_words(
-        write_addr, (uint32_t *)&_eep_header.data, EEP_RW_ONE_WORLD);
-
-    // erase current page
-    write_addr =
-        EEP_FLASH_BASE + (_eep_cntlr.page.bits.active_page * EEP_PAGE_SIZE);
-    eep_flash_erase(write_addr, EEP_PAGE_SIZE);
-
-    // set header.status = erase
-    _eep_cntlr.page.bits.active_page = _eep_cntlr.page.bits.next_page;
-    _eep_cntlr.page.bits.next_page   = _eep_cntlr.page.bits.active_page + 1;
-    if (_eep_cntlr.page.bits.next_page >= EEP_PAGE_NUM) {
-        _eep_cntlr.page.bits.next_page = 0;
-    }
-
-    _eep_cntlr.write_index = 1;
-
-    return eep_error_ok;
+    return eee_service(&_eep_cntlr.eee) ? 1 : 0;
 }
 
 uint32_t eep_get_cycle(void)
 {
-    return _eep_cntlr._cycle;
+    eee_stats_t stats;
+
+    if (eee_get_stats(&_eep_cntlr.eee, &stats) != EEE_OK) {
+        return 0;
+    }
+    return stats.erase_max;
 }
 
+/**
+ * @brief 擦除全部页, 数据恢复为 0xFFFF
+ */
 eep_error_t eep_reset(void)
 {
-    _eep_cntlr._cycle = 0;
+    if (eee_format(&_eep_cntlr.eee) != EEE_OK) {
+        return eep_error_block_write;
+    }
+    if (_eep_cntlr.data != NULL) {
+        memset(_eep_cntlr.data, 0xFF, _eep_cntlr.len * sizeof(uint16_t));
+    }
     return eep_error_ok;
 }
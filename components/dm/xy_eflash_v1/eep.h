@@ -1,12 +1,16 @@
 #ifndef _EEP_H_
 #define _EEP_H_
+#include <stdint.h>
+#include "eep_def.h"
 /**
  * limitation:
  * data len must  be 2*n Bytes
+ * storage: xy_eeprom/eee (add it to the include path)
  */
 eep_error_t eep_init(uint16_t *data, uint16_t len);
 int32_t eep_read_data(uint16_t offset, uint16_t *data, uint16_t len);
 int32_t eep_write_data(uint16_t offset, uint16_t *data, uint16_t len);
+int32_t eep_service(void);
 uint32_t eep_get_cycle(void);
 eep_error_t eep_reset(void);
 #endif
@@ -1,12 +0,0 @@
-/**
- * @file f2e_3.c
- * @author Eugene Chan (zerozap2020@gmail.com)
- * @brief
- * @version 0.1
- * @date 2023-01-12
- *
- * @copyright Copyright (c) ZeroZap 2023
- *
- * f2e_1 的改进版，适用于高性能 MCU, 执行速度快，因为访问有随机性，时间执行不固定了
- * 数据架构：
- */
\ No newline at end of file
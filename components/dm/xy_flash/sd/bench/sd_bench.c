@@ -0,0 +1,311 @@
+/**
+ * @file sd_bench.c
+ * @brief SD multi-block transfers and the block cache on the SPI card model
+ *
+ * 1. Raw: 1 MB written and read back one block per command (CMD24/CMD17),
+ *    in 32 KB multi-block transfers (ACMD23 + CMD25, CMD18) and as one
+ *    stream; the multi-block case again on a port without DMA.
+ * 2. File-system-like writes: a 256 KB log grown in 128-byte appends, each
+ *    a read-modify-write of its data block, with a FAT and a directory block
+ *    updated every 1 KB; straight to the card and through sd_cache.
+ * 3. The log read back 512 bytes at a time, uncached and with read-ahead.
+ * 4. Sequential cached reads up to the last block, where read-ahead must
+ *    stop at the card capacity.
+ *
+ * Every run is checked against a shadow image. Times are the model's virtual
+ * time: SPI bytes at the port path's cost plus card latency and busy.
+ */
+
+#include "sd.h"
+#include "sd_cache.h"
+#include "sd_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CARD_BLOCKS 8192 /* 4 MB */
+#define RAW_BLOCKS  2048 /* 1 MB */
+#define RAW_CHUNK   64   /* 32 KB */
+#define RAW_BASE    1024
+
+#define FAT_BLOCK   100
+#define DIR_BLOCK   200
+#define LOG_BASE    4096
+#define LOG_SIZE    (256 * 1024)
+#define LOG_APPEND  128
+#define META_EVERY  1024
+
+static uint8_t s_buf[RAW_BLOCKS * SD_BLOCK_SIZE];
+static uint8_t s_shadow[CARD_BLOCKS * SD_BLOCK_SIZE];
+static uint32_t s_rand = 1;
+
+static uint32_t rnd(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static void fill(uint8_t *p, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        p[i] = (uint8_t)rnd();
+}
+
+static int card_matches(void)
+{
+    return memcmp(sd_sim_mem(), s_shadow, sizeof(s_shadow)) == 0;
+}
+
+static int card_start(const sd_sim_timing_t *t)
+{
+    sd_sim_init(CARD_BLOCKS, t);
+    memset(s_shadow, 0xFF, sizeof(s_shadow));
+    return sd_init() == sd_error_ok && sd_card_type() == SD_TYPE_SDHC;
+}
+
+static double mbps(uint32_t bytes, uint64_t ns)
+{
+    return ns ? bytes * 1000.0 / ns : 0;
+}
+
+/* ==================== Raw ==================== */
+
+enum { RAW_SINGLE, RAW_MULTI, RAW_STREAM };
+
+static int raw_write(int mode)
+{
+    int32_t ret = sd_error_ok;
+
+    switch (mode) {
+    case RAW_SINGLE:
+        for (uint32_t i = 0; ret == sd_error_ok && i < RAW_BLOCKS; i++)
+            ret = sd_write_block(RAW_BASE + i, s_buf + i * SD_BLOCK_SIZE);
+        break;
+    case RAW_MULTI:
+        for (uint32_t i = 0; ret == sd_error_ok && i < RAW_BLOCKS; i += RAW_CHUNK)
+            ret = sd_write_blocks(RAW_BASE + i, s_buf + i * SD_BLOCK_SIZE, RAW_CHUNK);
+        break;
+    default:
+        ret = sd_write_start(RAW_BASE, RAW_BLOCKS);
+        for (uint32_t i = 0; ret == sd_error_ok && i < RAW_BLOCKS; i++)
+            ret = sd_write_next(s_buf + i * SD_BLOCK_SIZE);
+        if (sd_write_stop() != sd_error_ok)
+            ret = sd_error_unknown;
+        break;
+    }
+    return ret == sd_error_ok;
+}
+
+static int raw_read(int mode)
+{
+    int32_t ret = sd_error_ok;
+
+    switch (mode) {
+    case RAW_SINGLE:
+        for (uint32_t i = 0; ret == sd_error_ok && i < RAW_BLOCKS; i++)
+            ret = sd_read_block(RAW_BASE + i, s_buf + i * SD_BLOCK_SIZE);
+        break;
+    case RAW_MULTI:
+        for (uint32_t i = 0; ret == sd_error_ok && i < RAW_BLOCKS; i += RAW_CHUNK)
+            ret = sd_read_blocks(RAW_BASE + i, s_buf + i * SD_BLOCK_SIZE, RAW_CHUNK);
+        break;
+    default:
+        ret = sd_read_start(RAW_BASE);
+        for (uint32_t i = 0; ret == sd_error_ok && i < RAW_BLOCKS; i++)
+            ret = sd_read_next(s_buf + i * SD_BLOCK_SIZE);
+        if (sd_read_stop() != sd_error_ok)
+            ret = sd_error_unknown;
+        break;
+    }
+    return ret == sd_error_ok;
+}
+
+static int bench_raw(const char *name, int mode, const sd_sim_timing_t *t)
+{
+    sd_sim_stats_t st;
+    uint64_t t0, tw, tr;
+
+    if (!card_start(t))
+        return 0;
+    fill(s_buf, sizeof(s_buf));
+    memcpy(s_shadow + RAW_BASE * SD_BLOCK_SIZE, s_buf, sizeof(s_buf));
+
+    t0 = sd_sim_now();
+    if (!raw_write(mode))
+        return 0;
+    tw = sd_sim_now() - t0;
+    if (!card_matches())
+        return 0;
+
+    memset(s_buf, 0, sizeof(s_buf));
+    t0 = sd_sim_now();
+    if (!raw_read(mode))
+        return 0;
+    tr = sd_sim_now() - t0;
+    if (memcmp(s_buf, s_shadow + RAW_BASE * SD_BLOCK_SIZE, sizeof(s_buf)) != 0)
+        return 0;
+
+    sd_sim_get_stats(&st);
+    printf("  %-24s write %5.2f MB/s  read %5.2f MB/s  %5u cmds\n", name,
+           mbps(sizeof(s_buf), tw), mbps(sizeof(s_buf), tr), (unsigned)st.cmds);
+    return st.errors == 0;
+}
+
+/* ==================== File-system-like traffic ==================== */
+
+typedef struct {
+    int32_t (*read)(uint32_t block, uint8_t *data, uint32_t count);
+    int32_t (*write)(uint32_t block, const uint8_t *data, uint32_t count);
+    int32_t (*flush)(void);
+} blk_ops_t;
+
+static int32_t direct_flush(void)
+{
+    return sd_error_ok;
+}
+
+static const blk_ops_t s_direct = { sd_read_blocks, sd_write_blocks, direct_flush };
+static const blk_ops_t s_cached = { sd_cache_read, sd_cache_write, sd_cache_flush };
+
+/* Read-modify-write of part of one block */
+static int rmw(const blk_ops_t *ops, uint32_t block, uint32_t off, const uint8_t *p,
+               uint32_t len)
+{
+    uint8_t blk[SD_BLOCK_SIZE];
+
+    if (ops->read(block, blk, 1) != sd_error_ok)
+        return 0;
+    memcpy(blk + off, p, len);
+    memcpy(s_shadow + block * SD_BLOCK_SIZE + off, p, len);
+    return ops->write(block, blk, 1) == sd_error_ok;
+}
+
+static int log_append(const blk_ops_t *ops)
+{
+    uint8_t rec[LOG_APPEND];
+    uint8_t meta[16];
+
+    for (uint32_t pos = 0; pos < LOG_SIZE; pos += LOG_APPEND) {
+        fill(rec, sizeof(rec));
+        if (!rmw(ops, LOG_BASE + pos / SD_BLOCK_SIZE, pos % SD_BLOCK_SIZE, rec,
+                 sizeof(rec)))
+            return 0;
+        if ((pos + LOG_APPEND) % META_EVERY == 0) {
+            /* Cluster chain entry and the file size in its directory entry */
+            fill(meta, sizeof(meta));
+            if (!rmw(ops, FAT_BLOCK, (pos / META_EVERY) % 32 * 16, meta, sizeof(meta))
+                || !rmw(ops, DIR_BLOCK, 32, meta, 4))
+                return 0;
+        }
+    }
+    return ops->flush() == sd_error_ok;
+}
+
+static int log_read(const blk_ops_t *ops)
+{
+    uint8_t blk[SD_BLOCK_SIZE];
+
+    for (uint32_t b = 0; b < LOG_SIZE / SD_BLOCK_SIZE; b++) {
+        if (ops->read(LOG_BASE + b, blk, 1) != sd_error_ok
+            || memcmp(blk, s_shadow + (LOG_BASE + b) * SD_BLOCK_SIZE, SD_BLOCK_SIZE) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+static int bench_fs(const char *name, const blk_ops_t *ops, const sd_sim_timing_t *t)
+{
+    sd_cache_stats_t cs;
+    sd_sim_stats_t st;
+    uint64_t t0, tw, tr;
+    uint32_t cmds;
+
+    if (!card_start(t))
+        return 0;
+    sd_cache_init();
+
+    t0 = sd_sim_now();
+    if (!log_append(ops) || !card_matches())
+        return 0;
+    tw = sd_sim_now() - t0;
+    sd_sim_get_stats(&st);
+    cmds = st.cmds;
+
+    /* Cold read: nothing of the log left in the cache */
+    sd_cache_invalidate();
+    t0 = sd_sim_now();
+    if (!log_read(ops))
+        return 0;
+    tr = sd_sim_now() - t0;
+    sd_sim_get_stats(&st);
+    sd_cache_get_stats(&cs);
+
+    printf("  %-8s append %7.1f us/rec  %5u cmds  %5u blocks written   "
+           "read %5.2f MB/s  %4u cmds\n",
+           name, (double)tw / 1000 / (LOG_SIZE / LOG_APPEND), (unsigned)cmds,
+           (unsigned)st.blocks_written, mbps(LOG_SIZE, tr), (unsigned)(st.cmds - cmds));
+    return st.errors == 0;
+}
+
+/* ==================== Card end ==================== */
+
+static int bench_tail(const sd_sim_timing_t *t)
+{
+    uint8_t blk[SD_BLOCK_SIZE];
+    sd_sim_stats_t st;
+    uint32_t first = CARD_BLOCKS - SD_CACHE_READ_AHEAD / 2 - 1;
+
+    if (!card_start(t) || sd_card_blocks() != CARD_BLOCKS)
+        return 0;
+    fill(s_buf, (CARD_BLOCKS - first) * SD_BLOCK_SIZE);
+    memcpy(s_shadow + first * SD_BLOCK_SIZE, s_buf, (CARD_BLOCKS - first) * SD_BLOCK_SIZE);
+    if (sd_write_blocks(first, s_buf, CARD_BLOCKS - first) != sd_error_ok)
+        return 0;
+
+    sd_cache_init();
+    for (uint32_t b = first; b < CARD_BLOCKS; b++) {
+        if (sd_cache_read(b, blk, 1) != sd_error_ok
+            || memcmp(blk, s_shadow + b * SD_BLOCK_SIZE, SD_BLOCK_SIZE) != 0)
+            return 0;
+    }
+    sd_sim_get_stats(&st);
+    printf("  %u blocks up to the last one, capacity %u blocks, %u card errors\n",
+           (unsigned)(CARD_BLOCKS - first), (unsigned)sd_card_blocks(), (unsigned)st.errors);
+    return st.errors == 0;
+}
+
+int main(void)
+{
+    sd_sim_timing_t t;
+    sd_sim_timing_t polled;
+
+    sd_sim_default_timing(&t);
+    polled        = t;
+    polled.dma_ns = t.byte_ns;
+
+    printf("raw 1 MB, 25 MHz SPI\n");
+    if (!bench_raw("CMD24/CMD17 per block", RAW_SINGLE, &t)
+        || !bench_raw("CMD25/CMD18 32 KB", RAW_MULTI, &t)
+        || !bench_raw("one stream", RAW_STREAM, &t)
+        || !bench_raw("CMD25/CMD18, no DMA", RAW_MULTI, &polled))
+        goto fail;
+
+    printf("\n%u KB log in %u-byte appends, metadata every %u bytes\n",
+           (unsigned)(LOG_SIZE / 1024), (unsigned)LOG_APPEND, (unsigned)META_EVERY);
+    if (!bench_fs("direct", &s_direct, &t)
+        || !bench_fs("cached", &s_cached, &t))
+        goto fail;
+
+    printf("\nread-ahead at the end of the card\n");
+    if (!bench_tail(&t))
+        goto fail;
+
+    printf("\ncard image checked after every run\n");
+    sd_sim_free();
+    return 0;
+
+fail:
+    printf("check failed\n");
+    sd_sim_free();
+    return 1;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file sd_sim.h
+ * @brief SPI-mode SD card model behind the sd_spi_* port, for host benches
+ *
+ * The card answers byte by byte as on the wire (R1/R3/R7, data tokens, data
+ * response, busy, CMD12 inside CMD18, stop token inside CMD25, ACMD23), over
+ * a RAM image. Time is virtual: every byte costs what its port path costs
+ * (polled byte, FIFO burst or DMA), and the card adds access latency and
+ * programming busy from the timing below.
+ */
+
+#ifndef SD_SIM_H
+#define SD_SIM_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t byte_ns;        /* sd_spi_rw_byte(): polled, with software gap */
+    uint32_t burst_ns;       /* sd_spi_read/write_bytes(), per byte */
+    uint32_t dma_ns;         /* sd_spi_dma_*(), per byte (bus rate) */
+    uint32_t low_ns;         /* Any byte at SD_SPEED_LOW */
+    uint32_t access_ns;      /* CMD17/CMD18 to first data token */
+    uint32_t next_ns;        /* CMD18 gap between blocks */
+    uint32_t prog_single_ns; /* CMD24 busy */
+    uint32_t prog_multi_ns;  /* CMD25 busy per block */
+    uint32_t prog_erased_ns; /* CMD25 busy per block inside an ACMD23 count */
+    uint32_t stop_ns;        /* Busy after the stop token */
+    uint32_t stop_erased_ns; /* ... when the ACMD23 count was written */
+} sd_sim_timing_t;
+
+typedef struct {
+    uint32_t cmds;
+    uint32_t blocks_read;
+    uint32_t blocks_written;
+    uint32_t errors;         /* Illegal commands, bad addresses, lost bytes */
+} sd_sim_stats_t;
+
+void sd_sim_init(uint32_t blocks, const sd_sim_timing_t *timing);
+void sd_sim_free(void);
+uint64_t sd_sim_now(void);
+uint8_t *sd_sim_mem(void);
+void sd_sim_get_stats(sd_sim_stats_t *stats);
+void sd_sim_default_timing(sd_sim_timing_t *timing);
+
+#endif /* SD_SIM_H */
@@ -0,0 +1,427 @@
+/**
+ * @file sd_spi_sim.c
+ * @brief sd_spi_* port on an SPI-mode SD card model (replaces sd_spi.c)
+ */
+
+#include "sd_sim.h"
+#include "../sd.h"
+#include "../sd_spi.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    ST_IDLE,
+    ST_READ_WAIT,   /* Token due at data_at */
+    ST_READ_DATA,   /* 512 data + 2 CRC bytes out */
+    ST_WRITE_TOKEN, /* Waiting for FE / FC / FD */
+    ST_WRITE_DATA,  /* 512 data + 2 CRC bytes in */
+};
+
+typedef struct {
+    uint8_t *mem;
+    uint32_t blocks;
+    sd_sim_timing_t t;
+    sd_sim_stats_t stats;
+    uint64_t now;
+    uint8_t speed;
+    bool selected;
+    bool idle;           /* In idle state until ACMD41 completes */
+    bool app;            /* Last command was CMD55 */
+    uint8_t op_cond;     /* ACMD41 calls so far */
+    uint8_t cmd[6];
+    uint8_t cmd_len;
+    uint8_t out[8];      /* Response bytes queued */
+    uint8_t out_len, out_pos;
+    uint32_t busy_after; /* Busy starts once the queue drains */
+    uint64_t busy_until;
+    uint8_t state;
+    bool multi;
+    bool csd;            /* Data phase carries the CSD, not a block */
+    uint32_t block;
+    uint32_t pos;
+    uint64_t data_at;
+    uint32_t erase_count; /* ACMD23 for the next CMD25 */
+    uint32_t written;     /* Blocks of the current CMD25 */
+    uint32_t erase_start, erase_end;
+    uint8_t buf[SD_BLOCK_SIZE];
+    uint8_t reg[16];     /* CSD 2.0 */
+} sd_sim_t;
+
+static sd_sim_t s_card;
+
+void sd_sim_default_timing(sd_sim_timing_t *t)
+{
+    t->byte_ns        = 1000;  /* 25 MHz SPI, ~700 ns of polling per byte */
+    t->burst_ns       = 400;
+    t->dma_ns         = 320;
+    t->low_ns         = 20000; /* 400 kHz */
+    t->access_ns      = 300000;
+    t->next_ns        = 20000;
+    t->prog_single_ns = 1500000;
+    t->prog_multi_ns  = 150000;
+    t->prog_erased_ns = 100000;
+    t->stop_ns        = 1000000;
+    t->stop_erased_ns = 300000;
+}
+
+void sd_sim_init(uint32_t blocks, const sd_sim_timing_t *timing)
+{
+    free(s_card.mem);
+    memset(&s_card, 0, sizeof(s_card));
+    s_card.mem = malloc((size_t)blocks * SD_BLOCK_SIZE);
+    memset(s_card.mem, 0xFF, (size_t)blocks * SD_BLOCK_SIZE);
+    s_card.blocks = blocks;
+    /* CSD 2.0: C_SIZE (bits 69:48) = blocks / 1024 - 1 */
+    s_card.reg[0] = 0x40;
+    s_card.reg[7] = (uint8_t)(((blocks >> 10) - 1) >> 16 & 0x3F);
+    s_card.reg[8] = (uint8_t)(((blocks >> 10) - 1) >> 8);
+    s_card.reg[9] = (uint8_t)((blocks >> 10) - 1);
+    s_card.t = *timing;
+    s_card.idle = true;
+}
+
+void sd_sim_free(void)
+{
+    free(s_card.mem);
+    s_card.mem = NULL;
+}
+
+uint64_t sd_sim_now(void)
+{
+    return s_card.now;
+}
+
+uint8_t *sd_sim_mem(void)
+{
+    return s_card.mem;
+}
+
+void sd_sim_get_stats(sd_sim_stats_t *stats)
+{
+    *stats = s_card.stats;
+}
+
+/* ==================== Card ==================== */
+
+static void respond(const uint8_t *bytes, uint8_t len)
+{
+    s_card.out[0] = 0xFF; /* NCR */
+    memcpy(&s_card.out[1], bytes, len);
+    s_card.out_len = (uint8_t)(len + 1);
+    s_card.out_pos = 0;
+}
+
+static bool block_ok(uint32_t arg)
+{
+    if (arg < s_card.blocks)
+        return true;
+    s_card.stats.errors++;
+    return false;
+}
+
+static void execute(void)
+{
+    sd_sim_t *c = &s_card;
+    uint8_t cmd = c->cmd[0];
+    uint32_t arg = ((uint32_t)c->cmd[1] << 24) | ((uint32_t)c->cmd[2] << 16)
+                   | ((uint32_t)c->cmd[3] << 8) | c->cmd[4];
+    uint8_t r[5] = { c->idle ? SD_R1_IDLE_STATE : 0, 0, 0, 0, 0 };
+    bool app = c->app;
+
+    c->stats.cmds++;
+    c->app = false;
+    switch (cmd) {
+    case SD_CMD0_GO_IDLE_STATE:
+        c->idle = true;
+        c->op_cond = 0;
+        c->state = ST_IDLE;
+        r[0] = SD_R1_IDLE_STATE;
+        respond(r, 1);
+        return;
+    case SD_CMD8_SEND_IF_COND:
+        r[3] = (uint8_t)((arg >> 8) & 0x0F);
+        r[4] = (uint8_t)arg;
+        respond(r, 5);
+        return;
+    case SD_CMD55_APP_CMD:
+        c->app = true;
+        respond(r, 1);
+        return;
+    case SD_CMD58_READ_OCR:
+        r[1] = 0xC0; /* Powered up, CCS */
+        r[2] = 0xFF;
+        r[3] = 0x80;
+        respond(r, 5);
+        return;
+    case SD_CMD12_STOP_TRANSMISSION:
+        /* Stuff byte, NCR, R1; the data stream stops here */
+        c->state = ST_IDLE;
+        c->out[0] = 0xFF;
+        c->out[1] = 0xFF;
+        c->out[2] = r[0];
+        c->out_len = 3;
+        c->out_pos = 0;
+        return;
+    default:
+        break;
+    }
+
+    if (app && cmd == SD_ACMD41_SD_SEND_OP_COND) {
+        if (++c->op_cond >= 3)
+            c->idle = false;
+        r[0] = c->idle ? SD_R1_IDLE_STATE : 0;
+        respond(r, 1);
+        return;
+    }
+    if (app && cmd == SD_ACMD23_SET_WR_BLK_ERASE) {
+        c->erase_count = arg & 0x7FFFFF;
+        respond(r, 1);
+        return;
+    }
+    if (c->idle) {
+        r[0] |= SD_R1_ILLEGAL_COMMAND;
+        c->stats.errors++;
+        respond(r, 1);
+        return;
+    }
+
+    switch (cmd) {
+    case SD_CMD9_SEND_CSD:
+        c->multi = false;
+        c->csd = true;
+        c->state = ST_READ_WAIT;
+        c->data_at = c->now;
+        respond(r, 1);
+        return;
+    case SD_CMD16_SET_BLOCKLEN:
+    case SD_CMD13_SEND_STATUS:
+        respond(r, cmd == SD_CMD13_SEND_STATUS ? 2 : 1);
+        return;
+    case SD_CMD17_READ_BLOCK:
+    case SD_CMD18_READ_MULTIPLE:
+        if (!block_ok(arg)) {
+            r[0] = SD_R1_ADDRESS_ERROR;
+            respond(r, 1);
+            return;
+        }
+        c->multi = cmd == SD_CMD18_READ_MULTIPLE;
+        c->csd = false;
+        c->block = arg;
+        c->state = ST_READ_WAIT;
+        c->data_at = c->now + c->t.access_ns;
+        respond(r, 1);
+        return;
+    case SD_CMD24_WRITE_BLOCK:
+    case SD_CMD25_WRITE_MULTIPLE:
+        if (!block_ok(arg)) {
+            r[0] = SD_R1_ADDRESS_ERROR;
+            respond(r, 1);
+            return;
+        }
+        c->multi = cmd == SD_CMD25_WRITE_MULTIPLE;
+        if (!c->multi)
+            c->erase_count = 0;
+        c->block = arg;
+        c->written = 0;
+        c->state = ST_WRITE_TOKEN;
+        respond(r, 1);
+        return;
+    case SD_CMD32_ERASE_WR_BLK_START:
+        c->erase_start = arg;
+        respond(r, 1);
+        return;
+    case SD_CMD33_ERASE_WR_BLK_END:
+        c->erase_end = arg;
+        respond(r, 1);
+        return;
+    case SD_CMD38_ERASE:
+        if (c->erase_start <= c->erase_end && block_ok(c->erase_end)) {
+            memset(c->mem + (size_t)c->erase_start * SD_BLOCK_SIZE, 0xFF,
+                   (size_t)(c->erase_end - c->erase_start + 1) * SD_BLOCK_SIZE);
+            c->busy_after = c->t.prog_multi_ns;
+        }
+        respond(r, 1);
+        return;
+    default:
+        r[0] |= SD_R1_ILLEGAL_COMMAND;
+        c->stats.errors++;
+        respond(r, 1);
+        return;
+    }
+}
+
+static uint8_t card_xfer(uint8_t mosi)
+{
+    sd_sim_t *c = &s_card;
+    bool cmd_ok = c->state == ST_IDLE || c->state == ST_READ_WAIT
+                  || c->state == ST_READ_DATA;
+    uint8_t miso;
+
+    if (!c->selected)
+        return 0xFF;
+
+    /* Command bytes (CMD12 may come while data is going out) */
+    if (cmd_ok && (c->cmd_len > 0 || (mosi & 0xC0) == 0x40)) {
+        c->cmd[c->cmd_len++] = mosi;
+        if (c->cmd_len == 6) {
+            c->cmd_len = 0;
+            execute();
+        }
+        return 0xFF;
+    }
+
+    if (c->out_pos < c->out_len) {
+        miso = c->out[c->out_pos++];
+        if (c->out_pos == c->out_len && c->busy_after) {
+            c->busy_until = c->now + c->busy_after;
+            c->busy_after = 0;
+        }
+        return miso;
+    }
+    if (c->now < c->busy_until)
+        return 0x00;
+
+    switch (c->state) {
+    case ST_READ_WAIT:
+        if (c->now < c->data_at)
+            return 0xFF;
+        if (!c->csd && c->block >= c->blocks) {
+            /* CMD18 ran past the last block */
+            c->stats.errors++;
+            c->state = ST_IDLE;
+            return SD_DATA_ERROR_OUT_OF_RANGE;
+        }
+        c->state = ST_READ_DATA;
+        c->pos = 0;
+        return SD_TOKEN_START_BLOCK;
+    case ST_READ_DATA:
+        if (c->csd) {
+            if (c->pos < sizeof(c->reg))
+                return c->reg[c->pos++];
+            if (++c->pos < sizeof(c->reg) + 2)
+                return 0x00; /* CRC */
+            c->state = ST_IDLE;
+            return 0x00;
+        }
+        if (c->pos < SD_BLOCK_SIZE)
+            return c->mem[(size_t)c->block * SD_BLOCK_SIZE + c->pos++];
+        if (++c->pos < SD_BLOCK_SIZE + 2)
+            return 0x00; /* CRC */
+        c->stats.blocks_read++;
+        if (c->multi) {
+            c->block++;
+            c->state = ST_READ_WAIT;
+            c->data_at = c->now + c->t.next_ns;
+        } else {
+            c->state = ST_IDLE;
+        }
+        return 0x00;
+    case ST_WRITE_TOKEN:
+        if (mosi == SD_TOKEN_START_BLOCK || (c->multi && mosi == SD_TOKEN_START_MULTI)) {
+            c->state = ST_WRITE_DATA;
+            c->pos = 0;
+        } else if (c->multi && mosi == SD_TOKEN_STOP_TRAN) {
+            c->state = ST_IDLE;
+            c->out[0] = 0xFF; /* Nbr */
+            c->out_len = 1;
+            c->out_pos = 0;
+            c->busy_after = c->erase_count != 0 && c->written >= c->erase_count
+                                ? c->t.stop_erased_ns
+                                : c->t.stop_ns;
+            c->erase_count = 0;
+        } else if (mosi != 0xFF) {
+            c->stats.errors++;
+        }
+        return 0xFF;
+    case ST_WRITE_DATA:
+        if (c->pos < SD_BLOCK_SIZE) {
+            c->buf[c->pos++] = mosi;
+            return 0xFF;
+        }
+        if (++c->pos < SD_BLOCK_SIZE + 2)
+            return 0xFF;
+        /* CRC in: commit, data response, then busy */
+        if (c->block < c->blocks) {
+            memcpy(c->mem + (size_t)c->block * SD_BLOCK_SIZE, c->buf, SD_BLOCK_SIZE);
+            c->stats.blocks_written++;
+            c->out[0] = 0xE5;
+        } else {
+            c->stats.errors++;
+            c->out[0] = 0xED; /* Write error */
+        }
+        c->out_len = 1;
+        c->out_pos = 0;
+        if (!c->multi) {
+            c->busy_after = c->t.prog_single_ns;
+            c->state = ST_IDLE;
+        } else {
+            c->busy_after = c->written < c->erase_count ? c->t.prog_erased_ns
+                                                        : c->t.prog_multi_ns;
+            c->written++;
+            c->block++;
+            c->state = ST_WRITE_TOKEN;
+        }
+        return 0xFF;
+    default:
+        return 0xFF;
+    }
+}
+
+static uint8_t xfer(uint8_t mosi, uint32_t ns)
+{
+    s_card.now += s_card.speed == SD_SPEED_LOW ? s_card.t.low_ns : ns;
+    return card_xfer(mosi);
+}
+
+/* ==================== Port ==================== */
+
+int32_t sd_spi_init(uint8_t speed_mode)
+{
+    s_card.speed = speed_mode;
+    return 0;
+}
+
+int32_t sd_spi_deinit(void)
+{
+    return 0;
+}
+
+int32_t sd_spi_read_bytes(uint8_t *data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+        data[i] = xfer(0xFF, s_card.t.burst_ns);
+    return len;
+}
+
+int32_t sd_spi_write_bytes(uint8_t *data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+        xfer(data[i], s_card.t.burst_ns);
+    return len;
+}
+
+uint8_t sd_spi_rw_byte(uint8_t data)
+{
+    return xfer(data, s_card.t.byte_ns);
+}
+
+void sd_spi_cs(uint8_t level)
+{
+    s_card.selected = level == 0;
+    s_card.cmd_len = 0;
+}
+
+int32_t sd_spi_dma_read(uint8_t *data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+        data[i] = xfer(0xFF, s_card.t.dma_ns);
+    return len;
+}
+
+int32_t sd_spi_dma_write(const uint8_t *data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+        xfer(data[i], s_card.t.dma_ns);
+    return len;
+}
@@ -1,96 +1,420 @@
 #include "sd.h"
 #include "sd_spi.h"
 
+#include <stddef.h>
 
-int32_t sd_init(void)
+#define SD_NCR_MAX     10         // 命令到 R1 之间最多 8 字节, 多等两个
+#define SD_OCR_CCS     0x40000000 // OCR: 高容量卡, 按块寻址
+#define SD_ACMD41_HCS  0x40000000
+#define SD_DATA_RESP_MASK 0x1F
+#define SD_DATA_RESP_OK   0x05
+
+enum { SD_STREAM_NONE = 0, SD_STREAM_READ, SD_STREAM_WRITE };
+
+static uint8_t s_card_type;
+static uint8_t s_stream;
+static uint32_t s_card_blocks;
+
+static int32_t sd_wait_ready(uint32_t timeout);
+static int32_t sd_send_cmd(uint8_t cmd, uint32_t arg);
+static int32_t sd_send_acmd(uint8_t cmd, uint32_t arg);
+static int32_t sd_get_response(uint8_t *resp, uint8_t len);
+static int32_t sd_recv_block(uint8_t *data, uint16_t len);
+
+static void sd_select(void)
+{
+    sd_spi_cs(0);
+}
+
+static void sd_deselect(void)
+{
+    sd_spi_cs(1);
+    // 8 个时钟让卡释放 MISO
+    sd_spi_rw_byte(0xFF);
+}
+
+static uint32_t sd_block_arg(uint32_t block)
+{
+    // SDSC 按字节寻址
+    return s_card_type == SD_TYPE_SDHC ? block : block * SD_BLOCK_SIZE;
+}
+
+int32_t sd_go_idle(void)
+{
+    int32_t r1 = -1;
+
+    for (int i = 0; i < 10 && r1 != SD_RESP_IDLE; i++) {
+        r1 = sd_send_cmd(SD_CMD0_GO_IDLE_STATE, 0);
+    }
+    return r1 == SD_RESP_IDLE ? sd_error_ok : sd_error_timeout;
+}
+
+// CMD9 读 CSD 算块数, 读不到返回 0
+static uint32_t sd_read_capacity(void)
 {
+    uint8_t csd[16];
+    uint32_t c_size;
+    uint32_t shift;
+
+    if (sd_send_cmd(SD_CMD9_SEND_CSD, 0) != 0
+        || sd_recv_block(csd, sizeof(csd)) != sd_error_ok) {
+        return 0;
+    }
+    switch (csd[0] >> 6) {
+    case 0: // CSD 1.0 (SDSC): (C_SIZE + 1) << (C_SIZE_MULT + 2) 个 READ_BL_LEN 字节块
+        c_size = ((uint32_t)(csd[6] & 0x03) << 10) | ((uint32_t)csd[7] << 2) | (csd[8] >> 6);
+        shift  = (((csd[9] & 0x03) << 1) | (csd[10] >> 7)) + 2 + (csd[5] & 0x0F);
+        return shift >= 9 ? (c_size + 1) << (shift - 9) : 0;
+    case 1: // CSD 2.0 (SDHC/SDXC): (C_SIZE + 1) * 512 KB
+        c_size = ((uint32_t)(csd[7] & 0x3F) << 16) | ((uint32_t)csd[8] << 8) | csd[9];
+        return (c_size + 1) << 10;
+    default:
+        return 0;
+    }
+}
 
+int32_t sd_init(void)
+{
     uint8_t dummy = 0xff;
+    uint8_t resp[4];
+    uint32_t ocr;
+    uint32_t hcs = 0;
+    int32_t r1 = -1;
+    int32_t ret;
+
+    s_card_type   = 0;
+    s_card_blocks = 0;
+    s_stream      = SD_STREAM_NONE;
+    sd_spi_init(SD_SPEED_LOW);
 
     // Send 80 clock cycles to initialize the card and cs stay high
+    sd_spi_cs(1);
     for (int i = 0; i < 10; i++) {
         sd_spi_write_bytes(&dummy, 1);
     }
 
-    // Send CMD0
-    sd_send_cmd(SD_CMD0_GO_IDLE_STATE, 0);
-
-    // Wait for response
-    sd_match_response(SD_RESP_IDLE, 10);
+    sd_select();
+    ret = sd_go_idle();
+    if (ret != sd_error_ok) {
+        goto out;
+    }
 
     // Send CMD8 (After SDv2) for checking voltage range
-    sd_send_cmd(SD_CMD8_SEND_IF_COND, 0x1aa);
+    r1 = sd_send_cmd(SD_CMD8_SEND_IF_COND, 0x1aa);
+    if (r1 == SD_RESP_IDLE) {
+        sd_get_response(resp, 4);
+        if ((resp[2] & 0x0F) != 0x01 || resp[3] != 0xAA) {
+            ret = sd_error_cmd;
+            goto out;
+        }
+        hcs = SD_ACMD41_HCS;
+    }
 
-    // Wait for response
-    sd_match_response(SD_RESP_IDLE, 10);
+    // ACMD41 until the card leaves idle state
+    for (uint32_t i = 0; i < SD_TIMEOUT_INIT; i++) {
+        r1 = sd_send_acmd(SD_ACMD41_SD_SEND_OP_COND, hcs);
+        if (r1 != SD_RESP_IDLE) {
+            break;
+        }
+    }
+    if (r1 != 0) {
+        ret = r1 < 0 ? sd_error_timeout : sd_error_cmd;
+        goto out;
+    }
 
-    // need send cmd55 before send acmd41
-    sd_send_cmd(SD_CMD55_APP_CMD, 0);
-    // Send ACMD41  to initialize the card
-    sd_send_cmd(SD_ACMD41_SD_SEND_OP_COND, 0);
+    // Send CMD58 Read OCR, 32 Bits
+    s_card_type = SD_TYPE_SDSC;
+    if (hcs != 0 && sd_send_cmd(SD_CMD58_READ_OCR, 0) == 0) {
+        sd_get_response(resp, 4);
+        ocr = ((uint32_t)resp[0] << 24) | ((uint32_t)resp[1] << 16)
+              | ((uint32_t)resp[2] << 8) | resp[3];
+        if (ocr & SD_OCR_CCS) {
+            s_card_type = SD_TYPE_SDHC;
+        }
+    }
 
-    // Wait for response , if response is , then the card is initialized
-    sd_match_response(SD_RESP_IDLE, 10);
+    // Send CMD16, SDHC is fixed at 512
+    if (s_card_type == SD_TYPE_SDSC
+        && sd_send_cmd(SD_CMD16_SET_BLOCKLEN, SD_BLOCK_SIZE) != 0) {
+        s_card_type = 0;
+        ret = sd_error_cmd;
+        goto out;
+    }
+    s_card_blocks = sd_read_capacity();
+    ret = sd_error_ok;
 
-    // Send CMD58 Read OCR, 32 Bits
-    sd_send_cmd(SD_CMD58_READ_OCR, 0);
+out:
+    sd_deselect();
+    if (ret == sd_error_ok) {
+        sd_spi_init(SD_SPEED_HIGH);
+    }
+    return ret;
+}
+
+uint8_t sd_card_type(void)
+{
+    return s_card_type;
+}
 
-    // Wait for response
-    sd_match_response(SD_RESP_IDLE, 10);
+uint32_t sd_card_blocks(void)
+{
+    return s_card_blocks;
+}
 
-    // Send CMD16
-    sd_send_cmd(SD_CMD16_SET_BLOCKLEN, 512);
+/* ==================== 数据块 ==================== */
 
-    // Wait for response
-    sd_match_response(SD_RESP_IDLE, 10);
+// 等起始令牌, 收一块数据 (或 16 字节的 CSD) 和 CRC
+static int32_t sd_recv_block(uint8_t *data, uint16_t len)
+{
+    uint8_t crc[2];
+    uint8_t token = 0xFF;
 
-    return 0;
+    for (uint32_t i = 0; i < SD_TIMEOUT_READ && token == 0xFF; i++) {
+        token = sd_spi_rw_byte(0xFF);
+    }
+    if (token == 0xFF) {
+        return sd_error_timeout;
+    }
+    if (token != SD_TOKEN_START_BLOCK) {
+        return sd_error_data; // 数据错误令牌
+    }
+    if (sd_spi_dma_read(data, len) < 0) {
+        return sd_error_unknown;
+    }
+    sd_spi_read_bytes(crc, 2);
+    return sd_error_ok;
 }
 
+// 发令牌、一块数据和 CRC, 检查数据响应, 等编程完成
+static int32_t sd_send_block(uint8_t token, const uint8_t *data)
+{
+    uint8_t crc[2] = { 0xFF, 0xFF };
+    uint8_t resp;
+
+    sd_spi_rw_byte(token);
+    if (sd_spi_dma_write(data, SD_BLOCK_SIZE) < 0) {
+        return sd_error_unknown;
+    }
+    sd_spi_write_bytes(crc, 2);
+    resp = sd_spi_rw_byte(0xFF);
+    if ((resp & SD_DATA_RESP_MASK) != SD_DATA_RESP_OK) {
+        return sd_error_data;
+    }
+    return sd_wait_ready(SD_TIMEOUT_WRITE);
+}
 
 int32_t sd_read_block(uint32_t block_addr, uint8_t *data)
 {
+    int32_t ret;
+
+    if (data == NULL || s_card_type == 0 || s_stream != SD_STREAM_NONE) {
+        return sd_error_param;
+    }
+    sd_select();
+    ret = sd_send_cmd(SD_CMD17_READ_BLOCK, sd_block_arg(block_addr));
+    if (ret == 0) {
+        ret = sd_recv_block(data, SD_BLOCK_SIZE);
+    } else {
+        ret = ret < 0 ? sd_error_timeout : sd_error_cmd;
+    }
+    sd_deselect();
+    return ret;
 }
 
 
 int32_t sd_write_block(uint32_t block_addr, uint8_t *data)
 {
+    int32_t ret;
+
+    if (data == NULL || s_card_type == 0 || s_stream != SD_STREAM_NONE) {
+        return sd_error_param;
+    }
+    sd_select();
+    ret = sd_send_cmd(SD_CMD24_WRITE_BLOCK, sd_block_arg(block_addr));
+    if (ret == 0) {
+        sd_spi_rw_byte(0xFF); // Nwr
+        ret = sd_send_block(SD_TOKEN_START_BLOCK, data);
+    } else {
+        ret = ret < 0 ? sd_error_timeout : sd_error_cmd;
+    }
+    sd_deselect();
+    return ret;
 }
 
 int32_t sd_earase_block(uint32_t start_block, uint32_t end_block)
 {
+    int32_t ret = sd_error_cmd;
+
+    if (s_card_type == 0 || s_stream != SD_STREAM_NONE || end_block < start_block) {
+        return sd_error_param;
+    }
+    sd_select();
+    if (sd_send_cmd(SD_CMD32_ERASE_WR_BLK_START, sd_block_arg(start_block)) == 0
+        && sd_send_cmd(SD_CMD33_ERASE_WR_BLK_END, sd_block_arg(end_block)) == 0
+        && sd_send_cmd(SD_CMD38_ERASE, 0) == 0) {
+        // 擦除按块数计时, 每块按一次写超时算太长, 这里给 16 倍
+        ret = sd_wait_ready(SD_TIMEOUT_WRITE * 16);
+    }
+    sd_deselect();
+    return ret;
 }
 
+/* ==================== 多块流 ==================== */
 
-int32_t sd_wait_ready(uint32_t timeout)
+int32_t sd_read_start(uint32_t block)
 {
-    while (timeout--) {
-        if (sd_spi_rw_byte(0xFF) > 0) {
-            if (resp == 0xff) {
-                break;
-            }
-        }
+    int32_t r1;
+
+    if (s_card_type == 0 || s_stream != SD_STREAM_NONE) {
+        return sd_error_param;
     }
-    return 0;
+    sd_select();
+    r1 = sd_send_cmd(SD_CMD18_READ_MULTIPLE, sd_block_arg(block));
+    if (r1 != 0) {
+        sd_deselect();
+        return r1 < 0 ? sd_error_timeout : sd_error_cmd;
+    }
+    s_stream = SD_STREAM_READ;
+    return sd_error_ok;
 }
 
-int32_t sd_go_idle(void)
+int32_t sd_read_next(uint8_t *data)
+{
+    if (data == NULL || s_stream != SD_STREAM_READ) {
+        return sd_error_param;
+    }
+    return sd_recv_block(data, SD_BLOCK_SIZE);
+}
+
+int32_t sd_read_stop(void)
+{
+    int32_t ret;
+
+    if (s_stream != SD_STREAM_READ) {
+        return sd_error_param;
+    }
+    // CMD12 打断正在发的下一块, R1 之后可能还有一段忙
+    ret = sd_send_cmd(SD_CMD12_STOP_TRANSMISSION, 0);
+    ret = ret < 0 ? sd_error_timeout : sd_wait_ready(SD_TIMEOUT_READ);
+    sd_deselect();
+    s_stream = SD_STREAM_NONE;
+    return ret;
+}
+
+int32_t sd_write_start(uint32_t block, uint32_t count_hint)
+{
+    int32_t r1;
+
+    if (s_card_type == 0 || s_stream != SD_STREAM_NONE) {
+        return sd_error_param;
+    }
+    sd_select();
+    // 预擦除提示只是优化, 卡不认也照常写
+    if (count_hint > 1) {
+        sd_send_acmd(SD_ACMD23_SET_WR_BLK_ERASE, count_hint & 0x7FFFFF);
+    }
+    r1 = sd_send_cmd(SD_CMD25_WRITE_MULTIPLE, sd_block_arg(block));
+    if (r1 != 0) {
+        sd_deselect();
+        return r1 < 0 ? sd_error_timeout : sd_error_cmd;
+    }
+    sd_spi_rw_byte(0xFF); // Nwr
+    s_stream = SD_STREAM_WRITE;
+    return sd_error_ok;
+}
+
+int32_t sd_write_next(const uint8_t *data)
 {
-    // Send CMD0
-    sd_send_cmd(SD_CMD0_GO_IDLE_STATE, 0);
+    if (data == NULL || s_stream != SD_STREAM_WRITE) {
+        return sd_error_param;
+    }
+    return sd_send_block(SD_TOKEN_START_MULTI, data);
+}
 
-    // Wait for response
-    sd_match_response(SD_RESP_IDLE, 10);
+int32_t sd_write_stop(void)
+{
+    int32_t ret;
 
-    return 0;
+    if (s_stream != SD_STREAM_WRITE) {
+        return sd_error_param;
+    }
+    sd_spi_rw_byte(SD_TOKEN_STOP_TRAN);
+    sd_spi_rw_byte(0xFF); // Nbr, 之后才开始忙
+    ret = sd_wait_ready(SD_TIMEOUT_WRITE);
+    sd_deselect();
+    s_stream = SD_STREAM_NONE;
+    return ret;
 }
 
-int32_t sd_send_cmd(uint8_t cmd, uint32_t arg)
+int32_t sd_read_blocks(uint32_t block, uint8_t *data, uint32_t count)
 {
-    // Send command
-    uint8_t crc = 0xff;
+    int32_t ret;
 
+    if (data == NULL || count == 0) {
+        return sd_error_param;
+    }
+    if (count == 1) {
+        return sd_read_block(block, data);
+    }
+    ret = sd_read_start(block);
+    for (uint32_t i = 0; ret == sd_error_ok && i < count; i++) {
+        ret = sd_read_next(data + i * SD_BLOCK_SIZE);
+    }
+    if (s_stream == SD_STREAM_READ) {
+        int32_t stop = sd_read_stop();
+        if (ret == sd_error_ok) {
+            ret = stop;
+        }
+    }
+    return ret;
+}
+
+int32_t sd_write_blocks(uint32_t block, const uint8_t *data, uint32_t count)
+{
+    int32_t ret;
+
+    if (data == NULL || count == 0) {
+        return sd_error_param;
+    }
+    if (count == 1) {
+        return sd_write_block(block, (uint8_t *)data);
+    }
+    ret = sd_write_start(block, count);
+    for (uint32_t i = 0; ret == sd_error_ok && i < count; i++) {
+        ret = sd_write_next(data + i * SD_BLOCK_SIZE);
+    }
+    if (s_stream == SD_STREAM_WRITE) {
+        int32_t stop = sd_write_stop();
+        if (ret == sd_error_ok) {
+            ret = stop;
+        }
+    }
+    return ret;
+}
+
+/* ==================== 命令 ==================== */
+
+static int32_t sd_wait_ready(uint32_t timeout)
+{
+    while (timeout--) {
+        if (sd_spi_rw_byte(0xFF) == 0xff) {
+            return sd_error_ok;
+        }
+    }
+    return sd_error_timeout;
+}
+
+// 返回 R1, 负数为超时
+static int32_t sd_send_cmd(uint8_t cmd, uint32_t arg)
+{
     uint8_t cmd_pack[6];
+    uint8_t resp;
+
+    // 上一次写可能还在忙; CMD0 和数据流中的 CMD12 不等
+    if (cmd != SD_CMD0_GO_IDLE_STATE && cmd != SD_CMD12_STOP_TRANSMISSION
+        && sd_wait_ready(SD_TIMEOUT_WRITE) != sd_error_ok) {
+        return sd_error_timeout;
+    }
 
     cmd_pack[0] = cmd;
 
@@ -117,21 +441,32 @@ int32_t sd_send_cmd(uint8_t cmd, uint32_t arg)
 
     sd_spi_write_bytes(cmd_pack, 6);
 
-    return 0;
+    // CMD12 之后第一个字节是填充字节
+    if (cmd == SD_CMD12_STOP_TRANSMISSION) {
+        sd_spi_rw_byte(0xFF);
+    }
+
+    for (int i = 0; i < SD_NCR_MAX; i++) {
+        resp = sd_spi_rw_byte(0xFF);
+        if ((resp & SD_R1_RESPONSE_BUSY) == 0) {
+            return resp;
+        }
+    }
+    return sd_error_timeout;
 }
 
-int32_t sd_match_response(uint8_t desired_resp, uint8_t retry)
+static int32_t sd_send_acmd(uint8_t cmd, uint32_t arg)
 {
-    uint8_t resp;
-    while (retry--) {
-        if (sd_spi_read_byte(&resp, 1) > 0) {
-            if (resp == desired_resp) {
-                break;
-            }
-        }
+    int32_t r1 = sd_send_cmd(SD_CMD55_APP_CMD, 0);
+
+    if (r1 < 0 || (r1 & ~SD_R1_IDLE_STATE) != 0) {
+        return r1;
     }
+    return sd_send_cmd(cmd, arg);
 }
 
-int32_t sd_get_response(uint8_t *resp, uint8_t len)
+// R3/R7: R1 之后的 4 字节
+static int32_t sd_get_response(uint8_t *resp, uint8_t len)
 {
-}
\ No newline at end of file
+    return sd_spi_read_bytes(resp, len);
+}
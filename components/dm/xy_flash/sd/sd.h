@@ -3,6 +3,8 @@
 
 // ref: https://blog.csdn.net/LH_SMD/article/details/121605139
 
+#include <stdint.h>
+
 typedef struct {
     uint8_t manufacturer_id;
     uint16_t application_id;
@@ -24,7 +26,7 @@ typedef struct {
 } sd_reg_scr;
 
 typedef struct {
-    uint32_t reserved2 : 7;
+    uint32_t reserved0 : 7;
     uint32_t voltage_16_17 : 1;
     uint32_t voltage_18_19 : 1;
     uint32_t voltage_20_21 : 1;
@@ -128,6 +130,10 @@ typedef struct {
 } sd_resp7;
 
 typedef enum {
+    sd_error_param   = -5, // 参数错误或流状态不对
+    sd_error_data    = -4, // 数据响应/数据错误令牌
+    sd_error_cmd     = -3, // R1 报错
+    sd_error_timeout = -2, // 等待响应、令牌或忙超时
     sd_error_unknown = -1,
     sd_error_ok      = 0,
 } sd_error_t;
@@ -140,6 +146,8 @@ typedef enum {
 
 // Start/Stop Token
 #define SD_TOKEN_START_BLOCK 0xFE
+#define SD_TOKEN_START_MULTI 0xFC // CMD25 每块的起始令牌
+#define SD_TOKEN_STOP_TRAN   0xFD // CMD25 结束令牌
 
 // Data error token
 #define SD_DATA_ERROR_HASH_ERROR      0x01
@@ -168,7 +176,7 @@ typedef enum {
 #define SD_CMD5_IO_SEND_OP_COND       0x45
 #define SD_CMD6_SWITCH_FUNC           0x46
 #define SD_CMD7_SELECT_CARD           0x47
-#define SD_CMD8_SEND_IF_COND          0x49
+#define SD_CMD8_SEND_IF_COND          0x48
 #define SD_CMD9_SEND_CSD              0x49
 #define SD_CMD10_SEND_CID             0x4A
 #define SD_CMD12_STOP_TRANSMISSION    0x4C
@@ -191,6 +199,7 @@ typedef enum {
 #define SD_CMD42_LOCK_UNLOCK          0x6A
 #define SD_CMD55_APP_CMD              0x77
 #define SD_CMD58_READ_OCR             0x7A
+#define SD_ACMD23_SET_WR_BLK_ERASE    0x57
 #define SD_ACMD41_SD_SEND_OP_COND     0x69
 #define SD_ACMD42_SET_CLR_CARD_DETECT 0x6A
 #define SD_ACMD51_SEND_SCR            0x73
@@ -239,8 +248,39 @@ typedef enum { SD_PLUG_IN = 0, SD_PLUG_OUT = 1 } sd_plug_status_t;
 
 typedef void (*sd_detect_callback)(sd_plug_status_t status);
 
+// 等待超时, 以轮询字节数计 (25MHz 下 1 字节 0.32us)
+#ifndef SD_TIMEOUT_READ
+#define SD_TIMEOUT_READ  320000  // 读令牌, 约 100ms
+#endif
+#ifndef SD_TIMEOUT_WRITE
+#define SD_TIMEOUT_WRITE 1600000 // 写忙, 约 500ms
+#endif
+#ifndef SD_TIMEOUT_INIT
+#define SD_TIMEOUT_INIT  1000    // ACMD41 重试次数
+#endif
+
 extern int32_t sd_init(void);
+extern uint8_t sd_card_type(void);
+extern uint32_t sd_card_blocks(void); // 容量 (块), CSD 读不到时为 0
 extern int32_t sd_read_block(uint32_t block, uint8_t *data);
 extern int32_t sd_write_block(uint32_t block, uint8_t *data);
 extern int32_t sd_earase_block(uint32_t start_block, uint32_t end_block);
+
+/*
+ * 多块传输: 一条 CMD18/CMD25 连续传多块, 数据段走 DMA (sd_spi_dma_*).
+ * 流式接口用于块数事先不确定的场合 (日志导出、文件系统回写):
+ *   sd_read_start() -> sd_read_next() x n -> sd_read_stop()
+ *   sd_write_start() -> sd_write_next() x n -> sd_write_stop()
+ * 流打开期间不能调用其他 sd_ 接口. count_hint > 1 时先发 ACMD23 预擦除,
+ * 卡可以少做一些擦写合并; 写入块数可以少于提示.
+ */
+extern int32_t sd_read_blocks(uint32_t block, uint8_t *data, uint32_t count);
+extern int32_t sd_write_blocks(uint32_t block, const uint8_t *data, uint32_t count);
+
+extern int32_t sd_read_start(uint32_t block);
+extern int32_t sd_read_next(uint8_t *data);
+extern int32_t sd_read_stop(void);
+extern int32_t sd_write_start(uint32_t block, uint32_t count_hint);
+extern int32_t sd_write_next(const uint8_t *data);
+extern int32_t sd_write_stop(void);
 #endif
@@ -0,0 +1,294 @@
+#include "sd_cache.h"
+#include "sd.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define SD_CACHE_NONE 0xFFFFFFFF
+
+typedef struct {
+    uint32_t block; // SD_CACHE_NONE 为空
+    uint32_t stamp; // 最近使用时刻, 越小越老
+    uint8_t dirty;
+} sd_cache_slot_t;
+
+static sd_cache_slot_t s_slot[SD_CACHE_BLOCKS];
+static uint8_t s_data[SD_CACHE_BLOCKS][SD_BLOCK_SIZE];
+static uint32_t s_clock;
+static uint32_t s_next_miss; // 上次未命中之后的块号, 用于判断顺序读
+static sd_cache_stats_t s_stats;
+
+static int sd_cache_find(uint32_t block)
+{
+    for (int i = 0; i < SD_CACHE_BLOCKS; i++) {
+        if (s_slot[i].block == block) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void sd_cache_touch(int i)
+{
+    s_slot[i].stamp = ++s_clock;
+}
+
+// 从 s_slot[i] 所在的连续脏块段开头, 一条多块写写完整段
+static int32_t sd_cache_write_run(int i)
+{
+    uint32_t first = s_slot[i].block;
+    uint32_t count = 0;
+    int32_t ret;
+    int j;
+
+    while (first > 0 && (j = sd_cache_find(first - 1)) >= 0 && s_slot[j].dirty) {
+        first--;
+    }
+    while ((j = sd_cache_find(first + count)) >= 0 && s_slot[j].dirty) {
+        count++;
+    }
+
+    if (count == 1) {
+        j = sd_cache_find(first);
+        ret = sd_write_block(first, s_data[j]);
+        if (ret == sd_error_ok) {
+            s_slot[j].dirty = 0;
+            s_stats.blocks_written++;
+        }
+    } else if ((ret = sd_write_start(first, count)) == sd_error_ok) {
+        for (uint32_t k = 0; ret == sd_error_ok && k < count; k++) {
+            j = sd_cache_find(first + k);
+            ret = sd_write_next(s_data[j]);
+            if (ret == sd_error_ok) {
+                s_slot[j].dirty = 0;
+                s_stats.blocks_written++;
+            }
+        }
+        int32_t stop = sd_write_stop();
+        if (ret == sd_error_ok) {
+            ret = stop;
+        }
+    }
+    s_stats.write_cmds++;
+    return ret;
+}
+
+// 取最老的槽, 脏则先写回
+static int sd_cache_victim(void)
+{
+    int v = 0;
+
+    for (int i = 0; i < SD_CACHE_BLOCKS; i++) {
+        if (s_slot[i].block == SD_CACHE_NONE) {
+            return i;
+        }
+        if (s_slot[i].stamp < s_slot[v].stamp) {
+            v = i;
+        }
+    }
+    if (s_slot[v].dirty && sd_cache_write_run(v) != sd_error_ok) {
+        return -1;
+    }
+    s_slot[v].block = SD_CACHE_NONE;
+    return v;
+}
+
+// 未命中: 读 block 起最多 n 块进缓存, 遇到已缓存的块停止
+static int32_t sd_cache_fill(uint32_t block, uint32_t n)
+{
+    int slots[SD_CACHE_READ_AHEAD > 0 ? SD_CACHE_READ_AHEAD : 1];
+    uint32_t count = 0;
+    int32_t ret;
+
+    while (count < n && sd_cache_find(block + count) < 0) {
+        slots[count] = sd_cache_victim();
+        if (slots[count] < 0) {
+            break;
+        }
+        // 先占住, 免得被同一轮的 victim 再选中
+        s_slot[slots[count]].block = block + count;
+        sd_cache_touch(slots[count]);
+        count++;
+    }
+    if (count == 0) {
+        return sd_error_unknown;
+    }
+
+    if (count == 1) {
+        ret = sd_read_block(block, s_data[slots[0]]);
+    } else if ((ret = sd_read_start(block)) == sd_error_ok) {
+        for (uint32_t k = 0; ret == sd_error_ok && k < count; k++) {
+            ret = sd_read_next(s_data[slots[k]]);
+        }
+        int32_t stop = sd_read_stop();
+        if (ret == sd_error_ok) {
+            ret = stop;
+        }
+    }
+    s_stats.read_cmds++;
+    if (ret != sd_error_ok) {
+        for (uint32_t k = 0; k < count; k++) {
+            s_slot[slots[k]].block = SD_CACHE_NONE;
+        }
+        return ret;
+    }
+    s_stats.blocks_read += count;
+    s_next_miss = block + count;
+    return sd_error_ok;
+}
+
+void sd_cache_init(void)
+{
+    for (int i = 0; i < SD_CACHE_BLOCKS; i++) {
+        s_slot[i].block = SD_CACHE_NONE;
+        s_slot[i].dirty = 0;
+    }
+    s_clock     = 0;
+    s_next_miss = SD_CACHE_NONE;
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+int32_t sd_cache_read(uint32_t block, uint8_t *data, uint32_t count)
+{
+    int32_t ret;
+    uint32_t need;
+    uint32_t last;
+    uint32_t n;
+    int i;
+
+    if (data == NULL || count == 0) {
+        return sd_error_param;
+    }
+
+    if (count >= SD_CACHE_BLOCKS) {
+        // 大块直读, 缓存里的副本是最新的
+        ret = sd_read_blocks(block, data, count);
+        s_stats.read_cmds++;
+        if (ret != sd_error_ok) {
+            return ret;
+        }
+        s_stats.blocks_read += count;
+        for (i = 0; i < SD_CACHE_BLOCKS; i++) {
+            if (s_slot[i].block != SD_CACHE_NONE && s_slot[i].block - block < count) {
+                memcpy(data + (s_slot[i].block - block) * SD_BLOCK_SIZE, s_data[i],
+                       SD_BLOCK_SIZE);
+            }
+        }
+        return sd_error_ok;
+    }
+
+    for (uint32_t k = 0; k < count; k++, data += SD_BLOCK_SIZE) {
+        i = sd_cache_find(block + k);
+        if (i >= 0) {
+            s_stats.hits++;
+        } else {
+            s_stats.misses++;
+            // 本次还要的块一起读; 顺序读时再多读一段, 但不读过卡尾
+            need = count - k < SD_CACHE_READ_AHEAD ? count - k : SD_CACHE_READ_AHEAD;
+            n    = need;
+            if (block + k == s_next_miss) {
+                n = SD_CACHE_READ_AHEAD;
+                last = sd_card_blocks();
+                if (last > block + k && n > last - (block + k)) {
+                    n = last - (block + k);
+                }
+            }
+            ret = sd_cache_fill(block + k, n);
+            if (ret != sd_error_ok && n > need) {
+                // 容量未知时预读可能越界, 只读要的块再试一次
+                ret = sd_cache_fill(block + k, need);
+            }
+            if (ret != sd_error_ok) {
+                return ret;
+            }
+            i = sd_cache_find(block + k);
+        }
+        memcpy(data, s_data[i], SD_BLOCK_SIZE);
+        sd_cache_touch(i);
+    }
+    return sd_error_ok;
+}
+
+int32_t sd_cache_write(uint32_t block, const uint8_t *data, uint32_t count)
+{
+    int32_t ret;
+    int i;
+
+    if (data == NULL || count == 0) {
+        return sd_error_param;
+    }
+
+    if (count >= SD_CACHE_BLOCKS) {
+        // 大块直写, 同范围的缓存块被覆盖, 作废
+        for (i = 0; i < SD_CACHE_BLOCKS; i++) {
+            if (s_slot[i].block != SD_CACHE_NONE && s_slot[i].block - block < count) {
+                s_slot[i].block = SD_CACHE_NONE;
+                s_slot[i].dirty = 0;
+            }
+        }
+        ret = sd_write_blocks(block, data, count);
+        s_stats.write_cmds++;
+        if (ret == sd_error_ok) {
+            s_stats.blocks_written += count;
+        }
+        return ret;
+    }
+
+    for (uint32_t k = 0; k < count; k++, data += SD_BLOCK_SIZE) {
+        i = sd_cache_find(block + k);
+        if (i >= 0) {
+            s_stats.hits++;
+        } else {
+            // 整块覆盖, 不用先读
+            i = sd_cache_victim();
+            if (i < 0) {
+                return sd_error_unknown;
+            }
+            s_slot[i].block = block + k;
+        }
+        memcpy(s_data[i], data, SD_BLOCK_SIZE);
+        s_slot[i].dirty = 1;
+        sd_cache_touch(i);
+    }
+    return sd_error_ok;
+}
+
+int32_t sd_cache_flush(void)
+{
+    int32_t ret;
+    int low;
+
+    // 按块号从低到高写回, 连续段各一条命令
+    for (;;) {
+        low = -1;
+        for (int i = 0; i < SD_CACHE_BLOCKS; i++) {
+            if (s_slot[i].block != SD_CACHE_NONE && s_slot[i].dirty
+                && (low < 0 || s_slot[i].block < s_slot[low].block)) {
+                low = i;
+            }
+        }
+        if (low < 0) {
+            return sd_error_ok;
+        }
+        ret = sd_cache_write_run(low);
+        if (ret != sd_error_ok) {
+            return ret;
+        }
+    }
+}
+
+void sd_cache_invalidate(void)
+{
+    for (int i = 0; i < SD_CACHE_BLOCKS; i++) {
+        s_slot[i].block = SD_CACHE_NONE;
+        s_slot[i].dirty = 0;
+    }
+    s_next_miss = SD_CACHE_NONE;
+}
+
+void sd_cache_get_stats(sd_cache_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef _SD_CACHE_H_
+#define _SD_CACHE_H_
+
+#include <stdint.h>
+
+/*
+ * SD 块缓存: 小容量 LRU, 写回 + 顺序预读, 放在 sd_read_blocks/sd_write_blocks 之上.
+ *
+ * - 写: 块只进缓存并标脏; 换出或 sd_cache_flush() 时, 与之块号连续的脏块
+ *   合成一条 CMD25 (带 ACMD23 提示) 写出.
+ * - 读: 未命中时若正好接着上一次未命中往后读, 一条 CMD18 预读
+ *   SD_CACHE_READ_AHEAD 块 (不超过卡尾); 否则只读需要的块.
+ *   预读失败时只读需要的块重试一次.
+ * - 不小于 SD_CACHE_BLOCKS 块的读写直接走多块传输, 不占缓存
+ *   (缓存里同范围的块: 读时以缓存为准, 写时作废).
+ *
+ * 掉电前或拔卡前调用 sd_cache_flush(). 非线程安全, 与 sd_ 接口共用同一把锁.
+ */
+
+#ifndef SD_CACHE_BLOCKS
+#define SD_CACHE_BLOCKS 16
+#endif
+
+#ifndef SD_CACHE_READ_AHEAD
+#define SD_CACHE_READ_AHEAD 8 // 不超过 SD_CACHE_BLOCKS / 2
+#endif
+
+typedef struct {
+    uint32_t hits;         // 命中块数
+    uint32_t misses;       // 未命中块数
+    uint32_t read_cmds;    // 读命令数 (CMD17/CMD18)
+    uint32_t write_cmds;   // 写命令数 (CMD24/CMD25)
+    uint32_t blocks_read;  // 从卡读出的块数
+    uint32_t blocks_written; // 写到卡上的块数
+} sd_cache_stats_t;
+
+extern void sd_cache_init(void);
+extern int32_t sd_cache_read(uint32_t block, uint8_t *data, uint32_t count);
+extern int32_t sd_cache_write(uint32_t block, const uint8_t *data, uint32_t count);
+extern int32_t sd_cache_flush(void);
+extern void sd_cache_invalidate(void); // 丢弃全部缓存, 包括脏块
+extern void sd_cache_get_stats(sd_cache_stats_t *stats);
+#endif
@@ -1,4 +1,4 @@
-#include "sd_port.h"
+#include "sd_spi.h"
 
 int32_t sd_spi_init(uint8_t speed_mode)
 {
@@ -19,3 +19,19 @@ int32_t sd_spi_write_bytes(uint8_t *data, uint16_t len)
 uint8_t sd_spi_rw_byte(uint8_t data)
 {
 }
+
+void sd_spi_cs(uint8_t level)
+{
+}
+
+int32_t sd_spi_dma_read(uint8_t *data, uint16_t len)
+{
+    // 启动 SPI RX DMA (TX 同时发 0xFF), 等 DMA 完成中断
+    return sd_spi_read_bytes(data, len);
+}
+
+int32_t sd_spi_dma_write(const uint8_t *data, uint16_t len)
+{
+    // 启动 SPI TX DMA, 等 DMA 完成中断和 SPI 移位完成 (BSY 清零)
+    return sd_spi_write_bytes((uint8_t *)data, len);
+}
@@ -1,10 +1,19 @@
 #ifndef _SD_PORT_H_
 #define _SD_PORT_H_
 
+#include <stdint.h>
 
 int32_t sd_spi_init(uint8_t speed_mode);
 int32_t sd_spi_deinit(void);
 int32_t sd_spi_read_bytes(uint8_t *data, uint16_t len);
 int32_t sd_spi_write_bytes(uint8_t *data, uint16_t len);
 uint8_t sd_spi_rw_byte(uint8_t data);
-#endif
\ No newline at end of file
+
+// 片选, 0 选中
+void sd_spi_cs(uint8_t level);
+
+// 数据段 DMA (512 字节一块), 传完才返回; 端口可在等待 DMA 完成中断时让出 CPU.
+// 读时 MOSI 发 0xFF. 没有 DMA 的端口直接转调 sd_spi_read_bytes/write_bytes.
+int32_t sd_spi_dma_read(uint8_t *data, uint16_t len);
+int32_t sd_spi_dma_write(const uint8_t *data, uint16_t len);
+#endif
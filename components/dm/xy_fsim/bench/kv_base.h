@@ -0,0 +1,12 @@
+/**
+ * @file kv_base.h
+ * @brief sf_kv reads through KV_BASE_ADDR; the bench points it at the mapping
+ */
+#ifndef KV_BASE_H
+#define KV_BASE_H
+
+#include <stdint.h>
+
+extern uint8_t *g_kv_base;
+
+#endif
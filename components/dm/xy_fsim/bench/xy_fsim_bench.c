@@ -0,0 +1,286 @@
+/**
+ * @file xy_fsim_bench.c
+ * @brief Drivers and storage engines on the file-backed flash simulator
+ *
+ * 1. Drivers: xy_nor (through its port hooks) and norflash (through its
+ *    send_cmd callbacks, SFDP generated by the simulator) program, read back
+ *    and erase the same data on a W25Q-class model.
+ * 2. Engines: eee and sf_kv take the same stream of small record updates on
+ *    the same 16 KB of NOR. Per update: virtual flash time, programs, bytes
+ *    programmed; then erases and wear spread. The backing files are then
+ *    closed and reopened (a power cycle), both engines remount and every
+ *    value is checked against a shadow.
+ * 3. eee again on MCU internal flash (64-bit ECC units, programmed once).
+ *
+ * Every figure comes from the simulator's virtual clock, so runs are
+ * repeatable. sf_kv reads are memory-mapped and eee reads come from its RAM
+ * shadow; neither is charged flash time.
+ */
+
+#include "xy_fsim.h"
+#include "xy_nor.h"
+#include "norflash.h"
+#include "eee.h"
+#include "sf_kv.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NOR_SIZE     (1u << 20)
+#define DRV_BYTES    (64u * 1024)
+#define ENGINE_SIZE  (FLASH_PAGE_SIZE * FLASH_KV_PAGE)
+#define KEYS         64
+#define VAL_LEN      6  /* one eee element with 64-bit units */
+#define UPDATES      20000
+
+#define EEE_FILE     "fsim_eee.bin"
+#define KV_FILE      "fsim_kv.bin"
+
+uint8_t *g_kv_base; /* KV_BASE_ADDR, follows the mapping across reopen */
+
+static xy_fsim_t s_kv_fs;
+static uint8_t s_shadow[KEYS][VAL_LEN];
+static uint32_t s_rand = 1;
+
+static uint32_t rnd(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static void report(const char *name, xy_fsim_t *fs, uint32_t ops, uint64_t t0)
+{
+    xy_fsim_stats_t st;
+
+    xy_fsim_get_stats(fs, &st);
+    printf("  %-22s %8.1f us/op  %5.2f prog/op %6.1f B/op  %5u erases  "
+           "wear %u..%u\n",
+           name, (xy_fsim_now(fs) - t0) / 1e3 / ops,
+           (double)st.programs / ops, (double)st.prog_bytes / ops,
+           (unsigned)st.erases, (unsigned)st.wear_min, (unsigned)st.wear_max);
+}
+
+/* ==================== Drivers ==================== */
+
+static int bench_drivers(void)
+{
+    static uint8_t src[DRV_BYTES], dst[DRV_BYTES];
+    xy_fsim_config_t config;
+    xy_fsim_t fs;
+    xy_fsim_stats_t st;
+    xy_nor_handle_t nor;
+    xy_nor_config_t nor_config;
+    norflash_t flash;
+    norflash_erase_plan_t plan;
+    uint64_t t0;
+    uint32_t i;
+
+    for (i = 0; i < DRV_BYTES; i++)
+        src[i] = (uint8_t)(i * 13 + (i >> 8));
+
+    xy_fsim_config_nor(&config, NOR_SIZE);
+    if (xy_fsim_open(&fs, &config) != XY_FSIM_OK)
+        return -1;
+    printf("drivers, W25Q-class model, %u KB program + read + erase\n",
+           (unsigned)(DRV_BYTES / 1024));
+
+    xy_fsim_nor_attach(&fs);
+    xy_nor_get_default_config(&nor_config);
+    nor_config.quad_enable = true;
+    if (xy_nor_init(&nor, &nor_config) != XY_NOR_OK
+        || nor.info.capacity != NOR_SIZE)
+        return -1;
+    t0 = xy_fsim_now(&fs);
+    for (i = 0; i < DRV_BYTES; i += nor.info.page_size) {
+        if (xy_nor_page_program(&nor, i, &src[i], nor.info.page_size) != XY_NOR_OK)
+            return -1;
+    }
+    printf("  xy_nor   program  %8.1f ms  (WIP polled every 1 ms)\n",
+           (xy_fsim_now(&fs) - t0) / 1e6);
+    t0 = xy_fsim_now(&fs);
+    if (xy_nor_quad_read(&nor, 0, dst, DRV_BYTES) != XY_NOR_OK
+        || memcmp(src, dst, DRV_BYTES) != 0)
+        return -1;
+    printf("  xy_nor   read     %8.3f ms\n", (xy_fsim_now(&fs) - t0) / 1e6);
+
+    memset(&flash, 0, sizeof(flash));
+    flash.send_cmd     = xy_fsim_spi_send_cmd;
+    flash.write_enable = xy_fsim_spi_write_enable;
+    flash.wait_ready   = xy_fsim_spi_wait_ready;
+    flash.user_ctx     = &fs;
+    if (norflash_init(&flash) != 0 || !flash.info.support_sfdp
+        || flash.info.capacity != NOR_SIZE || flash.info.erase_type_num != 3)
+        return -1;
+    t0 = xy_fsim_now(&fs);
+    if (norflash_write(&flash, DRV_BYTES, src, DRV_BYTES) != 0)
+        return -1;
+    printf("  norflash program  %8.1f ms  (exact wait)\n",
+           (xy_fsim_now(&fs) - t0) / 1e6);
+    if (norflash_read(&flash, DRV_BYTES, dst, DRV_BYTES) != 0
+        || memcmp(src, dst, DRV_BYTES) != 0)
+        return -1;
+
+    if (norflash_erase_plan(&flash, 0x1000, 2 * DRV_BYTES - 0x1000, &plan) != 0)
+        return -1;
+    t0 = xy_fsim_now(&fs);
+    norflash_erase(&flash, 0x1000, 2 * DRV_BYTES - 0x1000);
+    printf("  norflash erase    %8.1f ms  (plan: %u erases, %u ms by SFDP times)\n",
+           (xy_fsim_now(&fs) - t0) / 1e6, (unsigned)plan.ops,
+           (unsigned)plan.time_ms);
+    norflash_read(&flash, 0, dst, 0x1000);
+    if (memcmp(src, dst, 0x1000) != 0 || fs.mem[0x1000] != 0xFF
+        || fs.mem[2 * DRV_BYTES - 1] != 0xFF)
+        return -1;
+
+    xy_fsim_get_stats(&fs, &st);
+    xy_fsim_close(&fs);
+    if (st.violations != 0 || st.lost_bits != 0) {
+        printf("  protocol violations %u, lost bits %u\n",
+               (unsigned)st.violations, (unsigned)st.lost_bits);
+        return -1;
+    }
+    return 0;
+}
+
+/* ==================== Engines ==================== */
+
+sf_bool sf_kv_port_write(sf_uint32_t addr, const void *data, sf_uint32_t len)
+{
+    return xy_fsim_program(&s_kv_fs, addr, data, len) == XY_FSIM_OK;
+}
+
+sf_bool sf_kv_port_erase(sf_uint32_t addr)
+{
+    return xy_fsim_port_erase(&s_kv_fs, addr) == 0;
+}
+
+static int eee_open(xy_fsim_t *fs, eee_handle_t *eee, const xy_fsim_config_t *fc,
+                    uint8_t unit, void *ws, size_t ws_size)
+{
+    eee_port_t port = { xy_fsim_port_read, xy_fsim_port_write,
+                        xy_fsim_port_erase, fs };
+    eee_config_t config = { .base          = 0,
+                            .page_size     = fc->erase[0].size,
+                            .page_count    = (uint8_t)(fc->size / fc->erase[0].size),
+                            .write_unit    = unit,
+                            .element_count = KEYS };
+
+    if (xy_fsim_open(fs, fc) != XY_FSIM_OK)
+        return -1;
+    return eee_init(eee, &config, &port, ws, ws_size) == EEE_OK ? 0 : -1;
+}
+
+static int bench_eee(const char *name, xy_fsim_config_t *fc)
+{
+    static uint8_t ws[EEE_WORKSPACE_SIZE(KEYS, 8)];
+    uint8_t buf[KEYS * VAL_LEN];
+    eee_handle_t eee;
+    xy_fsim_t fs;
+    uint64_t t0;
+    uint32_t i, key;
+
+    fc->path   = EEE_FILE;
+    fc->format = true;
+    if (eee_open(&fs, &eee, fc, 8, ws, sizeof(ws)) != 0)
+        return -1;
+    memset(s_shadow, 0xFF, sizeof(s_shadow));
+    s_rand = 1;
+    xy_fsim_reset_stats(&fs);
+    t0 = xy_fsim_now(&fs);
+    for (i = 0; i < UPDATES; i++) {
+        key = rnd() % KEYS;
+        memcpy(s_shadow[key], &i, 4);
+        s_shadow[key][4] = (uint8_t)key;
+        s_shadow[key][5] = (uint8_t)~i;
+        if (eee_write(&eee, key * VAL_LEN, s_shadow[key], VAL_LEN) != EEE_OK)
+            return -1;
+        eee_service(&eee);
+    }
+    report(name, &fs, UPDATES, t0);
+    xy_fsim_close(&fs);
+
+    /* Power cycle: remount from the file */
+    fc->format = false;
+    if (eee_open(&fs, &eee, fc, 8, ws, sizeof(ws)) != 0
+        || eee_read(&eee, 0, buf, sizeof(buf)) != EEE_OK
+        || memcmp(buf, s_shadow, sizeof(buf)) != 0)
+        return -1;
+    xy_fsim_close(&fs);
+    unlink(EEE_FILE);
+    return 0;
+}
+
+static int bench_kv(const char *name, xy_fsim_config_t *fc)
+{
+    uint8_t *val;
+    uint64_t t0;
+    uint32_t i, key;
+
+    fc->path   = KV_FILE;
+    fc->format = true;
+    if (xy_fsim_open(&s_kv_fs, fc) != XY_FSIM_OK)
+        return -1;
+    g_kv_base = s_kv_fs.mem;
+    if (sf_kv_init() != 0)
+        return -1;
+    memset(s_shadow, 0xFF, sizeof(s_shadow));
+    s_rand = 1;
+    xy_fsim_reset_stats(&s_kv_fs);
+    t0 = xy_fsim_now(&s_kv_fs);
+    for (i = 0; i < UPDATES; i++) {
+        key = rnd() % KEYS;
+        memcpy(s_shadow[key], &i, 4);
+        s_shadow[key][4] = (uint8_t)key;
+        s_shadow[key][5] = (uint8_t)~i;
+        if (sf_kv_set((uint8_t)(key + 1), s_shadow[key], VAL_LEN) == NULL)
+            return -1;
+        sf_kv_gc_check();
+    }
+    report(name, &s_kv_fs, UPDATES, t0);
+    xy_fsim_close(&s_kv_fs);
+
+    fc->format = false;
+    if (xy_fsim_open(&s_kv_fs, fc) != XY_FSIM_OK)
+        return -1;
+    g_kv_base = s_kv_fs.mem;
+    if (sf_kv_init() != 0)
+        return -1;
+    for (key = 0; key < KEYS; key++) {
+        val = (uint8_t *)sf_kv_get((uint8_t)(key + 1));
+        if (s_shadow[key][4] == 0xFF)
+            continue; /* never written */
+        if (val == NULL || memcmp(val, s_shadow[key], VAL_LEN) != 0)
+            return -1;
+    }
+    xy_fsim_close(&s_kv_fs);
+    unlink(KV_FILE);
+    return 0;
+}
+
+int main(void)
+{
+    xy_fsim_config_t config;
+
+    if (bench_drivers() != 0) {
+        printf("driver check failed\n");
+        return 1;
+    }
+
+    printf("\n%u updates of %u-byte values over %u keys, %u x %u KB sectors\n",
+           (unsigned)UPDATES, (unsigned)VAL_LEN, (unsigned)KEYS,
+           (unsigned)FLASH_KV_PAGE, (unsigned)(FLASH_PAGE_SIZE / 1024));
+    xy_fsim_config_nor(&config, ENGINE_SIZE);
+    if (bench_eee("SPI NOR, eee", &config) != 0
+        || bench_kv("SPI NOR, sf_kv", &config) != 0) {
+        printf("engine check failed\n");
+        return 1;
+    }
+    xy_fsim_config_eflash(&config, ENGINE_SIZE);
+    config.erase[0].size = FLASH_PAGE_SIZE;
+    if (bench_eee("MCU flash, eee", &config) != 0) {
+        printf("engine check failed\n");
+        return 1;
+    }
+    printf("\nremounted from the backing files, all values verified\n");
+    return 0;
+}
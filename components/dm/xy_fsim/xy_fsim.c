@@ -0,0 +1,689 @@
+/**
+ * @file xy_fsim.c
+ * @brief File-backed flash simulator implementation
+ *
+ * File layout: the device image (config.size bytes), then a trailer header
+ * and one uint32_t erase counter per smallest-erase sector. The trailer
+ * header records the geometry; a file whose geometry does not match is
+ * reformatted on open.
+ */
+
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS */
+
+#include "xy_fsim.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FSIM_MAGIC  0x4D495346u /* "FSIM" */
+#define FSIM_ERASED 0xFF
+
+#define FSIM_IS_POW2(x) ((x) != 0 && ((x) & ((x) - 1)) == 0)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t sector_size;
+    uint32_t prog_unit;
+} fsim_trailer_t;
+
+/* ==================== Helpers ==================== */
+
+static uint32_t fsim_sector_size(const xy_fsim_t *fsim)
+{
+    return fsim->config.erase[0].size;
+}
+
+static fsim_trailer_t *fsim_trailer(const xy_fsim_t *fsim)
+{
+    return (fsim_trailer_t *)(fsim->mem + fsim->config.size);
+}
+
+static bool fsim_in_range(const xy_fsim_t *fsim, uint32_t addr, uint32_t len)
+{
+    return addr <= fsim->config.size && len <= fsim->config.size - addr;
+}
+
+static uint64_t fsim_bus_ns(uint32_t ps_per_byte, uint32_t len)
+{
+    return ((uint64_t)ps_per_byte * len + 999) / 1000;
+}
+
+static uint64_t fsim_prog_ns(const xy_fsim_t *fsim, uint32_t len)
+{
+    uint32_t units = (len + fsim->config.prog_unit - 1) / fsim->config.prog_unit;
+
+    return fsim->config.timing.prog_base_ns
+           + (uint64_t)units * fsim->config.timing.prog_unit_ns;
+}
+
+/* Byte-level calls wait for an erase or program started over SPI */
+static void fsim_settle(xy_fsim_t *fsim)
+{
+    if (fsim->now_ns < fsim->busy_until)
+        fsim->now_ns = fsim->busy_until;
+}
+
+static int fsim_bit_count(uint8_t v)
+{
+    int n = 0;
+
+    for (; v != 0; v &= (uint8_t)(v - 1))
+        n++;
+    return n;
+}
+
+static bool fsim_worn(const xy_fsim_t *fsim, uint32_t addr, uint32_t len)
+{
+    uint32_t s;
+
+    if (fsim->config.endurance == 0 || len == 0)
+        return false;
+    for (s = addr / fsim_sector_size(fsim);
+         s <= (addr + len - 1) / fsim_sector_size(fsim); s++) {
+        if (fsim->wear[s] > fsim->config.endurance)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Check that a program can land: strict units erased, sectors alive
+ */
+static xy_fsim_status_t fsim_program_check(const xy_fsim_t *fsim, uint32_t addr,
+                                           uint32_t len)
+{
+    uint32_t i;
+
+    if (fsim_worn(fsim, addr, len))
+        return XY_FSIM_PROGRAM_FAIL;
+    if (fsim->config.strict) {
+        for (i = 0; i < len; i++) {
+            if (fsim->mem[addr + i] != FSIM_ERASED)
+                return XY_FSIM_PROGRAM_FAIL;
+        }
+    }
+    return XY_FSIM_OK;
+}
+
+/* Programming clears bits only */
+static void fsim_program_apply(xy_fsim_t *fsim, uint32_t addr,
+                               const uint8_t *src, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        fsim->stats.lost_bits += fsim_bit_count(src[i] & ~fsim->mem[addr + i]);
+        fsim->mem[addr + i] &= src[i];
+    }
+}
+
+static const xy_fsim_erase_t *fsim_erase_type(const xy_fsim_t *fsim,
+                                              uint32_t size)
+{
+    uint32_t i;
+
+    for (i = 0; i < XY_FSIM_ERASE_TYPES; i++) {
+        if (fsim->config.erase[i].size != 0 && fsim->config.erase[i].size == size)
+            return &fsim->config.erase[i];
+    }
+    return NULL;
+}
+
+static void fsim_erase_apply(xy_fsim_t *fsim, uint32_t addr, uint32_t size)
+{
+    uint32_t s;
+
+    memset(fsim->mem + addr, FSIM_ERASED, size);
+    for (s = addr / fsim_sector_size(fsim);
+         s < (addr + size) / fsim_sector_size(fsim); s++)
+        fsim->wear[s]++;
+}
+
+static void fsim_format(xy_fsim_t *fsim)
+{
+    fsim_trailer_t *t = fsim_trailer(fsim);
+
+    memset(fsim->mem, FSIM_ERASED, fsim->config.size);
+    memset(fsim->wear, 0, fsim->sectors * sizeof(uint32_t));
+    t->magic       = FSIM_MAGIC;
+    t->size        = fsim->config.size;
+    t->sector_size = fsim_sector_size(fsim);
+    t->prog_unit   = fsim->config.prog_unit;
+}
+
+static bool fsim_config_valid(const xy_fsim_config_t *config)
+{
+    uint32_t i, prev = 0;
+
+    if (config->size == 0 || !FSIM_IS_POW2(config->prog_unit))
+        return false;
+    if (config->page_size != 0 && config->page_size % config->prog_unit != 0)
+        return false;
+    for (i = 0; i < XY_FSIM_ERASE_TYPES; i++) {
+        uint32_t size = config->erase[i].size;
+        if (size == 0) {
+            if (i == 0)
+                return false;
+            continue;
+        }
+        if (!FSIM_IS_POW2(size) || size <= prev || size % config->prog_unit != 0)
+            return false;
+        prev = size;
+    }
+    return config->size % config->erase[0].size == 0;
+}
+
+/* ==================== Presets ==================== */
+
+void xy_fsim_config_nor(xy_fsim_config_t *config, uint32_t size)
+{
+    memset(config, 0, sizeof(xy_fsim_config_t));
+    config->size      = size;
+    config->prog_unit = 1;
+    config->page_size = 256;
+    config->endurance = 100000;
+    config->erase[0]  = (xy_fsim_erase_t){ 4096, 45000, 0x20 };
+    config->erase[1]  = (xy_fsim_erase_t){ 32 * 1024, 120000, 0x52 };
+    config->erase[2]  = (xy_fsim_erase_t){ 64 * 1024, 150000, 0xD8 };
+    /* 50 MHz: 1-line command + 24-bit address, quad data out, 1-line program */
+    config->timing.cmd_ns       = 640;
+    config->timing.read_ps      = 40000;
+    config->timing.write_ps     = 160000;
+    config->timing.prog_base_ns = 20000; /* tPP 0.4 ms for a full page */
+    config->timing.prog_unit_ns = 1500;
+}
+
+void xy_fsim_config_eflash(xy_fsim_config_t *config, uint32_t size)
+{
+    memset(config, 0, sizeof(xy_fsim_config_t));
+    config->size      = size;
+    config->prog_unit = 8;
+    config->strict    = true;
+    config->endurance = 10000;
+    config->erase[0]  = (xy_fsim_erase_t){ 2048, 22000, 0 };
+    /* Memory-mapped reads with wait states; one doubleword program ~82 us */
+    config->timing.cmd_ns       = 100;
+    config->timing.read_ps      = 3000;
+    config->timing.write_ps     = 0;
+    config->timing.prog_base_ns = 0;
+    config->timing.prog_unit_ns = 82000;
+}
+
+/* ==================== API ==================== */
+
+xy_fsim_status_t xy_fsim_open(xy_fsim_t *fsim, const xy_fsim_config_t *config)
+{
+    fsim_trailer_t *t;
+    struct stat st;
+    bool keep = false;
+    void *map;
+
+    if (fsim == NULL || config == NULL || !fsim_config_valid(config))
+        return XY_FSIM_INVALID_PARAM;
+
+    memset(fsim, 0, sizeof(xy_fsim_t));
+    fsim->config   = *config;
+    fsim->sectors  = config->size / config->erase[0].size;
+    fsim->map_size = config->size + sizeof(fsim_trailer_t)
+                     + fsim->sectors * sizeof(uint32_t);
+    fsim->fd       = -1;
+
+    if (config->path != NULL) {
+        fsim->fd = open(config->path, O_RDWR | O_CREAT, 0644);
+        if (fsim->fd < 0)
+            return XY_FSIM_IO;
+        if (fstat(fsim->fd, &st) != 0
+            || ((size_t)st.st_size != fsim->map_size
+                && ftruncate(fsim->fd, (off_t)fsim->map_size) != 0)) {
+            close(fsim->fd);
+            return XY_FSIM_IO;
+        }
+        keep = !config->format && (size_t)st.st_size == fsim->map_size;
+        map  = mmap(NULL, fsim->map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fsim->fd, 0);
+    } else {
+        map = mmap(NULL, fsim->map_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (map == MAP_FAILED) {
+        if (fsim->fd >= 0)
+            close(fsim->fd);
+        return XY_FSIM_IO;
+    }
+
+    fsim->mem  = (uint8_t *)map;
+    fsim->wear = (uint32_t *)(fsim->mem + config->size + sizeof(fsim_trailer_t));
+    t          = fsim_trailer(fsim);
+    if (!keep || t->magic != FSIM_MAGIC || t->size != config->size
+        || t->sector_size != config->erase[0].size
+        || t->prog_unit != config->prog_unit)
+        fsim_format(fsim);
+    return XY_FSIM_OK;
+}
+
+void xy_fsim_close(xy_fsim_t *fsim)
+{
+    if (fsim == NULL || fsim->mem == NULL)
+        return;
+    if (fsim->fd >= 0)
+        msync(fsim->mem, fsim->map_size, MS_SYNC);
+    munmap(fsim->mem, fsim->map_size);
+    if (fsim->fd >= 0)
+        close(fsim->fd);
+    fsim->mem  = NULL;
+    fsim->wear = NULL;
+    fsim->fd   = -1;
+}
+
+xy_fsim_status_t xy_fsim_read(xy_fsim_t *fsim, uint32_t addr, void *data,
+                              uint32_t len)
+{
+    uint64_t t;
+
+    if (fsim == NULL || fsim->mem == NULL || (data == NULL && len != 0))
+        return XY_FSIM_INVALID_PARAM;
+    if (!fsim_in_range(fsim, addr, len))
+        return XY_FSIM_OUT_OF_RANGE;
+
+    fsim_settle(fsim);
+    memcpy(data, fsim->mem + addr, len);
+    t = fsim->config.timing.cmd_ns + fsim_bus_ns(fsim->config.timing.read_ps, len);
+    fsim->now_ns += t;
+    fsim->stats.read_ns += t;
+    fsim->stats.reads++;
+    fsim->stats.read_bytes += len;
+    return XY_FSIM_OK;
+}
+
+xy_fsim_status_t xy_fsim_program(xy_fsim_t *fsim, uint32_t addr,
+                                 const void *data, uint32_t len)
+{
+    const uint8_t *src = (const uint8_t *)data;
+    xy_fsim_status_t status;
+    uint32_t page;
+    uint32_t chunk;
+    uint64_t t;
+
+    if (fsim == NULL || fsim->mem == NULL || (data == NULL && len != 0))
+        return XY_FSIM_INVALID_PARAM;
+    page = fsim->config.page_size;
+    if (!fsim_in_range(fsim, addr, len))
+        return XY_FSIM_OUT_OF_RANGE;
+    if (addr % fsim->config.prog_unit != 0 || len % fsim->config.prog_unit != 0)
+        return XY_FSIM_ALIGNMENT;
+    status = fsim_program_check(fsim, addr, len);
+    if (status != XY_FSIM_OK)
+        return status;
+
+    fsim_settle(fsim);
+    while (len > 0) {
+        chunk = len;
+        if (page != 0 && chunk > page - addr % page)
+            chunk = page - addr % page;
+        fsim_program_apply(fsim, addr, src, chunk);
+        t = fsim->config.timing.cmd_ns
+            + fsim_bus_ns(fsim->config.timing.write_ps, chunk)
+            + fsim_prog_ns(fsim, chunk);
+        fsim->now_ns += t;
+        fsim->stats.prog_ns += t;
+        fsim->stats.programs++;
+        fsim->stats.prog_bytes += chunk;
+        addr += chunk;
+        src += chunk;
+        len -= chunk;
+    }
+    return XY_FSIM_OK;
+}
+
+xy_fsim_status_t xy_fsim_erase(xy_fsim_t *fsim, uint32_t addr, uint32_t size)
+{
+    const xy_fsim_erase_t *type;
+    uint64_t t;
+
+    if (fsim == NULL || fsim->mem == NULL)
+        return XY_FSIM_INVALID_PARAM;
+    type = fsim_erase_type(fsim, size);
+    if (type == NULL || addr % size != 0)
+        return XY_FSIM_ALIGNMENT;
+    if (!fsim_in_range(fsim, addr, size))
+        return XY_FSIM_OUT_OF_RANGE;
+
+    fsim_settle(fsim);
+    fsim_erase_apply(fsim, addr, size);
+    t = fsim->config.timing.cmd_ns + (uint64_t)type->time_us * 1000;
+    fsim->now_ns += t;
+    fsim->stats.erase_ns += t;
+    fsim->stats.erases++;
+    return XY_FSIM_OK;
+}
+
+uint64_t xy_fsim_now(const xy_fsim_t *fsim)
+{
+    return fsim->now_ns;
+}
+
+void xy_fsim_delay(xy_fsim_t *fsim, uint64_t ns)
+{
+    fsim->now_ns += ns;
+}
+
+uint32_t xy_fsim_wear(const xy_fsim_t *fsim, uint32_t addr)
+{
+    if (fsim == NULL || fsim->wear == NULL || addr >= fsim->config.size)
+        return 0;
+    return fsim->wear[addr / fsim_sector_size(fsim)];
+}
+
+void xy_fsim_get_stats(xy_fsim_t *fsim, xy_fsim_stats_t *stats)
+{
+    uint32_t s, w;
+
+    if (fsim == NULL || stats == NULL || fsim->wear == NULL)
+        return;
+    fsim->stats.wear_min = UINT32_MAX;
+    fsim->stats.wear_max = 0;
+    fsim->stats.worn     = 0;
+    for (s = 0; s < fsim->sectors; s++) {
+        w = fsim->wear[s];
+        if (w < fsim->stats.wear_min)
+            fsim->stats.wear_min = w;
+        if (w > fsim->stats.wear_max)
+            fsim->stats.wear_max = w;
+        if (fsim->config.endurance != 0 && w > fsim->config.endurance)
+            fsim->stats.worn++;
+    }
+    *stats = fsim->stats;
+}
+
+void xy_fsim_reset_stats(xy_fsim_t *fsim)
+{
+    memset(&fsim->stats, 0, sizeof(xy_fsim_stats_t));
+}
+
+/* ==================== Byte-Level Port ==================== */
+
+int xy_fsim_port_read(void *ctx, uint32_t addr, void *data, size_t size)
+{
+    return xy_fsim_read((xy_fsim_t *)ctx, addr, data, (uint32_t)size)
+                   == XY_FSIM_OK
+               ? 0
+               : -1;
+}
+
+int xy_fsim_port_write(void *ctx, uint32_t addr, const void *data, size_t size)
+{
+    return xy_fsim_program((xy_fsim_t *)ctx, addr, data, (uint32_t)size)
+                   == XY_FSIM_OK
+               ? 0
+               : -1;
+}
+
+int xy_fsim_port_erase(void *ctx, uint32_t addr)
+{
+    xy_fsim_t *fsim = (xy_fsim_t *)ctx;
+    uint32_t sector = fsim_sector_size(fsim);
+
+    return xy_fsim_erase(fsim, addr - addr % sector, sector) == XY_FSIM_OK ? 0
+                                                                           : -1;
+}
+
+/* ==================== SPI NOR Front End ==================== */
+
+static void fsim_put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t fsim_log2(uint32_t v)
+{
+    uint32_t n = 0;
+
+    while (v > 1) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+}
+
+/* SFDP typical erase time field: 5-bit count, 2-bit unit (1/16/128/1000 ms) */
+static uint32_t fsim_sfdp_time(uint32_t us)
+{
+    static const uint32_t unit_ms[4] = { 1, 16, 128, 1000 };
+    uint32_t ms = (us + 999) / 1000;
+    uint32_t u;
+
+    for (u = 0; u < 3 && (ms + unit_ms[u] / 2) / unit_ms[u] > 32; u++)
+        ;
+    ms = (ms + unit_ms[u] / 2) / unit_ms[u];
+    if (ms == 0)
+        ms = 1;
+    if (ms > 32)
+        ms = 32;
+    return (u << 5) | (ms - 1);
+}
+
+/**
+ * @brief SFDP image: header, one parameter header, 16-DWORD basic table
+ */
+static void fsim_sfdp_build(const xy_fsim_t *fsim, uint8_t *sfdp)
+{
+    const uint32_t tbl = 0x10;
+    uint8_t *bfpt      = sfdp + tbl;
+    uint32_t dw1 = 0xFFF1FFE7, dw10 = 0x2; /* 4K erase: not supported */
+    uint32_t i, n = 0;
+
+    memset(sfdp, 0xFF, 0x50);
+    memcpy(sfdp, "SFDP", 4);
+    sfdp[4]  = 6; /* JESD216B */
+    sfdp[5]  = 1;
+    sfdp[6]  = 0; /* one parameter header */
+    sfdp[8]  = 0x00;
+    sfdp[9]  = 6;
+    sfdp[10] = 1;
+    sfdp[11] = 16;
+    sfdp[12] = (uint8_t)tbl;
+    sfdp[13] = 0;
+    sfdp[14] = 0;
+
+    memset(bfpt, 0, 64);
+    fsim_put32(bfpt + 4, fsim->config.size * 8 - 1); /* density in bits - 1 */
+    for (i = 0; i < XY_FSIM_ERASE_TYPES; i++) {
+        const xy_fsim_erase_t *e = &fsim->config.erase[i];
+        if (e->size == 0 || e->cmd == 0)
+            continue;
+        if (e->size == 4096)
+            dw1 = (dw1 & ~0xFF03u) | 0x1 | ((uint32_t)e->cmd << 8);
+        bfpt[28 + n * 2] = (uint8_t)fsim_log2(e->size);
+        bfpt[29 + n * 2] = e->cmd;
+        dw10 |= fsim_sfdp_time(e->time_us) << (4 + n * 7);
+        n++;
+    }
+    fsim_put32(bfpt + 0, dw1);
+    fsim_put32(bfpt + 36, dw10);
+    if (fsim->config.page_size != 0)
+        fsim_put32(bfpt + 40, fsim_log2(fsim->config.page_size) << 4 | 0x1);
+}
+
+static const xy_fsim_erase_t *fsim_erase_by_cmd(const xy_fsim_t *fsim,
+                                                uint8_t cmd)
+{
+    uint32_t i;
+
+    for (i = 0; i < XY_FSIM_ERASE_TYPES; i++) {
+        if (fsim->config.erase[i].size != 0 && fsim->config.erase[i].cmd == cmd)
+            return &fsim->config.erase[i];
+    }
+    return NULL;
+}
+
+/* Page program; the address wraps inside the page as on the chip */
+static void fsim_spi_program(xy_fsim_t *fsim, uint32_t addr, const uint8_t *tx,
+                             uint32_t len)
+{
+    uint32_t page = fsim->config.page_size;
+    uint32_t base = page != 0 ? addr - addr % page : addr;
+    uint32_t off  = addr - base;
+    uint32_t i;
+
+    if (page != 0 && off + len > page) {
+        fsim->stats.violations++;
+        if (len > page) {
+            /* Only the last page worth of data stays in the page buffer */
+            off = (off + len - page) % page;
+            tx += len - page;
+            len = page;
+        }
+    }
+    /* A failed program is silent on the chip; software sees it on read-back */
+    if (addr % fsim->config.prog_unit != 0 || len % fsim->config.prog_unit != 0
+        || fsim_worn(fsim, base, page != 0 ? page : len))
+        return;
+    for (i = 0; i < len && fsim->config.strict; i++) {
+        if (fsim->mem[base + (page != 0 ? (off + i) % page : i)] != FSIM_ERASED)
+            return;
+    }
+    for (i = 0; i < len; i++)
+        fsim_program_apply(fsim, base + (page != 0 ? (off + i) % page : i),
+                           &tx[i], 1);
+    fsim->busy_until = fsim->now_ns + fsim_prog_ns(fsim, len);
+    fsim->stats.prog_ns += fsim->busy_until - fsim->now_ns;
+    fsim->stats.programs++;
+    fsim->stats.prog_bytes += len;
+}
+
+int xy_fsim_spi(xy_fsim_t *fsim, uint8_t cmd, uint32_t addr, const uint8_t *tx,
+                uint8_t *rx, uint32_t len)
+{
+    const xy_fsim_timing_t *tm = &fsim->config.timing;
+    const xy_fsim_erase_t *type;
+    uint8_t sfdp[0x50];
+    uint32_t id;
+    bool busy;
+    uint64_t t;
+
+    fsim->now_ns += tm->cmd_ns;
+    busy = fsim->now_ns < fsim->busy_until;
+
+    switch (cmd) {
+    case 0x9F: /* JEDEC ID */
+        id = fsim->config.jedec_id != 0 ? fsim->config.jedec_id
+                                        : 0xEF4000u | fsim_log2(fsim->config.size);
+        if (rx != NULL && len >= 3) {
+            rx[0] = (uint8_t)(id >> 16);
+            rx[1] = (uint8_t)(id >> 8);
+            rx[2] = (uint8_t)id;
+        }
+        break;
+    case 0x5A: /* SFDP */
+        if (rx == NULL || addr > sizeof(sfdp) || len > sizeof(sfdp) - addr)
+            return -1;
+        fsim_sfdp_build(fsim, sfdp);
+        memcpy(rx, sfdp + addr, len);
+        break;
+    case 0x05: /* status register 1 */
+        if (rx != NULL && len >= 1)
+            rx[0] = (uint8_t)((busy ? 0x01 : 0) | (fsim->wel ? 0x02 : 0));
+        break;
+    case 0x06:
+        fsim->wel = true;
+        break;
+    case 0x04:
+        fsim->wel = false;
+        break;
+    case 0x03:
+    case 0x0B:
+    case 0xEB:
+        if (rx == NULL || !fsim_in_range(fsim, addr, len))
+            return -1;
+        if (busy)
+            fsim->stats.violations++;
+        memcpy(rx, fsim->mem + addr, len);
+        t = fsim_bus_ns(tm->read_ps, len);
+        fsim->now_ns += t;
+        fsim->stats.read_ns += tm->cmd_ns + t;
+        fsim->stats.reads++;
+        fsim->stats.read_bytes += len;
+        return 0;
+    case 0x02:
+        if (tx == NULL || !fsim_in_range(fsim, addr, len))
+            return -1;
+        fsim->now_ns += fsim_bus_ns(tm->write_ps, len);
+        fsim->stats.prog_ns += tm->cmd_ns + fsim_bus_ns(tm->write_ps, len);
+        if (busy || !fsim->wel) {
+            fsim->stats.violations++;
+            return 0;
+        }
+        fsim->wel = false;
+        fsim_spi_program(fsim, addr, tx, len);
+        return 0;
+    case 0xC7:
+    case 0x60:
+        if (busy || !fsim->wel) {
+            fsim->stats.violations++;
+            return 0;
+        }
+        fsim->wel = false;
+        fsim_erase_apply(fsim, 0, fsim->config.size);
+        /* Typical chip erase: the whole device in the largest erase blocks */
+        for (type = &fsim->config.erase[0];
+             type + 1 < &fsim->config.erase[XY_FSIM_ERASE_TYPES]
+             && (type + 1)->size != 0;
+             type++)
+            ;
+        t = (uint64_t)type->time_us * 1000 * (fsim->config.size / type->size);
+        fsim->busy_until = fsim->now_ns + t;
+        fsim->stats.erase_ns += tm->cmd_ns + t;
+        fsim->stats.erases++;
+        return 0;
+    case 0xB9:
+    case 0xAB:
+        break;
+    default:
+        type = fsim_erase_by_cmd(fsim, cmd);
+        if (type == NULL || type->cmd == 0)
+            break;
+        if (addr % type->size != 0 || !fsim_in_range(fsim, addr, type->size))
+            return -1;
+        if (busy || !fsim->wel) {
+            fsim->stats.violations++;
+            return 0;
+        }
+        fsim->wel = false;
+        fsim_erase_apply(fsim, addr, type->size);
+        t                = (uint64_t)type->time_us * 1000;
+        fsim->busy_until = fsim->now_ns + t;
+        fsim->stats.erase_ns += tm->cmd_ns + t;
+        fsim->stats.erases++;
+        return 0;
+    }
+    fsim->now_ns += fsim_bus_ns(tm->read_ps, len);
+    return 0;
+}
+
+int xy_fsim_spi_send_cmd(void *ctx, uint8_t cmd, uint32_t addr,
+                         const uint8_t *tx, uint8_t *rx, uint32_t len)
+{
+    return xy_fsim_spi((xy_fsim_t *)ctx, cmd, addr, tx, rx, len);
+}
+
+void xy_fsim_spi_write_enable(void *ctx)
+{
+    xy_fsim_spi((xy_fsim_t *)ctx, 0x06, 0, NULL, NULL, 0);
+}
+
+void xy_fsim_spi_wait_ready(void *ctx)
+{
+    xy_fsim_t *fsim = (xy_fsim_t *)ctx;
+    uint8_t sr      = 0;
+
+    /* One status read, then skip ahead to the end of the operation */
+    xy_fsim_spi(fsim, 0x05, 0, NULL, &sr, 1);
+    if (sr & 0x01)
+        fsim->now_ns = fsim->busy_until;
+}
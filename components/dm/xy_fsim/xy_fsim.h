@@ -0,0 +1,235 @@
+/**
+ * @file xy_fsim.h
+ * @brief File-backed flash simulator with a timing and wear model
+ *
+ * Host-side stand-in for a flash device, so storage engines can be
+ * benchmarked and compared deterministically on Linux:
+ * - contents live in an mmap'd file (a raw image of the device, followed by
+ *   a trailer with the per-sector erase counters), so state and wear survive
+ *   a reopen, which is how a remount or a power cycle is modelled
+ * - time is virtual: every operation advances a nanosecond clock by its
+ *   datasheet cost (command overhead + per-byte bus time + array time)
+ * - programming only clears bits, within program units and pages; with
+ *   @c strict (ECC flash) a unit can be programmed once per erase
+ * - erases count wear per sector; sectors past @c endurance fail programs
+ *
+ * Two front ends:
+ * - byte level (xy_fsim_read/program/erase and the xy_fsim_port_* wrappers
+ *   with the eee_port_t signatures): blocking, each call completes in virtual
+ *   time before it returns
+ * - SPI NOR commands (xy_fsim_spi_*): program and erase start and set WIP,
+ *   software polls the status register as on hardware. Backs the xy_nor port
+ *   hooks (xy_fsim_nor.c) and norflash_t callbacks, with a generated SFDP
+ *   table so norflash_init() finds the configured erase types and times.
+ *
+ * POSIX hosts only. Not thread safe.
+ */
+
+#ifndef XY_FSIM_H
+#define XY_FSIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Configuration ==================== */
+
+#define XY_FSIM_ERASE_TYPES 4 /**< Erase types per device, as in SFDP */
+
+/* ==================== Types ==================== */
+
+typedef enum {
+    XY_FSIM_OK = 0,
+    XY_FSIM_INVALID_PARAM, /**< Bad argument or configuration */
+    XY_FSIM_OUT_OF_RANGE,  /**< Address range outside the device */
+    XY_FSIM_ALIGNMENT,     /**< Not on a program unit or erase boundary */
+    XY_FSIM_PROGRAM_FAIL,  /**< Unit not erased (strict) or sector worn out */
+    XY_FSIM_IO,            /**< Backing file could not be opened or mapped */
+} xy_fsim_status_t;
+
+/** One erase granularity; erase[0] must be the smallest (the wear unit) */
+typedef struct {
+    uint32_t size;    /**< Bytes, power of two, 0 = unused */
+    uint32_t time_us; /**< Typical erase time */
+    uint8_t cmd;      /**< SPI opcode, 0 if the SPI front end has none */
+} xy_fsim_erase_t;
+
+/** Datasheet timings; bus times are per operation and per byte */
+typedef struct {
+    uint32_t cmd_ns;        /**< Command/address phase of every operation */
+    uint32_t read_ps;       /**< Read transfer per byte, picoseconds */
+    uint32_t write_ps;      /**< Program transfer per byte, picoseconds */
+    uint32_t prog_base_ns;  /**< Array time of a program, fixed part */
+    uint32_t prog_unit_ns;  /**< Array time per program unit */
+} xy_fsim_timing_t;
+
+typedef struct {
+    const char *path;   /**< Backing file, NULL for anonymous memory */
+    bool format;        /**< Discard existing contents and wear */
+    uint32_t size;      /**< Device size, multiple of erase[0].size */
+    uint32_t prog_unit; /**< Program granularity in bytes (1 for SPI NOR) */
+    uint32_t page_size; /**< One program may not cross a page, 0 = no limit */
+    bool strict;        /**< Program only fully erased units (ECC flash) */
+    uint32_t endurance; /**< Erase cycles per sector, 0 = unlimited */
+    uint32_t jedec_id;  /**< SPI front end, 0 = Winbond-style from size */
+    xy_fsim_erase_t erase[XY_FSIM_ERASE_TYPES];
+    xy_fsim_timing_t timing;
+} xy_fsim_config_t;
+
+typedef struct {
+    uint64_t reads;         /**< Read operations */
+    uint64_t read_bytes;
+    uint64_t programs;      /**< Program operations */
+    uint64_t prog_bytes;
+    uint64_t erases;        /**< Erase operations, any size */
+    uint64_t read_ns;       /**< Virtual time spent per kind of operation */
+    uint64_t prog_ns;
+    uint64_t erase_ns;
+    uint32_t lost_bits;     /**< 1 bits programmed over 0 (data not stored) */
+    uint32_t violations;    /**< SPI protocol errors: no WEL, access while WIP */
+    uint32_t wear_min;      /**< Lowest sector erase count */
+    uint32_t wear_max;      /**< Highest sector erase count */
+    uint32_t worn;          /**< Sectors past the endurance */
+} xy_fsim_stats_t;
+
+typedef struct {
+    xy_fsim_config_t config;
+    uint8_t *mem;           /**< Device contents, mapped; reads may use it directly */
+    uint32_t *wear;         /**< Erase count per erase[0] sector, in the file */
+    size_t map_size;
+    int fd;
+    uint32_t sectors;
+    uint64_t now_ns;        /**< Virtual clock */
+    uint64_t busy_until;    /**< SPI front end: WIP clears at this time */
+    bool wel;               /**< SPI front end: write enable latch */
+    xy_fsim_stats_t stats;  /**< wear_* and worn are filled by xy_fsim_get_stats() */
+} xy_fsim_t;
+
+/* ==================== API ==================== */
+
+/**
+ * @brief Fill @p config with a W25Q-class SPI NOR: 256 B pages, 4K/32K/64K
+ *        erases, 50 MHz quad read, 100k cycles
+ * @param config Configuration
+ * @param size Device size in bytes
+ */
+void xy_fsim_config_nor(xy_fsim_config_t *config, uint32_t size);
+
+/**
+ * @brief Fill @p config with MCU internal flash: 64-bit ECC program units,
+ *        2 KB pages, 10k cycles
+ * @param config Configuration
+ * @param size Device size in bytes
+ */
+void xy_fsim_config_eflash(xy_fsim_config_t *config, uint32_t size);
+
+/**
+ * @brief Open or create the device
+ *
+ * An existing file with the same geometry keeps its contents and wear;
+ * otherwise (or with config->format) the device starts erased and unworn.
+ * @param fsim Simulator
+ * @param config Configuration, copied
+ * @return xy_fsim_status_t Operation result
+ */
+xy_fsim_status_t xy_fsim_open(xy_fsim_t *fsim, const xy_fsim_config_t *config);
+
+/**
+ * @brief Flush and unmap; the file keeps contents and wear
+ * @param fsim Simulator
+ */
+void xy_fsim_close(xy_fsim_t *fsim);
+
+/**
+ * @brief Read, blocking in virtual time
+ */
+xy_fsim_status_t xy_fsim_read(xy_fsim_t *fsim, uint32_t addr, void *data,
+                              uint32_t len);
+
+/**
+ * @brief Program, blocking in virtual time; may span pages (one program
+ *        operation per page is charged)
+ */
+xy_fsim_status_t xy_fsim_program(xy_fsim_t *fsim, uint32_t addr,
+                                 const void *data, uint32_t len);
+
+/**
+ * @brief Erase one block of a configured erase size, blocking in virtual time
+ */
+xy_fsim_status_t xy_fsim_erase(xy_fsim_t *fsim, uint32_t addr, uint32_t size);
+
+/**
+ * @brief Virtual time in nanoseconds since open
+ */
+uint64_t xy_fsim_now(const xy_fsim_t *fsim);
+
+/**
+ * @brief Advance the virtual clock (CPU work between flash operations)
+ */
+void xy_fsim_delay(xy_fsim_t *fsim, uint64_t ns);
+
+/**
+ * @brief Erase count of the sector holding @p addr
+ */
+uint32_t xy_fsim_wear(const xy_fsim_t *fsim, uint32_t addr);
+
+/**
+ * @brief Get statistics, with the wear summary computed now
+ */
+void xy_fsim_get_stats(xy_fsim_t *fsim, xy_fsim_stats_t *stats);
+
+/**
+ * @brief Clear operation counters and times; wear is kept
+ */
+void xy_fsim_reset_stats(xy_fsim_t *fsim);
+
+/* ==================== Byte-Level Port ==================== */
+
+/* Signatures of eee_port_t, ctx is the xy_fsim_t; return 0 on success */
+int xy_fsim_port_read(void *ctx, uint32_t addr, void *data, size_t size);
+int xy_fsim_port_write(void *ctx, uint32_t addr, const void *data, size_t size);
+int xy_fsim_port_erase(void *ctx, uint32_t addr); /**< Sector holding @p addr */
+
+/* ==================== SPI NOR Front End ==================== */
+
+/**
+ * @brief Execute one SPI NOR command
+ *
+ * Supports 9F (ID), 5A (SFDP), 05 (status), 06/04 (WEL), 03/0B/EB (read),
+ * 02 (page program), the configured erase opcodes (20/52/D8), C7/60
+ * (chip erase), B9/AB (power down). Unknown commands only cost bus time.
+ * Program and erase return at once and leave WIP set for their array time;
+ * commands that need WEL or an idle device count a violation and are
+ * ignored, as the chip would.
+ * @param fsim Simulator
+ * @param cmd Opcode
+ * @param addr Address (ignored by commands without one)
+ * @param tx Data sent after the address, or NULL
+ * @param rx Data received, or NULL
+ * @param len Data phase length
+ * @return int 0, or -1 for an invalid address
+ */
+int xy_fsim_spi(xy_fsim_t *fsim, uint8_t cmd, uint32_t addr, const uint8_t *tx,
+                uint8_t *rx, uint32_t len);
+
+/* norflash_t callbacks, ctx is the xy_fsim_t */
+int xy_fsim_spi_send_cmd(void *ctx, uint8_t cmd, uint32_t addr,
+                         const uint8_t *tx, uint8_t *rx, uint32_t len);
+void xy_fsim_spi_write_enable(void *ctx);
+void xy_fsim_spi_wait_ready(void *ctx); /**< Spins until WIP clears */
+
+/**
+ * @brief Route the xy_nor port hooks (xy_fsim_nor.c) to @p fsim;
+ *        call before xy_nor_init()
+ */
+void xy_fsim_nor_attach(xy_fsim_t *fsim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XY_FSIM_H */
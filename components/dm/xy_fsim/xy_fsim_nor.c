@@ -0,0 +1,49 @@
+/**
+ * @file xy_fsim_nor.c
+ * @brief xy_nor port hooks on the simulator's SPI NOR front end
+ *
+ * Link instead of xy_nor_port.c and call xy_fsim_nor_attach() before
+ * xy_nor_init(). xy_nor_hw_delay_ms() advances the virtual clock, so the
+ * driver's WIP polling costs exactly what it would on the bus.
+ */
+
+#include "xy_fsim.h"
+#include "xy_nor.h"
+
+static xy_fsim_t *s_fsim;
+
+void xy_fsim_nor_attach(xy_fsim_t *fsim)
+{
+    s_fsim = fsim;
+}
+
+void *xy_nor_hw_init(const xy_nor_config_t *config)
+{
+    (void)config;
+    return s_fsim;
+}
+
+void xy_nor_hw_deinit(void *hw_handle)
+{
+    (void)hw_handle;
+}
+
+xy_nor_status_t xy_nor_hw_command(void *hw_handle, uint8_t cmd, uint32_t addr,
+                                  uint8_t addr_len, uint8_t *data,
+                                  uint32_t data_len, bool is_write)
+{
+    (void)addr_len;
+    if (xy_fsim_spi((xy_fsim_t *)hw_handle, cmd, addr, is_write ? data : NULL,
+                    is_write ? NULL : data, data_len)
+        != 0) {
+        return XY_NOR_INVALID_PARAM;
+    }
+    return XY_NOR_OK;
+}
+
+void xy_nor_hw_delay_ms(uint32_t ms)
+{
+    if (s_fsim != NULL) {
+        xy_fsim_delay(s_fsim, (uint64_t)ms * 1000000);
+    }
+}
@@ -0,0 +1,15 @@
+/**
+ * @file mem_port.h
+ * @brief Host port for the xy_mem bench: ssize_t for xy_typedef.h and the
+ * critical section, which the bench counts
+ */
+
+#ifndef _MEM_PORT_H_
+#define _MEM_PORT_H_
+
+#include <sys/types.h>
+
+void xy_enter_critical(void);
+void xy_exit_critical(void);
+
+#endif
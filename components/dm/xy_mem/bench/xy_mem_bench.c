@@ -0,0 +1,529 @@
+/**
+ * @file xy_mem_bench.c
+ * @brief xy_mem heap and ISR pool on the host: edge cases, stress, cost
+ *
+ * 1. Split: exact fit, a remainder too small to keep (absorbed) and one
+ *    just large enough (split off); zero-size, tiny and oversize requests.
+ * 2. Merge: a freed block joins the next block, the previous block, both,
+ *    and the free tail; freeing everything leaves one block.
+ * 3. Reuse: xy_mem has no realloc, callers shrink by freeing and allocating
+ *    again and grow by allocating, copying and freeing. Shrinking lands on
+ *    the same block and splits it; growing copies through xy_mem_copy,
+ *    which must handle overlap both ways.
+ * 4. ISR pool: pool exhausted, fallback to the heap, large requests, frees
+ *    from thread and interrupt side, and a heap too small for the pool.
+ * 5. Stress: random sizes and lifetimes, every byte checked on free; the
+ *    boundary tags of live blocks plus the free bytes add up to the heap.
+ * 6. Cost per malloc/free pair in steady state, against libc.
+ *
+ * The checks read the size word in front of a block (the boundary tag) to
+ * see how much the heap really gave out.
+ */
+
+#include "xy_mem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* As in xy_mem.c */
+#define MEM_ALIGN  (sizeof(xy_size_t) > 4 ? sizeof(xy_size_t) : 4)
+#define ALIGN_UP(x) (((x) + MEM_ALIGN - 1) & ~(xy_size_t)(MEM_ALIGN - 1))
+#define MEM_HEAD   sizeof(xy_size_t)
+#define MEM_MIN    ALIGN_UP(2 * sizeof(xy_size_t) + 2 * sizeof(void *))
+#define IRQ_BLOCK  ALIGN_UP((xy_size_t)XY_MEM_IRQ_BLOCK_SIZE)
+#define IRQ_BYTES  ((xy_size_t)XY_MEM_IRQ_BLOCK_NUM * IRQ_BLOCK)
+
+#define HEAP_WORDS 2048 /* 16 KB on 64-bit hosts */
+#define SLOTS      64
+#define STRESS_OPS 200000
+#define BENCH_OPS  1000000
+
+static xy_size_t s_ram[HEAP_WORDS];
+static xy_uint32_t s_rand = 1;
+static int s_fails;
+
+/* Critical section: depth must come back to 0, never nest */
+static int s_crit_depth;
+static int s_crit_nested;
+
+void xy_enter_critical(void)
+{
+    if (s_crit_depth++ != 0)
+        s_crit_nested++;
+}
+
+void xy_exit_critical(void)
+{
+    s_crit_depth--;
+}
+
+#define CHECK(cond)                                                   \
+    do {                                                              \
+        if (!(cond)) {                                                \
+            printf("  FAIL line %d: %s\n", __LINE__, #cond);          \
+            s_fails++;                                                \
+        }                                                             \
+    } while (0)
+
+static xy_uint32_t rnd(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Bytes the heap gave out for p, from its boundary tag */
+static xy_size_t block_size(void *p)
+{
+    return ((xy_size_t *)p)[-1] & ~(xy_size_t)3;
+}
+
+static xy_bool in_pool(void *p)
+{
+    xy_uint8_t *base = (xy_uint8_t *)s_ram;
+
+    return (xy_uint8_t *)p >= base && (xy_uint8_t *)p < base + IRQ_BYTES;
+}
+
+static xy_mem_stat_t stat_now(void)
+{
+    xy_mem_stat_t st;
+
+    xy_mem_stat(&st);
+    return st;
+}
+
+static void check_empty(const char *what)
+{
+    xy_mem_stat_t st = stat_now();
+
+    if (st.free_blocks != 1 || st.free != st.total || st.frag != 0 ||
+        st.alloc_num != 0) {
+        printf("  FAIL %s: %u free blocks, %u of %u bytes free, %u allocated\n",
+               what, (unsigned)st.free_blocks, (unsigned)st.free,
+               (unsigned)st.total, (unsigned)st.alloc_num);
+        s_fails++;
+    }
+}
+
+/* ==================== 1. Split ==================== */
+
+static void check_split(void)
+{
+    xy_mem_stat_t st;
+    xy_size_t total;
+    void *p, *q, *r;
+
+    printf("split\n");
+    xy_mem_init(s_ram, sizeof(s_ram));
+    st    = stat_now();
+    total = st.total;
+    CHECK(st.free_blocks == 1 && st.free == total && st.irq_total == XY_MEM_IRQ_BLOCK_NUM);
+    CHECK(total == sizeof(s_ram) - IRQ_BYTES - MEM_HEAD);
+
+    /* The whole heap in one request */
+    p  = xy_mem_malloc(total - MEM_HEAD);
+    st = stat_now();
+    CHECK(p != XY_NULL && block_size(p) == total);
+    CHECK(st.free == 0 && st.free_blocks == 0);
+    CHECK(xy_mem_malloc(1) == XY_NULL);
+    xy_mem_free(p);
+    check_empty("exact fit");
+
+    /* A remainder below MEM_MIN cannot hold a free block: it stays with p */
+    p  = xy_mem_malloc(total - MEM_HEAD - (MEM_MIN - MEM_ALIGN));
+    st = stat_now();
+    CHECK(p != XY_NULL && block_size(p) == total);
+    CHECK(st.free == 0 && st.free_blocks == 0);
+    xy_mem_free(p);
+    check_empty("absorbed remainder");
+
+    /* A remainder of exactly MEM_MIN is split off, and is enough for 1 byte */
+    p  = xy_mem_malloc(total - MEM_HEAD - MEM_MIN);
+    st = stat_now();
+    CHECK(p != XY_NULL && block_size(p) == total - MEM_MIN);
+    CHECK(st.free == MEM_MIN && st.free_blocks == 1);
+    q = xy_mem_malloc(1);
+    CHECK(q == (xy_uint8_t *)p + block_size(p) && block_size(q) == MEM_MIN);
+    st = stat_now();
+    CHECK(st.free == 0 && st.free_blocks == 0);
+    r  = xy_mem_malloc(0);
+    st = stat_now();
+    CHECK(r == XY_NULL && st.fail_num == 2);
+    xy_mem_free(p);
+    xy_mem_free(q);
+    check_empty("minimum remainder");
+
+    /* Small requests round up to MEM_MIN, then by MEM_ALIGN */
+    p = xy_mem_malloc(0);
+    q = xy_mem_malloc(MEM_MIN - MEM_HEAD);
+    r = xy_mem_malloc(MEM_MIN - MEM_HEAD + 1);
+    CHECK(p && q && r);
+    CHECK(block_size(p) == MEM_MIN && block_size(q) == MEM_MIN);
+    CHECK(block_size(r) == MEM_MIN + MEM_ALIGN);
+    CHECK(q == (xy_uint8_t *)p + MEM_MIN && r == (xy_uint8_t *)q + MEM_MIN);
+    CHECK(((xy_size_t)p | (xy_size_t)q | (xy_size_t)r) % MEM_ALIGN == 0);
+    xy_mem_free(q);
+    xy_mem_free(r);
+    xy_mem_free(p);
+    check_empty("small requests");
+
+    /* Larger than the heap, and sizes that would wrap once the header is added */
+    CHECK(xy_mem_malloc(total) == XY_NULL);
+    CHECK(xy_mem_malloc((xy_size_t)-1) == XY_NULL);
+    CHECK(xy_mem_malloc((xy_size_t)-1 - MEM_HEAD + 1) == XY_NULL);
+    xy_mem_free(XY_NULL);
+    xy_mem_free_from_irq(XY_NULL);
+    check_empty("oversize");
+}
+
+/* ==================== 2. Merge ==================== */
+
+static void check_merge(void)
+{
+    xy_mem_stat_t st;
+    void *a, *b, *c, *g, *p;
+    xy_size_t sz;
+
+    printf("merge\n");
+    xy_mem_init(s_ram, sizeof(s_ram));
+    a  = xy_mem_malloc(100);
+    b  = xy_mem_malloc(100);
+    c  = xy_mem_malloc(100);
+    g  = xy_mem_malloc(100); /* keeps c away from the free tail */
+    sz = block_size(a);
+    CHECK(a && b && c && g);
+    CHECK((xy_uint8_t *)b == (xy_uint8_t *)a + sz && (xy_uint8_t *)c == (xy_uint8_t *)b + sz);
+    CHECK(stat_now().free_blocks == 1);
+
+    /* With the next block: b, then a */
+    xy_mem_free(b);
+    CHECK(stat_now().free_blocks == 2);
+    xy_mem_free(a);
+    CHECK(stat_now().free_blocks == 2);
+    p = xy_mem_malloc(2 * sz - MEM_HEAD);
+    CHECK(p == a && block_size(p) == 2 * sz);
+    xy_mem_free(p);
+
+    /* With the previous block: a, then b */
+    a = xy_mem_malloc(100);
+    b = xy_mem_malloc(100);
+    CHECK(stat_now().free_blocks == 1);
+    xy_mem_free(a);
+    xy_mem_free(b);
+    CHECK(stat_now().free_blocks == 2);
+    p = xy_mem_malloc(2 * sz - MEM_HEAD);
+    CHECK(p == a && block_size(p) == 2 * sz);
+    xy_mem_free(p);
+
+    /* With both: a and c, then b */
+    a = xy_mem_malloc(100);
+    b = xy_mem_malloc(100);
+    CHECK(stat_now().free_blocks == 1);
+    xy_mem_free(a);
+    xy_mem_free(c);
+    CHECK(stat_now().free_blocks == 3);
+    xy_mem_free(b);
+    st = stat_now();
+    CHECK(st.free_blocks == 2 && st.max_free > 3 * sz);
+    p = xy_mem_malloc(3 * sz - MEM_HEAD);
+    CHECK(p == a && block_size(p) == 3 * sz);
+
+    /* With the free tail: g */
+    xy_mem_free(g);
+    st = stat_now();
+    CHECK(st.free_blocks == 1 && st.free == st.total - 3 * sz);
+    xy_mem_free(p);
+    check_empty("merge");
+}
+
+/* ==================== 3. Reuse ==================== */
+
+static void check_reuse(void)
+{
+    xy_uint8_t ref[200], *p, *q, *r, *n, *g;
+    xy_size_t i, big;
+
+    printf("reuse (shrink and grow without realloc)\n");
+    xy_mem_init(s_ram, sizeof(s_ram));
+    p = xy_mem_malloc(200);
+    g = xy_mem_malloc(16);
+    CHECK(p && g);
+    big = block_size(p);
+
+    /* Shrink: the same block comes back, split, and the rest is next in line */
+    xy_mem_free(p);
+    q = xy_mem_malloc(60);
+    CHECK(q == p && block_size(q) == ALIGN_UP(60 + MEM_HEAD));
+    CHECK(stat_now().free_blocks == 2);
+    r = xy_mem_malloc(60);
+    CHECK(r == q + block_size(q));
+    CHECK(block_size(q) + block_size(r) <= big);
+
+    /* Grow: allocate, copy, free; the freed 60 joins its free neighbour */
+    for (i = 0; i < 60; i++)
+        q[i] = (xy_uint8_t)(i * 7 + 1);
+    n = xy_mem_malloc(400);
+    CHECK(n != XY_NULL);
+    xy_mem_copy(n, q, 60);
+    CHECK(memcmp(n, q, 60) == 0);
+    xy_mem_free(q);
+    xy_mem_free(r);
+    q = xy_mem_malloc(big - MEM_HEAD);
+    CHECK(q == p);
+    xy_mem_free(q);
+
+    /* Overlapping copies, both directions, as memmove */
+    for (i = 0; i < 200; i++)
+        n[i] = ref[i] = (xy_uint8_t)(i * 13 + 5);
+    xy_mem_copy(n + 10, n, 150);
+    memmove(ref + 10, ref, 150);
+    CHECK(memcmp(n, ref, 200) == 0);
+    xy_mem_copy(n, n + 30, 150);
+    memmove(ref, ref + 30, 150);
+    CHECK(memcmp(n, ref, 200) == 0);
+
+    xy_mem_free(n);
+    xy_mem_free(g);
+    check_empty("reuse");
+}
+
+/* ==================== 4. ISR pool ==================== */
+
+static void check_irq(void)
+{
+    void *blk[XY_MEM_IRQ_BLOCK_NUM], *extra, *large;
+    xy_mem_stat_t st;
+    xy_size_t small[MEM_MIN / sizeof(xy_size_t) + IRQ_BYTES / sizeof(xy_size_t)];
+    int i, j;
+
+    printf("ISR pool\n");
+    xy_mem_init(s_ram, sizeof(s_ram));
+    for (i = 0; i < XY_MEM_IRQ_BLOCK_NUM; i++) {
+        blk[i] = xy_mem_malloc_from_irq(XY_MEM_IRQ_BLOCK_SIZE);
+        CHECK(blk[i] != XY_NULL && in_pool(blk[i]));
+        for (j = 0; j < i; j++)
+            CHECK(blk[i] != blk[j]);
+        memset(blk[i], 0xA5, XY_MEM_IRQ_BLOCK_SIZE);
+    }
+    st = stat_now();
+    CHECK(st.irq_free == 0 && st.irq_min_free == 0 && st.alloc_num == 0);
+    CHECK(st.free == st.total);
+
+    /* Pool empty: the heap serves it, and so any request over the block size */
+    extra = xy_mem_malloc_from_irq(1);
+    large = xy_mem_malloc_from_irq(XY_MEM_IRQ_BLOCK_SIZE + 1);
+    st    = stat_now();
+    CHECK(extra && !in_pool(extra) && large && !in_pool(large));
+    CHECK(st.irq_fallback == 1 && st.alloc_num == 2);
+
+    /* Either side may free either kind */
+    for (i = 0; i < XY_MEM_IRQ_BLOCK_NUM; i++) {
+        if (i & 1)
+            xy_mem_free(blk[i]);
+        else
+            xy_mem_free_from_irq(blk[i]);
+    }
+    xy_mem_free(extra);
+    xy_mem_free_from_irq(large);
+    st = stat_now();
+    CHECK(st.irq_free == XY_MEM_IRQ_BLOCK_NUM && st.irq_min_free == 0);
+    check_empty("ISR pool");
+
+    /* Last in, first out */
+    CHECK(xy_mem_malloc_from_irq(1) == blk[XY_MEM_IRQ_BLOCK_NUM - 1]);
+
+    /* No room for the pool next to a minimum block: all from the heap */
+    xy_mem_init(small, sizeof(small) - MEM_ALIGN);
+    st = stat_now();
+    CHECK(st.irq_total == 0 && st.total >= MEM_MIN);
+    extra = xy_mem_malloc_from_irq(1);
+    CHECK(extra != XY_NULL && stat_now().alloc_num == 1);
+    xy_mem_free_from_irq(extra);
+    CHECK(stat_now().free == st.total);
+
+    /* Too small for even one block */
+    xy_mem_init(small, MEM_MIN);
+    CHECK(stat_now().total == 0 && xy_mem_malloc(0) == XY_NULL);
+}
+
+/* ==================== 5. Stress ==================== */
+
+static xy_size_t rnd_size(void)
+{
+    xy_uint32_t r = rnd();
+
+    /* Mostly small, some medium, a few large */
+    if ((r & 7) < 5)
+        return (r >> 3) % 48;
+    if ((r & 7) < 7)
+        return (r >> 3) % 400;
+    return (r >> 3) % 3000;
+}
+
+static void fill(xy_uint8_t *p, xy_size_t n, xy_uint8_t seed)
+{
+    while (n--)
+        *p++ = seed++;
+}
+
+static int verify(const xy_uint8_t *p, xy_size_t n, xy_uint8_t seed)
+{
+    while (n--) {
+        if (*p++ != seed++)
+            return 0;
+    }
+    return 1;
+}
+
+static void check_stress(void)
+{
+    xy_uint8_t *ptr[SLOTS];
+    xy_size_t len[SLOTS];
+    xy_uint8_t seed[SLOTS];
+    xy_mem_stat_t st;
+    xy_size_t used;
+    unsigned allocs = 0, nulls = 0, bad = 0, worst_frag = 0;
+    int i, s, live;
+
+    printf("stress: %u random operations on %u slots\n", STRESS_OPS, SLOTS);
+    xy_mem_init(s_ram, sizeof(s_ram));
+    memset(ptr, 0, sizeof(ptr));
+    for (i = 0; i < STRESS_OPS; i++) {
+        s = (int)(rnd() % SLOTS);
+        if (ptr[s] == XY_NULL) {
+            len[s]  = rnd_size();
+            seed[s] = (xy_uint8_t)rnd();
+            ptr[s]  = (rnd() & 3) == 0 ? xy_mem_malloc_from_irq(len[s])
+                                       : xy_mem_malloc(len[s]);
+            if (ptr[s] == XY_NULL) {
+                nulls++;
+                continue;
+            }
+            allocs++;
+            fill(ptr[s], len[s], seed[s]);
+        } else {
+            if (!verify(ptr[s], len[s], seed[s]))
+                bad++;
+            if (rnd() & 1)
+                xy_mem_free(ptr[s]);
+            else
+                xy_mem_free_from_irq(ptr[s]);
+            ptr[s] = XY_NULL;
+        }
+
+        if (i % 1000 == 999) {
+            st   = stat_now();
+            used = 0;
+            live = 0;
+            for (s = 0; s < SLOTS; s++) {
+                if (ptr[s] && !in_pool(ptr[s])) {
+                    used += block_size(ptr[s]);
+                    live++;
+                }
+            }
+            CHECK(used + st.free == st.total && live == st.alloc_num);
+            if (worst_frag < st.frag)
+                worst_frag = st.frag;
+        }
+    }
+    for (s = 0; s < SLOTS; s++) {
+        if (ptr[s]) {
+            if (!verify(ptr[s], len[s], seed[s]))
+                bad++;
+            xy_mem_free(ptr[s]);
+        }
+    }
+    st = stat_now();
+    printf("  %u allocations, %u refused (heap full), worst frag %u%%, "
+           "peak %u of %u bytes, pool low water %u\n",
+           allocs, nulls, worst_frag, (unsigned)st.used_peak, (unsigned)st.total,
+           (unsigned)st.irq_min_free);
+    CHECK(bad == 0);
+    CHECK(st.irq_free == XY_MEM_IRQ_BLOCK_NUM);
+    check_empty("stress");
+}
+
+/* ==================== 6. Cost ==================== */
+
+static double bench_pairs(int use_libc)
+{
+    void *ptr[SLOTS];
+    xy_size_t sizes[1024];
+    double t0;
+    int i, s;
+
+    xy_mem_init(s_ram, sizeof(s_ram));
+    s_rand = 7;
+    for (i = 0; i < 1024; i++) {
+        sizes[i] = rnd() % 128 + 1;
+    }
+    for (s = 0; s < SLOTS; s++)
+        ptr[s] = use_libc ? malloc(sizes[s]) : xy_mem_malloc(sizes[s]);
+
+    t0 = now_ns();
+    for (i = 0; i < BENCH_OPS; i++) {
+        s = i % SLOTS;
+        if (use_libc) {
+            free(ptr[s]);
+            ptr[s] = malloc(sizes[i & 1023]);
+        } else {
+            xy_mem_free(ptr[s]);
+            ptr[s] = xy_mem_malloc(sizes[i & 1023]);
+        }
+    }
+    t0 = now_ns() - t0;
+
+    for (s = 0; s < SLOTS; s++) {
+        if (use_libc)
+            free(ptr[s]);
+        else
+            xy_mem_free(ptr[s]);
+    }
+    return t0 / BENCH_OPS;
+}
+
+static double bench_pool(void)
+{
+    void *p;
+    double t0;
+    int i;
+
+    xy_mem_init(s_ram, sizeof(s_ram));
+    t0 = now_ns();
+    for (i = 0; i < BENCH_OPS; i++) {
+        p = xy_mem_malloc_from_irq(XY_MEM_IRQ_BLOCK_SIZE);
+        xy_mem_free_from_irq(p);
+    }
+    return (now_ns() - t0) / BENCH_OPS;
+}
+
+int main(void)
+{
+    check_split();
+    check_merge();
+    check_reuse();
+    check_irq();
+    check_stress();
+    CHECK(s_crit_depth == 0 && s_crit_nested == 0);
+
+    printf("\nfree + malloc, 1..128 bytes, %u live blocks\n", SLOTS);
+    printf("  xy_mem heap      %6.1f ns\n", bench_pairs(0));
+    printf("  libc             %6.1f ns\n", bench_pairs(1));
+    printf("  xy_mem ISR pool  %6.1f ns\n", bench_pool());
+
+    if (s_fails) {
+        printf("\n%d checks failed\n", s_fails);
+        return 1;
+    }
+    printf("\nall checks passed\n");
+    return 0;
+}
@@ -4,14 +4,81 @@
 // #error "xy_enter_critical() and xy_exit_critical() need to be defined for
 // your platform."
 
+/**
+ * 块布局(边界标记):
+ *   已用块: | mem_size | 用户数据 ...                        |
+ *   空闲块: | mem_size | next | prev | ...        | mem_size |
+ * mem_size 为整块字节数, 低 2 位是标志: bit0 本块已用, bit1 前一块已用.
+ * 空闲块尾部重复保存大小, 释放时据此 O(1) 找到前一块并合并; 相邻空闲块
+ * 总是立即合并, 所以不会出现两个相邻的空闲块.
+ *
+ * 空闲块按大小 [2^k, 2^(k+1)) 挂到第 k 级链表, s_heap.map 的第 k 位表示
+ * 该级非空. 分配先看本级链表头, 不够则取更高一级中任意一块(必然够用),
+ * 只有更高级都为空时才遍历本级链表.
+ */
 typedef struct _xy_mem {
     xy_size_t mem_size;
-    // 8051中xdata的指针为2byte，所以sizeof(xy_mem_t) = 4
+    // 8051中xdata的指针为2byte, 以下两个指针只在空闲块中有效
     struct _xy_mem *next;
+    struct _xy_mem *prev;
 } xy_mem_t;
 
+// 标志占用低 2 位, 对齐至少 4 字节
+#define MEM_ALIGN     (sizeof(xy_size_t) > 4 ? sizeof(xy_size_t) : 4)
+#define MEM_ALIGN_UP(x) \
+    (((xy_size_t)(x) + MEM_ALIGN - 1) & ~(xy_size_t)(MEM_ALIGN - 1))
+#define MEM_USED      ((xy_size_t)1)
+#define MEM_PREV_USED ((xy_size_t)2)
+#define MEM_FLAGS     (MEM_USED | MEM_PREV_USED)
+#define MEM_HEAD      sizeof(xy_size_t)
+#define MEM_MIN       MEM_ALIGN_UP(sizeof(xy_mem_t) + sizeof(xy_size_t))
+#define MEM_CLASS_NUM 32
+
+#define MEM_SIZE(b)   ((b)->mem_size & ~MEM_FLAGS)
+#define MEM_NEXT(b)   ((xy_mem_t *)((xy_uint8_t *)(b) + MEM_SIZE(b)))
+#define MEM_FOOT(b)   (*(xy_size_t *)((xy_uint8_t *)(b) + MEM_SIZE(b) - MEM_HEAD))
+
+typedef struct {
+    xy_mem_t *free[MEM_CLASS_NUM];
+    xy_uint32_t map;
+    xy_size_t total;
+    xy_size_t used;
+    xy_size_t used_peak;
+    xy_uint16_t alloc_num;
+    xy_uint16_t fail_num;
+} xy_mem_heap_t;
+
+static xy_mem_heap_t s_heap;
+
+/**
+ * ISR 池: 定长块组成的栈, 块内头 2 字节存下一块的序号.
+ * 栈顶 head = (版本号 << 16) | 序号, 每次修改版本号加 1, 避免 ABA:
+ * 出栈读到 next 后被更高优先级中断抢占并弹出/压回同一块, CAS 也会失败.
+ * 有原生 CAS 时无锁; 否则(如 Cortex-M0, 8051) CAS 退化为极短的临界区.
+ */
+#ifndef XY_MEM_LOCK_FREE
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+#define XY_MEM_LOCK_FREE 1
+#else
+#define XY_MEM_LOCK_FREE 0
+#endif
+#endif
+
+#define IRQ_NONE       0xFFFFu
+#define IRQ_BLOCK_SIZE \
+    MEM_ALIGN_UP(XY_MEM_IRQ_BLOCK_SIZE < 2 ? 2 : XY_MEM_IRQ_BLOCK_SIZE)
+
+typedef struct {
+    xy_uint8_t *base;
+    xy_uint8_t *end;
+    volatile xy_uint32_t head;
+    volatile xy_uint32_t free_num;
+    xy_uint16_t total;
+    xy_uint16_t min_free;
+    xy_uint16_t fallback;
+} xy_mem_irq_t;
 
-xy_mem_t *g_mem = NULL;
+static xy_mem_irq_t s_irq;
 
 // 16bit = 65535 = 64kByte, enough
 void xy_mem_set(void *p_data, xy_uint8_t set_data, xy_size_t mem_size)
@@ -53,46 +120,266 @@ void xy_mem_copy(void *p_dest_data, void *p_src_data, xy_size_t mem_size)
     }
 }
 
-/**
- * @brief
- * 从空闲的内存块中获取，仅在 mem_size < p->size
- * @param p
- * @param mem_size
- * @return void*
- */
+/* ==================== 位操作 ==================== */
+
+// 最高置位的位置, x != 0
+static xy_uint8_t mem_fls(xy_size_t x)
+{
+    xy_uint8_t n = 0;
+
+    if (x > (xy_size_t)XY_U32_MAX)
+        return MEM_CLASS_NUM - 1;
+#if defined(__GNUC__)
+    n = (xy_uint8_t)(31 - __builtin_clz((unsigned int)x));
+#else
+    if (x & 0xFFFF0000UL) { n += 16; x >>= 16; }
+    if (x & 0xFF00) { n += 8; x >>= 8; }
+    if (x & 0xF0) { n += 4; x >>= 4; }
+    if (x & 0x0C) { n += 2; x >>= 2; }
+    if (x & 0x02) { n += 1; }
+#endif
+    return n;
+}
+
+// 最低置位的位置, x != 0
+static xy_uint8_t mem_ffs(xy_uint32_t x)
+{
+    return mem_fls((xy_size_t)(x & (~x + 1)));
+}
+
+/* ==================== 堆 ==================== */
+
+static void mem_insert(xy_mem_t *b)
+{
+    xy_uint8_t c = mem_fls(MEM_SIZE(b));
+
+    MEM_FOOT(b) = MEM_SIZE(b);
+    b->prev     = XY_NULL;
+    b->next     = s_heap.free[c];
+    if (b->next)
+        b->next->prev = b;
+    s_heap.free[c] = b;
+    s_heap.map |= (xy_uint32_t)1 << c;
+}
 
-static void *mem_break(xy_mem_t *p, xy_size_t mem_size)
+static void mem_remove(xy_mem_t *b)
 {
-    /* 从p+mem_size后拟造一个节点，切开 */
-    xy_mem_t *d = (xy_mem_t *)((xy_uint8_t *)p + mem_size);
-    // 获取P 剩余的mem_size
-    d->mem_size = p->mem_size - mem_size;
-    // 继承p->next
-    d->next = p->next;
-    // p的mem_size也减少了，那p->next怎么办？
-    p->mem_size = mem_size;
-    return d;
+    xy_uint8_t c = mem_fls(MEM_SIZE(b));
+
+    if (b->prev)
+        b->prev->next = b->next;
+    else
+        s_heap.free[c] = b->next;
+    if (b->next)
+        b->next->prev = b->prev;
+    if (s_heap.free[c] == XY_NULL)
+        s_heap.map &= ~((xy_uint32_t)1 << c);
 }
 
-static void mem_merge(xy_mem_t *p1, xy_mem_t *p2)
+static xy_mem_t *mem_find(xy_size_t mem_size)
 {
-    // if p1->next == p2 查看是不是物理连接在一起了
-    if ((xy_mem_t *)((xy_uint8_t *)p1 + p1->mem_size) == p2) {
-        p1->mem_size += p2->mem_size;
-        p1->next = p2->next;
-    } else // 如果不是合并，那么就是要跳转了
-    {
-        p1->next = p2;
+    xy_uint8_t c = mem_fls(mem_size);
+    xy_uint32_t map;
+    xy_mem_t *b;
+
+    b = s_heap.free[c];
+    if (b && MEM_SIZE(b) >= mem_size)
+        return b;
+
+    // 更高一级的任何一块都够用
+    map = (c + 1 < MEM_CLASS_NUM) ? s_heap.map & ~(((xy_uint32_t)2 << c) - 1)
+                                  : 0;
+    if (map)
+        return s_heap.free[mem_ffs(map)];
+
+    // 只剩本级, 堆将耗尽时才会走到这里
+    for (; b; b = b->next) {
+        if (MEM_SIZE(b) >= mem_size)
+            return b;
+    }
+    return XY_NULL;
+}
+
+static void *mem_alloc(xy_size_t mem_size)
+{
+    xy_mem_t *b, *r;
+    xy_size_t rest;
+
+    if (mem_size > s_heap.total) {
+        s_heap.fail_num++;
+        return XY_NULL;
+    }
+    // add size for xy_mem_t->size, align up
+    mem_size = MEM_ALIGN_UP(mem_size + MEM_HEAD);
+    if (mem_size < MEM_MIN)
+        mem_size = MEM_MIN;
+
+    b = mem_find(mem_size);
+    if (b == XY_NULL) {
+        s_heap.fail_num++;
+        return XY_NULL;
     }
+    mem_remove(b);
+
+    rest = MEM_SIZE(b) - mem_size;
+    if (rest >= MEM_MIN) {
+        // 切开, 剩余部分的后一块本来就标记为前一块空闲
+        b->mem_size = mem_size | MEM_USED | (b->mem_size & MEM_PREV_USED);
+        r           = MEM_NEXT(b);
+        r->mem_size = rest | MEM_PREV_USED;
+        mem_insert(r);
+    } else {
+        b->mem_size |= MEM_USED;
+        MEM_NEXT(b)->mem_size |= MEM_PREV_USED;
+    }
+
+    s_heap.used += MEM_SIZE(b);
+    if (s_heap.used_peak < s_heap.used)
+        s_heap.used_peak = s_heap.used;
+    s_heap.alloc_num++;
+    return (xy_uint8_t *)b + MEM_HEAD;
+}
+
+static void mem_release(void *p)
+{
+    xy_mem_t *b = (xy_mem_t *)((xy_uint8_t *)p - MEM_HEAD);
+    xy_mem_t *n = MEM_NEXT(b);
+    xy_size_t mem_size = MEM_SIZE(b);
+
+    s_heap.used -= mem_size;
+    s_heap.alloc_num--;
+
+    // 与后一块合并
+    if (!(n->mem_size & MEM_USED)) {
+        mem_remove(n);
+        mem_size += MEM_SIZE(n);
+    }
+    // 与前一块合并, 前一块的大小在它的尾部
+    if (!(b->mem_size & MEM_PREV_USED)) {
+        b = (xy_mem_t *)((xy_uint8_t *)b - *((xy_size_t *)b - 1));
+        mem_remove(b);
+        mem_size += MEM_SIZE(b);
+    }
+    // 空闲块的前一块一定是已用块
+    b->mem_size = mem_size | MEM_PREV_USED;
+    mem_insert(b);
+    MEM_NEXT(b)->mem_size &= ~MEM_PREV_USED;
+}
+
+/* ==================== ISR 池 ==================== */
+
+static xy_bool irq_cas(volatile xy_uint32_t *p, xy_uint32_t old, xy_uint32_t val)
+{
+#if XY_MEM_LOCK_FREE
+    return __atomic_compare_exchange_n(p, &old, val, 0, __ATOMIC_ACQ_REL,
+                                       __ATOMIC_ACQUIRE);
+#else
+    xy_bool ok;
+
+    xy_enter_critical();
+    ok = (*p == old);
+    if (ok)
+        *p = val;
+    xy_exit_critical();
+    return ok;
+#endif
+}
+
+static xy_uint32_t irq_add(volatile xy_uint32_t *p, xy_uint32_t v)
+{
+    xy_uint32_t old;
+
+    do {
+        old = *p;
+    } while (!irq_cas(p, old, old + v));
+    return old + v;
+}
+
+#define IRQ_LINK(i) (*(volatile xy_uint16_t *)(s_irq.base + (xy_size_t)(i) * IRQ_BLOCK_SIZE))
+
+static void *irq_pop(void)
+{
+    xy_uint32_t old, idx, n;
+
+    do {
+        old = s_irq.head;
+        idx = old & 0xFFFF;
+        if (idx == IRQ_NONE)
+            return XY_NULL;
+        // 块可能刚被别处弹出, 读到的 next 无效时版本号不符, CAS 失败重试
+        n = ((old + 0x10000) & 0xFFFF0000) | IRQ_LINK(idx);
+    } while (!irq_cas(&s_irq.head, old, n));
+
+    // 低水位仅作统计, 不要求精确
+    n = irq_add(&s_irq.free_num, (xy_uint32_t)-1);
+    if (n < s_irq.min_free)
+        s_irq.min_free = (xy_uint16_t)n;
+    return s_irq.base + (xy_size_t)idx * IRQ_BLOCK_SIZE;
+}
+
+static void irq_push(void *p)
+{
+    xy_uint32_t old, idx;
+
+    idx = (xy_uint32_t)(((xy_uint8_t *)p - s_irq.base) / IRQ_BLOCK_SIZE);
+    do {
+        old          = s_irq.head;
+        IRQ_LINK(idx) = (xy_uint16_t)(old & 0xFFFF);
+    } while (!irq_cas(&s_irq.head, old, ((old + 0x10000) & 0xFFFF0000) | idx));
+    irq_add(&s_irq.free_num, 1);
 }
 
+static xy_bool irq_owns(void *p)
+{
+    return (xy_uint8_t *)p >= s_irq.base && (xy_uint8_t *)p < s_irq.end;
+}
+
+/* ==================== 接口 ==================== */
+
+/**
+ * @brief 初始化堆, 头部切出 ISR 池, 尾部放一个大小为 0 的已用块作结束标记
+ *
+ * @param p 内存区
+ * @param mem_size 内存区字节数
+ */
 void xy_mem_init(void *p, xy_size_t mem_size)
 {
+    xy_uint8_t *start = (xy_uint8_t *)MEM_ALIGN_UP(p);
+    xy_uint8_t *end;
+    xy_size_t irq_size = (xy_size_t)XY_MEM_IRQ_BLOCK_NUM * IRQ_BLOCK_SIZE;
     xy_mem_t *h;
-    h           = (xy_mem_t *)p;
-    h->mem_size = mem_size;
-    h->next     = NULL;
-    g_mem       = h;
+    xy_uint16_t i;
+
+    xy_mem_set(&s_heap, 0, sizeof(s_heap));
+    xy_mem_set(&s_irq, 0, sizeof(s_irq));
+    s_irq.head = IRQ_NONE;
+
+    if (mem_size < (xy_size_t)(start - (xy_uint8_t *)p) + MEM_MIN + MEM_HEAD)
+        return;
+    mem_size -= (xy_size_t)(start - (xy_uint8_t *)p);
+
+    // 空间不够放下 ISR 池和一个最小块时不使用 ISR 池
+    if (XY_MEM_IRQ_BLOCK_NUM > 0 && XY_MEM_IRQ_BLOCK_NUM < IRQ_NONE
+        && mem_size >= irq_size + MEM_MIN + MEM_HEAD) {
+        s_irq.base = start;
+        s_irq.end  = start + irq_size;
+        for (i = 0; i < XY_MEM_IRQ_BLOCK_NUM; i++)
+            IRQ_LINK(i) = (i + 1 < XY_MEM_IRQ_BLOCK_NUM) ? (xy_uint16_t)(i + 1) : IRQ_NONE;
+        s_irq.head     = 0;
+        s_irq.total    = XY_MEM_IRQ_BLOCK_NUM;
+        s_irq.free_num = XY_MEM_IRQ_BLOCK_NUM;
+        s_irq.min_free = XY_MEM_IRQ_BLOCK_NUM;
+        start += irq_size;
+        mem_size -= irq_size;
+    }
+
+    end = start + ((mem_size - MEM_HEAD) & ~(xy_size_t)(MEM_ALIGN - 1));
+    ((xy_mem_t *)end)->mem_size = MEM_USED;
+
+    h           = (xy_mem_t *)start;
+    h->mem_size = (xy_size_t)(end - start) | MEM_PREV_USED;
+    s_heap.total = MEM_SIZE(h);
+    mem_insert(h);
 }
 
 
@@ -100,204 +387,143 @@ void *xy_mem_malloc(xy_size_t mem_size)
 {
     void *p;
     xy_enter_critical();
-    p = xy_mem_malloc_from_irq(mem_size);
+    p = mem_alloc(mem_size);
     xy_exit_critical();
     return p;
 }
 
 
+/**
+ * @brief 中断中分配: 不超过 XY_MEM_IRQ_BLOCK_SIZE 的先取 ISR 池(无锁),
+ * 池空或更大的请求走堆, 同以前一样由调用者保证不与线程中的堆操作重入
+ */
 void *xy_mem_malloc_from_irq(xy_size_t mem_size)
-{ // 理解为 int *p与p
-    xy_mem_t **pp, *p;
-
-    // add size for xy_mem_t->size
-    mem_size += sizeof(xy_size_t);
-
-    // 指针内存对齐，align up 算法： (((size) + (align) - 1) & ~((align) - 1))
-    mem_size =
-        (((mem_size) + (sizeof(xy_size_t)) - 1) & ~((sizeof(xy_size_t)) - 1));
-
-    if (mem_size < sizeof(xy_mem_t))
-        mem_size = sizeof(xy_mem_t);
-    /** 查看空内存块是否有适合的可分配空间
-     * 1、pp 获取指向内存第一个内存块指针地址（&g_mem）
-     * 2、p=*pp, p=g_mem, pp移动了，g_mem也就移动辣
-     * 3、当p->size不够分配时，pp获取指向p->next指针地址（也就是指向下一内存卡的指针地址）
-     * 4、当 size 够时，*pp=
-     * 也就是当前内存块next存储地址要变更了（就是指向mem_t变更了）
-     */
-    for (pp = (&g_mem); ((p = *pp) != NULL); pp = &p->next) {
-        if (mem_size <= p->mem_size) // 还有内存
-        {
-            /**
-             * *pp 更改指针pp的内容了
-             */
-            *pp = (p->mem_size >= mem_size + sizeof(xy_mem_t))
-                      ? mem_break(p, mem_size)
-                      : p->next;
-            return (&p->next); // 返回p->next所在的地址
-        }
+{
+    void *p;
+
+    if (mem_size <= XY_MEM_IRQ_BLOCK_SIZE && s_irq.total) {
+        p = irq_pop();
+        if (p)
+            return p;
+        s_irq.fallback++;
     }
-    return NULL;
+    return mem_alloc(mem_size);
 }
 
 
 void xy_mem_free(void *p)
 {
+    if (p == XY_NULL)
+        return;
+    if (irq_owns(p)) {
+        irq_push(p);
+        return;
+    }
     xy_enter_critical();
-    xy_mem_free_from_irq(p);
+    mem_release(p);
     xy_exit_critical();
 }
 
 void xy_mem_free_from_irq(void *p)
 {
-    xy_mem_t *x, *y, *z;
-
-    // p = xy_mem_t->next，p->next - p->size,就是p所在的mem_t啦
-    y = (xy_mem_t *)((xy_uint8_t *)p - sizeof(xy_size_t));
-
-    if (!g_mem) {
-        //        printf("g_mem = NULL\n");
-        y->next = NULL;
-        g_mem   = y;
-    } else if (y < g_mem) {
-        //        printf("y<g_mem\n");
-        mem_merge(y, g_mem);
-        g_mem = y;
-    } else {
-        //        printf("y>=g_mem\n");
-        // 查找释放mem_t上一个mem_t，z为 xy_mem_t->next
-        for (x = g_mem; (((z = x->next) != NULL) && (z < y)); x = z)
-            ;
-        // 如果 z 不为空，则与 z 拼接一起
-        if (z) {
-            //            printf("if(z)\n");
-            mem_merge(y, z);
-        } else //
-        {
-            // z = null
-            //            printf("z=NULL\n");
-            y->next = NULL;
-        }
-        mem_merge(x, y);
-    }
+    if (p == XY_NULL)
+        return;
+    if (irq_owns(p))
+        irq_push(p);
+    else
+        mem_release(p);
 }
 
+/**
+ * @brief 堆空闲信息
+ *
+ * @param p_num 空闲块个数
+ * @param p_max 最大空闲块字节
+ * @return xy_uint16_t 空闲字节
+ */
 xy_uint16_t xy_mem_info(xy_uint16_t *p_num, xy_uint16_t *p_max)
 {
-    xy_uint16_t mem_size = 0;
-    xy_uint16_t num      = 0;
-    xy_uint16_t max      = 0;
+    xy_mem_stat_t stat;
+
+    xy_mem_stat(&stat);
+    *p_num = stat.free_blocks;
+    *p_max = (xy_uint16_t)stat.max_free;
+    return (xy_uint16_t)stat.free;
+}
 
-    xy_mem_t *p;
+/**
+ * @brief 堆与 ISR 池的统计, 含碎片率和高水位
+ */
+void xy_mem_stat(xy_mem_stat_t *p_stat)
+{
+    xy_mem_t *b;
+    xy_size_t f, m;
+    xy_uint8_t c;
+
+    xy_mem_set(p_stat, 0, sizeof(*p_stat));
     xy_enter_critical();
-    for (p = g_mem; p; p = p->next) {
-        mem_size += p->mem_size;
-        if (max < p->mem_size)
-            max = p->mem_size;
-        num++;
+    for (c = 0; c < MEM_CLASS_NUM; c++) {
+        for (b = s_heap.free[c]; b; b = b->next) {
+            p_stat->free += MEM_SIZE(b);
+            if (p_stat->max_free < MEM_SIZE(b))
+                p_stat->max_free = MEM_SIZE(b);
+            p_stat->free_blocks++;
+        }
     }
+    p_stat->total     = s_heap.total;
+    p_stat->used_peak = s_heap.used_peak;
+    p_stat->alloc_num = s_heap.alloc_num;
+    p_stat->fail_num  = s_heap.fail_num;
     xy_exit_critical();
-    *p_num = num;
-    *p_max = max;
-    return mem_size;
+
+    // 缩放后再算比例, 避免 16/32 位下溢出
+    f = p_stat->free;
+    m = p_stat->max_free;
+    while (f > 0xFFFFFF) {
+        f >>= 8;
+        m >>= 8;
+    }
+    if (f)
+        p_stat->frag = (xy_uint8_t)(100 - (xy_uint32_t)m * 100 / f);
+    p_stat->irq_total    = s_irq.total;
+    p_stat->irq_free     = (xy_uint16_t)s_irq.free_num;
+    p_stat->irq_min_free = s_irq.min_free;
+    p_stat->irq_fallback = s_irq.fallback;
 }
 
 #if (PLATFORM == PLATFORM_X86)
+#include <stdio.h>
 
-void main(void)
+int main(void)
 {
-    xy_uint16_t g_ram_a[1024];
-    xy_uint16_t mem_block_num, mem_max, mem_size;
-    xy_mem_t *taska, *taskb, *taskc, *taskd;
-
-    printf("sizeof xy_mem_t:%d\n", sizeof(xy_mem_t));
+    static xy_size_t g_ram_a[512];
+    xy_mem_stat_t st;
+    void *taska, *taskb, *taskc, *taskd, *irqa;
 
     xy_mem_init(g_ram_a, sizeof(g_ram_a));
-    mem_size = xy_mem_info(&mem_block_num, &mem_max);
-    printf("After init mem_size=%d\n", mem_size);
-
-    taska    = xy_mem_malloc(256);
-    mem_size = xy_mem_info(&mem_block_num, &mem_max);
-    printf("after malloc mem_size=%d\n", mem_size);
-
-    taskb    = xy_mem_malloc(128);
-    mem_size = xy_mem_info(&mem_block_num, &mem_max);
-    printf("after malloc mem_size=%d\n", mem_size);
-
-    taskc    = xy_mem_malloc(50);
-    mem_size = xy_mem_info(&mem_block_num, &mem_max);
-    printf("after malloc, mem_size=%d\n", mem_size);
-
+    xy_mem_stat(&st);
+    printf("After init total=%u free=%u irq=%u\n", (unsigned)st.total,
+           (unsigned)st.free, (unsigned)st.irq_free);
+
+    taska = xy_mem_malloc(256);
+    taskb = xy_mem_malloc(128);
+    taskc = xy_mem_malloc(50);
+    irqa  = xy_mem_malloc_from_irq(16);
     xy_mem_free(taskb);
-    mem_size = xy_mem_info(&mem_block_num, &mem_max);
-    printf("Atfer free mem_size=%d\n", mem_size);
-
-    taskd    = xy_mem_malloc(24);
-    mem_size = xy_mem_info(&mem_block_num, &mem_max);
-    printf("Atfer malloc mem_size=%d\n", mem_size);
+    taskd = xy_mem_malloc(24);
+    xy_mem_stat(&st);
+    printf("free=%u max=%u blocks=%u frag=%u%% peak=%u irq_free=%u\n",
+           (unsigned)st.free, (unsigned)st.max_free, (unsigned)st.free_blocks,
+           (unsigned)st.frag, (unsigned)st.used_peak, (unsigned)st.irq_free);
 
     xy_mem_free(taska);
-    mem_size = xy_mem_info(&mem_block_num, &mem_max);
-    printf("Atfer free mem_size=%d\n", mem_size);
-
     xy_mem_free(taskd);
-    mem_size = xy_mem_info(&mem_block_num, &mem_max);
-    printf("Atfer free mem_size=%d\n", mem_size);
-
     xy_mem_free(taskc);
-    mem_size = xy_mem_info(&mem_block_num, &mem_max);
-    printf("Atfer free mem_size=%d\n", mem_size);
+    xy_mem_free_from_irq(irqa);
+    xy_mem_stat(&st);
+    printf("After free free=%u blocks=%u frag=%u%%\n", (unsigned)st.free,
+           (unsigned)st.free_blocks, (unsigned)st.frag);
+    return 0;
 }
 
-#elif (PLATFORM == PLATFORM_C51)
-
-#if 1
-// volatile xy_uint8_t g_ram_a[256];
-// void test_mem(void)
-//{
-
-//  xy_uint16_t mem_block_num, mem_max, mem_size;
-//  xy_mem_t *taska, *taskb, *taskc, *taskd;
-
-////  printf("sizeof xy_mem_t:%d\n", sizeof(xy_mem_t));
-
-////  xy_mem_init(g_ram_a, sizeof(g_ram_a));
-//  mem_size = xy_mem_info(&mem_block_num, &mem_max);
-////  printf("After init mem_size=%d\n", mem_size);
-
-//  taska = xy_mem_malloc(32);
-//  mem_size = xy_mem_info(&mem_block_num, &mem_max);
-////  printf("after malloc mem_size=%d\n", mem_size);
-
-//  taskb = xy_mem_malloc(46);
-//  mem_size = xy_mem_info(&mem_block_num, &mem_max);
-////  printf("after malloc mem_size=%d\n", mem_size);
-
-//  taskc = xy_mem_malloc(24);
-//  mem_size = xy_mem_info(&mem_block_num, &mem_max);
-////  printf("after malloc, mem_size=%d\n", mem_size);
-
-//  xy_mem_free(taskb);
-//  mem_size = xy_mem_info(&mem_block_num, &mem_max);
-////  printf("Atfer free mem_size=%d\n", mem_size);
-
-//  taskd = xy_mem_malloc(40);
-//  mem_size = xy_mem_info(&mem_block_num, &mem_max);
-////  printf("Atfer malloc mem_size=%d\n", mem_size);
-
-//  xy_mem_free(taska);
-//  mem_size = xy_mem_info(&mem_block_num, &mem_max);
-////  printf("Atfer free mem_size=%d\n", mem_size);
-
-//  xy_mem_free(taskd);
-//  mem_size = xy_mem_info(&mem_block_num, &mem_max);
-////  printf("Atfer free mem_size=%d\n", mem_size);
-
-//  xy_mem_free(taskc);
-//  mem_size = xy_mem_info(&mem_block_num, &mem_max);
-////  printf("Atfer free mem_size=%d\n", mem_size);
-//}
-#endif
-
 #endif
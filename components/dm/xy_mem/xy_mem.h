@@ -3,14 +3,45 @@
 
 #include "xy_typedef.h"
 
+/**
+ * 堆: 按 2 的幂分级的空闲链表 + 边界标记, 分配与释放均为 O(1).
+ * ISR 池: 初始化时从堆区头部切出的定长块, 无锁出栈/入栈, 供中断中使用.
+ */
+
+/* ISR 定长块大小(字节), 不超过此大小的 xy_mem_malloc_from_irq() 走 ISR 池 */
+#ifndef XY_MEM_IRQ_BLOCK_SIZE
+#define XY_MEM_IRQ_BLOCK_SIZE 32
+#endif
+
+/* ISR 定长块个数, 0 表示不使用 ISR 池 */
+#ifndef XY_MEM_IRQ_BLOCK_NUM
+#define XY_MEM_IRQ_BLOCK_NUM 8
+#endif
+
+typedef struct {
+    xy_size_t total;          // 堆总字节(不含 ISR 池)
+    xy_size_t free;           // 空闲字节
+    xy_size_t max_free;       // 最大空闲块字节
+    xy_size_t used_peak;      // 已用字节高水位
+    xy_uint16_t free_blocks;  // 空闲块个数
+    xy_uint16_t alloc_num;    // 当前已分配块个数
+    xy_uint16_t fail_num;     // 分配失败次数
+    xy_uint8_t frag;          // 碎片率 %, 100 - max_free * 100 / free
+    xy_uint16_t irq_total;    // ISR 池块数
+    xy_uint16_t irq_free;     // ISR 池空闲块数
+    xy_uint16_t irq_min_free; // ISR 池空闲块低水位
+    xy_uint16_t irq_fallback; // ISR 池为空转到堆的次数
+} xy_mem_stat_t;
+
 void xy_mem_set(void *p_data, xy_uint8_t set_data, xy_size_t mem_size);
 void xy_mem_copy(void *p_dest_data, void *p_src_data, xy_size_t mem_size);
-xy_uint8_t xy_mem_cmp(const void *str1, const void *str2, xy_uint8_t len);
+xy_int8_t xy_mem_cmp(const void *str1, const void *str2, xy_uint8_t len);
 void xy_mem_init(void *p, xy_size_t mem_size);
 void *xy_mem_malloc(xy_size_t mem_size);
 void *xy_mem_malloc_from_irq(xy_size_t mem_size);
 void xy_mem_free(void *p);
 void xy_mem_free_from_irq(void *p);
 xy_uint16_t xy_mem_info(xy_uint16_t *p_num, xy_uint16_t *p_max);
+void xy_mem_stat(xy_mem_stat_t *p_stat);
 
-#endif
\ No newline at end of file
+#endif
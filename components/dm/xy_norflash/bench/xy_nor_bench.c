@@ -0,0 +1,360 @@
+/**
+ * @file xy_nor_bench.c
+ * @brief Blocking xy_nor API vs. the async pipeline, on a timed NOR model
+ *
+ * The port below simulates a W25Q-class SPI NOR behind a DMA-capable
+ * controller, in virtual time:
+ * - bus time follows the clock and line count of each phase
+ *   (quad read: 1-line command, 4-line address/dummy/data)
+ * - page program keeps WIP set for T_PP after the transfer ends; programming
+ *   while WIP is set, without WEL or across a page is counted as a violation
+ * - CPU time is charged for CPU-driven transfers, busy-wait delays, ISR
+ *   entry and the consumer's CRC; a DMA transfer costs the CPU nothing
+ *
+ * The blocking API polls WIP with xy_nor_hw_delay_ms(1) between reads, as
+ * xy_nor_wait_ready() does. The async pipeline is driven by a periodic
+ * timer calling xy_nor_async_poll() and by DMA-complete events.
+ *
+ * Last, a read whose third DMA start is refused: the chunks that arrived
+ * must all be handed over before the request completes with the error.
+ */
+
+#include "xy_nor.h"
+#include "xy_nor_async.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_CAP       (1u << 20) /* JEDEC capacity code 0x14 */
+#define SIM_HZ        50e6       /* SPI clock */
+#define T_PP_NS       400000.0   /* page program, typical */
+#define ISR_NS        1000.0     /* ISR entry/exit and driver work */
+#define CRC_NS_BYTE   10.0       /* table CRC32 on the consumer side */
+#define POLL_US       25
+
+#define WRITE_BYTES   (64u * 1024)
+#define READ_BYTES    (256u * 1024)
+
+static uint8_t s_mem[SIM_CAP];
+static double s_now;         /* virtual time, ns */
+static double s_cpu;         /* CPU busy time, ns */
+static double s_busy_until;  /* WIP clears at this time */
+static bool s_wel;
+static uint32_t s_violations;
+
+static bool s_dma_active;
+static double s_dma_end;
+static void *s_dma_ctx;
+static uint32_t s_dma_fail;    /* refuse the n-th DMA start, 0: never */
+
+/* ==================== Device Model ==================== */
+
+static double sim_bus_ns(uint8_t cmd, uint8_t addr_len, uint32_t len)
+{
+    double clk = 8; /* command, always 1 line */
+
+    switch (cmd) {
+    case XY_NOR_CMD_QUAD_READ:
+        clk += (addr_len * 8 + 8) / 4.0 + 4 + len * 8 / 4.0; /* + mode, dummy */
+        break;
+    case XY_NOR_CMD_FAST_READ:
+        clk += addr_len * 8 + 8 + len * 8.0;
+        break;
+    default:
+        clk += addr_len * 8 + len * 8.0;
+        break;
+    }
+    return clk * 1e9 / SIM_HZ;
+}
+
+/**
+ * @brief Apply a command; @p end is when its transfer finishes
+ */
+static void sim_exec(uint8_t cmd, uint32_t addr, uint8_t *data, uint32_t len,
+                     double start, double end)
+{
+    uint32_t i;
+
+    switch (cmd) {
+    case XY_NOR_CMD_WRITE_ENABLE:
+        s_wel = true;
+        break;
+    case XY_NOR_CMD_WRITE_DISABLE:
+        s_wel = false;
+        break;
+    case XY_NOR_CMD_READ_STATUS:
+        data[0] = (uint8_t)((start < s_busy_until ? XY_NOR_STATUS_WIP : 0) |
+                            (s_wel ? XY_NOR_STATUS_WEL : 0));
+        break;
+    case XY_NOR_CMD_WRITE_STATUS:
+        s_wel = false;
+        break;
+    case XY_NOR_CMD_READ_ID:
+        data[0] = 0xEF;
+        data[1] = 0x40;
+        data[2] = 0x14;
+        break;
+    case XY_NOR_CMD_READ_DATA:
+    case XY_NOR_CMD_FAST_READ:
+    case XY_NOR_CMD_QUAD_READ:
+        if (start < s_busy_until)
+            s_violations++;
+        memcpy(data, &s_mem[addr], len);
+        break;
+    case XY_NOR_CMD_PAGE_PROGRAM:
+        if (!s_wel || start < s_busy_until || addr % 256 + len > 256)
+            s_violations++;
+        for (i = 0; i < len; i++)
+            s_mem[addr + i] &= data[i];
+        s_wel        = false;
+        s_busy_until = end + T_PP_NS;
+        break;
+    default:
+        break;
+    }
+}
+
+/* ==================== Port ==================== */
+
+void *xy_nor_hw_init(const xy_nor_config_t *config)
+{
+    (void)config;
+    return s_mem;
+}
+
+void xy_nor_hw_deinit(void *hw_handle)
+{
+    (void)hw_handle;
+}
+
+xy_nor_status_t xy_nor_hw_command(void *hw_handle, uint8_t cmd, uint32_t addr,
+                                  uint8_t addr_len, uint8_t *data,
+                                  uint32_t data_len, bool is_write)
+{
+    double t = sim_bus_ns(cmd, addr_len, data_len);
+
+    (void)hw_handle;
+    (void)is_write;
+    if (s_dma_active)
+        s_violations++; /* bus already owned by a DMA transfer */
+    sim_exec(cmd, addr, data, data_len, s_now, s_now + t);
+    s_now += t;
+    s_cpu += t;
+    return XY_NOR_OK;
+}
+
+void xy_nor_hw_delay_ms(uint32_t ms)
+{
+    s_now += ms * 1e6;
+    s_cpu += ms * 1e6;
+}
+
+xy_nor_status_t xy_nor_hw_command_dma(void *hw_handle, uint8_t cmd, uint32_t addr,
+                                      uint8_t addr_len, uint8_t *data,
+                                      uint32_t data_len, bool is_write, void *ctx)
+{
+    double t = sim_bus_ns(cmd, addr_len, data_len);
+
+    (void)hw_handle;
+    (void)is_write;
+    if (s_dma_fail != 0 && --s_dma_fail == 0)
+        return XY_NOR_ERROR;
+    if (s_dma_active)
+        s_violations++;
+    sim_exec(cmd, addr, data, data_len, s_now, s_now + t);
+    s_dma_active = true;
+    s_dma_end    = s_now + t;
+    s_dma_ctx    = ctx;
+    return XY_NOR_OK;
+}
+
+/* ==================== Helpers ==================== */
+
+static uint32_t s_crc_table[256];
+
+static void crc_init(void)
+{
+    uint32_t i, j, c;
+
+    for (i = 0; i < 256; i++) {
+        c = i;
+        for (j = 0; j < 8; j++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        s_crc_table[i] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t *p, uint32_t len)
+{
+    s_now += len * CRC_NS_BYTE;
+    s_cpu += len * CRC_NS_BYTE;
+    while (len--)
+        crc = s_crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+typedef struct {
+    uint32_t crc;
+    xy_nor_status_t result;
+    uint32_t chunks;        /* chunks handed over */
+    uint32_t late;          /* chunks handed over after done */
+    uint32_t dones;
+} bench_job_t;
+
+static void chunk_crc(void *arg, uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    bench_job_t *job = (bench_job_t *)arg;
+
+    (void)offset;
+    job->crc = crc_update(job->crc, data, len);
+    job->chunks++;
+    if (job->dones != 0)
+        job->late++;
+}
+
+static void job_done(void *arg, xy_nor_status_t status)
+{
+    ((bench_job_t *)arg)->result = status;
+    ((bench_job_t *)arg)->dones++;
+}
+
+/**
+ * @brief Run timer ticks and DMA completions until the pipeline drains
+ */
+static void run_async(xy_nor_async_t *nor_async)
+{
+    double tick = s_now;
+
+    while (xy_nor_async_busy(nor_async)) {
+        if (s_dma_active && s_dma_end <= tick) {
+            if (s_now < s_dma_end)
+                s_now = s_dma_end;
+            s_dma_active = false;
+            s_now += ISR_NS;
+            s_cpu += ISR_NS;
+            xy_nor_async_dma_done(s_dma_ctx, XY_NOR_OK);
+        } else {
+            if (s_now < tick)
+                s_now = tick;
+            s_now += ISR_NS;
+            s_cpu += ISR_NS;
+            xy_nor_async_poll(nor_async);
+            /* Ticks missed while the CPU was busy collapse into one */
+            while (tick <= s_now)
+                tick += POLL_US * 1000.0;
+        }
+    }
+}
+
+static void report(const char *name, uint32_t bytes, double t0, double c0)
+{
+    double t = s_now - t0;
+
+    printf("  %-28s %9.2f ms %8.1f KB/s  CPU %5.1f%%\n", name, t / 1e6,
+           bytes / 1024.0 / (t / 1e9), 100.0 * (s_cpu - c0) / t);
+}
+
+/* ==================== Benchmark ==================== */
+
+int main(void)
+{
+    static uint8_t src[WRITE_BYTES], dst[READ_BYTES];
+    xy_nor_handle_t nor;
+    xy_nor_config_t config;
+    xy_nor_async_t nor_async;
+    xy_nor_async_stats_t stats;
+    bench_job_t job;
+    uint32_t i, crc_ref;
+    double t0, c0;
+
+    memset(s_mem, 0xFF, sizeof(s_mem));
+    for (i = 0; i < WRITE_BYTES; i++)
+        src[i] = (uint8_t)(i * 31 + (i >> 8));
+    crc_init();
+
+    xy_nor_get_default_config(&config);
+    config.clock_freq  = (uint32_t)SIM_HZ;
+    config.quad_enable = true;
+    if (xy_nor_init(&nor, &config) != XY_NOR_OK ||
+        xy_nor_async_init(&nor_async, &nor, POLL_US) != XY_NOR_OK) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    printf("SPI NOR model: %.0f MHz, tPP %.0f us, %u B pages; timer poll %u us\n",
+           SIM_HZ / 1e6, T_PP_NS / 1e3, (unsigned)nor.info.page_size, POLL_US);
+
+    /* Program 64 KB at 0 and again at 64 KB */
+    printf("\nprogram %u KB\n", WRITE_BYTES / 1024);
+    t0 = s_now;
+    c0 = s_cpu;
+    for (i = 0; i < WRITE_BYTES; i += nor.info.page_size) {
+        if (xy_nor_page_program(&nor, i, &src[i], nor.info.page_size) != XY_NOR_OK)
+            return 1;
+    }
+    report("blocking page_program", WRITE_BYTES, t0, c0);
+
+    t0         = s_now;
+    c0         = s_cpu;
+    job.result = XY_NOR_ERROR;
+    if (xy_nor_async_write(&nor_async, WRITE_BYTES, src, WRITE_BYTES, job_done,
+                           &job) != XY_NOR_OK)
+        return 1;
+    run_async(&nor_async);
+    if (job.result != XY_NOR_OK)
+        return 1;
+    report("async write (pipelined)", WRITE_BYTES, t0, c0);
+
+    /* Read 256 KB and CRC it */
+    printf("\nquad read %u KB + CRC32\n", READ_BYTES / 1024);
+    for (i = WRITE_BYTES * 2; i < READ_BYTES; i++)
+        s_mem[i] = (uint8_t)(i ^ (i >> 9));
+    t0 = s_now;
+    c0 = s_cpu;
+    if (xy_nor_quad_read(&nor, 0, dst, READ_BYTES) != XY_NOR_OK)
+        return 1;
+    crc_ref = crc_update(0xFFFFFFFFu, dst, READ_BYTES);
+    report("blocking quad_read, then CRC", READ_BYTES, t0, c0);
+
+    memset(dst, 0, sizeof(dst));
+    t0         = s_now;
+    c0         = s_cpu;
+    job.crc    = 0xFFFFFFFFu;
+    job.result = XY_NOR_ERROR;
+    if (xy_nor_async_read(&nor_async, 0, dst, READ_BYTES, chunk_crc, job_done,
+                          &job) != XY_NOR_OK)
+        return 1;
+    run_async(&nor_async);
+    if (job.result != XY_NOR_OK)
+        return 1;
+    report("async read, CRC per chunk", READ_BYTES, t0, c0);
+
+    /* Check contents and protocol */
+    if (job.crc != crc_ref || memcmp(s_mem, src, WRITE_BYTES) != 0 ||
+        memcmp(s_mem + WRITE_BYTES, src, WRITE_BYTES) != 0 ||
+        memcmp(dst, s_mem, READ_BYTES) != 0 || s_violations != 0) {
+        printf("\nverify failed (violations %u)\n", (unsigned)s_violations);
+        return 1;
+    }
+    xy_nor_async_get_stats(&nor_async, &stats);
+    printf("\nasync: %u pages, %u read chunks, %u status polls, %u jobs, "
+           "%u errors; data verified\n",
+           (unsigned)stats.pages, (unsigned)stats.chunks, (unsigned)stats.polls,
+           (unsigned)stats.jobs, (unsigned)stats.errors);
+
+    /* The third chunk cannot start: two chunks, then the error */
+    memset(&job, 0, sizeof(job));
+    s_dma_fail = 3;
+    if (xy_nor_async_read(&nor_async, 0, dst, 4 * XY_NOR_ASYNC_READ_CHUNK, chunk_crc,
+                          job_done, &job) != XY_NOR_OK)
+        return 1;
+    run_async(&nor_async);
+    printf("DMA start refused mid-read: %u chunks, then done (%s), %u chunks after it\n",
+           (unsigned)job.chunks, job.result == XY_NOR_ERROR ? "error" : "no error",
+           (unsigned)job.late);
+    if (job.chunks != 2 || job.dones != 1 || job.late != 0 || job.result != XY_NOR_ERROR) {
+        printf("check failed\n");
+        return 1;
+    }
+    return 0;
+}
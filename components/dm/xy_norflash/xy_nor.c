@@ -1,4 +1,5 @@
 #include "xy_nor.h"
+#include <stdio.h>
 #include <string.h>
 
 /* 内部辅助函数 */
@@ -0,0 +1,357 @@
+#include "xy_nor_async.h"
+#include <string.h>
+
+/* 请求类型 */
+#define NOR_JOB_WRITE 0
+#define NOR_JOB_READ  1
+
+/* 流水线状态 */
+#define NOR_ST_IDLE      0 // 无请求进行
+#define NOR_ST_PROG_XFER 1 // 页数据 DMA 发送中
+#define NOR_ST_PROG_BUSY 2 // 芯片编程中, 等 WIP 清零
+#define NOR_ST_READ_XFER 3 // 读块 DMA 接收中
+
+/* 队列下标: 写方 release 发布, 读方 acquire 读取, 请求内容随下标可见 */
+#define NOR_LOAD(v)     __atomic_load_n(&(v), __ATOMIC_ACQUIRE)
+#define NOR_STORE(v, x) __atomic_store_n(&(v), (x), __ATOMIC_RELEASE)
+
+/* 队列计数在 [0, 2 * QUEUE) 内循环, 以区分空和满 */
+#define NOR_Q_NEXT(i)  ((uint8_t)(((i) + 1) % (2 * XY_NOR_ASYNC_QUEUE)))
+#define NOR_Q_COUNT(a) ((uint8_t)((NOR_LOAD((a)->q_tail) + 2 * XY_NOR_ASYNC_QUEUE \
+                                   - NOR_LOAD((a)->q_head)) % (2 * XY_NOR_ASYNC_QUEUE)))
+#define NOR_Q_JOB(a)   (&(a)->queue[(a)->q_head % XY_NOR_ASYNC_QUEUE])
+
+static void nor_async_start(xy_nor_async_t *nor_async);
+
+/**
+ * @brief 当前页的长度, 不跨页
+ */
+static uint32_t nor_async_page_len(xy_nor_async_t *nor_async, uint32_t done)
+{
+    xy_nor_job_t *job = NOR_Q_JOB(nor_async);
+    uint32_t page     = nor_async->nor->info.page_size;
+    uint32_t len      = page - (job->address + done) % page;
+
+    if (len > job->size - done) {
+        len = job->size - done;
+    }
+    return len;
+}
+
+/**
+ * @brief 结束当前请求, 回调后开始下一个
+ */
+static void nor_async_finish(xy_nor_async_t *nor_async, xy_nor_status_t status)
+{
+    xy_nor_job_t *job      = NOR_Q_JOB(nor_async);
+    xy_nor_async_cb_t done = job->done;
+    void *arg              = job->arg;
+
+    // 请求内容读完才让出槽位
+    nor_async->state = NOR_ST_IDLE;
+    NOR_STORE(nor_async->q_head, NOR_Q_NEXT(nor_async->q_head));
+    nor_async->stats.jobs++;
+    if (status != XY_NOR_OK) {
+        nor_async->stats.errors++;
+    }
+    if (done != NULL) {
+        done(arg, status);
+    }
+    nor_async_start(nor_async);
+}
+
+/**
+ * @brief 发出当前页: 写使能 + DMA 页编程, 传输期间准备下一页
+ */
+static void nor_async_write_page(xy_nor_async_t *nor_async)
+{
+    xy_nor_job_t *job = NOR_Q_JOB(nor_async);
+    uint32_t done     = nor_async->done_bytes;
+    uint32_t len      = nor_async_page_len(nor_async, done);
+    xy_nor_status_t status;
+    uint8_t *buf;
+
+#if XY_NOR_ASYNC_BOUNCE
+    if (!nor_async->staged) {
+        memcpy(nor_async->bounce[nor_async->bounce_idx], job->data + done, len);
+    }
+    nor_async->staged = false;
+    buf               = nor_async->bounce[nor_async->bounce_idx];
+#else
+    buf = job->data + done;
+#endif
+    nor_async->cur_len = len;
+
+    status = xy_nor_write_enable(nor_async->nor);
+    if (status == XY_NOR_OK) {
+        nor_async->state = NOR_ST_PROG_XFER;
+        status           = xy_nor_hw_command_dma(nor_async->nor->hw_handle,
+                                                 XY_NOR_CMD_PAGE_PROGRAM,
+                                                 job->address + done, 3, buf, len,
+                                                 true, nor_async);
+    }
+    if (status != XY_NOR_OK) {
+        nor_async_finish(nor_async, status);
+        return;
+    }
+
+#if XY_NOR_ASYNC_BOUNCE
+    // 下一页拷进另一个缓冲, 与本页传输和编程重叠
+    done += len;
+    if (done < job->size) {
+        nor_async->bounce_idx ^= 1;
+        memcpy(nor_async->bounce[nor_async->bounce_idx], job->data + done,
+               nor_async_page_len(nor_async, done));
+        nor_async->staged = true;
+    }
+#endif
+}
+
+/**
+ * @brief 发出下一个读块, 失败由调用方结束请求
+ */
+static xy_nor_status_t nor_async_read_chunk(xy_nor_async_t *nor_async)
+{
+    xy_nor_job_t *job = NOR_Q_JOB(nor_async);
+    uint32_t done     = nor_async->done_bytes;
+    uint32_t len      = job->size - done;
+    uint8_t cmd;
+
+    if (len > XY_NOR_ASYNC_READ_CHUNK) {
+        len = XY_NOR_ASYNC_READ_CHUNK;
+    }
+    cmd = nor_async->nor->config.quad_enable ? XY_NOR_CMD_QUAD_READ
+                                             : XY_NOR_CMD_FAST_READ;
+
+    nor_async->cur_len = len;
+    nor_async->state   = NOR_ST_READ_XFER;
+    return xy_nor_hw_command_dma(nor_async->nor->hw_handle, cmd,
+                                 job->address + done, 3, job->data + done,
+                                 len, false, nor_async);
+}
+
+/**
+ * @brief 空闲时开始队首请求
+ */
+static void nor_async_start(xy_nor_async_t *nor_async)
+{
+    xy_nor_status_t status;
+
+    if (nor_async->state != NOR_ST_IDLE || NOR_Q_COUNT(nor_async) == 0) {
+        return;
+    }
+
+    nor_async->done_bytes = 0;
+#if XY_NOR_ASYNC_BOUNCE
+    nor_async->staged = false;
+#endif
+    if (NOR_Q_JOB(nor_async)->type == NOR_JOB_WRITE) {
+        nor_async_write_page(nor_async);
+        return;
+    }
+    status = nor_async_read_chunk(nor_async);
+    if (status != XY_NOR_OK) {
+        nor_async_finish(nor_async, status);
+    }
+}
+
+/**
+ * @brief 请求入队
+ */
+static xy_nor_status_t nor_async_submit(xy_nor_async_t *nor_async, uint8_t type,
+                                        uint32_t address, uint8_t *data,
+                                        uint32_t size,
+                                        xy_nor_async_chunk_cb_t chunk,
+                                        xy_nor_async_cb_t done, void *arg)
+{
+    xy_nor_job_t *job;
+
+    if (nor_async == NULL || nor_async->nor == NULL || data == NULL || size == 0) {
+        return XY_NOR_INVALID_PARAM;
+    }
+
+    if (address >= nor_async->nor->info.capacity ||
+        size > nor_async->nor->info.capacity - address) {
+        return XY_NOR_INVALID_PARAM;
+    }
+
+    if (NOR_Q_COUNT(nor_async) >= XY_NOR_ASYNC_QUEUE) {
+        return XY_NOR_BUSY;
+    }
+
+    job          = &nor_async->queue[NOR_LOAD(nor_async->q_tail) % XY_NOR_ASYNC_QUEUE];
+    job->type    = type;
+    job->address = address;
+    job->data    = data;
+    job->size    = size;
+    job->chunk   = chunk;
+    job->done    = done;
+    job->arg     = arg;
+
+    // 请求写完后再发布, 由下一次 poll 开始
+    NOR_STORE(nor_async->q_tail, NOR_Q_NEXT(nor_async->q_tail));
+    return XY_NOR_OK;
+}
+
+/**
+ * @brief 初始化异步流水线
+ */
+xy_nor_status_t xy_nor_async_init(xy_nor_async_t *nor_async,
+                                  xy_nor_handle_t *handle,
+                                  uint32_t poll_period_us)
+{
+    if (nor_async == NULL || handle == NULL || !handle->is_initialized ||
+        poll_period_us == 0) {
+        return XY_NOR_INVALID_PARAM;
+    }
+
+#if XY_NOR_ASYNC_BOUNCE
+    if (handle->info.page_size > XY_NOR_ASYNC_PAGE_MAX) {
+        return XY_NOR_INVALID_PARAM;
+    }
+#endif
+
+    memset(nor_async, 0, sizeof(xy_nor_async_t));
+    nor_async->nor           = handle;
+    nor_async->timeout_polls = handle->config.timeout_ms * 1000 / poll_period_us;
+    if (nor_async->timeout_polls == 0) {
+        nor_async->timeout_polls = 1;
+    }
+    return XY_NOR_OK;
+}
+
+/**
+ * @brief 提交写请求
+ */
+xy_nor_status_t xy_nor_async_write(xy_nor_async_t *nor_async, uint32_t address,
+                                   const uint8_t *data, uint32_t size,
+                                   xy_nor_async_cb_t done, void *arg)
+{
+    return nor_async_submit(nor_async, NOR_JOB_WRITE, address, (uint8_t *)data,
+                            size, NULL, done, arg);
+}
+
+/**
+ * @brief 提交读请求
+ */
+xy_nor_status_t xy_nor_async_read(xy_nor_async_t *nor_async, uint32_t address,
+                                  uint8_t *data, uint32_t size,
+                                  xy_nor_async_chunk_cb_t chunk,
+                                  xy_nor_async_cb_t done, void *arg)
+{
+    return nor_async_submit(nor_async, NOR_JOB_READ, address, data, size, chunk,
+                            done, arg);
+}
+
+/**
+ * @brief 推进流水线
+ */
+void xy_nor_async_poll(xy_nor_async_t *nor_async)
+{
+    xy_nor_status_t status;
+    uint8_t sr = 0;
+
+    if (nor_async->state == NOR_ST_IDLE) {
+        nor_async_start(nor_async);
+        return;
+    }
+
+    // DMA 进行中总线被占用, 只有编程等待时才读状态
+    if (nor_async->state != NOR_ST_PROG_BUSY) {
+        return;
+    }
+
+    status = xy_nor_read_status(nor_async->nor, &sr);
+    nor_async->stats.polls++;
+    if (status != XY_NOR_OK) {
+        nor_async_finish(nor_async, status);
+        return;
+    }
+
+    if (sr & XY_NOR_STATUS_WIP) {
+        if (++nor_async->busy_polls > nor_async->timeout_polls) {
+            nor_async_finish(nor_async, XY_NOR_TIMEOUT);
+        }
+        return;
+    }
+
+    nor_async->stats.pages++;
+    nor_async->done_bytes += nor_async->cur_len;
+    if (nor_async->done_bytes < NOR_Q_JOB(nor_async)->size) {
+        nor_async_write_page(nor_async);
+    } else {
+        nor_async_finish(nor_async, XY_NOR_OK);
+    }
+}
+
+/**
+ * @brief DMA 传输完成
+ */
+void xy_nor_async_dma_done(void *ctx, xy_nor_status_t status)
+{
+    xy_nor_async_t *nor_async = (xy_nor_async_t *)ctx;
+    xy_nor_job_t *job         = NOR_Q_JOB(nor_async);
+    xy_nor_async_chunk_cb_t chunk;
+    uint8_t *data;
+    uint32_t offset, len, size;
+    void *arg;
+    xy_nor_status_t next = XY_NOR_OK;
+
+    if (status != XY_NOR_OK) {
+        nor_async_finish(nor_async, status);
+        return;
+    }
+
+    if (nor_async->state == NOR_ST_PROG_XFER) {
+        // 数据已送进芯片页缓冲, 编程开始, 之后由 poll 等 WIP
+        nor_async->state      = NOR_ST_PROG_BUSY;
+        nor_async->busy_polls = 0;
+        return;
+    }
+
+    if (nor_async->state != NOR_ST_READ_XFER) {
+        return;
+    }
+
+    chunk  = job->chunk;
+    arg    = job->arg;
+    data   = job->data;
+    size   = job->size;
+    offset = nor_async->done_bytes;
+    len    = nor_async->cur_len;
+    nor_async->stats.chunks++;
+    nor_async->done_bytes += len;
+
+    // 先启动下一块, 回调处理本块时下一块已在传输;
+    // 启动失败也先交付本块, 再结束请求
+    if (nor_async->done_bytes < size) {
+        next = nor_async_read_chunk(nor_async);
+    }
+    if (chunk != NULL) {
+        chunk(arg, offset, data + offset, len);
+    }
+    if (next != XY_NOR_OK) {
+        nor_async_finish(nor_async, next);
+    } else if (offset + len == size) {
+        nor_async_finish(nor_async, XY_NOR_OK);
+    }
+}
+
+/**
+ * @brief 是否还有未完成的请求
+ */
+bool xy_nor_async_busy(xy_nor_async_t *nor_async)
+{
+    return NOR_Q_COUNT(nor_async) != 0;
+}
+
+/**
+ * @brief 获取统计
+ */
+void xy_nor_async_get_stats(xy_nor_async_t *nor_async, xy_nor_async_stats_t *stats)
+{
+    if (nor_async == NULL || stats == NULL) {
+        return;
+    }
+    memcpy(stats, &nor_async->stats, sizeof(xy_nor_async_stats_t));
+}
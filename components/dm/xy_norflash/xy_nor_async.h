@@ -0,0 +1,182 @@
+#ifndef XY_NOR_ASYNC_H
+#define XY_NOR_ASYNC_H
+
+#include "xy_nor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 异步流水线: 写/读请求排队, 由 DMA 完成中断和定时(或就绪)中断推进, 调用方不再忙等.
+ *
+ * 写: 任意长度, 按页拆分. 当前页数据 DMA 发送完后芯片进入编程(WIP),
+ *     这段时间把下一页准备进 DMA 缓冲; WIP 清零后立即发出下一页.
+ * 读: 四线(未使能时用快速读)分块 DMA 直接写入调用方缓冲, 一块完成后先启动
+ *     下一块, 再回调 chunk, 调用方处理数据与下一块传输重叠.
+ *
+ * 上下文约定:
+ * - xy_nor_async_poll() 在周期定时中断(或 QSPI 自动轮询的就绪中断)中调用;
+ * - xy_nor_async_dma_done() 由端口在 DMA 完成中断中调用;
+ * - 两个中断优先级相同(互不抢占); 提交在任务中, 请求在下一次 poll 时开始;
+ * - 异步请求未完成时不要调用阻塞接口.
+ */
+
+/* 请求队列深度 */
+#ifndef XY_NOR_ASYNC_QUEUE
+#define XY_NOR_ASYNC_QUEUE 4
+#endif
+
+/* 读请求单次 DMA 的最大长度 */
+#ifndef XY_NOR_ASYNC_READ_CHUNK
+#define XY_NOR_ASYNC_READ_CHUNK 4096
+#endif
+
+/* 1: 写数据先拷贝到内部双缓冲再 DMA(源数据可在任意存储器);
+ * 0: 直接从调用方缓冲 DMA, 需保证其可被 DMA 访问且在完成前不变 */
+#ifndef XY_NOR_ASYNC_BOUNCE
+#define XY_NOR_ASYNC_BOUNCE 1
+#endif
+
+/* 内部缓冲的页大小上限 */
+#ifndef XY_NOR_ASYNC_PAGE_MAX
+#define XY_NOR_ASYNC_PAGE_MAX 256
+#endif
+
+/* 请求完成回调, 在中断上下文 */
+typedef void (*xy_nor_async_cb_t)(void *arg, xy_nor_status_t status);
+
+/* 读数据块到达回调, 在中断上下文; offset 为相对请求起点的偏移 */
+typedef void (*xy_nor_async_chunk_cb_t)(void *arg, uint32_t offset,
+                                        const uint8_t *data, uint32_t len);
+
+/* 异步请求 */
+typedef struct {
+    uint8_t type;                   // 写/读
+    uint32_t address;               // 起始地址
+    uint8_t *data;                  // 数据缓冲区
+    uint32_t size;                  // 数据大小
+    xy_nor_async_cb_t done;         // 完成回调, 可为 NULL
+    xy_nor_async_chunk_cb_t chunk;  // 读数据块回调, 可为 NULL
+    void *arg;                      // 回调参数
+} xy_nor_job_t;
+
+/* 异步统计 */
+typedef struct {
+    uint32_t pages;                 // 已编程页数
+    uint32_t chunks;                // 已完成读块数
+    uint32_t polls;                 // 读状态寄存器次数
+    uint32_t jobs;                  // 已完成请求数
+    uint32_t errors;                // 失败请求数
+} xy_nor_async_stats_t;
+
+/* 异步操作句柄 */
+typedef struct {
+    xy_nor_handle_t *nor;           // 已初始化的 NOR 句柄
+    xy_nor_job_t queue[XY_NOR_ASYNC_QUEUE];
+    volatile uint8_t q_head;        // 中断侧读
+    volatile uint8_t q_tail;        // 任务侧写
+    volatile uint8_t state;         // 流水线状态
+    uint32_t done_bytes;            // 当前请求已完成字节
+    uint32_t cur_len;               // 进行中的页/块长度
+    uint32_t busy_polls;            // 当前页已轮询次数
+    uint32_t timeout_polls;         // 超时轮询次数
+#if XY_NOR_ASYNC_BOUNCE
+    uint8_t bounce[2][XY_NOR_ASYNC_PAGE_MAX];
+    uint8_t bounce_idx;             // 进行中的缓冲
+    bool staged;                    // 下一页已准备在另一缓冲
+#endif
+    xy_nor_async_stats_t stats;
+} xy_nor_async_t;
+
+/**
+ * @brief 初始化异步流水线
+ * @param nor_async 异步句柄
+ * @param handle 已初始化的NOR Flash句柄
+ * @param poll_period_us xy_nor_async_poll() 调用周期(微秒), 用于换算超时
+ * @return 操作状态
+ */
+xy_nor_status_t xy_nor_async_init(xy_nor_async_t *nor_async,
+                                  xy_nor_handle_t *handle,
+                                  uint32_t poll_period_us);
+
+/**
+ * @brief 提交写请求, 可跨页, 目标区域需已擦除
+ * @param nor_async 异步句柄
+ * @param address 写入地址
+ * @param data 数据缓冲区, 完成前保持有效
+ * @param size 数据大小
+ * @param done 完成回调
+ * @param arg 回调参数
+ * @return XY_NOR_BUSY 队列已满
+ */
+xy_nor_status_t xy_nor_async_write(xy_nor_async_t *nor_async, uint32_t address,
+                                   const uint8_t *data, uint32_t size,
+                                   xy_nor_async_cb_t done, void *arg);
+
+/**
+ * @brief 提交读请求, 分块 DMA 到 data
+ * @param nor_async 异步句柄
+ * @param address 读取地址
+ * @param data 数据缓冲区
+ * @param size 数据大小
+ * @param chunk 每块到达回调, 可为 NULL
+ * @param done 完成回调
+ * @param arg 回调参数
+ * @return XY_NOR_BUSY 队列已满
+ */
+xy_nor_status_t xy_nor_async_read(xy_nor_async_t *nor_async, uint32_t address,
+                                  uint8_t *data, uint32_t size,
+                                  xy_nor_async_chunk_cb_t chunk,
+                                  xy_nor_async_cb_t done, void *arg);
+
+/**
+ * @brief 推进流水线: 编程中则读一次状态, 空闲则开始下一个请求
+ * @param nor_async 异步句柄
+ */
+void xy_nor_async_poll(xy_nor_async_t *nor_async);
+
+/**
+ * @brief DMA 传输完成, 由端口在中断中调用
+ * @param ctx xy_nor_hw_command_dma() 收到的 ctx
+ * @param status 传输结果
+ */
+void xy_nor_async_dma_done(void *ctx, xy_nor_status_t status);
+
+/**
+ * @brief 是否还有未完成的请求
+ * @param nor_async 异步句柄
+ * @return true 有请求排队或进行中
+ */
+bool xy_nor_async_busy(xy_nor_async_t *nor_async);
+
+/**
+ * @brief 获取统计
+ * @param nor_async 异步句柄
+ * @param stats 统计指针
+ */
+void xy_nor_async_get_stats(xy_nor_async_t *nor_async, xy_nor_async_stats_t *stats);
+
+/* 硬件抽象层接口 - 需要用户实现 */
+
+/**
+ * @brief 启动一次 DMA 命令传输, 立即返回; 完成后调用 xy_nor_async_dma_done(ctx, ...)
+ * @param hw_handle 硬件句柄
+ * @param cmd 命令
+ * @param addr 地址
+ * @param addr_len 地址长度
+ * @param data 数据
+ * @param data_len 数据长度
+ * @param is_write 是否为写操作
+ * @param ctx 完成时原样传回
+ * @return 操作状态, 非 XY_NOR_OK 时不会回调
+ */
+xy_nor_status_t xy_nor_hw_command_dma(void *hw_handle, uint8_t cmd, uint32_t addr,
+                                      uint8_t addr_len, uint8_t *data,
+                                      uint32_t data_len, bool is_write, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XY_NOR_ASYNC_H */
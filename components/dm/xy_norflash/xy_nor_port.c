@@ -5,6 +5,8 @@
  */
 
 #include "xy_nor.h"
+#include "xy_nor_async.h"
+#include <stdlib.h>
 
 /*
  * 这里需要包含您的硬件平台相关的头文件
@@ -178,3 +180,53 @@ void xy_nor_hw_delay_ms(uint32_t ms)
         __asm("nop");
     }
 }
+
+/**
+ * @brief 启动DMA命令传输（异步流水线使用）
+ * @note 命令和地址阶段可用轮询发送，数据阶段交给DMA；
+ *       DMA完成中断里拉高片选并调用 xy_nor_async_dma_done(ctx, XY_NOR_OK)
+ */
+xy_nor_status_t xy_nor_hw_command_dma(void *hw_handle, uint8_t cmd, uint32_t addr,
+                                      uint8_t addr_len, uint8_t *data,
+                                      uint32_t data_len, bool is_write, void *ctx)
+{
+    if (hw_handle == NULL) {
+        return XY_NOR_INVALID_PARAM;
+    }
+
+    // 示例：保存 ctx，供 DMA 完成中断使用
+    /*
+    nor_hw_handle_t *hw = (nor_hw_handle_t *)hw_handle;
+    s_dma_ctx = ctx;
+    gpio_set_level(hw->cs_pin, 0);
+    spi_transfer(hw->spi_handle, &cmd, NULL, 1);
+    ... 发送地址 ...
+    if (is_write) {
+        spi_dma_tx_start(hw->spi_handle, data, data_len);
+    } else {
+        spi_dma_rx_start(hw->spi_handle, data, data_len);
+    }
+    */
+    (void)cmd;
+    (void)addr;
+    (void)addr_len;
+    (void)data;
+    (void)data_len;
+    (void)is_write;
+    (void)ctx;
+
+    return XY_NOR_ERROR; // 未适配
+}
+
+/*
+void SPI_DMA_IRQHandler(void)
+{
+    gpio_set_level(CS_PIN, 1);
+    xy_nor_async_dma_done(s_dma_ctx, XY_NOR_OK);
+}
+
+void TIMER_IRQHandler(void) // 例如每 25us, 与 DMA 中断同优先级
+{
+    xy_nor_async_poll(&g_nor_async);
+}
+*/
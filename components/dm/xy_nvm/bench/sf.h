@@ -0,0 +1,20 @@
+/**
+ * @file sf.h
+ * @brief Host shim for the sf base types, used by the sf_kv benchmark only
+ */
+#ifndef _SF_H_
+#define _SF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef uint8_t  sf_uint8_t;
+typedef uint16_t sf_uint16_t;
+typedef uint32_t sf_uint32_t;
+typedef int8_t   sf_int8_t;
+typedef int16_t  sf_int16_t;
+typedef int32_t  sf_int32_t;
+typedef bool     sf_bool;
+
+#endif
@@ -0,0 +1,394 @@
+/**
+ * @file sf_kv_bench.c
+ * @brief sf_kv get/set latency against fill level
+ *
+ * Runs on the host against a RAM flash simulator that enforces NOR
+ * semantics (programming can only clear bits). For each fill level the
+ * store is filled with 254 keys, then:
+ * - get: indexed lookup vs. a linear walk of the log (the old algorithm)
+ * - set: random updates, mean / worst latency, flash programs and erases,
+ *   with GC only on demand and with sf_kv_gc_check() called between writes
+ * - remount: index rebuild time, then every key is checked against a shadow
+ *
+ * Then a burst of related updates is written with sf_kv_set() and with one
+ * transaction, and a commit is cut at every flash program to check that the
+ * batch is either fully applied or fully discarded on remount.
+ *
+ * Last, single programs of a set fail while later ones succeed: the set must
+ * report it, and every later write must survive a remount.
+ */
+
+#include "sf_kv.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SIM_SIZE   (FLASH_PAGE_SIZE * FLASH_KV_PAGE)
+#define KEYS       254
+#define GET_ROUNDS 200000
+#define SET_ROUNDS 20000
+#define TXN_KEYS   10
+#define TXN_LEN    16
+#define TXN_ROUNDS 2000
+
+uint8_t g_sim_flash[SIM_SIZE];
+
+static uint32_t s_programs;
+static uint32_t s_erases;
+static uint32_t s_violations;
+static uint32_t s_cut_at;                   /* fail programs from this count, 0 = off */
+static uint32_t s_fail_at;                  /* fail only this program, 0 = off */
+
+/* ==================== Flash Port ==================== */
+
+sf_bool sf_kv_port_write(sf_uint32_t addr, const void *data, sf_uint32_t len)
+{
+    const uint8_t *src = (const uint8_t *)data;
+    uint32_t i;
+
+    if (addr + len > SIM_SIZE)
+        return false;
+    if (s_cut_at != 0 && s_programs + 1 >= s_cut_at) {
+        /* Power cut: the program at s_cut_at lands half-way, later ones not at all */
+        if (s_programs + 1 == s_cut_at)
+            len /= 2;
+        else
+            len = 0;
+        for (i = 0; i < len; i++)
+            g_sim_flash[addr + i] &= src[i];
+        s_programs++;
+        return false;
+    }
+    if (s_programs + 1 == s_fail_at) {
+        /* Program error: lands half-way, the flash keeps working */
+        for (i = 0; i < len / 2; i++)
+            g_sim_flash[addr + i] &= src[i];
+        s_programs++;
+        return false;
+    }
+    for (i = 0; i < len; i++) {
+        if ((g_sim_flash[addr + i] & src[i]) != src[i])
+            s_violations++;
+        g_sim_flash[addr + i] &= src[i];
+    }
+    s_programs++;
+    return true;
+}
+
+sf_bool sf_kv_port_erase(sf_uint32_t addr)
+{
+    addr -= addr % FLASH_PAGE_SIZE;
+    if (addr >= SIM_SIZE)
+        return false;
+    memset(&g_sim_flash[addr], 0xFF, FLASH_PAGE_SIZE);
+    s_erases++;
+    return true;
+}
+
+/* ==================== Helpers ==================== */
+
+static uint8_t s_shadow[KEYS + 1][KV_DATA_MAX_LEN];
+static uint32_t s_rand = 1;
+
+static uint32_t rnd(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Reference lookup: walk every sector, keep the last live match
+ */
+static const uint8_t *scan_get(uint8_t key_id)
+{
+    const uint8_t *found = NULL;
+    uint32_t best_seq = 0;
+    uint32_t page, off, seq, magic;
+    kv_t kv;
+
+    for (page = 0; page < FLASH_KV_PAGE; page++) {
+        const uint8_t *base = &g_sim_flash[page * FLASH_PAGE_SIZE];
+        memcpy(&magic, base, 4);
+        memcpy(&seq, base + 4, 4);
+        if (magic == 0xFFFFFFFFu)
+            continue;
+        for (off = 8; off + 8 <= FLASH_PAGE_SIZE;) {
+            memcpy(&kv, base + off, 8);
+            if (kv.head != KV_SYS_PACK_HEAD)
+                break;
+            if (kv.key_id == key_id && kv.is_en == 0xFF
+                && (found == NULL || seq >= best_seq)) {
+                found = base + off + 8;
+                best_seq = seq;
+            }
+            off += (4 + kv.len + 3) & ~3u;
+        }
+    }
+    return found;
+}
+
+static int verify(void)
+{
+    uint8_t key;
+    const uint8_t *p;
+
+    for (key = 1; key <= KEYS; key++) {
+        p = (const uint8_t *)sf_kv_get(key);
+        if (p == NULL || memcmp(p, s_shadow[key], sf_kv_get_len(key)) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* ==================== Benchmark ==================== */
+
+static int bench_fill(unsigned fill_pct, int idle_gc)
+{
+    kv_stat_t st;
+    uint8_t len;
+    uint32_t i, prog0, erase0;
+    double t0, t, worst = 0, sum_set = 0, t_get, t_scan, t_mount;
+    volatile uintptr_t sink = 0;
+    uint8_t key;
+
+    memset(g_sim_flash, 0xFF, sizeof(g_sim_flash));
+    if (sf_kv_init() != 0)
+        return -1;
+    sf_kv_stat(&st);
+
+    /* Size values so that 254 keys occupy fill_pct of the capacity */
+    i = st.capacity * fill_pct / 100 / KEYS;
+    len = (uint8_t)(i > KV_DATA_MAX_LEN + 8 ? KV_DATA_MAX_LEN : (i > 8 ? i - 8 : 0));
+
+    for (key = 1; key <= KEYS; key++) {
+        for (i = 0; i < len; i++)
+            s_shadow[key][i] = (uint8_t)rnd();
+        if (sf_kv_set(key, s_shadow[key], len) == NULL)
+            return -1;
+    }
+
+    t0 = now_ns();
+    for (i = 0; i < GET_ROUNDS; i++)
+        sink += (uintptr_t)sf_kv_get((uint8_t)(1 + i % KEYS));
+    t_get = (now_ns() - t0) / GET_ROUNDS;
+
+    t0 = now_ns();
+    for (i = 0; i < GET_ROUNDS / 100; i++)
+        sink += (uintptr_t)scan_get((uint8_t)(1 + i % KEYS));
+    t_scan = (now_ns() - t0) / (GET_ROUNDS / 100);
+
+    prog0 = s_programs;
+    erase0 = s_erases;
+    for (i = 0; i < SET_ROUNDS; i++) {
+        key = (uint8_t)(1 + rnd() % KEYS);
+        s_shadow[key][0]++;
+        t0 = now_ns();
+        if (sf_kv_set(key, s_shadow[key], len) == NULL)
+            return -1;
+        t = now_ns() - t0;
+        sum_set += t;
+        if (t > worst)
+            worst = t;
+        if (idle_gc)
+            sf_kv_gc_check();
+    }
+
+    t0 = now_ns();
+    if (sf_kv_init() != 0)
+        return -1;
+    t_mount = (now_ns() - t0) / 1000.0;
+    if (verify() != 0 || s_violations != 0) {
+        printf("verify failed at %u%%\n", fill_pct);
+        return -1;
+    }
+
+    printf("%4u%% %5u %8.1f %9.1f %8.1f %9.1f %6.2f %7.4f %8.1f\n", fill_pct,
+           (unsigned)len, t_get, t_scan, sum_set / SET_ROUNDS, worst / 1000.0,
+           (double)(s_programs - prog0) / SET_ROUNDS,
+           (double)(s_erases - erase0) / SET_ROUNDS, t_mount);
+    (void)sink;
+    return 0;
+}
+
+/* ==================== Transactions ==================== */
+
+static int txn_write(uint8_t gen)
+{
+    uint8_t key, i;
+
+    for (key = 1; key <= TXN_KEYS; key++) {
+        for (i = 0; i < TXN_LEN; i++)
+            s_shadow[key][i] = (uint8_t)(gen + key + i);
+    }
+    if (!sf_kv_txn_begin())
+        return -1;
+    for (key = 1; key <= TXN_KEYS; key++) {
+        if (!sf_kv_txn_put(key, s_shadow[key], TXN_LEN))
+            return -1;
+    }
+    return sf_kv_txn_commit() ? 0 : -1;
+}
+
+/**
+ * @brief After a remount, keys 1..TXN_KEYS must all hold generation @p gen
+ */
+static int txn_check(uint8_t gen)
+{
+    uint8_t key, i;
+    const uint8_t *p;
+
+    for (key = 1; key <= TXN_KEYS; key++) {
+        p = (const uint8_t *)sf_kv_get(key);
+        if (p == NULL || sf_kv_get_len(key) != TXN_LEN)
+            return -1;
+        for (i = 0; i < TXN_LEN; i++) {
+            if (p[i] != (uint8_t)(gen + key + i))
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int bench_txn(void)
+{
+    uint32_t i, prog0, cut, programs, applied = 0, discarded = 0;
+    double t0, t_set, t_txn, p_set, p_txn;
+    uint8_t key, gen = 0;
+    uint8_t buf[TXN_LEN];
+
+    memset(g_sim_flash, 0xFF, sizeof(g_sim_flash));
+    if (sf_kv_init() != 0 || txn_write(gen) != 0)
+        return -1;
+
+    prog0 = s_programs;
+    t0 = now_ns();
+    for (i = 0; i < TXN_ROUNDS; i++) {
+        for (key = 1; key <= TXN_KEYS; key++) {
+            memset(buf, (uint8_t)(i + key), sizeof(buf));
+            if (sf_kv_set(key, buf, TXN_LEN) == NULL)
+                return -1;
+        }
+    }
+    t_set = (now_ns() - t0) / TXN_ROUNDS;
+    p_set = (double)(s_programs - prog0) / TXN_ROUNDS;
+
+    prog0 = s_programs;
+    t0 = now_ns();
+    for (i = 0; i < TXN_ROUNDS; i++) {
+        if (txn_write(++gen) != 0)
+            return -1;
+    }
+    t_txn = (now_ns() - t0) / TXN_ROUNDS;
+    p_txn = (double)(s_programs - prog0) / TXN_ROUNDS;
+
+    printf("\n%u-key update burst (%u B values)\n", TXN_KEYS, TXN_LEN);
+    printf("              ns/burst  programs/burst\n");
+    printf("  sf_kv_set  %9.1f  %8.2f\n", t_set, p_set);
+    printf("  txn        %9.1f  %8.2f\n", t_txn, p_txn);
+
+    /* Cut power at each program of one commit, remount, expect old or new */
+    for (cut = 1;; cut++) {
+        if (sf_kv_init() != 0 || txn_check(gen) != 0)
+            return -1;
+        programs = s_programs;
+        s_cut_at = programs + cut;
+        if (txn_write((uint8_t)(gen + 1)) == 0 && s_programs < s_cut_at) {
+            s_cut_at = 0;
+            gen++;
+            break;
+        }
+        s_cut_at = 0;
+        if (sf_kv_init() != 0)
+            return -1;
+        if (txn_check((uint8_t)(gen + 1)) == 0) {
+            gen++;
+            applied++;
+        } else if (txn_check(gen) == 0) {
+            discarded++;
+        } else {
+            printf("power cut at program %u: batch partially applied\n", (unsigned)cut);
+            return -1;
+        }
+    }
+    if (sf_kv_init() != 0 || txn_check(gen) != 0 || s_violations != 0)
+        return -1;
+    printf("  power cut at each of %u programs: %u discarded, %u applied, none partial\n",
+           (unsigned)(cut - 1), (unsigned)discarded, (unsigned)applied);
+    return 0;
+}
+
+/* ==================== Program Errors ==================== */
+
+static int bench_write_fail(void)
+{
+    uint8_t key, bad[16];
+    uint32_t step, i;
+
+    memset(g_sim_flash, 0xFF, sizeof(g_sim_flash));
+    if (sf_kv_init() != 0)
+        return -1;
+    for (key = 1; key <= KEYS; key++) {
+        for (i = 0; i < 16; i++)
+            s_shadow[key][i] = (uint8_t)rnd();
+        if (sf_kv_set(key, s_shadow[key], 16) == NULL)
+            return -1;
+    }
+
+    /* A set is two programs: the record body, then its head byte */
+    for (step = 1; step <= 2; step++) {
+        key = (uint8_t)(1 + rnd() % KEYS);
+        memset(bad, 0x5A, sizeof(bad));
+        s_fail_at = s_programs + step;
+        if (sf_kv_set(key, bad, sizeof(bad)) != NULL)
+            return -1;
+        s_fail_at = 0;
+        for (i = 0; i < 50; i++) {
+            key = (uint8_t)(1 + rnd() % KEYS);
+            s_shadow[key][0]++;
+            if (sf_kv_set(key, s_shadow[key], 16) == NULL)
+                return -1;
+        }
+    }
+
+    if (sf_kv_init() != 0 || verify() != 0)
+        return -1;
+    printf("\nfailed program of a set: reported, later writes kept after remount\n");
+    return 0;
+}
+
+int main(void)
+{
+    static const unsigned fills[] = { 10, 30, 50, 70, 85 };
+    unsigned i;
+    int idle;
+
+    printf("sf_kv: %u sectors x %u B, %u keys\n", (unsigned)FLASH_KV_PAGE,
+           (unsigned)FLASH_PAGE_SIZE, (unsigned)KEYS);
+    for (idle = 0; idle < 2; idle++) {
+        printf("\n%s\n", idle ? "GC in idle (sf_kv_gc_check after each set)"
+                              : "GC on demand only");
+        printf("fill   len   get ns   scan ns   set ns  worst us  prog/set "
+               "erase/set mount us\n");
+        for (i = 0; i < sizeof(fills) / sizeof(fills[0]); i++) {
+            if (bench_fill(fills[i], idle) != 0)
+                return 1;
+        }
+    }
+    if (bench_txn() != 0) {
+        printf("transaction check failed\n");
+        return 1;
+    }
+    if (bench_write_fail() != 0) {
+        printf("program error check failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+/**
+ * @file sim_flash.h
+ * @brief Simulated flash backing the sf_kv benchmark
+ */
+#ifndef SIM_FLASH_H
+#define SIM_FLASH_H
+
+#include <stdint.h>
+
+extern uint8_t g_sim_flash[];
+
+#endif
@@ -1,161 +1,738 @@
+/********************************************************************************
+ * @file    sf_kv.c
+ * @brief   KV键值系统(不固定长度)
+ *
+ * 布局: FLASH_KV_PAGE 个扇区组成环形日志, 每个扇区以 8 字节扇区头(magic + 序号)
+ * 开始, 之后依次追加记录: FE EF 95 81 | sum | len | key_id | is_en | data | 补齐4字节
+ *
+ * 1. 挂载时扫描一次, 建立 key_id -> 记录偏移 的 RAM 索引, 并缓存写指针,
+ *    之后 get/set/del 不再遍历 flash.
+ * 2. 写入顺序: 先写记录体, 最后写头字节. 掉电撕裂的记录没有头字节, 挂载时丢弃.
+ *    更新时先写新记录再作废旧记录, 挂载时同一 key 以较新的为准.
+ * 3. 垃圾回收按扇区增量进行: 每步把最旧扇区中的有效记录搬到写指针处, 然后擦除该扇区.
+ *    始终保留一个空扇区保证回收可以完成. sf_kv_gc_check 可在空闲时调用.
+ * 4. 读取走内存映射(KV_BASE_ADDR), 写入/擦除通过 sf_kv_port_write/erase.
+ * 5. 事务: sf_kv_txn_put 在 RAM 中暂存并合并同一 key 的多次写入, 提交时写成一个批:
+ *    批记录(key_id 0, 数据为 成员数 | 保留 | 成员字节数) 后紧跟各成员记录.
+ *    批记录体和全部成员一次写入, 最后写批记录头字节作为提交标记.
+ *    挂载时提交标记缺失的批与扇区尾部一起丢弃, 完整的批整体生效.
+ ********************************************************************************/
 #include "sf_kv.h"
+#include <string.h>
 
-#define FLASH_PAGE_SIZE 512
-#define FLASH_KV_PAGE 3
 // #define ALIGNED_4(size, align)    (((size) + (align) - 1) & ~((align) - 1))
-#define ALIGNED_4(size)    ((size) + 3) & ~(3)
+#define ALIGNED_4(size)    (((size) + 3) & ~(3))
 
-#define KV_SUM_SIZE (FLASH_PAGE_SIZE * (FLASH_KV_PAGE - 1))
-#define KV_BASE_ADDR    0x00
-#define KV_BACK_ADDR    (KV_BASE_ADDR + KV_SUM_SIZE)
+#define KV_SUM_SIZE (FLASH_PAGE_SIZE * FLASH_KV_PAGE)
 
 // PACK除了数据以外的字节 头字节(4byte) + (key_id + is_en + len + sum)(4byte)
 #define KV_PACK_NO_DATA_BYTE  8
 #define KV_PACK_HEAD_BYTE     4
 #define KV_PACK_INFO_BYTE     4 // (key_id + is_en + len + sum)(4byte)
+#define KV_PACK_IS_EN_OFFSET  7
+
+// 扇区头 magic(4byte) + 序号(4byte)
+#define KV_PAGE_MAGIC         0x4B565047
+#define KV_PAGE_HEAD_BYTE     8
+#define KV_PAGE_DATA_BYTE     (FLASH_PAGE_SIZE - KV_PAGE_HEAD_BYTE)
+#define KV_PAGE_EMPTY         0xFFFFFFFF
+
+#define KV_KEY_NUM            256
+
+// 批记录: 使用保留的 key_id 0, 数据 4 字节
+#define KV_BATCH_KEY          0
+#define KV_BATCH_BYTE         (KV_PACK_NO_DATA_BYTE + 4)
+
+// 空闲回收的最小收益: 最旧扇区至少有 1/4 是垃圾
+#define KV_GC_MIN_RECLAIM     (KV_PAGE_DATA_BYTE / 4)
+
+#if (FLASH_KV_PAGE < 2) || (FLASH_PAGE_SIZE % 4)
+#error "sf_kv: need at least 2 sectors of a 4-byte multiple size"
+#endif
+#if (KV_TXN_BUF_SIZE < KV_BATCH_BYTE) || (KV_TXN_BUF_SIZE > KV_PAGE_DATA_BYTE) || (KV_TXN_BUF_SIZE % 4)
+#error "sf_kv: KV_TXN_BUF_SIZE must be a 4-byte multiple that fits in one sector"
+#endif
 
+// 索引保存 偏移+1, 0 表示不存在
+#if KV_SUM_SIZE < 0xFFFF
+typedef sf_uint16_t kv_off_t;
+#else
+typedef sf_uint32_t kv_off_t;
+#endif
 
-static const char valid_space[9] = {
-    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
-};
+#define KV_PTR(off)         ((const sf_uint8_t *)(size_t)(KV_BASE_ADDR + (off)))
+#define KV_PAGE_ADDR(page)  ((sf_uint32_t)(page) * FLASH_PAGE_SIZE)
+#define KV_PAGE_OF(off)     ((sf_uint8_t)((off) / FLASH_PAGE_SIZE))
+#define KV_PACK_SIZE(len)   ALIGNED_4(KV_PACK_HEAD_BYTE + (sf_uint32_t)(len))
 
+typedef struct {
+    sf_uint32_t magic;
+    sf_uint32_t seq;
+} kv_page_head_t;
 
+static struct {
+    kv_off_t    index[KV_KEY_NUM];          // key_id -> 记录偏移+1
+    sf_uint32_t seq[FLASH_KV_PAGE];         // 扇区序号, KV_PAGE_EMPTY 表示已擦除
+    sf_uint16_t page_live[FLASH_KV_PAGE];   // 扇区内有效记录字节
+    sf_uint32_t next_seq;
+    sf_uint32_t live_bytes;
+    sf_uint32_t cur_off;                    // 当前扇区写偏移(扇区内)
+    sf_uint8_t  cur_page;
+    sf_uint8_t  free_pages;
+    sf_uint8_t  keys;
+    sf_bool     mounted;
+    sf_bool     busy;
+} s_kv;
 
+// 事务暂存区: 批记录 + 成员记录, 与 flash 中的布局一致
+static struct {
+    sf_uint8_t  buf[KV_TXN_BUF_SIZE];
+    sf_uint16_t used;
+    sf_uint8_t  count;
+    sf_bool     open;
+} s_txn;
+
+static sf_uint8_t s_pack_buf[KV_PACK_SIZE(KV_PACK_INFO_BYTE + KV_DATA_MAX_LEN)];
+
+/* Private Function Prototypes -----------------------------------------------*/
+/**
+ * @brief  计算校验值. is_en 按 0xFF 计入, 作废标记不破坏校验
+ */
 static sf_uint8_t compute_checksum(kv_t *kv)
 {
     sf_uint8_t i;
     sf_uint16_t sum = 0;
-    sum = kv->key_id + kv->is_en + kv->len;
-    for (i = 0; i < (kv->len-KV_PACK_INFO_BYTE); i++)
+    sum = kv->key_id + 0xFF + kv->len;
+    for (i = 0; i < (kv->len - KV_PACK_INFO_BYTE); i++)
         sum += *(kv->buff + i);
     return (sf_uint8_t)(sum & 0xff);
 }
 
+static void read_flash_pack(kv_t *kv, sf_uint32_t off)
+{
+    memcpy(kv, KV_PTR(off), sizeof(kv_t) - sizeof(kv->buff));
+    kv->buff = (sf_uint8_t *)KV_PTR(off + KV_PACK_HEAD_BYTE + KV_PACK_INFO_BYTE);
+}
 
-static void read_flash_pack(kv_t *kv, sf_uint32_t addr)
+static sf_bool is_blank(sf_uint32_t off, sf_uint32_t len)
 {
-    memcpy(kv, (kv_t *)(addr), sizeof(kv_t)-4); //拷贝除了head部分？
-    kv->buff = (sf_uint8_t *)(addr + KV_PACK_HEAD_BYTE + KV_PACK_INFO_BYTE);
+    const sf_uint8_t *p = KV_PTR(off);
+    while (len--) {
+        if (*p++ != 0xFF)
+            return false;
+    }
+    return true;
 }
 
 /**
- * @brief
- *
- * @param kv_head
- * @param location 当前flash位置
- * @return sf_bool
+ * @brief  验证记录完整性
+ * @param  kv: 记录头
+ * @param  off: 记录偏移
+ * @retval true--头字节/长度/校验和均正确
  */
-static sf_bool check_valid(kv_t *kv_head, sf_uint32_t *location)
+static sf_bool check_valid(kv_t *kv, sf_uint32_t off)
 {
-    sf_uint8_t sum;
-    if (kv_head->head != KV_SYS_PACK_HEAD) {
-        *location += 4;
+    if (kv->head != KV_SYS_PACK_HEAD)
         return false;
-    }
+    if (kv->len < KV_PACK_INFO_BYTE)
+        return false;
+    // 记录不跨扇区
+    if ((off % FLASH_PAGE_SIZE) + KV_PACK_SIZE(kv->len) > FLASH_PAGE_SIZE)
+        return false;
+    return kv->sum == compute_checksum(kv);
+}
+
+/**
+ * @brief  写扇区之后的第一个空扇区 (调用前已确认 free_pages > 0)
+ */
+static sf_uint8_t next_free_page(void)
+{
+    sf_uint8_t page = s_kv.cur_page;
+
+    do {
+        page = (sf_uint8_t)((page + 1) % FLASH_KV_PAGE);
+    } while (s_kv.seq[page] != KV_PAGE_EMPTY && page != s_kv.cur_page);
+    return page;
+}
 
-    // 先确保数据完整性，才能进行判断。4-->头字节(4byte)  |  3-->(key_id + is_en + len)
-    sum = = compute_checksum(kv_head);
+/**
+ * @brief  启用一个已擦除扇区作为写扇区
+ */
+static sf_bool page_open(sf_uint8_t page)
+{
+    kv_page_head_t head;
 
-    if (kv_head->sum != sum) {
-        // 指针移动，寻找头。头字节(4byte) + (key_id + is_en + len + sum)(4byte)
-        // 为什么不直接移动倒下一个位置？因为无法确保len位有效
-        *location += KV_PACK_NO_DATA_BYTE; // 8byte
+    if (!is_blank(KV_PAGE_ADDR(page), FLASH_PAGE_SIZE)) {
+        if (!sf_kv_port_erase(KV_PAGE_ADDR(page)))
+            return false;
+    }
+    head.magic = KV_PAGE_MAGIC;
+    head.seq   = s_kv.next_seq;
+    if (!sf_kv_port_write(KV_PAGE_ADDR(page), &head, sizeof(head)))
         return false;
+
+    s_kv.seq[page]       = s_kv.next_seq++;
+    s_kv.page_live[page] = 0;
+    s_kv.cur_page        = page;
+    s_kv.cur_off         = KV_PAGE_HEAD_BYTE;
+    s_kv.free_pages--;
+    return true;
+}
+
+/**
+ * @brief  最旧的在用扇区
+ * @retval 扇区号, FLASH_KV_PAGE 表示没有
+ */
+static sf_uint8_t oldest_page(void)
+{
+    sf_uint8_t page = FLASH_KV_PAGE;
+    sf_uint8_t i;
+
+    for (i = 0; i < FLASH_KV_PAGE; i++) {
+        if (s_kv.seq[i] == KV_PAGE_EMPTY)
+            continue;
+        if (page == FLASH_KV_PAGE || s_kv.seq[i] < s_kv.seq[page])
+            page = i;
     }
+    return page;
+}
+
+/**
+ * @brief  按 flash 布局构造一条记录, 补齐部分填 0xFF
+ * @retval 记录占用字节
+ */
+static sf_uint32_t pack_build(sf_uint8_t *dst, sf_uint8_t key_id, const void *data, sf_uint8_t len)
+{
+    sf_uint32_t size = KV_PACK_SIZE(len + KV_PACK_INFO_BYTE);
+    kv_t kv;
+
+    kv.head   = KV_SYS_PACK_HEAD;
+    kv.key_id = key_id;
+    kv.len    = len + KV_PACK_INFO_BYTE;
+    kv.is_en  = 0xFF;
+    kv.buff   = (sf_uint8_t *)data;
+    kv.sum    = compute_checksum(&kv);
+
+    memset(dst, 0xFF, size);
+    memcpy(dst, &kv, KV_PACK_NO_DATA_BYTE);
+    if (len > 0)
+        memcpy(dst + KV_PACK_NO_DATA_BYTE, data, len);
+    return size;
+}
+
+/**
+ * @brief  索引指向新记录并计入有效字节
+ * @retval 旧记录偏移+1, 0 表示新 key
+ */
+static kv_off_t kv_index_set(sf_uint8_t key_id, sf_uint32_t off, sf_uint32_t size)
+{
+    kv_off_t old = s_kv.index[key_id];
+
+    if (old == 0)
+        s_kv.keys++;
+    s_kv.index[key_id] = (kv_off_t)(off + 1);
+    s_kv.live_bytes += size;
+    s_kv.page_live[KV_PAGE_OF(off)] += size;
+    return old;
+}
+
+/**
+ * @brief  在写指针处追加一条记录并更新索引 (调用前已确保空间)
+ * @param  p_off: 输出记录偏移
+ * @retval true--成功 false--写入失败, 索引不变
+ */
+static sf_bool kv_append(sf_uint8_t key_id, const void *data, sf_uint8_t len, sf_uint32_t *p_off)
+{
+    sf_uint32_t off = KV_PAGE_ADDR(s_kv.cur_page) + s_kv.cur_off;
+    sf_uint32_t size = pack_build(s_pack_buf, key_id, data, len);
 
-    // 0xff是为写入的值
-    if (kv_head->is_en != 0xFF) {
-        *location += (kv_head->len + KV_PACK_INFO_BYTE);
+    // 先写记录体, 最后写头字节: 掉电撕裂的记录没有头字节
+    if (!sf_kv_port_write(off + KV_PACK_HEAD_BYTE, s_pack_buf + KV_PACK_HEAD_BYTE, KV_PACK_INFO_BYTE + len)
+        || !sf_kv_port_write(off, s_pack_buf, KV_PACK_HEAD_BYTE)) {
+        // 扇区尾部已不干净, 之后从新扇区写
+        s_kv.cur_off = FLASH_PAGE_SIZE;
         return false;
     }
 
+    s_kv.cur_off += size;
+    kv_index_set(key_id, off, size);
+    if (p_off != NULL)
+        *p_off = off;
     return true;
 }
 
-static void* find_blank_addr(viod)
+/**
+ * @brief  作废一条记录 (is_en 写 0, 不更新索引)
+ */
+static void kv_invalidate(sf_uint32_t off)
 {
-    sf_uint32_t i = 0;
-    sf_uint8_t sum;
-    while (i < KV_SUM_SIZE) {
-        kv_t kv_head;
-        read_flash_pack(&kv_head, KV_BACK_ADDR + i);
-        if (kv_head == KV_SYS_PACK_HEAD) {
-            sum = compute_checksum(&kv_head);
+    sf_uint8_t zero = 0x00;
+    sf_uint32_t size = KV_PACK_SIZE(KV_PTR(off)[5]);
+
+    sf_kv_port_write(off + KV_PACK_IS_EN_OFFSET, &zero, 1);
+    s_kv.live_bytes -= size;
+    s_kv.page_live[KV_PAGE_OF(off)] -= size;
+}
 
-            if (kv_head.sum != sum) {
-                i += KV_PACK_NO_DATA_BYTE;
-            } else {
-                // 指针移动到下一个数据包头 数据长度 + KV_PACK_NO_DATA_BYTE
-                i += kv_head.len + KV_PACK_NO_DATA_BYTE;
+/**
+ * @brief  回收最旧的扇区: 有效记录搬到写指针处, 然后擦除
+ * @retval true--回收了一个扇区
+ */
+static sf_bool kv_gc_one(void)
+{
+    sf_uint8_t victim = oldest_page();
+    sf_uint32_t base, off, size;
+    kv_t kv;
+
+    if (victim == FLASH_KV_PAGE)
+        return false;
+    // 回收当前写扇区时先切换到新扇区
+    if (victim == s_kv.cur_page) {
+        if (s_kv.free_pages == 0 || !page_open(next_free_page()))
+            return false;
+    }
+
+    base = KV_PAGE_ADDR(victim);
+    off  = base + KV_PAGE_HEAD_BYTE;
+    while (s_kv.page_live[victim] > 0 && off + KV_PACK_NO_DATA_BYTE <= base + FLASH_PAGE_SIZE) {
+        read_flash_pack(&kv, off);
+        if (!check_valid(&kv, off))
+            break;
+        size = KV_PACK_SIZE(kv.len);
+        // 只搬运索引指向的记录, 掉电遗留的重复记录在此丢弃
+        if (kv.is_en == 0xFF && s_kv.index[kv.key_id] == off + 1) {
+            if (s_kv.cur_off + size > FLASH_PAGE_SIZE) {
+                if (s_kv.free_pages == 0 || !page_open(next_free_page()))
+                    return false;
+            }
+            s_kv.live_bytes -= size;
+            s_kv.page_live[victim] -= size;
+            if (!kv_append(kv.key_id, kv.buff, kv.len - KV_PACK_INFO_BYTE, NULL)) {
+                // 记录仍在原扇区, 不擦除
+                s_kv.live_bytes += size;
+                s_kv.page_live[victim] += size;
+                return false;
             }
-            goto end;
-        } else if (kv_head.head == 0xFFFFFFFF) {
-            // KV_PACK_NO_DATA_BYTE + 1 byte
-            if ((i + 9) >= KV_SUM_SIZE)
-                return NULL;
-            if (memcmp((void*)(KV_BASE_ADDR + i), valid_space, 9) == 0)
-                return (void*)(KV_BASE_ADDR + i);
         }
-        // 指针移动倒下一个字
-        i += 4;
-end:
-        i = ALIGNED_4(i);
+        off += size;
+    }
+
+    if (!sf_kv_port_erase(base))
+        return false;
+    s_kv.seq[victim]       = KV_PAGE_EMPTY;
+    s_kv.page_live[victim] = 0;
+    s_kv.free_pages++;
+    return true;
+}
+
+/**
+ * @brief  为 size 字节的新记录准备空间, 必要时回收
+ */
+static sf_bool kv_reserve(sf_uint32_t size)
+{
+    sf_uint8_t tries = FLASH_KV_PAGE;
+
+    if (size > KV_PAGE_DATA_BYTE)
+        return false;
+    while (s_kv.cur_off + size > FLASH_PAGE_SIZE) {
+        // 保留一个空扇区给垃圾回收
+        if (s_kv.free_pages >= 2)
+            return page_open(next_free_page());
+        if (tries-- == 0 || !kv_gc_one())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief  检查批记录之后的成员记录是否完整
+ * @param  batch: 批记录
+ * @param  off: 批记录偏移
+ */
+static sf_bool batch_valid(kv_t *batch, sf_uint32_t off)
+{
+    sf_uint8_t count = batch->buff[0];
+    sf_uint32_t end = off + KV_BATCH_BYTE + (batch->buff[2] | ((sf_uint32_t)batch->buff[3] << 8));
+    sf_uint32_t limit = off - off % FLASH_PAGE_SIZE + FLASH_PAGE_SIZE;
+    kv_t kv;
+
+    if (batch->len != KV_BATCH_BYTE - KV_PACK_HEAD_BYTE || end > limit)
+        return false;
+    for (off += KV_BATCH_BYTE; count > 0; count--) {
+        if (off + KV_PACK_NO_DATA_BYTE > end)
+            return false;
+        read_flash_pack(&kv, off);
+        if (!check_valid(&kv, off) || kv.key_id == KV_BATCH_KEY || kv.key_id == 255)
+            return false;
+        off += KV_PACK_SIZE(kv.len);
+    }
+    return off == end;
+}
+
+/**
+ * @brief  扫描一个扇区, 建立索引
+ * @retval 扇区内第一个空白位置, 尾部损坏时返回 FLASH_PAGE_SIZE
+ */
+static sf_uint32_t mount_page(sf_uint8_t page)
+{
+    sf_uint32_t base = KV_PAGE_ADDR(page);
+    sf_uint32_t off = KV_PAGE_HEAD_BYTE;
+    sf_uint32_t size;
+    kv_off_t old;
+    kv_t kv;
+
+    while (off + KV_PACK_NO_DATA_BYTE <= FLASH_PAGE_SIZE) {
+        read_flash_pack(&kv, base + off);
+        if (kv.head == 0xFFFFFFFF) {
+            // 空白, 或掉电时未写完头字节的记录/批
+            return is_blank(base + off, FLASH_PAGE_SIZE - off) ? off : FLASH_PAGE_SIZE;
+        }
+        if (!check_valid(&kv, base + off))
+            return FLASH_PAGE_SIZE;
+
+        size = KV_PACK_SIZE(kv.len);
+        if (kv.key_id == KV_BATCH_KEY) {
+            // 成员不完整时整批不生效
+            if (!batch_valid(&kv, base + off))
+                return FLASH_PAGE_SIZE;
+        } else if (kv.is_en == 0xFF) {
+            // 扇区按序号扫描, 后出现的更新; 作废旧的, 防止删除后旧值复活
+            old = kv_index_set(kv.key_id, base + off, size);
+            if (old != 0)
+                kv_invalidate(old - 1);
+        }
+        off += size;
     }
-    return NULL;
+    return off;
 }
 
-static void *find_kv_addr(uint8_t key_id)
+/* Public Function Prototypes ------------------------------------------------*/
+
+/**
+ * @brief  [上电调用] 挂载: 建立索引, 定位写指针, 擦除损坏的扇区
+ * @retval 0--成功 -1--flash 操作失败
+ */
+sf_int8_t sf_kv_init(void)
 {
-    sf_uint32_t i = 0;
-    while (i < KV_SUM_SIZE)
-    {
-        kv_t kv_head;
-        read_flash_pack(&kv_head, KV_BASE_ADDR + i);
+    sf_uint8_t order[FLASH_KV_PAGE];
+    sf_uint8_t used = 0;
+    sf_uint8_t i, j, t;
+    kv_page_head_t head;
+    sf_uint32_t end = 0;
 
-        // 判断 flash 数据是否有效
-        if (!check_valid(&kv_head, &i))
-            goto end;
+    memset(&s_kv, 0, sizeof(s_kv));
 
-        // 判断键值是否匹配
-        if (kv_head.key_id != key_id) {
-            i += kv_head.len + KV_PACK_NO_DATA_BYTE;
-            goto end;
+    for (i = 0; i < FLASH_KV_PAGE; i++) {
+        memcpy(&head, KV_PTR(KV_PAGE_ADDR(i)), sizeof(head));
+        if (head.magic == KV_PAGE_MAGIC && head.seq != KV_PAGE_EMPTY) {
+            s_kv.seq[i] = head.seq;
+            // 按序号插入排序
+            for (j = used; j > 0 && s_kv.seq[order[j - 1]] > head.seq; j--)
+                order[j] = order[j - 1];
+            order[j] = i;
+            used++;
+            if (head.seq >= s_kv.next_seq)
+                s_kv.next_seq = head.seq + 1;
         } else {
-            return (void*)(KV_BACK_ADDR+i);
+            s_kv.seq[i] = KV_PAGE_EMPTY;
+            s_kv.free_pages++;
+            if (!is_blank(KV_PAGE_ADDR(i), FLASH_PAGE_SIZE)
+                && !sf_kv_port_erase(KV_PAGE_ADDR(i)))
+                return -1;
         }
-end:
-        i = ALIGNED_4(i);
     }
-    return NULL;
+
+    for (t = 0; t < used; t++)
+        end = mount_page(order[t]);
+
+    if (used == 0) {
+        if (!page_open(0))
+            return -1;
+    } else {
+        s_kv.cur_page = order[used - 1];
+        s_kv.cur_off  = end;
+    }
+
+    s_kv.mounted = true;
+    return 0;
 }
 
-sf_int8_t kv_gc_env(void)
+/**
+ * @brief  增量垃圾回收: 回收一个扇区
+ * @retval true--空扇区仍不足, 需要继续调用
+ */
+sf_bool sf_kv_gc_step(void)
 {
-    // bsp_flash_earase_page()
-    sf_uint8_t kv_page_tick = 0;
-    sf_uint32_t back_byte = 0;
-    sf_uint32_t i;
-    kv_t kv_head;
-    while(i < KV_SUM_SIZE)
-    {
-        read_flash_pack(&kv_head, KV_BACK_ADDR + i);
+    if (!s_kv.mounted || s_kv.busy)
+        return false;
+    s_kv.busy = true;
+    kv_gc_one();
+    s_kv.busy = false;
+    return s_kv.free_pages < KV_GC_FREE_PAGE;
+}
 
-        if (!check_valid(&kv_head, &i))
-            goto end;
+/**
+ * @brief  [空闲时调用] 空扇区不足且最旧扇区有可回收空间时回收一个扇区
+ */
+void sf_kv_gc_check(void)
+{
+    sf_uint8_t victim;
+
+    if (!s_kv.mounted || s_kv.free_pages >= KV_GC_FREE_PAGE)
+        return;
+    victim = oldest_page();
+    if (victim == FLASH_KV_PAGE || victim == s_kv.cur_page)
+        return;
+    // 可回收空间太少时搬运的代价大于收益, 留给写入时按需回收
+    if (s_kv.page_live[victim] + KV_GC_MIN_RECLAIM <= KV_PAGE_DATA_BYTE)
+        sf_kv_gc_step();
+}
+
+/**
+ * @brief  FLASH垃圾回收: 依次回收当前写扇区之外的所有扇区
+ * @retval 0--成功 1--失败
+ */
+sf_uint8_t sf_kv_gc_env(void)
+{
+    sf_uint8_t n;
+
+    if (!s_kv.mounted || s_kv.busy)
+        return 1;
+    s_kv.busy = true;
+    for (n = 0; n < FLASH_KV_PAGE; n++) {
+        if (oldest_page() == s_kv.cur_page)
+            break;
+        if (!kv_gc_one()) {
+            s_kv.busy = false;
+            return 1;
+        }
     }
+    s_kv.busy = false;
+    return 0;
 }
 
-sf_uint8_t ke_set(sf_uint8_t key_id, void *data, sf_uint8_t len)
+/**
+ * @brief  从FLASH中获取KV值
+ * @param  key_id: KEY ID
+ * @retval 数据指针(内存映射), 不存在时为 NULL
+ */
+void *sf_kv_get(sf_uint8_t key_id)
 {
-    static sf_uint8_t kv_set_state = 0;
+    kv_off_t off;
+
+    if (key_id == 0 || key_id == 255)
+        return NULL;
+    off = s_kv.index[key_id];
+    if (off == 0)
+        return NULL;
+    return (void *)KV_PTR(off - 1 + KV_PACK_NO_DATA_BYTE);
+}
 
-    kv_t kv_tmp = {0}
+/**
+ * @brief  获取KV值长度
+ * @retval 数据长度, 不存在时为 0
+ */
+sf_uint8_t sf_kv_get_len(sf_uint8_t key_id)
+{
+    kv_off_t off;
 
     if (key_id == 0 || key_id == 255)
-        return 1;
+        return 0;
+    off = s_kv.index[key_id];
+    if (off == 0)
+        return 0;
+    return KV_PTR(off - 1)[5] - KV_PACK_INFO_BYTE;
+}
+
+/**
+ * @brief  KV值写入Flash
+ * @param  key_id: KEY ID [1,254]
+ * @param  data: 数据指针
+ * @param  len: 数据长度 [0, KV_DATA_MAX_LEN]
+ * @retval 写入后的数据指针(内存映射), 失败时为 NULL
+ */
+void *sf_kv_set(sf_uint8_t key_id, void *data, sf_uint8_t len)
+{
+    kv_off_t old;
+    sf_uint32_t off;
+
+    // 检测ID和参数是否异常
+    if (key_id == 0 || key_id == 255 || (data == NULL && len > 0) || len > KV_DATA_MAX_LEN)
+        return NULL;
+    if (!s_kv.mounted || s_kv.busy)
+        return NULL;
+
+    // 数据一致，直接返回
+    old = s_kv.index[key_id];
+    if (old != 0 && sf_kv_get_len(key_id) == len
+        && memcmp(KV_PTR(old - 1 + KV_PACK_NO_DATA_BYTE), data, len) == 0)
+        return (void *)KV_PTR(old - 1 + KV_PACK_NO_DATA_BYTE);
+
+    s_kv.busy = true;
+    if (!kv_reserve(KV_PACK_SIZE(len + KV_PACK_INFO_BYTE))) {
+        s_kv.busy = false;
+        return NULL;
+    }
+    // 回收可能搬动了旧记录
+    old = s_kv.index[key_id];
+    if (!kv_append(key_id, data, len, &off)) {
+        s_kv.busy = false;
+        return NULL;
+    }
+    if (old != 0)
+        kv_invalidate(old - 1);
+    s_kv.busy = false;
+    return (void *)KV_PTR(off + KV_PACK_NO_DATA_BYTE);
+}
+
+/**
+ * @brief  从FLASH中删除某KV值
+ * @param  key_id: KEY ID
+ * @retval true--成功 false--不存在或忙
+ */
+sf_bool sf_kv_del(sf_uint8_t key_id)
+{
+    kv_off_t off;
+
+    if (key_id == 0 || key_id == 255 || !s_kv.mounted || s_kv.busy)
+        return false;
+    off = s_kv.index[key_id];
+    if (off == 0)
+        return false;
+    kv_invalidate(off - 1);
+    s_kv.index[key_id] = 0;
+    s_kv.keys--;
+    return true;
+}
+
+/**
+ * @brief  获取运行统计
+ */
+void sf_kv_stat(kv_stat_t *stat)
+{
+    if (stat == NULL)
+        return;
+    stat->live_bytes = s_kv.live_bytes;
+    stat->capacity   = (FLASH_KV_PAGE - 1) * KV_PAGE_DATA_BYTE;
+    stat->free_pages = s_kv.free_pages;
+    stat->keys       = s_kv.keys;
+    stat->free_bytes = (FLASH_PAGE_SIZE - s_kv.cur_off)
+                       + (s_kv.free_pages > 0 ? s_kv.free_pages - 1 : 0) * KV_PAGE_DATA_BYTE;
+}
+
+/**
+ * @brief  开始事务, 丢弃未提交的暂存
+ * @retval true--成功 false--未挂载
+ */
+sf_bool sf_kv_txn_begin(void)
+{
+    if (!s_kv.mounted)
+        return false;
+    s_txn.used  = KV_BATCH_BYTE;
+    s_txn.count = 0;
+    s_txn.open  = true;
+    return true;
+}
+
+/**
+ * @brief  暂存一个写入. 同一 key 只保留最后一次, 与 flash 中一致的值不写入
+ * @param  key_id: KEY ID [1,254]
+ * @param  data: 数据指针
+ * @param  len: 数据长度
+ * @retval true--成功 false--参数错误/未开始事务/暂存区已满
+ */
+sf_bool sf_kv_txn_put(sf_uint8_t key_id, const void *data, sf_uint8_t len)
+{
+    sf_uint32_t pos, size, old_size = 0;
+    kv_off_t old;
+
+    if (!s_txn.open || key_id == 0 || key_id == 255 || (data == NULL && len > 0) || len > KV_DATA_MAX_LEN)
+        return false;
+
+    // 查找已暂存的同一 key
+    for (pos = KV_BATCH_BYTE; pos < s_txn.used; pos += KV_PACK_SIZE(s_txn.buf[pos + 5])) {
+        if (s_txn.buf[pos + 6] == key_id) {
+            old_size = KV_PACK_SIZE(s_txn.buf[pos + 5]);
+            break;
+        }
+    }
+    size = KV_PACK_SIZE(len + KV_PACK_INFO_BYTE);
+    if (s_txn.used - old_size + size > KV_TXN_BUF_SIZE)
+        return false;
+
+    if (old_size > 0) {
+        memmove(&s_txn.buf[pos], &s_txn.buf[pos + old_size], s_txn.used - pos - old_size);
+        s_txn.used -= old_size;
+        s_txn.count--;
+    }
 
-    if ( (kv_set_state) || (KV_SUM_SIZE == 0))
-        return 2;
+    old = s_kv.index[key_id];
+    if (old != 0 && sf_kv_get_len(key_id) == len
+        && memcmp(KV_PTR(old - 1 + KV_PACK_NO_DATA_BYTE), data, len) == 0)
+        return true;
 
-    kv_set_state = 1;
-}
\ No newline at end of file
+    s_txn.used += pack_build(&s_txn.buf[s_txn.used], key_id, data, len);
+    s_txn.count++;
+    return true;
+}
+
+/**
+ * @brief  提交事务: 一次写入批记录和全部成员, 再写提交标记
+ * @retval true--成功(事务结束) false--失败(暂存保留, 可重试或放弃)
+ */
+sf_bool sf_kv_txn_commit(void)
+{
+    sf_uint8_t info[4];
+    sf_uint32_t off, pos, size;
+    sf_uint16_t span;
+    kv_off_t old;
+
+    if (!s_txn.open || !s_kv.mounted || s_kv.busy)
+        return false;
+    if (s_txn.count == 0) {
+        s_txn.open = false;
+        return true;
+    }
+
+    s_kv.busy = true;
+    if (!kv_reserve(s_txn.used)) {
+        s_kv.busy = false;
+        return false;
+    }
+
+    span    = s_txn.used - KV_BATCH_BYTE;
+    info[0] = s_txn.count;
+    info[1] = 0xFF;
+    info[2] = (sf_uint8_t)span;
+    info[3] = (sf_uint8_t)(span >> 8);
+    pack_build(s_txn.buf, KV_BATCH_KEY, info, sizeof(info));
+
+    off = KV_PAGE_ADDR(s_kv.cur_page) + s_kv.cur_off;
+    if (!sf_kv_port_write(off + KV_PACK_HEAD_BYTE, &s_txn.buf[KV_PACK_HEAD_BYTE], s_txn.used - KV_PACK_HEAD_BYTE)
+        || !sf_kv_port_write(off, s_txn.buf, KV_PACK_HEAD_BYTE)) {
+        // 扇区尾部已不干净, 之后从新扇区写
+        s_kv.cur_off = FLASH_PAGE_SIZE;
+        s_kv.busy = false;
+        return false;
+    }
+    s_kv.cur_off += s_txn.used;
+
+    // 已提交: 索引切到新记录, 再作废旧记录(掉电时挂载按新记录为准)
+    for (pos = KV_BATCH_BYTE; pos < s_txn.used; pos += size) {
+        size = KV_PACK_SIZE(s_txn.buf[pos + 5]);
+        old = kv_index_set(s_txn.buf[pos + 6], off + pos, size);
+        if (old != 0)
+            kv_invalidate(old - 1);
+    }
+    s_txn.open = false;
+    s_kv.busy = false;
+    return true;
+}
+
+/**
+ * @brief  放弃事务, 丢弃暂存
+ */
+void sf_kv_txn_abort(void)
+{
+    s_txn.open = false;
+}
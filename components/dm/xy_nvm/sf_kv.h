@@ -5,6 +5,26 @@
 /* Define --------------------------------------------------------------------*/
 #define FLASH_ONE_PAGE_BYTE 32
 #define KV_SYS_PACK_HEAD    0xFEEF9581
+
+// KV区域: FLASH_KV_PAGE 个扇区组成环形日志, 始终保留一个空扇区给垃圾回收
+#ifndef FLASH_PAGE_SIZE
+#define FLASH_PAGE_SIZE     512                         // 扇区大小(擦除单位)
+#endif
+#ifndef FLASH_KV_PAGE
+#define FLASH_KV_PAGE       3                           // 扇区数量, 至少 2
+#endif
+#ifndef KV_BASE_ADDR
+#define KV_BASE_ADDR        0x00                        // 内存映射地址(读取直接访问)
+#endif
+#ifndef KV_GC_FREE_PAGE
+#define KV_GC_FREE_PAGE     2                           // 空扇区少于该值时 sf_kv_gc_check 回收
+#endif
+
+#ifndef KV_TXN_BUF_SIZE
+#define KV_TXN_BUF_SIZE     256                         // 事务暂存区(含 12 字节批记录), 4 字节对齐
+#endif
+
+#define KV_DATA_MAX_LEN     251                         // 单个值最大长度(len 字段含 4 字节信息)
 /* Public Struct -------------------------------------------------------------*/
 // 仅适用简易版
 typedef struct {
@@ -25,10 +45,34 @@ typedef struct {
     sf_uint8_t  *buff;                                  // 实际数据指针
 } kv_t;
 
+// 运行统计
+typedef struct {
+    sf_uint32_t live_bytes;                             // 有效记录占用字节
+    sf_uint32_t free_bytes;                             // 可直接写入的字节(不含保留扇区)
+    sf_uint32_t capacity;                               // 可用容量 (FLASH_KV_PAGE - 1) 个扇区
+    sf_uint8_t  free_pages;                             // 空扇区数
+    sf_uint8_t  keys;                                   // 有效键数
+} kv_stat_t;
+
+/* Flash port ----------------------------------------------------------------*/
+// 由平台实现. addr 为相对 KV_BASE_ADDR 的偏移; 读取走内存映射
+sf_bool sf_kv_port_write(sf_uint32_t addr, const void *data, sf_uint32_t len);
+sf_bool sf_kv_port_erase(sf_uint32_t addr);             // 擦除 addr 所在扇区
+
+sf_int8_t sf_kv_init(void);     // 上电挂载: 建立索引, 定位写指针, 修复掉电残留
 sf_uint8_t sf_kv_gc_env(void); //垃圾回收
-void sf_kv_gc_check(void);
+sf_bool sf_kv_gc_step(void);    // 增量回收一个扇区, 返回是否还需要继续
+void sf_kv_gc_check(void);      // 空闲时调用, 空扇区不足时回收一个扇区
 void *sf_kv_get(sf_uint8_t key_id);
+sf_uint8_t sf_kv_get_len(sf_uint8_t key_id);
 void *sf_kv_set(sf_uint8_t key_id, void *data, sf_uint8_t len);
-void *sf_kv_del(sf_uint8_t key_id);
+sf_bool sf_kv_del(sf_uint8_t key_id);
+void sf_kv_stat(kv_stat_t *stat);
+
+// 事务: 暂存多个写入, 提交时作为一个批整体写入, 掉电时整体生效或整体丢弃
+sf_bool sf_kv_txn_begin(void);
+sf_bool sf_kv_txn_put(sf_uint8_t key_id, const void *data, sf_uint8_t len);
+sf_bool sf_kv_txn_commit(void);
+void sf_kv_txn_abort(void);
 
-#endif
\ No newline at end of file
+#endif
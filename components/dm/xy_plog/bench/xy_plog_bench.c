@@ -0,0 +1,432 @@
+/**
+ * @file xy_plog_bench.c
+ * @brief Product log store on the flash simulator
+ *
+ * 1. Append: a stream of small usage/event records with an occasional
+ *    error, on SPI NOR (64 x 4 KB) until the ring has wrapped several
+ *    times, batched and with every record synced. Per record: flash time,
+ *    bytes programmed; sectors reclaimed.
+ * 2. Mount: close and reopen the backing file; reads and flash time of the
+ *    binary search mount against reading the whole area. Every kept record
+ *    is then checked (sequence, time, payload).
+ * 3. Queries: short sequence and time ranges through the index against a
+ *    scan from the oldest record.
+ * 4. Power cuts: a batch torn half way and a reclaim erase cut short; both
+ *    remount, skip what was lost and keep appending.
+ * 5. The append, remount and check on MCU internal flash (8-byte units).
+ *
+ * All times are the simulator's virtual flash time.
+ */
+
+#include "xy_plog.h"
+#include "xy_fsim.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NOR_SECTORS  64
+#define NOR_SECTOR   4096
+#define EF_SECTORS   32
+#define EF_SECTOR    2048
+#define BATCH        256
+#define RECORDS      100000
+#define QUERIES      500
+#define QUERY_SPAN   24 /* 3 s of records */
+
+#define LOG_FILE "plog.bin"
+
+static uint32_t s_ws[XY_PLOG_WORKSPACE_SIZE(NOR_SECTORS, BATCH) / 4 + 1];
+static uint32_t s_rand = 1;
+
+/* Power cut injection: program only part of the next write, fail an erase */
+static int s_cut_write = -1;
+static bool s_cut_erase;
+
+static uint32_t rnd(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+/* ==================== Records ==================== */
+
+/* Everything about record n follows from n, so any record can be checked */
+static uint32_t rec_time(uint32_t n)
+{
+    return 1700000000u + n / 8;
+}
+
+static uint16_t rec_type(uint32_t n)
+{
+    if (n % 97 == 0)
+        return XY_PLOG_TYPE(XY_PLOG_ERROR, n % 7);
+    return XY_PLOG_TYPE(n % 3 ? XY_PLOG_USAGE : XY_PLOG_EVENT, n % 5);
+}
+
+static uint16_t rec_fill(uint32_t n, uint8_t *buf)
+{
+    uint16_t len = (uint16_t)(4 + n % 13), i;
+
+    for (i = 0; i < len; i++)
+        buf[i] = (uint8_t)(n * 31 + i);
+    return len;
+}
+
+typedef struct {
+    uint32_t next;  /* Expected sequence */
+    uint32_t seen;
+    bool bad;
+} check_t;
+
+static bool check_visit(const xy_plog_record_t *rec, void *arg)
+{
+    check_t *c = (check_t *)arg;
+    uint8_t buf[32];
+    uint16_t len = rec_fill(rec->seq, buf);
+
+    if (rec->seq != c->next || rec->time != rec_time(rec->seq)
+        || rec->type != rec_type(rec->seq) || rec->len != len
+        || memcmp(rec->data, buf, len) != 0) {
+        c->bad = true;
+        return false;
+    }
+    c->next++;
+    c->seen++;
+    return true;
+}
+
+/** Check every record in [first, next) is there, in order */
+static int check_all(xy_plog_t *plog)
+{
+    xy_plog_query_t q = { 0, 0xFFFFFFFFu, 0, 0xFFFFFFFFu, 0 };
+    xy_plog_stats_t st;
+    check_t c;
+
+    xy_plog_get_stats(plog, &st);
+    c.next = st.first_seq;
+    c.seen = 0;
+    c.bad = false;
+    if (xy_plog_query(plog, &q, check_visit, &c) != XY_PLOG_OK || c.bad
+        || c.next != st.next_seq) {
+        printf("  check failed at seq %u (kept %u..%u)\n", (unsigned)c.next,
+               (unsigned)st.first_seq, (unsigned)st.next_seq);
+        return -1;
+    }
+    return 0;
+}
+
+/* ==================== Port ==================== */
+
+static int port_write(void *ctx, uint32_t addr, const void *data, size_t size)
+{
+    if (s_cut_write >= 0) {
+        xy_fsim_port_write(ctx, addr, data, (size_t)s_cut_write);
+        s_cut_write = -1;
+        return -1;
+    }
+    return xy_fsim_port_write(ctx, addr, data, size);
+}
+
+static int port_erase(void *ctx, uint32_t addr)
+{
+    xy_fsim_t *fs = (xy_fsim_t *)ctx;
+    static const uint8_t junk[16] = { 0x1F, 0x01, 0x00, 0x0E, 0x5A };
+
+    if (s_cut_erase) {
+        /* Half erased: the old header is gone, some bits are still low */
+        s_cut_erase = false;
+        xy_fsim_port_erase(ctx, addr);
+        xy_fsim_program(fs, addr, junk, sizeof(junk));
+        return -1;
+    }
+    return xy_fsim_port_erase(ctx, addr);
+}
+
+static int open_log(xy_fsim_t *fs, xy_plog_t *plog, xy_fsim_config_t *fc,
+                    uint32_t sector, uint16_t sectors, uint16_t sync_mask)
+{
+    xy_plog_port_t port = { xy_fsim_port_read, port_write, port_erase, fs };
+    xy_plog_config_t config = { .base         = 0,
+                                .sector_size  = sector,
+                                .sector_count = sectors,
+                                .prog_unit    = (uint16_t)fc->prog_unit,
+                                .batch_size   = BATCH,
+                                .sync_mask    = sync_mask };
+
+    if (xy_fsim_open(fs, fc) != XY_FSIM_OK)
+        return -1;
+    return xy_plog_init(plog, &config, &port, s_ws, sizeof(s_ws)) == XY_PLOG_OK
+               ? 0
+               : -1;
+}
+
+static int append(xy_plog_t *plog, uint32_t from, uint32_t to)
+{
+    uint8_t buf[32];
+    uint32_t n;
+    uint16_t len;
+
+    for (n = from; n < to; n++) {
+        len = rec_fill(n, buf);
+        if (xy_plog_append(plog, rec_type(n), rec_time(n), buf, len) != XY_PLOG_OK)
+            return -1;
+    }
+    return 0;
+}
+
+/* ==================== Append ==================== */
+
+static int bench_append(const char *name, xy_fsim_config_t *fc, uint32_t sector,
+                        uint16_t sectors, uint16_t sync_mask, uint32_t records)
+{
+    xy_fsim_t fs;
+    xy_plog_t plog;
+    xy_fsim_stats_t fst;
+    xy_plog_stats_t st;
+    uint64_t t0;
+
+    fc->path   = LOG_FILE;
+    fc->format = true;
+    if (open_log(&fs, &plog, fc, sector, sectors, sync_mask) != 0)
+        return -1;
+    xy_fsim_reset_stats(&fs);
+    t0 = xy_fsim_now(&fs);
+    if (append(&plog, 0, records) != 0 || xy_plog_flush(&plog) != XY_PLOG_OK)
+        return -1;
+    xy_fsim_get_stats(&fs, &fst);
+    xy_plog_get_stats(&plog, &st);
+    printf("  %-22s %7.1f us/rec  %5.1f B/rec  %5u batches  %4u reclaimed  "
+           "wear %u..%u\n",
+           name, (xy_fsim_now(&fs) - t0) / 1e3 / records,
+           (double)fst.prog_bytes / records, (unsigned)st.batches,
+           (unsigned)st.reclaimed, (unsigned)fst.wear_min,
+           (unsigned)fst.wear_max);
+    if (check_all(&plog) != 0)
+        return -1;
+    xy_fsim_close(&fs);
+
+    fc->format = false;
+    if (open_log(&fs, &plog, fc, sector, sectors, sync_mask) != 0
+        || check_all(&plog) != 0)
+        return -1;
+    xy_fsim_close(&fs);
+    return 0;
+}
+
+/* ==================== Mount ==================== */
+
+static int bench_mount(xy_fsim_config_t *fc)
+{
+    static uint8_t area[NOR_SECTORS * NOR_SECTOR];
+    xy_fsim_t fs;
+    xy_plog_t plog;
+    xy_plog_stats_t st;
+    uint64_t t0;
+
+    fc->format = false;
+    if (xy_fsim_open(&fs, fc) != XY_FSIM_OK)
+        return -1;
+    t0 = xy_fsim_now(&fs);
+    xy_fsim_read(&fs, 0, area, sizeof(area));
+    printf("  full scan             %8.1f us  1 read of %u KB\n",
+           (xy_fsim_now(&fs) - t0) / 1e3, (unsigned)(sizeof(area) / 1024));
+    xy_fsim_close(&fs);
+
+    if (open_log(&fs, &plog, fc, NOR_SECTOR, NOR_SECTORS, 0) != 0)
+        return -1;
+    xy_plog_get_stats(&plog, &st);
+    printf("  binary search mount   %8.1f us  %u reads, records %u..%u kept\n",
+           xy_fsim_now(&fs) / 1e3, (unsigned)st.reads,
+           (unsigned)st.first_seq, (unsigned)(st.next_seq - 1));
+    if (st.next_seq != RECORDS || check_all(&plog) != 0)
+        return -1;
+    xy_fsim_close(&fs);
+    return 0;
+}
+
+/* ==================== Queries ==================== */
+
+typedef struct {
+    uint32_t seq_min, seq_max; /* For the scan: filter in the callback */
+    uint32_t time_min, time_max;
+    uint32_t hits;
+} range_t;
+
+static bool count_visit(const xy_plog_record_t *rec, void *arg)
+{
+    range_t *r = (range_t *)arg;
+
+    if (rec->seq > r->seq_max || rec->time > r->time_max)
+        return false;
+    if (rec->seq >= r->seq_min && rec->time >= r->time_min)
+        r->hits++;
+    return true;
+}
+
+static int run_queries(xy_fsim_t *fs, xy_plog_t *plog, bool by_time,
+                       bool indexed, const char *name)
+{
+    xy_plog_query_t q;
+    xy_plog_stats_t st;
+    range_t r;
+    uint64_t t0 = xy_fsim_now(fs);
+    uint32_t reads, hits = 0, i, span;
+
+    xy_plog_get_stats(plog, &st);
+    reads = st.reads;
+    span = st.next_seq - st.first_seq - QUERY_SPAN - 16;
+    s_rand = 7;
+    for (i = 0; i < QUERIES; i++) {
+        memset(&r, 0, sizeof(r));
+        r.seq_max = r.time_max = 0xFFFFFFFFu;
+        if (by_time) {
+            r.time_min = rec_time(st.first_seq + 8 + rnd() % span);
+            r.time_max = r.time_min + QUERY_SPAN / 8 - 1;
+        } else {
+            r.seq_min = st.first_seq + 8 + rnd() % span;
+            r.seq_max = r.seq_min + QUERY_SPAN - 1;
+        }
+        q = (xy_plog_query_t){ 0, 0xFFFFFFFFu, 0, 0xFFFFFFFFu, 0 };
+        if (indexed) {
+            q.seq_min  = r.seq_min;
+            q.seq_max  = r.seq_max;
+            q.time_min = r.time_min;
+            q.time_max = r.time_max;
+        }
+        if (xy_plog_query(plog, &q, count_visit, &r) != XY_PLOG_OK
+            || r.hits != QUERY_SPAN)
+            return -1;
+        hits += r.hits;
+    }
+    xy_plog_get_stats(plog, &st);
+    printf("  %-22s %8.1f us/query  %6.1f reads/query  %u records\n", name,
+           (xy_fsim_now(fs) - t0) / 1e3 / QUERIES,
+           (double)(st.reads - reads) / QUERIES, (unsigned)hits);
+    return 0;
+}
+
+static int bench_queries(xy_fsim_config_t *fc)
+{
+    xy_fsim_t fs;
+    xy_plog_t plog;
+
+    fc->format = false;
+    if (open_log(&fs, &plog, fc, NOR_SECTOR, NOR_SECTORS, 0) != 0)
+        return -1;
+    if (run_queries(&fs, &plog, false, true, "sequence, index") != 0
+        || run_queries(&fs, &plog, false, false, "sequence, scan") != 0
+        || run_queries(&fs, &plog, true, true, "time, index") != 0
+        || run_queries(&fs, &plog, true, false, "time, scan") != 0)
+        return -1;
+    xy_fsim_close(&fs);
+    return 0;
+}
+
+/* ==================== Power Cuts ==================== */
+
+static int remount(xy_fsim_t *fs, xy_plog_t *plog, xy_fsim_config_t *fc,
+                   xy_plog_stats_t *st)
+{
+    xy_fsim_close(fs);
+    fc->format = false;
+    if (open_log(fs, plog, fc, NOR_SECTOR, NOR_SECTORS, 0) != 0)
+        return -1;
+    xy_plog_get_stats(plog, st);
+    return 0;
+}
+
+static int bench_power_cut(xy_fsim_config_t *fc)
+{
+    xy_fsim_t fs;
+    xy_plog_t plog;
+    xy_plog_stats_t st;
+    uint32_t next;
+
+    fc->format = false;
+    if (open_log(&fs, &plog, fc, NOR_SECTOR, NOR_SECTORS, 0) != 0)
+        return -1;
+
+    /* A batch torn half way: its records are gone, the rest stays */
+    if (append(&plog, RECORDS, RECORDS + 10) != 0)
+        return -1;
+    s_cut_write = BATCH / 3;
+    if (xy_plog_flush(&plog) != XY_PLOG_FLASH
+        || remount(&fs, &plog, fc, &st) != 0 || st.next_seq != RECORDS
+        || st.bad_batches != 1 || check_all(&plog) != 0)
+        return -1;
+    if (append(&plog, RECORDS, RECORDS + 1000) != 0
+        || xy_plog_flush(&plog) != XY_PLOG_OK
+        || remount(&fs, &plog, fc, &st) != 0 || st.next_seq != RECORDS + 1000
+        || check_all(&plog) != 0)
+        return -1;
+    printf("  torn batch            skipped, %u records kept, appending resumes\n",
+           (unsigned)(st.next_seq - st.first_seq));
+
+    /* A reclaim erase cut short: the half-erased sector sits after the head */
+    next = st.next_seq;
+    s_cut_erase = true;
+    while (s_cut_erase) {
+        if (append(&plog, next, next + 1) != 0)
+            break;
+        next++;
+    }
+    if (s_cut_erase || remount(&fs, &plog, fc, &st) != 0
+        || check_all(&plog) != 0)
+        return -1;
+    next = st.next_seq;
+    if (append(&plog, next, next + 5000) != 0 || xy_plog_flush(&plog) != XY_PLOG_OK
+        || remount(&fs, &plog, fc, &st) != 0 || st.next_seq != next + 5000
+        || check_all(&plog) != 0)
+        return -1;
+    printf("  cut reclaim erase     head found in %u reads, appending resumes\n",
+           (unsigned)st.reads);
+    xy_fsim_close(&fs);
+    return 0;
+}
+
+int main(void)
+{
+    xy_fsim_config_t config;
+
+    printf("%u records of 4..16 bytes, %u-byte batches\n\n", (unsigned)RECORDS,
+           (unsigned)BATCH);
+    printf("append, SPI NOR %u x %u KB\n", (unsigned)NOR_SECTORS,
+           (unsigned)(NOR_SECTOR / 1024));
+    xy_fsim_config_nor(&config, NOR_SECTORS * NOR_SECTOR);
+    if (bench_append("synced every record", &config, NOR_SECTOR, NOR_SECTORS,
+                     0xFFFF, RECORDS) != 0
+        || bench_append("batched", &config, NOR_SECTOR, NOR_SECTORS, 0,
+                        RECORDS) != 0)
+        goto fail;
+
+    printf("\nmount after power cycle\n");
+    if (bench_mount(&config) != 0)
+        goto fail;
+
+    printf("\n%u queries of %u records\n", (unsigned)QUERIES,
+           (unsigned)QUERY_SPAN);
+    if (bench_queries(&config) != 0)
+        goto fail;
+
+    printf("\npower cuts\n");
+    if (bench_power_cut(&config) != 0)
+        goto fail;
+
+    printf("\nappend, MCU flash %u x %u KB\n", (unsigned)EF_SECTORS,
+           (unsigned)(EF_SECTOR / 1024));
+    xy_fsim_config_eflash(&config, EF_SECTORS * EF_SECTOR);
+    if (bench_append("synced every record", &config, EF_SECTOR, EF_SECTORS,
+                     0xFFFF, RECORDS) != 0
+        || bench_append("batched", &config, EF_SECTOR, EF_SECTORS, 0,
+                        RECORDS) != 0)
+        goto fail;
+
+    unlink(LOG_FILE);
+    printf("\nall records checked after every remount\n");
+    return 0;
+
+fail:
+    unlink(LOG_FILE);
+    printf("check failed\n");
+    return 1;
+}
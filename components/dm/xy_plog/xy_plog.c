@@ -0,0 +1,635 @@
+/**
+ * @file xy_plog.c
+ * @brief Append-only product log store: indexed TLV records in a flash ring
+ */
+
+#include "xy_plog.h"
+#include "xy_tlv.h"
+#include <string.h>
+
+/* ==================== Layout ==================== */
+
+#define SECTOR_VALUE 14 /* sector sequence, seq, time, crc16 */
+#define INFO_VALUE   14 /* seq, first time, last time, count */
+#define RECORD_TIME  4
+
+#define SHDR_SIZE  (xy_tlv_header_size(SECTOR_VALUE) + SECTOR_VALUE)
+#define INFO_SIZE  (xy_tlv_header_size(INFO_VALUE) + INFO_VALUE)
+#define CKSUM_SIZE (xy_tlv_header_size(2) + 2)
+
+/* Container header (reserved at full width) + INFO: what a hop reads */
+#define BHEAD_SIZE (XY_TLV_HEADER_SIZE + INFO_SIZE)
+
+#define PHYS(plog, k) ((uint16_t)(((plog)->tail + (k)) % (plog)->config.sector_count))
+
+typedef struct {
+    uint32_t seq;
+    uint32_t time0;
+    uint32_t time1;
+    uint16_t count;
+    uint32_t total; /* Bytes on flash, padding included */
+} batch_info_t;
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+           | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t round_up(const xy_plog_t *plog, uint32_t n)
+{
+    uint32_t unit = plog->config.prog_unit;
+
+    return (n + unit - 1) & ~(unit - 1);
+}
+
+static uint32_t sector_addr(const xy_plog_t *plog, uint16_t s)
+{
+    return plog->config.base + (uint32_t)s * plog->config.sector_size;
+}
+
+static int flash_read(xy_plog_t *plog, uint32_t addr, void *data, size_t size)
+{
+    plog->stats.reads++;
+    return plog->port.read(plog->port.ctx, addr, data, size);
+}
+
+/* ==================== Sector Headers ==================== */
+
+/**
+ * @brief Read and check the header of sector @p s, caching its index entry
+ * @return true if the header is valid
+ */
+static bool read_sector(xy_plog_t *plog, uint16_t s, uint32_t *sseq)
+{
+    uint8_t buf[XY_TLV_HEADER_SIZE + SECTOR_VALUE];
+    const uint8_t *v;
+    uint16_t type;
+    xy_tlv_size_t length;
+    uint8_t hsz;
+
+    if (flash_read(plog, sector_addr(plog, s), buf, SHDR_SIZE) != 0
+        || (buf[0] == 0xFF && buf[1] == 0xFF))
+        return false;
+    hsz = xy_tlv_header_decode(buf, SHDR_SIZE, &type, &length);
+    if (hsz == 0 || type != XY_PLOG_TAG_SECTOR || length != SECTOR_VALUE)
+        return false;
+    v = buf + hsz;
+    if (get16(v + 12) != xy_tlv_checksum(buf, (xy_tlv_size_t)(hsz + 12)))
+        return false;
+    *sseq = get32(v);
+    plog->index[s].seq  = get32(v + 4);
+    plog->index[s].time = get32(v + 8);
+    return true;
+}
+
+/** Index entry of physical sector @p s, loaded on first use */
+static const xy_plog_index_t *index_of(xy_plog_t *plog, uint16_t s)
+{
+    uint32_t sseq;
+
+    if (plog->index[s].seq == XY_PLOG_SEQ_NONE && !read_sector(plog, s, &sseq)) {
+        /* Unreadable: an empty range, ordered as early as possible */
+        plog->index[s].seq  = 0;
+        plog->index[s].time = 0;
+    }
+    return &plog->index[s];
+}
+
+static void write_sector_header(xy_plog_t *plog, uint8_t *buf)
+{
+    uint8_t hsz = xy_tlv_header_encode(buf, XY_PLOG_TAG_SECTOR, SECTOR_VALUE, 0);
+    uint8_t *v = buf + hsz;
+
+    put32(v, plog->head_sseq);
+    put32(v + 4, plog->batch_seq);
+    put32(v + 8, plog->batch_time);
+    put16(v + 12, xy_tlv_checksum(buf, (xy_tlv_size_t)(hsz + 12)));
+    memset(buf + hsz + SECTOR_VALUE, 0xFF, plog->head_room - hsz - SECTOR_VALUE);
+}
+
+/* ==================== Batches ==================== */
+
+/**
+ * @brief Parse a batch head (container header + INFO)
+ * @return 1 batch, 0 erased, -1 anything else
+ */
+static int parse_batch_head(const xy_plog_t *plog, const uint8_t *buf,
+                            batch_info_t *info)
+{
+    uint16_t type;
+    xy_tlv_size_t length, ilen;
+    uint8_t hsz, isz;
+
+    if (buf[0] == 0xFF && buf[1] == 0xFF)
+        return 0;
+    hsz = xy_tlv_header_decode(buf, BHEAD_SIZE, &type, &length);
+    if (hsz == 0 || type != XY_PLOG_TAG_BATCH
+        || length < (xy_tlv_size_t)INFO_SIZE)
+        return -1;
+    isz = xy_tlv_header_decode(buf + hsz, (xy_tlv_size_t)(BHEAD_SIZE - hsz),
+                               &type, &ilen);
+    if (isz == 0 || type != XY_PLOG_TAG_INFO || ilen != INFO_VALUE)
+        return -1;
+    buf += hsz + isz;
+    info->seq   = get32(buf);
+    info->time0 = get32(buf + 4);
+    info->time1 = get32(buf + 8);
+    info->count = get16(buf + 12);
+    info->total = round_up(plog, (uint32_t)hsz + length + CKSUM_SIZE);
+    if (info->total > plog->config.batch_size)
+        return -1;
+    return 1;
+}
+
+/** Checksum of a whole batch read into @p buf */
+static bool batch_ok(const uint8_t *buf, uint32_t total)
+{
+    uint16_t type;
+    xy_tlv_size_t length, clen;
+    uint8_t hsz, csz;
+
+    hsz = xy_tlv_header_decode(buf, (xy_tlv_size_t)total, &type, &length);
+    if (hsz == 0 || (uint32_t)hsz + length + CKSUM_SIZE > total)
+        return false;
+    clen = (xy_tlv_size_t)(hsz + length);
+    csz = xy_tlv_header_decode(buf + clen, (xy_tlv_size_t)(total - clen), &type,
+                               &length);
+    return csz != 0 && type == XY_TLV_TYPE_CHECKSUM && length == 2
+           && get16(buf + clen + csz) == xy_tlv_checksum(buf, clen);
+}
+
+/**
+ * @brief Visit the records of one batch
+ * @return false once the query is over (out of range or stopped)
+ */
+static bool visit_records(xy_tlv_iterator_t *it, uint32_t seq,
+                          const xy_plog_query_t *q, xy_plog_visit_t visit,
+                          void *arg)
+{
+    xy_plog_record_t rec;
+    xy_tlv_t tlv;
+
+    for (; xy_tlv_iterator_next(it, &tlv) == XY_TLV_OK; seq++) {
+        if (tlv.length < RECORD_TIME)
+            continue;
+        rec.seq  = seq;
+        rec.time = get32(tlv.value);
+        if (rec.seq > q->seq_max || rec.time > q->time_max)
+            return false;
+        if (rec.seq < q->seq_min || rec.time < q->time_min)
+            continue;
+        if (q->class_mask != 0
+            && !(q->class_mask & (1u << XY_PLOG_CLASS(tlv.type))))
+            continue;
+        rec.type = tlv.type;
+        rec.len  = (uint16_t)(tlv.length - RECORD_TIME);
+        rec.data = tlv.value + RECORD_TIME;
+        if (!visit(&rec, arg))
+            return false;
+    }
+    return true;
+}
+
+/* ==================== Sector Ring ==================== */
+
+static bool sector_blank(xy_plog_t *plog, uint16_t s)
+{
+    uint32_t addr = sector_addr(plog, s);
+    uint32_t end = addr + plog->config.sector_size;
+    uint32_t n, i;
+
+    for (; addr < end; addr += n) {
+        n = end - addr < plog->config.batch_size ? end - addr
+                                                  : plog->config.batch_size;
+        if (flash_read(plog, addr, plog->rbuf, n) != 0)
+            return false;
+        for (i = 0; i < n; i++) {
+            if (plog->rbuf[i] != 0xFF)
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Make the next sector the head; reclaims the oldest when full
+ */
+static xy_plog_status_t open_sector(xy_plog_t *plog)
+{
+    uint16_t n = plog->config.sector_count;
+    uint16_t next;
+    bool blank;
+
+    if (plog->used == 0) {
+        next = 0;
+        plog->tail = 0;
+        plog->stats.first_seq = plog->batch_seq;
+        blank = sector_blank(plog, next);
+    } else if (plog->used == n) {
+        /* O(1) reclaim: the oldest sector goes, nothing is moved */
+        uint32_t first = index_of(plog, plog->tail)->seq;
+        uint32_t after = index_of(plog, PHYS(plog, 1))->seq;
+
+        if (after > first)
+            plog->stats.dropped += after - first;
+        plog->stats.first_seq = after;
+        plog->stats.reclaimed++;
+        next = plog->tail;
+        plog->tail = PHYS(plog, 1);
+        plog->used--;
+        blank = false;
+    } else {
+        next = (uint16_t)((plog->head + 1) % n);
+        blank = sector_blank(plog, next);
+    }
+    if (!blank && plog->port.erase(plog->port.ctx, sector_addr(plog, next)) != 0)
+        return XY_PLOG_FLASH;
+
+    plog->head_sseq = plog->used == 0 ? 0 : plog->head_sseq + 1;
+    plog->head = next;
+    plog->used++;
+    plog->wr = 0;
+    plog->index[next].seq  = plog->batch_seq;
+    plog->index[next].time = plog->batch_time;
+    return XY_PLOG_OK;
+}
+
+/* ==================== Mount ==================== */
+
+/** Walk the batch heads of the head sector to the write position */
+static void recover_head(xy_plog_t *plog)
+{
+    uint32_t addr = sector_addr(plog, plog->head);
+    uint32_t off = plog->head_room;
+    uint32_t last_off = 0, prev_time;
+    batch_info_t info, last;
+    int r = 0;
+
+    plog->next_seq  = plog->index[plog->head].seq;
+    plog->last_time = plog->index[plog->head].time;
+    prev_time = plog->last_time;
+    last.count = 0;
+    while (off + BHEAD_SIZE <= plog->config.sector_size) {
+        if (flash_read(plog, addr + off, plog->rbuf, BHEAD_SIZE) != 0)
+            break;
+        r = parse_batch_head(plog, plog->rbuf, &info);
+        if (r <= 0 || off + info.total > plog->config.sector_size)
+            break;
+        if (last.count != 0)
+            prev_time = last.time1;
+        last = info;
+        last_off = off;
+        off += info.total;
+    }
+    /* Garbage after the last batch: leave the sector, open a new one */
+    plog->wr = r < 0 ? plog->config.sector_size : off;
+
+    if (last.count == 0)
+        return;
+    if (flash_read(plog, addr + last_off, plog->rbuf, last.total) == 0
+        && batch_ok(plog->rbuf, last.total)) {
+        plog->next_seq  = last.seq + last.count;
+        plog->last_time = last.time1;
+    } else {
+        /* Torn by a power cut: its records never made it */
+        plog->stats.bad_batches++;
+        plog->next_seq  = last.seq;
+        plog->last_time = prev_time;
+    }
+}
+
+static void mount(xy_plog_t *plog)
+{
+    uint16_t n = plog->config.sector_count;
+    uint32_t s0, sseq, lo, hi, mid, k;
+    uint16_t p;
+    bool valid0;
+
+    plog->used  = 0;
+    plog->count = 0;
+    plog->len   = 0;
+    plog->next_seq  = 0;
+    plog->last_time = 0;
+    plog->stats.first_seq = 0;
+    for (k = 0; k < n; k++)
+        plog->index[k].seq = XY_PLOG_SEQ_NONE;
+
+    /*
+     * Along the ring, sector sequences count up by one from the oldest
+     * sector to the head; the head is followed by erased sectors, by a
+     * sector left half-erased by a power cut, or by the oldest sector.
+     * From sector 0, "sector i has sequence s0 + i" holds up to the head
+     * and fails after it, so the head is found by binary search.
+     */
+    valid0 = read_sector(plog, 0, &s0);
+    if (valid0) {
+        lo = 0;
+        hi = n;
+        while (hi - lo > 1) {
+            mid = (lo + hi) / 2;
+            if (read_sector(plog, (uint16_t)mid, &sseq) && sseq == s0 + mid) {
+                lo = mid;
+            } else {
+                plog->index[mid].seq = XY_PLOG_SEQ_NONE;
+                hi = mid;
+            }
+        }
+        plog->head = (uint16_t)lo;
+        plog->head_sseq = s0 + lo;
+    } else if (read_sector(plog, (uint16_t)(n - 1), &sseq)) {
+        /* Sector 0 was being erased after a wrap */
+        plog->head = (uint16_t)(n - 1);
+        plog->head_sseq = sseq;
+    } else {
+        return; /* Empty */
+    }
+
+    /* Oldest sector: right after the head, or after a half-erased one */
+    plog->tail = valid0 ? 0 : plog->head;
+    for (k = 1; k <= 2 && k < n; k++) {
+        p = (uint16_t)((plog->head + k) % n);
+        if (read_sector(plog, p, &sseq) && sseq == plog->head_sseq - (n - k)) {
+            plog->tail = p;
+            break;
+        }
+        plog->index[p].seq = XY_PLOG_SEQ_NONE;
+    }
+    plog->used = (uint16_t)((plog->head + n - plog->tail) % n + 1);
+    plog->stats.first_seq = index_of(plog, plog->tail)->seq;
+    recover_head(plog);
+}
+
+/* ==================== API ==================== */
+
+xy_plog_status_t xy_plog_init(xy_plog_t *plog, const xy_plog_config_t *config,
+                              const xy_plog_port_t *port, void *workspace,
+                              size_t size)
+{
+    const xy_plog_config_t *c = config;
+    uint8_t *ws = (uint8_t *)workspace;
+    uint32_t head_room;
+
+    if (plog == NULL || c == NULL || port == NULL || ws == NULL
+        || port->read == NULL || port->write == NULL || port->erase == NULL)
+        return XY_PLOG_INVALID_PARAM;
+    if (c->sector_count < 2 || c->prog_unit == 0
+        || c->prog_unit > XY_PLOG_MAX_UNIT
+        || (c->prog_unit & (c->prog_unit - 1)) != 0
+        || c->sector_size % c->prog_unit != 0
+        || c->batch_size % c->prog_unit != 0
+        || size < XY_PLOG_WORKSPACE_SIZE(c->sector_count, c->batch_size)
+        || ((uintptr_t)ws & 3u) != 0)
+        return XY_PLOG_INVALID_PARAM;
+
+    memset(plog, 0, sizeof(*plog));
+    plog->config = *c;
+    plog->port = *port;
+    head_room = round_up(plog, SHDR_SIZE);
+    if (c->batch_size < round_up(plog, BHEAD_SIZE + CKSUM_SIZE + 8)
+        || head_room + c->batch_size > c->sector_size)
+        return XY_PLOG_INVALID_PARAM;
+
+    plog->head_room = (uint16_t)head_room;
+    plog->index = (xy_plog_index_t *)ws;
+    ws += (size_t)c->sector_count * sizeof(xy_plog_index_t);
+    plog->batch = ws;
+    plog->rbuf = ws + XY_PLOG_MAX_UNIT + c->batch_size;
+
+    mount(plog);
+    plog->ready = true;
+    return XY_PLOG_OK;
+}
+
+xy_plog_status_t xy_plog_format(xy_plog_t *plog)
+{
+    uint16_t s;
+
+    if (plog == NULL || !plog->ready)
+        return XY_PLOG_NOT_INIT;
+    for (s = 0; s < plog->config.sector_count; s++) {
+        if (plog->port.erase(plog->port.ctx, sector_addr(plog, s)) != 0)
+            return XY_PLOG_FLASH;
+    }
+    mount(plog);
+    return XY_PLOG_OK;
+}
+
+xy_plog_status_t xy_plog_flush(xy_plog_t *plog)
+{
+    uint8_t *b, *start;
+    uint32_t addr, total, padded;
+    uint8_t isz;
+    xy_plog_status_t ret;
+
+    if (plog == NULL || !plog->ready)
+        return XY_PLOG_NOT_INIT;
+    if (plog->count == 0)
+        return XY_PLOG_OK;
+
+    /* Close the container: header at full width, INFO, checksum, padding */
+    b = plog->batch + plog->head_room;
+    xy_tlv_header_encode(b, XY_PLOG_TAG_BATCH,
+                         (xy_tlv_size_t)(plog->len - XY_TLV_HEADER_SIZE),
+                         XY_TLV_HEADER_SIZE);
+    isz = xy_tlv_header_encode(b + XY_TLV_HEADER_SIZE, XY_PLOG_TAG_INFO,
+                               INFO_VALUE, 0);
+    start = b + XY_TLV_HEADER_SIZE + isz;
+    put32(start, plog->batch_seq);
+    put32(start + 4, plog->batch_time);
+    put32(start + 8, plog->last_time);
+    put16(start + 12, plog->count);
+    total = plog->len;
+    total += xy_tlv_header_encode(b + total, XY_TLV_TYPE_CHECKSUM, 2, 0);
+    put16(b + total, xy_tlv_checksum(b, plog->len));
+    total += 2;
+    padded = round_up(plog, total);
+    memset(b + total, 0xFF, padded - total);
+
+    if (plog->new_sector) {
+        ret = open_sector(plog);
+        if (ret != XY_PLOG_OK)
+            goto fail;
+        write_sector_header(plog, plog->batch);
+        b = plog->batch;
+        padded += plog->head_room;
+    }
+    addr = sector_addr(plog, plog->head) + plog->wr;
+    if (plog->port.write(plog->port.ctx, addr, b, padded) != 0) {
+        ret = XY_PLOG_FLASH;
+        goto fail;
+    }
+    plog->wr += padded;
+    plog->stats.batches++;
+    plog->count = 0;
+    plog->len = 0;
+    return XY_PLOG_OK;
+
+fail:
+    /* The records are lost; the sector is left, the next batch opens one */
+    plog->next_seq  = plog->batch_seq;
+    plog->count = 0;
+    plog->len = 0;
+    if (plog->used != 0)
+        plog->wr = plog->config.sector_size;
+    return ret;
+}
+
+xy_plog_status_t xy_plog_append(xy_plog_t *plog, uint16_t type, uint32_t time,
+                                const void *data, uint16_t len)
+{
+    uint32_t rec = xy_tlv_header_size((xy_tlv_size_t)(RECORD_TIME + len))
+                   + RECORD_TIME + len;
+    uint32_t room, need;
+    uint8_t *p;
+    uint8_t cls = (uint8_t)XY_PLOG_CLASS(type);
+    xy_plog_status_t ret;
+
+    if (plog == NULL || !plog->ready)
+        return XY_PLOG_NOT_INIT;
+    if ((type & 0xF000u) != 0x1000u || cls == 0 || cls == 0xF
+        || (len != 0 && data == NULL))
+        return XY_PLOG_INVALID_PARAM;
+    if (time < plog->last_time)
+        time = plog->last_time;
+
+    if (plog->count != 0
+        && round_up(plog, plog->len + rec + CKSUM_SIZE) > plog->cap) {
+        ret = xy_plog_flush(plog);
+        if (ret != XY_PLOG_OK)
+            return ret;
+    }
+    if (plog->count == 0) {
+        /* Start a batch where it will be programmed */
+        room = plog->used ? plog->config.sector_size - plog->wr : 0;
+        need = round_up(plog, BHEAD_SIZE + rec + CKSUM_SIZE);
+        plog->new_sector = need > room;
+        if (plog->new_sector)
+            room = plog->config.sector_size - plog->head_room;
+        if (room > plog->config.batch_size)
+            room = plog->config.batch_size;
+        if (need > room)
+            return XY_PLOG_INVALID_PARAM;
+        plog->cap = (uint16_t)room;
+        plog->len = BHEAD_SIZE;
+        plog->batch_seq  = plog->next_seq;
+        plog->batch_time = time;
+    }
+
+    p = plog->batch + plog->head_room + plog->len;
+    p += xy_tlv_header_encode(p, type, (xy_tlv_size_t)(RECORD_TIME + len), 0);
+    put32(p, time);
+    if (len != 0)
+        memcpy(p + RECORD_TIME, data, len);
+    plog->len = (uint16_t)(plog->len + rec);
+    plog->count++;
+    plog->next_seq++;
+    plog->last_time = time;
+
+    if (plog->config.sync_mask & (1u << cls))
+        return xy_plog_flush(plog);
+    return XY_PLOG_OK;
+}
+
+xy_plog_status_t xy_plog_query(xy_plog_t *plog, const xy_plog_query_t *query,
+                               xy_plog_visit_t visit, void *arg)
+{
+    const xy_plog_query_t *q = query;
+    const xy_plog_index_t *e;
+    xy_tlv_iterator_t it, child;
+    xy_tlv_t tlv;
+    batch_info_t info;
+    uint32_t lo, hi, mid, k, off, end, addr;
+    uint16_t s;
+
+    if (plog == NULL || !plog->ready)
+        return XY_PLOG_NOT_INIT;
+    if (q == NULL || visit == NULL)
+        return XY_PLOG_INVALID_PARAM;
+
+    /*
+     * First sector: the later of the last one starting at or before seq_min
+     * and the last one starting before time_min (records at time_min may
+     * end the sector before). Both orders hold along the ring.
+     */
+    lo = 0;
+    hi = plog->used;
+    while (hi - lo > 1) {
+        mid = (lo + hi) / 2;
+        e = index_of(plog, PHYS(plog, mid));
+        if (e->seq <= q->seq_min || e->time < q->time_min)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    for (k = lo; k < plog->used; k++) {
+        s = PHYS(plog, k);
+        e = index_of(plog, s);
+        if (e->seq > q->seq_max || e->time > q->time_max)
+            return XY_PLOG_OK;
+        addr = sector_addr(plog, s);
+        end = s == plog->head ? plog->wr : plog->config.sector_size;
+        for (off = plog->head_room; off + BHEAD_SIZE <= end; off += info.total) {
+            if (flash_read(plog, addr + off, plog->rbuf, BHEAD_SIZE) != 0
+                || parse_batch_head(plog, plog->rbuf, &info) <= 0
+                || off + info.total > end)
+                break;
+            if (info.seq > q->seq_max || info.time0 > q->time_max)
+                return XY_PLOG_OK;
+            /* Hop over batches that end before the range */
+            if (info.count == 0 || info.seq + info.count - 1 < q->seq_min
+                || info.time1 < q->time_min)
+                continue;
+            if (flash_read(plog, addr + off, plog->rbuf, info.total) != 0
+                || !batch_ok(plog->rbuf, info.total)) {
+                plog->stats.bad_batches++;
+                continue;
+            }
+            xy_tlv_iterator_init(&it, plog->rbuf, (xy_tlv_size_t)info.total);
+            if (xy_tlv_iterator_next(&it, &tlv) != XY_TLV_OK
+                || xy_tlv_container_enter(&it, &tlv, &child) != XY_TLV_OK
+                || xy_tlv_iterator_next(&child, &tlv) != XY_TLV_OK)
+                continue; /* INFO skipped */
+            if (!visit_records(&child, info.seq, q, visit, arg))
+                return XY_PLOG_OK;
+        }
+    }
+
+    /* Records still in RAM */
+    if (plog->count != 0) {
+        xy_tlv_iterator_init(&it, plog->batch + plog->head_room + BHEAD_SIZE,
+                             (xy_tlv_size_t)(plog->len - BHEAD_SIZE));
+        visit_records(&it, plog->batch_seq, q, visit, arg);
+    }
+    return XY_PLOG_OK;
+}
+
+void xy_plog_get_stats(const xy_plog_t *plog, xy_plog_stats_t *stats)
+{
+    if (plog == NULL || stats == NULL)
+        return;
+    *stats = plog->stats;
+    stats->next_seq = plog->next_seq;
+    stats->used = plog->used;
+    stats->pending = plog->count;
+}
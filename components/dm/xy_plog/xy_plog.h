@@ -0,0 +1,225 @@
+/**
+ * @file xy_plog.h
+ * @brief Append-only product log store: indexed TLV records in a flash ring
+ *
+ * Error, warning, event and usage logs (docs/嵌入式产品日志设计.md) are
+ * appended as xy_tlv records and kept in a circular run of erase sectors,
+ * internal or external flash, through a small port.
+ *
+ * Layout, every element is an xy_tlv element:
+ * - a sector starts with a SECTOR element: sector sequence, sequence number
+ *   and time of its first record
+ * - records are collected in RAM and programmed together as one BATCH
+ *   container: an INFO element (first sequence, first and last time, record
+ *   count), the records, then a CHECKSUM element over the container
+ * - a record is TLV(XY_PLOG_TYPE(class, code), time + payload); its sequence
+ *   number is implied by its place in the batch
+ *
+ * Index: one {sequence, time} entry per sector in RAM, filled lazily from
+ * the sector headers. A query binary searches it for the first sector, then
+ * hops batch headers (INFO gives each batch's range) to the first batch it
+ * needs, and reads only batches in range.
+ *
+ * Reclaim: when the ring is full, opening a sector erases the oldest one;
+ * no data is moved. Mount binary searches the sector headers for the newest
+ * sector and only walks the batch headers of that one. A batch torn by a
+ * power cut fails its checksum and is skipped; its sequence numbers are
+ * reused.
+ *
+ * Record times must not go backwards (RTC seconds, say); an older time is
+ * stored as the previous one so that the time index stays sorted.
+ *
+ * Not thread safe.
+ */
+
+#ifndef XY_PLOG_H
+#define XY_PLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Configuration ==================== */
+
+#define XY_PLOG_MAX_UNIT 32 /**< Largest program unit supported */
+
+/** Workspace for @p sectors sectors and @p batch byte batches */
+#define XY_PLOG_WORKSPACE_SIZE(sectors, batch) \
+    ((size_t)(sectors) * sizeof(xy_plog_index_t) + 2 * (size_t)(batch) \
+     + XY_PLOG_MAX_UNIT)
+
+/* ==================== Log Types ==================== */
+
+/* Log classes, as in the product log design */
+#define XY_PLOG_ERROR   0x01
+#define XY_PLOG_WARNING 0x02
+#define XY_PLOG_EVENT   0x03
+#define XY_PLOG_USAGE   0x04
+
+/** TLV type of a record: class 0x1..0xE, code 0x00..0xFF */
+#define XY_PLOG_TYPE(cls, code) \
+    ((uint16_t)(0x1000u | ((uint16_t)(cls) << 8) | (uint8_t)(code)))
+#define XY_PLOG_CLASS(type) (((type) >> 8) & 0x0Fu)
+#define XY_PLOG_CODE(type)  ((type) & 0xFFu)
+
+/* Store elements (class 0xF is reserved) */
+#define XY_PLOG_TAG_SECTOR 0x1F01 /**< Sector header */
+#define XY_PLOG_TAG_BATCH  0x1F02 /**< Batch container */
+#define XY_PLOG_TAG_INFO   0x1F03 /**< Batch range, first in the container */
+
+/* ==================== Types ==================== */
+
+typedef enum {
+    XY_PLOG_OK = 0,
+    XY_PLOG_INVALID_PARAM, /**< Bad argument, configuration or record size */
+    XY_PLOG_FLASH,         /**< Flash port reported a failure */
+    XY_PLOG_NOT_INIT,      /**< Not mounted */
+} xy_plog_status_t;
+
+/* Flash port, addresses relative to the flash device */
+typedef struct {
+    int (*read)(void *ctx, uint32_t addr, void *data, size_t size);
+    int (*write)(void *ctx, uint32_t addr, const void *data, size_t size);
+    int (*erase)(void *ctx, uint32_t addr); /**< Erase sector at @p addr */
+    void *ctx;
+} xy_plog_port_t;                           /**< All return 0 on success */
+
+typedef struct {
+    uint32_t base;         /**< Address of the first sector */
+    uint32_t sector_size;  /**< Erase sector size in bytes */
+    uint16_t sector_count; /**< Sectors in the ring, >= 2 */
+    uint16_t prog_unit;    /**< Program unit, power of two <= XY_PLOG_MAX_UNIT */
+    uint16_t batch_size;   /**< RAM batch bytes, multiple of prog_unit */
+    uint16_t sync_mask;    /**< Classes written at once, bit (1 << class) */
+} xy_plog_config_t;
+
+/** Sparse index entry, one per sector */
+typedef struct {
+    uint32_t seq;  /**< First record, XY_PLOG_SEQ_NONE until loaded */
+    uint32_t time; /**< Time of the first record */
+} xy_plog_index_t;
+
+#define XY_PLOG_SEQ_NONE 0xFFFFFFFFu
+
+typedef struct {
+    uint32_t seq;        /**< Sequence number, consecutive over the store */
+    uint32_t time;
+    uint16_t type;       /**< XY_PLOG_TYPE() */
+    uint16_t len;
+    const uint8_t *data; /**< Valid during the callback only */
+} xy_plog_record_t;
+
+/** Range of a query, bounds inclusive; class_mask 0 means all classes */
+typedef struct {
+    uint32_t seq_min;
+    uint32_t seq_max;
+    uint32_t time_min;
+    uint32_t time_max;
+    uint16_t class_mask; /**< bit (1 << class) */
+} xy_plog_query_t;
+
+/** Query callback, return false to stop */
+typedef bool (*xy_plog_visit_t)(const xy_plog_record_t *rec, void *arg);
+
+typedef struct {
+    uint32_t first_seq;   /**< Oldest record kept */
+    uint32_t next_seq;    /**< Sequence of the next append */
+    uint32_t batches;     /**< Batches programmed */
+    uint32_t reclaimed;   /**< Sectors erased to make room */
+    uint32_t dropped;     /**< Records lost with reclaimed sectors */
+    uint32_t bad_batches; /**< Batches failing their checksum */
+    uint32_t reads;       /**< Flash read operations issued */
+    uint16_t used;        /**< Sectors holding records */
+    uint16_t pending;     /**< Records waiting in the batch */
+} xy_plog_stats_t;
+
+typedef struct {
+    xy_plog_config_t config;
+    xy_plog_port_t port;
+    xy_plog_index_t *index; /**< Per physical sector */
+    uint8_t *batch;         /**< Sector header room + batch being built */
+    uint8_t *rbuf;          /**< Read buffer, batch_size bytes */
+    uint16_t head_room;     /**< Sector header bytes, rounded to prog_unit */
+    uint16_t tail;          /**< Oldest sector */
+    uint16_t head;          /**< Sector being written */
+    uint16_t used;          /**< Sectors tail..head, 0 when empty */
+    uint32_t head_sseq;     /**< Sector sequence of the head */
+    uint32_t wr;            /**< Write offset in the head sector */
+    uint32_t next_seq;
+    uint32_t last_time;
+    uint16_t len;           /**< Batch bytes built, from the container */
+    uint16_t cap;           /**< Batch bytes allowed, padding included */
+    uint16_t count;         /**< Records in the batch */
+    uint32_t batch_seq;     /**< First record of the batch */
+    uint32_t batch_time;
+    bool new_sector;        /**< The batch opens the next sector */
+    bool ready;
+    xy_plog_stats_t stats;
+} xy_plog_t;
+
+/* ==================== API ==================== */
+
+/**
+ * @brief Mount the store, recovering the head by binary search
+ * @param plog Handle
+ * @param config Configuration, copied
+ * @param port Flash port, copied
+ * @param workspace XY_PLOG_WORKSPACE_SIZE() bytes, 4-byte aligned, owned
+ *        by the handle
+ * @param size Workspace size
+ * @return xy_plog_status_t Operation result
+ */
+xy_plog_status_t xy_plog_init(xy_plog_t *plog, const xy_plog_config_t *config,
+                              const xy_plog_port_t *port, void *workspace,
+                              size_t size);
+
+/**
+ * @brief Erase every sector and start over at sequence 0
+ */
+xy_plog_status_t xy_plog_format(xy_plog_t *plog);
+
+/**
+ * @brief Append one record
+ *
+ * The record goes into the RAM batch; the batch is programmed when the next
+ * record does not fit, on xy_plog_flush(), or at once for sync_mask classes.
+ * @param plog Handle
+ * @param type XY_PLOG_TYPE(class, code)
+ * @param time Record time, clamped to be non-decreasing
+ * @param data Payload
+ * @param len Payload length; the record has to fit in one batch
+ * @return xy_plog_status_t Operation result
+ */
+xy_plog_status_t xy_plog_append(xy_plog_t *plog, uint16_t type, uint32_t time,
+                                const void *data, uint16_t len);
+
+/**
+ * @brief Program the pending batch, if any
+ */
+xy_plog_status_t xy_plog_flush(xy_plog_t *plog);
+
+/**
+ * @brief Visit the records in range, oldest first, pending ones included
+ * @param plog Handle
+ * @param query Range
+ * @param visit Callback
+ * @param arg Callback argument
+ * @return xy_plog_status_t Operation result
+ */
+xy_plog_status_t xy_plog_query(xy_plog_t *plog, const xy_plog_query_t *query,
+                               xy_plog_visit_t visit, void *arg);
+
+/**
+ * @brief Get statistics
+ */
+void xy_plog_get_stats(const xy_plog_t *plog, xy_plog_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XY_PLOG_H */
@@ -0,0 +1,181 @@
+/**
+ * @file xy_rblk.c
+ * @brief Ring block buffer implementation
+ *
+ * wr and rd are pool offsets; wr == rd means empty, so wr never catches up
+ * with rd from behind (at least XY_RBLK_ALIGN bytes stay unused). Only the
+ * producer writes wr and the headers of blocks it allocates; only the
+ * consumer writes rd, get and the state of blocks it has taken. Each side
+ * publishes with a release store and reads the other side's index with an
+ * acquire load, which is all a single-producer/single-consumer ring needs.
+ */
+
+#include "xy_rblk.h"
+
+#define RBLK_ALLOC 0x41u /**< Allocated, being filled */
+#define RBLK_PUT   0x50u /**< Ready for the consumer */
+#define RBLK_GET   0x47u /**< Held by the consumer */
+#define RBLK_FREE  0x46u /**< Released, space reclaimable */
+#define RBLK_PAD   0x5Au /**< Skip to offset 0; only the state word is valid */
+
+#define RBLK_ALIGN_UP(x) \
+    (((uintptr_t)(x) + XY_RBLK_ALIGN - 1) & ~(uintptr_t)(XY_RBLK_ALIGN - 1))
+
+#if defined(__GNUC__)
+#define RBLK_LOAD(v)     __atomic_load_n(&(v), __ATOMIC_ACQUIRE)
+#define RBLK_STORE(v, x) __atomic_store_n(&(v), (x), __ATOMIC_RELEASE)
+#else
+/* Single core without reordering: volatile access is enough */
+#define RBLK_LOAD(v)     (v)
+#define RBLK_STORE(v, x) ((v) = (x))
+#endif
+
+#define RBLK_AT(rblk, off) ((xy_rblk_blk_t *)((rblk)->pool + (off)))
+
+/* ==================== Helpers ==================== */
+
+static uint32_t rblk_wrap(const xy_rblk_t *rblk, uint32_t off)
+{
+    return off == rblk->size ? 0 : off;
+}
+
+/* ==================== API ==================== */
+
+int xy_rblk_init(xy_rblk_t *rblk, void *pool, uint32_t size)
+{
+    uint8_t *start;
+    uint32_t skip;
+
+    if (rblk == NULL || pool == NULL)
+        return -1;
+    start = (uint8_t *)RBLK_ALIGN_UP(pool);
+    skip  = (uint32_t)(start - (uint8_t *)pool);
+    if (size < skip + XY_RBLK_BLK_SIZE(1) + XY_RBLK_ALIGN)
+        return -1;
+
+    rblk->pool = start;
+    rblk->size = (size - skip) & ~(uint32_t)(XY_RBLK_ALIGN - 1);
+    xy_rblk_reset(rblk);
+    return 0;
+}
+
+void xy_rblk_reset(xy_rblk_t *rblk)
+{
+    rblk->wr  = 0;
+    rblk->rd  = 0;
+    rblk->get = 0;
+}
+
+xy_rblk_blk_t *xy_rblk_alloc(xy_rblk_t *rblk, uint32_t len)
+{
+    xy_rblk_blk_t *blk;
+    uint32_t wr, rd, need, off;
+
+    if (len >= rblk->size)
+        return NULL;
+    need = XY_RBLK_BLK_SIZE(len);
+    wr   = rblk->wr;
+    rd   = RBLK_LOAD(rblk->rd);
+
+    if (wr >= rd) {
+        if (need < rblk->size - wr || (need == rblk->size - wr && rd != 0)) {
+            off = wr;
+        } else if (need < rd) {
+            /* Never split a block: skip the tail of the pool */
+            RBLK_AT(rblk, wr)->state = RBLK_PAD;
+            off = 0;
+        } else {
+            return NULL;
+        }
+    } else if (need < rd - wr) {
+        off = wr;
+    } else {
+        return NULL;
+    }
+
+    blk        = RBLK_AT(rblk, off);
+    blk->len   = len;
+    blk->span  = need;
+    blk->state = RBLK_ALLOC;
+    RBLK_STORE(rblk->wr, rblk_wrap(rblk, off + need));
+    return blk;
+}
+
+void xy_rblk_put(xy_rblk_t *rblk, xy_rblk_blk_t *blk, uint32_t len)
+{
+    uint32_t off;
+
+    if (len < blk->len) {
+        blk->len = len;
+        off      = (uint32_t)((uint8_t *)blk - rblk->pool);
+        /* The newest block can give its tail back; the consumer has not
+         * looked past it, since its state is still RBLK_ALLOC */
+        if (rblk_wrap(rblk, off + blk->span) == rblk->wr) {
+            blk->span = XY_RBLK_BLK_SIZE(len);
+            RBLK_STORE(rblk->wr, rblk_wrap(rblk, off + blk->span));
+        }
+    }
+    RBLK_STORE(blk->state, RBLK_PUT);
+}
+
+xy_rblk_blk_t *xy_rblk_get(xy_rblk_t *rblk)
+{
+    xy_rblk_blk_t *blk;
+    uint32_t state;
+
+    for (;;) {
+        if (rblk->get == RBLK_LOAD(rblk->wr))
+            return NULL;
+        blk   = RBLK_AT(rblk, rblk->get);
+        state = RBLK_LOAD(blk->state);
+        if (state == RBLK_PAD) {
+            rblk->get = 0;
+            continue;
+        }
+        if (state != RBLK_PUT)
+            return NULL;
+        blk->state = RBLK_GET;
+        rblk->get  = rblk_wrap(rblk, rblk->get + blk->span);
+        return blk;
+    }
+}
+
+void xy_rblk_free(xy_rblk_t *rblk, xy_rblk_blk_t *blk)
+{
+    xy_rblk_blk_t *b;
+    uint32_t rd = rblk->rd;
+
+    blk->state = RBLK_FREE;
+    /* Reclaim the run of released blocks at the old end */
+    while (rd != rblk->get) {
+        b = RBLK_AT(rblk, rd);
+        if (b->state == RBLK_PAD)
+            rd = 0;
+        else if (b->state == RBLK_FREE)
+            rd = rblk_wrap(rblk, rd + b->span);
+        else
+            break;
+    }
+    RBLK_STORE(rblk->rd, rd);
+}
+
+uint32_t xy_rblk_space(xy_rblk_t *rblk)
+{
+    uint32_t wr = rblk->wr;
+    uint32_t rd = RBLK_LOAD(rblk->rd);
+    uint32_t avail;
+
+    if (wr >= rd) {
+        avail = rblk->size - wr - (rd == 0 ? XY_RBLK_ALIGN : 0);
+        if (rd != 0 && rd - XY_RBLK_ALIGN > avail)
+            avail = rd - XY_RBLK_ALIGN;
+    } else {
+        avail = rd - wr - XY_RBLK_ALIGN;
+    }
+    return avail > XY_RBLK_HEAD_SIZE ? avail - XY_RBLK_HEAD_SIZE : 0;
+}
+
+int xy_rblk_is_empty(xy_rblk_t *rblk)
+{
+    return RBLK_LOAD(rblk->rd) == RBLK_LOAD(rblk->wr);
+}
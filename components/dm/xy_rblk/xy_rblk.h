@@ -0,0 +1,148 @@
+/**
+ * @file xy_rblk.h
+ * @brief Ring block buffer: variable-size blocks in one contiguous ring
+ *
+ * Every block is a header followed by its payload, laid out back to back in
+ * the pool. A block never wraps: if it does not fit before the end of the
+ * pool, the tail is skipped with a pad header and the block starts at
+ * offset 0. Payloads start on XY_RBLK_ALIGN boundaries, so a DMA engine
+ * can write or read them in place.
+ *
+ * Producer side: xy_rblk_alloc() -> fill (CPU or DMA) -> xy_rblk_put().
+ * Consumer side: xy_rblk_get()   -> use in place      -> xy_rblk_free().
+ *
+ * Blocks are delivered in allocation order; a block that is allocated but
+ * not yet put holds back the ones behind it. Several blocks may be in
+ * flight on either side, and they may be put or freed in any order.
+ *
+ * One producer and one consumer may run concurrently (for example a DMA
+ * complete ISR and a task) without locks. Multiple producers or multiple
+ * consumers need external locking.
+ */
+
+#ifndef XY_RBLK_H
+#define XY_RBLK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Configuration ==================== */
+
+/**
+ * @brief Payload alignment in bytes, a power of two >= 4
+ *
+ * Use the cache line size (e.g. 32) when blocks are DMA targets on a core
+ * with a data cache, so that cache maintenance never touches a neighbour.
+ */
+#ifndef XY_RBLK_ALIGN
+#define XY_RBLK_ALIGN 4
+#endif
+
+/* ==================== Types ==================== */
+
+/** Block header, XY_RBLK_HEAD_SIZE bytes in the pool before the payload */
+typedef struct {
+    volatile uint32_t state; /**< Private */
+    uint32_t len;            /**< Payload length in bytes */
+    uint32_t span;           /**< Private: pool bytes taken, header included */
+} xy_rblk_blk_t;
+
+typedef struct {
+    uint8_t *pool;
+    uint32_t size;         /**< Usable pool bytes, multiple of XY_RBLK_ALIGN */
+    volatile uint32_t wr;  /**< Next allocation, written by the producer */
+    volatile uint32_t rd;  /**< Oldest unfreed block, written by the consumer */
+    uint32_t get;          /**< Next block to get, consumer private */
+} xy_rblk_t;
+
+#define XY_RBLK_HEAD_SIZE \
+    ((sizeof(xy_rblk_blk_t) + XY_RBLK_ALIGN - 1) & ~(uint32_t)(XY_RBLK_ALIGN - 1))
+
+/** Payload of a block */
+#define xy_rblk_buf(blk) ((uint8_t *)(blk) + XY_RBLK_HEAD_SIZE)
+
+/** Payload length of a block */
+#define xy_rblk_len(blk) ((blk)->len)
+
+/** Pool bytes taken by a block of @p len payload bytes */
+#define XY_RBLK_BLK_SIZE(len) \
+    (XY_RBLK_HEAD_SIZE + (((uint32_t)(len) + XY_RBLK_ALIGN - 1) & ~(uint32_t)(XY_RBLK_ALIGN - 1)))
+
+/* ==================== API ==================== */
+
+/**
+ * @brief Initialize over a caller-provided pool
+ * @param rblk Ring block buffer
+ * @param pool Memory, start is aligned up to XY_RBLK_ALIGN
+ * @param size Pool size in bytes
+ * @return int 0 on success, -1 if the pool cannot hold a block
+ */
+int xy_rblk_init(xy_rblk_t *rblk, void *pool, uint32_t size);
+
+/**
+ * @brief Drop every block; neither side may be active
+ * @param rblk Ring block buffer
+ */
+void xy_rblk_reset(xy_rblk_t *rblk);
+
+/**
+ * @brief Producer: reserve a block of @p len contiguous payload bytes
+ *
+ * An empty ring always fits a payload of half the pool less a header.
+ *
+ * @param rblk Ring block buffer
+ * @param len Payload length
+ * @return xy_rblk_blk_t* Block, NULL if there is no room
+ */
+xy_rblk_blk_t *xy_rblk_alloc(xy_rblk_t *rblk, uint32_t len);
+
+/**
+ * @brief Producer: hand a filled block to the consumer
+ *
+ * @p len may be less than the allocated length, e.g. when a DMA transfer
+ * ended early on an idle line. If @p blk is the most recent allocation the
+ * unused tail goes back to the ring.
+ *
+ * @param rblk Ring block buffer
+ * @param blk Block from xy_rblk_alloc()
+ * @param len Bytes filled, at most the allocated length
+ */
+void xy_rblk_put(xy_rblk_t *rblk, xy_rblk_blk_t *blk, uint32_t len);
+
+/**
+ * @brief Consumer: take the next block in allocation order
+ * @param rblk Ring block buffer
+ * @return xy_rblk_blk_t* Block, NULL if the next block is not put yet
+ */
+xy_rblk_blk_t *xy_rblk_get(xy_rblk_t *rblk);
+
+/**
+ * @brief Consumer: release a block from xy_rblk_get()
+ * @param rblk Ring block buffer
+ * @param blk Block
+ */
+void xy_rblk_free(xy_rblk_t *rblk, xy_rblk_blk_t *blk);
+
+/**
+ * @brief Largest payload xy_rblk_alloc() could return now (producer side)
+ * @param rblk Ring block buffer
+ * @return uint32_t Bytes
+ */
+uint32_t xy_rblk_space(xy_rblk_t *rblk);
+
+/**
+ * @brief Whether no block is allocated, queued or held
+ * @param rblk Ring block buffer
+ * @return int 1 if empty
+ */
+int xy_rblk_is_empty(xy_rblk_t *rblk);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XY_RBLK_H */
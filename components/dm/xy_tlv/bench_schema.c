@@ -0,0 +1,272 @@
+/**
+ * @file bench_schema.c
+ * @brief Schema codec vs. hand-written per-field calls
+ *
+ * Encodes and decodes the same 10-field record both ways, checks that the
+ * wire bytes and the decoded structs agree, then reports ns per record.
+ * Also checks the STRING field at its limits: N-1 chars round-trip, and a
+ * full array with no NUL is sent as its first N-1 chars.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "xy_tlv.h"
+#include "xy_tlv_schema.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROUNDS 200000
+
+/* ==================== Record and Schema ==================== */
+
+#define REC_ID       0x2001
+#define REC_SEQ      0x2002
+#define REC_TEMP     0x2003
+#define REC_HUMIDITY 0x2004
+#define REC_PRESSURE 0x2005
+#define REC_UPTIME   0x2006
+#define REC_ONLINE   0x2007
+#define REC_RSSI     0x2008
+#define REC_NAME     0x2009
+#define REC_MAC      0x200A
+
+typedef struct {
+    uint32_t id;
+    uint16_t seq;
+    int16_t temp;
+    uint8_t humidity;
+    float pressure;
+    uint64_t uptime;
+    bool online;
+    int8_t rssi;
+    char name[16];
+    uint8_t mac[6];
+} bench_record_t;
+
+#define BENCH_RECORD_SCHEMA(X)                      \
+    X(bench_record_t, id, REC_ID, U32)              \
+    X(bench_record_t, seq, REC_SEQ, U16)            \
+    X(bench_record_t, temp, REC_TEMP, I16)          \
+    X(bench_record_t, humidity, REC_HUMIDITY, U8)   \
+    X(bench_record_t, pressure, REC_PRESSURE, FLOAT) \
+    X(bench_record_t, uptime, REC_UPTIME, U64)      \
+    X(bench_record_t, online, REC_ONLINE, BOOL)     \
+    X(bench_record_t, rssi, REC_RSSI, I8)           \
+    X(bench_record_t, name, REC_NAME, STRING)       \
+    X(bench_record_t, mac, REC_MAC, BYTES)
+
+XY_TLV_SCHEMA_DEFINE(bench_record_schema, bench_record_t, BENCH_RECORD_SCHEMA);
+
+static uint8_t s_buf[XY_TLV_SCHEMA_MAX_SIZE(BENCH_RECORD_SCHEMA)];
+
+/* ==================== Hand-written Codec ==================== */
+
+static int hand_encode(xy_tlv_buffer_t *b, const bench_record_t *r)
+{
+    uint32_t bits;
+    int ret = 0;
+
+    memcpy(&bits, &r->pressure, sizeof(bits));
+    ret |= xy_tlv_encode_uint32(b, REC_ID, r->id);
+    ret |= xy_tlv_encode_uint16(b, REC_SEQ, r->seq);
+    ret |= xy_tlv_encode_int16(b, REC_TEMP, r->temp);
+    ret |= xy_tlv_encode_uint8(b, REC_HUMIDITY, r->humidity);
+    ret |= xy_tlv_encode_uint32(b, REC_PRESSURE, bits);
+    ret |= xy_tlv_encode_uint64(b, REC_UPTIME, r->uptime);
+    ret |= xy_tlv_encode_bool(b, REC_ONLINE, r->online);
+    ret |= xy_tlv_encode_int8(b, REC_RSSI, r->rssi);
+    ret |= xy_tlv_encode_string(b, REC_NAME, r->name);
+    ret |= xy_tlv_encode_bytes(b, REC_MAC, r->mac, sizeof(r->mac));
+    return ret;
+}
+
+static int hand_decode(const uint8_t *buf, xy_tlv_size_t len, bench_record_t *r)
+{
+    xy_tlv_iterator_t iter;
+    xy_tlv_size_t n;
+    uint32_t bits;
+    xy_tlv_t tlv;
+    int ret = 0;
+
+    xy_tlv_iterator_init(&iter, buf, len);
+    while (xy_tlv_iterator_next(&iter, &tlv) == XY_TLV_OK) {
+        switch (tlv.type) {
+        case REC_ID:
+            ret |= xy_tlv_decode_uint32(&tlv, &r->id);
+            break;
+        case REC_SEQ:
+            ret |= xy_tlv_decode_uint16(&tlv, &r->seq);
+            break;
+        case REC_TEMP:
+            ret |= xy_tlv_decode_int16(&tlv, &r->temp);
+            break;
+        case REC_HUMIDITY:
+            ret |= xy_tlv_decode_uint8(&tlv, &r->humidity);
+            break;
+        case REC_PRESSURE:
+            ret |= xy_tlv_decode_uint32(&tlv, &bits);
+            memcpy(&r->pressure, &bits, sizeof(bits));
+            break;
+        case REC_UPTIME:
+            ret |= xy_tlv_decode_uint64(&tlv, &r->uptime);
+            break;
+        case REC_ONLINE:
+            ret |= xy_tlv_decode_bool(&tlv, &r->online);
+            break;
+        case REC_RSSI:
+            ret |= xy_tlv_decode_int8(&tlv, &r->rssi);
+            break;
+        case REC_NAME:
+            ret |= xy_tlv_decode_string(&tlv, r->name, sizeof(r->name));
+            break;
+        case REC_MAC:
+            n = sizeof(r->mac);
+            ret |= xy_tlv_decode_bytes(&tlv, r->mac, &n);
+            break;
+        default:
+            break;
+        }
+    }
+    return ret;
+}
+
+/* ==================== Timing ==================== */
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static volatile uint32_t s_sink;
+
+static double bench_encode(int schema, const bench_record_t *r)
+{
+    xy_tlv_buffer_t b;
+    double t0 = now_ns();
+    int i;
+
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        xy_tlv_buffer_init(&b, s_buf, sizeof(s_buf));
+        if (schema) {
+            xy_tlv_schema_encode(&b, &bench_record_schema, r);
+        } else {
+            hand_encode(&b, r);
+        }
+        s_sink += b.offset;
+    }
+    return (now_ns() - t0) / BENCH_ROUNDS;
+}
+
+static double bench_decode(int schema, xy_tlv_size_t len, bench_record_t *r)
+{
+    double t0 = now_ns();
+    int i;
+
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        if (schema) {
+            xy_tlv_schema_decode(s_buf, len, &bench_record_schema, r, NULL);
+        } else {
+            hand_decode(s_buf, len, r);
+        }
+        s_sink += r->id;
+    }
+    return (now_ns() - t0) / BENCH_ROUNDS;
+}
+
+/* ==================== STRING Boundary ==================== */
+
+/* Encode @p name into the record and decode it back into @p out */
+static int string_round_trip(const char *name, size_t n, bench_record_t *out)
+{
+    bench_record_t r;
+    xy_tlv_buffer_t buf;
+
+    memset(&r, 0, sizeof(r));
+    memcpy(r.name, name, n);
+    xy_tlv_buffer_init(&buf, s_buf, sizeof(s_buf));
+    if (xy_tlv_schema_encode(&buf, &bench_record_schema, &r) != XY_TLV_OK)
+        return 0;
+    memset(out, 0xAA, sizeof(*out));
+    return xy_tlv_schema_decode(s_buf, buf.offset, &bench_record_schema, out,
+                                NULL)
+           == XY_TLV_OK;
+}
+
+static int check_string_boundary(void)
+{
+    bench_record_t out;
+
+    /* 15 chars and the NUL: the whole string */
+    if (!string_round_trip("0123456789abcde", 16, &out)
+        || strcmp(out.name, "0123456789abcde") != 0)
+        return 0;
+    /* 16 chars, no NUL: cut to the 15 that decode has room for */
+    if (!string_round_trip("0123456789abcdef", 16, &out)
+        || strcmp(out.name, "0123456789abcde") != 0)
+        return 0;
+    /* Empty */
+    return string_round_trip("", 1, &out) && out.name[0] == '\0';
+}
+
+/* ==================== Main ==================== */
+
+int main(void)
+{
+    static const bench_record_t rec = {
+        0x12345678u, 42, -1250, 55, 1013.25f, 86400123ull, true, -67,
+        "node-17", { 0x00, 0x1A, 0x2B, 0x3C, 0x4D, 0x5E }
+    };
+    uint8_t hand_wire[sizeof(s_buf)];
+    bench_record_t a, b;
+    xy_tlv_buffer_t buf;
+    xy_tlv_size_t len;
+    uint32_t present;
+    double he, se, hd, sd;
+
+    /* Equivalence: same bytes on the wire, same struct back */
+    xy_tlv_buffer_init(&buf, hand_wire, sizeof(hand_wire));
+    if (hand_encode(&buf, &rec) != XY_TLV_OK) {
+        printf("hand encode failed\n");
+        return 1;
+    }
+    len = buf.offset;
+    xy_tlv_buffer_init(&buf, s_buf, sizeof(s_buf));
+    if (xy_tlv_schema_encode(&buf, &bench_record_schema, &rec) != XY_TLV_OK
+        || buf.offset != len || memcmp(s_buf, hand_wire, len) != 0) {
+        printf("schema encode mismatch\n");
+        return 1;
+    }
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    if (hand_decode(s_buf, len, &a) != XY_TLV_OK
+        || xy_tlv_schema_decode(s_buf, len, &bench_record_schema, &b,
+                                &present)
+               != XY_TLV_OK
+        || present != 0x3FFu || memcmp(&a, &b, sizeof(a)) != 0
+        || memcmp(&b, &rec, sizeof(b)) != 0) {
+        printf("schema decode mismatch\n");
+        return 1;
+    }
+    if (!check_string_boundary()) {
+        printf("string boundary check failed\n");
+        return 1;
+    }
+    printf("record: %u fields, %u bytes (max %u)\n",
+           (unsigned)bench_record_schema.field_count, (unsigned)len,
+           (unsigned)bench_record_schema.max_encoded);
+
+    he = bench_encode(0, &rec);
+    se = bench_encode(1, &rec);
+    hd = bench_decode(0, len, &a);
+    sd = bench_decode(1, len, &b);
+
+    printf("            per-field   schema   speedup\n");
+    printf("  encode   %8.1f ns %7.1f ns   %5.2fx\n", he, se, he / se);
+    printf("  decode   %8.1f ns %7.1f ns   %5.2fx\n", hd, sd, hd / sd);
+
+    return 0;
+}
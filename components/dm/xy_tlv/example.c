@@ -4,6 +4,7 @@
  */
 
 #include "xy_tlv.h"
+#include "xy_tlv_stream.h"
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -453,13 +454,13 @@ void example_binary_data(void)
     while (xy_tlv_iterator_next(&iter, &tlv) == XY_TLV_OK) {
         if (tlv.type == XY_TLV_TYPE_MAC_ADDR) {
             uint8_t mac[6];
-            uint16_t len = sizeof(mac);
+            xy_tlv_size_t len = sizeof(mac);
             xy_tlv_decode_bytes(&tlv, mac, &len);
             printf("MAC Address: %02X:%02X:%02X:%02X:%02X:%02X\n", mac[0],
                    mac[1], mac[2], mac[3], mac[4], mac[5]);
         } else if (tlv.type == XY_TLV_TYPE_UUID) {
             uint8_t uid[16];
-            uint16_t len = sizeof(uid);
+            xy_tlv_size_t len = sizeof(uid);
             xy_tlv_decode_bytes(&tlv, uid, &len);
             printf("UUID: ");
             for (int i = 0; i < 16; i++) {
@@ -472,6 +473,136 @@ void example_binary_data(void)
     }
 }
 
+/* ==================== Example 8: Indexed Lookup ==================== */
+
+#define CFG_NETWORK 0x1010
+#define CFG_WIFI    0x1011
+
+static bool example_is_container(uint16_t type)
+{
+    return type == CFG_NETWORK || type == CFG_WIFI
+           || xy_tlv_is_builtin_container(type);
+}
+
+void example_index(void)
+{
+    printf("\n=== Example 8: Indexed Lookup ===\n");
+
+    uint8_t buffer[256];
+    xy_tlv_buffer_t tlv_buf;
+
+    /* Encode a record with nested containers */
+    xy_tlv_buffer_init(&tlv_buf, buffer, sizeof(buffer));
+    xy_tlv_encode_uint32(&tlv_buf, CFG_DEVICE_ID, 0x12345678);
+    xy_tlv_container_begin(&tlv_buf, CFG_NETWORK);
+    xy_tlv_container_begin(&tlv_buf, CFG_WIFI);
+    xy_tlv_encode_string(&tlv_buf, CFG_WIFI_SSID, "HomeNetwork");
+    xy_tlv_encode_bool(&tlv_buf, CFG_WIFI_ENABLED, true);
+    xy_tlv_container_end(&tlv_buf);
+    xy_tlv_container_end(&tlv_buf);
+    xy_tlv_encode_string(&tlv_buf, CFG_DEVICE_NAME, "XY Device");
+
+    /* One pass builds the index; lookups are then binary searches */
+    xy_tlv_index_entry_t entries[16];
+    xy_tlv_index_t index;
+
+    xy_tlv_index_init(&index, entries, 16, example_is_container);
+    if (xy_tlv_index_build(&index, buffer, xy_tlv_buffer_get_used(&tlv_buf))
+        != XY_TLV_OK) {
+        printf("Index build failed\n");
+        return;
+    }
+    printf("Indexed %u TLVs, %d at top level\n", index.count,
+           xy_tlv_index_count(&index, NULL));
+
+    xy_tlv_t tlv;
+    char name[32];
+    if (xy_tlv_index_find(&index, NULL, CFG_DEVICE_NAME, &tlv) == XY_TLV_OK) {
+        xy_tlv_decode_string(&tlv, name, sizeof(name));
+        printf("Device Name: %s\n", name);
+    }
+
+    const uint16_t path[] = { CFG_NETWORK, CFG_WIFI, CFG_WIFI_SSID };
+    if (xy_tlv_index_find_path(&index, path, 3, &tlv) == XY_TLV_OK) {
+        xy_tlv_decode_string(&tlv, name, sizeof(name));
+        printf("Network/WiFi/SSID: %s\n", name);
+    }
+}
+
+static int stream_event(void *ctx, const xy_tlv_event_t *evt)
+{
+    (void)ctx;
+
+    switch (evt->event) {
+    case XY_TLV_EVT_ENTER:
+        printf("%*sENTER 0x%04X (%u bytes)\n", evt->depth * 2, "",
+               evt->tlv.type, (unsigned)evt->tlv.length);
+        break;
+    case XY_TLV_EVT_LEAVE:
+        printf("%*sLEAVE 0x%04X\n", evt->depth * 2, "", evt->tlv.type);
+        break;
+    case XY_TLV_EVT_ELEMENT:
+        printf("%*s0x%04X: %u bytes\n", evt->depth * 2, "", evt->tlv.type,
+               (unsigned)evt->tlv.length);
+        break;
+    case XY_TLV_EVT_CHUNK:
+        printf("%*s0x%04X: chunk %u+%u of %u\n", evt->depth * 2, "",
+               evt->tlv.type, (unsigned)evt->offset,
+               (unsigned)evt->tlv.length, (unsigned)evt->total_length);
+        break;
+    }
+    return 0;
+}
+
+void example_streaming(void)
+{
+    printf("\n=== Example 9: Streaming Parse and Segment Chains ===\n");
+
+    /* Encode into three small blocks instead of one buffer */
+    uint8_t blk0[16], blk1[16], blk2[48];
+    xy_tlv_seg_t segs[] = { { blk0, sizeof(blk0) },
+                            { blk1, sizeof(blk1) },
+                            { blk2, sizeof(blk2) } };
+    xy_tlv_sg_writer_t writer;
+    uint8_t blob[40];
+    uint32_t device_id = 0x12345678;
+
+    memset(blob, 0xA5, sizeof(blob));
+    xy_tlv_sg_init(&writer, segs, 3);
+    xy_tlv_sg_container_begin(&writer, XY_TLV_TYPE_CONTAINER);
+    xy_tlv_sg_encode(&writer, CFG_DEVICE_ID, &device_id, sizeof(device_id));
+    xy_tlv_sg_encode(&writer, CFG_DEVICE_NAME, "XY-Stream", 10);
+    xy_tlv_sg_container_end(&writer);
+    xy_tlv_sg_value_begin(&writer, XY_TLV_TYPE_BLOB, sizeof(blob));
+    xy_tlv_sg_value_write(&writer, blob, 25);
+    xy_tlv_sg_value_write(&writer, blob + 25, sizeof(blob) - 25);
+
+    xy_tlv_seg_t iov[3];
+    int cnt = xy_tlv_sg_get_segments(&writer, iov, 3);
+    printf("Encoded %u bytes into %d segments\n",
+           (unsigned)xy_tlv_sg_get_used(&writer), cnt);
+
+    /* Feed the segments to the parser in 5-byte fragments, as a UART
+     * driver would; the 16-byte stage forces the blob into chunks. */
+    uint8_t stage[16];
+    xy_tlv_parser_t parser;
+    xy_tlv_parser_init(&parser, stage, sizeof(stage),
+                       xy_tlv_is_builtin_container, stream_event, NULL);
+
+    for (int i = 0; i < cnt; i++) {
+        for (size_t off = 0; off < iov[i].len; off += 5) {
+            size_t n = iov[i].len - off < 5 ? iov[i].len - off : 5;
+            if (xy_tlv_parser_feed(&parser, iov[i].data + off, n)
+                != XY_TLV_OK) {
+                printf("Parse error\n");
+                return;
+            }
+        }
+    }
+    printf("Parser idle: %s\n",
+           xy_tlv_parser_is_idle(&parser) ? "yes" : "no");
+}
+
 /* ==================== Main ==================== */
 
 int main(void)
@@ -486,6 +617,8 @@ int main(void)
     example_validation();
     example_statistics();
     example_binary_data();
+    example_index();
+    example_streaming();
 
     printf("\n=== All examples completed ===\n");
 
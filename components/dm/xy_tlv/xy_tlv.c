@@ -58,7 +58,8 @@ static inline void write_uint32(uint8_t *buf, uint32_t value)
  */
 static inline uint32_t read_uint32(const uint8_t *buf)
 {
-    return (uint32_t)((buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3]);
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16)
+           | ((uint32_t)buf[2] << 8) | (uint32_t)buf[3];
 }
 
 /**
@@ -87,10 +88,115 @@ static inline uint64_t read_uint64(const uint8_t *buf)
            | ((uint64_t)buf[6] << 8) | (uint64_t)buf[7];
 }
 
+/**
+ * @brief Size of the length field for a given value length
+ */
+static inline uint8_t length_field_size(xy_tlv_size_t length)
+{
+#if XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_VARINT
+    uint8_t n = 1;
+
+    while (length >= 0x80) {
+        length >>= 7;
+        n++;
+    }
+    return n;
+#else
+    (void)length;
+    return XY_TLV_LENGTH_FIELD_SIZE;
+#endif
+}
+
+/**
+ * @brief Write the length field, padded to @p field_size bytes
+ *
+ * In varint mode a larger @p field_size produces a non-minimal encoding,
+ * which lets container headers be reserved before the length is known.
+ */
+static inline void write_length(uint8_t *buf, xy_tlv_size_t length,
+                                uint8_t field_size)
+{
+#if XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_16
+    (void)field_size;
+    write_uint16(buf, length);
+#elif XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_32
+    (void)field_size;
+    write_uint32(buf, length);
+#else
+    uint8_t i;
+
+    for (i = 0; i + 1 < field_size; i++) {
+        buf[i] = (uint8_t)(length & 0x7F) | 0x80;
+        length >>= 7;
+    }
+    buf[i] = (uint8_t)length;
+#endif
+}
+
+/**
+ * @brief Read the length field
+ *
+ * @param buf Length field
+ * @param avail Bytes available at @p buf
+ * @param length Output length
+ * @return Field size in bytes, 0 if truncated or malformed
+ */
+static inline uint8_t read_length(const uint8_t *buf, xy_tlv_size_t avail,
+                                  xy_tlv_size_t *length)
+{
+#if XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_16
+    if (avail < 2) {
+        return 0;
+    }
+    *length = read_uint16(buf);
+    return 2;
+#elif XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_32
+    if (avail < 4) {
+        return 0;
+    }
+    *length = read_uint32(buf);
+    return 4;
+#else
+    uint32_t value = 0;
+    uint8_t i;
+
+    for (i = 0; i < XY_TLV_LENGTH_FIELD_SIZE && i < avail; i++) {
+        value |= (uint32_t)(buf[i] & 0x7F) << (7 * i);
+        if ((buf[i] & 0x80) == 0) {
+            /* The 5th byte may only carry the top 4 bits */
+            if (i == XY_TLV_LENGTH_FIELD_SIZE - 1 && buf[i] > 0x0F) {
+                return 0;
+            }
+            *length = value;
+            return (uint8_t)(i + 1);
+        }
+    }
+    return 0;
+#endif
+}
+
+/**
+ * @brief Parse a T+L header
+ *
+ * @return Header size, 0 if truncated or malformed
+ */
+static inline uint8_t read_header(const uint8_t *buf, xy_tlv_size_t avail,
+                                  uint16_t *type, xy_tlv_size_t *length)
+{
+    uint8_t n;
+
+    if (avail < XY_TLV_HEADER_MIN_SIZE) {
+        return 0;
+    }
+    *type = read_uint16(buf);
+    n     = read_length(buf + 2, avail - 2, length);
+    return n ? (uint8_t)(2 + n) : 0;
+}
+
 /* ==================== Core API - Buffer Management ==================== */
 
 int xy_tlv_buffer_init(xy_tlv_buffer_t *tlv_buf, uint8_t *buffer,
-                       uint16_t capacity)
+                       xy_tlv_size_t capacity)
 {
     if (!tlv_buf || !buffer || capacity == 0) {
         return XY_TLV_INVALID_PARAM;
@@ -116,7 +222,7 @@ int xy_tlv_buffer_reset(xy_tlv_buffer_t *tlv_buf)
     return XY_TLV_OK;
 }
 
-uint16_t xy_tlv_buffer_get_used(const xy_tlv_buffer_t *tlv_buf)
+xy_tlv_size_t xy_tlv_buffer_get_used(const xy_tlv_buffer_t *tlv_buf)
 {
     if (!tlv_buf) {
         return 0;
@@ -124,7 +230,7 @@ uint16_t xy_tlv_buffer_get_used(const xy_tlv_buffer_t *tlv_buf)
     return tlv_buf->offset;
 }
 
-uint16_t xy_tlv_buffer_get_free(const xy_tlv_buffer_t *tlv_buf)
+xy_tlv_size_t xy_tlv_buffer_get_free(const xy_tlv_buffer_t *tlv_buf)
 {
     if (!tlv_buf) {
         return 0;
@@ -132,10 +238,37 @@ uint16_t xy_tlv_buffer_get_free(const xy_tlv_buffer_t *tlv_buf)
     return tlv_buf->capacity - tlv_buf->offset;
 }
 
+uint8_t xy_tlv_header_size(xy_tlv_size_t length)
+{
+    return (uint8_t)(2 + length_field_size(length));
+}
+
+uint8_t xy_tlv_header_encode(uint8_t *buf, uint16_t type, xy_tlv_size_t length,
+                             uint8_t header_size)
+{
+    uint8_t len_size = length_field_size(length);
+
+    if (header_size > 2 + len_size && header_size <= XY_TLV_HEADER_SIZE) {
+        len_size = header_size - 2;
+    }
+    write_uint16(buf, type);
+    write_length(buf + 2, length, len_size);
+    return (uint8_t)(2 + len_size);
+}
+
+uint8_t xy_tlv_header_decode(const uint8_t *buf, xy_tlv_size_t avail,
+                             uint16_t *type, xy_tlv_size_t *length)
+{
+    if (!buf || !type || !length) {
+        return 0;
+    }
+    return read_header(buf, avail, type, length);
+}
+
 /* ==================== Core API - Encoding ==================== */
 
 int xy_tlv_encode(xy_tlv_buffer_t *tlv_buf, uint16_t type, const void *value,
-                  uint16_t length)
+                  xy_tlv_size_t length)
 {
     if (!tlv_buf || !tlv_buf->buffer) {
         g_tlv_stats.encoding_errors++;
@@ -147,18 +280,20 @@ int xy_tlv_encode(xy_tlv_buffer_t *tlv_buf, uint16_t type, const void *value,
         return XY_TLV_INVALID_PARAM;
     }
 
-    /* Check buffer space */
-    uint16_t required = XY_TLV_HEADER_SIZE + length;
-    if (tlv_buf->offset + required > tlv_buf->capacity) {
+    /* Check buffer space (written so that it cannot wrap) */
+    uint8_t len_size = length_field_size(length);
+    xy_tlv_size_t free_space = tlv_buf->capacity - tlv_buf->offset;
+    if (free_space < 2u + len_size || length > free_space - 2u - len_size) {
         g_tlv_stats.encoding_errors++;
         return XY_TLV_BUFFER_OVERFLOW;
     }
+    xy_tlv_size_t required = (xy_tlv_size_t)(2u + len_size + length);
 
     /* Write type and length */
     write_uint16(&tlv_buf->buffer[tlv_buf->offset], type);
     tlv_buf->offset += 2;
-    write_uint16(&tlv_buf->buffer[tlv_buf->offset], length);
-    tlv_buf->offset += 2;
+    write_length(&tlv_buf->buffer[tlv_buf->offset], length, len_size);
+    tlv_buf->offset += len_size;
 
     /* Write value */
     if (length > 0) {
@@ -239,12 +374,15 @@ int xy_tlv_encode_string(xy_tlv_buffer_t *tlv_buf, uint16_t type,
     if (!str) {
         return XY_TLV_INVALID_PARAM;
     }
-    uint16_t len = (uint16_t)strlen(str);
-    return xy_tlv_encode(tlv_buf, type, str, len);
+    size_t len = strlen(str);
+    if (len > XY_TLV_LENGTH_MAX) {
+        return XY_TLV_INVALID_LENGTH;
+    }
+    return xy_tlv_encode(tlv_buf, type, str, (xy_tlv_size_t)len);
 }
 
 int xy_tlv_encode_bytes(xy_tlv_buffer_t *tlv_buf, uint16_t type,
-                        const uint8_t *bytes, uint16_t length)
+                        const uint8_t *bytes, xy_tlv_size_t length)
 {
     return xy_tlv_encode(tlv_buf, type, bytes, length);
 }
@@ -252,7 +390,7 @@ int xy_tlv_encode_bytes(xy_tlv_buffer_t *tlv_buf, uint16_t type,
 /* ==================== Core API - Decoding ==================== */
 
 int xy_tlv_iterator_init(xy_tlv_iterator_t *iter, const uint8_t *buffer,
-                         uint16_t buffer_len)
+                         xy_tlv_size_t buffer_len)
 {
     if (!iter || !buffer || buffer_len == 0) {
         return XY_TLV_INVALID_PARAM;
@@ -274,33 +412,30 @@ int xy_tlv_iterator_next(xy_tlv_iterator_t *iter, xy_tlv_t *tlv)
         return XY_TLV_INVALID_PARAM;
     }
 
-    /* Check if enough data for header */
-    if (iter->remaining < XY_TLV_HEADER_SIZE) {
-        if (iter->remaining > 0) {
-            g_tlv_stats.decoding_errors++;
-            return XY_TLV_BUFFER_UNDERFLOW;
-        }
+    if (iter->remaining == 0) {
         return XY_TLV_NOT_FOUND; /* End of buffer */
     }
 
     /* Read type and length */
     const uint8_t *ptr = &iter->buffer[iter->offset];
-    tlv->type          = read_uint16(ptr);
-    ptr += 2;
-    tlv->length = read_uint16(ptr);
-    ptr += 2;
+    uint8_t hdr_size =
+        read_header(ptr, iter->remaining, &tlv->type, &tlv->length);
+    if (hdr_size == 0) {
+        g_tlv_stats.decoding_errors++;
+        return XY_TLV_BUFFER_UNDERFLOW;
+    }
 
     /* Validate length */
-    if (tlv->length > iter->remaining - XY_TLV_HEADER_SIZE) {
+    if (tlv->length > iter->remaining - hdr_size) {
         g_tlv_stats.decoding_errors++;
         return XY_TLV_INVALID_LENGTH;
     }
 
     /* Set value pointer */
-    tlv->value = ptr;
+    tlv->value = ptr + hdr_size;
 
     /* Update iterator state */
-    uint16_t tlv_size = XY_TLV_HEADER_SIZE + tlv->length;
+    xy_tlv_size_t tlv_size = hdr_size + tlv->length;
     iter->offset += tlv_size;
     iter->remaining -= tlv_size;
 
@@ -315,7 +450,7 @@ bool xy_tlv_iterator_has_next(const xy_tlv_iterator_t *iter)
     if (!iter) {
         return false;
     }
-    return iter->remaining >= XY_TLV_HEADER_SIZE;
+    return iter->remaining >= XY_TLV_HEADER_MIN_SIZE;
 }
 
 int xy_tlv_iterator_reset(xy_tlv_iterator_t *iter)
@@ -330,7 +465,7 @@ int xy_tlv_iterator_reset(xy_tlv_iterator_t *iter)
     return XY_TLV_OK;
 }
 
-int xy_tlv_decode(const xy_tlv_t *tlv, void *value, uint16_t *value_len)
+int xy_tlv_decode(const xy_tlv_t *tlv, void *value, xy_tlv_size_t *value_len)
 {
     if (!tlv || !value || !value_len) {
         return XY_TLV_INVALID_PARAM;
@@ -472,14 +607,14 @@ int xy_tlv_decode_bool(const xy_tlv_t *tlv, bool *value)
     return XY_TLV_OK;
 }
 
-int xy_tlv_decode_string(const xy_tlv_t *tlv, char *str, uint16_t str_len)
+int xy_tlv_decode_string(const xy_tlv_t *tlv, char *str, xy_tlv_size_t str_len)
 {
     if (!tlv || !str || str_len == 0) {
         return XY_TLV_INVALID_PARAM;
     }
 
     /* Need space for NULL terminator */
-    if (str_len < tlv->length + 1) {
+    if (tlv->length >= str_len) {
         return XY_TLV_BUFFER_OVERFLOW;
     }
 
@@ -490,7 +625,7 @@ int xy_tlv_decode_string(const xy_tlv_t *tlv, char *str, uint16_t str_len)
 }
 
 int xy_tlv_decode_bytes(const xy_tlv_t *tlv, uint8_t *bytes,
-                        uint16_t *bytes_len)
+                        xy_tlv_size_t *bytes_len)
 {
     if (!tlv || !bytes || !bytes_len) {
         return XY_TLV_INVALID_PARAM;
@@ -508,7 +643,7 @@ int xy_tlv_decode_bytes(const xy_tlv_t *tlv, uint8_t *bytes,
 
 /* ==================== Advanced API - Searching ==================== */
 
-int xy_tlv_find(const uint8_t *buffer, uint16_t buffer_len, uint16_t type,
+int xy_tlv_find(const uint8_t *buffer, xy_tlv_size_t buffer_len, uint16_t type,
                 xy_tlv_t *tlv)
 {
     xy_tlv_iterator_t iter;
@@ -532,8 +667,8 @@ int xy_tlv_find(const uint8_t *buffer, uint16_t buffer_len, uint16_t type,
     return XY_TLV_NOT_FOUND;
 }
 
-int xy_tlv_find_all(const uint8_t *buffer, uint16_t buffer_len, uint16_t type,
-                    xy_tlv_t *tlv_array, uint16_t *array_size)
+int xy_tlv_find_all(const uint8_t *buffer, xy_tlv_size_t buffer_len,
+                    uint16_t type, xy_tlv_t *tlv_array, uint16_t *array_size)
 {
     xy_tlv_iterator_t iter;
     xy_tlv_t current;
@@ -562,7 +697,7 @@ int xy_tlv_find_all(const uint8_t *buffer, uint16_t buffer_len, uint16_t type,
     return (int)count;
 }
 
-int xy_tlv_count(const uint8_t *buffer, uint16_t buffer_len)
+int xy_tlv_count(const uint8_t *buffer, xy_tlv_size_t buffer_len)
 {
     xy_tlv_iterator_t iter;
     xy_tlv_t tlv;
@@ -581,6 +716,311 @@ int xy_tlv_count(const uint8_t *buffer, uint16_t buffer_len)
     return count;
 }
 
+/* ==================== Advanced API - Index ==================== */
+
+bool xy_tlv_is_builtin_container(uint16_t type)
+{
+    return type == XY_TLV_TYPE_CONTAINER || type == XY_TLV_TYPE_ARRAY
+           || type == XY_TLV_TYPE_LIST;
+}
+
+int xy_tlv_index_init(xy_tlv_index_t *index, xy_tlv_index_entry_t *entries,
+                      uint16_t capacity, xy_tlv_is_container_t is_container)
+{
+    if (!index || !entries || capacity == 0) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    index->buffer       = NULL;
+    index->buffer_len   = 0;
+    index->entries      = entries;
+    index->capacity     = capacity;
+    index->count        = 0;
+    index->is_container = is_container;
+
+    return XY_TLV_OK;
+}
+
+/**
+ * @brief Order entries by (parent, type, value offset)
+ */
+static inline int index_entry_cmp(const xy_tlv_index_entry_t *a,
+                                  xy_tlv_size_t parent, uint16_t type,
+                                  xy_tlv_size_t value_off)
+{
+    if (a->parent != parent) {
+        return a->parent < parent ? -1 : 1;
+    }
+    if (a->type != type) {
+        return a->type < type ? -1 : 1;
+    }
+    if (a->value_off != value_off) {
+        return a->value_off < value_off ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sift entries[root] down the max-heap entries[0..n)
+ */
+static void index_sift_down(xy_tlv_index_entry_t *entries, uint16_t root,
+                            uint16_t n)
+{
+    xy_tlv_index_entry_t key = entries[root];
+    uint32_t child;
+
+    while ((child = 2u * root + 1) < n) {
+        if (child + 1 < n
+            && index_entry_cmp(&entries[child], entries[child + 1].parent,
+                               entries[child + 1].type,
+                               entries[child + 1].value_off)
+                   < 0) {
+            child++;
+        }
+        if (index_entry_cmp(&entries[child], key.parent, key.type,
+                            key.value_off)
+            <= 0) {
+            break;
+        }
+        entries[root] = entries[child];
+        root          = (uint16_t)child;
+    }
+    entries[root] = key;
+}
+
+/**
+ * @brief Heap sort: O(n log n) in place, whatever the nesting
+ */
+static void index_sort(xy_tlv_index_entry_t *entries, uint16_t n)
+{
+    xy_tlv_index_entry_t top;
+    uint16_t i;
+
+    for (i = n / 2; i > 0; i--) {
+        index_sift_down(entries, (uint16_t)(i - 1), n);
+    }
+    for (i = n; i > 1; i--) {
+        top            = entries[0];
+        entries[0]     = entries[i - 1];
+        entries[i - 1] = top;
+        index_sift_down(entries, 0, (uint16_t)(i - 1));
+    }
+}
+
+/**
+ * @brief First entry not ordered before (parent, type, value_off)
+ */
+static uint16_t index_lower_bound(const xy_tlv_index_t *index,
+                                  xy_tlv_size_t parent, uint16_t type,
+                                  xy_tlv_size_t value_off)
+{
+    uint16_t lo = 0;
+    uint16_t hi = index->count;
+
+    while (lo < hi) {
+        uint16_t mid = lo + (hi - lo) / 2;
+        if (index_entry_cmp(&index->entries[mid], parent, type, value_off)
+            < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int xy_tlv_index_build(xy_tlv_index_t *index, const uint8_t *buffer,
+                       xy_tlv_size_t buffer_len)
+{
+    xy_tlv_iterator_t stack[XY_TLV_MAX_NESTING_LEVEL + 1];
+    uint8_t depth = 0;
+    xy_tlv_t tlv;
+    int ret;
+
+    if (!index || !index->entries) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    index->count = 0;
+    ret          = xy_tlv_iterator_init(&stack[0], buffer, buffer_len);
+    if (ret != XY_TLV_OK) {
+        return ret;
+    }
+    index->buffer     = buffer;
+    index->buffer_len = buffer_len;
+
+    /* Depth-first walk; each level's iterator stays on the stack */
+    for (;;) {
+        ret = xy_tlv_iterator_next(&stack[depth], &tlv);
+        if (ret == XY_TLV_NOT_FOUND) {
+            if (depth == 0) {
+                break;
+            }
+            depth--;
+            continue;
+        }
+        if (ret != XY_TLV_OK) {
+            index->count = 0;
+            return ret;
+        }
+
+        if (index->count >= index->capacity) {
+            index->count = 0;
+            return XY_TLV_BUFFER_OVERFLOW;
+        }
+
+        xy_tlv_index_entry_t *e = &index->entries[index->count++];
+        e->parent    = (xy_tlv_size_t)(stack[depth].buffer - buffer);
+        e->value_off = (xy_tlv_size_t)(tlv.value - buffer);
+        e->length    = tlv.length;
+        e->type      = tlv.type;
+
+        if (index->is_container && index->is_container(tlv.type)
+            && tlv.length > 0) {
+            ret = xy_tlv_container_enter(&stack[depth], &tlv,
+                                         &stack[depth + 1]);
+            if (ret != XY_TLV_OK) {
+                index->count = 0;
+                return ret;
+            }
+            depth++;
+        }
+    }
+
+    /* The walk interleaves parents and leaves types in wire order */
+    index_sort(index->entries, index->count);
+
+    return XY_TLV_OK;
+}
+
+/**
+ * @brief Resolve the parent key of a TLV returned by this index
+ */
+static int index_parent_key(const xy_tlv_index_t *index,
+                            const xy_tlv_t *parent, xy_tlv_size_t *key)
+{
+    if (!parent) {
+        *key = 0;
+        return XY_TLV_OK;
+    }
+    if (parent->value <= index->buffer
+        || parent->value > index->buffer + index->buffer_len) {
+        return XY_TLV_INVALID_PARAM;
+    }
+    *key = (xy_tlv_size_t)(parent->value - index->buffer);
+    return XY_TLV_OK;
+}
+
+static inline void index_entry_to_tlv(const xy_tlv_index_t *index,
+                                      const xy_tlv_index_entry_t *e,
+                                      xy_tlv_t *tlv)
+{
+    tlv->type   = e->type;
+    tlv->length = e->length;
+    tlv->value  = index->buffer + e->value_off;
+}
+
+int xy_tlv_index_find(const xy_tlv_index_t *index, const xy_tlv_t *parent,
+                      uint16_t type, xy_tlv_t *tlv)
+{
+    xy_tlv_size_t key;
+    uint16_t pos;
+
+    if (!index || !index->buffer
+        || index_parent_key(index, parent, &key) != XY_TLV_OK) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    pos = index_lower_bound(index, key, type, 0);
+    if (pos >= index->count || index->entries[pos].parent != key
+        || index->entries[pos].type != type) {
+        return XY_TLV_NOT_FOUND;
+    }
+
+    if (tlv) {
+        index_entry_to_tlv(index, &index->entries[pos], tlv);
+    }
+    return XY_TLV_OK;
+}
+
+int xy_tlv_index_find_all(const xy_tlv_index_t *index, const xy_tlv_t *parent,
+                          uint16_t type, xy_tlv_t *tlv_array,
+                          uint16_t *array_size)
+{
+    xy_tlv_size_t key;
+    uint16_t max_count = (tlv_array && array_size) ? *array_size : 0;
+    uint16_t count     = 0;
+    uint16_t pos;
+
+    if (!index || !index->buffer
+        || index_parent_key(index, parent, &key) != XY_TLV_OK) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    pos = index_lower_bound(index, key, type, 0);
+    while (pos < index->count && index->entries[pos].parent == key
+           && index->entries[pos].type == type) {
+        if (count < max_count) {
+            index_entry_to_tlv(index, &index->entries[pos], &tlv_array[count]);
+        }
+        count++;
+        pos++;
+    }
+
+    if (array_size) {
+        *array_size = count;
+    }
+
+    return (int)count;
+}
+
+int xy_tlv_index_find_path(const xy_tlv_index_t *index, const uint16_t *path,
+                           uint8_t depth, xy_tlv_t *tlv)
+{
+    xy_tlv_t current;
+    uint8_t i;
+    int ret;
+
+    if (!index || !path || depth == 0) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    ret = xy_tlv_index_find(index, NULL, path[0], &current);
+    for (i = 1; i < depth && ret == XY_TLV_OK; i++) {
+        ret = xy_tlv_index_find(index, &current, path[i], &current);
+    }
+
+    if (ret == XY_TLV_OK && tlv) {
+        *tlv = current;
+    }
+    return ret;
+}
+
+int xy_tlv_index_count(const xy_tlv_index_t *index, const xy_tlv_t *parent)
+{
+    xy_tlv_size_t key;
+
+    if (!index || !index->buffer
+        || index_parent_key(index, parent, &key) != XY_TLV_OK) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    /* Children of one parent are contiguous */
+    uint16_t first = index_lower_bound(index, key, 0, 0);
+    uint16_t lo    = first;
+    uint16_t hi    = index->count;
+
+    while (lo < hi) {
+        uint16_t mid = lo + (hi - lo) / 2;
+        if (index->entries[mid].parent <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (int)(lo - first);
+}
+
 /* ==================== Advanced API - Containers ==================== */
 
 int xy_tlv_container_begin(xy_tlv_buffer_t *tlv_buf, uint16_t type)
@@ -594,16 +1034,18 @@ int xy_tlv_container_begin(xy_tlv_buffer_t *tlv_buf, uint16_t type)
     }
 
     /* Reserve space for container header (will update length at end) */
-    if (tlv_buf->offset + XY_TLV_HEADER_SIZE > tlv_buf->capacity) {
+    if (tlv_buf->capacity - tlv_buf->offset < XY_TLV_HEADER_SIZE) {
         return XY_TLV_BUFFER_OVERFLOW;
     }
 
     /* Write type, length will be updated at container_end */
     write_uint16(&tlv_buf->buffer[tlv_buf->offset], type);
     tlv_buf->offset += 2;
-    write_uint16(&tlv_buf->buffer[tlv_buf->offset], 0); /* Placeholder */
-    tlv_buf->offset += 2;
+    write_length(&tlv_buf->buffer[tlv_buf->offset], 0, /* Placeholder */
+                 XY_TLV_LENGTH_FIELD_SIZE);
+    tlv_buf->offset += XY_TLV_LENGTH_FIELD_SIZE;
 
+    tlv_buf->container_start[tlv_buf->nesting] = tlv_buf->offset;
     tlv_buf->nesting++;
 
     return XY_TLV_OK;
@@ -621,9 +1063,10 @@ int xy_tlv_container_end(xy_tlv_buffer_t *tlv_buf)
 
     tlv_buf->nesting--;
 
-    /* Note: In a full implementation, we would need to track the container
-     * start position and update the length field. For simplicity, this
-     * basic version requires manual length management or post-processing. */
+    /* Patch the placeholder written by container_begin */
+    xy_tlv_size_t start = tlv_buf->container_start[tlv_buf->nesting];
+    write_length(&tlv_buf->buffer[start - XY_TLV_LENGTH_FIELD_SIZE],
+                 tlv_buf->offset - start, XY_TLV_LENGTH_FIELD_SIZE);
 
     return XY_TLV_OK;
 }
@@ -651,7 +1094,7 @@ int xy_tlv_container_enter(const xy_tlv_iterator_t *iter, const xy_tlv_t *tlv,
 
 /* ==================== Utility API ==================== */
 
-int xy_tlv_validate(const uint8_t *buffer, uint16_t buffer_len)
+int xy_tlv_validate(const uint8_t *buffer, xy_tlv_size_t buffer_len)
 {
     xy_tlv_iterator_t iter;
     xy_tlv_t tlv;
@@ -675,11 +1118,11 @@ int xy_tlv_validate(const uint8_t *buffer, uint16_t buffer_len)
     return ret;
 }
 
-uint16_t xy_tlv_checksum(const uint8_t *buffer, uint16_t buffer_len)
+uint16_t xy_tlv_checksum(const uint8_t *buffer, xy_tlv_size_t buffer_len)
 {
     /* Simple CRC16 calculation */
     uint16_t crc = 0xFFFF;
-    uint16_t i;
+    xy_tlv_size_t i;
 
     for (i = 0; i < buffer_len; i++) {
         crc ^= buffer[i];
@@ -792,7 +1235,8 @@ void xy_tlv_reset_stats(void)
     memset(&g_tlv_stats, 0, sizeof(xy_tlv_stats_t));
 }
 
-void xy_tlv_print(const uint8_t *buffer, uint16_t buffer_len, uint8_t indent)
+void xy_tlv_print(const uint8_t *buffer, xy_tlv_size_t buffer_len,
+                  uint8_t indent)
 {
     /* This function would require printf or similar output facility.
      * For embedded systems, implementation depends on available logging. */
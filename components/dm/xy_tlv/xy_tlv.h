@@ -14,6 +14,7 @@
  * TLV Format:
  * - Type: 2 bytes (uint16_t) - identifies data type
  * - Length: 2 bytes (uint16_t) - value payload length
+ *   (4 bytes or a 1-5 byte varint, see XY_TLV_LENGTH_MODE)
  * - Value: variable length - actual data payload
  *
  * @author XY Team
@@ -42,6 +43,21 @@ extern "C" {
 #define XY_TLV_ENABLE_VALIDATION 1 /**< Enable strict validation checks */
 #endif
 
+#define XY_TLV_LENGTH_16     0 /**< 2-byte length, buffers up to 64 KB */
+#define XY_TLV_LENGTH_32     1 /**< 4-byte length */
+#define XY_TLV_LENGTH_VARINT 2 /**< LEB128 length, 1-5 bytes */
+
+/**
+ * @brief Length field encoding (wire format)
+ *
+ * XY_TLV_LENGTH_16 keeps the original format and API. The other modes lift
+ * the 64 KB limit on values and buffers: sizes become uint32_t throughout.
+ * Both ends of a link must use the same mode.
+ */
+#ifndef XY_TLV_LENGTH_MODE
+#define XY_TLV_LENGTH_MODE XY_TLV_LENGTH_16
+#endif
+
 /* ==================== Return Codes ==================== */
 
 #define XY_TLV_OK               0  /**< Success */
@@ -57,7 +73,31 @@ extern "C" {
 
 /* ==================== TLV Header Constants ==================== */
 
-#define XY_TLV_HEADER_SIZE 4 /**< Size of T+L fields (2+2 bytes) */
+#if XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_16
+typedef uint16_t xy_tlv_size_t; /**< Length / offset type */
+#define XY_TLV_LENGTH_FIELD_SIZE 2
+#define XY_TLV_LENGTH_MAX        0xFFFFu
+#elif XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_32
+typedef uint32_t xy_tlv_size_t;
+#define XY_TLV_LENGTH_FIELD_SIZE 4
+#define XY_TLV_LENGTH_MAX        0xFFFFFFFFu
+#elif XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_VARINT
+typedef uint32_t xy_tlv_size_t;
+#define XY_TLV_LENGTH_FIELD_SIZE 5 /**< Maximum; small lengths use 1 byte */
+#define XY_TLV_LENGTH_MAX        0xFFFFFFFFu
+#else
+#error "Unsupported XY_TLV_LENGTH_MODE"
+#endif
+
+/** Largest T+L header (fixed size except in varint mode) */
+#define XY_TLV_HEADER_SIZE (2 + XY_TLV_LENGTH_FIELD_SIZE)
+
+/** Smallest T+L header */
+#if XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_VARINT
+#define XY_TLV_HEADER_MIN_SIZE 3
+#else
+#define XY_TLV_HEADER_MIN_SIZE XY_TLV_HEADER_SIZE
+#endif
 
 /* ==================== Predefined TLV Types ==================== */
 
@@ -109,8 +149,8 @@ extern "C" {
  * @brief TLV header structure
  */
 typedef struct {
-    uint16_t type;   /**< TLV type identifier */
-    uint16_t length; /**< Value length in bytes */
+    uint16_t type;        /**< TLV type identifier */
+    xy_tlv_size_t length; /**< Value length in bytes */
 } xy_tlv_header_t;
 
 /**
@@ -118,7 +158,7 @@ typedef struct {
  */
 typedef struct {
     uint16_t type;        /**< TLV type identifier */
-    uint16_t length;      /**< Value length in bytes */
+    xy_tlv_size_t length; /**< Value length in bytes */
     const uint8_t *value; /**< Pointer to value data */
 } xy_tlv_t;
 
@@ -126,21 +166,23 @@ typedef struct {
  * @brief TLV buffer context for encoding
  */
 typedef struct {
-    uint8_t *buffer;   /**< Buffer for TLV data */
-    uint16_t capacity; /**< Total buffer capacity */
-    uint16_t offset;   /**< Current write offset */
-    uint8_t nesting;   /**< Current nesting level */
+    uint8_t *buffer;        /**< Buffer for TLV data */
+    xy_tlv_size_t capacity; /**< Total buffer capacity */
+    xy_tlv_size_t offset;   /**< Current write offset */
+    uint8_t nesting;        /**< Current nesting level */
+    /** Value offset of each open container, patched by container_end */
+    xy_tlv_size_t container_start[XY_TLV_MAX_NESTING_LEVEL];
 } xy_tlv_buffer_t;
 
 /**
  * @brief TLV iterator for decoding/traversal
  */
 typedef struct {
-    const uint8_t *buffer; /**< Source buffer */
-    uint16_t buffer_len;   /**< Total buffer length */
-    uint16_t offset;       /**< Current read offset */
-    uint16_t remaining;    /**< Remaining bytes to parse */
-    uint8_t nesting;       /**< Current nesting level */
+    const uint8_t *buffer;    /**< Source buffer */
+    xy_tlv_size_t buffer_len; /**< Total buffer length */
+    xy_tlv_size_t offset;     /**< Current read offset */
+    xy_tlv_size_t remaining;  /**< Remaining bytes to parse */
+    uint8_t nesting;          /**< Current nesting level */
 } xy_tlv_iterator_t;
 
 /**
@@ -166,7 +208,7 @@ typedef struct {
  * @return XY_TLV_OK on success, error code otherwise
  */
 int xy_tlv_buffer_init(xy_tlv_buffer_t *tlv_buf, uint8_t *buffer,
-                       uint16_t capacity);
+                       xy_tlv_size_t capacity);
 
 /**
  * @brief Reset TLV buffer to initial state
@@ -182,7 +224,7 @@ int xy_tlv_buffer_reset(xy_tlv_buffer_t *tlv_buf);
  * @param tlv_buf TLV buffer context
  * @return Number of bytes currently used
  */
-uint16_t xy_tlv_buffer_get_used(const xy_tlv_buffer_t *tlv_buf);
+xy_tlv_size_t xy_tlv_buffer_get_used(const xy_tlv_buffer_t *tlv_buf);
 
 /**
  * @brief Get remaining buffer space
@@ -190,7 +232,41 @@ uint16_t xy_tlv_buffer_get_used(const xy_tlv_buffer_t *tlv_buf);
  * @param tlv_buf TLV buffer context
  * @return Number of bytes available
  */
-uint16_t xy_tlv_buffer_get_free(const xy_tlv_buffer_t *tlv_buf);
+xy_tlv_size_t xy_tlv_buffer_get_free(const xy_tlv_buffer_t *tlv_buf);
+
+/**
+ * @brief Get the encoded header size for a value of @p length bytes
+ *
+ * @param length Value length
+ * @return Header size (XY_TLV_HEADER_SIZE except in varint mode)
+ */
+uint8_t xy_tlv_header_size(xy_tlv_size_t length);
+
+/**
+ * @brief Write a T+L header
+ *
+ * @param buf Destination, at least XY_TLV_HEADER_SIZE bytes
+ * @param type TLV type
+ * @param length Value length
+ * @param header_size 0 for the minimal header, or a larger size to pad the
+ *                    length field (varint mode only; used to reserve
+ *                    container headers before the length is known)
+ * @return Bytes written
+ */
+uint8_t xy_tlv_header_encode(uint8_t *buf, uint16_t type, xy_tlv_size_t length,
+                             uint8_t header_size);
+
+/**
+ * @brief Parse a T+L header
+ *
+ * @param buf Header bytes
+ * @param avail Bytes available at @p buf
+ * @param type Output type
+ * @param length Output value length
+ * @return Header size, 0 if @p avail is too short or the field is malformed
+ */
+uint8_t xy_tlv_header_decode(const uint8_t *buf, xy_tlv_size_t avail,
+                             uint16_t *type, xy_tlv_size_t *length);
 
 /* ==================== Core API - Encoding ==================== */
 
@@ -204,7 +280,7 @@ uint16_t xy_tlv_buffer_get_free(const xy_tlv_buffer_t *tlv_buf);
  * @return XY_TLV_OK on success, error code otherwise
  */
 int xy_tlv_encode(xy_tlv_buffer_t *tlv_buf, uint16_t type, const void *value,
-                  uint16_t length);
+                  xy_tlv_size_t length);
 
 /**
  * @brief Encode uint8_t value
@@ -264,7 +340,7 @@ int xy_tlv_encode_string(xy_tlv_buffer_t *tlv_buf, uint16_t type,
  * @brief Encode binary bytes
  */
 int xy_tlv_encode_bytes(xy_tlv_buffer_t *tlv_buf, uint16_t type,
-                        const uint8_t *bytes, uint16_t length);
+                        const uint8_t *bytes, xy_tlv_size_t length);
 
 /* ==================== Core API - Decoding ==================== */
 
@@ -277,7 +353,7 @@ int xy_tlv_encode_bytes(xy_tlv_buffer_t *tlv_buf, uint16_t type,
  * @return XY_TLV_OK on success, error code otherwise
  */
 int xy_tlv_iterator_init(xy_tlv_iterator_t *iter, const uint8_t *buffer,
-                         uint16_t buffer_len);
+                         xy_tlv_size_t buffer_len);
 
 /**
  * @brief Get next TLV element from iterator
@@ -312,7 +388,7 @@ int xy_tlv_iterator_reset(xy_tlv_iterator_t *iter);
  * @param value_len Buffer size (input), actual size (output)
  * @return XY_TLV_OK on success, error code otherwise
  */
-int xy_tlv_decode(const xy_tlv_t *tlv, void *value, uint16_t *value_len);
+int xy_tlv_decode(const xy_tlv_t *tlv, void *value, xy_tlv_size_t *value_len);
 
 /**
  * @brief Decode uint8_t value
@@ -367,7 +443,7 @@ int xy_tlv_decode_bool(const xy_tlv_t *tlv, bool *value);
  * @param str_len Buffer size (must include space for NULL terminator)
  * @return XY_TLV_OK on success, error code otherwise
  */
-int xy_tlv_decode_string(const xy_tlv_t *tlv, char *str, uint16_t str_len);
+int xy_tlv_decode_string(const xy_tlv_t *tlv, char *str, xy_tlv_size_t str_len);
 
 /**
  * @brief Decode binary bytes
@@ -378,7 +454,7 @@ int xy_tlv_decode_string(const xy_tlv_t *tlv, char *str, uint16_t str_len);
  * @return XY_TLV_OK on success, error code otherwise
  */
 int xy_tlv_decode_bytes(const xy_tlv_t *tlv, uint8_t *bytes,
-                        uint16_t *bytes_len);
+                        xy_tlv_size_t *bytes_len);
 
 /* ==================== Advanced API - Searching ==================== */
 
@@ -391,7 +467,7 @@ int xy_tlv_decode_bytes(const xy_tlv_t *tlv, uint8_t *bytes,
  * @param tlv Output TLV element if found
  * @return XY_TLV_OK if found, XY_TLV_NOT_FOUND otherwise
  */
-int xy_tlv_find(const uint8_t *buffer, uint16_t buffer_len, uint16_t type,
+int xy_tlv_find(const uint8_t *buffer, xy_tlv_size_t buffer_len, uint16_t type,
                 xy_tlv_t *tlv);
 
 /**
@@ -404,8 +480,8 @@ int xy_tlv_find(const uint8_t *buffer, uint16_t buffer_len, uint16_t type,
  * @param array_size Array capacity (input), found count (output)
  * @return Number of TLVs found, or error code if negative
  */
-int xy_tlv_find_all(const uint8_t *buffer, uint16_t buffer_len, uint16_t type,
-                    xy_tlv_t *tlv_array, uint16_t *array_size);
+int xy_tlv_find_all(const uint8_t *buffer, xy_tlv_size_t buffer_len,
+                    uint16_t type, xy_tlv_t *tlv_array, uint16_t *array_size);
 
 /**
  * @brief Count TLVs in buffer
@@ -414,7 +490,126 @@ int xy_tlv_find_all(const uint8_t *buffer, uint16_t buffer_len, uint16_t type,
  * @param buffer_len Buffer length
  * @return Number of TLVs, or error code if negative
  */
-int xy_tlv_count(const uint8_t *buffer, uint16_t buffer_len);
+int xy_tlv_count(const uint8_t *buffer, xy_tlv_size_t buffer_len);
+
+/* ==================== Advanced API - Index ==================== */
+
+/**
+ * @brief Index entry: one TLV located in the indexed buffer
+ */
+typedef struct {
+    xy_tlv_size_t parent;    /**< Value offset of the parent, 0 for root */
+    xy_tlv_size_t value_off; /**< Value offset in the buffer */
+    xy_tlv_size_t length;    /**< Value length */
+    uint16_t type;           /**< TLV type */
+} xy_tlv_index_entry_t;
+
+/**
+ * @brief Container predicate used when indexing nested TLVs
+ *
+ * @param type TLV type
+ * @return true if the value of @p type is itself a TLV sequence
+ */
+typedef bool (*xy_tlv_is_container_t)(uint16_t type);
+
+/**
+ * @brief Type -> offset index over an encoded buffer
+ *
+ * Built once with a single pass over the buffer (and into nested
+ * containers) and an in-place O(n log n) sort by (parent, type, offset), so
+ * lookups are a binary search and all TLVs of one type under one parent
+ * are adjacent.
+ * The entry table is supplied by the caller; the buffer must stay unchanged
+ * while the index is in use.
+ */
+typedef struct {
+    const uint8_t *buffer;               /**< Indexed buffer */
+    xy_tlv_size_t buffer_len;            /**< Indexed length */
+    xy_tlv_index_entry_t *entries;       /**< Entry table */
+    uint16_t capacity;                   /**< Entry table size */
+    uint16_t count;                      /**< Entries in use */
+    xy_tlv_is_container_t is_container;  /**< NULL: top level only */
+} xy_tlv_index_t;
+
+/**
+ * @brief Default container predicate: CONTAINER, ARRAY and LIST types
+ */
+bool xy_tlv_is_builtin_container(uint16_t type);
+
+/**
+ * @brief Initialize an index
+ *
+ * @param index Index context
+ * @param entries Entry table
+ * @param capacity Number of entries in the table
+ * @param is_container Types to descend into, NULL to index the top level
+ *                     only (xy_tlv_is_builtin_container for the built-in
+ *                     container types)
+ * @return XY_TLV_OK on success, error code otherwise
+ */
+int xy_tlv_index_init(xy_tlv_index_t *index, xy_tlv_index_entry_t *entries,
+                      uint16_t capacity, xy_tlv_is_container_t is_container);
+
+/**
+ * @brief Parse @p buffer once and build the index
+ *
+ * @param index Index context
+ * @param buffer Encoded TLV buffer
+ * @param buffer_len Buffer length
+ * @return XY_TLV_OK on success, XY_TLV_BUFFER_OVERFLOW if the entry table
+ *         is too small, or a parse error
+ */
+int xy_tlv_index_build(xy_tlv_index_t *index, const uint8_t *buffer,
+                       xy_tlv_size_t buffer_len);
+
+/**
+ * @brief Find the first TLV of @p type directly under @p parent
+ *
+ * @param index Built index
+ * @param parent Container returned by this index, or NULL for the top level
+ * @param type TLV type
+ * @param tlv Output TLV element (may be NULL)
+ * @return XY_TLV_OK if found, XY_TLV_NOT_FOUND otherwise
+ */
+int xy_tlv_index_find(const xy_tlv_index_t *index, const xy_tlv_t *parent,
+                      uint16_t type, xy_tlv_t *tlv);
+
+/**
+ * @brief Find all TLVs of @p type directly under @p parent, in buffer order
+ *
+ * @param index Built index
+ * @param parent Container returned by this index, or NULL for the top level
+ * @param type TLV type
+ * @param tlv_array Output array (may be NULL to only count)
+ * @param array_size Array capacity (input), found count (output)
+ * @return Number of TLVs found, or error code if negative
+ */
+int xy_tlv_index_find_all(const xy_tlv_index_t *index, const xy_tlv_t *parent,
+                          uint16_t type, xy_tlv_t *tlv_array,
+                          uint16_t *array_size);
+
+/**
+ * @brief Find a nested TLV by its type path, e.g. {NETWORK, WIFI, SSID}
+ *
+ * Each step takes the first match, like xy_tlv_index_find().
+ *
+ * @param index Built index (with a container predicate)
+ * @param path Type of each level, outermost first
+ * @param depth Number of elements in @p path
+ * @param tlv Output TLV element (may be NULL)
+ * @return XY_TLV_OK if found, XY_TLV_NOT_FOUND otherwise
+ */
+int xy_tlv_index_find_path(const xy_tlv_index_t *index, const uint16_t *path,
+                           uint8_t depth, xy_tlv_t *tlv);
+
+/**
+ * @brief Count TLVs directly under @p parent
+ *
+ * @param index Built index
+ * @param parent Container returned by this index, or NULL for the top level
+ * @return Number of TLVs, or error code if negative
+ */
+int xy_tlv_index_count(const xy_tlv_index_t *index, const xy_tlv_t *parent);
 
 /* ==================== Advanced API - Containers ==================== */
 
@@ -430,6 +625,9 @@ int xy_tlv_container_begin(xy_tlv_buffer_t *tlv_buf, uint16_t type);
 /**
  * @brief End encoding a container
  *
+ * Patches the container length with the size of everything encoded since
+ * the matching xy_tlv_container_begin().
+ *
  * @param tlv_buf TLV buffer context
  * @return XY_TLV_OK on success, error code otherwise
  */
@@ -455,7 +653,7 @@ int xy_tlv_container_enter(const xy_tlv_iterator_t *iter, const xy_tlv_t *tlv,
  * @param buffer_len Buffer length
  * @return XY_TLV_OK if valid, error code otherwise
  */
-int xy_tlv_validate(const uint8_t *buffer, uint16_t buffer_len);
+int xy_tlv_validate(const uint8_t *buffer, xy_tlv_size_t buffer_len);
 
 /**
  * @brief Calculate checksum for TLV buffer
@@ -464,7 +662,7 @@ int xy_tlv_validate(const uint8_t *buffer, uint16_t buffer_len);
  * @param buffer_len Buffer length
  * @return Checksum value (CRC16)
  */
-uint16_t xy_tlv_checksum(const uint8_t *buffer, uint16_t buffer_len);
+uint16_t xy_tlv_checksum(const uint8_t *buffer, xy_tlv_size_t buffer_len);
 
 /**
  * @brief Get TLV type name for debugging
@@ -502,7 +700,8 @@ void xy_tlv_reset_stats(void);
  * @param buffer_len Buffer length
  * @param indent Indentation level
  */
-void xy_tlv_print(const uint8_t *buffer, uint16_t buffer_len, uint8_t indent);
+void xy_tlv_print(const uint8_t *buffer, xy_tlv_size_t buffer_len,
+                  uint8_t indent);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,307 @@
+/**
+ * @file xy_tlv_schema.c
+ * @brief Schema-driven struct <-> TLV codec
+ */
+
+#include "xy_tlv_schema.h"
+#include <string.h>
+
+/* ==================== Internal Helper Functions ==================== */
+
+static inline void put_be16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = (uint8_t)(value >> 8);
+    buf[1] = (uint8_t)value;
+}
+
+static inline void put_be32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = (uint8_t)(value >> 24);
+    buf[1] = (uint8_t)(value >> 16);
+    buf[2] = (uint8_t)(value >> 8);
+    buf[3] = (uint8_t)value;
+}
+
+static inline uint16_t get_be16(const uint8_t *buf)
+{
+    return (uint16_t)((buf[0] << 8) | buf[1]);
+}
+
+static inline uint32_t get_be32(const uint8_t *buf)
+{
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16)
+           | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+/**
+ * @brief Write a minimal header; inlined for the fixed-width modes
+ */
+static inline uint8_t put_header(uint8_t *buf, uint16_t type,
+                                 xy_tlv_size_t length)
+{
+#if XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_16
+    put_be16(buf, type);
+    put_be16(buf + 2, length);
+    return 4;
+#elif XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_32
+    put_be16(buf, type);
+    put_be32(buf + 2, length);
+    return 6;
+#else
+    if (length < 0x80) {
+        put_be16(buf, type);
+        buf[2] = (uint8_t)length;
+        return 3;
+    }
+    return xy_tlv_header_encode(buf, type, length, 0);
+#endif
+}
+
+/**
+ * @brief Parse a header; inlined for the fixed-width modes
+ */
+static inline uint8_t get_header(const uint8_t *buf, xy_tlv_size_t avail,
+                                 uint16_t *type, xy_tlv_size_t *length)
+{
+#if XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_16
+    if (avail < 4) {
+        return 0;
+    }
+    *type = get_be16(buf);
+    *length = get_be16(buf + 2);
+    return 4;
+#elif XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_32
+    if (avail < 6) {
+        return 0;
+    }
+    *type = get_be16(buf);
+    *length = get_be32(buf + 2);
+    return 6;
+#else
+    if (avail >= 3 && buf[2] < 0x80) {
+        *type = get_be16(buf);
+        *length = buf[2];
+        return 3;
+    }
+    return xy_tlv_header_decode(buf, avail, type, length);
+#endif
+}
+
+/**
+ * @brief Wire length of one field
+ */
+static inline xy_tlv_size_t field_length(const xy_tlv_field_t *f,
+                                         const uint8_t *src)
+{
+    const uint8_t *nul;
+
+    if (f->kind == XY_TLV_FIELD_STRING) {
+        /* At most N-1 chars, as decode keeps one byte for the NUL */
+        nul = (const uint8_t *)memchr(src, '\0', f->size - 1);
+        return nul ? (xy_tlv_size_t)(nul - src) : f->size - 1;
+    }
+    /* Array size, or the kind width (checked at compile time) */
+    return f->size;
+}
+
+/**
+ * @brief Write one field's value; @p len is from field_length()
+ */
+static inline void put_value(uint8_t *dst, const xy_tlv_field_t *f,
+                             const uint8_t *src, xy_tlv_size_t len)
+{
+    uint64_t v;
+
+    switch (f->kind) {
+    case XY_TLV_FIELD_U8:
+    case XY_TLV_FIELD_I8:
+        *dst = *src;
+        break;
+    case XY_TLV_FIELD_BOOL:
+        *dst = *(const bool *)src ? 1 : 0;
+        break;
+    case XY_TLV_FIELD_U16:
+    case XY_TLV_FIELD_I16: {
+        uint16_t u;
+        memcpy(&u, src, 2);
+        put_be16(dst, u);
+        break;
+    }
+    case XY_TLV_FIELD_U32:
+    case XY_TLV_FIELD_I32:
+    case XY_TLV_FIELD_FLOAT: {
+        uint32_t u;
+        memcpy(&u, src, 4);
+        put_be32(dst, u);
+        break;
+    }
+    case XY_TLV_FIELD_U64:
+    case XY_TLV_FIELD_I64:
+    case XY_TLV_FIELD_DOUBLE:
+        memcpy(&v, src, 8);
+        put_be32(dst, (uint32_t)(v >> 32));
+        put_be32(dst + 4, (uint32_t)v);
+        break;
+    default: /* STRING, BYTES */
+        memcpy(dst, src, len);
+        break;
+    }
+}
+
+/**
+ * @brief Store one element into its field
+ */
+static inline int get_value(uint8_t *dst, const xy_tlv_field_t *f,
+                            const uint8_t *src, xy_tlv_size_t len)
+{
+    switch (f->kind) {
+    case XY_TLV_FIELD_STRING:
+        /* Need space for NULL terminator */
+        if (len >= f->size) {
+            return XY_TLV_BUFFER_OVERFLOW;
+        }
+        memcpy(dst, src, len);
+        dst[len] = '\0';
+        return XY_TLV_OK;
+    case XY_TLV_FIELD_BOOL:
+        if (len != 1) {
+            return XY_TLV_INVALID_LENGTH;
+        }
+        *(bool *)dst = (*src != 0);
+        return XY_TLV_OK;
+    case XY_TLV_FIELD_U8:
+    case XY_TLV_FIELD_I8:
+    case XY_TLV_FIELD_BYTES:
+        if (len != f->size) {
+            return XY_TLV_INVALID_LENGTH;
+        }
+        memcpy(dst, src, len);
+        return XY_TLV_OK;
+    default:
+        break;
+    }
+
+    if (len != f->size) {
+        return XY_TLV_INVALID_LENGTH;
+    }
+    if (f->size == 2) {
+        uint16_t u = get_be16(src);
+        memcpy(dst, &u, 2);
+    } else if (f->size == 4) {
+        uint32_t u = get_be32(src);
+        memcpy(dst, &u, 4);
+    } else {
+        uint64_t u = ((uint64_t)get_be32(src) << 32) | get_be32(src + 4);
+        memcpy(dst, &u, 8);
+    }
+    return XY_TLV_OK;
+}
+
+/* ==================== Encoding ==================== */
+
+int xy_tlv_schema_encode(xy_tlv_buffer_t *tlv_buf,
+                         const xy_tlv_schema_t *schema, const void *record)
+{
+    const uint8_t *rec = (const uint8_t *)record;
+    const xy_tlv_field_t *f;
+    xy_tlv_size_t start;
+    xy_tlv_size_t len;
+    uint8_t *p;
+    uint8_t hdr;
+    uint8_t i;
+
+    if (!tlv_buf || !tlv_buf->buffer || !schema || !record) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    start = tlv_buf->offset;
+    p = tlv_buf->buffer + start;
+
+    if (tlv_buf->capacity - start >= schema->max_encoded) {
+        /* Fast path: the worst case fits, no per-field checks */
+        for (i = 0, f = schema->fields; i < schema->field_count; i++, f++) {
+            len = field_length(f, rec + f->offset);
+            p += put_header(p, f->type, len);
+            put_value(p, f, rec + f->offset, len);
+            p += len;
+        }
+    } else {
+        for (i = 0, f = schema->fields; i < schema->field_count; i++, f++) {
+            xy_tlv_size_t room = (xy_tlv_size_t)(tlv_buf->capacity
+                                                 - (p - tlv_buf->buffer));
+            len = field_length(f, rec + f->offset);
+            hdr = xy_tlv_header_size(len);
+            if (room < hdr || len > room - hdr) {
+                /* Leave the buffer as it was */
+                tlv_buf->offset = start;
+                return XY_TLV_BUFFER_OVERFLOW;
+            }
+            p += put_header(p, f->type, len);
+            put_value(p, f, rec + f->offset, len);
+            p += len;
+        }
+    }
+
+    tlv_buf->offset = (xy_tlv_size_t)(p - tlv_buf->buffer);
+    return XY_TLV_OK;
+}
+
+/* ==================== Decoding ==================== */
+
+int xy_tlv_schema_decode(const uint8_t *buffer, xy_tlv_size_t buffer_len,
+                         const xy_tlv_schema_t *schema, void *record,
+                         uint32_t *present)
+{
+    uint8_t *rec = (uint8_t *)record;
+    const xy_tlv_field_t *f;
+    xy_tlv_size_t offset = 0;
+    xy_tlv_size_t length;
+    uint32_t mask = 0;
+    uint16_t type;
+    uint8_t hdr;
+    uint8_t next = 0;
+    uint8_t i;
+    int ret;
+
+    if (!buffer || !schema || !record) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    while (offset < buffer_len) {
+        hdr = get_header(buffer + offset, buffer_len - offset, &type,
+                         &length);
+        if (hdr == 0 || length > buffer_len - offset - hdr) {
+            return XY_TLV_BUFFER_UNDERFLOW;
+        }
+        offset += hdr;
+
+        /* Records are usually in table order: try the next field first */
+        f = NULL;
+        if (next < schema->field_count && schema->fields[next].type == type) {
+            i = next;
+            f = &schema->fields[i];
+        } else {
+            for (i = 0; i < schema->field_count; i++) {
+                if (schema->fields[i].type == type) {
+                    f = &schema->fields[i];
+                    break;
+                }
+            }
+        }
+
+        if (f) {
+            ret = get_value(rec + f->offset, f, buffer + offset, length);
+            if (ret != XY_TLV_OK) {
+                return ret;
+            }
+            mask |= 1ul << i;
+            next = i + 1;
+        }
+        offset += length;
+    }
+
+    if (present) {
+        *present = mask;
+    }
+    return XY_TLV_OK;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file xy_tlv_schema.h
+ * @brief Schema-driven struct <-> TLV codec
+ *
+ * A record is described once by an X-macro table listing, for each field,
+ * the struct member, its TLV type and its value kind:
+ *
+ * @code
+ * #define SENSOR_SCHEMA(X)                                \
+ *     X(sensor_t, id,       SENSOR_ID,       U32)        \
+ *     X(sensor_t, temp,     SENSOR_TEMP,     I16)        \
+ *     X(sensor_t, name,     SENSOR_NAME,     STRING)     \
+ *     X(sensor_t, mac,      SENSOR_MAC,      BYTES)
+ *
+ * XY_TLV_SCHEMA_DEFINE(sensor_schema, sensor_t, SENSOR_SCHEMA);
+ * @endcode
+ *
+ * The table expands to a field descriptor array plus compile-time
+ * constants: member sizes are checked against the kind, and the worst-case
+ * encoded size is available as XY_TLV_SCHEMA_MAX_SIZE(SENSOR_SCHEMA). The
+ * codec then moves a whole record in one pass: a single space check on
+ * encode, a single walk on decode, no per-field type dispatch through the
+ * public API and no statistics updates.
+ *
+ * The wire format matches the per-field xy_tlv_encode_* / decode_* calls,
+ * so schema and hand-written code interoperate.
+ *
+ * @author XY Team
+ * @date 2025
+ */
+
+#ifndef XY_TLV_SCHEMA_H
+#define XY_TLV_SCHEMA_H
+
+#include "xy_tlv.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Field Kinds ==================== */
+
+/**
+ * @brief Value encoding of a schema field
+ *
+ * Integers and floats are big-endian, as in xy_tlv_encode_uint32() etc.
+ */
+typedef enum {
+    XY_TLV_FIELD_U8 = 0,
+    XY_TLV_FIELD_U16,
+    XY_TLV_FIELD_U32,
+    XY_TLV_FIELD_U64,
+    XY_TLV_FIELD_I8,
+    XY_TLV_FIELD_I16,
+    XY_TLV_FIELD_I32,
+    XY_TLV_FIELD_I64,
+    XY_TLV_FIELD_BOOL,
+    XY_TLV_FIELD_FLOAT,  /**< IEEE-754 single, bit pattern as U32 */
+    XY_TLV_FIELD_DOUBLE, /**< IEEE-754 double, bit pattern as U64 */
+    XY_TLV_FIELD_STRING, /**< char[N]; sent without NUL, N-1 chars max
+                              (an array without NUL is cut there) */
+    XY_TLV_FIELD_BYTES,  /**< uint8_t[N]; exactly N bytes */
+} xy_tlv_field_kind_t;
+
+/* Wire width of each kind, 0 for arrays (width = member size) */
+#define XY_TLV_FIELD_WIDTH_U8     1
+#define XY_TLV_FIELD_WIDTH_U16    2
+#define XY_TLV_FIELD_WIDTH_U32    4
+#define XY_TLV_FIELD_WIDTH_U64    8
+#define XY_TLV_FIELD_WIDTH_I8     1
+#define XY_TLV_FIELD_WIDTH_I16    2
+#define XY_TLV_FIELD_WIDTH_I32    4
+#define XY_TLV_FIELD_WIDTH_I64    8
+#define XY_TLV_FIELD_WIDTH_BOOL   1
+#define XY_TLV_FIELD_WIDTH_FLOAT  4
+#define XY_TLV_FIELD_WIDTH_DOUBLE 8
+#define XY_TLV_FIELD_WIDTH_STRING 0
+#define XY_TLV_FIELD_WIDTH_BYTES  0
+
+/** Maximum number of fields in one schema (decode presence mask width) */
+#define XY_TLV_SCHEMA_MAX_FIELDS 32
+
+/* ==================== Data Structures ==================== */
+
+/**
+ * @brief Field descriptor
+ */
+typedef struct {
+    uint16_t type;        /**< TLV type */
+    uint8_t kind;         /**< xy_tlv_field_kind_t */
+    xy_tlv_size_t offset; /**< offsetof() the member */
+    xy_tlv_size_t size;   /**< sizeof() the member */
+} xy_tlv_field_t;
+
+/**
+ * @brief Record schema
+ */
+typedef struct {
+    const char *name;              /**< Schema name, for diagnostics */
+    const xy_tlv_field_t *fields;  /**< Fields in encoding order */
+    uint8_t field_count;           /**< Number of fields */
+    xy_tlv_size_t max_encoded;     /**< Worst-case encoded size */
+} xy_tlv_schema_t;
+
+/* ==================== Schema Definition Macros ==================== */
+
+/**
+ * @brief Header size for a value of compile-time length @p len
+ */
+#if XY_TLV_LENGTH_MODE == XY_TLV_LENGTH_VARINT
+#define XY_TLV_HEADER_SIZE_OF(len)                                     \
+    (2u + ((len) < 0x80u ? 1u : (len) < 0x4000u ? 2u                   \
+                             : (len) < 0x200000u ? 3u                  \
+                             : (len) < 0x10000000u ? 4u : 5u))
+#else
+#define XY_TLV_HEADER_SIZE_OF(len) ((unsigned)XY_TLV_HEADER_SIZE)
+#endif
+
+#define XY_TLV_MEMBER_SIZE(st, m) sizeof(((st *)0)->m)
+
+/* Per-field expansions used by the table macros below */
+#define XY_TLV_SCHEMA_FIELD(st, m, type, kind)                               \
+    { (type), XY_TLV_FIELD_##kind, (xy_tlv_size_t)offsetof(st, m),           \
+      (xy_tlv_size_t)XY_TLV_MEMBER_SIZE(st, m) },
+#define XY_TLV_SCHEMA_FIELD_MAX(st, m, type, kind)                           \
+    +XY_TLV_HEADER_SIZE_OF(XY_TLV_MEMBER_SIZE(st, m))                        \
+        + XY_TLV_MEMBER_SIZE(st, m)
+#define XY_TLV_SCHEMA_FIELD_BAD(st, m, type, kind)                           \
+    +(XY_TLV_FIELD_WIDTH_##kind != 0                                         \
+      && XY_TLV_MEMBER_SIZE(st, m) != XY_TLV_FIELD_WIDTH_##kind)
+#define XY_TLV_SCHEMA_FIELD_ONE(st, m, type, kind) +1
+
+/**
+ * @brief Worst-case encoded size of a schema table (constant expression)
+ */
+#define XY_TLV_SCHEMA_MAX_SIZE(TABLE) (0u TABLE(XY_TLV_SCHEMA_FIELD_MAX))
+
+/**
+ * @brief Number of fields in a schema table (constant expression)
+ */
+#define XY_TLV_SCHEMA_FIELD_COUNT(TABLE) (0 TABLE(XY_TLV_SCHEMA_FIELD_ONE))
+
+/**
+ * @brief Define a schema object from an X-macro table
+ *
+ * Fails to compile if a scalar member's size does not match its kind or
+ * the table has more than XY_TLV_SCHEMA_MAX_FIELDS fields.
+ *
+ * @param name Schema variable name
+ * @param st Record struct type
+ * @param TABLE X-macro taking X(st, member, tlv_type, KIND)
+ */
+#define XY_TLV_SCHEMA_DEFINE(name, st, TABLE)                                \
+    typedef char name##_member_size_check                                    \
+        [(0 TABLE(XY_TLV_SCHEMA_FIELD_BAD)) ? -1 : 1];                       \
+    typedef char name##_field_count_check                                    \
+        [XY_TLV_SCHEMA_FIELD_COUNT(TABLE) <= XY_TLV_SCHEMA_MAX_FIELDS ? 1    \
+                                                                      : -1]; \
+    static const xy_tlv_field_t name##_fields[] = { TABLE(                   \
+        XY_TLV_SCHEMA_FIELD) };                                              \
+    const xy_tlv_schema_t name = {                                           \
+        #name, name##_fields, (uint8_t)XY_TLV_SCHEMA_FIELD_COUNT(TABLE),     \
+        (xy_tlv_size_t)XY_TLV_SCHEMA_MAX_SIZE(TABLE)                         \
+    }
+
+/* ==================== API ==================== */
+
+/**
+ * @brief Encode a record
+ *
+ * Fields are written in table order at the buffer's current position
+ * (wrap in xy_tlv_container_begin/end for a nested record). Either the
+ * whole record is written or, on overflow, nothing.
+ *
+ * @param tlv_buf TLV buffer context
+ * @param schema Record schema
+ * @param record Pointer to the struct
+ * @return XY_TLV_OK on success, error code otherwise
+ */
+int xy_tlv_schema_encode(xy_tlv_buffer_t *tlv_buf,
+                         const xy_tlv_schema_t *schema, const void *record);
+
+/**
+ * @brief Decode a record
+ *
+ * Elements are matched to fields by type in one pass; unknown types are
+ * skipped and fields that are absent keep their previous value.
+ *
+ * @param buffer TLV data (one record's elements)
+ * @param buffer_len Length of @p buffer
+ * @param schema Record schema
+ * @param record Pointer to the struct
+ * @param present Optional output, bit i set if field i was decoded
+ * @return XY_TLV_OK on success, error code otherwise
+ */
+int xy_tlv_schema_decode(const uint8_t *buffer, xy_tlv_size_t buffer_len,
+                         const xy_tlv_schema_t *schema, void *record,
+                         uint32_t *present);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XY_TLV_SCHEMA_H */
@@ -0,0 +1,481 @@
+/**
+ * @file xy_tlv_stream.c
+ * @brief Streaming TLV decoding and scatter-gather encoding
+ */
+
+#include "xy_tlv_stream.h"
+#include <string.h>
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/* ==================== Push Parser ==================== */
+
+/**
+ * @brief Deliver an event; non-zero callback returns become sticky errors
+ */
+static int emit(xy_tlv_parser_t *parser, xy_tlv_event_type_t event,
+                const uint8_t *value, xy_tlv_size_t length,
+                xy_tlv_size_t offset)
+{
+    xy_tlv_event_t evt;
+    int ret;
+
+    evt.event = event;
+    evt.depth = parser->depth;
+    evt.tlv.type = parser->type;
+    evt.tlv.length = length;
+    evt.tlv.value = value;
+    evt.total_length = parser->length;
+    evt.offset = offset;
+
+    ret = parser->callback(parser->ctx, &evt);
+    if (ret != 0) {
+        parser->error = ret;
+    }
+    return ret;
+}
+
+/**
+ * @brief Close every container whose last byte has been consumed
+ */
+static int element_done(xy_tlv_parser_t *parser)
+{
+    int ret;
+
+    parser->in_value = 0;
+    while (parser->depth > 0
+           && parser->consumed == parser->end[parser->depth - 1]) {
+        parser->depth--;
+        parser->type = parser->end_type[parser->depth];
+        parser->length = 0;
+        ret = emit(parser, XY_TLV_EVT_LEAVE, NULL, 0, 0);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    /* Offsets are relative to the current top-level element so a
+     * long-running stream never wraps the counter. */
+    if (parser->depth == 0) {
+        parser->consumed = 0;
+    }
+    return XY_TLV_OK;
+}
+
+/**
+ * @brief Act on a freshly parsed header of @p header_size bytes
+ */
+static int header_done(xy_tlv_parser_t *parser, uint8_t header_size)
+{
+    uint32_t room;
+    int ret;
+
+    if (parser->depth > 0) {
+        room = parser->end[parser->depth - 1] - parser->consumed;
+        if (header_size > room || parser->length > room - header_size) {
+            return XY_TLV_INVALID_LENGTH;
+        }
+    }
+    parser->consumed += header_size;
+
+    if (parser->is_container && parser->is_container(parser->type)) {
+        if (parser->depth >= XY_TLV_MAX_NESTING_LEVEL) {
+            return XY_TLV_NESTING_OVERFLOW;
+        }
+        ret = emit(parser, XY_TLV_EVT_ENTER, NULL, parser->length, 0);
+        if (ret != 0) {
+            return ret;
+        }
+        parser->end[parser->depth] = parser->consumed + parser->length;
+        parser->end_type[parser->depth] = parser->type;
+        parser->depth++;
+        return element_done(parser);
+    }
+
+    parser->in_value = 1;
+    parser->value_pos = 0;
+    parser->staging = parser->stage != NULL
+                      && parser->length <= parser->stage_size;
+    return XY_TLV_OK;
+}
+
+int xy_tlv_parser_init(xy_tlv_parser_t *parser, uint8_t *stage,
+                       xy_tlv_size_t stage_size,
+                       xy_tlv_is_container_t is_container,
+                       xy_tlv_event_cb_t callback, void *ctx)
+{
+    if (!parser || !callback) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    parser->stage = stage;
+    parser->stage_size = stage ? stage_size : 0;
+    parser->is_container = is_container;
+    parser->callback = callback;
+    parser->ctx = ctx;
+
+    return xy_tlv_parser_reset(parser);
+}
+
+int xy_tlv_parser_reset(xy_tlv_parser_t *parser)
+{
+    if (!parser) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    parser->header_len = 0;
+    parser->in_value = 0;
+    parser->staging = 0;
+    parser->type = 0;
+    parser->length = 0;
+    parser->value_pos = 0;
+    parser->depth = 0;
+    parser->consumed = 0;
+    parser->error = XY_TLV_OK;
+
+    return XY_TLV_OK;
+}
+
+int xy_tlv_parser_feed(xy_tlv_parser_t *parser, const uint8_t *data,
+                       size_t len)
+{
+    uint8_t header_size;
+    xy_tlv_size_t take;
+    int ret;
+
+    if (!parser || (!data && len > 0)) {
+        return XY_TLV_INVALID_PARAM;
+    }
+    if (parser->error != XY_TLV_OK) {
+        return parser->error;
+    }
+
+    while (len > 0) {
+        if (!parser->in_value) {
+            /* Header: decode in place when it is whole in this fragment,
+             * otherwise accumulate it byte-wise. */
+            if (parser->header_len == 0) {
+                header_size = xy_tlv_header_decode(
+                    data, (xy_tlv_size_t)MIN(len, XY_TLV_HEADER_SIZE),
+                    &parser->type, &parser->length);
+                if (header_size == 0 && len >= XY_TLV_HEADER_SIZE) {
+                    ret = XY_TLV_INVALID_LENGTH;
+                    goto fail;
+                }
+            } else {
+                take = (xy_tlv_size_t)MIN(
+                    len, (size_t)(XY_TLV_HEADER_SIZE - parser->header_len));
+                memcpy(parser->header + parser->header_len, data, take);
+                header_size = xy_tlv_header_decode(
+                    parser->header, parser->header_len + take, &parser->type,
+                    &parser->length);
+                if (header_size == 0
+                    && parser->header_len + take >= XY_TLV_HEADER_SIZE) {
+                    ret = XY_TLV_INVALID_LENGTH;
+                    goto fail;
+                }
+            }
+
+            if (header_size == 0) {
+                /* Incomplete: keep what we have and wait for more */
+                if (parser->header_len == 0) {
+                    memcpy(parser->header, data, len);
+                }
+                parser->header_len += (uint8_t)len;
+                return XY_TLV_OK;
+            }
+
+            data += header_size - parser->header_len;
+            len -= header_size - parser->header_len;
+            parser->header_len = 0;
+
+            ret = header_done(parser, header_size);
+            if (ret != XY_TLV_OK) {
+                goto fail;
+            }
+            if (!parser->in_value || parser->length != 0) {
+                continue;
+            }
+            /* Empty value: report it without waiting for more input */
+        }
+
+        take = (xy_tlv_size_t)MIN(len,
+                                  (size_t)(parser->length - parser->value_pos));
+
+        if (parser->value_pos == 0 && take == parser->length) {
+            /* Whole value in this fragment: zero-copy */
+            ret = emit(parser, XY_TLV_EVT_ELEMENT, data, take, 0);
+        } else if (parser->staging) {
+            memcpy(parser->stage + parser->value_pos, data, take);
+            ret = XY_TLV_OK;
+            if (parser->value_pos + take == parser->length) {
+                ret = emit(parser, XY_TLV_EVT_ELEMENT, parser->stage,
+                           parser->length, 0);
+            }
+        } else {
+            ret = emit(parser, XY_TLV_EVT_CHUNK, data, take,
+                       parser->value_pos);
+        }
+        if (ret != 0) {
+            return ret;
+        }
+
+        parser->value_pos += take;
+        parser->consumed += take;
+        data += take;
+        len -= take;
+
+        if (parser->value_pos == parser->length) {
+            ret = element_done(parser);
+            if (ret != XY_TLV_OK) {
+                return ret;
+            }
+        }
+    }
+
+    return XY_TLV_OK;
+
+fail:
+    parser->error = ret;
+    return ret;
+}
+
+bool xy_tlv_parser_is_idle(const xy_tlv_parser_t *parser)
+{
+    return parser && parser->error == XY_TLV_OK && !parser->in_value
+           && parser->header_len == 0 && parser->depth == 0;
+}
+
+/* ==================== Segment Writer ==================== */
+
+/**
+ * @brief Copy @p len bytes into the chain at the cursor
+ *
+ * The caller has already checked capacity.
+ */
+static void sg_put(xy_tlv_sg_writer_t *writer, const uint8_t *src, size_t len)
+{
+    const xy_tlv_seg_t *seg;
+    size_t n;
+
+    while (len > 0) {
+        seg = &writer->segs[writer->seg];
+        if (writer->pos == seg->len) {
+            writer->seg++;
+            writer->pos = 0;
+            continue;
+        }
+        n = MIN(len, seg->len - writer->pos);
+        memcpy(seg->data + writer->pos, src, n);
+        writer->pos += n;
+        writer->total += (uint32_t)n;
+        src += n;
+        len -= n;
+    }
+}
+
+/**
+ * @brief Overwrite @p len bytes at a saved position
+ */
+static void sg_patch(const xy_tlv_sg_writer_t *writer, uint16_t seg,
+                     size_t pos, const uint8_t *src, size_t len)
+{
+    size_t n;
+
+    while (len > 0) {
+        if (pos == writer->segs[seg].len) {
+            seg++;
+            pos = 0;
+            continue;
+        }
+        n = MIN(len, writer->segs[seg].len - pos);
+        memcpy(writer->segs[seg].data + pos, src, n);
+        pos += n;
+        src += n;
+        len -= n;
+    }
+}
+
+static bool sg_has_room(const xy_tlv_sg_writer_t *writer, uint32_t header,
+                        xy_tlv_size_t length)
+{
+    uint32_t room = writer->capacity - writer->total;
+
+    return header <= room && length <= room - header;
+}
+
+int xy_tlv_sg_init(xy_tlv_sg_writer_t *writer, const xy_tlv_seg_t *segs,
+                   uint16_t seg_count)
+{
+    uint64_t capacity = 0;
+    uint16_t i;
+
+    if (!writer || (!segs && seg_count > 0)) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    for (i = 0; i < seg_count; i++) {
+        if (!segs[i].data && segs[i].len > 0) {
+            return XY_TLV_INVALID_PARAM;
+        }
+        capacity += segs[i].len;
+    }
+
+    writer->segs = segs;
+    writer->seg_count = seg_count;
+    writer->seg = 0;
+    writer->pos = 0;
+    writer->capacity = capacity > 0xFFFFFFFFu ? 0xFFFFFFFFu
+                                              : (uint32_t)capacity;
+    writer->total = 0;
+    writer->value_left = 0;
+    writer->nesting = 0;
+
+    return XY_TLV_OK;
+}
+
+int xy_tlv_sg_value_begin(xy_tlv_sg_writer_t *writer, uint16_t type,
+                          xy_tlv_size_t length)
+{
+    uint8_t header[XY_TLV_HEADER_SIZE];
+    uint8_t header_size;
+
+    if (!writer) {
+        return XY_TLV_INVALID_PARAM;
+    }
+    if (writer->value_left > 0) {
+        return XY_TLV_ERROR;
+    }
+
+    header_size = xy_tlv_header_encode(header, type, length, 0);
+    if (!sg_has_room(writer, header_size, length)) {
+        return XY_TLV_BUFFER_OVERFLOW;
+    }
+
+    sg_put(writer, header, header_size);
+    writer->value_left = length;
+
+    return XY_TLV_OK;
+}
+
+int xy_tlv_sg_value_write(xy_tlv_sg_writer_t *writer, const void *data,
+                          xy_tlv_size_t len)
+{
+    if (!writer || (!data && len > 0)) {
+        return XY_TLV_INVALID_PARAM;
+    }
+    if (len > writer->value_left) {
+        return XY_TLV_INVALID_LENGTH;
+    }
+
+    sg_put(writer, (const uint8_t *)data, len);
+    writer->value_left -= len;
+
+    return XY_TLV_OK;
+}
+
+int xy_tlv_sg_encode(xy_tlv_sg_writer_t *writer, uint16_t type,
+                     const void *value, xy_tlv_size_t length)
+{
+    int ret;
+
+    if (!writer || (!value && length > 0)) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    ret = xy_tlv_sg_value_begin(writer, type, length);
+    if (ret != XY_TLV_OK) {
+        return ret;
+    }
+    return xy_tlv_sg_value_write(writer, value, length);
+}
+
+int xy_tlv_sg_container_begin(xy_tlv_sg_writer_t *writer, uint16_t type)
+{
+    uint8_t header[XY_TLV_HEADER_SIZE];
+
+    if (!writer) {
+        return XY_TLV_INVALID_PARAM;
+    }
+    if (writer->value_left > 0) {
+        return XY_TLV_ERROR;
+    }
+    if (writer->nesting >= XY_TLV_MAX_NESTING_LEVEL) {
+        return XY_TLV_NESTING_OVERFLOW;
+    }
+    if (!sg_has_room(writer, XY_TLV_HEADER_SIZE, 0)) {
+        return XY_TLV_BUFFER_OVERFLOW;
+    }
+
+    /* Reserve a full-width header; the length is patched at the end */
+    writer->open[writer->nesting].seg = writer->seg;
+    writer->open[writer->nesting].pos = writer->pos;
+    writer->open[writer->nesting].type = type;
+    xy_tlv_header_encode(header, type, 0, XY_TLV_HEADER_SIZE);
+    sg_put(writer, header, XY_TLV_HEADER_SIZE);
+    writer->open[writer->nesting].start = writer->total;
+    writer->nesting++;
+
+    return XY_TLV_OK;
+}
+
+int xy_tlv_sg_container_end(xy_tlv_sg_writer_t *writer)
+{
+    uint8_t header[XY_TLV_HEADER_SIZE];
+    uint32_t length;
+
+    if (!writer) {
+        return XY_TLV_INVALID_PARAM;
+    }
+    if (writer->nesting == 0 || writer->value_left > 0) {
+        return XY_TLV_ERROR;
+    }
+
+    writer->nesting--;
+    length = writer->total - writer->open[writer->nesting].start;
+    if (length > XY_TLV_LENGTH_MAX) {
+        return XY_TLV_INVALID_LENGTH;
+    }
+
+    xy_tlv_header_encode(header, writer->open[writer->nesting].type,
+                         (xy_tlv_size_t)length, XY_TLV_HEADER_SIZE);
+    sg_patch(writer, writer->open[writer->nesting].seg,
+             writer->open[writer->nesting].pos, header, XY_TLV_HEADER_SIZE);
+
+    return XY_TLV_OK;
+}
+
+uint32_t xy_tlv_sg_get_used(const xy_tlv_sg_writer_t *writer)
+{
+    return writer ? writer->total : 0;
+}
+
+int xy_tlv_sg_get_segments(const xy_tlv_sg_writer_t *writer, xy_tlv_seg_t *out,
+                           uint16_t max)
+{
+    uint32_t left;
+    uint16_t i;
+    int count = 0;
+    size_t n;
+
+    if (!writer || !out) {
+        return XY_TLV_INVALID_PARAM;
+    }
+
+    left = writer->total;
+    for (i = 0; i < writer->seg_count && left > 0; i++) {
+        n = MIN((size_t)left, writer->segs[i].len);
+        if (n == 0) {
+            continue;
+        }
+        if (count >= max) {
+            return XY_TLV_BUFFER_OVERFLOW;
+        }
+        out[count].data = writer->segs[i].data;
+        out[count].len = n;
+        count++;
+        left -= (uint32_t)n;
+    }
+
+    return count;
+}
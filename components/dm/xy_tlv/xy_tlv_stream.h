@@ -0,0 +1,255 @@
+/**
+ * @file xy_tlv_stream.h
+ * @brief Streaming TLV decoding and scatter-gather encoding
+ *
+ * The core API needs a whole message in one contiguous buffer. This module
+ * removes that requirement on both sides:
+ * - Push parser: accepts arbitrary fragments (UART / DMA chunks, the two
+ *   halves of a ring buffer) and reports each element as soon as it is
+ *   complete. Values that arrive in one piece are passed zero-copy; others
+ *   are reassembled in a small staging buffer or delivered as chunks.
+ * - Segment writer: encodes into a chain of buffers (iovec style), so large
+ *   records can be produced in pool blocks and transmitted with a gather
+ *   DMA or writev() without a staging copy.
+ *
+ * The wire format is identical to xy_tlv.h, including XY_TLV_LENGTH_MODE.
+ *
+ * @author XY Team
+ * @date 2025
+ */
+
+#ifndef XY_TLV_STREAM_H
+#define XY_TLV_STREAM_H
+
+#include "xy_tlv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Push Parser ==================== */
+
+/**
+ * @brief Parser event types
+ */
+typedef enum {
+    XY_TLV_EVT_ELEMENT = 0, /**< Complete element, value contiguous */
+    XY_TLV_EVT_CHUNK,       /**< Part of a value too large to stage */
+    XY_TLV_EVT_ENTER,       /**< Container header parsed */
+    XY_TLV_EVT_LEAVE,       /**< Container fully received */
+} xy_tlv_event_type_t;
+
+/**
+ * @brief Parser event
+ *
+ * - ELEMENT: @c tlv is the whole element. @c tlv.value points into the
+ *   fed fragment or the staging buffer and is valid only for the callback.
+ * - CHUNK: @c tlv.value / @c tlv.length is one piece of the value, at
+ *   @c offset within a value of @c total_length bytes. The last chunk has
+ *   offset + length == total_length.
+ * - ENTER: @c tlv.type and @c tlv.length of the container, value NULL.
+ *   Its children follow one level deeper.
+ * - LEAVE: @c tlv.type of the container that just ended.
+ */
+typedef struct {
+    xy_tlv_event_type_t event; /**< Event type */
+    uint8_t depth;             /**< Nesting depth, 0 for top level */
+    xy_tlv_t tlv;              /**< Element (see above) */
+    xy_tlv_size_t total_length; /**< CHUNK: full value length */
+    xy_tlv_size_t offset;       /**< CHUNK: chunk offset in the value */
+} xy_tlv_event_t;
+
+/**
+ * @brief Parser event callback
+ *
+ * @param ctx User context
+ * @param evt Event
+ * @return 0 to continue, any other value aborts xy_tlv_parser_feed()
+ */
+typedef int (*xy_tlv_event_cb_t)(void *ctx, const xy_tlv_event_t *evt);
+
+/**
+ * @brief Push parser context
+ */
+typedef struct {
+    /* Configuration */
+    uint8_t *stage;                     /**< Reassembly buffer (may be NULL) */
+    xy_tlv_size_t stage_size;           /**< Reassembly buffer size */
+    xy_tlv_is_container_t is_container; /**< Types to descend into */
+    xy_tlv_event_cb_t callback;         /**< Event sink */
+    void *ctx;                          /**< Callback context */
+
+    /* Current element */
+    uint8_t header[XY_TLV_HEADER_SIZE]; /**< Partial header */
+    uint8_t header_len;                 /**< Bytes in header[] */
+    uint8_t in_value;                   /**< Receiving a value */
+    uint8_t staging;                    /**< Value goes to stage */
+    uint16_t type;                      /**< Element type */
+    xy_tlv_size_t length;               /**< Element value length */
+    xy_tlv_size_t value_pos;            /**< Value bytes received */
+
+    /* Open containers */
+    uint8_t depth;
+    uint32_t consumed; /**< Bytes since the last top-level boundary */
+    uint32_t end[XY_TLV_MAX_NESTING_LEVEL];
+    uint16_t end_type[XY_TLV_MAX_NESTING_LEVEL];
+
+    int error; /**< Sticky error, cleared by reset */
+} xy_tlv_parser_t;
+
+/**
+ * @brief Initialize a push parser
+ *
+ * @param parser Parser context
+ * @param stage Reassembly buffer for values split across fragments, or
+ *              NULL to always deliver split values as CHUNK events
+ * @param stage_size Reassembly buffer size; larger values become chunks
+ * @param is_container Types whose value is parsed as nested TLVs (ENTER /
+ *                     LEAVE events), NULL to treat every value as opaque
+ * @param callback Event sink
+ * @param ctx Callback context
+ * @return XY_TLV_OK on success, error code otherwise
+ */
+int xy_tlv_parser_init(xy_tlv_parser_t *parser, uint8_t *stage,
+                       xy_tlv_size_t stage_size,
+                       xy_tlv_is_container_t is_container,
+                       xy_tlv_event_cb_t callback, void *ctx);
+
+/**
+ * @brief Return the parser to the start of a stream
+ *
+ * @param parser Parser context
+ * @return XY_TLV_OK on success, error code otherwise
+ */
+int xy_tlv_parser_reset(xy_tlv_parser_t *parser);
+
+/**
+ * @brief Feed a fragment
+ *
+ * The whole fragment is consumed; incomplete headers and staged values are
+ * carried over to the next call. After an error the parser stays failed
+ * until xy_tlv_parser_reset().
+ *
+ * @param parser Parser context
+ * @param data Fragment
+ * @param len Fragment length
+ * @return XY_TLV_OK, a parse error, or the callback's non-zero return value
+ */
+int xy_tlv_parser_feed(xy_tlv_parser_t *parser, const uint8_t *data,
+                       size_t len);
+
+/**
+ * @brief Check whether the parser is between top-level elements
+ *
+ * @param parser Parser context
+ * @return true if no element or container is partially received
+ */
+bool xy_tlv_parser_is_idle(const xy_tlv_parser_t *parser);
+
+/* ==================== Segment Writer ==================== */
+
+/**
+ * @brief One output segment (iovec style)
+ */
+typedef struct {
+    uint8_t *data; /**< Segment memory */
+    size_t len;    /**< Segment size */
+} xy_tlv_seg_t;
+
+/**
+ * @brief Segment writer context
+ */
+typedef struct {
+    const xy_tlv_seg_t *segs; /**< Segment chain */
+    uint16_t seg_count;       /**< Segments in the chain */
+    uint16_t seg;             /**< Current segment */
+    size_t pos;               /**< Write offset in the current segment */
+    uint32_t capacity;        /**< Total size of the chain */
+    uint32_t total;           /**< Bytes written */
+    xy_tlv_size_t value_left; /**< Bytes owed by xy_tlv_sg_value_write */
+    uint8_t nesting;          /**< Open containers */
+    struct {
+        uint16_t seg;   /**< Segment of the header */
+        uint16_t type;  /**< Container type */
+        size_t pos;     /**< Offset of the header */
+        uint32_t start; /**< total at the first content byte */
+    } open[XY_TLV_MAX_NESTING_LEVEL];
+} xy_tlv_sg_writer_t;
+
+/**
+ * @brief Initialize a segment writer
+ *
+ * @param writer Writer context
+ * @param segs Segment chain, filled in order
+ * @param seg_count Number of segments
+ * @return XY_TLV_OK on success, error code otherwise
+ */
+int xy_tlv_sg_init(xy_tlv_sg_writer_t *writer, const xy_tlv_seg_t *segs,
+                   uint16_t seg_count);
+
+/**
+ * @brief Encode a complete element
+ *
+ * Header and value may straddle segment boundaries.
+ *
+ * @return XY_TLV_OK on success, error code otherwise
+ */
+int xy_tlv_sg_encode(xy_tlv_sg_writer_t *writer, uint16_t type,
+                     const void *value, xy_tlv_size_t length);
+
+/**
+ * @brief Start an element whose value is written piecewise
+ *
+ * Reserves the whole element; follow with xy_tlv_sg_value_write() calls
+ * totalling exactly @p length bytes.
+ *
+ * @return XY_TLV_OK on success, error code otherwise
+ */
+int xy_tlv_sg_value_begin(xy_tlv_sg_writer_t *writer, uint16_t type,
+                          xy_tlv_size_t length);
+
+/**
+ * @brief Append value bytes to the element started by
+ *        xy_tlv_sg_value_begin()
+ *
+ * @return XY_TLV_OK on success, XY_TLV_INVALID_LENGTH if more bytes are
+ *         written than announced
+ */
+int xy_tlv_sg_value_write(xy_tlv_sg_writer_t *writer, const void *data,
+                          xy_tlv_size_t len);
+
+/**
+ * @brief Begin a container; its length is patched by xy_tlv_sg_container_end
+ *
+ * @return XY_TLV_OK on success, error code otherwise
+ */
+int xy_tlv_sg_container_begin(xy_tlv_sg_writer_t *writer, uint16_t type);
+
+/**
+ * @brief End the innermost open container
+ *
+ * @return XY_TLV_OK on success, error code otherwise
+ */
+int xy_tlv_sg_container_end(xy_tlv_sg_writer_t *writer);
+
+/**
+ * @brief Get the number of bytes written
+ */
+uint32_t xy_tlv_sg_get_used(const xy_tlv_sg_writer_t *writer);
+
+/**
+ * @brief Describe the written data as a segment list for transmission
+ *
+ * @param writer Writer context
+ * @param out Output list; the last entry is trimmed to the written length
+ * @param max Capacity of @p out
+ * @return Number of entries filled, or XY_TLV_BUFFER_OVERFLOW
+ */
+int xy_tlv_sg_get_segments(const xy_tlv_sg_writer_t *writer, xy_tlv_seg_t *out,
+                           uint16_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XY_TLV_STREAM_H */
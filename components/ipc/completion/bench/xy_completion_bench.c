@@ -0,0 +1,410 @@
+/**
+ * @file xy_completion_bench.c
+ * @brief Completions on the host
+ *
+ * Built once per wait mode (XY_COMPLETION_WAIT): thread flags, semaphore,
+ * and the bare-metal poll, which on the host yields instead of WFI.
+ *
+ * 1. Semantics: completes are counted, a wait with timeout 0 does not
+ *    block, a wait times out, complete_all releases every waiter and
+ *    stays done until reinit.
+ * 2. Ping-pong: complete then wait in one thread, the transfer that is
+ *    done before the driver waits; then two threads hand a token back and
+ *    forth through two completions, with and without the spin. Both
+ *    against OSAL semaphores; time per handoff.
+ * 3. Stress: two threads complete, three wait, 20000 times in all. No
+ *    completion may be lost or taken twice.
+ * 4. Interrupt (poll build): a 100 us timer signal completes, the main
+ *    loop waits; time from the handler to the waiter.
+ *
+ * xy_os_host.c (from the xy_broker bench) provides the OSAL on pthreads.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "xy_completion.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#if XY_COMPLETION_WAIT == XY_COMPLETION_WAIT_FLAGS
+#define MODE_NAME "thread flags"
+#elif XY_COMPLETION_WAIT == XY_COMPLETION_WAIT_SEM
+#define MODE_NAME "semaphore"
+#else
+#define MODE_NAME "poll"
+#endif
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* ==================== Semantics ==================== */
+
+#define ALL_WAITERS 4
+
+static xy_completion_t s_all;
+static uint32_t s_all_back;
+
+static void *all_waiter(void *arg)
+{
+    (void)arg;
+    if (xy_completion_wait(&s_all, 2000) == XY_OS_OK)
+        __atomic_fetch_add(&s_all_back, 1, __ATOMIC_ACQ_REL);
+    return NULL;
+}
+
+static int check_semantics(void)
+{
+    xy_completion_t c;
+    pthread_t waiters[ALL_WAITERS];
+    double t0, waited;
+    int ok = 1;
+
+    if (xy_completion_init(&c) != XY_OS_OK)
+        return 0;
+
+    /* Counted: three completes, three waits */
+    for (int i = 0; i < 3; i++)
+        xy_completion_complete(&c);
+    for (int i = 0; i < 3; i++)
+        ok &= xy_completion_wait(&c, XY_OS_NO_WAIT) == XY_OS_OK;
+    ok &= xy_completion_wait(&c, XY_OS_NO_WAIT) == XY_OS_ERROR_RESOURCE;
+    ok &= !xy_completion_done(&c);
+
+    /* Times out after about 20 ticks; the host tick may be coarse */
+    t0     = now_ns();
+    ok    &= xy_completion_wait(&c, 20) == XY_OS_ERROR_TIMEOUT;
+    waited = (now_ns() - t0) / 1e6;
+    ok    &= waited >= 10.0 && waited < 500.0;
+    printf("  counted, try, timeout of 20 ticks after %.1f ms\n", waited);
+    xy_completion_deinit(&c);
+
+    /* complete_all: every blocked waiter, and every later one */
+    if (xy_completion_init(&s_all) != XY_OS_OK)
+        return 0;
+    s_all_back = 0;
+    for (int i = 0; i < ALL_WAITERS; i++)
+        pthread_create(&waiters[i], NULL, all_waiter, NULL);
+    xy_os_delay(20);
+    xy_completion_complete_all(&s_all);
+    for (int i = 0; i < ALL_WAITERS; i++)
+        pthread_join(waiters[i], NULL);
+    ok &= s_all_back == ALL_WAITERS;
+    ok &= xy_completion_wait(&s_all, XY_OS_NO_WAIT) == XY_OS_OK;
+    ok &= xy_completion_wait(&s_all, XY_OS_NO_WAIT) == XY_OS_OK;
+    xy_completion_reinit(&s_all);
+    ok &= xy_completion_wait(&s_all, XY_OS_NO_WAIT) == XY_OS_ERROR_RESOURCE;
+    printf("  complete_all released %u of %d waiters, stays done until reinit\n",
+           (unsigned)s_all_back, ALL_WAITERS);
+    xy_completion_deinit(&s_all);
+
+    return ok;
+}
+
+/* ==================== Ping-pong ==================== */
+
+#define PP_ROUNDS 20000
+
+static xy_completion_t s_ping, s_pong;
+static xy_os_semaphore_id_t s_sem_ping, s_sem_pong;
+static int s_pp_bad;
+
+static void *pp_completion_peer(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < PP_ROUNDS; i++) {
+        if (xy_completion_wait(&s_ping, 2000) != XY_OS_OK)
+            s_pp_bad = 1;
+        xy_completion_complete(&s_pong);
+    }
+    return NULL;
+}
+
+static void *pp_sem_peer(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < PP_ROUNDS; i++) {
+        if (xy_os_semaphore_acquire(s_sem_ping, 2000) != XY_OS_OK)
+            s_pp_bad = 1;
+        xy_os_semaphore_release(s_sem_pong);
+    }
+    return NULL;
+}
+
+/* Already complete when waited for: no thread switch */
+static int bench_done_first(void)
+{
+    xy_completion_t c;
+    xy_os_semaphore_id_t sem = xy_os_semaphore_new(1, 0, NULL);
+    double t0, comp_ns, sem_ns;
+    int ok = 1;
+
+    if (!sem || xy_completion_init(&c) != XY_OS_OK)
+        return 0;
+
+    t0 = now_ns();
+    for (int i = 0; i < PP_ROUNDS; i++) {
+        xy_completion_complete(&c);
+        ok &= xy_completion_wait(&c, XY_OS_WAIT_FOREVER) == XY_OS_OK;
+    }
+    comp_ns = (now_ns() - t0) / PP_ROUNDS;
+
+    t0 = now_ns();
+    for (int i = 0; i < PP_ROUNDS; i++) {
+        xy_os_semaphore_release(sem);
+        ok &= xy_os_semaphore_acquire(sem, XY_OS_WAIT_FOREVER) == XY_OS_OK;
+    }
+    sem_ns = (now_ns() - t0) / PP_ROUNDS;
+
+    printf("  done first: completion %.0f ns, OSAL semaphore %.0f ns\n", comp_ns, sem_ns);
+    xy_completion_deinit(&c);
+    xy_os_semaphore_delete(sem);
+    return ok;
+}
+
+static int bench_pingpong_completion(uint32_t spin)
+{
+    pthread_t peer;
+    double t0, ns;
+
+    if (xy_completion_init(&s_ping) != XY_OS_OK || xy_completion_init(&s_pong) != XY_OS_OK)
+        return 0;
+    xy_completion_set_spin(&s_ping, spin);
+    xy_completion_set_spin(&s_pong, spin);
+    s_pp_bad = 0;
+
+    pthread_create(&peer, NULL, pp_completion_peer, NULL);
+    t0 = now_ns();
+    for (int i = 0; i < PP_ROUNDS; i++) {
+        xy_completion_complete(&s_ping);
+        if (xy_completion_wait(&s_pong, 2000) != XY_OS_OK)
+            s_pp_bad = 1;
+    }
+    ns = (now_ns() - t0) / (2.0 * PP_ROUNDS);
+    pthread_join(peer, NULL);
+
+    printf("  completion, spin %-4u %8.0f ns per handoff\n", (unsigned)spin, ns);
+    xy_completion_deinit(&s_ping);
+    xy_completion_deinit(&s_pong);
+    return !s_pp_bad && !xy_completion_done(&s_ping) && !xy_completion_done(&s_pong);
+}
+
+static int bench_pingpong_sem(void)
+{
+    pthread_t peer;
+    double t0, ns;
+
+    s_sem_ping = xy_os_semaphore_new(1, 0, NULL);
+    s_sem_pong = xy_os_semaphore_new(1, 0, NULL);
+    if (!s_sem_ping || !s_sem_pong)
+        return 0;
+    s_pp_bad = 0;
+
+    pthread_create(&peer, NULL, pp_sem_peer, NULL);
+    t0 = now_ns();
+    for (int i = 0; i < PP_ROUNDS; i++) {
+        xy_os_semaphore_release(s_sem_ping);
+        if (xy_os_semaphore_acquire(s_sem_pong, 2000) != XY_OS_OK)
+            s_pp_bad = 1;
+    }
+    ns = (now_ns() - t0) / (2.0 * PP_ROUNDS);
+    pthread_join(peer, NULL);
+
+    printf("  OSAL semaphore         %8.0f ns per handoff\n", ns);
+    xy_os_semaphore_delete(s_sem_ping);
+    xy_os_semaphore_delete(s_sem_pong);
+    return !s_pp_bad;
+}
+
+/* ==================== Stress ==================== */
+
+#define ST_COMPLETERS 2
+#define ST_WAITERS    3
+#define ST_TOTAL      20000
+
+static xy_completion_t s_st;
+static uint32_t s_st_taken;
+static uint32_t s_st_stop;
+static uint32_t s_st_timeouts;
+
+static void *st_completer(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < ST_TOTAL / ST_COMPLETERS; i++) {
+        xy_completion_complete(&s_st);
+        if ((i & 63) == 0)
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void *st_waiter(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        xy_os_status_t ret = xy_completion_wait(&s_st, 50);
+
+        if (__atomic_load_n(&s_st_stop, __ATOMIC_ACQUIRE))
+            break;
+        if (ret == XY_OS_OK)
+            __atomic_fetch_add(&s_st_taken, 1, __ATOMIC_ACQ_REL);
+        else
+            __atomic_fetch_add(&s_st_timeouts, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+static int check_stress(void)
+{
+    pthread_t completers[ST_COMPLETERS], waiters[ST_WAITERS];
+    uint32_t taken;
+    double t0;
+
+    if (xy_completion_init(&s_st) != XY_OS_OK)
+        return 0;
+    s_st_taken = s_st_stop = s_st_timeouts = 0;
+
+    t0 = now_ns();
+    for (int i = 0; i < ST_WAITERS; i++)
+        pthread_create(&waiters[i], NULL, st_waiter, NULL);
+    for (int i = 0; i < ST_COMPLETERS; i++)
+        pthread_create(&completers[i], NULL, st_completer, NULL);
+    for (int i = 0; i < ST_COMPLETERS; i++)
+        pthread_join(completers[i], NULL);
+
+    /* Every completion is taken by a waiter, without help */
+    for (int ms = 0; ms < 5000; ms++) {
+        if (__atomic_load_n(&s_st_taken, __ATOMIC_ACQUIRE) >= ST_TOTAL)
+            break;
+        xy_os_delay(1);
+    }
+    taken = __atomic_load_n(&s_st_taken, __ATOMIC_ACQUIRE);
+
+    __atomic_store_n(&s_st_stop, 1, __ATOMIC_RELEASE);
+    xy_completion_complete_all(&s_st);
+    for (int i = 0; i < ST_WAITERS; i++)
+        pthread_join(waiters[i], NULL);
+    xy_completion_deinit(&s_st);
+
+    printf("  %d completers, %d waiters: %u of %d taken in %.1f ms, %u idle timeouts\n",
+           ST_COMPLETERS, ST_WAITERS, (unsigned)taken, ST_TOTAL, (now_ns() - t0) / 1e6,
+           (unsigned)s_st_timeouts);
+    return taken == ST_TOTAL && s_st_taken == ST_TOTAL;
+}
+
+/* ==================== Interrupt ==================== */
+
+#if XY_COMPLETION_WAIT == XY_COMPLETION_WAIT_IDLE
+
+#define IRQ_WAITS 1000
+
+static xy_completion_t s_irq;
+static volatile uint32_t s_irq_stamp;
+static volatile uint32_t s_irq_count;
+
+static void irq_handler(int sig)
+{
+    int saved = errno;
+
+    (void)sig;
+    s_irq_count++;
+    if (!xy_completion_done(&s_irq)) {
+        s_irq_stamp = xy_os_kernel_get_sys_timer_count();
+        xy_completion_complete(&s_irq);
+    }
+    errno = saved;
+}
+
+static int check_irq(void)
+{
+    struct itimerval period = { { 0, 100 }, { 0, 100 } }, off = { { 0, 0 }, { 0, 0 } };
+    struct sigaction sa;
+    sigset_t alrm;
+    double total = 0, worst = 0;
+    int got = 0;
+
+    if (xy_completion_init(&s_irq) != XY_OS_OK)
+        return 0;
+    s_irq_count = 0;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = irq_handler;
+    sa.sa_flags   = SA_RESTART;
+    sigaction(SIGALRM, &sa, NULL);
+    setitimer(ITIMER_REAL, &period, NULL);
+
+    /* The main loop waits for each "transfer" as a driver would */
+    for (int i = 0; i < IRQ_WAITS; i++) {
+        double ns;
+
+        if (xy_completion_wait(&s_irq, 100) != XY_OS_OK)
+            break;
+        ns = (double)(uint32_t)(xy_os_kernel_get_sys_timer_count() - s_irq_stamp);
+        total += ns;
+        if (ns > worst)
+            worst = ns;
+        got++;
+    }
+
+    setitimer(ITIMER_REAL, &off, NULL);
+    sigemptyset(&alrm);
+    sigaddset(&alrm, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &alrm, NULL);
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGALRM, &sa, NULL);
+    pthread_sigmask(SIG_UNBLOCK, &alrm, NULL);
+    xy_completion_deinit(&s_irq);
+
+    printf("  %u interrupts, %d completions waited for, handler to waiter "
+           "mean %.2f us, worst %.1f us\n",
+           (unsigned)s_irq_count, got, got ? total / got / 1e3 : 0.0, worst / 1e3);
+    return got == IRQ_WAITS;
+}
+
+#endif
+
+int main(void)
+{
+    static const uint32_t spins[] = { 0, XY_COMPLETION_SPIN, 1000 };
+
+    printf("wait mode: %s\n\nsemantics\n", MODE_NAME);
+    if (!check_semantics())
+        goto fail;
+
+    printf("\nping-pong, %d rounds\n", PP_ROUNDS);
+    if (!bench_done_first())
+        goto fail;
+    for (size_t i = 0; i < sizeof(spins) / sizeof(spins[0]); i++) {
+        if (!bench_pingpong_completion(spins[i]))
+            goto fail;
+    }
+    if (!bench_pingpong_sem())
+        goto fail;
+
+    printf("\nstress\n");
+    if (!check_stress())
+        goto fail;
+
+#if XY_COMPLETION_WAIT == XY_COMPLETION_WAIT_IDLE
+    printf("\ninterrupt\n");
+    if (!check_irq())
+        goto fail;
+#endif
+
+    return 0;
+
+fail:
+    printf("check failed\n");
+    return 1;
+}
@@ -0,0 +1,346 @@
+/**
+ * @file xy_completion.c
+ * @brief XY Completion Implementation
+ */
+
+#include "xy_completion.h"
+#include <string.h>
+
+/* ==================== Internal Definitions ==================== */
+
+/*
+ * The count is the whole state: completers add to it and waiters take from
+ * it with compare-and-swap, so neither takes a lock and completers may run
+ * in interrupts. A waiter that blocks first makes itself known (a waiter
+ * slot, or the sleeper count) and then looks at the count again; a
+ * completer adds first and then looks for waiters. One of the two always
+ * sees the other, so no wake-up is lost. Both are sequentially consistent
+ * for that reason.
+ */
+#if !defined(__GNUC__)
+#error "xy_completion needs the __atomic builtins (GCC, Clang, armclang)"
+#endif
+
+#define COMP_LOAD(p)     __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define COMP_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define COMP_CAS(p, e, v)                                                      \
+    __atomic_compare_exchange_n((p), (e), (v), 0, __ATOMIC_SEQ_CST,           \
+                                __ATOMIC_SEQ_CST)
+#define COMP_XCHG(p, v)  __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define COMP_ADD(p, v)   __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define COMP_SUB(p, v)   __atomic_fetch_sub((p), (v), __ATOMIC_SEQ_CST)
+
+/** Wake count for complete_all */
+#define COMP_WAKE_ALL 0x7FFFFFFF
+
+/** CPU hint inside a polling loop */
+#if defined(__i386__) || defined(__x86_64__)
+#define COMP_RELAX() __asm volatile("pause" ::: "memory")
+#elif defined(__ARM_ARCH) && (__ARM_ARCH >= 7 || defined(__aarch64__))
+#define COMP_RELAX() __asm volatile("yield" ::: "memory")
+#else
+#define COMP_RELAX() __asm volatile("" ::: "memory")
+#endif
+
+/* ==================== Internal Helper Functions ==================== */
+
+/**
+ * @brief Take one completion
+ *
+ * @return 1 if taken, or done for good; 0 if there is none
+ */
+static int comp_take(xy_completion_t *completion)
+{
+    uint32_t done = COMP_LOAD(&completion->done);
+
+    do {
+        if (done == XY_COMPLETION_DONE_ALL)
+            return 1;
+        if (done == 0)
+            return 0;
+    } while (!COMP_CAS(&completion->done, &done, done - 1));
+    return 1;
+}
+
+/**
+ * @brief Ticks left of @p timeout, counted from tick @p start
+ */
+static uint32_t comp_left(uint32_t timeout, uint32_t start)
+{
+    uint32_t spent;
+
+    if (timeout == XY_OS_WAIT_FOREVER)
+        return timeout;
+    spent = xy_os_kernel_get_tick_count() - start;
+    return spent >= timeout ? 0 : timeout - spent;
+}
+
+#if XY_COMPLETION_WAIT == XY_COMPLETION_WAIT_FLAGS
+
+/**
+ * @brief Claim a waiter slot for @p self
+ *
+ * @return Slot index, or -1 if all are taken
+ */
+static int comp_enlist(xy_completion_t *completion, xy_os_thread_id_t self)
+{
+    int i;
+
+    for (i = 0; i < XY_COMPLETION_MAX_WAITERS; i++) {
+        xy_os_thread_id_t none = NULL;
+
+        if (COMP_CAS(&completion->waiters[i], &none, self))
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Give up slot @p slot, unless a completer has already taken it
+ */
+static void comp_delist(xy_completion_t *completion, int slot,
+                        xy_os_thread_id_t self)
+{
+    xy_os_thread_id_t mine = self;
+
+    (void)COMP_CAS(&completion->waiters[slot], &mine, NULL);
+}
+
+/**
+ * @brief Wake up to @p max waiters, taking their slots
+ */
+static void comp_wake(xy_completion_t *completion, int max)
+{
+    int i;
+
+    for (i = 0; i < XY_COMPLETION_MAX_WAITERS && max > 0; i++) {
+        xy_os_thread_id_t thread = COMP_LOAD(&completion->waiters[i]);
+
+        if (thread && COMP_CAS(&completion->waiters[i], &thread, NULL)) {
+            (void)xy_os_thread_flags_set(thread, XY_COMPLETION_FLAG);
+            max--;
+        }
+    }
+}
+
+/**
+ * @brief Block until a completion is taken or the timeout expires
+ *
+ * A woken waiter that finds the completion taken by a thread that never
+ * blocked goes back to sleep. One whose slot a completer took while it was
+ * timing out finds that completion still there, and returns it.
+ */
+static xy_os_status_t comp_block(xy_completion_t *completion,
+                                 uint32_t timeout, uint32_t start)
+{
+    xy_os_thread_id_t self = xy_os_thread_get_id();
+
+    for (;;) {
+        uint32_t left = comp_left(timeout, start);
+        int slot;
+
+        if (left == 0)
+            return XY_OS_ERROR_TIMEOUT;
+
+        /* Drop a wake-up left from a completer that lost a race with us */
+        (void)xy_os_thread_flags_wait(XY_COMPLETION_FLAG, XY_OS_FLAGS_WAIT_ANY,
+                                      XY_OS_NO_WAIT);
+        slot = self ? comp_enlist(completion, self) : -1;
+        if (slot < 0) {
+            (void)xy_os_delay(1);
+            if (comp_take(completion))
+                return XY_OS_OK;
+            continue;
+        }
+
+        if (comp_take(completion)) {
+            comp_delist(completion, slot, self);
+            return XY_OS_OK;
+        }
+        (void)xy_os_thread_flags_wait(XY_COMPLETION_FLAG, XY_OS_FLAGS_WAIT_ANY,
+                                      left);
+        comp_delist(completion, slot, self);
+        if (comp_take(completion))
+            return XY_OS_OK;
+    }
+}
+
+#elif XY_COMPLETION_WAIT == XY_COMPLETION_WAIT_SEM
+
+/**
+ * @brief Wake up to @p max sleepers
+ *
+ * A sleeper that took its completion before sleeping leaves a token
+ * behind; the next one to sleep wakes on it, finds nothing and sleeps
+ * again.
+ */
+static void comp_wake(xy_completion_t *completion, int max)
+{
+    uint32_t sleepers = COMP_LOAD(&completion->sleepers);
+
+    while (sleepers-- > 0 && max-- > 0)
+        (void)xy_os_semaphore_release(completion->sem);
+}
+
+static xy_os_status_t comp_block(xy_completion_t *completion,
+                                 uint32_t timeout, uint32_t start)
+{
+    for (;;) {
+        uint32_t left = comp_left(timeout, start);
+
+        if (left == 0)
+            return XY_OS_ERROR_TIMEOUT;
+
+        COMP_ADD(&completion->sleepers, 1);
+        if (comp_take(completion)) {
+            COMP_SUB(&completion->sleepers, 1);
+            return XY_OS_OK;
+        }
+        (void)xy_os_semaphore_acquire(completion->sem, left);
+        COMP_SUB(&completion->sleepers, 1);
+        if (comp_take(completion))
+            return XY_OS_OK;
+    }
+}
+
+#else /* XY_COMPLETION_WAIT_IDLE */
+
+/**
+ * @brief Sleep until the next interrupt, unless completed already
+ *
+ * On Cortex-M the check and the WFI run with interrupts masked: an
+ * interrupt that completes in between stays pending and ends the WFI at
+ * once, and its handler runs when the mask is restored. A port may define
+ * XY_COMPLETION_IDLE() instead; elsewhere the waiter yields between polls.
+ */
+static void comp_idle(xy_completion_t *completion)
+{
+#if defined(XY_COMPLETION_IDLE)
+    (void)completion;
+    XY_COMPLETION_IDLE();
+#elif defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+    uint32_t primask;
+
+    __asm volatile("mrs %0, primask\n\tcpsid i" : "=r"(primask)::"memory");
+    if (COMP_LOAD(&completion->done) == 0)
+        __asm volatile("dsb\n\twfi" ::: "memory");
+    __asm volatile("msr primask, %0" ::"r"(primask) : "memory");
+#else
+    (void)completion;
+    (void)xy_os_thread_yield();
+#endif
+}
+
+static void comp_wake(xy_completion_t *completion, int max)
+{
+    /* Interrupts wake the core by themselves */
+    (void)completion;
+    (void)max;
+}
+
+static xy_os_status_t comp_block(xy_completion_t *completion,
+                                 uint32_t timeout, uint32_t start)
+{
+    for (;;) {
+        if (comp_left(timeout, start) == 0)
+            return XY_OS_ERROR_TIMEOUT;
+        comp_idle(completion);
+        if (comp_take(completion))
+            return XY_OS_OK;
+    }
+}
+
+#endif /* XY_COMPLETION_WAIT */
+
+/* ==================== API Implementation ==================== */
+
+xy_os_status_t xy_completion_init(xy_completion_t *completion)
+{
+    if (!completion)
+        return XY_OS_ERROR_PARAMETER;
+
+    memset(completion, 0, sizeof(*completion));
+    completion->spin = XY_COMPLETION_SPIN;
+#if XY_COMPLETION_WAIT == XY_COMPLETION_WAIT_SEM
+    completion->sem = xy_os_semaphore_new(0xFFFF, 0, NULL);
+    if (!completion->sem)
+        return XY_OS_ERROR_NO_MEMORY;
+#endif
+    return XY_OS_OK;
+}
+
+xy_os_status_t xy_completion_deinit(xy_completion_t *completion)
+{
+    if (!completion)
+        return XY_OS_ERROR_PARAMETER;
+
+#if XY_COMPLETION_WAIT == XY_COMPLETION_WAIT_SEM
+    if (completion->sem)
+        (void)xy_os_semaphore_delete(completion->sem);
+    completion->sem = NULL;
+#endif
+    return XY_OS_OK;
+}
+
+void xy_completion_reinit(xy_completion_t *completion)
+{
+    if (completion)
+        COMP_STORE(&completion->done, 0);
+}
+
+void xy_completion_set_spin(xy_completion_t *completion, uint32_t spin)
+{
+    if (completion)
+        completion->spin = spin;
+}
+
+xy_os_status_t xy_completion_wait(xy_completion_t *completion,
+                                  uint32_t timeout)
+{
+    uint32_t spin;
+
+    if (!completion)
+        return XY_OS_ERROR_PARAMETER;
+
+    if (comp_take(completion))
+        return XY_OS_OK;
+    if (timeout == XY_OS_NO_WAIT)
+        return XY_OS_ERROR_RESOURCE;
+
+    for (spin = completion->spin; spin > 0; spin--) {
+        COMP_RELAX();
+        if (COMP_LOAD(&completion->done) != 0 && comp_take(completion))
+            return XY_OS_OK;
+    }
+
+    return comp_block(completion, timeout, xy_os_kernel_get_tick_count());
+}
+
+void xy_completion_complete(xy_completion_t *completion)
+{
+    uint32_t done;
+
+    if (!completion)
+        return;
+
+    done = COMP_LOAD(&completion->done);
+    do {
+        if (done >= XY_COMPLETION_DONE_ALL - 1)
+            return;
+    } while (!COMP_CAS(&completion->done, &done, done + 1));
+    comp_wake(completion, 1);
+}
+
+void xy_completion_complete_all(xy_completion_t *completion)
+{
+    if (!completion)
+        return;
+
+    (void)COMP_XCHG(&completion->done, XY_COMPLETION_DONE_ALL);
+    comp_wake(completion, COMP_WAKE_ALL);
+}
+
+int xy_completion_done(const xy_completion_t *completion)
+{
+    return completion && COMP_LOAD(&completion->done) != 0;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file xy_completion.h
+ * @brief XY Completion - wait for a single event, such as a DMA transfer or
+ * a bus transaction, to finish
+ *
+ * A completion counts events. complete() adds one and wakes one waiter,
+ * complete_all() marks it done for good and wakes every waiter, and wait()
+ * takes one, or returns at once after complete_all(). Both completes may be
+ * called from an ISR; wait() from a thread, or from anywhere with a timeout
+ * of 0.
+ *
+ * A waiter first polls for a short while: a transfer that finishes within
+ * a few microseconds never costs a context switch. Then it blocks:
+ * - XY_COMPLETION_WAIT_FLAGS: on a thread flag, set by the completer
+ * - XY_COMPLETION_WAIT_SEM: on an OSAL semaphore, for ports without flags
+ * - XY_COMPLETION_WAIT_IDLE: no threads; the core sleeps in WFI between
+ *   polls, woken by the interrupt that completes
+ *
+ * @author XY Team
+ * @date 2025
+ */
+
+#ifndef _XY_COMPLETION_H_
+#define _XY_COMPLETION_H_
+
+#include <stdint.h>
+#include "../../kernel/osal/xy_os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Configuration ==================== */
+
+#define XY_COMPLETION_WAIT_FLAGS 0 /**< Block on a thread flag */
+#define XY_COMPLETION_WAIT_SEM   1 /**< Block on a semaphore */
+#define XY_COMPLETION_WAIT_IDLE  2 /**< Poll, sleeping in WFI (bare metal) */
+
+/**
+ * How a waiter blocks once it has polled; by default from the OSAL backend
+ * the build selects
+ */
+#ifndef XY_COMPLETION_WAIT
+#if defined(XY_OS_BACKEND_BAREMETAL)
+#define XY_COMPLETION_WAIT XY_COMPLETION_WAIT_IDLE
+#elif defined(XY_OS_FEATURE_THREAD_FLAGS) && !XY_OS_FEATURE_THREAD_FLAGS
+#define XY_COMPLETION_WAIT XY_COMPLETION_WAIT_SEM
+#else
+#define XY_COMPLETION_WAIT XY_COMPLETION_WAIT_FLAGS
+#endif
+#endif
+
+#ifndef XY_COMPLETION_SPIN
+#define XY_COMPLETION_SPIN 100 /**< Default polls before blocking */
+#endif
+
+#ifndef XY_COMPLETION_FLAG
+#define XY_COMPLETION_FLAG 0x20000000U /**< Thread flag a waiter blocks on */
+#endif
+
+#ifndef XY_COMPLETION_MAX_WAITERS
+#define XY_COMPLETION_MAX_WAITERS 4 /**< Threads blocked on flags, at most */
+#endif
+
+/** done after xy_completion_complete_all() */
+#define XY_COMPLETION_DONE_ALL 0xFFFFFFFFU
+
+/* ==================== Data Structures ==================== */
+
+/**
+ * @brief Completion, owned by the caller
+ *
+ * With thread flags, waiters beyond XY_COMPLETION_MAX_WAITERS poll once a
+ * tick instead of blocking.
+ */
+typedef struct {
+    uint32_t done;                  /**< Completions not yet taken */
+    uint32_t spin;                  /**< Polls before blocking */
+#if XY_COMPLETION_WAIT == XY_COMPLETION_WAIT_FLAGS
+    xy_os_thread_id_t waiters[XY_COMPLETION_MAX_WAITERS]; /**< Blocked */
+#elif XY_COMPLETION_WAIT == XY_COMPLETION_WAIT_SEM
+    xy_os_semaphore_id_t sem;       /**< Blocked threads wait here */
+    uint32_t sleepers;              /**< Threads on sem */
+#endif
+} xy_completion_t;
+
+/* ==================== API ==================== */
+
+/**
+ * @brief Initialize a completion, not done
+ *
+ * @param completion Completion
+ * @return XY_OS_OK, XY_OS_ERROR_PARAMETER, or XY_OS_ERROR_NO_MEMORY if the
+ *         semaphore could not be created
+ */
+xy_os_status_t xy_completion_init(xy_completion_t *completion);
+
+/**
+ * @brief Release a completion; no thread may be waiting on it
+ *
+ * @param completion Completion
+ * @return XY_OS_OK or XY_OS_ERROR_PARAMETER
+ */
+xy_os_status_t xy_completion_deinit(xy_completion_t *completion);
+
+/**
+ * @brief Make a completion not done again, for the next transfer
+ *
+ * No thread may be waiting on it.
+ *
+ * @param completion Completion
+ */
+void xy_completion_reinit(xy_completion_t *completion);
+
+/**
+ * @brief Set the polls a waiter makes before it blocks
+ *
+ * 0 blocks at once: best where the completer is another thread on the same
+ * core. Larger values suit completions from interrupts or other cores that
+ * usually come within microseconds.
+ *
+ * @param completion Completion
+ * @param spin Polls
+ */
+void xy_completion_set_spin(xy_completion_t *completion, uint32_t spin);
+
+/**
+ * @brief Wait for a completion
+ *
+ * @param completion Completion
+ * @param timeout Kernel ticks, XY_OS_NO_WAIT or XY_OS_WAIT_FOREVER
+ * @return XY_OS_OK once completed, XY_OS_ERROR_RESOURCE if not done and
+ *         timeout is 0, XY_OS_ERROR_TIMEOUT, or XY_OS_ERROR_PARAMETER
+ */
+xy_os_status_t xy_completion_wait(xy_completion_t *completion,
+                                  uint32_t timeout);
+
+/**
+ * @brief Complete once: one waiter, present or future, returns
+ *
+ * @note May be called from an ISR
+ *
+ * @param completion Completion
+ */
+void xy_completion_complete(xy_completion_t *completion);
+
+/**
+ * @brief Complete for good: every waiter returns, now and until reinit
+ *
+ * @note May be called from an ISR
+ *
+ * @param completion Completion
+ */
+void xy_completion_complete_all(xy_completion_t *completion);
+
+/**
+ * @brief Whether a wait would return at once
+ *
+ * @param completion Completion
+ * @return 1 if done, 0 otherwise
+ */
+int xy_completion_done(const xy_completion_t *completion);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XY_COMPLETION_H_ */
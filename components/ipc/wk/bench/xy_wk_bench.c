@@ -0,0 +1,514 @@
+/**
+ * @file xy_wk_bench.c
+ * @brief Workqueue on the host
+ *
+ * 1. Cooperative: a queue without workers, run from a main loop. Items run
+ *    in submit order, once however often they are submitted before they
+ *    run; delayed work and xy_wk_next_due(); cancel. Cost of a submit and
+ *    its run.
+ * 2. Delayed work on a worker thread: random delays, none may run early;
+ *    how late they run.
+ * 3. Cancel: half of a set of delayed items are canceled. Those must never
+ *    run, the rest must run once.
+ * 4. Throughput: two threads keep a set of items submitted to one and four
+ *    workers, one item per lock and batches of eight. Every accepted
+ *    submit must run once, and no item may run on two workers at once;
+ *    time per item, queue latency, items per lock.
+ * 5. Re-arming: an item submits itself again from its own function on four
+ *    workers while another thread submits it too.
+ * 6. Interrupt: a 100 us timer signal submits work, some of it delayed, to
+ *    a cooperative queue that the main loop runs, as on bare metal.
+ *
+ * xy_os_host.c (from the xy_broker bench) provides the OSAL on pthreads.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "xy_wk.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define ITEMS 200
+
+typedef struct {
+    xy_wk_work_t work;
+    uint32_t seq;      /* Submit order */
+    uint32_t runs;     /* Times its function ran */
+    uint32_t inflight; /* Runs in progress; never above 1 */
+    uint32_t due;      /* Earliest tick it may run */
+    uint32_t ran_at;   /* Tick it ran */
+} bench_item_t;
+
+static bench_item_t s_items[ITEMS];
+static uint32_t s_rand = 1;
+static int s_bad;
+
+static uint32_t rnd(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void items_init(xy_wk_func_t func)
+{
+    memset(s_items, 0, sizeof(s_items));
+    for (uint32_t i = 0; i < ITEMS; i++) {
+        xy_wk_init(&s_items[i].work, func, &s_items[i]);
+        s_items[i].seq = i;
+    }
+}
+
+static uint32_t runs_total(int n)
+{
+    uint32_t total = 0;
+
+    for (int i = 0; i < n; i++)
+        total += __atomic_load_n(&s_items[i].runs, __ATOMIC_ACQUIRE);
+    return total;
+}
+
+/* Wait for @p want runs of the first @p n items, up to 2 s */
+static int wait_runs(int n, uint32_t want)
+{
+    for (int ms = 0; ms < 2000; ms++) {
+        if (runs_total(n) >= want)
+            return runs_total(n) == want;
+        xy_os_delay(1);
+    }
+    return 0;
+}
+
+/* Counts the run, checks it is the item's only one in progress */
+static void count_func(xy_wk_work_t *work)
+{
+    bench_item_t *it = work->arg;
+
+    if (__atomic_add_fetch(&it->inflight, 1, __ATOMIC_ACQ_REL) != 1)
+        s_bad = 1;
+    it->ran_at = xy_os_kernel_get_tick_count();
+    __atomic_fetch_add(&it->runs, 1, __ATOMIC_RELEASE);
+    __atomic_fetch_sub(&it->inflight, 1, __ATOMIC_ACQ_REL);
+}
+
+/* ==================== Cooperative ==================== */
+
+static uint32_t s_order[ITEMS];
+static uint32_t s_ran;
+static xy_wk_queue_t *s_poll_q;
+
+/* Polls: submits itself again every time it runs */
+static void poll_func(xy_wk_work_t *work)
+{
+    bench_item_t *it = work->arg;
+
+    it->runs++;
+    xy_wk_submit(s_poll_q, work);
+}
+
+static void order_func(xy_wk_work_t *work)
+{
+    bench_item_t *it = work->arg;
+
+    it->runs++;
+    s_order[s_ran++] = it->seq;
+}
+
+static int check_cooperative(void)
+{
+    const xy_wk_queue_cfg_t cfg = { "coop", 0, 4, 0, 0 };
+    xy_wk_queue_t q;
+    xy_wk_stats_t st;
+    uint32_t ticks;
+    double t0, t;
+
+    items_init(order_func);
+    s_ran = 0;
+    if (xy_wk_queue_init(&q, &cfg) != XY_WK_OK || q.cfg.workers != 0)
+        return 0;
+
+    for (int i = 0; i < 64; i++) {
+        if (xy_wk_submit(&q, &s_items[i].work) != XY_WK_OK
+            || xy_wk_submit(&q, &s_items[i].work) != XY_WK_BUSY
+            || !xy_wk_is_pending(&s_items[i].work))
+            return 0;
+    }
+    if (xy_wk_next_due(&q) != 0 || xy_wk_run(&q, 10) != 10 || xy_wk_run(&q, 0) != 54)
+        return 0;
+    for (uint32_t i = 0; i < 64; i++) {
+        if (s_order[i] != i || s_items[i].runs != 1 || xy_wk_is_pending(&s_items[i].work))
+            return 0;
+    }
+    xy_wk_get_stats(&q, &st);
+    if (st.submitted != 64 || st.busy != 64 || st.run != 64 || xy_wk_run(&q, 0) != 0
+        || xy_wk_next_due(&q) != XY_OS_WAIT_FOREVER)
+        return 0;
+
+    /* Delayed: not before its tick; canceled: never */
+    if (xy_wk_submit_delayed(&q, &s_items[0].work, 5) != XY_WK_OK
+        || xy_wk_submit_delayed(&q, &s_items[1].work, 5) != XY_WK_OK
+        || xy_wk_cancel(&s_items[1].work) != XY_WK_OK
+        || xy_wk_cancel(&s_items[1].work) != XY_WK_NOT_FOUND)
+        return 0;
+    ticks = xy_wk_next_due(&q);
+    if (ticks == 0 || ticks > 5 || xy_wk_run(&q, 0) != 0)
+        return 0;
+    /* The host tick is coarse: wait for it rather than for 5 ms */
+    for (int ms = 0; ms < 100 && xy_wk_next_due(&q) != 0; ms++)
+        xy_os_delay(1);
+    if (xy_wk_next_due(&q) != 0 || xy_wk_run(&q, 0) != 1 || s_items[0].runs != 2
+        || s_items[1].runs != 1)
+        return 0;
+
+    /* A polling item runs once per call, the caller gets control back */
+    s_poll_q = &q;
+    xy_wk_init(&s_items[3].work, poll_func, &s_items[3]);
+    s_items[3].runs = 0;
+    if (xy_wk_submit(&q, &s_items[3].work) != XY_WK_OK
+        || xy_wk_submit(&q, &s_items[4].work) != XY_WK_OK || xy_wk_run(&q, 0) != 2
+        || xy_wk_run(&q, 0) != 1 || s_items[3].runs != 2
+        || xy_wk_cancel(&s_items[3].work) != XY_WK_OK || xy_wk_run(&q, 0) != 0)
+        return 0;
+
+    /* One item, submitted and run over and over */
+    s_ran = 0;
+    t0    = now_ns();
+    for (int r = 0; r < 100000; r++) {
+        xy_wk_submit(&q, &s_items[2].work);
+        xy_wk_run(&q, 0);
+        s_ran = 0;
+    }
+    t = (now_ns() - t0) / 100000;
+    xy_wk_queue_deinit(&q);
+
+    printf("  64 items in order, 64 second submits refused, delayed and canceled ok,"
+           " polling item returns\n");
+    printf("  submit + run          %6.1f ns per item\n", t);
+    return s_items[2].runs == 100001;
+}
+
+/* ==================== Delayed ==================== */
+
+static int check_delayed(void)
+{
+    xy_wk_queue_t q;
+    xy_wk_stats_t st;
+    uint32_t late = 0;
+
+    items_init(count_func);
+    if (xy_wk_queue_init(&q, NULL) != XY_WK_OK || q.cfg.workers != 1)
+        return 0;
+
+    s_rand = 3;
+    for (int i = 0; i < ITEMS; i++) {
+        uint32_t delay = 1 + rnd() % 30;
+
+        s_items[i].due = xy_os_kernel_get_tick_count() + delay;
+        if (xy_wk_submit_delayed(&q, &s_items[i].work, delay) != XY_WK_OK)
+            return 0;
+    }
+    if (!wait_runs(ITEMS, ITEMS))
+        return 0;
+
+    for (int i = 0; i < ITEMS; i++) {
+        int32_t d = (int32_t)(s_items[i].ran_at - s_items[i].due);
+        if (d < 0)
+            return 0;
+        if ((uint32_t)d > late)
+            late = (uint32_t)d;
+    }
+    xy_wk_get_stats(&q, &st);
+    xy_wk_queue_deinit(&q);
+
+    printf("  %d items, 1-30 ticks   none early, at most %u tick(s) late, "
+           "due to run mean %.1f us, max %.1f us\n",
+           ITEMS, (unsigned)late, st.total_latency / 1e3 / st.run, st.max_latency / 1e3);
+    return s_bad == 0;
+}
+
+/* ==================== Cancel ==================== */
+
+static int check_cancel(void)
+{
+    xy_wk_queue_t q;
+    xy_wk_stats_t st;
+
+    items_init(count_func);
+    if (xy_wk_queue_init(&q, NULL) != XY_WK_OK)
+        return 0;
+
+    s_rand = 5;
+    for (int i = 0; i < ITEMS; i++) {
+        if (xy_wk_submit_delayed(&q, &s_items[i].work, 20 + rnd() % 20) != XY_WK_OK)
+            return 0;
+    }
+    for (int i = 1; i < ITEMS; i += 2) {
+        if (xy_wk_cancel(&s_items[i].work) != XY_WK_OK)
+            return 0;
+    }
+    if (!wait_runs(ITEMS, ITEMS / 2))
+        return 0;
+    xy_os_delay(10);
+
+    for (int i = 0; i < ITEMS; i++) {
+        if (s_items[i].runs != (uint32_t)!(i & 1)
+            || xy_wk_cancel(&s_items[i].work) != XY_WK_NOT_FOUND)
+            return 0;
+    }
+    xy_wk_get_stats(&q, &st);
+    xy_wk_queue_deinit(&q);
+
+    printf("  %d delayed, %u canceled   canceled never ran, the rest once\n", ITEMS,
+           (unsigned)st.canceled);
+    return st.canceled == ITEMS / 2 && st.run == ITEMS / 2;
+}
+
+/* ==================== Throughput ==================== */
+
+#define TP_PRODUCERS 2
+#define TP_SUBMITS   100000 /* Accepted submits per producer */
+
+static xy_wk_queue_t s_tp_q;
+static uint32_t s_tp_busy[TP_PRODUCERS];
+
+static void *tp_producer(void *arg)
+{
+    uintptr_t p      = (uintptr_t)arg;
+    const int per    = ITEMS / TP_PRODUCERS;
+    bench_item_t *my = &s_items[p * per];
+
+    for (uint32_t accepted = 0, k = 0; accepted < TP_SUBMITS; k++) {
+        if (xy_wk_submit(&s_tp_q, &my[k % per].work) == XY_WK_OK) {
+            accepted++;
+        } else {
+            s_tp_busy[p]++;
+            if (k % per == per - 1)
+                sched_yield(); /* The whole set is pending */
+        }
+    }
+    return NULL;
+}
+
+static int bench_throughput(uint8_t workers, uint8_t batch)
+{
+    const xy_wk_queue_cfg_t cfg = { "tp", workers, batch, 0, 0 };
+    pthread_t prod[TP_PRODUCERS];
+    xy_wk_stats_t st;
+    const uint32_t total = TP_PRODUCERS * TP_SUBMITS;
+    double t0, dt;
+
+    items_init(count_func);
+    memset(s_tp_busy, 0, sizeof(s_tp_busy));
+    s_bad = 0;
+    if (xy_wk_queue_init(&s_tp_q, &cfg) != XY_WK_OK || s_tp_q.cfg.workers != workers)
+        return 0;
+
+    t0 = now_ns();
+    for (uintptr_t p = 0; p < TP_PRODUCERS; p++)
+        pthread_create(&prod[p], NULL, tp_producer, (void *)p);
+    for (int p = 0; p < TP_PRODUCERS; p++)
+        pthread_join(prod[p], NULL);
+    if (!wait_runs(ITEMS, total))
+        return 0;
+    dt = now_ns() - t0;
+
+    xy_wk_get_stats(&s_tp_q, &st);
+    xy_wk_queue_deinit(&s_tp_q);
+
+    printf("  %u worker(s), batch %u   %6.0f ns per item, latency mean %6.1f us max %7.1f us, "
+           "%.1f items per lock\n",
+           workers, batch, dt / total, st.total_latency / 1e3 / st.run, st.max_latency / 1e3,
+           (double)st.run / st.batches);
+    return s_bad == 0 && st.run == total && st.submitted == total
+           && st.busy == s_tp_busy[0] + s_tp_busy[1];
+}
+
+/* ==================== Re-arming ==================== */
+
+#define REARM_RUNS 20000
+
+static xy_wk_queue_t s_re_q;
+static uint32_t s_re_accepted;
+static int s_re_stop;
+
+static void rearm_func(xy_wk_work_t *work)
+{
+    bench_item_t *it = work->arg;
+
+    count_func(work);
+    if (__atomic_load_n(&it->runs, __ATOMIC_ACQUIRE) < REARM_RUNS
+        && xy_wk_submit(&s_re_q, work) == XY_WK_OK)
+        __atomic_fetch_add(&s_re_accepted, 1, __ATOMIC_RELAXED);
+}
+
+static void *rearm_hammer(void *arg)
+{
+    (void)arg;
+    while (!__atomic_load_n(&s_re_stop, __ATOMIC_ACQUIRE)) {
+        if (xy_wk_submit(&s_re_q, &s_items[0].work) == XY_WK_OK)
+            __atomic_fetch_add(&s_re_accepted, 1, __ATOMIC_RELAXED);
+        sched_yield();
+    }
+    return NULL;
+}
+
+static int check_rearm(void)
+{
+    const xy_wk_queue_cfg_t cfg = { "rearm", 4, 1, 0, 0 };
+    pthread_t hammer;
+    uint32_t runs;
+
+    items_init(rearm_func);
+    s_bad = 0;
+    s_re_stop = 0;
+    s_re_accepted = 1;
+    if (xy_wk_queue_init(&s_re_q, &cfg) != XY_WK_OK)
+        return 0;
+
+    if (xy_wk_submit(&s_re_q, &s_items[0].work) != XY_WK_OK)
+        return 0;
+    pthread_create(&hammer, NULL, rearm_hammer, NULL);
+    while (__atomic_load_n(&s_items[0].runs, __ATOMIC_ACQUIRE) < REARM_RUNS)
+        xy_os_delay(1);
+    __atomic_store_n(&s_re_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(hammer, NULL);
+    if (!wait_runs(1, __atomic_load_n(&s_re_accepted, __ATOMIC_ACQUIRE)))
+        return 0;
+    runs = s_items[0].runs;
+    xy_wk_queue_deinit(&s_re_q);
+
+    printf("  4 workers   %u runs of one item, never two at once\n", (unsigned)runs);
+    return s_bad == 0;
+}
+
+/* ==================== Interrupt ==================== */
+
+#define IRQ_ITEMS 16
+
+static xy_wk_queue_t s_irq_q;
+static volatile uint32_t s_irq_accepted;
+static volatile uint32_t s_irq_busy;
+static volatile uint32_t s_irq_count;
+
+static void irq_handler(int sig)
+{
+    int saved      = errno;
+    uint32_t n     = s_irq_count++;
+    xy_wk_work_t *w = &s_items[n % IRQ_ITEMS].work;
+    int ret;
+
+    (void)sig;
+    /* Every tenth defers by two ticks */
+    ret = (n % 10 == 9) ? xy_wk_submit_delayed(&s_irq_q, w, 2) : xy_wk_submit(&s_irq_q, w);
+    if (ret == XY_WK_OK)
+        s_irq_accepted++;
+    else
+        s_irq_busy++;
+    errno = saved;
+}
+
+static int check_irq(void)
+{
+    struct itimerval period = { { 0, 100 }, { 0, 100 } }, off = { { 0, 0 }, { 0, 0 } };
+    const xy_wk_queue_cfg_t cfg = { "main", 0, 8, 0, 0 };
+    struct sigaction sa;
+    sigset_t alrm;
+    xy_wk_stats_t st;
+    double t0;
+    uint32_t loops = 0;
+
+    items_init(count_func);
+    s_bad = 0;
+    s_irq_accepted = s_irq_busy = s_irq_count = 0;
+    if (xy_wk_queue_init(&s_irq_q, &cfg) != XY_WK_OK)
+        return 0;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = irq_handler;
+    sa.sa_flags   = SA_RESTART;
+    sigaction(SIGALRM, &sa, NULL);
+    setitimer(ITIMER_REAL, &period, NULL);
+
+    /* The main loop: run what is ready, else wait for the next interrupt */
+    t0 = now_ns();
+    while (now_ns() - t0 < 300e6) {
+        if (xy_wk_run(&s_irq_q, 0) == 0)
+            sched_yield();
+        loops++;
+    }
+
+    setitimer(ITIMER_REAL, &off, NULL);
+    sigemptyset(&alrm);
+    sigaddset(&alrm, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &alrm, NULL);
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGALRM, &sa, NULL);
+    pthread_sigmask(SIG_UNBLOCK, &alrm, NULL);
+
+    /* Delayed work from the last interrupts */
+    for (int ms = 0; ms < 100 && xy_wk_next_due(&s_irq_q) != XY_OS_WAIT_FOREVER; ms++) {
+        xy_os_delay(1);
+        xy_wk_run(&s_irq_q, 0);
+    }
+    xy_wk_get_stats(&s_irq_q, &st);
+    xy_wk_queue_deinit(&s_irq_q);
+
+    printf("  %u interrupts   %u submitted, %u already pending, all ran once, "
+           "latency mean %.1f us\n",
+           (unsigned)s_irq_count, (unsigned)s_irq_accepted, (unsigned)s_irq_busy,
+           st.total_latency / 1e3 / st.run);
+    return s_bad == 0 && s_irq_count > 0 && runs_total(IRQ_ITEMS) == s_irq_accepted
+           && st.run == s_irq_accepted && loops > 0;
+}
+
+int main(void)
+{
+    static const uint8_t workers[] = { 1, 1, 4, 4 };
+    static const uint8_t batch[] = { 1, 8, 1, 8 };
+
+    printf("cooperative\n");
+    if (!check_cooperative())
+        goto fail;
+
+    printf("\ndelayed\n");
+    if (!check_delayed())
+        goto fail;
+
+    printf("\ncancel\n");
+    if (!check_cancel())
+        goto fail;
+
+    printf("\nthroughput, %d producers\n", TP_PRODUCERS);
+    for (size_t i = 0; i < sizeof(workers); i++) {
+        if (!bench_throughput(workers[i], batch[i]))
+            goto fail;
+    }
+
+    printf("\nre-arming\n");
+    if (!check_rearm())
+        goto fail;
+
+    printf("\ninterrupt\n");
+    if (!check_irq())
+        goto fail;
+
+    return 0;
+
+fail:
+    printf("check failed\n");
+    return 1;
+}
@@ -0,0 +1,544 @@
+/**
+ * @file xy_wk.c
+ * @brief XY Workqueue Implementation
+ */
+
+#include "xy_wk.h"
+#include <string.h>
+
+/* ==================== Internal Definitions ==================== */
+
+/*
+ * Submit takes no lock, so that interrupts can defer work at any time: the
+ * item claims its pending bit and is pushed onto the queue's incoming list.
+ * Runners hold the queue lock to move it on and take it, and run it with
+ * the lock released.
+ */
+#if !defined(__GNUC__)
+#error "xy_wk needs the __atomic builtins (GCC, Clang, armclang)"
+#endif
+
+#define WK_LOAD(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define WK_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define WK_CAS(p, e, v)                                                        \
+    __atomic_compare_exchange_n((p), (e), (v), 0, __ATOMIC_ACQ_REL,           \
+                                __ATOMIC_ACQUIRE)
+#define WK_ADD(p, v)   __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+
+/** Item state bits */
+#define WK_PENDING 0x01 /**< Submitted, not yet taken by a runner */
+#define WK_RUNNING 0x02 /**< Taken by a runner, function not yet returned */
+
+static const xy_wk_queue_cfg_t wk_default_cfg = { "wk", 1, 1, 0,
+                                                  XY_OS_PRIORITY_NORMAL };
+
+/* ==================== Internal Helper Functions ==================== */
+
+/**
+ * @brief Whether tick @p due has come at @p now, across wrap-around
+ */
+static inline int wk_due(uint32_t due, uint32_t now)
+{
+    return (int32_t)(due - now) <= 0;
+}
+
+/**
+ * @brief Latency time base
+ */
+static inline uint32_t wk_stamp(void)
+{
+#if XY_WK_LATENCY
+    return xy_os_kernel_get_sys_timer_count();
+#else
+    return 0;
+#endif
+}
+
+static void wk_lock(xy_wk_queue_t *queue)
+{
+    if (queue->lock)
+        xy_os_mutex_acquire(queue->lock, XY_OS_WAIT_FOREVER);
+}
+
+static void wk_unlock(xy_wk_queue_t *queue)
+{
+    if (queue->lock)
+        xy_os_mutex_release(queue->lock);
+}
+
+/**
+ * @brief Append to the ready list; called locked
+ */
+static void wk_ready_append(xy_wk_queue_t *queue, xy_wk_work_t *work)
+{
+    work->next = NULL;
+    if (queue->ready_tail)
+        queue->ready_tail->next = work;
+    else
+        queue->ready = work;
+    queue->ready_tail = work;
+}
+
+/**
+ * @brief Insert into the delayed list after all items due no later;
+ * called locked
+ */
+static void wk_delayed_insert(xy_wk_queue_t *queue, xy_wk_work_t *work)
+{
+    xy_wk_work_t **pp = &queue->delayed;
+
+    while (*pp && wk_due((*pp)->due, work->due))
+        pp = &(*pp)->next;
+    work->next = *pp;
+    *pp        = work;
+}
+
+/**
+ * @brief Move submitted work to the ready and delayed lists, and delayed
+ * work that has fallen due to the ready list; called locked
+ */
+static void wk_collect(xy_wk_queue_t *queue, uint32_t now)
+{
+    xy_wk_work_t *list = __atomic_exchange_n(&queue->incoming, NULL,
+                                             __ATOMIC_SEQ_CST);
+    xy_wk_work_t *fifo = NULL;
+
+    // The incoming list is newest first
+    while (list) {
+        xy_wk_work_t *next = list->next;
+        list->next         = fifo;
+        fifo               = list;
+        list               = next;
+    }
+
+    while (fifo) {
+        xy_wk_work_t *next = fifo->next;
+
+        queue->stats.submitted++;
+        if (fifo->delayed)
+            wk_delayed_insert(queue, fifo);
+        else
+            wk_ready_append(queue, fifo);
+        fifo = next;
+    }
+
+    while (queue->delayed && wk_due(queue->delayed->due, now)) {
+        xy_wk_work_t *work = queue->delayed;
+
+        queue->delayed = work->next;
+        work->delayed  = 0;
+        work->stamp    = wk_stamp();
+        wk_ready_append(queue, work);
+    }
+}
+
+/**
+ * @brief Take up to @p max ready items that are not running elsewhere;
+ * called locked
+ *
+ * An item submitted again while it runs stays on the ready list until that
+ * run returns; the runner running it then takes it on its next pass.
+ */
+static int wk_take(xy_wk_queue_t *queue, xy_wk_work_t **out, int max)
+{
+    xy_wk_work_t **pp  = &queue->ready;
+    xy_wk_work_t *prev = NULL;
+    int n              = 0;
+#if XY_WK_LATENCY
+    uint32_t now = wk_stamp();
+#endif
+
+    while (*pp && n < max) {
+        xy_wk_work_t *work = *pp;
+
+        if (WK_LOAD(&work->state) & WK_RUNNING) {
+            prev = work;
+            pp   = &work->next;
+            continue;
+        }
+
+        *pp = work->next;
+        if (queue->ready_tail == work)
+            queue->ready_tail = prev;
+
+        work->run_count++;
+#if XY_WK_LATENCY
+        work->latency = now - work->stamp;
+        if (work->latency > work->max_latency)
+            work->max_latency = work->latency;
+        if (work->latency > queue->stats.max_latency)
+            queue->stats.max_latency = work->latency;
+        queue->stats.total_latency += work->latency;
+#endif
+        // Only the lock holder changes a pending item's state; once it is
+        // running and not pending, a new submit may rewrite its stamp
+        WK_STORE(&work->state, WK_RUNNING);
+        out[n++] = work;
+    }
+
+    queue->stats.run += (uint32_t)n;
+    if (n > 0)
+        queue->stats.batches++;
+    return n;
+}
+
+/**
+ * @brief Ready items not running elsewhere; called locked
+ */
+static int wk_ready_count(xy_wk_queue_t *queue)
+{
+    int n = 0;
+
+    for (xy_wk_work_t *work = queue->ready; work; work = work->next) {
+        if (!(WK_LOAD(&work->state) & WK_RUNNING))
+            n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Ticks until there is work to take; called locked, after collect
+ */
+static uint32_t wk_next_due(xy_wk_queue_t *queue, uint32_t now)
+{
+    for (xy_wk_work_t *work = queue->ready; work; work = work->next) {
+        if (!(WK_LOAD(&work->state) & WK_RUNNING))
+            return 0;
+    }
+    if (__atomic_load_n(&queue->incoming, __ATOMIC_SEQ_CST))
+        return 0;
+    if (!queue->delayed)
+        return XY_OS_WAIT_FOREVER;
+    if (wk_due(queue->delayed->due, now))
+        return 0;
+    return queue->delayed->due - now;
+}
+
+/**
+ * @brief Remove an item from the ready or delayed list; called locked
+ * @return 1 if it was found
+ */
+static int wk_unlink(xy_wk_queue_t *queue, xy_wk_work_t *work)
+{
+    xy_wk_work_t *prev = NULL;
+
+    for (xy_wk_work_t **pp = &queue->ready; *pp; pp = &(*pp)->next) {
+        if (*pp == work) {
+            *pp = work->next;
+            if (queue->ready_tail == work)
+                queue->ready_tail = prev;
+            return 1;
+        }
+        prev = *pp;
+    }
+
+    for (xy_wk_work_t **pp = &queue->delayed; *pp; pp = &(*pp)->next) {
+        if (*pp == work) {
+            *pp = work->next;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Take one batch under the lock and run it
+ * @return Number of items run
+ */
+static int wk_run_batch(xy_wk_queue_t *queue, int max)
+{
+    xy_wk_work_t *batch[XY_WK_BATCH_MAX];
+    int n;
+
+    wk_lock(queue);
+    wk_collect(queue, xy_os_kernel_get_tick_count());
+    n = wk_take(queue, batch, max);
+    wk_unlock(queue);
+
+    // The item's next link is free to a new submit once it runs, so the
+    // batch is held here
+    for (int i = 0; i < n; i++) {
+        batch[i]->func(batch[i]);
+        __atomic_fetch_and(&batch[i]->state, (uint8_t)~WK_RUNNING,
+                           __ATOMIC_RELEASE);
+    }
+    return n;
+}
+
+/**
+ * @brief Worker thread: run batches, sleep until the next one is due
+ */
+static void wk_worker(void *arg)
+{
+    xy_wk_queue_t *queue = arg;
+
+    while (!WK_LOAD(&queue->stop)) {
+        uint32_t timeout;
+
+        if (wk_run_batch(queue, queue->cfg.batch) > 0)
+            continue;
+
+        // Count as a sleeper before the last look at the queue, so that a
+        // submit either is seen here or sees a sleeper to wake
+        __atomic_fetch_add(&queue->sleepers, 1, __ATOMIC_SEQ_CST);
+        wk_lock(queue);
+        wk_collect(queue, xy_os_kernel_get_tick_count());
+        timeout = wk_next_due(queue, xy_os_kernel_get_tick_count());
+        wk_unlock(queue);
+
+        if (timeout != 0 && !WK_LOAD(&queue->stop))
+            xy_os_semaphore_acquire(queue->wake, timeout);
+        __atomic_fetch_sub(&queue->sleepers, 1, __ATOMIC_SEQ_CST);
+    }
+
+    __atomic_fetch_sub(&queue->alive, 1, __ATOMIC_RELEASE);
+    xy_os_thread_exit();
+}
+
+/**
+ * @brief Claim the pending bit and push onto the incoming list
+ */
+static int wk_submit(xy_wk_queue_t *queue, xy_wk_work_t *work, uint32_t ticks)
+{
+    xy_wk_work_t *head;
+    uint8_t state;
+
+    if (!queue || !work || !work->func)
+        return XY_WK_INVALID_PARAM;
+
+    state = WK_LOAD(&work->state);
+    do {
+        if (state & WK_PENDING) {
+            WK_ADD(&queue->stats.busy, 1);
+            return XY_WK_BUSY;
+        }
+    } while (!WK_CAS(&work->state, &state, (uint8_t)(state | WK_PENDING)));
+
+    // The tick and sys-timer reads and the semaphore release below are the
+    // OSAL calls documented as ISR-safe in xy_os.h
+    WK_STORE(&work->queue, queue);
+    work->delayed = ticks != 0;
+    work->due     = xy_os_kernel_get_tick_count() + ticks;
+    work->stamp   = wk_stamp();
+
+    // Push; runners take the whole list at once, so there is no ABA
+    head = __atomic_load_n(&queue->incoming, __ATOMIC_RELAXED);
+    do {
+        work->next = head;
+    } while (!__atomic_compare_exchange_n(&queue->incoming, &head, work, 0,
+                                          __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+
+    if (__atomic_load_n(&queue->sleepers, __ATOMIC_SEQ_CST))
+        xy_os_semaphore_release(queue->wake);
+    return XY_WK_OK;
+}
+
+/* ==================== Queue API ==================== */
+
+int xy_wk_queue_init(xy_wk_queue_t *queue, const xy_wk_queue_cfg_t *cfg)
+{
+    xy_os_thread_attr_t attr;
+    uint8_t started = 0;
+
+    if (!queue)
+        return XY_WK_INVALID_PARAM;
+    if (!cfg)
+        cfg = &wk_default_cfg;
+    if (cfg->workers > XY_WK_MAX_WORKERS || cfg->batch > XY_WK_BATCH_MAX)
+        return XY_WK_INVALID_PARAM;
+
+    memset(queue, 0, sizeof(xy_wk_queue_t));
+    queue->cfg = *cfg;
+    if (queue->cfg.batch == 0)
+        queue->cfg.batch = 1;
+    if (queue->cfg.workers == 0)
+        return XY_WK_OK;
+
+    // Without a lock and a wake-up there are no workers: the queue is run
+    // cooperatively, as on bare metal
+    queue->lock = xy_os_mutex_new(NULL);
+    queue->wake = xy_os_semaphore_new(queue->cfg.workers, 0, NULL);
+    if (!queue->lock || !queue->wake) {
+        if (queue->lock)
+            xy_os_mutex_delete(queue->lock);
+        if (queue->wake)
+            xy_os_semaphore_delete(queue->wake);
+        queue->lock        = NULL;
+        queue->wake        = NULL;
+        queue->cfg.workers = 0;
+        return XY_WK_OK;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    attr.name       = queue->cfg.name;
+    attr.stack_size = queue->cfg.stack_size ? queue->cfg.stack_size
+                                            : XY_WK_STACK_SIZE;
+    attr.priority   = queue->cfg.priority ? queue->cfg.priority
+                                          : XY_OS_PRIORITY_NORMAL;
+
+    for (uint8_t i = 0; i < queue->cfg.workers; i++) {
+        WK_ADD(&queue->alive, 1);
+        if (!xy_os_thread_new(wk_worker, queue, &attr)) {
+            __atomic_fetch_sub(&queue->alive, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        started++;
+    }
+    queue->cfg.workers = started;
+
+    return XY_WK_OK;
+}
+
+int xy_wk_queue_deinit(xy_wk_queue_t *queue)
+{
+    if (!queue)
+        return XY_WK_INVALID_PARAM;
+
+    WK_STORE(&queue->stop, 1);
+    while (WK_LOAD(&queue->alive)) {
+        xy_os_semaphore_release(queue->wake);
+        xy_os_delay(1);
+    }
+
+    // Drop what is still pending, so it can be submitted again
+    wk_collect(queue, xy_os_kernel_get_tick_count());
+    for (xy_wk_work_t *work = queue->ready; work; work = work->next)
+        __atomic_fetch_and(&work->state, (uint8_t)~WK_PENDING, __ATOMIC_RELEASE);
+    for (xy_wk_work_t *work = queue->delayed; work; work = work->next)
+        __atomic_fetch_and(&work->state, (uint8_t)~WK_PENDING, __ATOMIC_RELEASE);
+
+    if (queue->lock)
+        xy_os_mutex_delete(queue->lock);
+    if (queue->wake)
+        xy_os_semaphore_delete(queue->wake);
+    memset(queue, 0, sizeof(xy_wk_queue_t));
+
+    return XY_WK_OK;
+}
+
+int xy_wk_run(xy_wk_queue_t *queue, int max)
+{
+    int total = 0;
+
+    if (!queue)
+        return 0;
+
+    // "All" is what is ready now: an item that submits itself again, as a
+    // polling item does, waits for the next call instead of keeping the
+    // caller here
+    if (max <= 0) {
+        wk_lock(queue);
+        wk_collect(queue, xy_os_kernel_get_tick_count());
+        max = wk_ready_count(queue);
+        wk_unlock(queue);
+    }
+
+    for (;;) {
+        int chunk = queue->cfg.batch;
+        int n;
+
+        if (max - total < chunk)
+            chunk = max - total;
+        if (chunk == 0)
+            break;
+
+        n = wk_run_batch(queue, chunk);
+        if (n == 0)
+            break;
+        total += n;
+    }
+
+    return total;
+}
+
+uint32_t xy_wk_next_due(xy_wk_queue_t *queue)
+{
+    uint32_t now, ticks;
+
+    if (!queue)
+        return XY_OS_WAIT_FOREVER;
+
+    wk_lock(queue);
+    now = xy_os_kernel_get_tick_count();
+    wk_collect(queue, now);
+    ticks = wk_next_due(queue, now);
+    wk_unlock(queue);
+
+    return ticks;
+}
+
+int xy_wk_get_stats(xy_wk_queue_t *queue, xy_wk_stats_t *stats)
+{
+    if (!queue || !stats)
+        return XY_WK_INVALID_PARAM;
+
+    wk_lock(queue);
+    *stats      = queue->stats;
+    stats->busy = WK_LOAD(&queue->stats.busy);
+    wk_unlock(queue);
+
+    return XY_WK_OK;
+}
+
+/* ==================== Work API ==================== */
+
+void xy_wk_init(xy_wk_work_t *work, xy_wk_func_t func, void *arg)
+{
+    if (!work)
+        return;
+
+    memset(work, 0, sizeof(xy_wk_work_t));
+    work->func = func;
+    work->arg  = arg;
+}
+
+int xy_wk_submit(xy_wk_queue_t *queue, xy_wk_work_t *work)
+{
+    return wk_submit(queue, work, 0);
+}
+
+int xy_wk_submit_delayed(xy_wk_queue_t *queue, xy_wk_work_t *work,
+                         uint32_t ticks)
+{
+    return wk_submit(queue, work, ticks);
+}
+
+int xy_wk_cancel(xy_wk_work_t *work)
+{
+    if (!work)
+        return XY_WK_INVALID_PARAM;
+
+    for (;;) {
+        xy_wk_queue_t *queue = WK_LOAD(&work->queue);
+        uint8_t state        = WK_LOAD(&work->state);
+        int found;
+
+        if (!(state & WK_PENDING))
+            return (state & WK_RUNNING) ? XY_WK_BUSY : XY_WK_NOT_FOUND;
+        if (!queue)
+            return XY_WK_NOT_FOUND;
+
+        wk_lock(queue);
+        wk_collect(queue, xy_os_kernel_get_tick_count());
+        found = wk_unlink(queue, work);
+        if (found) {
+            __atomic_fetch_and(&work->state, (uint8_t)~WK_PENDING,
+                               __ATOMIC_RELEASE);
+            work->delayed = 0;
+            queue->stats.canceled++;
+        }
+        wk_unlock(queue);
+
+        if (found)
+            return XY_WK_OK;
+
+        // Pending but not on the queue yet: its submit has claimed it and
+        // is about to push it, or a runner just took it. Look again.
+        xy_os_thread_yield();
+    }
+}
+
+int xy_wk_is_pending(const xy_wk_work_t *work)
+{
+    return work && (WK_LOAD(&work->state) & WK_PENDING) != 0;
+}
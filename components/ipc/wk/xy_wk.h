@@ -1,4 +1,266 @@
-#ifdef _XY_WK_H_
+/**
+ * @file xy_wk.h
+ * @brief XY Workqueue - deferred work for drivers and interrupts
+ *
+ * A work item is a function and an argument, owned by the caller. It is
+ * submitted to a queue now or after a number of kernel ticks, and runs
+ * later in thread context: on the queue's worker threads, or, where there
+ * are no threads, in whatever loop calls xy_wk_run().
+ *
+ * Features:
+ * - Submit and delayed submit from any thread or interrupt, lock-free
+ * - Cancel of pending and delayed work
+ * - A pool of worker threads per queue through the OSAL, or a cooperative
+ *   runner on bare metal
+ * - Batch drain: several items taken per lock, run back to back
+ * - Queue latency per item and per queue
+ *
+ * An item is pending at most once: submitting it again before it runs
+ * returns XY_WK_BUSY, so an interrupt that fires twice before its work
+ * runs gets one run. An item never runs on two workers at once, and may
+ * submit itself again from its own function.
+ *
+ * @author XY Team
+ * @date 2025
+ */
+
+#ifndef _XY_WK_H_
 #define _XY_WK_H_
 
-#endif
\ No newline at end of file
+#include <stdint.h>
+#include <stddef.h>
+#include "../../kernel/osal/xy_os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Configuration ==================== */
+
+#ifndef XY_WK_MAX_WORKERS
+#define XY_WK_MAX_WORKERS 4 /**< Worker threads per queue, at most */
+#endif
+
+#ifndef XY_WK_BATCH_MAX
+#define XY_WK_BATCH_MAX 8 /**< Items a worker takes per lock, at most */
+#endif
+
+#ifndef XY_WK_STACK_SIZE
+#define XY_WK_STACK_SIZE 1024 /**< Default worker stack, bytes */
+#endif
+
+#ifndef XY_WK_LATENCY
+#define XY_WK_LATENCY 1 /**< Track queue latency (one timer read per item) */
+#endif
+
+/* ==================== Return Codes ==================== */
+
+#define XY_WK_OK            0  /**< Success */
+#define XY_WK_ERROR         -1 /**< General error */
+#define XY_WK_INVALID_PARAM -2 /**< Invalid parameter */
+#define XY_WK_NO_MEMORY     -3 /**< OSAL object could not be created */
+#define XY_WK_BUSY          -4 /**< Already pending, or running */
+#define XY_WK_NOT_FOUND     -5 /**< Not pending */
+
+/* ==================== Data Structures ==================== */
+
+typedef struct xy_wk_work xy_wk_work_t;
+typedef struct xy_wk_queue xy_wk_queue_t;
+
+/**
+ * @brief Work function, called in thread context
+ *
+ * @param work The item; its arg field holds the argument
+ */
+typedef void (*xy_wk_func_t)(xy_wk_work_t *work);
+
+/**
+ * @brief Work item
+ *
+ * Set up with xy_wk_init(); all other fields belong to the queue while the
+ * item is pending or running. The latency fields may be read at any time.
+ * The item must stay valid until it is neither, so a work function must
+ * not free its own item; and it goes to one queue at a time.
+ */
+struct xy_wk_work {
+    xy_wk_work_t *next;     /**< Queue link */
+    xy_wk_func_t func;      /**< Work function */
+    void *arg;              /**< User argument */
+    xy_wk_queue_t *queue;   /**< Queue it was last submitted to */
+    uint32_t due;           /**< Tick at which delayed work becomes ready */
+    uint32_t stamp;         /**< Sys timer count when it became ready */
+    uint32_t latency;       /**< Last wait from ready to run, sys timer counts */
+    uint32_t max_latency;   /**< Longest such wait */
+    uint32_t run_count;     /**< Times run */
+    volatile uint8_t state; /**< Pending and running bits */
+    uint8_t delayed;        /**< Waiting for due, not yet ready */
+};
+
+/**
+ * @brief Queue configuration
+ */
+typedef struct {
+    const char *name;          /**< Worker thread name */
+    uint8_t workers;           /**< Worker threads; 0 = run by xy_wk_run() */
+    uint8_t batch;             /**< Items taken per lock, 1..XY_WK_BATCH_MAX */
+    uint32_t stack_size;       /**< Worker stack; 0 = XY_WK_STACK_SIZE */
+    xy_os_priority_t priority; /**< Worker priority; 0 = NORMAL */
+} xy_wk_queue_cfg_t;
+
+/**
+ * @brief Queue statistics
+ *
+ * Latencies are in sys timer counts, xy_os_kernel_get_sys_timer_freq()
+ * per second: from submit, or for delayed work from when it fell due, to
+ * the start of the work function.
+ */
+typedef struct {
+    uint32_t submitted;     /**< Items accepted */
+    uint32_t busy;          /**< Submits refused, item already pending */
+    uint32_t run;           /**< Items run */
+    uint32_t canceled;      /**< Items canceled while pending */
+    uint32_t batches;       /**< Lock acquisitions that took work */
+    uint32_t max_latency;   /**< Longest queue latency */
+    uint64_t total_latency; /**< Sum of queue latencies, for the mean */
+} xy_wk_stats_t;
+
+/**
+ * @brief Workqueue, owned by the caller
+ *
+ * The incoming list takes submits from any context; the runner moves them
+ * to the ready list or the delayed list, sorted by due tick, under the
+ * queue lock.
+ */
+struct xy_wk_queue {
+    xy_wk_work_t *incoming;       /**< Submitted, newest first, lock-free */
+    xy_wk_work_t *ready;          /**< Ready to run, oldest first */
+    xy_wk_work_t *ready_tail;     /**< Last ready item */
+    xy_wk_work_t *delayed;        /**< Delayed, soonest first */
+    xy_os_mutex_id_t lock;        /**< Between runners; NULL if cooperative */
+    xy_os_semaphore_id_t wake;    /**< Wakes sleeping workers */
+    uint32_t sleepers;            /**< Workers waiting on wake */
+    uint32_t alive;               /**< Worker threads not yet exited */
+    uint8_t stop;                 /**< Workers exit when set */
+    xy_wk_queue_cfg_t cfg;        /**< Configuration as given */
+    xy_wk_stats_t stats;          /**< Statistics */
+};
+
+/* ==================== Queue API ==================== */
+
+/**
+ * @brief Initialize a queue and start its workers
+ *
+ * With cfg->workers of 0 nothing is started and the queue is run by
+ * calling xy_wk_run(). On a port without threads, or short of memory,
+ * fewer workers start, possibly none; queue->cfg.workers says how many.
+ *
+ * @param queue Queue to initialize
+ * @param cfg Configuration; NULL for one worker, one item per lock
+ * @return XY_WK_OK on success, error code otherwise
+ */
+int xy_wk_queue_init(xy_wk_queue_t *queue, const xy_wk_queue_cfg_t *cfg);
+
+/**
+ * @brief Stop the workers and release the queue
+ *
+ * Waits for each worker to finish the work it is running. Work still
+ * pending is dropped and may be submitted elsewhere.
+ *
+ * @param queue Queue
+ * @return XY_WK_OK on success, error code otherwise
+ */
+int xy_wk_queue_deinit(xy_wk_queue_t *queue);
+
+/**
+ * @brief Run ready work in the calling thread
+ *
+ * The cooperative runner for queues without workers: call from the main
+ * loop. On a queue with workers it helps them.
+ *
+ * @param queue Queue
+ * @param max Maximum items to run (0 = all that are ready on entry; work
+ *            submitted meanwhile, even by the items run, waits for the
+ *            next call)
+ * @return Number of items run
+ */
+int xy_wk_run(xy_wk_queue_t *queue, int max);
+
+/**
+ * @brief Ticks until the queue has work to run
+ *
+ * For a cooperative loop: sleep, or program a timer, for this long.
+ *
+ * @param queue Queue
+ * @return 0 if work is ready, ticks until the first delayed item falls
+ *         due, or XY_OS_WAIT_FOREVER if the queue is empty
+ */
+uint32_t xy_wk_next_due(xy_wk_queue_t *queue);
+
+/**
+ * @brief Get queue statistics
+ *
+ * @param queue Queue
+ * @param stats Pointer to store statistics
+ * @return XY_WK_OK on success, error code otherwise
+ */
+int xy_wk_get_stats(xy_wk_queue_t *queue, xy_wk_stats_t *stats);
+
+/* ==================== Work API ==================== */
+
+/**
+ * @brief Set up a work item
+ *
+ * @param work Work item
+ * @param func Work function
+ * @param arg User argument, in work->arg
+ */
+void xy_wk_init(xy_wk_work_t *work, xy_wk_func_t func, void *arg);
+
+/**
+ * @brief Submit work to run as soon as possible
+ *
+ * @note May be called from an ISR
+ *
+ * @param queue Queue
+ * @param work Work item
+ * @return XY_WK_OK on success, XY_WK_BUSY if already pending
+ */
+int xy_wk_submit(xy_wk_queue_t *queue, xy_wk_work_t *work);
+
+/**
+ * @brief Submit work to run after a delay
+ *
+ * @note May be called from an ISR
+ *
+ * @param queue Queue
+ * @param work Work item
+ * @param ticks Kernel ticks to wait; 0 is xy_wk_submit()
+ * @return XY_WK_OK on success, XY_WK_BUSY if already pending
+ */
+int xy_wk_submit_delayed(xy_wk_queue_t *queue, xy_wk_work_t *work,
+                         uint32_t ticks);
+
+/**
+ * @brief Cancel pending or delayed work
+ *
+ * Call from a thread, not an ISR. A run already started is not stopped.
+ *
+ * @param work Work item
+ * @return XY_WK_OK if it was pending and will not run, XY_WK_BUSY if it
+ *         is running and not pending, XY_WK_NOT_FOUND if neither
+ */
+int xy_wk_cancel(xy_wk_work_t *work);
+
+/**
+ * @brief Whether work is pending (submitted, not yet started)
+ *
+ * @param work Work item
+ * @return 1 if pending, 0 otherwise
+ */
+int xy_wk_is_pending(const xy_wk_work_t *work);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XY_WK_H_ */
@@ -0,0 +1,1404 @@
+/**
+ * @file xy_broker_bench.c
+ * @brief Broker message path on the host
+ *
+ * 1. RAM: per-server queues of handles plus the shared pool, against the
+ *    previous layout (a full message with inline payload per queue slot).
+ * 2. Send + process: one message at a time to a server and straight back
+ *    out, at several payload sizes. The previous path (copy into a stack
+ *    message, copy that into the queue, copy it out again) is rebuilt here
+ *    as the baseline; xy_broker_send_msg() copies the payload once;
+ *    xy_broker_msg_alloc() + xy_broker_msg_send() fills it in place.
+ * 3. Fan-out: one publish to 8 subscribers, some of which keep the message
+ *    past their handler. All must see the same buffer, and the pool must be
+ *    empty again once the last one lets go. A subscriber that passes the
+ *    message on, sent and published, must leave the header the others see
+ *    as it was.
+ * 4. Pool: allocate until refused, check the class fallback, free all.
+ * 5. Publish latency against the number of topics and subscribers per
+ *    topic, to a random topic each time. The previous publish (linear topic
+ *    scan, every subscriber slot checked, message built on the stack) is
+ *    rebuilt here as the baseline. Server lookup likewise.
+ * 6. Index churn: servers and topics with random IDs come and go; every
+ *    lookup is checked against a shadow list.
+ * 7. Priority: a CRITICAL alarm behind a queue of LOW sensor data; HIGH
+ *    traffic that never lets up, with LOW messages mixed in, without and
+ *    with aging (wait in dispatches, messages dropped); the three drop
+ *    policies on a flooded server.
+ * 8. Request/response: round trip to a server processed by its own thread,
+ *    which sleeps on its thread flags until a request comes in; one caller
+ *    and several callers with requests outstanding at once (each response
+ *    must answer its own request); a request that times out and its late
+ *    response. xy_os_host.c provides the OSAL on pthreads.
+ * 9. Several senders: threads flooding one server that its own thread
+ *    processes, woken by thread flags; then again with a timer signal
+ *    standing in for an interrupt, sending from inside whichever send it
+ *    cuts into. Each sender's messages must arrive complete and in order.
+ * 10. Wildcard topics: random path topics and '+' / '#' filters, some
+ *    topics created before the filters and some after, some never created;
+ *    every delivery is checked against a level-by-level matcher, again
+ *    after half the filters are removed. Then publish latency to a topic
+ *    reached through exact subscriptions, through filters on its cached
+ *    match list, and through filters when it was never created.
+ *
+ * Every delivered payload is checked.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "xy_broker.h"
+#include "../../../kernel/osal/xy_os.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define ROUNDS      200000
+#define SUBSCRIBERS 8
+#define KEEPERS     3 /* Subscribers that retain the published message */
+
+#define SRV_A (XY_BROKER_SERVER_USER_BASE + 1)
+#define SRV_B (XY_BROKER_SERVER_USER_BASE + 2)
+#define SRV_C (XY_BROKER_SERVER_USER_BASE + 3)
+#define SRV_D (XY_BROKER_SERVER_USER_BASE + 4)
+#define TOPIC (XY_BROKER_TOPIC_USER_BASE + 1)
+#define TOPIC_FWD (XY_BROKER_TOPIC_USER_BASE + 2)
+
+static uint32_t s_rand = 1;
+static uint32_t s_sink;
+static int s_bad;
+
+static uint32_t rnd(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void fill(uint8_t *p, uint16_t len, uint32_t seed)
+{
+    for (uint16_t i = 0; i < len; i++)
+        p[i] = (uint8_t)(seed + i * 7u);
+}
+
+static int verify(const uint8_t *p, uint16_t len, uint32_t seed)
+{
+    /* First, middle and last byte: enough to catch a stale buffer */
+    if (len == 0)
+        return 1;
+    return p[0] == (uint8_t)seed && p[len / 2] == (uint8_t)(seed + (len / 2) * 7u)
+           && p[len - 1] == (uint8_t)(seed + (len - 1) * 7u);
+}
+
+/* ==================== Previous Layout ==================== */
+
+typedef struct {
+    uint16_t msg_id, src_server, dst_server, topic_id;
+    uint8_t priority, flags;
+    uint16_t seq_num;
+    uint32_t timestamp;
+    uint16_t payload_len;
+    uint8_t payload[XY_BROKER_MAX_MSG_SIZE];
+} legacy_msg_t;
+
+typedef struct {
+    uint16_t server_id;
+    xy_broker_msg_handler_t handler;
+    void *user_data;
+    legacy_msg_t msg_queue[XY_BROKER_MSG_QUEUE_SIZE];
+    uint16_t queue_head, queue_tail, queue_count;
+    uint8_t active;
+    uint32_t msg_received, msg_sent;
+} legacy_server_t;
+
+static legacy_server_t s_legacy;
+
+typedef struct {
+    uint16_t server_id;
+    xy_broker_msg_handler_t handler;
+    void *user_data;
+    uint8_t active;
+} legacy_sub_t;
+
+typedef struct {
+    uint16_t topic_id;
+    legacy_sub_t subscribers[XY_BROKER_MAX_SUBSCRIBERS];
+    uint8_t subscriber_count;
+    uint32_t msg_count;
+} legacy_topic_t;
+
+static legacy_topic_t s_legacy_topics[XY_BROKER_MAX_TOPICS];
+static legacy_server_t s_legacy_servers[XY_BROKER_MAX_SERVERS];
+
+static void legacy_send(const void *payload, uint16_t len, uint32_t seq)
+{
+    legacy_msg_t msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_id      = XY_BROKER_MSG_USER_BASE;
+    msg.seq_num     = (uint16_t)seq;
+    msg.payload_len = len;
+    memcpy(msg.payload, payload, len);
+    memcpy(&s_legacy.msg_queue[s_legacy.queue_tail], &msg, sizeof(msg));
+    s_legacy.queue_tail = (s_legacy.queue_tail + 1) % XY_BROKER_MSG_QUEUE_SIZE;
+    s_legacy.queue_count++;
+}
+
+static void legacy_process(uint32_t seed)
+{
+    legacy_msg_t msg;
+
+    memcpy(&msg, &s_legacy.msg_queue[s_legacy.queue_head], sizeof(msg));
+    s_legacy.queue_head = (s_legacy.queue_head + 1) % XY_BROKER_MSG_QUEUE_SIZE;
+    s_legacy.queue_count--;
+    if (!verify(msg.payload, msg.payload_len, seed))
+        s_bad++;
+    s_sink += msg.payload[0];
+}
+
+/* ==================== Send + Process ==================== */
+
+static uint32_t s_expect;
+
+static int check_handler(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)user_data;
+    if (!verify(msg->payload, msg->payload_len, s_expect))
+        s_bad++;
+    s_sink += msg->payload_len;
+    return 0;
+}
+
+static int bench_send(uint16_t len)
+{
+    uint8_t src[XY_BROKER_MAX_MSG_SIZE];
+    double t0, t_legacy, t_copy, t_inplace;
+
+    t0 = now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++) {
+        fill(src, len, r);
+        legacy_send(src, len, r);
+        legacy_process(r);
+    }
+    t_legacy = (now_ns() - t0) / ROUNDS;
+
+    t0 = now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++) {
+        fill(src, len, r);
+        s_expect = r;
+        if (xy_broker_send_msg(SRV_A, SRV_B, XY_BROKER_MSG_USER_BASE, src, len,
+                               XY_BROKER_PRIORITY_NORMAL)
+                != XY_BROKER_OK
+            || xy_broker_process_msgs(SRV_B, 0) != 1)
+            return 0;
+    }
+    t_copy = (now_ns() - t0) / ROUNDS;
+
+    t0 = now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++) {
+        xy_broker_msg_t *msg = xy_broker_msg_alloc(len);
+        if (!msg)
+            return 0;
+        fill(msg->payload, len, r);
+        s_expect = r;
+        if (xy_broker_msg_send(SRV_A, SRV_B, XY_BROKER_MSG_USER_BASE, msg,
+                               XY_BROKER_PRIORITY_NORMAL)
+                != XY_BROKER_OK
+            || xy_broker_process_msgs(SRV_B, 0) != 1)
+            return 0;
+    }
+    t_inplace = (now_ns() - t0) / ROUNDS;
+
+    printf("  %3u B  previous %6.1f ns   send_msg %6.1f ns   in place %6.1f ns\n",
+           len, t_legacy, t_copy, t_inplace);
+    return s_bad == 0;
+}
+
+/* ==================== Fan-out ==================== */
+
+static const xy_broker_msg_t *s_kept[SUBSCRIBERS];
+static const uint8_t *s_seen[SUBSCRIBERS];
+
+static int fanout_handler(const xy_broker_msg_t *msg, void *user_data)
+{
+    int i = (int)(intptr_t)user_data;
+
+    s_seen[i] = msg->payload;
+    if (!verify(msg->payload, msg->payload_len, s_expect))
+        s_bad++;
+    if (i < KEEPERS) {
+        xy_broker_msg_retain(msg);
+        s_kept[i] = msg;
+    }
+    return 0;
+}
+
+static int bench_fanout(void)
+{
+    xy_broker_stats_t st;
+    double t0, t;
+
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        if (xy_broker_subscribe(TOPIC, (uint16_t)(SRV_B + 1 + i), fanout_handler,
+                                (void *)(intptr_t)i)
+            != XY_BROKER_OK)
+            return 0;
+    }
+
+    t0 = now_ns();
+    for (uint32_t r = 0; r < ROUNDS / 4; r++) {
+        xy_broker_msg_t *msg = xy_broker_msg_alloc(200);
+        if (!msg)
+            return 0;
+        fill(msg->payload, 200, r);
+        s_expect = r;
+        if (xy_broker_msg_publish(SRV_A, TOPIC, XY_BROKER_MSG_USER_BASE, msg,
+                                  XY_BROKER_PRIORITY_NORMAL)
+            != XY_BROKER_OK)
+            return 0;
+
+        /* One buffer for everybody, still intact for the keepers */
+        for (int i = 1; i < SUBSCRIBERS; i++) {
+            if (s_seen[i] != s_seen[0])
+                return 0;
+        }
+        xy_broker_get_stats(&st);
+        if (st.pool_in_use != 1)
+            return 0;
+        for (int i = 0; i < KEEPERS; i++) {
+            if (!verify(s_kept[i]->payload, 200, r))
+                return 0;
+            xy_broker_msg_release(s_kept[i]);
+        }
+        xy_broker_get_stats(&st);
+        if (st.pool_in_use != 0)
+            return 0;
+    }
+    t = (now_ns() - t0) / (ROUNDS / 4);
+
+    printf("  200 B to %d subscribers, %d keep it   %.1f ns per publish, one buffer\n",
+           SUBSCRIBERS, KEEPERS, t);
+    return s_bad == 0;
+}
+
+static const xy_broker_msg_t *s_fwd_held;
+static const xy_broker_msg_t *s_fwd_seen[2];
+
+/* Keeps the message and passes it on, to SRV_D and to TOPIC_FWD */
+static int forward_handler(const xy_broker_msg_t *msg, void *user_data)
+{
+    xy_broker_msg_t *fwd = (xy_broker_msg_t *)msg;
+
+    (void)user_data;
+    xy_broker_msg_retain(msg);
+    s_fwd_held = msg;
+    xy_broker_msg_retain(msg);
+    if (xy_broker_msg_send(SRV_B, SRV_D, XY_BROKER_MSG_USER_BASE + 1, fwd,
+                           XY_BROKER_PRIORITY_HIGH)
+        != XY_BROKER_OK)
+        s_bad++;
+    xy_broker_msg_retain(msg);
+    if (xy_broker_msg_publish(SRV_B, TOPIC_FWD, XY_BROKER_MSG_USER_BASE + 2, fwd,
+                              XY_BROKER_PRIORITY_LOW)
+        != XY_BROKER_OK)
+        s_bad++;
+    return 0;
+}
+
+static int forwarded_handler(const xy_broker_msg_t *msg, void *user_data)
+{
+    int i = msg->topic_id == TOPIC_FWD;
+
+    (void)user_data;
+    if (msg->src_server != SRV_B || msg->msg_id != XY_BROKER_MSG_USER_BASE + 1 + i
+        || msg->payload != s_fwd_held->payload || !verify(msg->payload, msg->payload_len, s_expect))
+        s_bad++;
+    s_fwd_seen[i] = msg;
+    return 0;
+}
+
+static int check_forward(void)
+{
+    xy_broker_stats_t st;
+    int ok = 1;
+
+    if (xy_broker_register_server(SRV_D, forwarded_handler, NULL) != XY_BROKER_OK
+        || xy_broker_create_topic(TOPIC_FWD) != XY_BROKER_OK
+        || xy_broker_subscribe(TOPIC_FWD, SRV_D, forwarded_handler, NULL) != XY_BROKER_OK
+        || xy_broker_subscribe(TOPIC_FWD + 1, SRV_B, forward_handler, NULL) != XY_BROKER_OK)
+        return 0;
+
+    for (uint32_t r = 0; r < 1000 && ok; r++) {
+        xy_broker_msg_t *msg = xy_broker_msg_alloc(64);
+        if (!msg)
+            return 0;
+        fill(msg->payload, 64, r);
+        s_expect      = r;
+        s_fwd_seen[0] = s_fwd_seen[1] = NULL;
+        if (xy_broker_msg_publish(SRV_A, TOPIC_FWD + 1, XY_BROKER_MSG_USER_BASE, msg,
+                                  XY_BROKER_PRIORITY_NORMAL)
+                != XY_BROKER_OK
+            || xy_broker_process_msgs(SRV_D, 0) != 1)
+            return 0;
+
+        /* What the subscriber kept is still the publish it received */
+        ok = s_fwd_seen[0] && s_fwd_seen[1] && s_fwd_held->src_server == SRV_A
+             && s_fwd_held->topic_id == TOPIC_FWD + 1 && s_fwd_held->dst_server == 0
+             && s_fwd_held->msg_id == XY_BROKER_MSG_USER_BASE
+             && s_fwd_held->priority == XY_BROKER_PRIORITY_NORMAL;
+        xy_broker_msg_release(s_fwd_held);
+    }
+
+    xy_broker_get_stats(&st);
+    printf("  1000 messages passed on by a subscriber, sent and published: header %s, "
+           "%u in use after\n",
+           ok ? "kept" : "overwritten", (unsigned)st.pool_in_use);
+    xy_broker_unsubscribe(TOPIC_FWD + 1, SRV_B);
+    xy_broker_unregister_server(SRV_D);
+    return ok && s_bad == 0 && st.pool_in_use == 0;
+}
+
+/* ==================== Publish Latency ==================== */
+
+static uint32_t s_calls;
+
+static int count_handler(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)user_data;
+    s_calls++;
+    if (msg->payload_len > 0)
+        s_sink += msg->payload[0];
+    return 0;
+}
+
+static int legacy_publish(uint16_t topic_id, const void *payload, uint16_t len)
+{
+    legacy_topic_t *topic = NULL;
+    xy_broker_msg_t view;
+    legacy_msg_t msg;
+
+    for (int i = 0; i < XY_BROKER_MAX_TOPICS; i++) {
+        if (s_legacy_topics[i].topic_id == topic_id
+            && s_legacy_topics[i].subscriber_count > 0) {
+            topic = &s_legacy_topics[i];
+            break;
+        }
+    }
+    if (!topic)
+        return XY_BROKER_NOT_FOUND;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.topic_id    = topic_id;
+    msg.payload_len = len;
+    memcpy(msg.payload, payload, len);
+    memset(&view, 0, sizeof(view));
+    view.topic_id    = topic_id;
+    view.payload_len = len;
+    view.payload     = msg.payload;
+
+    for (int i = 0; i < XY_BROKER_MAX_SUBSCRIBERS; i++) {
+        if (topic->subscribers[i].active && topic->subscribers[i].handler)
+            topic->subscribers[i].handler(&view, topic->subscribers[i].user_data);
+    }
+    topic->msg_count++;
+    return XY_BROKER_OK;
+}
+
+static int bench_publish(int topics, int subs)
+{
+    static uint16_t ids[XY_BROKER_MAX_TOPICS];
+    uint8_t payload[16] = { 1 };
+    uint32_t expect;
+    double t0, t_legacy, t_now;
+
+    xy_broker_deinit();
+    xy_broker_init();
+    memset(s_legacy_topics, 0, sizeof(s_legacy_topics));
+
+    for (int t = 0; t < topics; t++) {
+        int dup;
+        do {
+            ids[t] = (uint16_t)rnd();
+            dup    = 0;
+            for (int k = 0; k < t; k++)
+                dup |= ids[k] == ids[t];
+        } while (dup);
+
+        s_legacy_topics[t].topic_id = ids[t];
+        for (int k = 0; k < subs; k++) {
+            legacy_sub_t *sub = &s_legacy_topics[t].subscribers[k];
+            sub->server_id    = (uint16_t)(0x200 + k);
+            sub->handler      = count_handler;
+            sub->active       = 1;
+            s_legacy_topics[t].subscriber_count++;
+            if (xy_broker_subscribe(ids[t], (uint16_t)(0x200 + k), count_handler, NULL)
+                != XY_BROKER_OK)
+                return 0;
+        }
+    }
+
+    /* Best of three: the dispatch is short enough for noise to matter */
+    t_legacy = t_now = 1e30;
+    for (int rep = 0; rep < 3; rep++) {
+        double t;
+
+        s_calls = 0;
+        s_rand  = 7;
+        t0      = now_ns();
+        for (uint32_t r = 0; r < ROUNDS; r++) {
+            if (legacy_publish(ids[rnd() % topics], payload, sizeof(payload))
+                != XY_BROKER_OK)
+                return 0;
+        }
+        t        = (now_ns() - t0) / ROUNDS;
+        t_legacy = t < t_legacy ? t : t_legacy;
+        expect   = s_calls;
+
+        s_calls = 0;
+        s_rand  = 7;
+        t0      = now_ns();
+        for (uint32_t r = 0; r < ROUNDS; r++) {
+            if (xy_broker_publish(SRV_A, ids[rnd() % topics], XY_BROKER_MSG_USER_BASE,
+                                  payload, sizeof(payload), XY_BROKER_PRIORITY_NORMAL)
+                != XY_BROKER_OK)
+                return 0;
+        }
+        t     = (now_ns() - t0) / ROUNDS;
+        t_now = t < t_now ? t : t_now;
+        if (s_calls != expect)
+            return 0;
+    }
+
+    printf("  %2d topics x %2d subscribers   previous %6.1f ns   now %6.1f ns   (%.1fx)\n",
+           topics, subs, t_legacy, t_now, t_legacy / t_now);
+    return expect == (uint32_t)subs * ROUNDS;
+}
+
+static int bench_server_lookup(void)
+{
+    static uint16_t ids[XY_BROKER_MAX_SERVERS];
+    uint32_t found = 0;
+    double t0, t_legacy, t_now;
+
+    xy_broker_deinit();
+    xy_broker_init();
+    memset(s_legacy_servers, 0, sizeof(s_legacy_servers));
+    for (int i = 0; i < XY_BROKER_MAX_SERVERS;) {
+        ids[i] = (uint16_t)(1 + rnd() % 0xFFFE);
+        if (xy_broker_register_server(ids[i], count_handler, NULL) != XY_BROKER_OK)
+            continue; /* Duplicate ID, draw again */
+        s_legacy_servers[i].server_id = ids[i];
+        s_legacy_servers[i].active    = 1;
+        i++;
+    }
+
+    s_rand = 9;
+    t0     = now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++) {
+        uint16_t id = ids[rnd() % XY_BROKER_MAX_SERVERS];
+        for (int i = 0; i < XY_BROKER_MAX_SERVERS; i++) {
+            if (s_legacy_servers[i].active && s_legacy_servers[i].server_id == id) {
+                found += s_legacy_servers[i].queue_count + 1;
+                break;
+            }
+        }
+    }
+    t_legacy = (now_ns() - t0) / ROUNDS;
+
+    s_rand = 9;
+    t0     = now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+        found -= (uint32_t)xy_broker_get_pending_count(ids[rnd() % XY_BROKER_MAX_SERVERS]) + 1;
+    t_now = (now_ns() - t0) / ROUNDS;
+
+    printf("  server lookup, %d servers     previous %6.1f ns   now %6.1f ns\n",
+           XY_BROKER_MAX_SERVERS, t_legacy, t_now);
+    return found == 0;
+}
+
+/* ==================== Index Churn ==================== */
+
+static int check_churn(void)
+{
+    uint16_t srv[XY_BROKER_MAX_SERVERS], top[XY_BROKER_MAX_TOPICS];
+    int nsrv = 0, ntop = 0;
+
+    xy_broker_deinit();
+    xy_broker_init();
+
+    for (uint32_t r = 0; r < ROUNDS / 2; r++) {
+        /* Narrow ID range so that probe runs collide and wrap */
+        uint16_t id = (uint16_t)(1 + rnd() % 512);
+        int k, op = (int)(rnd() % 10);
+
+        /* Inserts outweigh removals, so both tables run full most of the time */
+        op = op < 3 ? 0 : op < 5 ? 1 : op < 8 ? 2 : 3;
+
+        if (op == 0) {
+            for (k = 0; k < nsrv && srv[k] != id; k++)
+                ;
+            int ret = xy_broker_register_server(id, count_handler, NULL);
+            if (k < nsrv ? ret != XY_BROKER_ALREADY_EXISTS
+                         : ret != (nsrv < XY_BROKER_MAX_SERVERS ? XY_BROKER_OK
+                                                                : XY_BROKER_NO_MEMORY))
+                return 0;
+            if (k == nsrv && ret == XY_BROKER_OK)
+                srv[nsrv++] = id;
+        } else if (op == 1 && nsrv > 0) {
+            k = (int)(rnd() % nsrv);
+            if (xy_broker_unregister_server(srv[k]) != XY_BROKER_OK)
+                return 0;
+            srv[k] = srv[--nsrv];
+        } else if (op == 2) {
+            for (k = 0; k < ntop && top[k] != id; k++)
+                ;
+            int ret = xy_broker_subscribe(id, SRV_A, count_handler, NULL);
+            if (k < ntop ? ret != XY_BROKER_ALREADY_EXISTS
+                         : ret != (ntop < XY_BROKER_MAX_TOPICS ? XY_BROKER_OK
+                                                               : XY_BROKER_NO_MEMORY))
+                return 0;
+            if (k == ntop && ret == XY_BROKER_OK)
+                top[ntop++] = id;
+        } else if (op == 3 && ntop > 0) {
+            k = (int)(rnd() % ntop);
+            if (xy_broker_unsubscribe(top[k], SRV_A) != XY_BROKER_OK)
+                return 0;
+            top[k] = top[--ntop];
+        }
+
+        /* Everything in the shadow is found, a random other ID is not */
+        for (k = 0; k < nsrv; k++) {
+            if (!xy_broker_is_server_registered(srv[k]))
+                return 0;
+        }
+        for (k = 0; k < ntop; k++) {
+            s_calls = 0;
+            if (xy_broker_publish(SRV_A, top[k], 1, NULL, 0, 0) != XY_BROKER_OK || s_calls != 1)
+                return 0;
+        }
+        id = (uint16_t)(513 + rnd() % 512);
+        if (xy_broker_is_server_registered(id)
+            || xy_broker_publish(SRV_A, id, 1, NULL, 0, 0) != XY_BROKER_NOT_FOUND)
+            return 0;
+    }
+
+    printf("  %d operations on IDs 1..512, %d servers and %d topics left, all lookups agree\n",
+           ROUNDS / 2, nsrv, ntop);
+    return 1;
+}
+
+/* ==================== Priority ==================== */
+
+typedef struct {
+    uint8_t prio;
+    uint32_t seq;      /* Per priority */
+    uint32_t enqueued; /* Dispatch count when sent */
+} prio_payload_t;
+
+static uint32_t s_dispatched;
+static uint32_t s_max_wait[XY_BROKER_PRIORITY_LEVELS];
+static uint32_t s_got[XY_BROKER_PRIORITY_LEVELS];
+static uint32_t s_last_seq[XY_BROKER_PRIORITY_LEVELS];
+static uint8_t s_order[64];
+
+static int prio_handler(const xy_broker_msg_t *msg, void *user_data)
+{
+    const prio_payload_t *p = (const prio_payload_t *)msg->payload;
+    uint32_t wait           = s_dispatched - p->enqueued;
+
+    (void)user_data;
+    if (s_dispatched < sizeof(s_order))
+        s_order[s_dispatched] = p->prio;
+    if (wait > s_max_wait[p->prio])
+        s_max_wait[p->prio] = wait;
+    /* In order within a priority */
+    if (s_got[p->prio] > 0 && p->seq <= s_last_seq[p->prio])
+        s_bad++;
+    s_last_seq[p->prio] = p->seq;
+    s_got[p->prio]++;
+    s_dispatched++;
+    return 0;
+}
+
+static int prio_send(uint8_t prio, uint32_t seq)
+{
+    xy_broker_msg_t *msg = xy_broker_msg_alloc(sizeof(prio_payload_t));
+    prio_payload_t *p;
+
+    if (!msg)
+        return XY_BROKER_NO_MEMORY;
+    p           = (prio_payload_t *)msg->payload;
+    p->prio     = prio;
+    p->seq      = seq;
+    p->enqueued = s_dispatched;
+    return xy_broker_msg_send(SRV_A, SRV_C, XY_BROKER_MSG_USER_BASE, msg, prio);
+}
+
+static void prio_reset(void)
+{
+    xy_broker_clear_queue(SRV_C);
+    s_dispatched = 0;
+    memset(s_max_wait, 0, sizeof(s_max_wait));
+    memset(s_got, 0, sizeof(s_got));
+    memset(s_order, 0xFF, sizeof(s_order));
+}
+
+/* HIGH arrives as fast as it is served, LOW on top: 2.25 offered per 2 served */
+static int prio_load(uint8_t aging, uint32_t *dropped)
+{
+    uint32_t seq[XY_BROKER_PRIORITY_LEVELS] = { 0 };
+    xy_broker_stats_t st0, st1;
+
+    prio_reset();
+    xy_broker_set_aging(SRV_C, aging);
+    xy_broker_get_stats(&st0);
+    for (uint32_t r = 0; r < ROUNDS / 10; r++) {
+        prio_send(XY_BROKER_PRIORITY_HIGH, seq[XY_BROKER_PRIORITY_HIGH]++);
+        prio_send(XY_BROKER_PRIORITY_HIGH, seq[XY_BROKER_PRIORITY_HIGH]++);
+        if (r % 4 == 0)
+            prio_send(XY_BROKER_PRIORITY_LOW, seq[XY_BROKER_PRIORITY_LOW]++);
+        if (xy_broker_process_msgs(SRV_C, 2) != 2)
+            return 0;
+    }
+    xy_broker_get_stats(&st1);
+    *dropped = st1.total_msg_dropped - st0.total_msg_dropped;
+
+    printf("  aging %-3s  HIGH %u sent, %u served, max wait %u   LOW %u sent, %u served,"
+           " max wait %u   %u dropped\n",
+           aging ? "8" : "off", (unsigned)seq[XY_BROKER_PRIORITY_HIGH],
+           (unsigned)s_got[XY_BROKER_PRIORITY_HIGH],
+           (unsigned)s_max_wait[XY_BROKER_PRIORITY_HIGH], (unsigned)seq[XY_BROKER_PRIORITY_LOW],
+           (unsigned)s_got[XY_BROKER_PRIORITY_LOW], (unsigned)s_max_wait[XY_BROKER_PRIORITY_LOW],
+           (unsigned)*dropped);
+    return s_bad == 0;
+}
+
+static int check_priority(void)
+{
+    uint32_t dropped;
+    int n;
+
+    if (xy_broker_register_server(SRV_C, prio_handler, NULL) != XY_BROKER_OK)
+        return 0;
+
+    /* An alarm behind a queue of sensor data */
+    prio_reset();
+    for (n = 0; n < XY_BROKER_PRIO_QUEUE_SIZE; n++) {
+        if (prio_send(XY_BROKER_PRIORITY_LOW, (uint32_t)n) != XY_BROKER_OK)
+            return 0;
+    }
+    prio_send(XY_BROKER_PRIORITY_NORMAL, 0);
+    prio_send(XY_BROKER_PRIORITY_CRITICAL, 0);
+    if (xy_broker_process_msgs(SRV_C, 0) != n + 2 || s_order[0] != XY_BROKER_PRIORITY_CRITICAL
+        || s_order[1] != XY_BROKER_PRIORITY_NORMAL || s_bad)
+        return 0;
+    printf("  CRITICAL sent behind %d LOW + 1 NORMAL: dispatched 1st (FIFO: %dth)\n", n, n + 2);
+
+    /* Sustained HIGH load: strict priority starves LOW, aging bounds it */
+    if (!prio_load(0, &dropped) || s_got[XY_BROKER_PRIORITY_LOW] != 0)
+        return 0;
+    if (!prio_load(8, &dropped) || s_got[XY_BROKER_PRIORITY_LOW] == 0
+        || s_max_wait[XY_BROKER_PRIORITY_LOW] > 9 * XY_BROKER_PRIO_QUEUE_SIZE)
+        return 0;
+    xy_broker_set_aging(SRV_C, 0);
+
+    /* Flood LOW: newest refused by default, oldest dropped on request */
+    for (int policy = XY_BROKER_DROP_NEWEST; policy <= XY_BROKER_DROP_OLDEST; policy++) {
+        prio_reset();
+        xy_broker_set_drop_policy(SRV_C, XY_BROKER_PRIORITY_LOW, (uint8_t)policy);
+        for (n = 0; n < 100; n++)
+            prio_send(XY_BROKER_PRIORITY_LOW, (uint32_t)n);
+        s_got[XY_BROKER_PRIORITY_LOW] = 0;
+        if (xy_broker_process_msgs(SRV_C, 0) != XY_BROKER_PRIO_QUEUE_SIZE)
+            return 0;
+        /* Kept: 0..15 when refusing, 84..99 when dropping the oldest */
+        if (s_last_seq[XY_BROKER_PRIORITY_LOW]
+            != (policy == XY_BROKER_DROP_NEWEST ? XY_BROKER_PRIO_QUEUE_SIZE - 1u : 99u))
+            return 0;
+        printf("  100 LOW into %d slots, %s: kept %u..%u\n", XY_BROKER_PRIO_QUEUE_SIZE,
+               policy == XY_BROKER_DROP_NEWEST ? "DROP_NEWEST" : "DROP_OLDEST",
+               (unsigned)(s_last_seq[XY_BROKER_PRIORITY_LOW] + 1 - XY_BROKER_PRIO_QUEUE_SIZE),
+               (unsigned)s_last_seq[XY_BROKER_PRIORITY_LOW]);
+    }
+    xy_broker_set_drop_policy(SRV_C, XY_BROKER_PRIORITY_LOW, XY_BROKER_DROP_NEWEST);
+
+    /* Server full of LOW and NORMAL: CRITICAL gets in only with DROP_LOWER */
+    prio_reset();
+    for (n = 0; n < XY_BROKER_MSG_QUEUE_SIZE; n++)
+        prio_send((uint8_t)(n % 2), (uint32_t)(n / 2));
+    if (prio_send(XY_BROKER_PRIORITY_CRITICAL, 0) != XY_BROKER_QUEUE_FULL)
+        return 0;
+    xy_broker_set_drop_policy(SRV_C, XY_BROKER_PRIORITY_CRITICAL, XY_BROKER_DROP_LOWER);
+    if (prio_send(XY_BROKER_PRIORITY_CRITICAL, 0) != XY_BROKER_OK
+        || xy_broker_get_pending_count(SRV_C) != XY_BROKER_MSG_QUEUE_SIZE)
+        return 0;
+    xy_broker_process_msgs(SRV_C, 0);
+    printf("  server full (%d), CRITICAL: refused, with DROP_LOWER accepted (LOW %u of %d kept)\n",
+           XY_BROKER_MSG_QUEUE_SIZE, (unsigned)s_got[XY_BROKER_PRIORITY_LOW],
+           XY_BROKER_MSG_QUEUE_SIZE / 2);
+    return s_order[0] == XY_BROKER_PRIORITY_CRITICAL
+           && s_got[XY_BROKER_PRIORITY_LOW] == XY_BROKER_MSG_QUEUE_SIZE / 2 - 1 && s_bad == 0;
+}
+
+/* ==================== Request/Response ==================== */
+
+#define RR_ROUNDS  20000
+#define RR_CALLERS 4
+
+static volatile int s_rr_stop;
+
+static int echo_handler(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)user_data;
+    /* Payload comes back with every byte + 1 */
+    uint8_t out[XY_BROKER_MAX_MSG_SIZE];
+    for (uint16_t i = 0; i < msg->payload_len; i++)
+        out[i] = (uint8_t)(msg->payload[i] + 1);
+    xy_broker_respond(msg, out, msg->payload_len);
+    return 0;
+}
+
+static void *responder(void *arg)
+{
+    uint16_t server = *(const uint16_t *)arg;
+
+    xy_broker_set_wakeup(server, xy_os_thread_get_id(), 1);
+    while (!s_rr_stop) {
+        if (xy_broker_wait_msgs(server, 10) > 0)
+            xy_broker_process_msgs(server, 0);
+    }
+    xy_broker_set_wakeup(server, NULL, 0);
+    return NULL;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* One request with a seeded 16 B payload; 1 if the echo matches */
+static int rr_call(uint16_t src, uint32_t seed)
+{
+    uint8_t req[16];
+    xy_broker_msg_t *resp;
+
+    fill(req, sizeof(req), seed);
+    if (xy_broker_request(src, SRV_B, 1, req, sizeof(req), &resp, 1000) != XY_BROKER_OK)
+        return 0;
+
+    int ok = resp->payload_len == sizeof(req) && (resp->flags & XY_BROKER_FLAG_RESPONSE)
+             && verify(resp->payload, sizeof(req), seed + 1);
+    xy_broker_msg_release(resp);
+    return ok;
+}
+
+static void *caller(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+
+    for (uint32_t i = 0; i < RR_ROUNDS / RR_CALLERS; i++) {
+        if (!rr_call((uint16_t)(SRV_C + 1 + id), id << 24 | i))
+            s_bad++;
+    }
+    return NULL;
+}
+
+static int bench_request(void)
+{
+    static double rtt[RR_ROUNDS];
+    static const uint16_t server = SRV_B;
+    pthread_t thr, callers[RR_CALLERS];
+    xy_broker_stats_t st;
+
+    xy_broker_deinit();
+    xy_broker_init();
+    if (xy_broker_register_server(SRV_B, echo_handler, NULL) != XY_BROKER_OK)
+        return 0;
+
+    s_rr_stop = 0;
+    s_bad     = 0;
+    if (pthread_create(&thr, NULL, responder, (void *)&server) != 0)
+        return 0;
+
+    /* One caller: every request waits for its own round trip */
+    for (int i = 0; i < RR_ROUNDS; i++) {
+        double t0 = now_ns();
+        if (!rr_call(SRV_A, (uint32_t)i))
+            s_bad++;
+        rtt[i] = now_ns() - t0;
+    }
+    qsort(rtt, RR_ROUNDS, sizeof(rtt[0]), cmp_double);
+    printf("  1 caller        median %7.0f ns  p99 %7.0f ns\n", rtt[RR_ROUNDS / 2],
+           rtt[RR_ROUNDS * 99 / 100]);
+
+    /* Several callers, up to RR_CALLERS requests outstanding */
+    double t0 = now_ns();
+    for (uintptr_t c = 0; c < RR_CALLERS; c++)
+        pthread_create(&callers[c], NULL, caller, (void *)c);
+    for (int c = 0; c < RR_CALLERS; c++)
+        pthread_join(callers[c], NULL);
+    double dt = now_ns() - t0;
+    printf("  %d callers       %7.0f ns per request, %.0f requests/s\n", RR_CALLERS,
+           dt / RR_ROUNDS, RR_ROUNDS / (dt / 1e9));
+
+    s_rr_stop = 1;
+    pthread_join(thr, NULL);
+    if (s_bad) {
+        printf("  %d responses wrong or missing\n", s_bad);
+        return 0;
+    }
+
+    /* Nobody processes the server: the request times out, the answer is late */
+    xy_broker_msg_t *resp = NULL;
+    uint8_t req[16];
+    fill(req, sizeof(req), 7);
+    uint32_t tick0 = (uint32_t)(now_ns() / 1e6);
+    if (xy_broker_request(SRV_A, SRV_B, 1, req, sizeof(req), &resp, 20) != XY_BROKER_TIMEOUT
+        || resp != NULL)
+        return 0;
+    uint32_t waited = (uint32_t)(now_ns() / 1e6) - tick0;
+    if (waited < 20 || xy_broker_process_msgs(SRV_B, 0) != 1)
+        return 0;
+
+    xy_broker_get_stats(&st);
+    printf("  timeout 20 ms   waited %u ms, %u late response, %u timeouts\n", (unsigned)waited,
+           (unsigned)st.late_responses, (unsigned)st.request_timeouts);
+    return st.late_responses == 1 && st.request_timeouts == 1 && st.pool_in_use == 0;
+}
+
+/* ==================== Several Senders ==================== */
+
+#define MP_SENDERS 3
+#define MP_MSGS    100000
+#define MP_IRQ     MP_SENDERS /* Sender index of the timer interrupt */
+
+static uint32_t s_mp_next[MP_SENDERS + 1]; /* Next sequence expected */
+static volatile uint32_t s_mp_irq_sent;
+static volatile uint32_t s_mp_irq_refused;
+static volatile int s_mp_done;
+static uint32_t s_mp_waits;
+
+static int mp_handler(const xy_broker_msg_t *msg, void *user_data)
+{
+    uint32_t seq;
+
+    (void)user_data;
+    if (msg->payload_len != 5 || msg->payload[0] > MP_IRQ) {
+        s_bad++;
+        return 0;
+    }
+    memcpy(&seq, msg->payload + 1, sizeof(seq));
+    if (seq != s_mp_next[msg->payload[0]]++)
+        s_bad++;
+    return 0;
+}
+
+/* Payload: sender index, then the sender's own sequence number */
+static int mp_send(uint8_t sender, uint32_t seq)
+{
+    uint8_t p[5];
+
+    p[0] = sender;
+    memcpy(p + 1, &seq, sizeof(seq));
+    return xy_broker_send_msg(SRV_A, SRV_B, XY_BROKER_MSG_USER_BASE, p, sizeof(p),
+                              XY_BROKER_PRIORITY_NORMAL);
+}
+
+static void *mp_sender(void *arg)
+{
+    uint8_t id = (uint8_t)(uintptr_t)arg;
+    sigset_t alrm;
+
+    /* Only the first sender takes the timer signal, as one interrupt line */
+    if (id == 0) {
+        sigemptyset(&alrm);
+        sigaddset(&alrm, SIGALRM);
+        pthread_sigmask(SIG_UNBLOCK, &alrm, NULL);
+    }
+
+    for (uint32_t i = 0; i < MP_MSGS;) {
+        if (mp_send(id, i) == XY_BROKER_OK)
+            i++;
+        else
+            sched_yield(); /* Full: let the consumer catch up */
+    }
+    return NULL;
+}
+
+/* The "interrupt": sends from inside whatever it cut into, cannot wait */
+static void mp_irq(int sig)
+{
+    int saved = errno;
+
+    (void)sig;
+    if (mp_send(MP_IRQ, s_mp_irq_sent) == XY_BROKER_OK)
+        s_mp_irq_sent++;
+    else
+        s_mp_irq_refused++;
+    errno = saved;
+}
+
+static void *mp_consumer(void *arg)
+{
+    int wake = (int)(uintptr_t)arg;
+
+    if (wake)
+        xy_broker_set_wakeup(SRV_B, xy_os_thread_get_id(), 1);
+    for (;;) {
+        int done = s_mp_done; /* Read first: nothing is sent after it is set */
+        if (xy_broker_process_msgs(SRV_B, 0) > 0)
+            continue;
+        if (done)
+            break;
+        if (wake) {
+            xy_broker_wait_msgs(SRV_B, 10);
+            s_mp_waits++;
+        } else {
+            sched_yield();
+        }
+    }
+    if (wake)
+        xy_broker_set_wakeup(SRV_B, NULL, 0);
+    return NULL;
+}
+
+/*
+ * irq = 0: the consumer sleeps on its thread flags.
+ * irq = 1: a 200 us timer signal sends as well. The host thread flags take
+ * a pthread mutex, which a signal handler must not, so the consumer polls;
+ * on an RTOS port setting thread flags is interrupt-safe.
+ */
+static int run_mpsc(int irq)
+{
+    pthread_t senders[MP_SENDERS], consumer;
+    struct itimerval period = { { 0, 200 }, { 0, 200 } }, off = { { 0, 0 }, { 0, 0 } };
+    struct sigaction sa;
+    sigset_t alrm;
+    xy_broker_stats_t st;
+
+    memset(s_mp_next, 0, sizeof(s_mp_next));
+    s_mp_irq_sent = s_mp_irq_refused = 0;
+    s_mp_done = 0;
+    s_mp_waits = 0;
+    s_bad = 0;
+
+    /* Blocked here and in every thread but the first sender */
+    sigemptyset(&alrm);
+    sigaddset(&alrm, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &alrm, NULL);
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = mp_irq;
+    sa.sa_flags   = SA_RESTART;
+    sigaction(SIGALRM, &sa, NULL);
+
+    double t0 = now_ns();
+    if (pthread_create(&consumer, NULL, mp_consumer, (void *)(uintptr_t)!irq) != 0)
+        return 0;
+    for (uintptr_t i = 0; i < MP_SENDERS; i++)
+        pthread_create(&senders[i], NULL, mp_sender, (void *)i);
+    if (irq)
+        setitimer(ITIMER_REAL, &period, NULL);
+    for (int i = 0; i < MP_SENDERS; i++)
+        pthread_join(senders[i], NULL);
+    setitimer(ITIMER_REAL, &off, NULL);
+    s_mp_done = 1;
+    pthread_join(consumer, NULL);
+    double dt = now_ns() - t0;
+
+    /* A signal still pending is dropped with the handler */
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGALRM, &sa, NULL);
+    pthread_sigmask(SIG_UNBLOCK, &alrm, NULL);
+
+    uint32_t total = MP_SENDERS * MP_MSGS + s_mp_irq_sent;
+    if (irq)
+        printf("  %d threads + irq  %7.0f ns per message, irq sent %u (%u refused, queue full)\n",
+               MP_SENDERS, dt / total, (unsigned)s_mp_irq_sent, (unsigned)s_mp_irq_refused);
+    else
+        printf("  %d threads        %7.0f ns per message, %.0f messages/s, consumer waited %u times\n",
+               MP_SENDERS, dt / total, total / (dt / 1e9), (unsigned)s_mp_waits);
+
+    for (int i = 0; i < MP_SENDERS; i++) {
+        if (s_mp_next[i] != MP_MSGS)
+            return 0;
+    }
+    xy_broker_get_stats(&st);
+    return s_mp_next[MP_IRQ] == s_mp_irq_sent && (!irq || s_mp_irq_sent > 0) && s_bad == 0
+           && st.pool_in_use == 0;
+}
+
+static int bench_mpsc(void)
+{
+    xy_broker_deinit();
+    xy_broker_init();
+    if (xy_broker_register_server(SRV_B, mp_handler, NULL) != XY_BROKER_OK)
+        return 0;
+
+    return run_mpsc(0) && run_mpsc(1);
+}
+
+/* ==================== Wildcard Topics ==================== */
+
+#define WILD_TOPICS 48
+#define WILD_SPARE  16 /* Published to, never created */
+
+static uint32_t s_wild_hits[XY_BROKER_MAX_FILTERS + 1]; /* Last: direct */
+
+static int wild_handler(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)msg;
+    s_wild_hits[(uintptr_t)user_data]++;
+    return 0;
+}
+
+/* The filter read the slow way, one level at a time */
+static int wild_ref_match(uint32_t filter, uint16_t topic_id)
+{
+    for (int i = 0; i < XY_BROKER_TOPIC_LEVELS; i++) {
+        uint8_t f = (uint8_t)(filter >> (8 * (3 - i)));
+        uint8_t t = (uint8_t)((topic_id >> (4 * (3 - i))) & 0xF);
+
+        if (f == XY_BROKER_TOPIC_REST)
+            return 1;
+        if (f == XY_BROKER_TOPIC_ANY ? t == 0 : f != t)
+            return 0;
+    }
+    return 1;
+}
+
+/* Path of up to four levels from a small alphabet, so filters hit often */
+static uint16_t wild_topic(void)
+{
+    uint16_t id = 0;
+    int depth   = 1 + (int)(rnd() % 4);
+
+    for (int i = 0; i < depth; i++)
+        id |= (uint16_t)((1 + rnd() % 3) << (4 * (3 - i)));
+    return id;
+}
+
+static uint32_t wild_filter(void)
+{
+    uint32_t filter = 0;
+
+    for (int i = 0; i < XY_BROKER_TOPIC_LEVELS; i++) {
+        uint32_t r = rnd() % 8, level;
+
+        if (r < 4)
+            level = 1 + r % 3;
+        else if (r < 6)
+            level = XY_BROKER_TOPIC_ANY;
+        else if (r < 7)
+            level = XY_BROKER_TOPIC_REST;
+        else
+            break; /* Path ends here */
+        filter |= level << (8 * (3 - i));
+        if (level == XY_BROKER_TOPIC_REST)
+            break;
+    }
+    return filter;
+}
+
+static int wild_check(const uint16_t *ids, const uint32_t *filters, const int *live)
+{
+    uint8_t payload[16] = { 1 };
+
+    for (int t = 0; t < WILD_TOPICS + WILD_SPARE; t++) {
+        uint32_t expect = t < WILD_TOPICS; /* The direct subscriber */
+        int ret;
+
+        memset(s_wild_hits, 0, sizeof(s_wild_hits));
+        ret = xy_broker_publish(SRV_A, ids[t], XY_BROKER_MSG_USER_BASE, payload,
+                                sizeof(payload), XY_BROKER_PRIORITY_NORMAL);
+        for (int f = 0; f < XY_BROKER_MAX_FILTERS; f++) {
+            uint32_t want = live[f] && wild_ref_match(filters[f], ids[t]);
+            if (s_wild_hits[f] != want)
+                return 0;
+            expect += want;
+        }
+        if (s_wild_hits[XY_BROKER_MAX_FILTERS] != (t < WILD_TOPICS))
+            return 0;
+        if (ret != (expect ? XY_BROKER_OK : XY_BROKER_NOT_FOUND))
+            return 0;
+    }
+    return 1;
+}
+
+static int check_wildcard(void)
+{
+    static uint16_t ids[WILD_TOPICS + WILD_SPARE];
+    static uint32_t filters[XY_BROKER_MAX_FILTERS];
+    static int live[XY_BROKER_MAX_FILTERS];
+    int matches = 0;
+
+    xy_broker_deinit();
+    xy_broker_init();
+    s_rand = 21;
+
+    for (int t = 0; t < WILD_TOPICS + WILD_SPARE; t++) {
+        int dup;
+        do {
+            ids[t] = wild_topic();
+            dup    = 0;
+            for (int k = 0; k < t; k++)
+                dup |= ids[k] == ids[t];
+        } while (dup);
+    }
+
+    /* Half the topics exist before the filters, half come after */
+    for (int t = 0; t < WILD_TOPICS / 2; t++) {
+        if (xy_broker_subscribe(ids[t], SRV_B, wild_handler,
+                                (void *)(uintptr_t)XY_BROKER_MAX_FILTERS)
+            != XY_BROKER_OK)
+            return 0;
+    }
+    for (int f = 0; f < XY_BROKER_MAX_FILTERS; f++) {
+        filters[f] = wild_filter();
+        live[f]    = 1;
+        if (xy_broker_subscribe_filter(filters[f], (uint16_t)(0x200 + f), wild_handler,
+                                       (void *)(uintptr_t)f)
+            != XY_BROKER_OK)
+            return 0;
+        for (int t = 0; t < WILD_TOPICS + WILD_SPARE; t++)
+            matches += wild_ref_match(filters[f], ids[t]);
+    }
+    for (int t = WILD_TOPICS / 2; t < WILD_TOPICS; t++) {
+        if (xy_broker_subscribe(ids[t], SRV_B, wild_handler,
+                                (void *)(uintptr_t)XY_BROKER_MAX_FILTERS)
+            != XY_BROKER_OK)
+            return 0;
+    }
+
+    if (xy_broker_subscribe_filter(filters[0], 0x200, wild_handler, NULL)
+            != XY_BROKER_ALREADY_EXISTS
+        || xy_broker_subscribe_filter(filters[0], 0x300, wild_handler, NULL)
+               != XY_BROKER_NO_MEMORY
+        || xy_broker_subscribe_filter(XY_BROKER_FILTER(0x12, 0, 0, 0), 0x300,
+                                      wild_handler, NULL)
+               != XY_BROKER_INVALID_PARAM)
+        return 0;
+
+    if (!wild_check(ids, filters, live))
+        return 0;
+
+    for (int f = 0; f < XY_BROKER_MAX_FILTERS; f += 2) {
+        live[f] = 0;
+        if (xy_broker_unsubscribe_filter(filters[f], (uint16_t)(0x200 + f))
+            != XY_BROKER_OK)
+            return 0;
+    }
+    if (xy_broker_unsubscribe_filter(filters[0], 0x200) != XY_BROKER_NOT_FOUND)
+        return 0;
+    if (!wild_check(ids, filters, live))
+        return 0;
+
+    printf("  %d topics x %d filters, %d matches   ok\n", WILD_TOPICS + WILD_SPARE,
+           XY_BROKER_MAX_FILTERS, matches);
+    return 1;
+}
+
+static double wild_time(uint16_t topic_id)
+{
+    uint8_t payload[16] = { 1 };
+    double t0, best = 1e30;
+
+    for (int rep = 0; rep < 3; rep++) {
+        double t;
+
+        s_calls = 0;
+        t0      = now_ns();
+        for (uint32_t r = 0; r < ROUNDS; r++)
+            xy_broker_publish(SRV_A, topic_id, XY_BROKER_MSG_USER_BASE, payload,
+                              sizeof(payload), XY_BROKER_PRIORITY_NORMAL);
+        t    = (now_ns() - t0) / ROUNDS;
+        best = t < best ? t : best;
+    }
+    return best;
+}
+
+static int bench_wildcard(void)
+{
+    const uint16_t exact = XY_BROKER_TOPIC_PATH(1, 2, 3, 0);
+    const uint16_t wild  = XY_BROKER_TOPIC_PATH(2, 2, 3, 0);
+    const uint16_t loose = XY_BROKER_TOPIC_PATH(2, 2, 4, 0);
+    double t_exact, t_cached, t_scan;
+
+    xy_broker_deinit();
+    xy_broker_init();
+
+    /* Four exact subscribers on one topic; four filters reaching the other
+     * two, among filters that do not, until the table is full */
+    for (int k = 0; k < 4; k++) {
+        if (xy_broker_subscribe(exact, (uint16_t)(0x200 + k), count_handler, NULL)
+            != XY_BROKER_OK)
+            return 0;
+    }
+    if (xy_broker_create_topic(wild) != XY_BROKER_OK
+        || xy_broker_subscribe_filter(XY_BROKER_FILTER(2, 2, XY_BROKER_TOPIC_ANY, 0),
+                                      0x200, count_handler, NULL) != XY_BROKER_OK
+        || xy_broker_subscribe_filter(XY_BROKER_FILTER(2, XY_BROKER_TOPIC_ANY,
+                                                       XY_BROKER_TOPIC_ANY, 0),
+                                      0x200, count_handler, NULL) != XY_BROKER_OK
+        || xy_broker_subscribe_filter(XY_BROKER_FILTER(2, 2, XY_BROKER_TOPIC_REST, 0),
+                                      0x200, count_handler, NULL) != XY_BROKER_OK
+        || xy_broker_subscribe_filter(XY_BROKER_FILTER(2, XY_BROKER_TOPIC_REST, 0, 0),
+                                      0x200, count_handler, NULL) != XY_BROKER_OK)
+        return 0;
+    for (int f = 4; f < XY_BROKER_MAX_FILTERS; f++) {
+        if (xy_broker_subscribe_filter(XY_BROKER_FILTER(1 + f % 15, 4 + f % 7,
+                                                        XY_BROKER_TOPIC_REST, 0),
+                                       (uint16_t)(0x200 + f), count_handler, NULL)
+            != XY_BROKER_OK)
+            return 0;
+    }
+
+    t_exact = wild_time(exact);
+    if (s_calls != 4u * ROUNDS)
+        return 0;
+    t_cached = wild_time(wild);
+    if (s_calls != 4u * ROUNDS)
+        return 0;
+    t_scan = wild_time(loose);
+    if (s_calls != 4u * ROUNDS)
+        return 0;
+
+    printf("  4 receivers, exact subscriptions      %6.1f ns\n", t_exact);
+    printf("  4 receivers, filters on cached list   %6.1f ns\n", t_cached);
+    printf("  4 receivers, filters, topic not created (%d checked) %6.1f ns\n",
+           XY_BROKER_MAX_FILTERS, t_scan);
+    return 1;
+}
+
+/* ==================== Pool ==================== */
+
+static int check_pool(void)
+{
+    static xy_broker_msg_t *held[XY_BROKER_POOL_SMALL_COUNT + XY_BROKER_POOL_MEDIUM_COUNT
+                                 + XY_BROKER_POOL_LARGE_COUNT + 1];
+    uint8_t payload[XY_BROKER_MAX_MSG_SIZE] = { 0 };
+    xy_broker_stats_t st;
+    int n = 0, big = 0;
+
+    /* Small requests spill into the medium and large classes */
+    while ((held[n] = xy_broker_msg_alloc((uint16_t)(1 + rnd() % 16))) != NULL)
+        n++;
+    xy_broker_get_stats(&st);
+    printf("  %d small requests served before refusal (%u refused), %u in use\n", n,
+           (unsigned)st.pool_alloc_failed, (unsigned)st.pool_in_use);
+    if (n != (int)(sizeof(held) / sizeof(held[0])) - 1 || st.pool_alloc_failed != 1
+        || st.pool_in_use != (uint32_t)n)
+        return 0;
+    while (n > 0)
+        xy_broker_msg_release(held[--n]);
+
+    /* Large requests only fit the large class */
+    while ((held[big] = xy_broker_msg_alloc(XY_BROKER_MAX_MSG_SIZE)) != NULL)
+        big++;
+    if (big != XY_BROKER_POOL_LARGE_COUNT)
+        return 0;
+    if (xy_broker_send_msg(SRV_A, SRV_B, XY_BROKER_MSG_USER_BASE, payload,
+                           XY_BROKER_MAX_MSG_SIZE, XY_BROKER_PRIORITY_NORMAL)
+        != XY_BROKER_NO_MEMORY)
+        return 0;
+    while (big > 0)
+        xy_broker_msg_release(held[--big]);
+
+    /* Queued messages go back to the pool when the queue is cleared */
+    for (int i = 0; i < XY_BROKER_PRIO_QUEUE_SIZE; i++) {
+        if (xy_broker_send_msg(SRV_A, SRV_B, XY_BROKER_MSG_USER_BASE, NULL, 8,
+                               XY_BROKER_PRIORITY_NORMAL)
+            != XY_BROKER_OK)
+            return 0;
+    }
+    if (xy_broker_send_msg(SRV_A, SRV_B, XY_BROKER_MSG_USER_BASE, NULL, 8,
+                           XY_BROKER_PRIORITY_NORMAL)
+        != XY_BROKER_QUEUE_FULL)
+        return 0;
+    xy_broker_clear_queue(SRV_B);
+    xy_broker_get_stats(&st);
+    return st.pool_in_use == 0;
+}
+
+int main(void)
+{
+    static const uint16_t sizes[] = { 8, 32, 96, 256 };
+    static const int topics[] = { 4, 16, 64 };
+    static const int subs[] = { 1, 4, 32 };
+
+    printf("RAM\n  previous queues  %zu B for %d servers\n",
+           sizeof(legacy_server_t) * XY_BROKER_MAX_SERVERS, XY_BROKER_MAX_SERVERS);
+    printf("  handle queues    %zu B, pool %d x %d B + %d x %d B + %d x %d B payload\n",
+           sizeof(xy_broker_server_t) * XY_BROKER_MAX_SERVERS, XY_BROKER_POOL_SMALL_COUNT,
+           XY_BROKER_POOL_SMALL_SIZE, XY_BROKER_POOL_MEDIUM_COUNT, XY_BROKER_POOL_MEDIUM_SIZE,
+           XY_BROKER_POOL_LARGE_COUNT, XY_BROKER_MAX_MSG_SIZE);
+
+    xy_broker_init();
+    if (xy_broker_register_server(SRV_A, check_handler, NULL) != XY_BROKER_OK
+        || xy_broker_register_server(SRV_B, check_handler, NULL) != XY_BROKER_OK)
+        goto fail;
+
+    printf("\nsend + process, per message\n");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        if (!bench_send(sizes[i]))
+            goto fail;
+    }
+
+    printf("\nfan-out\n");
+    if (!bench_fanout() || !check_forward())
+        goto fail;
+
+    printf("\npool\n");
+    if (!check_pool())
+        goto fail;
+
+    printf("\npriority\n");
+    if (!check_priority())
+        goto fail;
+
+    printf("\npublish, 16 B payload\n");
+    for (size_t t = 0; t < sizeof(topics) / sizeof(topics[0]); t++) {
+        for (size_t k = 0; k < sizeof(subs) / sizeof(subs[0]); k++) {
+            if (!bench_publish(topics[t], subs[k]))
+                goto fail;
+        }
+    }
+    if (!bench_server_lookup())
+        goto fail;
+
+    printf("\nrequest/response, 16 B payload\n");
+    if (!bench_request())
+        goto fail;
+
+    printf("\nseveral senders, one server\n");
+    if (!bench_mpsc())
+        goto fail;
+
+    printf("\nwildcard topics\n");
+    if (!check_wildcard() || !bench_wildcard())
+        goto fail;
+
+    printf("\nindex churn\n");
+    if (!check_churn())
+        goto fail;
+
+    xy_broker_deinit();
+    printf("\nsink %u\n", (unsigned)s_sink);
+    return 0;
+
+fail:
+    printf("check failed\n");
+    return 1;
+}
@@ -0,0 +1,688 @@
+/**
+ * @file xy_broker_shm_bench.c
+ * @brief Broker shared-memory transport between two processes on the host
+ *
+ * Each scenario starts a child, this program again, that runs its own
+ * broker, attaches to the segment, subscribes and dispatches; the parent
+ * publishes.
+ *
+ * 1. Delivery: 20000 publishes of random sizes to a topic the child
+ *    subscribes to, and messages to a server the child exports. Each must
+ *    arrive once, in order, with its payload intact; a local subscriber of
+ *    the parent must see the very buffer it filled. Every block must be
+ *    back in the pool when the child detaches, and a node left behind by a
+ *    killed child must be reclaimed. The child passes received messages
+ *    back as they are, published and sent: each must come back intact, in
+ *    a copy of its block, while the parent still holds the original.
+ * 2. Latency: ping-pong through two topics, the child answering from its
+ *    handler; both sides sleeping on their futex, and both polling. A Unix
+ *    socketpair carrying the same messages is the baseline.
+ * 3. Throughput: 200000 zero-copy publishes of 64 and 1024 bytes that the
+ *    child reads in place; against the socketpair again.
+ *
+ * xy_os_host.c provides the OSAL on pthreads.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "xy_broker_shm.h"
+#include "../../../kernel/osal/xy_os.h"
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define T_DATA  (XY_BROKER_TOPIC_USER_BASE + 1)
+#define T_PING  (XY_BROKER_TOPIC_USER_BASE + 2)
+#define T_PONG  (XY_BROKER_TOPIC_USER_BASE + 3)
+#define T_STOP  (XY_BROKER_TOPIC_USER_BASE + 4)
+#define T_LOCAL (XY_BROKER_TOPIC_USER_BASE + 5)
+#define T_FWD   (XY_BROKER_TOPIC_USER_BASE + 6)
+#define T_BACK  (XY_BROKER_TOPIC_USER_BASE + 7)
+#define S_CHILD 0x0200 /* Server the child exports */
+#define S_PARENT 0x0201
+
+#define DELIVERY_MSGS 20000
+#define DELIVERY_SENDS 2000
+#define FORWARD_MSGS  1000
+#define PP_ROUNDS     20000
+#define TP_MSGS       200000
+
+enum { MODE_CHECK, MODE_PONG, MODE_COUNT, MODE_DEAF };
+
+/* What the child reports when it stops */
+typedef struct {
+    uint32_t received;
+    uint32_t sends;
+    uint32_t bad;
+    uint32_t sum;
+} child_result_t;
+
+static char s_name[64];
+static uint32_t s_rand = 1;
+
+static uint32_t rnd(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* Payload of message @p seq: the sequence number, then a pattern */
+static void fill(uint8_t *p, uint16_t len, uint32_t seq)
+{
+    memcpy(p, &seq, sizeof(seq));
+    for (uint16_t i = sizeof(seq); i < len; i++)
+        p[i] = (uint8_t)(seq + i);
+}
+
+static int intact(const uint8_t *p, uint16_t len, uint32_t seq)
+{
+    uint32_t got;
+
+    memcpy(&got, p, sizeof(got));
+    if (got != seq)
+        return 0;
+    for (uint16_t i = sizeof(seq); i < len; i++) {
+        if (p[i] != (uint8_t)(seq + i))
+            return 0;
+    }
+    return 1;
+}
+
+/* Read every cache line of a payload, as a consumer parsing it would */
+static uint32_t touch(const uint8_t *p, uint16_t len)
+{
+    uint32_t sum = 0;
+
+    for (uint16_t i = 0; i < len; i += 64)
+        sum += p[i];
+    return sum + p[len - 1];
+}
+
+/* ==================== Child ==================== */
+
+static int s_mode;
+static int s_poll;
+static int s_stop;
+static child_result_t s_res;
+
+static int child_data(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)user_data;
+    if (s_mode == MODE_CHECK) {
+        if (msg->payload_len < 4 || !intact(msg->payload, msg->payload_len, s_res.received))
+            s_res.bad++;
+    } else {
+        s_res.sum += touch(msg->payload, msg->payload_len);
+    }
+    s_res.received++;
+    return 0;
+}
+
+static int child_ping(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)user_data;
+    xy_broker_msg_t *pong = xy_broker_shm_msg_alloc(msg->payload_len);
+
+    if (!pong) {
+        s_res.bad++;
+        return 0;
+    }
+    memcpy(pong->payload, msg->payload, msg->payload_len);
+    if (xy_broker_shm_msg_publish(S_CHILD, T_PONG, 0, pong, XY_BROKER_PRIORITY_NORMAL)
+        != XY_BROKER_OK)
+        s_res.bad++;
+    s_res.received++;
+    return 0;
+}
+
+static int child_stop(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)msg;
+    (void)user_data;
+    s_stop = 1;
+    return 0;
+}
+
+/* Pass the received message on as it is, every other one by send */
+static int child_forward(const xy_broker_msg_t *msg, void *user_data)
+{
+    xy_broker_msg_t *fwd = (xy_broker_msg_t *)msg;
+    int ret;
+
+    (void)user_data;
+    xy_broker_msg_retain(msg);
+    if (s_res.received % 2 == 0)
+        ret = xy_broker_shm_msg_publish(S_CHILD, T_BACK, 9, fwd, XY_BROKER_PRIORITY_NORMAL);
+    else
+        ret = xy_broker_shm_msg_send(S_CHILD, S_PARENT, 9, fwd, XY_BROKER_PRIORITY_NORMAL);
+    if (ret != XY_BROKER_OK)
+        s_res.bad++;
+    s_res.received++;
+    return 0;
+}
+
+static int child_server(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)user_data;
+    if (msg->src_server != S_PARENT || msg->msg_id != 7
+        || !intact(msg->payload, msg->payload_len, s_res.sends))
+        s_res.bad++;
+    s_res.sends++;
+    return 0;
+}
+
+static void child_main(int fd, int mode, int poll)
+{
+    char ready = 1;
+
+    s_mode = mode;
+    s_poll = poll;
+    xy_broker_init();
+    xy_broker_register_server(S_CHILD, child_server, NULL);
+    xy_broker_create_topic(T_DATA);
+    xy_broker_create_topic(T_PING);
+    xy_broker_create_topic(T_STOP);
+    xy_broker_create_topic(T_FWD);
+    xy_broker_subscribe(T_DATA, S_CHILD, child_data, NULL);
+    xy_broker_subscribe(T_PING, S_CHILD, child_ping, NULL);
+    xy_broker_subscribe(T_STOP, S_CHILD, child_stop, NULL);
+    xy_broker_subscribe(T_FWD, S_CHILD, child_forward, NULL);
+
+    if (xy_broker_shm_attach(s_name) < 0 || xy_broker_shm_subscribe(T_DATA) != XY_BROKER_OK
+        || xy_broker_shm_subscribe(T_PING) != XY_BROKER_OK
+        || xy_broker_shm_subscribe(T_STOP) != XY_BROKER_OK
+        || xy_broker_shm_subscribe(T_FWD) != XY_BROKER_OK
+        || xy_broker_shm_export_server(S_CHILD) != XY_BROKER_OK)
+        _exit(2);
+    if (write(fd, &ready, 1) != 1)
+        _exit(2);
+
+    // Never takes its messages, until killed
+    while (mode == MODE_DEAF)
+        pause();
+
+    while (!s_stop) {
+        if (s_poll) {
+            if (xy_broker_shm_dispatch(0) == 0)
+                sched_yield();
+        } else if (xy_broker_shm_wait(1000) > 0) {
+            xy_broker_shm_dispatch(0);
+        }
+        xy_broker_process_msgs(S_CHILD, 0);
+    }
+
+    xy_broker_shm_detach();
+    if (write(fd, &s_res, sizeof(s_res)) != (ssize_t)sizeof(s_res))
+        _exit(2);
+    _exit(0);
+}
+
+/*
+ * Start a child in @p mode; returns its pid once it is subscribed. It runs
+ * this program afresh, as another service would, not a copy of this
+ * process's broker and node.
+ */
+static pid_t child_start(int mode, int poll, int *fd)
+{
+    char arg_mode[16], arg_poll[16], arg_fd[16];
+    int sv[2];
+    char ready;
+    pid_t pid;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        return -1;
+    pid = fork();
+    if (pid == 0) {
+        close(sv[0]);
+        snprintf(arg_mode, sizeof(arg_mode), "%d", mode);
+        snprintf(arg_poll, sizeof(arg_poll), "%d", poll);
+        snprintf(arg_fd, sizeof(arg_fd), "%d", sv[1]);
+        execl("/proc/self/exe", "xy_broker_shm_bench", "child", arg_mode, arg_poll, arg_fd,
+              s_name, (char *)NULL);
+        _exit(2);
+    }
+    close(sv[1]);
+    if (pid < 0 || read(sv[0], &ready, 1) != 1) {
+        close(sv[0]);
+        return -1;
+    }
+    *fd = sv[0];
+    return pid;
+}
+
+/* Stop the child and collect its result */
+static int child_finish(pid_t pid, int fd, child_result_t *res)
+{
+    int status = 0;
+    int ok;
+
+    while (xy_broker_shm_publish(S_PARENT, T_STOP, 0, NULL, 0, 0) != XY_BROKER_OK)
+        sched_yield();
+    ok = read(fd, res, sizeof(*res)) == (ssize_t)sizeof(*res);
+    close(fd);
+    waitpid(pid, &status, 0);
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* Publish a zero-copy message, waiting while the child catches up */
+static uint32_t s_retries;
+
+static void publish_wait(uint16_t topic, uint16_t len, uint32_t seq)
+{
+    for (;;) {
+        xy_broker_msg_t *msg = xy_broker_shm_msg_alloc(len);
+
+        if (msg) {
+            fill(msg->payload, len, seq);
+            if (xy_broker_shm_msg_publish(S_PARENT, topic, 1, msg, XY_BROKER_PRIORITY_NORMAL)
+                == XY_BROKER_OK)
+                return;
+        }
+        s_retries++;
+        sched_yield();
+    }
+}
+
+/* ==================== Delivery ==================== */
+
+static const uint8_t *s_local_filled;
+static uint32_t s_local_same;
+
+static int parent_local(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)user_data;
+    if (msg->payload == s_local_filled)
+        s_local_same++;
+    return 0;
+}
+
+static int check_delivery(void)
+{
+    xy_broker_shm_stats_t st;
+    child_result_t res;
+    uint32_t sent = 0;
+    int fd, ok;
+    pid_t pid = child_start(MODE_CHECK, 0, &fd);
+
+    if (pid < 0)
+        return 0;
+
+    // Random sizes, a server message every tenth
+    s_retries = 0;
+    for (uint32_t seq = 0; seq < DELIVERY_MSGS; seq++) {
+        publish_wait(T_DATA, (uint16_t)(4 + rnd() % (XY_BROKER_SHM_MSG_SIZE - 3)), seq);
+        if (seq % 10 == 0) {
+            xy_broker_msg_t *msg;
+
+            while (!(msg = xy_broker_shm_msg_alloc(64)))
+                sched_yield();
+            fill(msg->payload, 64, sent);
+            while (xy_broker_shm_msg_send(S_PARENT, S_CHILD, 7, msg, 0) != XY_BROKER_OK) {
+                sched_yield();
+                while (!(msg = xy_broker_shm_msg_alloc(64)))
+                    sched_yield();
+                fill(msg->payload, 64, sent);
+            }
+            sent++;
+        }
+    }
+
+    // A local subscriber sees the buffer the publisher filled
+    for (int i = 0; i < 100; i++) {
+        xy_broker_msg_t *msg;
+
+        while (!(msg = xy_broker_shm_msg_alloc(32)))
+            sched_yield();
+        s_local_filled = msg->payload;
+        fill(msg->payload, 32, (uint32_t)i);
+        xy_broker_shm_msg_publish(S_PARENT, T_LOCAL, 1, msg, XY_BROKER_PRIORITY_NORMAL);
+    }
+
+    ok = child_finish(pid, fd, &res);
+    xy_broker_shm_get_stats(&st);
+    printf("  %u publishes and %u server messages, %u retries while the child "
+           "caught up: %u and %u arrived, %u bad\n",
+           DELIVERY_MSGS, (unsigned)sent, (unsigned)s_retries, (unsigned)res.received,
+           (unsigned)res.sends, (unsigned)res.bad);
+    printf("  local subscriber saw the publisher's buffer %u of 100 times, "
+           "%u of %d blocks free after detach\n",
+           (unsigned)s_local_same, (unsigned)st.blocks_free, XY_BROKER_SHM_BLOCKS);
+
+    return ok && res.bad == 0 && res.received == DELIVERY_MSGS && res.sends == sent
+           && s_local_same == 100 && st.blocks_free == XY_BROKER_SHM_BLOCKS;
+}
+
+static int check_reclaim(void)
+{
+    xy_broker_shm_stats_t st;
+    int fd, status;
+    pid_t pid = child_start(MODE_DEAF, 0, &fd);
+
+    if (pid < 0)
+        return 0;
+
+    // Messages the child will never take, then the child dies
+    for (int i = 0; i < 10; i++)
+        publish_wait(T_DATA, 100, (uint32_t)i);
+    kill(pid, SIGKILL);
+    waitpid(pid, &status, 0);
+    close(fd);
+
+    // The next child takes over the node and returns the blocks
+    pid = child_start(MODE_COUNT, 0, &fd);
+    if (pid < 0)
+        return 0;
+    xy_broker_shm_get_stats(&st);
+    printf("  killed child: its node reclaimed, %u of %d blocks free, %u nodes\n",
+           (unsigned)st.blocks_free, XY_BROKER_SHM_BLOCKS, (unsigned)st.nodes);
+
+    child_result_t res;
+    return child_finish(pid, fd, &res) && st.blocks_free == XY_BROKER_SHM_BLOCKS
+           && st.nodes == 2;
+}
+
+static const uint8_t *s_fwd_sent;
+static uint32_t s_fwd_seq;
+static uint32_t s_fwd_back;
+static uint32_t s_fwd_copies;
+static uint32_t s_fwd_bad;
+
+/* Messages the child passed back, published or sent to S_PARENT */
+static int parent_back(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)user_data;
+    if (msg->src_server != S_CHILD || msg->msg_id != 9
+        || !intact(msg->payload, msg->payload_len, s_fwd_seq))
+        s_fwd_bad++;
+    if (msg->payload != s_fwd_sent)
+        s_fwd_copies++;
+    s_fwd_back++;
+    return 0;
+}
+
+static int check_forward(void)
+{
+    xy_broker_shm_stats_t st;
+    child_result_t res;
+    int fd, ok;
+    pid_t pid = child_start(MODE_COUNT, 0, &fd);
+
+    if (pid < 0)
+        return 0;
+
+    for (uint32_t seq = 0; seq < FORWARD_MSGS && s_fwd_bad == 0; seq++) {
+        uint16_t len = (uint16_t)(4 + rnd() % (XY_BROKER_SHM_MSG_SIZE - 3));
+        xy_broker_msg_t *msg;
+
+        while (!(msg = xy_broker_shm_msg_alloc(len)))
+            sched_yield();
+        fill(msg->payload, len, seq);
+
+        // Held here while the child passes it on
+        xy_broker_msg_retain(msg);
+        s_fwd_sent = msg->payload;
+        s_fwd_seq  = seq;
+        if (xy_broker_shm_msg_publish(S_PARENT, T_FWD, 1, msg, XY_BROKER_PRIORITY_NORMAL)
+            != XY_BROKER_OK)
+            s_fwd_bad++;
+        while (s_fwd_back == seq && s_fwd_bad == 0) {
+            if (xy_broker_shm_wait(1000) > 0)
+                xy_broker_shm_dispatch(0);
+            else
+                s_fwd_bad++;
+            xy_broker_process_msgs(S_PARENT, 0);
+        }
+        if (!intact(msg->payload, len, seq))
+            s_fwd_bad++;
+        xy_broker_msg_release(msg);
+    }
+
+    ok = child_finish(pid, fd, &res);
+    xy_broker_shm_get_stats(&st);
+    printf("  %u messages passed back by the child: %u came back, %u in a copy, "
+           "%u bad, %u of %d blocks free\n",
+           FORWARD_MSGS, (unsigned)s_fwd_back, (unsigned)s_fwd_copies,
+           (unsigned)(s_fwd_bad + res.bad), (unsigned)st.blocks_free, XY_BROKER_SHM_BLOCKS);
+
+    return ok && res.bad == 0 && s_fwd_bad == 0 && s_fwd_back == FORWARD_MSGS
+           && s_fwd_copies == FORWARD_MSGS && st.blocks_free == XY_BROKER_SHM_BLOCKS;
+}
+
+/* ==================== Latency ==================== */
+
+static uint32_t s_pong_seq;
+static int s_pong_seen;
+
+static int parent_pong(const xy_broker_msg_t *msg, void *user_data)
+{
+    (void)user_data;
+    memcpy(&s_pong_seq, msg->payload, sizeof(s_pong_seq));
+    s_pong_seen = 1;
+    return 0;
+}
+
+static int bench_pingpong(int poll)
+{
+    child_result_t res;
+    double t0, ns;
+    int fd, bad = 0;
+    pid_t pid = child_start(MODE_PONG, poll, &fd);
+
+    if (pid < 0)
+        return 0;
+
+    t0 = now_ns();
+    for (uint32_t i = 0; i < PP_ROUNDS; i++) {
+        s_pong_seen = 0;
+        publish_wait(T_PING, 64, i);
+        while (!s_pong_seen) {
+            if (poll) {
+                if (xy_broker_shm_dispatch(0) == 0)
+                    sched_yield();
+            } else if (xy_broker_shm_wait(1000) > 0) {
+                xy_broker_shm_dispatch(0);
+            } else {
+                bad = 1;
+                break;
+            }
+        }
+        if (bad || s_pong_seq != i)
+            break;
+    }
+    ns = (now_ns() - t0) / (2.0 * PP_ROUNDS);
+
+    printf("  shm, %-13s %8.2f us one way\n", poll ? "polling" : "futex", ns / 1e3);
+    return child_finish(pid, fd, &res) && !bad && res.bad == 0 && res.received == PP_ROUNDS;
+}
+
+/* The same exchange over a socketpair: 64 bytes each way */
+static int bench_pingpong_socket(void)
+{
+    int sv[2];
+    uint8_t buf[64];
+    double t0, ns;
+    pid_t pid;
+    int status, ok = 1;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        return 0;
+    pid = fork();
+    if (pid == 0) {
+        close(sv[0]);
+        for (int i = 0; i < PP_ROUNDS; i++) {
+            if (read(sv[1], buf, sizeof(buf)) != (ssize_t)sizeof(buf)
+                || write(sv[1], buf, sizeof(buf)) != (ssize_t)sizeof(buf))
+                _exit(1);
+        }
+        _exit(0);
+    }
+    close(sv[1]);
+
+    t0 = now_ns();
+    for (uint32_t i = 0; i < PP_ROUNDS && ok; i++) {
+        fill(buf, sizeof(buf), i);
+        ok = write(sv[0], buf, sizeof(buf)) == (ssize_t)sizeof(buf)
+             && read(sv[0], buf, sizeof(buf)) == (ssize_t)sizeof(buf)
+             && intact(buf, sizeof(buf), i);
+    }
+    ns = (now_ns() - t0) / (2.0 * PP_ROUNDS);
+    close(sv[0]);
+    waitpid(pid, &status, 0);
+
+    printf("  socketpair         %8.2f us one way\n", ns / 1e3);
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* ==================== Throughput ==================== */
+
+static int bench_throughput(uint16_t len)
+{
+    child_result_t res;
+    double t0, s;
+    uint32_t want = 0;
+    int fd, ok;
+    pid_t pid = child_start(MODE_COUNT, 0, &fd);
+
+    if (pid < 0)
+        return 0;
+
+    s_retries = 0;
+    t0        = now_ns();
+    for (uint32_t i = 0; i < TP_MSGS;) {
+        xy_broker_msg_t *msg = xy_broker_shm_msg_alloc(len);
+        uint32_t sum;
+
+        if (!msg) {
+            s_retries++;
+            sched_yield();
+            continue;
+        }
+        // A producer writes its data straight into the block
+        msg->payload[0]       = (uint8_t)i;
+        msg->payload[len - 1] = (uint8_t)(i >> 8);
+        sum                   = touch(msg->payload, len);
+        if (xy_broker_shm_msg_publish(S_PARENT, T_DATA, 1, msg, 0) != XY_BROKER_OK) {
+            s_retries++;
+            sched_yield();
+            continue;
+        }
+        want += sum;
+        i++;
+    }
+    ok = child_finish(pid, fd, &res);
+    s  = (now_ns() - t0) / 1e9;
+
+    printf("  shm, %4u B        %8.2f M msg/s  %7.1f MB/s  (%u retries)\n", (unsigned)len,
+           TP_MSGS / s / 1e6, TP_MSGS * (double)len / s / 1e6, (unsigned)s_retries);
+    return ok && res.received == TP_MSGS && res.sum == want;
+}
+
+static int bench_throughput_socket(uint16_t len)
+{
+    static uint8_t buf[XY_BROKER_SHM_MSG_SIZE];
+    int sv[2];
+    double t0, s;
+    uint32_t sum = 0, want = 0;
+    pid_t pid;
+    int status;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        return 0;
+    pid = fork();
+    if (pid == 0) {
+        close(sv[0]);
+        for (int i = 0; i < TP_MSGS; i++) {
+            size_t got = 0;
+            while (got < len) {
+                ssize_t n = read(sv[1], buf + got, len - got);
+                if (n <= 0)
+                    _exit(1);
+                got += (size_t)n;
+            }
+            sum += touch(buf, len);
+        }
+        _exit(write(sv[1], &sum, sizeof(sum)) == (ssize_t)sizeof(sum) ? 0 : 1);
+    }
+    close(sv[1]);
+
+    memset(buf, 0, sizeof(buf));
+    t0 = now_ns();
+    for (uint32_t i = 0; i < TP_MSGS; i++) {
+        buf[0]       = (uint8_t)i;
+        buf[len - 1] = (uint8_t)(i >> 8);
+        want += touch(buf, len);
+        if (write(sv[0], buf, len) != (ssize_t)len)
+            break;
+    }
+    if (read(sv[0], &sum, sizeof(sum)) != (ssize_t)sizeof(sum))
+        sum = ~want;
+    s = (now_ns() - t0) / 1e9;
+    close(sv[0]);
+    waitpid(pid, &status, 0);
+
+    printf("  socketpair, %4u B %8.2f M msg/s  %7.1f MB/s\n", (unsigned)len,
+           TP_MSGS / s / 1e6, TP_MSGS * (double)len / s / 1e6);
+    return sum == want && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    int ok;
+
+    if (argc == 6 && strcmp(argv[1], "child") == 0) {
+        snprintf(s_name, sizeof(s_name), "%s", argv[5]);
+        child_main(atoi(argv[4]), atoi(argv[2]), atoi(argv[3]));
+    }
+
+    snprintf(s_name, sizeof(s_name), "/xy_broker_bench_%d", (int)getpid());
+    xy_broker_shm_unlink(s_name);
+
+    printf("delivery\n");
+    xy_broker_init();
+    xy_broker_register_server(S_PARENT, parent_back, NULL);
+    xy_broker_create_topic(T_PONG);
+    xy_broker_create_topic(T_LOCAL);
+    xy_broker_create_topic(T_BACK);
+    xy_broker_subscribe(T_PONG, S_PARENT, parent_pong, NULL);
+    xy_broker_subscribe(T_LOCAL, S_PARENT, parent_local, NULL);
+    xy_broker_subscribe(T_BACK, S_PARENT, parent_back, NULL);
+    ok = xy_broker_shm_attach(s_name) >= 0 && xy_broker_shm_subscribe(T_PONG) == XY_BROKER_OK
+         && xy_broker_shm_subscribe(T_BACK) == XY_BROKER_OK
+         && xy_broker_shm_export_server(S_PARENT) == XY_BROKER_OK;
+    ok = ok && check_delivery() && check_reclaim() && check_forward();
+
+    if (ok) {
+        printf("\nlatency, %d round trips of 64 B\n", PP_ROUNDS);
+        ok = bench_pingpong(0) && bench_pingpong(1) && bench_pingpong_socket();
+    }
+
+    if (ok) {
+        printf("\nthroughput, %d messages\n", TP_MSGS);
+        ok = bench_throughput(64) && bench_throughput_socket(64) && bench_throughput(1024)
+             && bench_throughput_socket(1024);
+    }
+
+    xy_broker_shm_detach();
+    xy_broker_shm_unlink(s_name);
+    xy_broker_deinit();
+    if (!ok) {
+        printf("check failed\n");
+        return 1;
+    }
+    return 0;
+}
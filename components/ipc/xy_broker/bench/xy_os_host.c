@@ -0,0 +1,373 @@
+/**
+ * @file xy_os_host.c
+ * @brief The OSAL calls xy_broker, xy_wk and xy_completion use, on POSIX
+ * threads for host builds
+ *
+ * Kernel tick in milliseconds, a nanosecond sys timer, threads, thread
+ * flags, mutexes and counting semaphores with timeouts. Only what the ipc
+ * components need; not a full port.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "../../../kernel/osal/xy_os.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t count;
+    uint32_t max;
+} host_sem_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t flags;
+} host_thread_t;
+
+static pthread_key_t s_thread_key;
+static pthread_once_t s_thread_once = PTHREAD_ONCE_INIT;
+
+/** Flag wait result on timeout, top bit set as on the other ports */
+#define HOST_FLAGS_ERROR_TIMEOUT 0x80000002U
+
+/** Absolute CLOCK_MONOTONIC time @p ms from now */
+static void host_deadline(struct timespec *until, uint32_t ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, until);
+    until->tv_sec += ms / 1000u;
+    until->tv_nsec += (long)(ms % 1000u) * 1000000L;
+    if (until->tv_nsec >= 1000000000L) {
+        until->tv_sec++;
+        until->tv_nsec -= 1000000000L;
+    }
+}
+
+static void host_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t ca;
+
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &ca);
+    pthread_condattr_destroy(&ca);
+}
+
+/* ==================== Kernel ==================== */
+
+uint32_t xy_os_kernel_get_tick_count(void)
+{
+    struct timespec ts;
+
+    /* A kernel tick is a counter read; the coarse clock is the closest
+     * match, in cost and in resolution, where there is one */
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+}
+
+uint32_t xy_os_kernel_get_tick_freq(void)
+{
+    return 1000;
+}
+
+uint32_t xy_os_kernel_get_sys_timer_count(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+uint32_t xy_os_kernel_get_sys_timer_freq(void)
+{
+    return 1000000000u;
+}
+
+xy_os_status_t xy_os_delay(uint32_t ticks)
+{
+    struct timespec ts = { (time_t)(ticks / 1000u), (long)(ticks % 1000u) * 1000000L };
+
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+    return XY_OS_OK;
+}
+
+/* ==================== Thread ==================== */
+
+static void host_thread_free(void *arg)
+{
+    host_thread_t *t = arg;
+
+    pthread_cond_destroy(&t->cond);
+    pthread_mutex_destroy(&t->lock);
+    free(t);
+}
+
+static void host_thread_key_init(void)
+{
+    (void)pthread_key_create(&s_thread_key, host_thread_free);
+}
+
+typedef struct {
+    xy_os_thread_func_t func;
+    void *arg;
+} host_start_t;
+
+static void *host_thread_start(void *arg)
+{
+    host_start_t start = *(host_start_t *)arg;
+
+    free(arg);
+    start.func(start.arg);
+    return NULL;
+}
+
+/* Detached; name, stack and priority are ignored */
+xy_os_thread_id_t xy_os_thread_new(xy_os_thread_func_t func, void *argument,
+                                   const xy_os_thread_attr_t *attr)
+{
+    host_start_t *start;
+    pthread_attr_t pa;
+    pthread_t tid;
+    int err;
+
+    (void)attr;
+    if (!func)
+        return NULL;
+    start = malloc(sizeof(*start));
+    if (!start)
+        return NULL;
+    start->func = func;
+    start->arg  = argument;
+
+    pthread_attr_init(&pa);
+    pthread_attr_setdetachstate(&pa, PTHREAD_CREATE_DETACHED);
+    err = pthread_create(&tid, &pa, host_thread_start, start);
+    pthread_attr_destroy(&pa);
+    if (err != 0) {
+        free(start);
+        return NULL;
+    }
+    /* Not the thread's flags handle; only non-NULL for success */
+    return (xy_os_thread_id_t)start;
+}
+
+void xy_os_thread_exit(void)
+{
+    pthread_exit(NULL);
+}
+
+xy_os_status_t xy_os_thread_yield(void)
+{
+    sched_yield();
+    return XY_OS_OK;
+}
+
+/* Any pthread gets its flags on first use; freed when it exits */
+xy_os_thread_id_t xy_os_thread_get_id(void)
+{
+    host_thread_t *t;
+
+    pthread_once(&s_thread_once, host_thread_key_init);
+    t = pthread_getspecific(s_thread_key);
+    if (!t) {
+        t = malloc(sizeof(*t));
+        if (!t)
+            return NULL;
+        pthread_mutex_init(&t->lock, NULL);
+        host_cond_init(&t->cond);
+        t->flags = 0;
+        pthread_setspecific(s_thread_key, t);
+    }
+    return t;
+}
+
+uint32_t xy_os_thread_flags_set(xy_os_thread_id_t thread_id, uint32_t flags)
+{
+    host_thread_t *t = thread_id;
+    uint32_t ret;
+
+    if (!t)
+        return 0x80000004U;
+
+    pthread_mutex_lock(&t->lock);
+    t->flags |= flags;
+    ret = t->flags;
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    return ret;
+}
+
+uint32_t xy_os_thread_flags_wait(uint32_t flags, uint32_t options,
+                                 uint32_t timeout)
+{
+    host_thread_t *t = xy_os_thread_get_id();
+    struct timespec until;
+    uint32_t ret;
+    int err = 0;
+
+    if (!t)
+        return 0x80000001U;
+    if (timeout != XY_OS_WAIT_FOREVER)
+        host_deadline(&until, timeout);
+
+    pthread_mutex_lock(&t->lock);
+    for (;;) {
+        uint32_t got = t->flags & flags;
+        int done     = (options & XY_OS_FLAGS_WAIT_ALL) ? got == flags : got != 0;
+
+        if (done) {
+            ret = t->flags;
+            if (!(options & XY_OS_FLAGS_NO_CLEAR))
+                t->flags &= ~flags;
+            break;
+        }
+        if (timeout == XY_OS_NO_WAIT || err != 0) {
+            ret = HOST_FLAGS_ERROR_TIMEOUT;
+            break;
+        }
+        if (timeout == XY_OS_WAIT_FOREVER)
+            pthread_cond_wait(&t->cond, &t->lock);
+        else
+            err = pthread_cond_timedwait(&t->cond, &t->lock, &until);
+    }
+    pthread_mutex_unlock(&t->lock);
+    return ret;
+}
+
+/* ==================== Mutex ==================== */
+
+xy_os_mutex_id_t xy_os_mutex_new(const xy_os_mutex_attr_t *attr)
+{
+    pthread_mutex_t *m;
+
+    (void)attr;
+    m = malloc(sizeof(*m));
+    if (m)
+        pthread_mutex_init(m, NULL);
+    return m;
+}
+
+/* Always waits: the ipc components only wait forever on a mutex */
+xy_os_status_t xy_os_mutex_acquire(xy_os_mutex_id_t mutex_id, uint32_t timeout)
+{
+    (void)timeout;
+    if (!mutex_id)
+        return XY_OS_ERROR_PARAMETER;
+    pthread_mutex_lock(mutex_id);
+    return XY_OS_OK;
+}
+
+xy_os_status_t xy_os_mutex_release(xy_os_mutex_id_t mutex_id)
+{
+    if (!mutex_id)
+        return XY_OS_ERROR_PARAMETER;
+    pthread_mutex_unlock(mutex_id);
+    return XY_OS_OK;
+}
+
+xy_os_status_t xy_os_mutex_delete(xy_os_mutex_id_t mutex_id)
+{
+    if (!mutex_id)
+        return XY_OS_ERROR_PARAMETER;
+    pthread_mutex_destroy(mutex_id);
+    free(mutex_id);
+    return XY_OS_OK;
+}
+
+/* ==================== Semaphore ==================== */
+
+xy_os_semaphore_id_t xy_os_semaphore_new(uint32_t max_count,
+                                         uint32_t initial_count,
+                                         const xy_os_semaphore_attr_t *attr)
+{
+    host_sem_t *s;
+
+    (void)attr;
+    if (max_count == 0 || initial_count > max_count)
+        return NULL;
+
+    s = malloc(sizeof(*s));
+    if (!s)
+        return NULL;
+
+    pthread_mutex_init(&s->lock, NULL);
+    host_cond_init(&s->cond);
+    s->count = initial_count;
+    s->max   = max_count;
+    return s;
+}
+
+xy_os_status_t xy_os_semaphore_acquire(xy_os_semaphore_id_t semaphore_id,
+                                       uint32_t timeout)
+{
+    host_sem_t *s = semaphore_id;
+    struct timespec until;
+    int err = 0;
+
+    if (!s)
+        return XY_OS_ERROR_PARAMETER;
+
+    if (timeout != XY_OS_WAIT_FOREVER)
+        host_deadline(&until, timeout);
+
+    pthread_mutex_lock(&s->lock);
+    while (s->count == 0 && err == 0) {
+        if (timeout == XY_OS_NO_WAIT)
+            err = ETIMEDOUT;
+        else if (timeout == XY_OS_WAIT_FOREVER)
+            pthread_cond_wait(&s->cond, &s->lock);
+        else
+            err = pthread_cond_timedwait(&s->cond, &s->lock, &until);
+    }
+    if (s->count > 0) {
+        s->count--;
+        err = 0;
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    if (err == 0)
+        return XY_OS_OK;
+    return timeout == XY_OS_NO_WAIT ? XY_OS_ERROR_RESOURCE : XY_OS_ERROR_TIMEOUT;
+}
+
+xy_os_status_t xy_os_semaphore_release(xy_os_semaphore_id_t semaphore_id)
+{
+    host_sem_t *s = semaphore_id;
+    xy_os_status_t ret = XY_OS_OK;
+
+    if (!s)
+        return XY_OS_ERROR_PARAMETER;
+
+    pthread_mutex_lock(&s->lock);
+    if (s->count < s->max) {
+        s->count++;
+        pthread_cond_signal(&s->cond);
+    } else {
+        ret = XY_OS_ERROR_RESOURCE;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return ret;
+}
+
+xy_os_status_t xy_os_semaphore_delete(xy_os_semaphore_id_t semaphore_id)
+{
+    host_sem_t *s = semaphore_id;
+
+    if (!s)
+        return XY_OS_ERROR_PARAMETER;
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+    return XY_OS_OK;
+}
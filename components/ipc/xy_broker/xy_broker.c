@@ -4,125 +4,1087 @@
  */
 
 #include "xy_broker.h"
+#include "../../kernel/osal/xy_os.h"
 #include <string.h>
 
 /* ==================== Internal Data Structures ==================== */
 
+/*
+ * Messaging takes no lock, so that threads and interrupts can send at any
+ * time: queues are sequence-numbered rings, the pool keeps tagged free
+ * lists, and references, pending requests and statistics are atomics.
+ */
+#if !defined(__GNUC__)
+#error "xy_broker needs the __atomic builtins (GCC, Clang, armclang)"
+#endif
+
+#define BROKER_LOAD(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define BROKER_STORE(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define BROKER_CAS(p, e, v)                                                    \
+    __atomic_compare_exchange_n((p), (e), (v), 0, __ATOMIC_ACQ_REL,           \
+                                __ATOMIC_ACQUIRE)
+#define BROKER_ADD(p, v)    __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define BROKER_SUB(p, v)    __atomic_fetch_sub((p), (v), __ATOMIC_RELAXED)
+#define BROKER_COUNT(field) BROKER_ADD(&g_broker.stats.field, 1)
+
+/* Counters on every message, only with XY_BROKER_STATS */
+#if XY_BROKER_STATS
+#define BROKER_COUNT_MSG(field, v) BROKER_ADD(&g_broker.stats.field, (v))
+#else
+#define BROKER_COUNT_MSG(field, v) ((void)0)
+#endif
+
+/**
+ * @brief Pool buffer: header, then the payload bytes
+ *
+ * The message comes first so that a message pointer is also a buffer
+ * pointer.
+ */
+typedef struct broker_buf {
+    xy_broker_msg_t msg; /**< Message handed out to users */
+    uint16_t next;       /**< Free list link, block index + 1 */
+    uint16_t refcnt;     /**< References held */
+} broker_buf_t;
+
+/** Storage block of one pool class; the union keeps the header aligned */
+#define BROKER_POOL_BLOCK(size)                                                \
+    union {                                                                    \
+        broker_buf_t hdr;                                                      \
+        uint8_t raw[sizeof(broker_buf_t) + (size)];                            \
+    }
+
+/**
+ * @brief Where a wrapped message keeps its free hook: its own payload
+ * bytes, unused since msg.payload points elsewhere
+ */
+typedef struct {
+    xy_broker_payload_free_t free_fn;
+    void *ctx;
+} broker_wrap_t;
+
+#if XY_BROKER_POOL_SMALL_SIZE < 16
+#error "XY_BROKER_POOL_SMALL_SIZE: at least 16, wrapped messages use it"
+#endif
+
+typedef BROKER_POOL_BLOCK(XY_BROKER_POOL_SMALL_SIZE) broker_small_t;
+typedef BROKER_POOL_BLOCK(XY_BROKER_POOL_MEDIUM_SIZE) broker_medium_t;
+typedef BROKER_POOL_BLOCK(XY_BROKER_MAX_MSG_SIZE) broker_large_t;
+
+#define BROKER_POOL_CLASSES 3
+
+/**
+ * @brief One size class of the message pool
+ *
+ * The free list head holds the first block's index + 1 in the low half
+ * and a tag in the high half, bumped on every change so that a stale
+ * compare-and-swap fails.
+ */
+typedef struct {
+    uint8_t *base;   /**< First block */
+    uint16_t stride; /**< Bytes per block */
+    uint16_t size;   /**< Payload bytes per block */
+    uint16_t count;  /**< Number of blocks */
+    uint32_t free;   /**< Free list head: tag << 16 | (index + 1) */
+} broker_pool_class_t;
+
+/**
+ * @brief ID index entry; slot is the array index plus one, 0 when unused
+ */
+typedef struct {
+    uint16_t id;
+    uint16_t slot;
+} broker_index_entry_t;
+
+/** Request slot phases, in the low half of broker_pending_t.state */
+#define BROKER_REQ_FREE       0
+#define BROKER_REQ_WAITING    1 /**< Caller waits for the response */
+#define BROKER_REQ_DELIVERING 2 /**< A responder is handing it over */
+#define BROKER_REQ_DONE       3 /**< Response is in place */
+
+#define BROKER_REQ_STATE(corr_id, phase) (((uint32_t)(corr_id) << 16) | (phase))
+
+/**
+ * @brief Request waiting for its response
+ *
+ * Caller and responder move the slot through its phases by
+ * compare-and-swap; whoever leaves WAITING first decides between a
+ * response and a timeout.
+ */
+typedef struct {
+    uint32_t state;            /**< corr_id << 16 | BROKER_REQ_xxx */
+    xy_broker_msg_t *response; /**< Response reference for the caller */
+    xy_os_semaphore_id_t sem;  /**< Completion, NULL on ports without one */
+} broker_pending_t;
+
+#if XY_BROKER_PRIORITY_LEVELS < 1 || XY_BROKER_PRIORITY_LEVELS > 8
+#error "XY_BROKER_PRIORITY_LEVELS: 1 to 8 (one ready bit per level)"
+#endif
+
+#if (XY_BROKER_PRIO_QUEUE_SIZE & (XY_BROKER_PRIO_QUEUE_SIZE - 1)) != 0
+#error "XY_BROKER_PRIO_QUEUE_SIZE: power of two"
+#endif
+
+#if (XY_BROKER_SERVER_INDEX_SIZE & (XY_BROKER_SERVER_INDEX_SIZE - 1)) != 0    \
+    || XY_BROKER_SERVER_INDEX_SIZE < 2 * XY_BROKER_MAX_SERVERS
+#error "XY_BROKER_SERVER_INDEX_SIZE: power of two, >= 2 * MAX_SERVERS"
+#endif
+
+#if (XY_BROKER_TOPIC_INDEX_SIZE & (XY_BROKER_TOPIC_INDEX_SIZE - 1)) != 0      \
+    || XY_BROKER_TOPIC_INDEX_SIZE < 2 * XY_BROKER_MAX_TOPICS
+#error "XY_BROKER_TOPIC_INDEX_SIZE: power of two, >= 2 * MAX_TOPICS"
+#endif
+
 static struct {
     xy_broker_server_t servers[XY_BROKER_MAX_SERVERS];
     xy_broker_topic_t topics[XY_BROKER_MAX_TOPICS];
+    broker_index_entry_t server_index[XY_BROKER_SERVER_INDEX_SIZE];
+    broker_index_entry_t topic_index[XY_BROKER_TOPIC_INDEX_SIZE];
+    xy_broker_filter_t filters[XY_BROKER_MAX_FILTERS];
+    uint32_t filter_map[XY_BROKER_FILTER_WORDS]; /**< Bit set per filter in use */
     xy_broker_stats_t stats;
     uint16_t seq_counter;
+    uint16_t corr_counter;
     uint8_t initialized;
+    broker_pending_t pending[XY_BROKER_MAX_PENDING];
+    broker_pool_class_t pool[BROKER_POOL_CLASSES];
+    broker_small_t pool_small[XY_BROKER_POOL_SMALL_COUNT];
+    broker_medium_t pool_medium[XY_BROKER_POOL_MEDIUM_COUNT];
+    broker_large_t pool_large[XY_BROKER_POOL_LARGE_COUNT];
 } g_broker;
 
-/* ==================== Internal Functions ==================== */
+/* ==================== Internal Functions ==================== */
+
+/**
+ * @brief Get timestamp in milliseconds from the OS tick
+ */
+static uint32_t broker_get_timestamp(void)
+{
+    uint32_t tick = xy_os_kernel_get_tick_count();
+    uint32_t freq = xy_os_kernel_get_tick_freq();
+
+    if (freq == 0 || freq == 1000)
+        return tick;
+    return (uint32_t)((uint64_t)tick * 1000u / freq);
+}
+
+/**
+ * @brief Convert a timeout in milliseconds to OS ticks, rounding up
+ */
+static uint32_t broker_ms_to_ticks(uint32_t ms)
+{
+    uint32_t freq = xy_os_kernel_get_tick_freq();
+
+    if (ms == XY_OS_WAIT_FOREVER || freq == 0 || freq == 1000)
+        return ms;
+
+    uint64_t ticks = ((uint64_t)ms * freq + 999u) / 1000u;
+    return ticks < XY_OS_WAIT_FOREVER ? (uint32_t)ticks
+                                      : XY_OS_WAIT_FOREVER - 1;
+}
+
+/**
+ * @brief Block of a pool class by index
+ */
+static broker_buf_t *broker_pool_block(const broker_pool_class_t *cls, int i)
+{
+    return (broker_buf_t *)(void *)(cls->base + i * cls->stride);
+}
+
+/**
+ * @brief Set up one pool class and thread its free list
+ */
+static void broker_pool_class_init(broker_pool_class_t *cls, void *base,
+                                   uint16_t stride, uint16_t size,
+                                   uint16_t count)
+{
+    cls->base   = (uint8_t *)base;
+    cls->stride = stride;
+    cls->size   = size;
+    cls->count  = count;
+    cls->free   = 0;
+
+    for (int i = count - 1; i >= 0; i--) {
+        broker_pool_block(cls, i)->next = (uint16_t)cls->free;
+        cls->free                       = (uint32_t)(i + 1);
+    }
+}
+
+/**
+ * @brief Build the free lists of all pool classes
+ */
+static void broker_pool_init(void)
+{
+    broker_pool_class_init(&g_broker.pool[0], g_broker.pool_small,
+                           sizeof(broker_small_t), XY_BROKER_POOL_SMALL_SIZE,
+                           XY_BROKER_POOL_SMALL_COUNT);
+    broker_pool_class_init(&g_broker.pool[1], g_broker.pool_medium,
+                           sizeof(broker_medium_t), XY_BROKER_POOL_MEDIUM_SIZE,
+                           XY_BROKER_POOL_MEDIUM_COUNT);
+    broker_pool_class_init(&g_broker.pool[2], g_broker.pool_large,
+                           sizeof(broker_large_t), XY_BROKER_MAX_MSG_SIZE,
+                           XY_BROKER_POOL_LARGE_COUNT);
+}
+
+/**
+ * @brief Find the pool class a buffer belongs to
+ */
+static broker_pool_class_t *broker_pool_class_of(const broker_buf_t *buf)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+
+    for (int i = 0; i < BROKER_POOL_CLASSES; i++) {
+        broker_pool_class_t *cls = &g_broker.pool[i];
+        if (p >= cls->base && p < cls->base + cls->count * cls->stride) {
+            return cls;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Pop a block off a class free list
+ */
+static broker_buf_t *broker_pool_pop(broker_pool_class_t *cls)
+{
+    uint32_t head = BROKER_LOAD(&cls->free);
+
+    for (;;) {
+        uint16_t first = (uint16_t)head;
+        if (first == 0)
+            return NULL;
+
+        // A stale next read here is caught by the tag
+        broker_buf_t *buf = broker_pool_block(cls, first - 1);
+        uint16_t next     = __atomic_load_n(&buf->next, __ATOMIC_RELAXED);
+        uint32_t newhead  = (((head >> 16) + 1) << 16) | next;
+
+        if (BROKER_CAS(&cls->free, &head, newhead))
+            return buf;
+    }
+}
+
+/**
+ * @brief Push a block back on its class free list
+ */
+static void broker_pool_push(broker_pool_class_t *cls, broker_buf_t *buf)
+{
+    uint32_t index = (uint32_t)(((uint8_t *)buf - cls->base) / cls->stride) + 1;
+    uint32_t head  = BROKER_LOAD(&cls->free);
+    uint32_t newhead;
+
+    do {
+        __atomic_store_n(&buf->next, (uint16_t)head, __ATOMIC_RELAXED);
+        newhead = (((head >> 16) + 1) << 16) | index;
+    } while (!BROKER_CAS(&cls->free, &head, newhead));
+}
+
+#if !XY_BROKER_STATS
+/**
+ * @brief Buffers off the free lists; exact only while no one allocates
+ * or releases
+ */
+static uint32_t broker_pool_in_use(void)
+{
+    uint32_t used = 0;
+
+    for (int i = 0; i < BROKER_POOL_CLASSES; i++) {
+        broker_pool_class_t *cls = &g_broker.pool[i];
+        uint16_t next            = (uint16_t)BROKER_LOAD(&cls->free);
+        uint32_t free            = 0;
+
+        while (next != 0 && free < cls->count) {
+            free++;
+            next = __atomic_load_n(&broker_pool_block(cls, next - 1)->next,
+                                   __ATOMIC_RELAXED);
+        }
+        used += cls->count - free;
+    }
+    return used;
+}
+#endif
+
+/**
+ * @brief Take a buffer from the pool
+ */
+static xy_broker_msg_t *broker_msg_get(uint16_t payload_len)
+{
+    // Smallest class that fits, larger ones when it runs dry
+    for (int i = 0; i < BROKER_POOL_CLASSES; i++) {
+        broker_pool_class_t *cls = &g_broker.pool[i];
+        if (cls->size < payload_len)
+            continue;
+
+        broker_buf_t *buf = broker_pool_pop(cls);
+        if (!buf)
+            continue;
+
+        memset(&buf->msg, 0, sizeof(buf->msg));
+        buf->msg.payload_len = payload_len;
+        buf->msg.payload     = (uint8_t *)(buf + 1);
+        __atomic_store_n(&buf->refcnt, 1, __ATOMIC_RELAXED);
+
+#if XY_BROKER_STATS
+        uint32_t used = BROKER_ADD(&g_broker.stats.pool_in_use, 1) + 1;
+        uint32_t peak = BROKER_LOAD(&g_broker.stats.pool_peak);
+        while (used > peak && !BROKER_CAS(&g_broker.stats.pool_peak, &peak, used))
+            ;
+#endif
+
+        return &buf->msg;
+    }
+
+    BROKER_COUNT(pool_alloc_failed);
+    return NULL;
+}
+
+/**
+ * @brief Drop one reference to a buffer
+ */
+static void broker_msg_put(const xy_broker_msg_t *msg)
+{
+    broker_buf_t *buf = (broker_buf_t *)(void *)msg;
+    uint16_t ref      = BROKER_LOAD(&buf->refcnt);
+
+    // The last holder frees the buffer, after everyone else's writes; a
+    // sole holder has no one to race with
+    while (ref > 1) {
+        if (BROKER_CAS(&buf->refcnt, &ref, (uint16_t)(ref - 1)))
+            return;
+    }
+    if (ref == 0)
+        return;
+    __atomic_store_n(&buf->refcnt, 0, __ATOMIC_RELAXED);
+
+    // A wrapped payload goes back to its owner first
+    if (buf->msg.payload != (uint8_t *)(buf + 1)) {
+        broker_wrap_t *wrap = (broker_wrap_t *)(void *)(buf + 1);
+        wrap->free_fn(&buf->msg, wrap->ctx);
+    }
+
+    broker_pool_class_t *cls = broker_pool_class_of(buf);
+    if (cls) {
+        broker_pool_push(cls, buf);
+#if XY_BROKER_STATS
+        BROKER_SUB(&g_broker.stats.pool_in_use, 1);
+#endif
+    }
+}
+
+/**
+ * @brief Free hook of a header sent over another message's payload
+ */
+static void broker_share_free(const xy_broker_msg_t *msg, void *ctx)
+{
+    (void)msg;
+    broker_msg_put(ctx);
+}
+
+/**
+ * @brief A message the caller alone holds, whose header may be stamped
+ *
+ * Others holding @p msg may read its header at any time, so a shared
+ * message goes out as a new header over the same payload, which keeps a
+ * reference to it. Consumes the caller's reference.
+ *
+ * @return The message to stamp, or NULL if the pool is exhausted
+ */
+static xy_broker_msg_t *broker_msg_own(xy_broker_msg_t *msg)
+{
+    if (BROKER_LOAD(&((broker_buf_t *)(void *)msg)->refcnt) == 1)
+        return msg;
+
+    xy_broker_msg_t *own = xy_broker_msg_wrap(msg->payload, msg->payload_len,
+                                              broker_share_free, msg);
+    if (!own)
+        broker_msg_put(msg);
+    return own;
+}
+
+/**
+ * @brief Count trailing zeros, x != 0
+ */
+static int broker_ctz(uint32_t x)
+{
+    return __builtin_ctz(x);
+}
+
+/**
+ * @brief Index of the highest set bit, x != 0
+ */
+static int broker_fls(uint32_t x)
+{
+    return 31 - __builtin_clz(x);
+}
+/**
+ * @brief Home position of an ID in an index of the given size
+ */
+static uint16_t broker_hash(uint16_t id, uint16_t size)
+{
+    return (uint16_t)(((uint32_t)id * 0x9E3779B1u) >> 16) & (size - 1);
+}
+
+/**
+ * @brief Look up an ID, linear probing
+ * @return Slot index, or -1 if the ID is not in the index
+ */
+static int broker_index_find(const broker_index_entry_t *index, uint16_t size,
+                             uint16_t id)
+{
+    uint16_t i = broker_hash(id, size);
+
+    while (index[i].slot != 0) {
+        if (index[i].id == id)
+            return index[i].slot - 1;
+        i = (i + 1) & (size - 1);
+    }
+    return -1;
+}
+
+/**
+ * @brief Add an ID; the caller has checked that it is not present
+ */
+static void broker_index_insert(broker_index_entry_t *index, uint16_t size,
+                                uint16_t id, int slot)
+{
+    uint16_t i = broker_hash(id, size);
+
+    while (index[i].slot != 0) {
+        i = (i + 1) & (size - 1);
+    }
+    index[i].id   = id;
+    index[i].slot = (uint16_t)(slot + 1);
+}
+
+/**
+ * @brief Remove an ID, shifting back the entries probed past it
+ */
+static void broker_index_remove(broker_index_entry_t *index, uint16_t size,
+                                uint16_t id)
+{
+    uint16_t mask = size - 1;
+    uint16_t i    = broker_hash(id, size);
+
+    while (index[i].slot != 0 && index[i].id != id) {
+        i = (i + 1) & mask;
+    }
+    if (index[i].slot == 0)
+        return;
+
+    // Move up every later entry of the run whose home is not in (i, j]
+    for (uint16_t j = (i + 1) & mask; index[j].slot != 0; j = (j + 1) & mask) {
+        uint16_t home = broker_hash(index[j].id, size);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            index[i] = index[j];
+            i        = j;
+        }
+    }
+    index[i].slot = 0;
+}
+
+/**
+ * @brief Find server by ID
+ */
+static xy_broker_server_t *broker_find_server(uint16_t server_id)
+{
+    int slot = broker_index_find(
+        g_broker.server_index, XY_BROKER_SERVER_INDEX_SIZE, server_id);
+
+    return slot < 0 ? NULL : &g_broker.servers[slot];
+}
+
+/**
+ * @brief Find free server slot
+ */
+static xy_broker_server_t *broker_alloc_server(void)
+{
+    for (int i = 0; i < XY_BROKER_MAX_SERVERS; i++) {
+        if (!g_broker.servers[i].active) {
+            return &g_broker.servers[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Find topic by ID
+ */
+static xy_broker_topic_t *broker_find_topic(uint16_t topic_id)
+{
+    int slot = broker_index_find(
+        g_broker.topic_index, XY_BROKER_TOPIC_INDEX_SIZE, topic_id);
+
+    return slot < 0 ? NULL : &g_broker.topics[slot];
+}
+
+/**
+ * @brief Find free topic slot
+ */
+static xy_broker_topic_t *broker_alloc_topic(void)
+{
+    for (int i = 0; i < XY_BROKER_MAX_TOPICS; i++) {
+        if (!g_broker.topics[i].active) {
+            return &g_broker.topics[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Find a subscriber of a topic
+ * @return Subscriber slot, or -1 if the server is not subscribed
+ */
+static int broker_find_subscriber(const xy_broker_topic_t *topic,
+                                  uint16_t server_id)
+{
+    for (int w = 0; w < XY_BROKER_SUB_WORDS; w++) {
+        for (uint32_t map = topic->sub_map[w]; map; map &= map - 1) {
+            int i = w * 32 + broker_ctz(map);
+            if (topic->subscribers[i].server_id == server_id)
+                return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Compile a wildcard filter to its masks
+ * @return 0 on success, -1 if a level is out of range
+ */
+static int broker_filter_compile(uint32_t filter, xy_broker_filter_t *f)
+{
+    const uint16_t named = (1u << XY_BROKER_TOPIC_LEVEL_BITS) - 1;
+
+    f->filter  = filter;
+    f->value   = 0;
+    f->mask    = 0;
+    f->present = 0;
+
+    for (int i = 0; i < XY_BROKER_TOPIC_LEVELS; i++) {
+        int down      = XY_BROKER_TOPIC_LEVELS - 1 - i;
+        uint8_t level = (uint8_t)(filter >> (8 * down));
+        int shift     = XY_BROKER_TOPIC_LEVEL_BITS * down;
+
+        if (level == XY_BROKER_TOPIC_REST)
+            break;
+        if (level == XY_BROKER_TOPIC_ANY) {
+            f->present |= (uint16_t)(named << shift);
+        } else if (level <= named) {
+            f->mask |= (uint16_t)(named << shift);
+            f->value |= (uint16_t)(level << shift);
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Whether a filter matches a topic ID
+ */
+static int broker_filter_match(const xy_broker_filter_t *f, uint16_t topic_id)
+{
+    if ((topic_id & f->mask) != f->value)
+        return 0;
+
+    // Fold each '+' level onto its lowest bit, which is then set if the
+    // level is named (4-bit levels)
+    uint16_t levels = topic_id & f->present;
+    levels |= levels >> 2;
+    levels |= levels >> 1;
+    return (levels & f->present & 0x1111u) == (f->present & 0x1111u);
+}
+
+/**
+ * @brief Find a wildcard subscription
+ * @return Filter slot, or -1 if there is none
+ */
+static int broker_find_filter(uint32_t filter, uint16_t server_id)
+{
+    for (int w = 0; w < XY_BROKER_FILTER_WORDS; w++) {
+        for (uint32_t map = g_broker.filter_map[w]; map; map &= map - 1) {
+            int i = w * 32 + broker_ctz(map);
+            if (g_broker.filters[i].filter == filter
+                && g_broker.filters[i].sub.server_id == server_id)
+                return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Build the cached list of filters that match a topic
+ */
+static void broker_topic_match_filters(xy_broker_topic_t *topic)
+{
+    for (int w = 0; w < XY_BROKER_FILTER_WORDS; w++) {
+        topic->filter_map[w] = 0;
+        for (uint32_t map = g_broker.filter_map[w]; map; map &= map - 1) {
+            int i = w * 32 + broker_ctz(map);
+            if (broker_filter_match(&g_broker.filters[i], topic->topic_id))
+                topic->filter_map[w] |= 1u << (i % 32);
+        }
+    }
+}
+
+/**
+ * @brief Whether a publish to a topic reaches any subscriber
+ *
+ * @param topic Created topic, or NULL if topic_id was never created
+ */
+static int broker_topic_has_receivers(const xy_broker_topic_t *topic,
+                                      uint16_t topic_id)
+{
+    if (topic) {
+        if (topic->subscriber_count > 0)
+            return 1;
+        for (int w = 0; w < XY_BROKER_FILTER_WORDS; w++) {
+            if (topic->filter_map[w])
+                return 1;
+        }
+        return 0;
+    }
+
+    for (int w = 0; w < XY_BROKER_FILTER_WORDS; w++) {
+        for (uint32_t map = g_broker.filter_map[w]; map; map &= map - 1) {
+            if (broker_filter_match(&g_broker.filters[w * 32 + broker_ctz(map)],
+                                    topic_id))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Queue level of a priority; values above the top level share it
+ */
+static int broker_level(uint8_t priority)
+{
+    return priority < XY_BROKER_PRIORITY_LEVELS
+               ? priority
+               : XY_BROKER_PRIORITY_LEVELS - 1;
+}
+
+
+/**
+ * @brief Put a message into a priority ring
+ * @return 1 on success, 0 if the ring is full
+ */
+static int broker_ring_push(xy_broker_prio_queue_t *q, xy_broker_msg_t *msg)
+{
+    uint32_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+
+    for (;;) {
+        xy_broker_cell_t *cell = &q->ring[pos & (XY_BROKER_PRIO_QUEUE_SIZE - 1)];
+        int32_t diff = (int32_t)(BROKER_LOAD(&cell->seq) - pos);
+
+        if (diff == 0) {
+            // Free for this lap: claim the position, then fill the cell
+            if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, 0,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                cell->msg = msg;
+                BROKER_STORE(&cell->seq, pos + 1);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0; // Still holds the message from one lap ago
+        } else {
+            pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Take the oldest message of a priority ring
+ *
+ * Normally the processing thread; senders evicting under a drop policy
+ * take from the ring as well.
+ *
+ * @return Message, or NULL if the ring holds no filled cell
+ */
+static xy_broker_msg_t *broker_ring_pop(xy_broker_prio_queue_t *q)
+{
+    uint32_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+
+    for (;;) {
+        xy_broker_cell_t *cell = &q->ring[pos & (XY_BROKER_PRIO_QUEUE_SIZE - 1)];
+        int32_t diff = (int32_t)(BROKER_LOAD(&cell->seq) - (pos + 1));
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&q->head, &pos, pos + 1, 0,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                xy_broker_msg_t *msg = cell->msg;
+                // Hand the cell to the sender one lap ahead
+                BROKER_STORE(&cell->seq, pos + XY_BROKER_PRIO_QUEUE_SIZE);
+                return msg;
+            }
+        } else if (diff < 0) {
+            return NULL; // Empty, or its sender is still filling it
+        } else {
+            pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Bit set per priority level with a message ready to take
+ */
+static uint8_t broker_ready_map(xy_broker_server_t *server)
+{
+    uint8_t map = 0;
+
+    for (int l = 0; l < XY_BROKER_PRIORITY_LEVELS; l++) {
+        xy_broker_prio_queue_t *q = &server->queues[l];
+        uint32_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+        xy_broker_cell_t *cell = &q->ring[pos & (XY_BROKER_PRIO_QUEUE_SIZE - 1)];
+
+        if (BROKER_LOAD(&cell->seq) == pos + 1)
+            map |= (uint8_t)(1u << l);
+    }
+    return map;
+}
+
+/**
+ * @brief Reserve room in the server total
+ * @return 1 on success, 0 if the server is full
+ */
+static int broker_reserve(xy_broker_server_t *server)
+{
+    uint16_t n = BROKER_LOAD(&server->queue_count);
+
+    do {
+        if (n >= XY_BROKER_MSG_QUEUE_SIZE)
+            return 0;
+    } while (!BROKER_CAS(&server->queue_count, &n, (uint16_t)(n + 1)));
+    return 1;
+}
+
+/**
+ * @brief Drop a message taken out of a server's queues
+ */
+static void broker_evict(xy_broker_server_t *server, xy_broker_msg_t *msg)
+{
+    BROKER_SUB(&server->queue_count, 1);
+    broker_msg_put(msg);
+}
+
+/**
+ * @brief Wake the server's processing thread if it is waiting
+ */
+static void broker_wake(xy_broker_server_t *server)
+{
+    void *thread = BROKER_LOAD(&server->wake_thread);
+    if (!thread)
+        return;
+
+    // Pairs with the fence in xy_broker_wait_msgs(): either the waiter
+    // sees the message, or this sees it armed
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&server->wake_armed, __ATOMIC_RELAXED)
+        && __atomic_exchange_n(&server->wake_armed, 0, __ATOMIC_ACQ_REL)) {
+        (void)xy_os_thread_flags_set(thread, server->wake_flags);
+    }
+}
+
+/**
+ * @brief Enqueue message to server
+ */
+static int broker_enqueue_msg(xy_broker_server_t *server,
+                              xy_broker_msg_t *msg)
+{
+    if (!server || !msg)
+        return XY_BROKER_INVALID_PARAM;
+
+    int level                 = broker_level(msg->priority);
+    xy_broker_prio_queue_t *q = &server->queues[level];
+
+    // One eviction makes room; a second try can lose it to another sender
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int level_full = 0;
+
+        if (broker_reserve(server)) {
+            if (broker_ring_push(q, msg)) {
+                BROKER_ADD(&server->msg_received, 1);
+                broker_wake(server);
+                return XY_BROKER_OK;
+            }
+            BROKER_SUB(&server->queue_count, 1);
+            level_full = 1;
+        }
+
+        if (attempt == 0)
+            BROKER_COUNT(queue_overflow_count);
+
+        xy_broker_msg_t *victim = NULL;
+        if (q->policy == XY_BROKER_DROP_OLDEST) {
+            victim = broker_ring_pop(q);
+        } else if (q->policy == XY_BROKER_DROP_LOWER && !level_full) {
+            // Only the server total is full: make room at the bottom
+            for (int l = 0; l < level && !victim; l++) {
+                victim = broker_ring_pop(&server->queues[l]);
+            }
+        }
+
+        if (!victim)
+            break;
+        broker_evict(server, victim);
+        BROKER_COUNT(total_msg_dropped);
+    }
+
+    BROKER_COUNT(total_msg_dropped);
+    return XY_BROKER_QUEUE_FULL;
+}
+
+/**
+ * @brief Dequeue message from server, highest priority first
+ *
+ * Processing thread only: it alone advances the aging counters.
+ */
+static int broker_dequeue_msg(xy_broker_server_t *server,
+                              xy_broker_msg_t **msg)
+{
+    if (!server || !msg)
+        return XY_BROKER_INVALID_PARAM;
+
+    uint8_t ready = broker_ready_map(server);
+
+    for (int l = 0; l < XY_BROKER_PRIORITY_LEVELS; l++) {
+        if (!(ready & (1u << l)))
+            server->queues[l].passed = 0;
+    }
+
+    while (ready) {
+        int top   = broker_fls(ready);
+        int level = top;
+        uint8_t below = ready & (uint8_t)((1u << top) - 1);
+
+        if (server->aging_limit > 0) {
+            // The lowest queue passed over long enough goes first
+            for (uint8_t wait = below; wait; wait &= wait - 1) {
+                int l = broker_ctz(wait);
+                if (server->queues[l].passed >= server->aging_limit) {
+                    level = l;
+                    break;
+                }
+            }
+        }
+
+        *msg = broker_ring_pop(&server->queues[level]);
+        if (!*msg) {
+            // A sender evicted it under a drop policy meanwhile
+            ready &= (uint8_t)~(1u << level);
+            continue;
+        }
+        BROKER_SUB(&server->queue_count, 1);
+
+        if (server->aging_limit > 0) {
+            // Every other waiting queue below the top is passed over once more
+            for (uint8_t wait = below & (uint8_t)~(1u << level); wait;
+                 wait &= wait - 1) {
+                xy_broker_prio_queue_t *q = &server->queues[broker_ctz(wait)];
+                if (q->passed < UINT8_MAX)
+                    q->passed++;
+            }
+        }
+        server->queues[level].passed = 0;
+
+        return XY_BROKER_OK;
+    }
 
-/**
- * @brief Get timestamp in milliseconds
- * @note Implement this based on your platform's timer
- */
-static uint32_t broker_get_timestamp(void)
-{
-    // TODO: Implement platform-specific timestamp
-    // For now, use a simple counter
-    static uint32_t tick_count = 0;
-    return tick_count++;
+    return XY_BROKER_NOT_FOUND;
 }
 
 /**
- * @brief Find server by ID
+ * @brief Drop every queued message of a server
  */
-static xy_broker_server_t *broker_find_server(uint16_t server_id)
+static void broker_flush_queue(xy_broker_server_t *server)
 {
-    for (int i = 0; i < XY_BROKER_MAX_SERVERS; i++) {
-        if (g_broker.servers[i].active
-            && g_broker.servers[i].server_id == server_id) {
-            return &g_broker.servers[i];
+    for (int l = 0; l < XY_BROKER_PRIORITY_LEVELS; l++) {
+        xy_broker_msg_t *msg;
+        while ((msg = broker_ring_pop(&server->queues[l])) != NULL) {
+            broker_evict(server, msg);
         }
+        server->queues[l].passed = 0;
     }
-    return NULL;
 }
 
 /**
- * @brief Find free server slot
+ * @brief Claim a pending slot under a fresh correlation ID
  */
-static xy_broker_server_t *broker_alloc_server(void)
+static broker_pending_t *broker_pending_alloc(uint16_t *corr_id)
 {
-    for (int i = 0; i < XY_BROKER_MAX_SERVERS; i++) {
-        if (!g_broker.servers[i].active) {
-            return &g_broker.servers[i];
+    uint16_t id;
+
+    do {
+        id = (uint16_t)(BROKER_ADD(&g_broker.corr_counter, 1) + 1);
+    } while (id == 0);
+
+    for (int i = 0; i < XY_BROKER_MAX_PENDING; i++) {
+        broker_pending_t *p = &g_broker.pending[i];
+        uint32_t expected   = BROKER_REQ_FREE;
+
+        if (BROKER_LOAD(&p->state) == BROKER_REQ_FREE
+            && BROKER_CAS(&p->state, &expected,
+                          BROKER_REQ_STATE(id, BROKER_REQ_WAITING))) {
+            *corr_id = id;
+            return p;
         }
     }
     return NULL;
 }
 
 /**
- * @brief Find topic by ID
+ * @brief Take over the request a correlation ID belongs to, if its caller
+ * is still waiting
  */
-static xy_broker_topic_t *broker_find_topic(uint16_t topic_id)
+static broker_pending_t *broker_pending_claim(uint16_t corr_id)
 {
-    for (int i = 0; i < XY_BROKER_MAX_TOPICS; i++) {
-        if (g_broker.topics[i].topic_id == topic_id
-            && g_broker.topics[i].subscriber_count > 0) {
-            return &g_broker.topics[i];
-        }
+    uint32_t waiting = BROKER_REQ_STATE(corr_id, BROKER_REQ_WAITING);
+
+    if (corr_id == 0)
+        return NULL;
+
+    for (int i = 0; i < XY_BROKER_MAX_PENDING; i++) {
+        broker_pending_t *p = &g_broker.pending[i];
+        uint32_t expected   = waiting;
+
+        if (BROKER_LOAD(&p->state) == waiting
+            && BROKER_CAS(&p->state, &expected,
+                          BROKER_REQ_STATE(corr_id, BROKER_REQ_DELIVERING)))
+            return p;
     }
     return NULL;
 }
 
 /**
- * @brief Find free topic slot
+ * @brief Wait for a request's completion
+ * @return 1 if the completion was signalled, 0 on timeout
  */
-static xy_broker_topic_t *broker_alloc_topic(void)
+static int broker_pending_wait(broker_pending_t *p, uint32_t timeout_ms)
 {
-    for (int i = 0; i < XY_BROKER_MAX_TOPICS; i++) {
-        if (g_broker.topics[i].subscriber_count == 0) {
-            return &g_broker.topics[i];
-        }
+    uint32_t ticks = broker_ms_to_ticks(timeout_ms);
+
+    if (p->sem)
+        return xy_os_semaphore_acquire(p->sem, ticks) == XY_OS_OK;
+
+    // No semaphores on this port: the response can only come from an
+    // interrupt, so poll the state against the tick
+    uint32_t start = xy_os_kernel_get_tick_count();
+    while ((BROKER_LOAD(&p->state) & 0xFFFFu) != BROKER_REQ_DONE) {
+        if (ticks != XY_OS_WAIT_FOREVER
+            && xy_os_kernel_get_tick_count() - start >= ticks)
+            return 0;
     }
-    return NULL;
+    return 1;
 }
 
 /**
- * @brief Enqueue message to server
+ * @brief Address, stamp and queue a pool message; consumes the reference
+ *
+ * @param dst Server @p dst_server, or NULL if it is not registered
  */
-static int broker_enqueue_msg(xy_broker_server_t *server,
-                              const xy_broker_msg_t *msg)
+static int broker_send(xy_broker_server_t *dst, uint16_t src_server,
+                       uint16_t dst_server, uint16_t msg_id,
+                       xy_broker_msg_t *msg, uint8_t priority, uint8_t flags,
+                       uint16_t corr_id)
 {
-    if (!server || !msg)
-        return XY_BROKER_INVALID_PARAM;
+    if (!dst) {
+        broker_msg_put(msg);
+        return XY_BROKER_NOT_FOUND;
+    }
 
-    if (server->queue_count >= XY_BROKER_MSG_QUEUE_SIZE) {
-        g_broker.stats.queue_overflow_count++;
-        g_broker.stats.total_msg_dropped++;
-        return XY_BROKER_QUEUE_FULL;
+    msg = broker_msg_own(msg);
+    if (!msg) {
+        BROKER_COUNT(total_msg_dropped);
+        return XY_BROKER_NO_MEMORY;
     }
 
-    memcpy(
-        &server->msg_queue[server->queue_tail], msg, sizeof(xy_broker_msg_t));
-    server->queue_tail = (server->queue_tail + 1) % XY_BROKER_MSG_QUEUE_SIZE;
-    server->queue_count++;
-    server->msg_received++;
+    msg->msg_id     = msg_id;
+    msg->src_server = src_server;
+    msg->dst_server = dst_server;
+    msg->topic_id   = 0;
+    msg->priority   = priority;
+    msg->flags      = flags;
+    msg->corr_id    = corr_id;
+    msg->timestamp  = broker_get_timestamp();
+    msg->seq_num    = BROKER_ADD(&g_broker.seq_counter, 1);
+
+    // The queue takes over the caller's reference
+    int ret = broker_enqueue_msg(dst, msg);
+    if (ret == XY_BROKER_OK) {
+        BROKER_COUNT_MSG(total_msg_sent, 1);
 
-    return XY_BROKER_OK;
+        // Update source server stats if registered
+        xy_broker_server_t *src = broker_find_server(src_server);
+        if (src) {
+            BROKER_ADD(&src->msg_sent, 1);
+        }
+    } else {
+        broker_msg_put(msg);
+    }
+
+    return ret;
 }
 
 /**
- * @brief Dequeue message from server
+ * @brief Stamp a pool message and call every subscriber; consumes the
+ * reference
+ *
+ * @param topic Created topic, or NULL if topic_id was never created
  */
-static int broker_dequeue_msg(xy_broker_server_t *server, xy_broker_msg_t *msg)
+static int broker_publish(xy_broker_topic_t *topic, uint16_t topic_id,
+                          uint16_t src_server, uint16_t msg_id,
+                          xy_broker_msg_t *msg, uint8_t priority)
 {
-    if (!server || !msg)
-        return XY_BROKER_INVALID_PARAM;
+    msg = broker_msg_own(msg);
+    if (!msg) {
+        BROKER_COUNT(total_msg_dropped);
+        return XY_BROKER_NO_MEMORY;
+    }
 
-    if (server->queue_count == 0)
-        return XY_BROKER_NOT_FOUND;
+    msg->msg_id     = msg_id;
+    msg->src_server = src_server;
+    msg->dst_server = 0;
+    msg->topic_id   = topic_id;
+    msg->priority   = priority;
+    msg->flags      = XY_BROKER_FLAG_BROADCAST;
+    msg->corr_id    = 0;
+    msg->timestamp  = broker_get_timestamp();
+    msg->seq_num    = BROKER_ADD(&g_broker.seq_counter, 1);
+
+    // Deliver the same buffer to all subscribers, set bits only
+    int delivered = 0;
+    for (int w = 0; topic && w < XY_BROKER_SUB_WORDS; w++) {
+        for (uint32_t map = topic->sub_map[w]; map; map &= map - 1) {
+            xy_broker_subscriber_t *sub =
+                &topic->subscribers[w * 32 + broker_ctz(map)];
+            // Direct callback
+            sub->handler(msg, sub->user_data);
+            delivered++;
+        }
+    }
+
+    // Then the wildcard subscribers: the topic's cached list, or every
+    // filter for a topic that was never created
+    for (int w = 0; w < XY_BROKER_FILTER_WORDS; w++) {
+        uint32_t map = topic ? topic->filter_map[w] : g_broker.filter_map[w];
+        for (; map; map &= map - 1) {
+            xy_broker_filter_t *f = &g_broker.filters[w * 32 + broker_ctz(map)];
+            if (!topic && !broker_filter_match(f, topic_id))
+                continue;
+            f->sub.handler(msg, f->sub.user_data);
+            delivered++;
+        }
+    }
 
-    memcpy(
-        msg, &server->msg_queue[server->queue_head], sizeof(xy_broker_msg_t));
-    server->queue_head = (server->queue_head + 1) % XY_BROKER_MSG_QUEUE_SIZE;
-    server->queue_count--;
+    if (delivered > 0) {
+        if (topic)
+            BROKER_ADD(&topic->msg_count, 1);
+        BROKER_COUNT_MSG(total_msg_sent, 1);
+        BROKER_COUNT_MSG(total_msg_delivered, (uint32_t)delivered);
+    }
+    broker_msg_put(msg);
 
     return XY_BROKER_OK;
 }
@@ -135,6 +1097,14 @@ int xy_broker_init(void)
         return XY_BROKER_OK;
 
     memset(&g_broker, 0, sizeof(g_broker));
+    broker_pool_init();
+
+    // Ports without semaphores leave them NULL; requests then poll for
+    // their response
+    for (int i = 0; i < XY_BROKER_MAX_PENDING; i++) {
+        g_broker.pending[i].sem = xy_os_semaphore_new(1, 0, NULL);
+    }
+
     g_broker.initialized = 1;
 
     return XY_BROKER_OK;
@@ -145,6 +1115,11 @@ int xy_broker_deinit(void)
     if (!g_broker.initialized)
         return XY_BROKER_ERROR;
 
+    for (int i = 0; i < XY_BROKER_MAX_PENDING; i++) {
+        if (g_broker.pending[i].sem)
+            xy_os_semaphore_delete(g_broker.pending[i].sem);
+    }
+
     memset(&g_broker, 0, sizeof(g_broker));
 
     return XY_BROKER_OK;
@@ -172,8 +1147,16 @@ int xy_broker_register_server(uint16_t server_id,
     memset(server, 0, sizeof(xy_broker_server_t));
     server->server_id = server_id;
     server->handler   = handler;
-    server->user_data = user_data;
-    server->active    = 1;
+    server->user_data   = user_data;
+    server->aging_limit = XY_BROKER_AGING_LIMIT;
+    server->active      = 1;
+    for (int l = 0; l < XY_BROKER_PRIORITY_LEVELS; l++) {
+        for (uint32_t i = 0; i < XY_BROKER_PRIO_QUEUE_SIZE; i++) {
+            server->queues[l].ring[i].seq = i;
+        }
+    }
+    broker_index_insert(g_broker.server_index, XY_BROKER_SERVER_INDEX_SIZE,
+                        server_id, (int)(server - g_broker.servers));
 
     g_broker.stats.active_servers++;
 
@@ -189,6 +1172,9 @@ int xy_broker_unregister_server(uint16_t server_id)
     if (!server)
         return XY_BROKER_NOT_FOUND;
 
+    broker_index_remove(
+        g_broker.server_index, XY_BROKER_SERVER_INDEX_SIZE, server_id);
+    broker_flush_queue(server);
     server->active = 0;
     g_broker.stats.active_servers--;
 
@@ -209,34 +1195,18 @@ int xy_broker_send_msg(uint16_t src_server, uint16_t dst_server,
     if (!dst)
         return XY_BROKER_NOT_FOUND;
 
-    // Create message
-    xy_broker_msg_t msg;
-    memset(&msg, 0, sizeof(msg));
-    msg.msg_id      = msg_id;
-    msg.src_server  = src_server;
-    msg.dst_server  = dst_server;
-    msg.priority    = priority;
-    msg.seq_num     = g_broker.seq_counter++;
-    msg.timestamp   = broker_get_timestamp();
-    msg.payload_len = payload_len;
-
-    if (payload && payload_len > 0) {
-        memcpy(msg.payload, payload, payload_len);
+    xy_broker_msg_t *msg = broker_msg_get(payload_len);
+    if (!msg) {
+        BROKER_COUNT(total_msg_dropped);
+        return XY_BROKER_NO_MEMORY;
     }
 
-    // Enqueue message
-    int ret = broker_enqueue_msg(dst, &msg);
-    if (ret == XY_BROKER_OK) {
-        g_broker.stats.total_msg_sent++;
-
-        // Update source server stats if registered
-        xy_broker_server_t *src = broker_find_server(src_server);
-        if (src) {
-            src->msg_sent++;
-        }
+    if (payload && payload_len > 0) {
+        memcpy(msg->payload, payload, payload_len);
     }
 
-    return ret;
+    return broker_send(dst, src_server, dst_server, msg_id, msg, priority,
+                       XY_BROKER_FLAG_NONE, 0);
 }
 
 int xy_broker_process_msgs(uint16_t server_id, uint16_t max_msgs)
@@ -252,22 +1222,192 @@ int xy_broker_process_msgs(uint16_t server_id, uint16_t max_msgs)
         return XY_BROKER_ERROR;
 
     int processed = 0;
-    xy_broker_msg_t msg;
 
-    while (server->queue_count > 0) {
-        if (max_msgs > 0 && processed >= max_msgs)
+    while (max_msgs == 0 || processed < max_msgs) {
+        xy_broker_msg_t *msg;
+        if (broker_dequeue_msg(server, &msg) != XY_BROKER_OK)
             break;
+        BROKER_COUNT_MSG(total_msg_delivered, 1);
 
-        if (broker_dequeue_msg(server, &msg) == XY_BROKER_OK) {
-            server->handler(&msg, server->user_data);
-            g_broker.stats.total_msg_delivered++;
-            processed++;
-        }
+        // The handler may send, request or respond
+        server->handler(msg, server->user_data);
+        broker_msg_put(msg);
+        processed++;
     }
 
     return processed;
 }
 
+int xy_broker_set_wakeup(uint16_t server_id, void *thread_id, uint32_t flags)
+{
+    if (!g_broker.initialized)
+        return XY_BROKER_ERROR;
+
+    if (thread_id && flags == 0)
+        return XY_BROKER_INVALID_PARAM;
+
+    xy_broker_server_t *server = broker_find_server(server_id);
+    if (!server)
+        return XY_BROKER_NOT_FOUND;
+
+    __atomic_store_n(&server->wake_armed, 0, __ATOMIC_RELAXED);
+    server->wake_flags = flags;
+    BROKER_STORE(&server->wake_thread, thread_id);
+
+    return XY_BROKER_OK;
+}
+
+int xy_broker_wait_msgs(uint16_t server_id, uint32_t timeout_ms)
+{
+    if (!g_broker.initialized)
+        return XY_BROKER_ERROR;
+
+    xy_broker_server_t *server = broker_find_server(server_id);
+    if (!server)
+        return XY_BROKER_NOT_FOUND;
+
+    if (!server->wake_thread)
+        return XY_BROKER_ERROR;
+
+    uint32_t ticks = broker_ms_to_ticks(timeout_ms);
+    uint32_t start = xy_os_kernel_get_tick_count();
+
+    for (;;) {
+        if (broker_ready_map(server))
+            return BROKER_LOAD(&server->queue_count);
+
+        // Arm, then look again: a message sent in between either shows up
+        // here or finds the thread armed and sets the flags
+        __atomic_store_n(&server->wake_armed, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (broker_ready_map(server)) {
+            __atomic_store_n(&server->wake_armed, 0, __ATOMIC_RELAXED);
+            return BROKER_LOAD(&server->queue_count);
+        }
+
+        uint32_t left = XY_OS_WAIT_FOREVER;
+        if (ticks != XY_OS_WAIT_FOREVER) {
+            uint32_t spent = xy_os_kernel_get_tick_count() - start;
+            if (spent >= ticks) {
+                __atomic_store_n(&server->wake_armed, 0, __ATOMIC_RELAXED);
+                return XY_BROKER_TIMEOUT;
+            }
+            left = ticks - spent;
+        }
+
+        // Errors come back with the top bit set; the loop rechecks either way
+        (void)xy_os_thread_flags_wait(server->wake_flags, XY_OS_FLAGS_WAIT_ANY,
+                                      left);
+    }
+}
+
+int xy_broker_set_drop_policy(uint16_t server_id, uint8_t priority,
+                              uint8_t policy)
+{
+    if (!g_broker.initialized)
+        return XY_BROKER_ERROR;
+
+    if (policy > XY_BROKER_DROP_LOWER)
+        return XY_BROKER_INVALID_PARAM;
+
+    xy_broker_server_t *server = broker_find_server(server_id);
+    if (!server)
+        return XY_BROKER_NOT_FOUND;
+
+    server->queues[broker_level(priority)].policy = policy;
+
+    return XY_BROKER_OK;
+}
+
+int xy_broker_set_aging(uint16_t server_id, uint8_t limit)
+{
+    if (!g_broker.initialized)
+        return XY_BROKER_ERROR;
+
+    xy_broker_server_t *server = broker_find_server(server_id);
+    if (!server)
+        return XY_BROKER_NOT_FOUND;
+
+    server->aging_limit = limit;
+
+    return XY_BROKER_OK;
+}
+
+/* ==================== Zero-Copy API Implementation ==================== */
+
+xy_broker_msg_t *xy_broker_msg_alloc(uint16_t payload_len)
+{
+    if (!g_broker.initialized || payload_len > XY_BROKER_MAX_MSG_SIZE)
+        return NULL;
+
+    return broker_msg_get(payload_len);
+}
+
+xy_broker_msg_t *xy_broker_msg_wrap(void *payload, uint16_t payload_len,
+                                    xy_broker_payload_free_t free_fn,
+                                    void *ctx)
+{
+    if (!g_broker.initialized || !payload || !free_fn)
+        return NULL;
+
+    xy_broker_msg_t *msg = broker_msg_get(sizeof(broker_wrap_t));
+    if (!msg)
+        return NULL;
+
+    broker_wrap_t *wrap = (broker_wrap_t *)(void *)msg->payload;
+    wrap->free_fn       = free_fn;
+    wrap->ctx           = ctx;
+    msg->payload        = (uint8_t *)payload;
+    msg->payload_len    = payload_len;
+    return msg;
+}
+
+void xy_broker_msg_retain(const xy_broker_msg_t *msg)
+{
+    if (msg) {
+        BROKER_ADD(&((broker_buf_t *)(void *)msg)->refcnt, 1);
+    }
+}
+
+void xy_broker_msg_release(const xy_broker_msg_t *msg)
+{
+    if (msg)
+        broker_msg_put(msg);
+}
+
+int xy_broker_msg_send(uint16_t src_server, uint16_t dst_server,
+                       uint16_t msg_id, xy_broker_msg_t *msg,
+                       uint8_t priority)
+{
+    if (!g_broker.initialized)
+        return XY_BROKER_ERROR;
+
+    if (!msg)
+        return XY_BROKER_INVALID_PARAM;
+
+    return broker_send(broker_find_server(dst_server), src_server, dst_server,
+                       msg_id, msg, priority, XY_BROKER_FLAG_NONE, 0);
+}
+
+int xy_broker_msg_publish(uint16_t src_server, uint16_t topic_id,
+                          uint16_t msg_id, xy_broker_msg_t *msg,
+                          uint8_t priority)
+{
+    if (!g_broker.initialized)
+        return XY_BROKER_ERROR;
+
+    if (!msg)
+        return XY_BROKER_INVALID_PARAM;
+
+    xy_broker_topic_t *topic = broker_find_topic(topic_id);
+    if (!broker_topic_has_receivers(topic, topic_id)) {
+        xy_broker_msg_release(msg);
+        return XY_BROKER_NOT_FOUND;
+    }
+
+    return broker_publish(topic, topic_id, src_server, msg_id, msg, priority);
+}
+
 /* ==================== Pub/Sub API Implementation ==================== */
 
 int xy_broker_create_topic(uint16_t topic_id)
@@ -284,6 +1424,10 @@ int xy_broker_create_topic(uint16_t topic_id)
 
     memset(topic, 0, sizeof(xy_broker_topic_t));
     topic->topic_id = topic_id;
+    topic->active   = 1;
+    broker_topic_match_filters(topic);
+    broker_index_insert(g_broker.topic_index, XY_BROKER_TOPIC_INDEX_SIZE,
+                        topic_id, (int)(topic - g_broker.topics));
 
     return XY_BROKER_OK;
 }
@@ -306,28 +1450,29 @@ int xy_broker_subscribe(uint16_t topic_id, uint16_t server_id,
     }
 
     // Check if already subscribed
-    for (int i = 0; i < XY_BROKER_MAX_SUBSCRIBERS; i++) {
-        if (topic->subscribers[i].active
-            && topic->subscribers[i].server_id == server_id) {
-            return XY_BROKER_ALREADY_EXISTS;
-        }
-    }
+    if (broker_find_subscriber(topic, server_id) >= 0)
+        return XY_BROKER_ALREADY_EXISTS;
 
-    // Find free subscriber slot
-    for (int i = 0; i < XY_BROKER_MAX_SUBSCRIBERS; i++) {
-        if (!topic->subscribers[i].active) {
-            topic->subscribers[i].server_id = server_id;
-            topic->subscribers[i].handler   = handler;
-            topic->subscribers[i].user_data = user_data;
-            topic->subscribers[i].active    = 1;
-            topic->subscriber_count++;
+    // Find free subscriber slot: lowest clear bit
+    for (int w = 0; w < XY_BROKER_SUB_WORDS; w++) {
+        if (topic->sub_map[w] == 0xFFFFFFFFu)
+            continue;
 
-            if (topic->subscriber_count == 1) {
-                g_broker.stats.active_topics++;
-            }
+        int i = w * 32 + broker_ctz(~topic->sub_map[w]);
+        if (i >= XY_BROKER_MAX_SUBSCRIBERS)
+            break;
+
+        topic->subscribers[i].server_id = server_id;
+        topic->subscribers[i].handler   = handler;
+        topic->subscribers[i].user_data = user_data;
+        topic->sub_map[w] |= 1u << (i % 32);
+        topic->subscriber_count++;
 
-            return XY_BROKER_OK;
+        if (topic->subscriber_count == 1) {
+            g_broker.stats.active_topics++;
         }
+
+        return XY_BROKER_OK;
     }
 
     return XY_BROKER_NO_MEMORY;
@@ -342,21 +1487,82 @@ int xy_broker_unsubscribe(uint16_t topic_id, uint16_t server_id)
     if (!topic)
         return XY_BROKER_NOT_FOUND;
 
-    for (int i = 0; i < XY_BROKER_MAX_SUBSCRIBERS; i++) {
-        if (topic->subscribers[i].active
-            && topic->subscribers[i].server_id == server_id) {
-            topic->subscribers[i].active = 0;
-            topic->subscriber_count--;
+    int i = broker_find_subscriber(topic, server_id);
+    if (i < 0)
+        return XY_BROKER_NOT_FOUND;
 
-            if (topic->subscriber_count == 0) {
-                g_broker.stats.active_topics--;
-            }
+    topic->sub_map[i / 32] &= ~(1u << (i % 32));
+    topic->subscriber_count--;
+
+    // The last subscriber takes the topic with it
+    if (topic->subscriber_count == 0) {
+        g_broker.stats.active_topics--;
+        broker_index_remove(
+            g_broker.topic_index, XY_BROKER_TOPIC_INDEX_SIZE, topic_id);
+        topic->active = 0;
+    }
+
+    return XY_BROKER_OK;
+}
+
+int xy_broker_subscribe_filter(uint32_t filter, uint16_t server_id,
+                               xy_broker_msg_handler_t handler,
+                               void *user_data)
+{
+    if (!g_broker.initialized)
+        return XY_BROKER_ERROR;
+
+    xy_broker_filter_t compiled;
+    if (!handler || broker_filter_compile(filter, &compiled) != 0)
+        return XY_BROKER_INVALID_PARAM;
+
+    if (broker_find_filter(filter, server_id) >= 0)
+        return XY_BROKER_ALREADY_EXISTS;
+
+    // Find free filter slot: lowest clear bit
+    for (int w = 0; w < XY_BROKER_FILTER_WORDS; w++) {
+        if (g_broker.filter_map[w] == 0xFFFFFFFFu)
+            continue;
+
+        int i = w * 32 + broker_ctz(~g_broker.filter_map[w]);
+        if (i >= XY_BROKER_MAX_FILTERS)
+            break;
 
-            return XY_BROKER_OK;
+        compiled.sub.server_id = server_id;
+        compiled.sub.handler   = handler;
+        compiled.sub.user_data = user_data;
+        g_broker.filters[i]    = compiled;
+
+        // Join the cached list of every created topic it matches
+        for (int t = 0; t < XY_BROKER_MAX_TOPICS; t++) {
+            xy_broker_topic_t *topic = &g_broker.topics[t];
+            if (topic->active && broker_filter_match(&compiled, topic->topic_id))
+                topic->filter_map[w] |= 1u << (i % 32);
         }
+        g_broker.filter_map[w] |= 1u << (i % 32);
+
+        return XY_BROKER_OK;
     }
 
-    return XY_BROKER_NOT_FOUND;
+    return XY_BROKER_NO_MEMORY;
+}
+
+int xy_broker_unsubscribe_filter(uint32_t filter, uint16_t server_id)
+{
+    if (!g_broker.initialized)
+        return XY_BROKER_ERROR;
+
+    int i = broker_find_filter(filter, server_id);
+    if (i < 0)
+        return XY_BROKER_NOT_FOUND;
+
+    uint32_t bit = 1u << (i % 32);
+    g_broker.filter_map[i / 32] &= ~bit;
+    for (int t = 0; t < XY_BROKER_MAX_TOPICS; t++) {
+        g_broker.topics[t].filter_map[i / 32] &= ~bit;
+    }
+
+    return XY_BROKER_OK;
 }
 
 int xy_broker_publish(uint16_t src_server, uint16_t topic_id, uint16_t msg_id,
@@ -370,45 +1576,21 @@ int xy_broker_publish(uint16_t src_server, uint16_t topic_id, uint16_t msg_id,
         return XY_BROKER_INVALID_PARAM;
 
     xy_broker_topic_t *topic = broker_find_topic(topic_id);
-    if (!topic || topic->subscriber_count == 0)
+    if (!broker_topic_has_receivers(topic, topic_id))
         return XY_BROKER_NOT_FOUND;
 
-    // Create message
-    xy_broker_msg_t msg;
-    memset(&msg, 0, sizeof(msg));
-    msg.msg_id      = msg_id;
-    msg.src_server  = src_server;
-    msg.topic_id    = topic_id;
-    msg.priority    = priority;
-    msg.seq_num     = g_broker.seq_counter++;
-    msg.timestamp   = broker_get_timestamp();
-    msg.payload_len = payload_len;
-    msg.flags       = XY_BROKER_FLAG_BROADCAST;
-
-    if (payload && payload_len > 0) {
-        memcpy(msg.payload, payload, payload_len);
-    }
-
-    // Deliver to all subscribers
-    int delivered = 0;
-    for (int i = 0; i < XY_BROKER_MAX_SUBSCRIBERS; i++) {
-        if (topic->subscribers[i].active) {
-            if (topic->subscribers[i].handler) {
-                // Direct callback
-                topic->subscribers[i].handler(
-                    &msg, topic->subscribers[i].user_data);
-                delivered++;
-            }
-        }
+    // One copy into the pool, shared by every subscriber
+    xy_broker_msg_t *msg = broker_msg_get(payload_len);
+    if (!msg) {
+        BROKER_COUNT(total_msg_dropped);
+        return XY_BROKER_NO_MEMORY;
     }
 
-    if (delivered > 0) {
-        topic->msg_count++;
-        g_broker.stats.total_msg_sent++;
-        g_broker.stats.total_msg_delivered += delivered;
+    if (payload && payload_len > 0) {
+        memcpy(msg->payload, payload, payload_len);
     }
 
-    return XY_BROKER_OK;
+    return broker_publish(topic, topic_id, src_server, msg_id, msg, priority);
 }
 
 /* ==================== Request/Response API Implementation ====================
@@ -416,32 +1598,55 @@ int xy_broker_publish(uint16_t src_server, uint16_t topic_id, uint16_t msg_id,
 
 int xy_broker_request(uint16_t src_server, uint16_t dst_server, uint16_t msg_id,
                       const void *request_payload, uint16_t request_len,
-                      xy_broker_msg_t *response_msg, uint32_t timeout_ms)
+                      xy_broker_msg_t **response_msg, uint32_t timeout_ms)
 {
     if (!g_broker.initialized || !response_msg)
         return XY_BROKER_ERROR;
 
-    // Send request
-    int ret =
-        xy_broker_send_msg(src_server, dst_server, msg_id, request_payload,
-                           request_len, XY_BROKER_PRIORITY_NORMAL);
-    if (ret != XY_BROKER_OK)
-        return ret;
-
-    // Wait for response (simple polling implementation)
-    // TODO: Implement proper timeout and blocking mechanism
-    uint32_t start_time     = broker_get_timestamp();
-    xy_broker_server_t *src = broker_find_server(src_server);
-
-    while ((broker_get_timestamp() - start_time) < timeout_ms) {
-        if (src && src->queue_count > 0) {
-            if (broker_dequeue_msg(src, response_msg) == XY_BROKER_OK) {
-                return XY_BROKER_OK;
+    *response_msg = NULL;
+
+    if (request_len > XY_BROKER_MAX_MSG_SIZE)
+        return XY_BROKER_INVALID_PARAM;
+
+    uint16_t corr_id     = 0;
+    broker_pending_t *p  = broker_pending_alloc(&corr_id);
+    xy_broker_msg_t *msg = p ? broker_msg_get(request_len) : NULL;
+    if (!msg) {
+        if (p)
+            BROKER_STORE(&p->state, BROKER_REQ_FREE);
+        BROKER_COUNT(total_msg_dropped);
+        return XY_BROKER_NO_MEMORY;
+    }
+
+    if (request_payload && request_len > 0) {
+        memcpy(msg->payload, request_payload, request_len);
+    }
+
+    int ret = broker_send(broker_find_server(dst_server), src_server,
+                          dst_server, msg_id, msg, XY_BROKER_PRIORITY_NORMAL,
+                          XY_BROKER_FLAG_REQUEST, corr_id);
+    int woken = ret == XY_BROKER_OK && broker_pending_wait(p, timeout_ms);
+
+    if (!woken) {
+        // Withdraw the request, unless a responder has already taken it
+        uint32_t expected = BROKER_REQ_STATE(corr_id, BROKER_REQ_WAITING);
+        if (BROKER_CAS(&p->state, &expected, BROKER_REQ_FREE)) {
+            if (ret == XY_BROKER_OK) {
+                BROKER_COUNT(request_timeouts);
+                ret = XY_BROKER_TIMEOUT;
             }
+            return ret;
         }
+
+        // The response is on its way; its completion follows shortly
+        (void)broker_pending_wait(p, XY_OS_WAIT_FOREVER);
     }
 
-    return XY_BROKER_TIMEOUT;
+    *response_msg = p->response;
+    p->response   = NULL;
+    BROKER_STORE(&p->state, BROKER_REQ_FREE);
+
+    return XY_BROKER_OK;
 }
 
 int xy_broker_respond(const xy_broker_msg_t *request_msg,
@@ -450,10 +1655,52 @@ int xy_broker_respond(const xy_broker_msg_t *request_msg,
     if (!g_broker.initialized || !request_msg)
         return XY_BROKER_ERROR;
 
-    // Send response back to source
-    return xy_broker_send_msg(request_msg->dst_server, request_msg->src_server,
-                              request_msg->msg_id, response_payload,
-                              response_len, request_msg->priority);
+    // Not from xy_broker_request(): send the response back to the source
+    if (!(request_msg->flags & XY_BROKER_FLAG_REQUEST)) {
+        return xy_broker_send_msg(request_msg->dst_server,
+                                  request_msg->src_server, request_msg->msg_id,
+                                  response_payload, response_len,
+                                  request_msg->priority);
+    }
+
+    if (response_len > XY_BROKER_MAX_MSG_SIZE)
+        return XY_BROKER_INVALID_PARAM;
+
+    xy_broker_msg_t *msg = broker_msg_get(response_len);
+    if (!msg) {
+        BROKER_COUNT(total_msg_dropped);
+        return XY_BROKER_NO_MEMORY;
+    }
+
+    if (response_payload && response_len > 0) {
+        memcpy(msg->payload, response_payload, response_len);
+    }
+
+    msg->msg_id     = request_msg->msg_id;
+    msg->src_server = request_msg->dst_server;
+    msg->dst_server = request_msg->src_server;
+    msg->priority   = request_msg->priority;
+    msg->flags      = XY_BROKER_FLAG_RESPONSE;
+    msg->corr_id    = request_msg->corr_id;
+    msg->timestamp  = broker_get_timestamp();
+    msg->seq_num    = BROKER_ADD(&g_broker.seq_counter, 1);
+
+    // Hand the response to the waiting caller and complete its request
+    broker_pending_t *p = broker_pending_claim(msg->corr_id);
+    if (!p) {
+        broker_msg_put(msg);
+        BROKER_COUNT(late_responses);
+        return XY_BROKER_TIMEOUT;
+    }
+
+    p->response = msg;
+    BROKER_STORE(&p->state, BROKER_REQ_STATE(msg->corr_id, BROKER_REQ_DONE));
+    if (p->sem)
+        (void)xy_os_semaphore_release(p->sem);
+    BROKER_COUNT_MSG(total_msg_sent, 1);
+    BROKER_COUNT_MSG(total_msg_delivered, 1);
+
+    return XY_BROKER_OK;
 }
 
 /* ==================== Utility API Implementation ==================== */
@@ -463,7 +1710,11 @@ int xy_broker_get_stats(xy_broker_stats_t *stats)
     if (!g_broker.initialized || !stats)
         return XY_BROKER_ERROR;
 
+    // Counters are read one by one, not as one snapshot
     memcpy(stats, &g_broker.stats, sizeof(xy_broker_stats_t));
+#if !XY_BROKER_STATS
+    stats->pool_in_use = broker_pool_in_use();
+#endif
     return XY_BROKER_OK;
 }
 
@@ -478,7 +1729,7 @@ int xy_broker_get_pending_count(uint16_t server_id)
     if (!server)
         return XY_BROKER_NOT_FOUND;
 
-    return server->queue_count;
+    return BROKER_LOAD(&server->queue_count);
 }
 
 int xy_broker_clear_queue(uint16_t server_id)
@@ -487,9 +1738,7 @@ int xy_broker_clear_queue(uint16_t server_id)
     if (!server)
         return XY_BROKER_NOT_FOUND;
 
-    server->queue_head  = 0;
-    server->queue_tail  = 0;
-    server->queue_count = 0;
+    broker_flush_queue(server);
 
     return XY_BROKER_OK;
 }
@@ -14,6 +14,11 @@
  * - Priority-based message delivery
  * - Lightweight and efficient for embedded systems
  *
+ * Sending, publishing, responding and the message pool never block or lock
+ * and may be used from any thread or interrupt; each server is processed
+ * by one thread at a time. Registering servers and managing topics is
+ * meant for start-up and must not race with messaging.
+ *
  * @author XY Team
  * @date 2025
  */
@@ -42,14 +47,82 @@ extern "C" {
 #define XY_BROKER_MAX_TOPICS 64 /**< Maximum number of topics */
 #endif
 
+#ifndef XY_BROKER_MAX_FILTERS
+#define XY_BROKER_MAX_FILTERS 32 /**< Maximum wildcard subscriptions */
+#endif
+
 #ifndef XY_BROKER_MSG_QUEUE_SIZE
 #define XY_BROKER_MSG_QUEUE_SIZE 32 /**< Message queue size per server */
 #endif
 
+#ifndef XY_BROKER_PRIORITY_LEVELS
+#define XY_BROKER_PRIORITY_LEVELS 4 /**< Queues per server, at most 8 */
+#endif
+
+#ifndef XY_BROKER_PRIO_QUEUE_SIZE
+#define XY_BROKER_PRIO_QUEUE_SIZE 16 /**< Per priority level, power of two */
+#endif
+
+#ifndef XY_BROKER_AGING_LIMIT
+#define XY_BROKER_AGING_LIMIT 0 /**< Default aging limit, 0 = strict */
+#endif
+
+#ifndef XY_BROKER_MAX_PENDING
+#define XY_BROKER_MAX_PENDING 8 /**< Requests outstanding at once */
+#endif
+
 #ifndef XY_BROKER_MAX_MSG_SIZE
 #define XY_BROKER_MAX_MSG_SIZE 256 /**< Maximum message payload size */
 #endif
 
+/*
+ * Server and topic IDs are resolved through hash indexes of these sizes
+ * (powers of two, at least twice the number of slots).
+ */
+#ifndef XY_BROKER_SERVER_INDEX_SIZE
+#define XY_BROKER_SERVER_INDEX_SIZE 32 /**< Server ID index entries */
+#endif
+
+#ifndef XY_BROKER_TOPIC_INDEX_SIZE
+#define XY_BROKER_TOPIC_INDEX_SIZE 128 /**< Topic ID index entries */
+#endif
+
+/*
+ * Message pool: three classes of payload buffers shared by all servers.
+ * An allocation takes the smallest class that fits and falls back to a
+ * larger one when its own class is exhausted.
+ */
+#ifndef XY_BROKER_POOL_SMALL_SIZE
+#define XY_BROKER_POOL_SMALL_SIZE 32 /**< Payload bytes of a small buffer */
+#endif
+
+#ifndef XY_BROKER_POOL_SMALL_COUNT
+#define XY_BROKER_POOL_SMALL_COUNT 64 /**< Number of small buffers */
+#endif
+
+#ifndef XY_BROKER_POOL_MEDIUM_SIZE
+#define XY_BROKER_POOL_MEDIUM_SIZE 96 /**< Payload bytes of a medium buffer */
+#endif
+
+#ifndef XY_BROKER_POOL_MEDIUM_COUNT
+#define XY_BROKER_POOL_MEDIUM_COUNT 16 /**< Number of medium buffers */
+#endif
+
+#ifndef XY_BROKER_POOL_LARGE_COUNT
+#define XY_BROKER_POOL_LARGE_COUNT 8 /**< Buffers of XY_BROKER_MAX_MSG_SIZE */
+#endif
+
+/*
+ * Exact message and pool counters cost an atomic on one shared cache line
+ * for every send, publish and release. Set to 0 to drop them from the fast
+ * path: total_msg_sent, total_msg_delivered and pool_peak then read 0, and
+ * pool_in_use is counted from the free lists when the statistics are read,
+ * exact only while nothing is allocated or released meanwhile.
+ */
+#ifndef XY_BROKER_STATS
+#define XY_BROKER_STATS 1 /**< Count messages and the pool peak */
+#endif
+
 /* ==================== Return Codes ==================== */
 
 #define XY_BROKER_OK             0  /**< Success */
@@ -148,19 +221,67 @@ typedef enum {
 #define XY_BROKER_TOPIC_USER_BASE     0x0100
 #define XY_BROKER_TOPIC_USER_END      0xFFFF
 
+/* ==================== Hierarchical Topics ==================== */
+
+/**
+ * @brief Topic IDs as paths
+ *
+ * A topic ID reads as a path of four 4-bit levels, level 0 in the top
+ * nibble. Levels are named 1 to 15; 0 ends the path, so
+ * XY_BROKER_TOPIC_PATH(POWER, BATTERY, 0, 0) is "power/battery". Wildcard
+ * filters (xy_broker_subscribe_filter()) match these paths level by
+ * level. Flat IDs such as the predefined topics above keep working and
+ * are seen by filters as their four nibbles.
+ */
+#define XY_BROKER_TOPIC_LEVELS     4
+#define XY_BROKER_TOPIC_LEVEL_BITS 4
+
+#define XY_BROKER_TOPIC_PATH(l0, l1, l2, l3)                                   \
+    ((uint16_t)(((l0) << 12) | ((l1) << 8) | ((l2) << 4) | (l3)))
+
+/**
+ * @brief Wildcard filter levels
+ *
+ * XY_BROKER_FILTER(POWER, BATTERY, XY_BROKER_TOPIC_ANY, 0) is
+ * "power/battery/+": any one named level below power/battery.
+ * XY_BROKER_FILTER(SENSOR, XY_BROKER_TOPIC_REST, 0, 0) is "sensor/#":
+ * sensor and everything below it; levels after XY_BROKER_TOPIC_REST are
+ * ignored. A level of 0 requires the path to end there.
+ */
+#define XY_BROKER_TOPIC_ANY  0x10 /**< '+': exactly one level */
+#define XY_BROKER_TOPIC_REST 0x11 /**< '#': all levels from here on */
+
+#define XY_BROKER_FILTER(l0, l1, l2, l3)                                       \
+    (((uint32_t)(l0) << 24) | ((uint32_t)(l1) << 16) | ((uint32_t)(l2) << 8)  \
+     | (uint32_t)(l3))
+
 /* ==================== Message Priority ==================== */
 
 /**
  * @brief Message priority levels
  *
  * These are provided as reference values. Users can define their own
- * priority levels without being restricted to these constants.
+ * priority levels without being restricted to these constants; each
+ * server has one queue per level up to XY_BROKER_PRIORITY_LEVELS - 1, and
+ * higher values share the top queue.
  */
 #define XY_BROKER_PRIORITY_LOW      0
 #define XY_BROKER_PRIORITY_NORMAL   1
 #define XY_BROKER_PRIORITY_HIGH     2
 #define XY_BROKER_PRIORITY_CRITICAL 3
 
+/* ==================== Drop Policies ==================== */
+
+/**
+ * @brief What a server does with a message for a full queue
+ *
+ * A priority queue is full when it holds XY_BROKER_PRIO_QUEUE_SIZE
+ * messages or the server holds XY_BROKER_MSG_QUEUE_SIZE in total.
+ */
+#define XY_BROKER_DROP_NEWEST 0 /**< Refuse the new message (default) */
+#define XY_BROKER_DROP_OLDEST 1 /**< Drop the oldest of the same priority */
+#define XY_BROKER_DROP_LOWER  2 /**< Drop the oldest of a lower priority */
+
 /* ==================== Message Flags ==================== */
 
 #define XY_BROKER_FLAG_NONE         0x00
@@ -168,11 +289,20 @@ typedef enum {
 #define XY_BROKER_FLAG_BROADCAST    0x02 /**< Broadcast to all subscribers */
 #define XY_BROKER_FLAG_PERSISTENT   0x04 /**< Message should be persisted */
 #define XY_BROKER_FLAG_ENCRYPTED    0x08 /**< Message is encrypted */
+#define XY_BROKER_FLAG_REQUEST      0x10 /**< Sent by xy_broker_request() */
+#define XY_BROKER_FLAG_RESPONSE     0x20 /**< Answer to a request */
 
 /* ==================== Data Structures ==================== */
 
 /**
  * @brief Broker message structure
+ *
+ * Messages live in the broker's message pool; the payload follows the
+ * header in the same buffer and queues hold only pointers to it. A handler
+ * that needs a message after it returns takes a reference with
+ * xy_broker_msg_retain() and drops it with xy_broker_msg_release(). A
+ * retained message may be passed on with that reference; the header every
+ * holder sees stays as it is.
  */
 typedef struct {
     uint16_t msg_id;                         /**< Message ID (fixed value) */
@@ -184,7 +314,8 @@ typedef struct {
     uint16_t seq_num;                        /**< Sequence number */
     uint32_t timestamp;                      /**< Timestamp (ms) */
     uint16_t payload_len;                    /**< Payload length */
-    uint8_t payload[XY_BROKER_MAX_MSG_SIZE]; /**< Message payload */
+    uint16_t corr_id;                        /**< Request correlation ID */
+    uint8_t *payload;                        /**< Message payload */
 } xy_broker_msg_t;
 
 /**
@@ -197,6 +328,15 @@ typedef struct {
 typedef int (*xy_broker_msg_handler_t)(const xy_broker_msg_t *msg,
                                        void *user_data);
 
+/**
+ * @brief Gives a wrapped payload back when its message is freed
+ *
+ * @param msg The message; its payload is still valid
+ * @param ctx As given to xy_broker_msg_wrap()
+ */
+typedef void (*xy_broker_payload_free_t)(const xy_broker_msg_t *msg,
+                                         void *ctx);
+
 /**
  * @brief Topic subscriber information
  */
@@ -204,19 +344,65 @@ typedef struct {
     uint16_t server_id;              /**< Subscriber server ID */
     xy_broker_msg_handler_t handler; /**< Message handler callback */
     void *user_data;                 /**< User context data */
-    uint8_t active;                  /**< Subscription active flag */
 } xy_broker_subscriber_t;
 
+/** Words in a topic's subscriber bitmap */
+#define XY_BROKER_SUB_WORDS ((XY_BROKER_MAX_SUBSCRIBERS + 31) / 32)
+
+/** Words in a filter bitmap */
+#define XY_BROKER_FILTER_WORDS ((XY_BROKER_MAX_FILTERS + 31) / 32)
+
+/**
+ * @brief Wildcard subscription, compiled to masks
+ *
+ * A topic matches when (topic & mask) == value and every level in
+ * present is non-zero.
+ */
+typedef struct {
+    uint32_t filter;            /**< As given, XY_BROKER_FILTER() */
+    uint16_t value;             /**< Level values to match */
+    uint16_t mask;              /**< Levels compared with value */
+    uint16_t present;           /**< Levels that must be named ('+') */
+    xy_broker_subscriber_t sub; /**< Who gets the messages */
+} xy_broker_filter_t;
+
 /**
  * @brief Topic information
  */
 typedef struct {
     uint16_t topic_id; /**< Topic ID */
     xy_broker_subscriber_t subscribers[XY_BROKER_MAX_SUBSCRIBERS];
+    uint32_t sub_map[XY_BROKER_SUB_WORDS]; /**< Bit set per used slot */
+    uint32_t filter_map[XY_BROKER_FILTER_WORDS]; /**< Filters matching it */
     uint8_t subscriber_count; /**< Number of active subscribers */
+    uint8_t active;           /**< Topic created flag */
     uint32_t msg_count;       /**< Total messages published */
 } xy_broker_topic_t;
 
+/**
+ * @brief Queue cell; seq tells whose turn the cell is
+ */
+typedef struct {
+    xy_broker_msg_t *msg; /**< Queued reference */
+    uint32_t seq;         /**< Position the cell is ready for */
+} xy_broker_cell_t;
+
+/**
+ * @brief Queue of one priority level
+ *
+ * A bounded ring of sequence-numbered cells: senders claim a position by
+ * advancing tail, fill the cell and publish it through its sequence
+ * number, so any number of threads and interrupts can send at once
+ * without a lock.
+ */
+typedef struct {
+    xy_broker_cell_t ring[XY_BROKER_PRIO_QUEUE_SIZE];
+    uint32_t tail;  /**< Next position to fill */
+    uint32_t head;  /**< Next position to take */
+    uint8_t policy; /**< XY_BROKER_DROP_xxx */
+    uint8_t passed; /**< Dispatches of higher levels while waiting */
+} xy_broker_prio_queue_t;
+
 /**
  * @brief Broker server structure
  */
@@ -224,11 +410,13 @@ typedef struct {
     uint16_t server_id;              /**< Server ID */
     xy_broker_msg_handler_t handler; /**< Default message handler */
     void *user_data;                 /**< User context data */
-    xy_broker_msg_t msg_queue[XY_BROKER_MSG_QUEUE_SIZE];
-    uint16_t queue_head;   /**< Queue head index */
-    uint16_t queue_tail;   /**< Queue tail index */
-    uint16_t queue_count;  /**< Messages in queue */
+    xy_broker_prio_queue_t queues[XY_BROKER_PRIORITY_LEVELS];
+    uint16_t queue_count;  /**< Messages in all queues */
+    uint8_t aging_limit;   /**< Dispatches a queue may be passed over */
     uint8_t active;        /**< Server active flag */
+    uint8_t wake_armed;    /**< Processing thread is about to wait */
+    void *wake_thread;     /**< Thread to wake, NULL for none */
+    uint32_t wake_flags;   /**< Thread flags that wake it */
     uint32_t msg_received; /**< Total messages received */
     uint32_t msg_sent;     /**< Total messages sent */
 } xy_broker_server_t;
@@ -237,12 +425,17 @@ typedef struct {
  * @brief Broker statistics
  */
 typedef struct {
-    uint32_t total_msg_sent;       /**< Total messages sent */
-    uint32_t total_msg_delivered;  /**< Total messages delivered */
+    uint32_t total_msg_sent;       /**< Total messages sent (0 without XY_BROKER_STATS) */
+    uint32_t total_msg_delivered;  /**< Total messages delivered (ditto) */
     uint32_t total_msg_dropped;    /**< Total messages dropped */
     uint32_t queue_overflow_count; /**< Queue overflow count */
     uint32_t active_servers;       /**< Number of active servers */
     uint32_t active_topics;        /**< Number of active topics */
+    uint32_t pool_in_use;          /**< Message buffers in use */
+    uint32_t pool_peak;            /**< Most buffers ever in use (ditto) */
+    uint32_t pool_alloc_failed;    /**< Allocations the pool refused */
+    uint32_t request_timeouts;     /**< Requests that got no response */
+    uint32_t late_responses;       /**< Responses after the caller gave up */
 } xy_broker_stats_t;
 
 /* ==================== Core API ==================== */
@@ -293,15 +486,154 @@ int xy_broker_send_msg(uint16_t src_server, uint16_t dst_server,
                        uint16_t msg_id, const void *payload,
                        uint16_t payload_len, uint8_t priority);
 
+/**
+ * @brief Let senders wake the thread that processes a server
+ *
+ * While that thread waits in xy_broker_wait_msgs(), the next message for
+ * the server sets @p flags on it with xy_os_thread_flags_set(), also when
+ * sent from an interrupt. Senders skip the call while the thread is busy.
+ *
+ * @param server_id Server ID
+ * @param thread_id Processing thread (xy_os_thread_id_t), NULL to unbind
+ * @param flags Thread flags of that thread reserved for the broker
+ * @return XY_BROKER_OK on success, error code otherwise
+ */
+int xy_broker_set_wakeup(uint16_t server_id, void *thread_id, uint32_t flags);
+
+/**
+ * @brief Wait until a server has messages to process
+ *
+ * Call from the thread given to xy_broker_set_wakeup().
+ *
+ * @param server_id Server ID
+ * @param timeout_ms Timeout in milliseconds, or XY_OS_WAIT_FOREVER
+ * @return Number of pending messages, XY_BROKER_TIMEOUT if none came in
+ *         time, error code otherwise
+ */
+int xy_broker_wait_msgs(uint16_t server_id, uint32_t timeout_ms);
+
 /**
  * @brief Process pending messages for a server
  *
+ * Messages are dispatched highest priority first, in order within a
+ * priority. With aging enabled (xy_broker_set_aging()), a waiting queue
+ * that has been passed over that many times goes next. Call from one
+ * thread per server.
+ *
  * @param server_id Server ID to process messages for
  * @param max_msgs Maximum number of messages to process (0 = all)
  * @return Number of messages processed, or error code if negative
  */
 int xy_broker_process_msgs(uint16_t server_id, uint16_t max_msgs);
 
+/**
+ * @brief Set what happens when a server's queue for a priority is full
+ *
+ * @param server_id Server ID
+ * @param priority Message priority
+ * @param policy XY_BROKER_DROP_NEWEST, XY_BROKER_DROP_OLDEST or
+ *               XY_BROKER_DROP_LOWER
+ * @return XY_BROKER_OK on success, error code otherwise
+ */
+int xy_broker_set_drop_policy(uint16_t server_id, uint8_t priority,
+                              uint8_t policy);
+
+/**
+ * @brief Keep lower priorities moving under sustained higher-priority load
+ *
+ * @param server_id Server ID
+ * @param limit Dispatches of higher priorities after which a waiting
+ *              message goes next; 0 for strict priority
+ * @return XY_BROKER_OK on success, error code otherwise
+ */
+int xy_broker_set_aging(uint16_t server_id, uint8_t limit);
+
+/* ==================== Zero-Copy API ==================== */
+
+/**
+ * @brief Allocate a message from the pool
+ *
+ * The payload is filled in place through msg->payload and the message is
+ * then handed to xy_broker_msg_send() or xy_broker_msg_publish(), so the
+ * data is never copied by the broker.
+ *
+ * @param payload_len Payload length (at most XY_BROKER_MAX_MSG_SIZE)
+ * @return Message holding one reference, or NULL if the pool is exhausted
+ */
+xy_broker_msg_t *xy_broker_msg_alloc(uint16_t payload_len);
+
+/**
+ * @brief Take an additional reference to a message
+ *
+ * @param msg Message from the pool, e.g. the one passed to a handler
+ */
+void xy_broker_msg_retain(const xy_broker_msg_t *msg);
+
+/**
+ * @brief Drop a reference; the buffer returns to the pool with the last one
+ *
+ * @param msg Message from the pool
+ */
+void xy_broker_msg_release(const xy_broker_msg_t *msg);
+
+/**
+ * @brief Wrap a payload held outside the pool in a pool message
+ *
+ * For transports that receive into buffers of their own: the message takes
+ * a small pool buffer and its payload points at @p payload, which is not
+ * copied. When the last reference is dropped, @p free_fn gets the payload
+ * back. The message is sent, published, retained and released like any
+ * other; its payload may be larger than XY_BROKER_MAX_MSG_SIZE.
+ *
+ * @param payload Payload, valid until free_fn is called
+ * @param payload_len Payload length
+ * @param free_fn Called with the last reference, from whoever drops it
+ * @param ctx Passed to free_fn
+ * @return Message holding one reference, or NULL if the pool is exhausted
+ */
+xy_broker_msg_t *xy_broker_msg_wrap(void *payload, uint16_t payload_len,
+                                    xy_broker_payload_free_t free_fn,
+                                    void *ctx);
+
+/**
+ * @brief Send a pool message to a specific server
+ *
+ * Consumes the caller's reference whether or not the send succeeds. The
+ * broker writes the addressing fields into the message itself, so a
+ * message others still hold, such as a received one retained to pass on,
+ * goes out as a new message over the same payload; that takes a small
+ * pool buffer.
+ *
+ * @param src_server Source server ID
+ * @param dst_server Destination server ID
+ * @param msg_id Message ID
+ * @param msg Message from xy_broker_msg_alloc()
+ * @param priority Message priority
+ * @return XY_BROKER_OK on success, error code otherwise
+ */
+int xy_broker_msg_send(uint16_t src_server, uint16_t dst_server,
+                       uint16_t msg_id, xy_broker_msg_t *msg,
+                       uint8_t priority);
+
+/**
+ * @brief Publish a pool message to a topic
+ *
+ * All subscribers see the same buffer. Consumes the caller's reference
+ * whether or not the publish succeeds. A message others still hold goes
+ * out over the same payload as a new message, as with
+ * xy_broker_msg_send().
+ *
+ * @param src_server Source server ID
+ * @param topic_id Topic ID
+ * @param msg_id Message ID
+ * @param msg Message from xy_broker_msg_alloc()
+ * @param priority Message priority
+ * @return XY_BROKER_OK on success, error code otherwise
+ */
+int xy_broker_msg_publish(uint16_t src_server, uint16_t topic_id,
+                          uint16_t msg_id, xy_broker_msg_t *msg,
+                          uint8_t priority);
+
 /* ==================== Pub/Sub API ==================== */
 
 /**
@@ -333,9 +665,40 @@ int xy_broker_subscribe(uint16_t topic_id, uint16_t server_id,
  */
 int xy_broker_unsubscribe(uint16_t topic_id, uint16_t server_id);
 
+/**
+ * @brief Subscribe to every topic a wildcard filter matches
+ *
+ * Each created topic keeps the list of filters that match it, updated
+ * here and by xy_broker_create_topic(), so a publish to it costs no
+ * matching. A publish to a topic that was never created checks the
+ * filters one by one. Like xy_broker_subscribe(), call at start-up.
+ *
+ * @param filter XY_BROKER_FILTER() of levels, XY_BROKER_TOPIC_ANY and
+ *               XY_BROKER_TOPIC_REST
+ * @param server_id Subscriber server ID
+ * @param handler Message handler for matching topics
+ * @param user_data User context data
+ * @return XY_BROKER_OK on success, error code otherwise
+ */
+int xy_broker_subscribe_filter(uint32_t filter, uint16_t server_id,
+                               xy_broker_msg_handler_t handler,
+                               void *user_data);
+
+/**
+ * @brief Remove a wildcard subscription
+ *
+ * @param filter Filter as subscribed
+ * @param server_id Subscriber server ID
+ * @return XY_BROKER_OK on success, error code otherwise
+ */
+int xy_broker_unsubscribe_filter(uint32_t filter, uint16_t server_id);
+
 /**
  * @brief Publish a message to a topic
  *
+ * Subscribers of the topic and of every matching filter are called; a
+ * server subscribed both ways is called once per subscription.
+ *
  * @param src_server Source server ID
  * @param topic_id Topic ID
  * @param msg_id Message ID
@@ -353,26 +716,40 @@ int xy_broker_publish(uint16_t src_server, uint16_t topic_id, uint16_t msg_id,
 /**
  * @brief Send a request and wait for response
  *
+ * The request carries a correlation ID and the caller blocks on its own
+ * completion until xy_broker_respond() hands over the response or the
+ * timeout expires, so up to XY_BROKER_MAX_PENDING requests from different
+ * threads can be outstanding at once. The source server does not need to
+ * be registered. Do not call it from the thread that processes
+ * dst_server, or from an interrupt.
+ *
  * @param src_server Source server ID
  * @param dst_server Destination server ID
  * @param msg_id Message ID
  * @param request_payload Request payload
  * @param request_len Request length
- * @param response_msg Response message (output)
- * @param timeout_ms Timeout in milliseconds
- * @return XY_BROKER_OK on success, error code otherwise
+ * @param response_msg Response message (output); release it with
+ *                     xy_broker_msg_release() when done
+ * @param timeout_ms Timeout in milliseconds, or XY_OS_WAIT_FOREVER
+ * @return XY_BROKER_OK on success, XY_BROKER_TIMEOUT if no response came in
+ *         time, XY_BROKER_NO_MEMORY if all pending slots are in use
  */
 int xy_broker_request(uint16_t src_server, uint16_t dst_server, uint16_t msg_id,
                       const void *request_payload, uint16_t request_len,
-                      xy_broker_msg_t *response_msg, uint32_t timeout_ms);
+                      xy_broker_msg_t **response_msg, uint32_t timeout_ms);
 
 /**
  * @brief Send a response to a request
  *
+ * The response to a request from xy_broker_request() goes straight to the
+ * waiting caller; any other message is answered through the queue of its
+ * source server.
+ *
  * @param request_msg Original request message
  * @param response_payload Response payload
  * @param response_len Response length
- * @return XY_BROKER_OK on success, error code otherwise
+ * @return XY_BROKER_OK on success, XY_BROKER_TIMEOUT if the requester has
+ *         already given up, error code otherwise
  */
 int xy_broker_respond(const xy_broker_msg_t *request_msg,
                       const void *response_payload, uint16_t response_len);
@@ -0,0 +1,932 @@
+/**
+ * @file xy_broker_shm.c
+ * @brief XY Broker shared-memory transport implementation (Linux)
+ */
+
+#if defined(__linux__)
+
+#define _DEFAULT_SOURCE
+
+#include "xy_broker_shm.h"
+#include "../../kernel/osal/xy_os.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ==================== Internal Data Structures ==================== */
+
+/*
+ * Everything in the segment is reached by index, never by pointer, since
+ * each process maps it at its own address. The pool's free list, block
+ * references, routes and statistics are atomics in the segment. A ring has
+ * one producer process, whose threads take turns under a local lock, and
+ * one consumer, its node's dispatcher. A dispatcher about to sleep sets
+ * its waiting flag and looks at its rings once more. A producer fills a
+ * ring and then looks at the flag. Both fence in between, so one of the
+ * two always sees the other.
+ */
+#if !defined(__GNUC__)
+#error "xy_broker_shm needs the __atomic builtins (GCC, Clang)"
+#endif
+
+#define SHM_LOAD(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SHM_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define SHM_CAS(p, e, v)                                                       \
+    __atomic_compare_exchange_n((p), (e), (v), 0, __ATOMIC_ACQ_REL,           \
+                                __ATOMIC_ACQUIRE)
+#define SHM_ADD(p, v)   __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define SHM_OR(p, v)    __atomic_fetch_or((p), (v), __ATOMIC_ACQ_REL)
+#define SHM_AND(p, v)   __atomic_fetch_and((p), (v), __ATOMIC_ACQ_REL)
+#define SHM_FENCE()     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define SHM_COUNT(node, field) SHM_ADD(&(node)->field, 1)
+
+#define SHM_MAGIC 0x58594253u /**< "XYBS", stored once the segment is set up */
+#define SHM_LINE  64          /**< Cache line; ring ends live on their own */
+
+/** Route keys: kind in the high half, ID in the low */
+#define SHM_ROUTE_TOPIC  1
+#define SHM_ROUTE_SERVER 2
+#define SHM_KEY(kind, id) (((uint32_t)(kind) << 16) | (id))
+
+/** What a block carries */
+#define SHM_MSG_PUBLISH 0
+#define SHM_MSG_SEND    1
+#define SHM_MSG_NEW     2 /* Not sent yet, its header free to write */
+
+#if XY_BROKER_SHM_MAX_NODES < 2 || XY_BROKER_SHM_MAX_NODES > 32
+#error "XY_BROKER_SHM_MAX_NODES: 2 to 32 (one subscriber bit per node)"
+#endif
+
+#if XY_BROKER_SHM_BLOCKS < 1 || XY_BROKER_SHM_BLOCKS > 65535
+#error "XY_BROKER_SHM_BLOCKS: 1 to 65535 (16-bit free list index)"
+#endif
+
+#if (XY_BROKER_SHM_RING_SIZE & (XY_BROKER_SHM_RING_SIZE - 1)) != 0
+#error "XY_BROKER_SHM_RING_SIZE: power of two"
+#endif
+
+#if (XY_BROKER_SHM_ROUTES & (XY_BROKER_SHM_ROUTES - 1)) != 0
+#error "XY_BROKER_SHM_ROUTES: power of two"
+#endif
+
+/**
+ * @brief Message block header; the payload follows at SHM_BLOCK_HDR
+ *
+ * Written by the producer before the block goes into any ring, read-only
+ * after: receivers read it from their ring entry, maybe more than once. A
+ * block that has been sent is copied, not stamped again, to send it on.
+ */
+typedef struct {
+    uint32_t refcnt;      /**< Ring entries and local messages holding it */
+    uint32_t next;        /**< Free list link, block index + 1 */
+    uint32_t src_node;    /**< Node that sent it */
+    uint16_t msg_id;      /**< Message ID */
+    uint16_t src_server;  /**< Source server ID */
+    uint16_t dst_server;  /**< Destination server, SHM_MSG_SEND */
+    uint16_t topic_id;    /**< Topic, SHM_MSG_PUBLISH */
+    uint16_t payload_len; /**< Payload length */
+    uint8_t priority;     /**< Message priority */
+    uint8_t kind;         /**< SHM_MSG_xxx */
+} shm_block_t;
+
+#define SHM_BLOCK_HDR ((sizeof(shm_block_t) + 15u) & ~15u)
+#define SHM_BLOCK_STRIDE                                                       \
+    ((SHM_BLOCK_HDR + XY_BROKER_SHM_MSG_SIZE + SHM_LINE - 1) & ~(SHM_LINE - 1u))
+
+/**
+ * @brief Ring of block indices from one node to another
+ *
+ * The producer owns tail, the consumer head; each on its own cache line.
+ */
+typedef struct {
+    uint32_t tail;                       /**< Next position to fill */
+    uint8_t pad0[SHM_LINE - sizeof(uint32_t)];
+    uint32_t head;                       /**< Next position to take */
+    uint8_t pad1[SHM_LINE - sizeof(uint32_t)];
+    uint32_t slot[XY_BROKER_SHM_RING_SIZE]; /**< Block indices */
+} shm_ring_t;
+
+/**
+ * @brief A process attached to the segment
+ */
+typedef struct {
+    uint32_t pid;           /**< Owner, 0 when free */
+    uint32_t futex;         /**< Bumped to wake the dispatcher */
+    uint32_t waiting;       /**< Dispatcher is about to sleep, or sleeps */
+    uint32_t published;     /**< Messages given to other nodes */
+    uint32_t received;      /**< Messages dispatched from other nodes */
+    uint32_t ring_full;     /**< Deliveries dropped, ring full */
+    uint32_t pool_empty;    /**< Allocations refused */
+    uint32_t undeliverable; /**< Received, no local receiver */
+    uint32_t wakeups;       /**< Futex wakes sent */
+    uint8_t pad[SHM_LINE - 9 * sizeof(uint32_t)];
+} shm_node_t;
+
+/**
+ * @brief Topic or server route; entries are claimed once and never freed,
+ * so a lookup stops at the first unused one
+ */
+typedef struct {
+    uint32_t key;   /**< SHM_KEY(kind, id), 0 when unused */
+    uint32_t nodes; /**< Topic: a bit per subscribing node; server: owner + 1 */
+} shm_route_t;
+
+/**
+ * @brief The segment, the same layout in every process
+ */
+typedef struct {
+    uint32_t magic;      /**< SHM_MAGIC once set up */
+    uint32_t layout;     /**< sizeof(shm_segment_t) */
+    uint32_t msg_size;   /**< XY_BROKER_SHM_MSG_SIZE */
+    uint32_t max_nodes;  /**< XY_BROKER_SHM_MAX_NODES */
+    uint32_t free;       /**< Free list head: tag << 16 | (index + 1) */
+    uint32_t free_count; /**< Blocks on the free list */
+    uint8_t pad[SHM_LINE - 6 * sizeof(uint32_t)];
+    shm_node_t nodes[XY_BROKER_SHM_MAX_NODES];
+    shm_route_t routes[XY_BROKER_SHM_ROUTES];
+    shm_ring_t rings[XY_BROKER_SHM_MAX_NODES][XY_BROKER_SHM_MAX_NODES];
+    uint8_t blocks[XY_BROKER_SHM_BLOCKS][SHM_BLOCK_STRIDE];
+} shm_segment_t;
+
+/** This process's view */
+static struct {
+    shm_segment_t *seg;
+    int node;
+    uint32_t dispatching;                        /**< A thread dispatches */
+    uint32_t head_cache[XY_BROKER_SHM_MAX_NODES]; /**< Last head seen per ring */
+    pthread_mutex_t tx_lock[XY_BROKER_SHM_MAX_NODES]; /**< Per outgoing ring */
+    pthread_once_t once;
+} s_shm = { .once = PTHREAD_ONCE_INIT };
+
+/* ==================== Internal Functions ==================== */
+
+static void shm_locks_init(void)
+{
+    for (int i = 0; i < XY_BROKER_SHM_MAX_NODES; i++)
+        pthread_mutex_init(&s_shm.tx_lock[i], NULL);
+}
+
+static shm_block_t *shm_block(uint32_t index)
+{
+    return (shm_block_t *)(void *)s_shm.seg->blocks[index];
+}
+
+static uint8_t *shm_payload(shm_block_t *block)
+{
+    return (uint8_t *)block + SHM_BLOCK_HDR;
+}
+
+/**
+ * @brief Block behind a message from xy_broker_shm_msg_alloc(), or NULL
+ */
+static shm_block_t *shm_block_of(const xy_broker_msg_t *msg)
+{
+    uintptr_t first = (uintptr_t)s_shm.seg->blocks[0] + SHM_BLOCK_HDR;
+    uintptr_t p     = (uintptr_t)msg->payload;
+
+    if (p < first || p - first >= sizeof(s_shm.seg->blocks)
+        || (p - first) % SHM_BLOCK_STRIDE != 0)
+        return NULL;
+    return (shm_block_t *)(void *)(msg->payload - SHM_BLOCK_HDR);
+}
+
+static uint32_t shm_block_index(const shm_block_t *block)
+{
+    return (uint32_t)(((const uint8_t *)block - s_shm.seg->blocks[0])
+                      / SHM_BLOCK_STRIDE);
+}
+
+/**
+ * @brief Take a block off the free list, holding one reference
+ */
+static shm_block_t *shm_block_get(void)
+{
+    uint32_t head = SHM_LOAD(&s_shm.seg->free);
+
+    for (;;) {
+        uint16_t first = (uint16_t)head;
+        if (first == 0)
+            return NULL;
+
+        // A stale next read here is caught by the tag
+        shm_block_t *block = shm_block(first - 1u);
+        uint32_t next      = __atomic_load_n(&block->next, __ATOMIC_RELAXED);
+        uint32_t newhead   = (((head >> 16) + 1) << 16) | (uint16_t)next;
+
+        if (SHM_CAS(&s_shm.seg->free, &head, newhead)) {
+            __atomic_store_n(&block->refcnt, 1, __ATOMIC_RELAXED);
+            block->kind = SHM_MSG_NEW;
+            __atomic_fetch_sub(&s_shm.seg->free_count, 1, __ATOMIC_RELAXED);
+            return block;
+        }
+    }
+}
+
+/**
+ * @brief Drop one reference; the last returns the block to the free list
+ */
+static void shm_block_put(shm_block_t *block)
+{
+    if (__atomic_sub_fetch(&block->refcnt, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+
+    uint32_t index = shm_block_index(block) + 1;
+    uint32_t head  = SHM_LOAD(&s_shm.seg->free);
+    uint32_t newhead;
+
+    do {
+        __atomic_store_n(&block->next, head & 0xFFFFu, __ATOMIC_RELAXED);
+        newhead = (((head >> 16) + 1) << 16) | index;
+    } while (!SHM_CAS(&s_shm.seg->free, &head, newhead));
+    SHM_ADD(&s_shm.seg->free_count, 1);
+}
+
+/**
+ * @brief Free hook of local messages wrapping a block
+ */
+static void shm_wrap_free(const xy_broker_msg_t *msg, void *ctx)
+{
+    (void)msg;
+    shm_block_put((shm_block_t *)ctx);
+}
+
+/**
+ * @brief A local message for a block; takes over one block reference
+ */
+static xy_broker_msg_t *shm_wrap(shm_block_t *block, uint16_t payload_len)
+{
+    xy_broker_msg_t *msg = xy_broker_msg_wrap(shm_payload(block), payload_len,
+                                              shm_wrap_free, block);
+    if (!msg)
+        shm_block_put(block);
+    return msg;
+}
+
+/**
+ * @brief The block of @p *msg to stamp and send
+ *
+ * A block sent before, such as a received message being forwarded, is
+ * read by other nodes, so @p *msg is swapped for a copy in a fresh block.
+ *
+ * @return The block, or NULL with the caller's reference dropped if no
+ *         block is free
+ */
+static shm_block_t *shm_block_own(xy_broker_msg_t **msg, shm_block_t *block)
+{
+    if (block->kind == SHM_MSG_NEW)
+        return block;
+
+    xy_broker_msg_t *copy = xy_broker_shm_msg_alloc((*msg)->payload_len);
+    if (copy)
+        memcpy(copy->payload, (*msg)->payload, (*msg)->payload_len);
+    xy_broker_msg_release(*msg);
+    *msg = copy;
+    return copy ? shm_block_of(copy) : NULL;
+}
+
+static long shm_futex(uint32_t *addr, int op, uint32_t val,
+                      const struct timespec *timeout)
+{
+    return syscall(SYS_futex, addr, op, val, timeout, NULL, 0);
+}
+
+/**
+ * @brief Wake node @p to's dispatcher if it sleeps, or is about to
+ */
+static void shm_notify(int to)
+{
+    shm_node_t *node = &s_shm.seg->nodes[to];
+
+    SHM_FENCE();
+    if (__atomic_load_n(&node->waiting, __ATOMIC_RELAXED)) {
+        SHM_ADD(&node->futex, 1);
+        shm_futex(&node->futex, FUTEX_WAKE, 1, NULL);
+        SHM_COUNT(&s_shm.seg->nodes[s_shm.node], wakeups);
+    }
+}
+
+/**
+ * @brief Put a block reference into the ring to node @p to
+ *
+ * Takes its own reference for the ring entry.
+ *
+ * @return 1 if queued, 0 if the ring is full
+ */
+static int shm_push(int to, shm_block_t *block)
+{
+    shm_ring_t *ring = &s_shm.seg->rings[s_shm.node][to];
+
+    SHM_ADD(&block->refcnt, 1);
+    pthread_mutex_lock(&s_shm.tx_lock[to]);
+
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    if (tail - s_shm.head_cache[to] >= XY_BROKER_SHM_RING_SIZE) {
+        s_shm.head_cache[to] = SHM_LOAD(&ring->head);
+        if (tail - s_shm.head_cache[to] >= XY_BROKER_SHM_RING_SIZE) {
+            pthread_mutex_unlock(&s_shm.tx_lock[to]);
+            shm_block_put(block);
+            SHM_COUNT(&s_shm.seg->nodes[s_shm.node], ring_full);
+            return 0;
+        }
+    }
+    ring->slot[tail & (XY_BROKER_SHM_RING_SIZE - 1)] = shm_block_index(block);
+    SHM_STORE(&ring->tail, tail + 1);
+
+    pthread_mutex_unlock(&s_shm.tx_lock[to]);
+    SHM_COUNT(&s_shm.seg->nodes[s_shm.node], published);
+    shm_notify(to);
+    return 1;
+}
+
+/**
+ * @brief Whether any ring to this node holds messages
+ */
+static int shm_pending(void)
+{
+    for (int from = 0; from < XY_BROKER_SHM_MAX_NODES; from++) {
+        shm_ring_t *ring = &s_shm.seg->rings[from][s_shm.node];
+        if (SHM_LOAD(&ring->tail) != __atomic_load_n(&ring->head,
+                                                     __ATOMIC_RELAXED))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Hand one received block to the local broker
+ *
+ * A topic message is published, its handlers run at once. A server message
+ * is only queued, so it is tried while still in the ring: if the server's
+ * queue is full it stays there, for a later dispatch, rather than being
+ * lost.
+ *
+ * @return 1 if the ring's slot may be freed, 0 to leave the message in it
+ */
+static int shm_receive(shm_block_t *block)
+{
+    shm_node_t *self = &s_shm.seg->nodes[s_shm.node];
+    xy_broker_msg_t *msg;
+    int ret;
+
+    if (block->kind == SHM_MSG_SEND) {
+        // The local message holds its own reference; the ring keeps its one
+        SHM_ADD(&block->refcnt, 1);
+        msg = shm_wrap(block, block->payload_len);
+        ret = msg ? xy_broker_msg_send(block->src_server, block->dst_server,
+                                       block->msg_id, msg, block->priority)
+                  : XY_BROKER_NO_MEMORY;
+        if (ret == XY_BROKER_QUEUE_FULL || ret == XY_BROKER_NO_MEMORY)
+            return 0;
+        shm_block_put(block);
+    } else {
+        msg = shm_wrap(block, block->payload_len);
+        ret = msg ? xy_broker_msg_publish(block->src_server, block->topic_id,
+                                          block->msg_id, msg, block->priority)
+                  : XY_BROKER_NO_MEMORY;
+    }
+
+    SHM_COUNT(self, received);
+    if (ret != XY_BROKER_OK)
+        SHM_COUNT(self, undeliverable);
+    return 1;
+}
+
+/**
+ * @brief Find a route, or claim an unused entry for it
+ */
+static shm_route_t *shm_route(uint32_t key, int claim)
+{
+    uint32_t start = (key * 2654435761u) >> 16;
+
+    for (uint32_t i = 0; i < XY_BROKER_SHM_ROUTES; i++) {
+        shm_route_t *r =
+            &s_shm.seg->routes[(start + i) & (XY_BROKER_SHM_ROUTES - 1)];
+        uint32_t k = SHM_LOAD(&r->key);
+
+        if (k == key)
+            return r;
+        if (k != 0)
+            continue;
+        if (!claim)
+            return NULL;
+        if (SHM_CAS(&r->key, &k, key) || k == key)
+            return r;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Withdraw node @p node: its routes and the messages waiting for it
+ *
+ * Called by the node's own process, at detach and again when the node is
+ * next attached; so it is the consumer of the rings it drains.
+ */
+static void shm_node_clear(int node)
+{
+    shm_segment_t *seg = s_shm.seg;
+
+    for (int i = 0; i < XY_BROKER_SHM_ROUTES; i++) {
+        shm_route_t *r = &seg->routes[i];
+        uint32_t owner = (uint32_t)node + 1;
+
+        if ((SHM_LOAD(&r->key) >> 16) == SHM_ROUTE_TOPIC)
+            SHM_AND(&r->nodes, ~(1u << node));
+        else
+            (void)SHM_CAS(&r->nodes, &owner, 0);
+    }
+
+    for (int from = 0; from < XY_BROKER_SHM_MAX_NODES; from++) {
+        shm_ring_t *ring = &seg->rings[from][node];
+        uint32_t head    = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        uint32_t tail    = SHM_LOAD(&ring->tail);
+
+        for (; head != tail; head++)
+            shm_block_put(
+                shm_block(ring->slot[head & (XY_BROKER_SHM_RING_SIZE - 1)]));
+        SHM_STORE(&ring->head, head);
+    }
+}
+
+/**
+ * @brief Set up a segment just created, zero-filled by ftruncate()
+ */
+static void shm_segment_init(shm_segment_t *seg)
+{
+    seg->layout    = sizeof(shm_segment_t);
+    seg->msg_size  = XY_BROKER_SHM_MSG_SIZE;
+    seg->max_nodes = XY_BROKER_SHM_MAX_NODES;
+
+    for (int i = XY_BROKER_SHM_BLOCKS - 1; i >= 0; i--) {
+        ((shm_block_t *)(void *)seg->blocks[i])->next = seg->free;
+        seg->free = (uint32_t)(i + 1);
+    }
+    seg->free_count = XY_BROKER_SHM_BLOCKS;
+
+    SHM_STORE(&seg->magic, SHM_MAGIC);
+}
+
+/**
+ * @brief Map a segment: create it, or open one another process creates
+ */
+static shm_segment_t *shm_map(const char *name)
+{
+    struct stat st;
+    int created = 1;
+    int fd      = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if (fd < 0 && errno == EEXIST) {
+        created = 0;
+        fd      = shm_open(name, O_RDWR, 0);
+    }
+    if (fd < 0)
+        return NULL;
+
+    if (created && ftruncate(fd, sizeof(shm_segment_t)) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    // The creator may not have sized it yet
+    for (int ms = 0; !created && ms < 1000; ms++) {
+        if (fstat(fd, &st) != 0 || st.st_size != 0)
+            break;
+        usleep(1000);
+    }
+    if (!created && (fstat(fd, &st) != 0
+                     || st.st_size != (off_t)sizeof(shm_segment_t))) {
+        close(fd);
+        return NULL;
+    }
+
+    void *p = mmap(NULL, sizeof(shm_segment_t), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return NULL;
+
+    shm_segment_t *seg = p;
+    if (created)
+        shm_segment_init(seg);
+    for (int ms = 0; ms < 1000 && SHM_LOAD(&seg->magic) != SHM_MAGIC; ms++)
+        usleep(1000);
+
+    if (SHM_LOAD(&seg->magic) != SHM_MAGIC
+        || seg->layout != sizeof(shm_segment_t)
+        || seg->msg_size != XY_BROKER_SHM_MSG_SIZE
+        || seg->max_nodes != XY_BROKER_SHM_MAX_NODES) {
+        munmap(p, sizeof(shm_segment_t));
+        return NULL;
+    }
+    return seg;
+}
+
+/**
+ * @brief Whether the process that owned a node is gone
+ */
+static int shm_pid_dead(uint32_t pid)
+{
+    return kill((pid_t)pid, 0) != 0 && errno == ESRCH;
+}
+
+/* ==================== Segment API Implementation ==================== */
+
+int xy_broker_shm_attach(const char *name)
+{
+    if (!name)
+        return XY_BROKER_INVALID_PARAM;
+    if (s_shm.seg)
+        return s_shm.node;
+
+    pthread_once(&s_shm.once, shm_locks_init);
+
+    shm_segment_t *seg = shm_map(name);
+    if (!seg)
+        return XY_BROKER_ERROR;
+
+    uint32_t me = (uint32_t)getpid();
+    int node    = -1;
+
+    for (int i = 0; i < XY_BROKER_SHM_MAX_NODES && node < 0; i++) {
+        uint32_t pid = SHM_LOAD(&seg->nodes[i].pid);
+
+        if (pid != 0 && !shm_pid_dead(pid))
+            continue;
+        if (SHM_CAS(&seg->nodes[i].pid, &pid, me))
+            node = i;
+    }
+    if (node < 0) {
+        munmap(seg, sizeof(shm_segment_t));
+        return XY_BROKER_NO_MEMORY;
+    }
+
+    s_shm.seg         = seg;
+    s_shm.node        = node;
+    s_shm.dispatching = 0;
+    // Also for a node detached cleanly: a sender that resolved its route
+    // before the detach may have pushed after the detach drained the rings
+    shm_node_clear(node);
+
+    shm_node_t *self = &seg->nodes[node];
+    SHM_STORE(&self->waiting, 0);
+    self->published = self->received = self->ring_full = 0;
+    self->pool_empty = self->undeliverable = self->wakeups = 0;
+    for (int to = 0; to < XY_BROKER_SHM_MAX_NODES; to++)
+        s_shm.head_cache[to] = SHM_LOAD(&seg->rings[node][to].head);
+
+    return node;
+}
+
+int xy_broker_shm_detach(void)
+{
+    shm_segment_t *seg = s_shm.seg;
+
+    if (!seg)
+        return XY_BROKER_ERROR;
+
+    shm_node_clear(s_shm.node);
+    SHM_STORE(&seg->nodes[s_shm.node].pid, 0);
+    s_shm.seg = NULL;
+    munmap(seg, sizeof(shm_segment_t));
+
+    return XY_BROKER_OK;
+}
+
+int xy_broker_shm_unlink(const char *name)
+{
+    if (!name)
+        return XY_BROKER_INVALID_PARAM;
+    return shm_unlink(name) == 0 ? XY_BROKER_OK : XY_BROKER_NOT_FOUND;
+}
+
+/* ==================== Routing API Implementation ==================== */
+
+int xy_broker_shm_subscribe(uint16_t topic_id)
+{
+    if (!s_shm.seg)
+        return XY_BROKER_ERROR;
+    if (topic_id == 0)
+        return XY_BROKER_INVALID_PARAM;
+
+    shm_route_t *r = shm_route(SHM_KEY(SHM_ROUTE_TOPIC, topic_id), 1);
+    if (!r)
+        return XY_BROKER_NO_MEMORY;
+
+    SHM_OR(&r->nodes, 1u << s_shm.node);
+    return XY_BROKER_OK;
+}
+
+int xy_broker_shm_unsubscribe(uint16_t topic_id)
+{
+    if (!s_shm.seg)
+        return XY_BROKER_ERROR;
+
+    shm_route_t *r = shm_route(SHM_KEY(SHM_ROUTE_TOPIC, topic_id), 0);
+    if (!r || !(SHM_AND(&r->nodes, ~(1u << s_shm.node)) & (1u << s_shm.node)))
+        return XY_BROKER_NOT_FOUND;
+
+    return XY_BROKER_OK;
+}
+
+int xy_broker_shm_export_server(uint16_t server_id)
+{
+    if (!s_shm.seg)
+        return XY_BROKER_ERROR;
+    if (server_id == 0)
+        return XY_BROKER_INVALID_PARAM;
+    if (!xy_broker_is_server_registered(server_id))
+        return XY_BROKER_NOT_FOUND;
+
+    shm_route_t *r = shm_route(SHM_KEY(SHM_ROUTE_SERVER, server_id), 1);
+    if (!r)
+        return XY_BROKER_NO_MEMORY;
+
+    uint32_t owner = 0;
+    uint32_t mine  = (uint32_t)s_shm.node + 1;
+    if (!SHM_CAS(&r->nodes, &owner, mine) && owner != mine)
+        return XY_BROKER_ALREADY_EXISTS;
+
+    return XY_BROKER_OK;
+}
+
+int xy_broker_shm_unexport_server(uint16_t server_id)
+{
+    if (!s_shm.seg)
+        return XY_BROKER_ERROR;
+
+    shm_route_t *r = shm_route(SHM_KEY(SHM_ROUTE_SERVER, server_id), 0);
+    uint32_t mine  = (uint32_t)s_shm.node + 1;
+    if (!r || !SHM_CAS(&r->nodes, &mine, 0))
+        return XY_BROKER_NOT_FOUND;
+
+    return XY_BROKER_OK;
+}
+
+/* ==================== Messaging API Implementation ==================== */
+
+xy_broker_msg_t *xy_broker_shm_msg_alloc(uint16_t payload_len)
+{
+    if (!s_shm.seg || payload_len > XY_BROKER_SHM_MSG_SIZE)
+        return NULL;
+
+    shm_block_t *block = shm_block_get();
+    if (!block) {
+        SHM_COUNT(&s_shm.seg->nodes[s_shm.node], pool_empty);
+        return NULL;
+    }
+
+    return shm_wrap(block, payload_len);
+}
+
+int xy_broker_shm_msg_publish(uint16_t src_server, uint16_t topic_id,
+                              uint16_t msg_id, xy_broker_msg_t *msg,
+                              uint8_t priority)
+{
+    if (!msg)
+        return XY_BROKER_INVALID_PARAM;
+
+    shm_block_t *block = s_shm.seg ? shm_block_of(msg) : NULL;
+    if (!block) {
+        xy_broker_msg_release(msg);
+        return s_shm.seg ? XY_BROKER_INVALID_PARAM : XY_BROKER_ERROR;
+    }
+    block = shm_block_own(&msg, block);
+    if (!block)
+        return XY_BROKER_NO_MEMORY;
+
+    block->kind        = SHM_MSG_PUBLISH;
+    block->src_node    = (uint32_t)s_shm.node;
+    block->msg_id      = msg_id;
+    block->src_server  = src_server;
+    block->dst_server  = 0;
+    block->topic_id    = topic_id;
+    block->priority    = priority;
+    block->payload_len = msg->payload_len;
+
+    // Other nodes first, so they work while the local handlers run
+    int delivered = 0;
+    int full      = 0;
+    shm_route_t *r = shm_route(SHM_KEY(SHM_ROUTE_TOPIC, topic_id), 0);
+    uint32_t nodes = r ? SHM_LOAD(&r->nodes) & ~(1u << s_shm.node) : 0;
+
+    for (; nodes; nodes &= nodes - 1) {
+        if (shm_push(__builtin_ctz(nodes), block))
+            delivered++;
+        else
+            full++;
+    }
+
+    // The local broker takes over the caller's reference
+    if (xy_broker_msg_publish(src_server, topic_id, msg_id, msg, priority)
+        == XY_BROKER_OK)
+        delivered++;
+
+    if (delivered > 0)
+        return XY_BROKER_OK;
+    return full ? XY_BROKER_QUEUE_FULL : XY_BROKER_NOT_FOUND;
+}
+
+int xy_broker_shm_publish(uint16_t src_server, uint16_t topic_id,
+                          uint16_t msg_id, const void *payload,
+                          uint16_t payload_len, uint8_t priority)
+{
+    if (!s_shm.seg)
+        return XY_BROKER_ERROR;
+    if (payload_len > XY_BROKER_SHM_MSG_SIZE)
+        return XY_BROKER_INVALID_PARAM;
+
+    xy_broker_msg_t *msg = xy_broker_shm_msg_alloc(payload_len);
+    if (!msg)
+        return XY_BROKER_NO_MEMORY;
+
+    if (payload && payload_len > 0)
+        memcpy(msg->payload, payload, payload_len);
+
+    return xy_broker_shm_msg_publish(src_server, topic_id, msg_id, msg,
+                                     priority);
+}
+
+int xy_broker_shm_msg_send(uint16_t src_server, uint16_t dst_server,
+                           uint16_t msg_id, xy_broker_msg_t *msg,
+                           uint8_t priority)
+{
+    if (!msg)
+        return XY_BROKER_INVALID_PARAM;
+
+    // A server of this process needs no ring
+    if (xy_broker_is_server_registered(dst_server))
+        return xy_broker_msg_send(src_server, dst_server, msg_id, msg,
+                                  priority);
+
+    shm_block_t *block = s_shm.seg ? shm_block_of(msg) : NULL;
+    shm_route_t *r     = block ? shm_route(SHM_KEY(SHM_ROUTE_SERVER,
+                                                   dst_server), 0)
+                               : NULL;
+    uint32_t owner     = r ? SHM_LOAD(&r->nodes) : 0;
+
+    if (!block || owner == 0 || owner - 1 == (uint32_t)s_shm.node) {
+        xy_broker_msg_release(msg);
+        if (!block)
+            return s_shm.seg ? XY_BROKER_INVALID_PARAM : XY_BROKER_ERROR;
+        return XY_BROKER_NOT_FOUND;
+    }
+
+    block = shm_block_own(&msg, block);
+    if (!block)
+        return XY_BROKER_NO_MEMORY;
+
+    block->kind        = SHM_MSG_SEND;
+    block->src_node    = (uint32_t)s_shm.node;
+    block->msg_id      = msg_id;
+    block->src_server  = src_server;
+    block->dst_server  = dst_server;
+    block->topic_id    = 0;
+    block->priority    = priority;
+    block->payload_len = msg->payload_len;
+
+    int ret = shm_push((int)owner - 1, block) ? XY_BROKER_OK
+                                              : XY_BROKER_QUEUE_FULL;
+    xy_broker_msg_release(msg);
+    return ret;
+}
+
+/* ==================== Dispatch API Implementation ==================== */
+
+int xy_broker_shm_wait(uint32_t timeout_ms)
+{
+    shm_segment_t *seg = s_shm.seg;
+    struct timespec now, end = { 0, 0 };
+
+    if (!seg)
+        return XY_BROKER_ERROR;
+    if (shm_pending())
+        return 1;
+    if (timeout_ms == 0)
+        return 0;
+
+    if (timeout_ms != XY_OS_WAIT_FOREVER) {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        end.tv_sec += timeout_ms / 1000u;
+        end.tv_nsec += (long)(timeout_ms % 1000u) * 1000000L;
+        if (end.tv_nsec >= 1000000000L) {
+            end.tv_sec++;
+            end.tv_nsec -= 1000000000L;
+        }
+    }
+
+    shm_node_t *self = &seg->nodes[s_shm.node];
+    for (;;) {
+        struct timespec left, *timeout = NULL;
+        uint32_t seen = SHM_LOAD(&self->futex);
+
+        __atomic_store_n(&self->waiting, 1, __ATOMIC_RELAXED);
+        SHM_FENCE();
+        if (shm_pending())
+            break;
+
+        if (timeout_ms != XY_OS_WAIT_FOREVER) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            left.tv_sec  = end.tv_sec - now.tv_sec;
+            left.tv_nsec = end.tv_nsec - now.tv_nsec;
+            if (left.tv_nsec < 0) {
+                left.tv_sec--;
+                left.tv_nsec += 1000000000L;
+            }
+            if (left.tv_sec < 0)
+                break;
+            timeout = &left;
+        }
+        // Returns at once if a producer bumped the word since we read it
+        shm_futex(&self->futex, FUTEX_WAIT, seen, timeout);
+    }
+    SHM_STORE(&self->waiting, 0);
+
+    return shm_pending();
+}
+
+int xy_broker_shm_dispatch(uint16_t max_msgs)
+{
+    shm_segment_t *seg = s_shm.seg;
+    uint32_t idle      = 0;
+    int count          = 0;
+
+    if (!seg)
+        return XY_BROKER_ERROR;
+    if (!SHM_CAS(&s_shm.dispatching, &idle, 1))
+        return 0;
+
+    // Ring by ring, round after round, until all are empty
+    for (int progress = 1; progress && (max_msgs == 0 || count < max_msgs);) {
+        progress = 0;
+        for (int from = 0; from < XY_BROKER_SHM_MAX_NODES; from++) {
+            shm_ring_t *ring = &seg->rings[from][s_shm.node];
+            uint32_t head    = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+            uint32_t tail    = SHM_LOAD(&ring->tail);
+
+            for (; head != tail && (max_msgs == 0 || count < max_msgs);
+                 count++) {
+                shm_block_t *block =
+                    shm_block(ring->slot[head & (XY_BROKER_SHM_RING_SIZE - 1)]);
+
+                if (block->kind == SHM_MSG_SEND) {
+                    // Its server is busy: this ring waits, the others go on
+                    if (!shm_receive(block))
+                        break;
+                    SHM_STORE(&ring->head, ++head);
+                } else {
+                    // Free the slot first: a handler may publish back to
+                    // the same node
+                    SHM_STORE(&ring->head, ++head);
+                    shm_receive(block);
+                }
+                progress = 1;
+            }
+        }
+    }
+
+    SHM_STORE(&s_shm.dispatching, 0);
+    return count;
+}
+
+int xy_broker_shm_get_stats(xy_broker_shm_stats_t *stats)
+{
+    shm_segment_t *seg = s_shm.seg;
+
+    if (!stats)
+        return XY_BROKER_INVALID_PARAM;
+    if (!seg)
+        return XY_BROKER_ERROR;
+
+    shm_node_t *self = &seg->nodes[s_shm.node];
+    memset(stats, 0, sizeof(*stats));
+    stats->node = s_shm.node;
+    for (int i = 0; i < XY_BROKER_SHM_MAX_NODES; i++) {
+        if (SHM_LOAD(&seg->nodes[i].pid) != 0)
+            stats->nodes++;
+    }
+    stats->blocks_free   = SHM_LOAD(&seg->free_count);
+    stats->published     = SHM_LOAD(&self->published);
+    stats->received      = SHM_LOAD(&self->received);
+    stats->ring_full     = SHM_LOAD(&self->ring_full);
+    stats->pool_empty    = SHM_LOAD(&self->pool_empty);
+    stats->undeliverable = SHM_LOAD(&self->undeliverable);
+    stats->wakeups       = SHM_LOAD(&self->wakeups);
+
+    return XY_BROKER_OK;
+}
+
+#else
+
+/* POSIX shared memory and futexes: Linux only */
+typedef int xy_broker_shm_unsupported_t;
+
+#endif /* __linux__ */
@@ -0,0 +1,261 @@
+/**
+ * @file xy_broker_shm.h
+ * @brief XY Broker shared-memory transport - topics and servers across
+ * processes on Linux
+ *
+ * Each process runs its own broker and attaches to a named POSIX
+ * shared-memory segment as a node. The segment holds:
+ * - a pool of message blocks;
+ * - a table of which nodes subscribe to which topics and which node owns
+ *   which server;
+ * - a single-producer, single-consumer ring of block indices for every
+ *   ordered pair of nodes.
+ *
+ * A publish writes its payload into a block once. The block then goes, by
+ * index, to the ring of every subscribing node and to the local
+ * subscribers. The receiving dispatcher hands each subscriber a message
+ * whose payload points into the segment, so the payload is never copied
+ * between processes. A sleeping dispatcher is woken through a futex in the
+ * segment.
+ *
+ * Threads of a process take turns on its outgoing rings under a
+ * process-local lock. One thread per process dispatches.
+ *
+ * @author XY Team
+ * @date 2025
+ */
+
+#ifndef XY_BROKER_SHM_H
+#define XY_BROKER_SHM_H
+
+#include "xy_broker.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== Configuration ==================== */
+
+/*
+ * All processes attaching to a segment must be built with the same values;
+ * attach refuses a segment with another layout.
+ */
+#ifndef XY_BROKER_SHM_MAX_NODES
+#define XY_BROKER_SHM_MAX_NODES 8 /**< Processes attached at once, <= 32 */
+#endif
+
+#ifndef XY_BROKER_SHM_BLOCKS
+#define XY_BROKER_SHM_BLOCKS 256 /**< Message blocks in the segment */
+#endif
+
+#ifndef XY_BROKER_SHM_MSG_SIZE
+#define XY_BROKER_SHM_MSG_SIZE 1024 /**< Payload bytes per block */
+#endif
+
+#ifndef XY_BROKER_SHM_RING_SIZE
+#define XY_BROKER_SHM_RING_SIZE 64 /**< Ring slots per node pair, power of two */
+#endif
+
+#ifndef XY_BROKER_SHM_ROUTES
+#define XY_BROKER_SHM_ROUTES 128 /**< Topic and server entries, power of two */
+#endif
+
+/* ==================== Data Structures ==================== */
+
+/**
+ * @brief Transport statistics of this process
+ */
+typedef struct {
+    int node;               /**< This process's node */
+    uint32_t nodes;         /**< Nodes attached */
+    uint32_t blocks_free;   /**< Blocks in the segment's pool */
+    uint32_t published;     /**< Messages this node gave to other nodes */
+    uint32_t received;      /**< Messages dispatched from other nodes */
+    uint32_t ring_full;     /**< Deliveries dropped, a ring was full */
+    uint32_t pool_empty;    /**< Allocations refused, no free block */
+    uint32_t undeliverable; /**< Received, no local receiver */
+    uint32_t wakeups;       /**< Futex wakes this node sent */
+} xy_broker_shm_stats_t;
+
+/* ==================== Segment API ==================== */
+
+/**
+ * @brief Attach this process to a segment, creating it if needed
+ *
+ * xy_broker_init() must have been called. A node left behind by a process
+ * that died is reclaimed, and messages still waiting in the node's rings
+ * are returned to the pool. Blocks that the dead process held in its own
+ * local messages are not: they stay out of the pool until the segment is
+ * unlinked and created again.
+ *
+ * @param name Segment name, "/name" as for shm_open()
+ * @return Node number (>= 0), or an error code: XY_BROKER_NO_MEMORY if all
+ *         nodes are taken, XY_BROKER_ERROR if the segment cannot be mapped
+ *         or has another layout
+ */
+int xy_broker_shm_attach(const char *name);
+
+/**
+ * @brief Detach from the segment
+ *
+ * Withdraws this node's subscriptions and servers, and returns messages
+ * still waiting for it to the pool. The segment stays until unlinked.
+ *
+ * @return XY_BROKER_OK on success, error code otherwise
+ */
+int xy_broker_shm_detach(void);
+
+/**
+ * @brief Remove a segment's name; mapped segments live on until detached
+ *
+ * @param name Segment name
+ * @return XY_BROKER_OK on success, XY_BROKER_NOT_FOUND otherwise
+ */
+int xy_broker_shm_unlink(const char *name);
+
+/* ==================== Routing API ==================== */
+
+/**
+ * @brief Receive a topic's messages published by other nodes
+ *
+ * They are published to the local broker, so local subscribers, and
+ * wildcard filters, see them as if published here.
+ *
+ * @param topic_id Topic ID (not 0)
+ * @return XY_BROKER_OK on success, XY_BROKER_NO_MEMORY if the route table
+ *         is full
+ */
+int xy_broker_shm_subscribe(uint16_t topic_id);
+
+/**
+ * @brief Stop receiving a topic from other nodes
+ *
+ * @param topic_id Topic ID
+ * @return XY_BROKER_OK on success, XY_BROKER_NOT_FOUND if not subscribed
+ */
+int xy_broker_shm_unsubscribe(uint16_t topic_id);
+
+/**
+ * @brief Make a local server reachable from other nodes
+ *
+ * @param server_id Registered server ID (not 0)
+ * @return XY_BROKER_OK on success, XY_BROKER_ALREADY_EXISTS if another
+ *         node exports it, XY_BROKER_NO_MEMORY if the route table is full
+ */
+int xy_broker_shm_export_server(uint16_t server_id);
+
+/**
+ * @brief Withdraw a server exported by this node
+ *
+ * @param server_id Server ID
+ * @return XY_BROKER_OK on success, XY_BROKER_NOT_FOUND otherwise
+ */
+int xy_broker_shm_unexport_server(uint16_t server_id);
+
+/* ==================== Messaging API ==================== */
+
+/**
+ * @brief Allocate a message whose payload lives in the segment
+ *
+ * Filled in place and handed to xy_broker_shm_msg_publish() or
+ * xy_broker_shm_msg_send(), its payload is never copied, locally or to
+ * other nodes. The message may also go to xy_broker_msg_publish() and the
+ * other local calls, like any pool message.
+ *
+ * @param payload_len Payload length (at most XY_BROKER_SHM_MSG_SIZE)
+ * @return Message holding one reference, or NULL if no block is free
+ */
+xy_broker_msg_t *xy_broker_shm_msg_alloc(uint16_t payload_len);
+
+/**
+ * @brief Publish a segment message to a topic on every node
+ *
+ * Goes to every other node subscribed with xy_broker_shm_subscribe() and
+ * to this node's local receivers. Consumes the caller's reference whether
+ * or not the publish succeeds. A message sent before, such as one received
+ * from another node and passed on, is copied into a fresh block first.
+ *
+ * @param src_server Source server ID
+ * @param topic_id Topic ID
+ * @param msg_id Message ID
+ * @param msg Message from xy_broker_shm_msg_alloc()
+ * @param priority Message priority
+ * @return XY_BROKER_OK if delivered anywhere, XY_BROKER_QUEUE_FULL if only
+ *         full rings wanted it, XY_BROKER_NOT_FOUND if nobody did,
+ *         XY_BROKER_NO_MEMORY if a copy found no free block
+ */
+int xy_broker_shm_msg_publish(uint16_t src_server, uint16_t topic_id,
+                              uint16_t msg_id, xy_broker_msg_t *msg,
+                              uint8_t priority);
+
+/**
+ * @brief Publish to a topic on every node, copying the payload once
+ *
+ * @param src_server Source server ID
+ * @param topic_id Topic ID
+ * @param msg_id Message ID
+ * @param payload Payload data
+ * @param payload_len Payload length (at most XY_BROKER_SHM_MSG_SIZE)
+ * @param priority Message priority
+ * @return As xy_broker_shm_msg_publish(), or XY_BROKER_NO_MEMORY
+ */
+int xy_broker_shm_publish(uint16_t src_server, uint16_t topic_id,
+                          uint16_t msg_id, const void *payload,
+                          uint16_t payload_len, uint8_t priority);
+
+/**
+ * @brief Send a segment message to a server on any node
+ *
+ * A local server gets it directly, an exported one on another node through
+ * that node's ring. Consumes the caller's reference. A message sent before
+ * is copied into a fresh block, as by xy_broker_shm_msg_publish().
+ *
+ * @param src_server Source server ID
+ * @param dst_server Destination server ID
+ * @param msg_id Message ID
+ * @param msg Message from xy_broker_shm_msg_alloc()
+ * @param priority Message priority
+ * @return XY_BROKER_OK on success, XY_BROKER_NOT_FOUND if no node has the
+ *         server, XY_BROKER_QUEUE_FULL if its ring is full,
+ *         XY_BROKER_NO_MEMORY if a copy found no free block
+ */
+int xy_broker_shm_msg_send(uint16_t src_server, uint16_t dst_server,
+                           uint16_t msg_id, xy_broker_msg_t *msg,
+                           uint8_t priority);
+
+/* ==================== Dispatch API ==================== */
+
+/**
+ * @brief Sleep until another node has sent this one something
+ *
+ * @param timeout_ms Timeout in milliseconds (XY_OS_WAIT_FOREVER: none)
+ * @return 1 if messages are waiting, 0 on timeout, error code otherwise
+ */
+int xy_broker_shm_wait(uint32_t timeout_ms);
+
+/**
+ * @brief Hand messages from other nodes to the local broker
+ *
+ * Topics are published and server messages queued locally, in the order
+ * each node sent them. A server message whose queue is full waits in its
+ * ring, holding back that node's later messages, until a later dispatch.
+ * Only one thread per process dispatches at a time.
+ *
+ * @param max_msgs Maximum messages (0 = all waiting)
+ * @return Number of messages dispatched, or error code
+ */
+int xy_broker_shm_dispatch(uint16_t max_msgs);
+
+/**
+ * @brief Get transport statistics
+ *
+ * @param stats Pointer to store statistics
+ * @return XY_BROKER_OK on success, error code otherwise
+ */
+int xy_broker_shm_get_stats(xy_broker_shm_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XY_BROKER_SHM_H */
@@ -32,6 +32,12 @@ static xy_os_status_t pdstatus_to_xy(BaseType_t status)
     return (status == pdPASS) ? XY_OS_OK : XY_OS_ERROR;
 }
 
+/* Interrupt context check for the calls allowed from an ISR; Cortex-M
+ * ports provide xPortIsInsideInterrupt(), others define their own */
+#ifndef XY_OS_FREERTOS_IN_ISR
+#define XY_OS_FREERTOS_IN_ISR() (xPortIsInsideInterrupt() == pdTRUE)
+#endif
+
 /* Kernel Control */
 xy_os_status_t xy_os_kernel_init(void)
 {
@@ -84,6 +90,8 @@ int32_t xy_os_kernel_restore_lock(int32_t lock)
 
 uint32_t xy_os_kernel_get_tick_count(void)
 {
+    if (XY_OS_FREERTOS_IN_ISR())
+        return (uint32_t)xTaskGetTickCountFromISR();
     return (uint32_t)xTaskGetTickCount();
 }
 uint32_t xy_os_kernel_get_tick_freq(void)
@@ -92,6 +100,8 @@ uint32_t xy_os_kernel_get_tick_freq(void)
 }
 uint32_t xy_os_kernel_get_sys_timer_count(void)
 {
+    if (XY_OS_FREERTOS_IN_ISR())
+        return (uint32_t)xTaskGetTickCountFromISR();
     return (uint32_t)xTaskGetTickCount();
 }
 uint32_t xy_os_kernel_get_sys_timer_freq(void)
@@ -241,7 +251,13 @@ uint32_t xy_os_thread_flags_set(xy_os_thread_id_t thread_id, uint32_t flags)
     TaskHandle_t h = (TaskHandle_t)thread_id;
     if (!h)
         return 0x80000000;
-    xTaskNotify(h, flags, eSetBits);
+    if (XY_OS_FREERTOS_IN_ISR()) {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyFromISR(h, flags, eSetBits, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xTaskNotify(h, flags, eSetBits);
+    }
     return flags;
 }
 
@@ -476,9 +492,16 @@ xy_os_status_t xy_os_semaphore_acquire(xy_os_semaphore_id_t semaphore_id,
 
 xy_os_status_t xy_os_semaphore_release(xy_os_semaphore_id_t semaphore_id)
 {
-    return semaphore_id
-               ? pdstatus_to_xy(xSemaphoreGive((SemaphoreHandle_t)semaphore_id))
-               : XY_OS_ERROR_PARAMETER;
+    if (!semaphore_id)
+        return XY_OS_ERROR_PARAMETER;
+    if (XY_OS_FREERTOS_IN_ISR()) {
+        BaseType_t woken = pdFALSE;
+        BaseType_t ret =
+            xSemaphoreGiveFromISR((SemaphoreHandle_t)semaphore_id, &woken);
+        portYIELD_FROM_ISR(woken);
+        return pdstatus_to_xy(ret);
+    }
+    return pdstatus_to_xy(xSemaphoreGive((SemaphoreHandle_t)semaphore_id));
 }
 
 uint32_t xy_os_semaphore_get_count(xy_os_semaphore_id_t semaphore_id)
@@ -122,6 +122,7 @@ int32_t xy_os_kernel_restore_lock(int32_t lock);
 
 /**
  * @brief Get the RTOS kernel tick count
+ * @note May be called from an ISR
  * @return RTOS kernel current tick count
  */
 uint32_t xy_os_kernel_get_tick_count(void);
@@ -134,6 +135,7 @@ uint32_t xy_os_kernel_get_tick_freq(void);
 
 /**
  * @brief Get the RTOS kernel system timer count
+ * @note May be called from an ISR
  * @return RTOS kernel current system timer count
  */
 uint32_t xy_os_kernel_get_sys_timer_count(void);
@@ -378,6 +380,7 @@ uint32_t xy_os_thread_enumerate(xy_os_thread_id_t *thread_array,
 
 /**
  * @brief Set the specified thread flags of a thread
+ * @note May be called from an ISR
  * @param[in] thread_id Thread ID
  * @param[in] flags Flags to set
  * @return Flags after setting or error code
@@ -698,6 +701,7 @@ xy_os_status_t xy_os_semaphore_acquire(xy_os_semaphore_id_t semaphore_id,
 
 /**
  * @brief Release a Semaphore token
+ * @note May be called from an ISR
  * @param[in] semaphore_id Semaphore ID
  * @return Status code
  */
@@ -851,7 +855,7 @@ const char *xy_os_msgqueue_get_name(xy_os_msgqueue_id_t mq_id);
  * @return Status code
  */
 xy_os_status_t xy_os_msgqueue_put(xy_os_msgqueue_id_t mq_id,
-                                  const void *msg_ptr, xy_u8_t msg_prio,
+                                  const void *msg_ptr, uint8_t msg_prio,
                                   uint32_t timeout);
 
 /**
@@ -864,7 +868,7 @@ xy_os_status_t xy_os_msgqueue_put(xy_os_msgqueue_id_t mq_id,
  * @return Status code
  */
 xy_os_status_t xy_os_msgqueue_get(xy_os_msgqueue_id_t mq_id, void *msg_ptr,
-                                  xy_u8_t *msg_prio, uint32_t timeout);
+                                  uint8_t *msg_prio, uint32_t timeout);
 
 /**
  * @brief Get maximum number of messages in a Message Queue